@@ -0,0 +1,568 @@
+#include "stdafx.h"
+#include "animated_artwork.h"
+#include "control_panel.h"
+#include "perf_stats.h"
+#include "tracing.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <wincodec.h>
+
+static const size_t RING_MEMORY_LIMIT = 16 << 20;  // Decoded frames held at once, per stream
+static const size_t RING_FRAMES = 8;                // Decoded ahead when the animation does not fit
+static const size_t MIN_RING_FRAMES = 2;            // One being shown, one ready
+static const unsigned DEFAULT_FRAME_DELAY = 100;    // ms, for frames without a usable delay
+static const t_size MAX_SOURCE_SIZE = 32 << 20;     // Larger encoded covers stay on their first frame
+static const int MAX_CANVAS_SIZE = 16384;           // Sanity bound on the size a header claims
+static const int MAX_ANIMATION_SIZE = 2048;         // Larger animations stay on their first frame
+
+// GIF frame disposal methods (graphic control extension)
+enum gif_disposal {
+    gif_dispose_none = 0,
+    gif_dispose_keep = 1,
+    gif_dispose_background = 2,
+    gif_dispose_previous = 3
+};
+
+// COM for a worker thread, for as long as it uses WIC
+class com_scope {
+public:
+    com_scope() : m_initialized(SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {}
+    ~com_scope() { if (m_initialized) CoUninitialize(); }
+
+private:
+    bool m_initialized;     // Otherwise the thread already had COM, in a mode we leave alone
+
+    com_scope(const com_scope&) = delete;
+    com_scope& operator=(const com_scope&) = delete;
+};
+
+static bool read_metadata_uint(IWICMetadataQueryReader* reader, const wchar_t* name, UINT& value) {
+    if (!reader) return false;
+    PROPVARIANT variant;
+    PropVariantInit(&variant);
+    bool found = false;
+    if (SUCCEEDED(reader->GetMetadataByName(name, &variant))) {
+        found = true;
+        switch (variant.vt) {
+        case VT_UI1: value = variant.bVal; break;
+        case VT_UI2: value = variant.uiVal; break;
+        case VT_UI4: value = variant.ulVal; break;
+        default: found = false; break;
+        }
+    }
+    PropVariantClear(&variant);
+    return found;
+}
+
+// Only GIF and WebP carry animations WIC can read
+static bool is_animation_container(const album_art_data_ptr& data) {
+    const char* bytes = static_cast<const char*>(data->get_ptr());
+    t_size size = data->get_size();
+    if (size >= 6 && memcmp(bytes, "GIF8", 4) == 0) return true;
+    return size >= 12 && memcmp(bytes, "RIFF", 4) == 0 && memcmp(bytes + 8, "WEBP", 4) == 0;
+}
+
+// The composed picture after a number of frames, kept between decode batches so a ring that
+// wraps or is refilled continues where it left off. Straight-alpha BGRA, top-down.
+struct animation_canvas {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> saved;     // Picture to restore after a gif_dispose_previous frame
+    unsigned next_frame = 0;        // Frame compose() adds next; 0 means a blank canvas
+    UINT disposal = gif_dispose_none;
+    RECT last_rect = {};            // Area of the last frame added, for its disposal
+};
+
+// An open WIC decoder over the encoded cover. Lives for one batch on one thread; the canvas it
+// draws on outlives it.
+class wic_animation {
+public:
+    bool open(const album_art_data_ptr& data) {
+        if (FAILED(m_factory.CoCreateInstance(CLSID_WICImagingFactory))) return false;
+        m_source.p = SHCreateMemStream(reinterpret_cast<const BYTE*>(data->get_ptr()), static_cast<UINT>(data->get_size()));
+        if (!m_source) return false;
+        if (FAILED(m_factory->CreateDecoderFromStream(m_source, nullptr, WICDecodeMetadataCacheOnDemand, &m_decoder))) return false;
+        GUID container = {};
+        m_gif = SUCCEEDED(m_decoder->GetContainerFormat(&container)) && container == GUID_ContainerFormatGif;
+        return SUCCEEDED(m_decoder->GetFrameCount(&m_frame_count)) && m_frame_count > 0 && read_canvas_size();
+    }
+
+    UINT get_frame_count() const { return m_frame_count; }
+    bool is_small_enough_to_animate() const {
+        return m_canvas_width <= MAX_ANIMATION_SIZE && m_canvas_height <= MAX_ANIMATION_SIZE;
+    }
+    IWICImagingFactory* get_factory() const { return m_factory; }
+
+    // GIF: centiseconds in the graphic control extension. WebP: milliseconds in its ANMF chunk.
+    unsigned read_delay(UINT index) {
+        CComPtr<IWICBitmapFrameDecode> frame;
+        CComPtr<IWICMetadataQueryReader> metadata;
+        if (FAILED(m_decoder->GetFrame(index, &frame)) || FAILED(frame->GetMetadataQueryReader(&metadata))) {
+            return DEFAULT_FRAME_DELAY;
+        }
+        UINT delay = 0;
+        if (m_gif) {
+            // Like browsers: 0 and 10 ms mean "unspecified", not "as fast as possible"
+            if (read_metadata_uint(metadata, L"/grctlext/Delay", delay) && delay > 1) return delay * 10;
+        } else if (read_metadata_uint(metadata, L"/ANMF/FrameDuration", delay) && delay > 10) {
+            return delay;
+        }
+        return DEFAULT_FRAME_DELAY;
+    }
+
+    // Bring the canvas to the picture after frame index. Frames build on each other, so going
+    // back starts over from the first one.
+    bool compose(animation_canvas& canvas, unsigned index) {
+        if (index >= m_frame_count) return false;
+        if (canvas.width != m_canvas_width || canvas.height != m_canvas_height || canvas.next_frame > index + 1) {
+            reset(canvas);
+        }
+        while (canvas.next_frame <= index) {
+            if (!add_frame(canvas, canvas.next_frame)) return false;
+            canvas.next_frame++;
+        }
+        return true;
+    }
+
+private:
+    CComPtr<IWICImagingFactory> m_factory;
+    CComPtr<IStream> m_source;
+    CComPtr<IWICBitmapDecoder> m_decoder;
+    UINT m_frame_count = 0;
+    bool m_gif = false;
+    int m_canvas_width = 0;
+    int m_canvas_height = 0;
+
+    // GIF frames are placed on a logical screen; WebP frames come out whole
+    bool read_canvas_size() {
+        UINT width = 0, height = 0;
+        CComPtr<IWICMetadataQueryReader> metadata;
+        if (!m_gif || FAILED(m_decoder->GetMetadataQueryReader(&metadata)) ||
+            !read_metadata_uint(metadata, L"/logscrdesc/Width", width) ||
+            !read_metadata_uint(metadata, L"/logscrdesc/Height", height) || width == 0 || height == 0) {
+            CComPtr<IWICBitmapFrameDecode> first;
+            if (FAILED(m_decoder->GetFrame(0, &first)) || FAILED(first->GetSize(&width, &height))) return false;
+        }
+        if (width == 0 || height == 0 || width > MAX_CANVAS_SIZE || height > MAX_CANVAS_SIZE) return false;
+        m_canvas_width = (int)width;
+        m_canvas_height = (int)height;
+        return true;
+    }
+
+    void reset(animation_canvas& canvas) {
+        canvas.width = m_canvas_width;
+        canvas.height = m_canvas_height;
+        canvas.pixels.assign((size_t)m_canvas_width * m_canvas_height * 4, 0);
+        canvas.saved.clear();
+        canvas.next_frame = 0;
+        canvas.disposal = gif_dispose_none;
+        canvas.last_rect = RECT{};
+    }
+
+    bool add_frame(animation_canvas& canvas, unsigned index) {
+        // Undo the previous frame as it asked
+        if (canvas.disposal == gif_dispose_background) {
+            for (LONG y = canvas.last_rect.top; y < canvas.last_rect.bottom; y++) {
+                memset(&canvas.pixels[((size_t)y * canvas.width + canvas.last_rect.left) * 4], 0,
+                    (size_t)(canvas.last_rect.right - canvas.last_rect.left) * 4);
+            }
+        } else if (canvas.disposal == gif_dispose_previous && canvas.saved.size() == canvas.pixels.size()) {
+            canvas.pixels.swap(canvas.saved);
+        }
+
+        CComPtr<IWICBitmapFrameDecode> frame;
+        CComPtr<IWICFormatConverter> converter;
+        UINT frame_width = 0, frame_height = 0;
+        if (FAILED(m_decoder->GetFrame(index, &frame)) || FAILED(frame->GetSize(&frame_width, &frame_height)) ||
+            FAILED(m_factory->CreateFormatConverter(&converter)) ||
+            FAILED(converter->Initialize(frame, GUID_WICPixelFormat32bppBGRA, WICBitmapDitherTypeNone,
+                nullptr, 0.0, WICBitmapPaletteTypeCustom))) {
+            return false;
+        }
+
+        UINT left = 0, top = 0, disposal = gif_dispose_none;
+        if (m_gif) {
+            CComPtr<IWICMetadataQueryReader> metadata;
+            if (SUCCEEDED(frame->GetMetadataQueryReader(&metadata))) {
+                read_metadata_uint(metadata, L"/imgdesc/Left", left);
+                read_metadata_uint(metadata, L"/imgdesc/Top", top);
+                read_metadata_uint(metadata, L"/grctlext/Disposal", disposal);
+            }
+        }
+        if (disposal == gif_dispose_previous) canvas.saved = canvas.pixels;
+
+        std::vector<uint8_t> pixels((size_t)frame_width * frame_height * 4);
+        if (FAILED(converter->CopyPixels(nullptr, frame_width * 4, (UINT)pixels.size(), pixels.data()))) return false;
+
+        // Clip to the canvas; GIF pixels are either opaque or fully transparent (kept from below)
+        int right = (std::min)(canvas.width, (int)(left + frame_width));
+        int bottom = (std::min)(canvas.height, (int)(top + frame_height));
+        for (int y = (int)top; y < bottom && (int)left < right; y++) {
+            const uint8_t* src = &pixels[(size_t)(y - top) * frame_width * 4];
+            uint8_t* dst = &canvas.pixels[((size_t)y * canvas.width + left) * 4];
+            for (int x = (int)left; x < right; x++, src += 4, dst += 4) {
+                if (!m_gif || src[3] != 0) memcpy(dst, src, 4);
+            }
+        }
+
+        canvas.disposal = disposal;
+        canvas.last_rect.left = (std::min)((LONG)left, (LONG)canvas.width);
+        canvas.last_rect.top = (std::min)((LONG)top, (LONG)canvas.height);
+        canvas.last_rect.right = (std::max)(canvas.last_rect.left, (LONG)right);
+        canvas.last_rect.bottom = (std::max)(canvas.last_rect.top, (LONG)bottom);
+        return true;
+    }
+};
+
+bool read_animation_delays(const album_art_data_ptr& data, std::vector<unsigned>& delays_ms) {
+    delays_ms.clear();
+    if (data.is_empty() || data->get_size() > MAX_SOURCE_SIZE || !is_animation_container(data)) return false;
+    com_scope com;
+    wic_animation animation;
+    if (!animation.open(data) || animation.get_frame_count() < 2 || !animation.is_small_enough_to_animate()) return false;
+    delays_ms.resize(animation.get_frame_count());
+    for (UINT i = 0; i < animation.get_frame_count(); i++) {
+        delays_ms[i] = animation.read_delay(i);
+    }
+    return true;
+}
+
+bool decode_first_frame(const album_art_data_ptr& data, std::vector<uint8_t>& pixels, int& width, int& height) {
+    if (data.is_empty() || data->get_size() == 0) return false;
+    com_scope com;
+    wic_animation animation;
+    animation_canvas canvas;
+    if (!animation.open(data) || !animation.compose(canvas, 0)) return false;
+    pixels.swap(canvas.pixels);
+    width = canvas.width;
+    height = canvas.height;
+    return true;
+}
+
+struct animated_artwork::stream {
+    album_art_data_ptr data;
+    unsigned frame_count;
+    int requested_width;            // Cover size the stream was started for
+    int requested_height;
+    int width;                      // Frame size, after the memory cap
+    int height;
+    bool resident;                  // Every frame fits: decoded once, then looped from memory
+    abort_callback_impl abort;
+
+    // Slots [head, head + count) hold decoded frames in playback order and belong to the main
+    // thread; the worker only writes the slot after them. Resident streams never pop, so their
+    // slot index is the playback position.
+    std::vector<std::vector<uint8_t>> slots;
+    std::mutex mutex;
+    size_t head;
+    size_t count;
+    bool waiting;                   // advance() found no frame: the worker reports the next one
+    size_t position;                // Main thread: resident slot on show
+
+    // Worker only; batches of one stream never overlap. No GDI+ or COM object outlives a
+    // batch, so the last reference can go on any thread at any time.
+    unsigned next_frame;
+    animation_canvas canvas;
+
+    stream()
+        : frame_count(0)
+        , requested_width(0)
+        , requested_height(0)
+        , width(0)
+        , height(0)
+        , resident(false)
+        , head(0)
+        , count(0)
+        , waiting(false)
+        , position(0)
+        , next_frame(0) {
+    }
+
+    bool render_frame(IWICImagingFactory* factory, std::vector<uint8_t>& pixels);
+};
+
+// The composed canvas scaled to fit and letterboxed on the same dark gray as the docked thumbnail
+bool animated_artwork::stream::render_frame(IWICImagingFactory* factory, std::vector<uint8_t>& pixels) {
+    int draw_width = width;
+    int draw_height = height;
+    if ((long long)canvas.width * height > (long long)canvas.height * width) {
+        draw_height = (std::max)(1, (int)((long long)width * canvas.height / canvas.width));
+    } else if ((long long)canvas.width * height < (long long)canvas.height * width) {
+        draw_width = (std::max)(1, (int)((long long)height * canvas.width / canvas.height));
+    }
+
+    // Scaling averages neighbours, so transparent pixels must not bleed their color
+    std::vector<uint8_t> premultiplied(canvas.pixels.size());
+    for (size_t i = 0; i < canvas.pixels.size(); i += 4) {
+        unsigned alpha = canvas.pixels[i + 3];
+        premultiplied[i] = (uint8_t)((canvas.pixels[i] * alpha + 127) / 255);
+        premultiplied[i + 1] = (uint8_t)((canvas.pixels[i + 1] * alpha + 127) / 255);
+        premultiplied[i + 2] = (uint8_t)((canvas.pixels[i + 2] * alpha + 127) / 255);
+        premultiplied[i + 3] = (uint8_t)alpha;
+    }
+
+    CComPtr<IWICBitmap> source;
+    CComPtr<IWICBitmapScaler> scaler;
+    if (FAILED(factory->CreateBitmapFromMemory(canvas.width, canvas.height, GUID_WICPixelFormat32bppPBGRA,
+            canvas.width * 4, (UINT)premultiplied.size(), premultiplied.data(), &source)) ||
+        FAILED(factory->CreateBitmapScaler(&scaler))) {
+        return false;
+    }
+    // High quality cubic needs Windows 10; Fant is the best filter before it
+    if (FAILED(scaler->Initialize(source, draw_width, draw_height, WICBitmapInterpolationModeHighQualityCubic)) &&
+        FAILED(scaler->Initialize(source, draw_width, draw_height, WICBitmapInterpolationModeFant))) {
+        return false;
+    }
+    std::vector<uint8_t> scaled((size_t)draw_width * draw_height * 4);
+    if (FAILED(scaler->CopyPixels(nullptr, draw_width * 4, (UINT)scaled.size(), scaled.data()))) return false;
+
+    if (pixels.empty()) pixels.resize((size_t)width * height * 4);
+    const uint8_t background = 32;
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        pixels[i] = pixels[i + 1] = pixels[i + 2] = background;
+        pixels[i + 3] = 255;
+    }
+    int offset_x = (width - draw_width) / 2;
+    int offset_y = (height - draw_height) / 2;
+    for (int y = 0; y < draw_height; y++) {
+        const uint8_t* src = &scaled[(size_t)y * draw_width * 4];
+        uint8_t* dst = &pixels[((size_t)(y + offset_y) * width + offset_x) * 4];
+        for (int x = 0; x < draw_width; x++, src += 4, dst += 4) {
+            unsigned inverse = 255 - src[3];
+            dst[0] = (uint8_t)(src[0] + (background * inverse + 127) / 255);
+            dst[1] = (uint8_t)(src[1] + (background * inverse + 127) / 255);
+            dst[2] = (uint8_t)(src[2] + (background * inverse + 127) / 255);
+        }
+    }
+    return true;
+}
+
+animated_artwork::animated_artwork()
+    : m_frame(0)
+    , m_decoding(false)
+    , m_bitmap(nullptr)
+    , m_bits(nullptr)
+    , m_has_frame(false)
+    , m_alive(std::make_shared<bool>(true)) {
+}
+
+animated_artwork::~animated_artwork() {
+    close();
+}
+
+void animated_artwork::open(const album_art_data_ptr& data, const std::vector<unsigned>& delays_ms) {
+    close();
+    if (data.is_empty() || data->get_size() == 0 || data->get_size() > MAX_SOURCE_SIZE || delays_ms.size() < 2) return;
+    m_data = data;
+    m_delays = delays_ms;
+}
+
+void animated_artwork::close() {
+    suspend();
+    m_data.release();
+    m_delays.clear();
+    m_frame = 0;
+}
+
+void animated_artwork::suspend() {
+    stop_stream();
+    if (m_bitmap) {
+        DeleteObject(m_bitmap);
+        m_bitmap = nullptr;
+        m_bits = nullptr;
+    }
+}
+
+void animated_artwork::stop_stream() {
+    if (m_stream) {
+        m_stream->abort.abort();
+        m_stream.reset();
+    }
+    m_decoding = false;
+    m_has_frame = false;
+}
+
+HBITMAP animated_artwork::get_frame(int width, int height) {
+    if (!is_open() || width <= 0 || height <= 0) return nullptr;
+    if (!m_stream || m_stream->requested_width != width || m_stream->requested_height != height) {
+        start_stream(width, height);
+    }
+    return m_has_frame ? m_bitmap : nullptr;
+}
+
+void animated_artwork::start_stream(int width, int height) {
+    suspend();
+
+    auto s = std::make_shared<stream>();
+    s->data = m_data;
+    s->frame_count = (unsigned)m_delays.size();
+    s->requested_width = width;
+    s->requested_height = height;
+
+    // Frames too large for two slots are decoded smaller and stretched when drawn
+    size_t frame_bytes = (size_t)width * height * 4;
+    if (frame_bytes * MIN_RING_FRAMES > RING_MEMORY_LIMIT) {
+        double scale = sqrt((double)RING_MEMORY_LIMIT / (double)(frame_bytes * MIN_RING_FRAMES));
+        width = (std::max)(1, (int)(width * scale));
+        height = (std::max)(1, (int)(height * scale));
+        frame_bytes = (size_t)width * height * 4;
+    }
+    s->width = width;
+    s->height = height;
+
+    size_t capacity = RING_MEMORY_LIMIT / frame_bytes;
+    s->resident = s->frame_count <= capacity;
+    s->slots.resize(s->resident ? s->frame_count : (std::min)(capacity, RING_FRAMES));
+    s->next_frame = m_frame;   // Resume at the frame on show
+
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height; // Top-down, like the decoded slots
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    m_bitmap = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &m_bits, nullptr, 0);
+    if (!m_bitmap || !m_bits) {
+        if (m_bitmap) DeleteObject(m_bitmap);
+        m_bitmap = nullptr;
+        m_bits = nullptr;
+        return;
+    }
+    TRAY_PERF_COUNT(perf_counter_gdi_objects);
+
+    TRAY_TRACE_INSTANT("artwork", "animation stream start");
+    s->waiting = true;  // The first frame is shown as soon as it lands
+    m_stream = s;
+    schedule_decode();
+}
+
+// Fill the free slots on a worker; one batch per stream at a time
+void animated_artwork::schedule_decode() {
+    if (m_decoding || !m_stream) return;
+    m_decoding = true;
+
+    std::weak_ptr<bool> alive = m_alive;
+    animated_artwork* self = this;
+    std::shared_ptr<stream> source = m_stream;
+    fb2k::splitTask([alive, self, source] {
+        TRAY_TRACE_SCOPE("artwork", "decode animation frames");
+        bool failed = false;
+        try {
+            com_scope com;
+            wic_animation animation;
+            failed = !animation.open(source->data) || animation.get_frame_count() < source->frame_count;
+            while (!failed) {
+                source->abort.check();
+                size_t slot;
+                {
+                    std::lock_guard<std::mutex> lock(source->mutex);
+                    if (source->count >= source->slots.size()) break;
+                    slot = (source->head + source->count) % source->slots.size();
+                }
+                if (!animation.compose(source->canvas, source->next_frame) ||
+                    !source->render_frame(animation.get_factory(), source->slots[slot])) {
+                    failed = true;
+                    break;
+                }
+                TRAY_PERF_COUNT(perf_counter_animation_frames);
+                source->next_frame = (source->next_frame + 1) % source->frame_count;
+
+                // Shown right away if the main thread is waiting, not after the whole batch
+                bool wanted;
+                {
+                    std::lock_guard<std::mutex> lock(source->mutex);
+                    source->count++;
+                    wanted = source->waiting;
+                    source->waiting = false;
+                }
+                if (wanted) {
+                    fb2k::inMainThread([alive, self, source] {
+                        if (alive.expired()) return;
+                        self->on_frame_ready(source);
+                    });
+                }
+            }
+        } catch (exception_aborted const&) {
+            return;
+        } catch (...) {
+            failed = true;
+        }
+
+        fb2k::inMainThread([alive, self, source, failed] {
+            if (alive.expired()) return;
+            self->on_batch_done(source, failed);
+        });
+    });
+}
+
+void animated_artwork::on_frame_ready(const std::shared_ptr<stream>& source) {
+    if (source != m_stream) return;
+    control_panel::get_instance().on_cover_animation_ready();
+}
+
+void animated_artwork::on_batch_done(const std::shared_ptr<stream>& source, bool failed) {
+    if (source != m_stream) return;
+    m_decoding = false;
+    if (failed) {
+        // Not decodable frame by frame after all: the static first frame stays
+        close();
+        control_panel::get_instance().on_cover_animation_ready();
+    }
+}
+
+bool animated_artwork::advance() {
+    if (!m_stream || !m_bits) return false;
+    stream& s = *m_stream;
+
+    size_t slot;
+    bool available;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.resident) {
+            slot = m_has_frame ? (s.position + 1) % s.slots.size() : 0;
+            available = slot < s.count;
+        } else {
+            slot = s.head;
+            available = s.count > 0;
+        }
+        if (!available) s.waiting = true;
+    }
+    if (!available) {
+        // Normally a batch is already filling the ring; make sure of it
+        schedule_decode();
+        return false;
+    }
+
+    if (!show_slot(slot)) return false;
+    bool refill = false;
+    if (s.resident) {
+        s.position = slot;
+    } else {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.head = (s.head + 1) % s.slots.size();
+        s.count--;
+        // Refill once half the ring has been shown, so the worker wakes in batches
+        refill = s.count <= s.slots.size() / 2;
+    }
+    if (m_has_frame) m_frame = (m_frame + 1) % (unsigned)m_delays.size();
+    m_has_frame = true;
+
+    if (refill) schedule_decode();
+    return true;
+}
+
+bool animated_artwork::show_slot(size_t slot) {
+    const std::vector<uint8_t>& pixels = m_stream->slots[slot];
+    size_t bytes = (size_t)m_stream->width * m_stream->height * 4;
+    if (pixels.size() != bytes) return false;
+    GdiFlush(); // Earlier GDI draws from the DIB must be done before its bits change
+    memcpy(m_bits, pixels.data(), bytes);
+    return true;
+}
+
+unsigned animated_artwork::get_delay() const {
+    return m_frame < m_delays.size() ? m_delays[m_frame] : DEFAULT_FRAME_DELAY;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "stdafx.h"
+#include <memory>
+#include <vector>
+
+// Frames come from WIC, a system component: GIF everywhere, and WebP (animated too) where
+// the system WebP codec is installed. Both helpers below run on workers and set up COM for
+// the calling thread themselves.
+
+// Frame delays of an animated cover (GIF or WebP), or false for a still image. Delays are in
+// ms, one per frame, with the near-zero ones browsers also slow down raised to a watchable speed.
+bool read_animation_delays(const album_art_data_ptr& data, std::vector<unsigned>& delays_ms);
+
+// First frame of an image GDI+ has no codec for (WebP), composed at full size as 32 bpp BGRA
+// with straight alpha, top-down rows of width * 4 bytes
+bool decode_first_frame(const album_art_data_ptr& data, std::vector<uint8_t>& pixels, int& width, int& height);
+
+// Animated cover art streamed frame by frame. The encoded image is the only complete copy of
+// the animation: a worker decodes a few frames ahead of the one on show, each scaled once to
+// the size the cover is drawn at, into a ring whose memory is capped (large covers are decoded
+// smaller and stretched instead of holding fewer than two frames). An animation short enough
+// to fit the ring is decoded once and then loops from memory, its first frame showing as soon
+// as it is decoded. The control panel shows the frames on its own timer and suspends the
+// stream while it cannot be seen. Main thread only.
+class animated_artwork {
+public:
+    animated_artwork();
+    ~animated_artwork();
+
+    // Start over with a new cover; until the stream delivers, the static decode (its first
+    // frame) is drawn
+    void open(const album_art_data_ptr& data, const std::vector<unsigned>& delays_ms);
+    void close();
+    bool is_open() const { return m_data.is_valid(); }
+
+    // Stop decoding and free the frames. The frame on show is remembered; the next
+    // get_frame() restarts the stream there.
+    void suspend();
+
+    // The frame to draw for a cover of width x height, or null until one has been decoded at
+    // that size. Asking for another size restarts the stream at the frame on show.
+    HBITMAP get_frame(int width, int height);
+
+    // Show the next frame. False when the worker has not delivered it yet; the control panel
+    // is called back (on_cover_animation_ready) once it has.
+    bool advance();
+
+    // How long the frame on show stays up, in ms
+    unsigned get_delay() const;
+
+private:
+    struct stream;                      // State shared with the decode worker
+
+    album_art_data_ptr m_data;
+    std::vector<unsigned> m_delays;
+    unsigned m_frame;                   // Index of the frame on show
+    std::shared_ptr<stream> m_stream;
+    bool m_decoding;                    // A decode batch is running for m_stream
+
+    HBITMAP m_bitmap;                   // Frame on show, at the stream's frame size
+    void* m_bits;
+    bool m_has_frame;                   // m_bitmap holds a frame of the current stream
+
+    std::shared_ptr<bool> m_alive;      // Lets worker completions detect a destroyed object
+
+    void start_stream(int width, int height);
+    void stop_stream();
+    void schedule_decode();
+    void on_frame_ready(const std::shared_ptr<stream>& source);
+    void on_batch_done(const std::shared_ptr<stream>& source, bool failed);
+    bool show_slot(size_t slot);
+
+    animated_artwork(const animated_artwork&) = delete;
+    animated_artwork& operator=(const animated_artwork&) = delete;
+};
@@ -2,7 +2,9 @@
 #include "artwork_bridge.h"
 #include "control_panel.h"
 #include "popup_window.h"
+#include "tracing.h"
 #include <mutex>
+#include <atomic>
 
 // Global function pointers
 pfn_foo_artwork_search g_artwork_search = nullptr;
@@ -16,45 +18,183 @@ static HMODULE g_foo_artwork_module = nullptr;
 
 // Pending artwork from callback (guarded by g_pending_mutex)
 static std::mutex g_pending_mutex;
-static HBITMAP g_pending_artwork_bitmap = nullptr;
+static bridge_artwork_ptr g_pending_artwork;
 static bool g_has_pending_artwork_popup = false;
 static bool g_has_pending_artwork_panel = false;
 
-// Create an independent copy of an HBITMAP (caller owns the copy and must DeleteObject it)
-static HBITMAP copy_hbitmap(HBITMAP source) {
+// Last image imported from foo_artwork_get_bitmap(), keyed by the source handle and size
+// so repeated get_current_online_artwork() calls share one import (guarded by g_pending_mutex).
+// foo_artwork frees its bitmap when the next result arrives and GDI reuses handle values, so
+// the key only holds until then: every result and every cleared request forgets the import.
+static HBITMAP g_current_source = nullptr;
+static int g_current_source_width = 0;
+static int g_current_source_height = 0;
+static bridge_artwork_ptr g_current_artwork;
+
+// Accounting
+static std::atomic<long> g_stat_live_handles(0);
+static std::atomic<long long> g_stat_live_bytes(0);
+static std::atomic<long> g_stat_total_imports(0);
+static std::atomic<long> g_stat_total_received(0);
+static std::atomic<long> g_stat_total_shares(0);
+static std::atomic<long> g_stat_searches_issued(0);
+static std::atomic<long> g_stat_searches_deferred(0);
+static std::atomic<long> g_stat_searches_skipped(0);
+
+// Last requested artist & title for search deduplication
+static std::string g_last_requested_artist;
+static std::string g_last_requested_title;
+
+// Online search throttling (guarded by g_pending_mutex, timer state main thread only).
+// Stations push a new title for every jingle and ad break; searches are spaced at least
+// MIN_SEARCH_INTERVAL_MS apart with the latest request winning, and titles foo_artwork
+// found nothing for are not searched again for NEGATIVE_CACHE_TTL_MS.
+static const DWORD MIN_SEARCH_INTERVAL_MS = 2000;
+static const DWORD NEGATIVE_CACHE_TTL_MS = 10 * 60 * 1000;
+static const size_t NEGATIVE_CACHE_MAX_ENTRIES = 64;
+
+struct negative_cache_entry {
+    std::string key;
+    DWORD tick;
+};
+static std::vector<negative_cache_entry> g_negative_cache;
+static std::string g_in_flight_key; // Search awaiting a result, empty if none
+static DWORD g_last_search_tick = 0;
+static bool g_has_searched = false;
+static std::string g_deferred_artist;
+static std::string g_deferred_title;
+static UINT_PTR g_deferred_search_timer = 0;
+
+bridge_artwork::bridge_artwork(HBITMAP bitmap, int width, int height)
+    : m_bitmap(bitmap)
+    , m_width(width)
+    , m_height(height) {
+    g_stat_live_handles++;
+    g_stat_live_bytes += (long long)byte_size();
+}
+
+bridge_artwork::~bridge_artwork() {
+    if (m_bitmap) {
+        DeleteObject(m_bitmap);
+        g_stat_live_handles--;
+        g_stat_live_bytes -= (long long)byte_size();
+    }
+}
+
+// Copy a foreign HBITMAP into a 32-bit top-down DIB section. This is the only
+// pixel copy made for a received artwork; all consumers share the result.
+bridge_artwork_ptr bridge_artwork::import(HBITMAP source) {
     if (!source) return nullptr;
 
     BITMAP bm;
-    if (!GetObject(source, sizeof(bm), &bm)) return nullptr;
+    if (!GetObject(source, sizeof(bm), &bm) || bm.bmWidth <= 0 || bm.bmHeight <= 0) return nullptr;
 
-    HDC screen_dc = GetDC(nullptr);
-    HDC src_dc = CreateCompatibleDC(screen_dc);
-    HDC dst_dc = CreateCompatibleDC(screen_dc);
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = bm.bmWidth;
+    bmi.bmiHeader.biHeight = -bm.bmHeight; // Top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
 
-    HBITMAP copy = CreateCompatibleBitmap(screen_dc, bm.bmWidth, bm.bmHeight);
-    if (copy) {
-        HBITMAP old_src = (HBITMAP)SelectObject(src_dc, source);
-        HBITMAP old_dst = (HBITMAP)SelectObject(dst_dc, copy);
+    HDC screen_dc = GetDC(nullptr);
+    void* bits = nullptr;
+    HBITMAP dib = CreateDIBSection(screen_dc, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    bool ok = false;
+    if (dib && bits) {
+        // GetDIBits converts from any source format straight into our pixel buffer
+        ok = GetDIBits(screen_dc, source, 0, bm.bmHeight, bits, &bmi, DIB_RGB_COLORS) == bm.bmHeight;
+    }
+    ReleaseDC(nullptr, screen_dc);
 
-        BitBlt(dst_dc, 0, 0, bm.bmWidth, bm.bmHeight, src_dc, 0, 0, SRCCOPY);
+    if (!ok) {
+        if (dib) DeleteObject(dib);
+        return nullptr;
+    }
 
-        SelectObject(src_dc, old_src);
-        SelectObject(dst_dc, old_dst);
+    // Force opaque alpha so the image composites correctly into layered windows
+    DWORD* px = static_cast<DWORD*>(bits);
+    size_t count = (size_t)bm.bmWidth * (size_t)bm.bmHeight;
+    for (size_t i = 0; i < count; i++) {
+        px[i] |= 0xFF000000;
     }
+    GdiFlush();
 
-    DeleteDC(src_dc);
-    DeleteDC(dst_dc);
-    ReleaseDC(nullptr, screen_dc);
-    return copy;
+    g_stat_total_imports++;
+    bridge_artwork_ptr art(new bridge_artwork(dib, bm.bmWidth, bm.bmHeight));
+
+#ifdef _DEBUG
+    char msg[160];
+    sprintf_s(msg, "artwork_bridge: imported %dx%d, live handles=%ld bytes=%lld imports=%ld received=%ld shares=%ld\n",
+        bm.bmWidth, bm.bmHeight, g_stat_live_handles.load(), g_stat_live_bytes.load(),
+        g_stat_total_imports.load(), g_stat_total_received.load(), g_stat_total_shares.load());
+    OutputDebugStringA(msg);
+#endif
+
+    return art;
+}
+
+// Hand an already-imported image to a consumer (counted for accounting only)
+static bridge_artwork_ptr share_artwork(const bridge_artwork_ptr& art) {
+    if (art) g_stat_total_shares++;
+    return art;
+}
+
+void get_artwork_bridge_stats(artwork_bridge_stats& out) {
+    out.live_handles = g_stat_live_handles.load();
+    out.live_bytes = g_stat_live_bytes.load();
+    out.total_imports = g_stat_total_imports.load();
+    out.total_received = g_stat_total_received.load();
+    out.total_shares = g_stat_total_shares.load();
+    out.searches_issued = g_stat_searches_issued.load();
+    out.searches_deferred = g_stat_searches_deferred.load();
+    out.searches_skipped = g_stat_searches_skipped.load();
+}
+
+static void record_search_miss();
+
+// Caller holds g_pending_mutex
+static void forget_current_artwork() {
+    g_current_source = nullptr;
+    g_current_source_width = 0;
+    g_current_source_height = 0;
+    g_current_artwork.reset();
 }
 
 // Callback function that receives artwork results from foo_artwork.
 // Called on foo_artwork's worker thread - must synchronize and marshal to main thread.
 static void artwork_result_callback(bool success, HBITMAP bitmap) {
-    if (success && bitmap) {
+    TRAY_TRACE_SCOPE("artwork", "artwork_result_callback");
+    {
+        // foo_artwork's bitmap is replaced with this result; the old handle may be recycled
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        forget_current_artwork();
+    }
+    if (!success) {
+        record_search_miss();
+        return;
+    }
+    if (bitmap) {
+        g_stat_total_received++;
+
+        // Only the search in flight may set the pending artwork; a result arriving after its
+        // request was superseded or cleared belongs to a previous track
+        std::string key;
+        {
+            std::lock_guard<std::mutex> lock(g_pending_mutex);
+            if (g_in_flight_key.empty()) return;
+            key = g_in_flight_key;
+        }
+
+        // Import while foo_artwork guarantees the handle is valid (we are on its thread)
+        bridge_artwork_ptr art = bridge_artwork::import(bitmap);
+        if (!art) return;
+
         {
             std::lock_guard<std::mutex> lock(g_pending_mutex);
-            g_pending_artwork_bitmap = bitmap;
+            if (g_in_flight_key != key) return;
+            g_pending_artwork = art;
+            g_in_flight_key.clear();
             g_has_pending_artwork_popup = true;
             g_has_pending_artwork_panel = true;
         }
@@ -107,49 +247,159 @@ void shutdown_artwork_bridge() {
     } else if (g_artwork_set_callback) {
         g_artwork_set_callback(nullptr); // Fallback for older foo_artwork
     }
+    if (g_deferred_search_timer) {
+        KillTimer(nullptr, g_deferred_search_timer);
+        g_deferred_search_timer = 0;
+    }
     std::lock_guard<std::mutex> lock(g_pending_mutex);
-    g_pending_artwork_bitmap = nullptr;
+    g_pending_artwork.reset();
     g_has_pending_artwork_popup = false;
     g_has_pending_artwork_panel = false;
+    forget_current_artwork();
+    g_deferred_artist.clear();
+    g_deferred_title.clear();
+    g_in_flight_key.clear();
 }
 
-// Last requested artist & title for search deduplication
-static std::string g_last_requested_artist;
-static std::string g_last_requested_title;
+static std::string make_search_key(const std::string& artist, const std::string& title) {
+    std::string key = artist;
+    key += '\x1f';
+    key += title;
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+    return key;
+}
+
+static void record_search_miss() {
+    std::lock_guard<std::mutex> lock(g_pending_mutex);
+    if (g_in_flight_key.empty()) return; // Result for someone else's search
+
+    DWORD now = GetTickCount();
+    auto it = std::find_if(g_negative_cache.begin(), g_negative_cache.end(),
+        [](const negative_cache_entry& e) { return e.key == g_in_flight_key; });
+    if (it != g_negative_cache.end()) {
+        it->tick = now;
+    } else {
+        if (g_negative_cache.size() >= NEGATIVE_CACHE_MAX_ENTRIES) {
+            g_negative_cache.erase(g_negative_cache.begin()); // Oldest first
+        }
+        g_negative_cache.push_back({ g_in_flight_key, now });
+    }
+
+    // Allow the same title to be requested again once it leaves the cache, unless a newer
+    // title has been requested since
+    if (make_search_key(g_last_requested_artist, g_last_requested_title) == g_in_flight_key) {
+        g_last_requested_artist.clear();
+        g_last_requested_title.clear();
+    }
+    g_in_flight_key.clear();
+}
+
+// Caller holds g_pending_mutex
+static bool is_negative_cached(const std::string& key) {
+    DWORD now = GetTickCount();
+    for (auto it = g_negative_cache.begin(); it != g_negative_cache.end(); ) {
+        if (now - it->tick > NEGATIVE_CACHE_TTL_MS) {
+            it = g_negative_cache.erase(it);
+        } else if (it->key == key) {
+            return true;
+        } else {
+            ++it;
+        }
+    }
+    return false;
+}
+
+static void issue_search(const std::string& artist, const std::string& title) {
+    {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        g_in_flight_key = make_search_key(artist, title);
+        g_last_search_tick = GetTickCount();
+        g_has_searched = true;
+    }
+    g_stat_searches_issued++;
+    TRAY_TRACE_SCOPE("artwork", "foo_artwork_search");
+    g_artwork_search(artist.c_str(), title.c_str());
+}
+
+static VOID CALLBACK deferred_search_timer_proc(HWND hwnd, UINT msg, UINT_PTR timer_id, DWORD time) {
+    TRAY_TRACE_INSTANT("timer", "deferred artwork search");
+    KillTimer(nullptr, timer_id);
+    g_deferred_search_timer = 0;
+
+    std::string artist, title;
+    {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        artist.swap(g_deferred_artist);
+        title.swap(g_deferred_title);
+    }
+    if (g_artwork_search && (!artist.empty() || !title.empty())) {
+        issue_search(artist, title);
+    }
+}
 
 void clear_pending_online_artwork() {
     std::lock_guard<std::mutex> lock(g_pending_mutex);
-    g_pending_artwork_bitmap = nullptr;
+    g_pending_artwork.reset();
     g_has_pending_artwork_popup = false;
     g_has_pending_artwork_panel = false;
+    forget_current_artwork();
+    g_in_flight_key.clear(); // The running search no longer answers anything shown
 }
 
-void request_online_artwork(const char* artist, const char* title) {
+bool request_online_artwork(const char* artist, const char* title) {
     if (!g_artwork_search) {
-        return;
+        return false;
     }
 
     const char* safe_artist = artist ? artist : "";
     const char* safe_title = title ? title : "";
 
     if (safe_artist[0] == '\0' && safe_title[0] == '\0') {
-        return;
+        return false;
     }
 
-    // Deduplicate: If already searching or searched for this exact artist & title, don't re-issue search
+    DWORD wait_ms = 0;
     {
         std::lock_guard<std::mutex> lock(g_pending_mutex);
+        // Deduplicate: If already searching or searched for this exact artist & title, don't re-issue search
         if (g_last_requested_artist == safe_artist && g_last_requested_title == safe_title) {
-            return;
+            return true;
+        }
+        if (is_negative_cached(make_search_key(safe_artist, safe_title))) {
+            g_stat_searches_skipped++;
+            return false;
         }
         g_last_requested_artist = safe_artist;
         g_last_requested_title = safe_title;
-        g_pending_artwork_bitmap = nullptr;
+        g_pending_artwork.reset();
         g_has_pending_artwork_popup = false;
         g_has_pending_artwork_panel = false;
+
+        DWORD elapsed = GetTickCount() - g_last_search_tick;
+        if (g_has_searched && elapsed < MIN_SEARCH_INTERVAL_MS) {
+            wait_ms = MIN_SEARCH_INTERVAL_MS - elapsed;
+            g_deferred_artist = safe_artist;
+            g_deferred_title = safe_title;
+            g_in_flight_key.clear(); // A late result of the previous search is for another title
+        }
+    }
+
+    if (wait_ms > 0) {
+        g_stat_searches_deferred++;
+        if (!g_deferred_search_timer) {
+            g_deferred_search_timer = SetTimer(nullptr, 0, wait_ms, deferred_search_timer_proc);
+        }
+        if (g_deferred_search_timer) {
+            return true;
+        }
+        // No timer available - fall through and search now
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        g_deferred_artist.clear();
+        g_deferred_title.clear();
     }
 
-    g_artwork_search(safe_artist, safe_title);
+    issue_search(safe_artist, safe_title);
+    return true;
 }
 
 bool has_pending_online_artwork() {
@@ -167,59 +417,59 @@ bool has_pending_online_artwork_panel() {
     return g_has_pending_artwork_panel;
 }
 
-HBITMAP get_pending_online_artwork() {
-    HBITMAP src = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(g_pending_mutex);
-        src = g_pending_artwork_bitmap;
-        g_has_pending_artwork_popup = false;
-        g_has_pending_artwork_panel = false;
-    }
-    return copy_hbitmap(src);
+bridge_artwork_ptr get_pending_online_artwork() {
+    std::lock_guard<std::mutex> lock(g_pending_mutex);
+    g_has_pending_artwork_popup = false;
+    g_has_pending_artwork_panel = false;
+    return share_artwork(g_pending_artwork);
 }
 
-HBITMAP get_pending_online_artwork_popup() {
-    HBITMAP src = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(g_pending_mutex);
-        if (g_has_pending_artwork_popup) {
-            src = g_pending_artwork_bitmap;
-            g_has_pending_artwork_popup = false;
-        }
-    }
-    return copy_hbitmap(src);
+bridge_artwork_ptr get_pending_online_artwork_popup() {
+    std::lock_guard<std::mutex> lock(g_pending_mutex);
+    if (!g_has_pending_artwork_popup) return nullptr;
+    g_has_pending_artwork_popup = false;
+    return share_artwork(g_pending_artwork);
 }
 
-HBITMAP get_pending_online_artwork_panel() {
-    HBITMAP src = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(g_pending_mutex);
-        if (g_has_pending_artwork_panel) {
-            src = g_pending_artwork_bitmap;
-            g_has_pending_artwork_panel = false;
-        }
-    }
-    return copy_hbitmap(src);
+bridge_artwork_ptr get_pending_online_artwork_panel() {
+    std::lock_guard<std::mutex> lock(g_pending_mutex);
+    if (!g_has_pending_artwork_panel) return nullptr;
+    g_has_pending_artwork_panel = false;
+    return share_artwork(g_pending_artwork);
 }
 
-HBITMAP get_last_online_artwork() {
-    HBITMAP src = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(g_pending_mutex);
-        src = g_pending_artwork_bitmap;
-    }
-    return copy_hbitmap(src);
+bridge_artwork_ptr get_last_online_artwork() {
+    std::lock_guard<std::mutex> lock(g_pending_mutex);
+    return share_artwork(g_pending_artwork);
 }
 
-HBITMAP get_current_online_artwork() {
+bridge_artwork_ptr get_current_online_artwork() {
     // Check if foo_artwork already has an active artwork bitmap available (e.g. displayed in main window)
-    if (g_artwork_get_bitmap) {
-        HBITMAP bmp = g_artwork_get_bitmap();
-        if (bmp) {
-            return copy_hbitmap(bmp);
+    if (!g_artwork_get_bitmap) return nullptr;
+
+    HBITMAP bmp = g_artwork_get_bitmap();
+    if (!bmp) return nullptr;
+
+    BITMAP bm;
+    if (!GetObject(bmp, sizeof(bm), &bm)) return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        if (g_current_artwork && bmp == g_current_source &&
+            bm.bmWidth == g_current_source_width && bm.bmHeight == g_current_source_height) {
+            return share_artwork(g_current_artwork);
         }
     }
-    return nullptr;
+
+    bridge_artwork_ptr art = bridge_artwork::import(bmp);
+    if (art) {
+        std::lock_guard<std::mutex> lock(g_pending_mutex);
+        g_current_source = bmp;
+        g_current_source_width = bm.bmWidth;
+        g_current_source_height = bm.bmHeight;
+        g_current_artwork = art;
+    }
+    return art;
 }
 
 bool is_online_artwork_loading() {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <windows.h>
+#include <memory>
 
 // Callback type for receiving artwork results from foo_artwork
 // Parameters: success (true if artwork found), bitmap (valid HBITMAP if success)
@@ -33,8 +34,9 @@ inline bool is_artwork_bridge_available() {
 }
 
 // Request artwork from foo_artwork for given artist/title
-// No-op if bridge not available
-void request_online_artwork(const char* artist, const char* title);
+// Returns true if a search was issued, is already in flight, or is queued behind the
+// rate limit; false if the bridge is unavailable or the pair recently returned no art.
+bool request_online_artwork(const char* artist, const char* title);
 
 // Clear any pending online artwork from previous search
 void clear_pending_online_artwork();
@@ -44,19 +46,61 @@ bool has_pending_online_artwork();
 bool has_pending_online_artwork_popup();
 bool has_pending_online_artwork_panel();
 
-// Get a copy of the pending artwork bitmap and clear the pending flag.
-// Caller OWNS the returned HBITMAP and must DeleteObject it.
-HBITMAP get_pending_online_artwork();
-HBITMAP get_pending_online_artwork_popup();
-HBITMAP get_pending_online_artwork_panel();
+// Immutable, reference-counted artwork image imported once from foo_artwork.
+// The bitmap is a 32-bit top-down DIB section (opaque alpha) shared by every consumer;
+// holders keep a bridge_artwork_ptr alive while they use bitmap() and must NOT DeleteObject it.
+// Only select it into a DC on the main thread, and deselect before returning.
+class bridge_artwork {
+public:
+    ~bridge_artwork();
 
-// Get a copy of the last received artwork bitmap without changing state.
-// Used to re-acquire artwork after mode switches. Caller OWNS the returned HBITMAP.
-HBITMAP get_last_online_artwork();
+    HBITMAP bitmap() const { return m_bitmap; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    size_t byte_size() const { return (size_t)m_width * (size_t)m_height * 4; }
 
-// Get a copy of the currently active artwork bitmap directly from foo_artwork (e.g. displayed in main window).
-// Caller OWNS the returned HBITMAP and must DeleteObject it.
-HBITMAP get_current_online_artwork();
+    // Import (copy) a foreign HBITMAP into a new shared image. Returns null on failure.
+    static std::shared_ptr<const bridge_artwork> import(HBITMAP source);
+
+    bridge_artwork(const bridge_artwork&) = delete;
+    bridge_artwork& operator=(const bridge_artwork&) = delete;
+
+private:
+    bridge_artwork(HBITMAP bitmap, int width, int height);
+
+    HBITMAP m_bitmap;
+    int m_width;
+    int m_height;
+};
+
+typedef std::shared_ptr<const bridge_artwork> bridge_artwork_ptr;
+
+// Get the pending artwork image and clear the pending flag.
+// The returned image is shared - no per-consumer copy is made.
+bridge_artwork_ptr get_pending_online_artwork();
+bridge_artwork_ptr get_pending_online_artwork_popup();
+bridge_artwork_ptr get_pending_online_artwork_panel();
+
+// Get the last received artwork image without changing state.
+// Used to re-acquire artwork after mode switches.
+bridge_artwork_ptr get_last_online_artwork();
+
+// Get the currently active artwork directly from foo_artwork (e.g. displayed in main window).
+// Imported once per foo_artwork bitmap and shared between callers.
+bridge_artwork_ptr get_current_online_artwork();
+
+// Handle and byte accounting for imported bridge artwork
+struct artwork_bridge_stats {
+    long live_handles;      // Imported DIB sections currently alive
+    long long live_bytes;   // Pixel bytes held by those DIB sections
+    long total_imports;     // Copies made from foo_artwork bitmaps since startup
+    long total_received;    // Artwork results received via callback
+    long total_shares;      // Times a consumer acquired an already-imported image
+    long searches_issued;   // Searches actually sent to foo_artwork
+    long searches_deferred; // Requests held back by the rate limit (latest wins)
+    long searches_skipped;  // Requests dropped by the negative cache
+};
+void get_artwork_bridge_stats(artwork_bridge_stats& out);
 
 // Check if foo_artwork is currently searching/downloading artwork in the background
 bool is_online_artwork_loading();
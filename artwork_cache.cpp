@@ -0,0 +1,364 @@
+#include "stdafx.h"
+#include "artwork_cache.h"
+#include "animated_artwork.h"
+#include "control_panel.h"
+#include "startup.h"
+#include "perf_stats.h"
+#include "tracing.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+static const size_t SIGNATURE_LIMIT = 2048;        // Tracks remembered, in memory and on disk
+static const int THUMBNAIL_SIZE = 80;               // Cover area of the docked panel
+
+// Appends from decode workers and the index load never overlap
+static std::mutex g_index_mutex;
+
+static pfc::string8 get_index_path() {
+    pfc::string8 path = core_api::get_profile_path();
+    path.add_filename("foo_traycontrols_artwork.idx");
+    return path;
+}
+
+// Same file, same subsong, unchanged size and timestamp: same cover (FNV-1a)
+static t_uint64 make_signature_key(const metadb_handle_ptr& track) {
+    const playable_location& location = track->get_location();
+    t_filestats stats = track->get_filestats();
+    t_uint64 hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void* data, size_t size) {
+        const t_uint8* bytes = static_cast<const t_uint8*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    const char* path = location.get_path();
+    mix(path, strlen(path));
+    t_uint32 subsong = location.get_subsong();
+    mix(&subsong, sizeof(subsong));
+    mix(&stats.m_size, sizeof(stats.m_size));
+    mix(&stats.m_timestamp, sizeof(stats.m_timestamp));
+    return hash;
+}
+
+// Records in file order (later ones supersede earlier ones); caller holds g_index_mutex
+static void read_index(const char* path, std::vector<signature_record>& out, abort_callback& abort) {
+    if (!filesystem::g_exists(path, abort)) return;
+    file::ptr in;
+    filesystem::g_open_read(in, path, abort);
+    t_filesize size = in->get_size_ex(abort);
+    if (size < SIGNATURE_INDEX_HEADER_SIZE || size > SIGNATURE_INDEX_HEADER_SIZE + SIGNATURE_INDEX_RECORD_SIZE * SIGNATURE_LIMIT * 4) return;
+    pfc::array_t<t_uint8> data;
+    data.set_size((t_size)size);
+    in->read_object(data.get_ptr(), data.get_size(), abort);
+    parse_signature_index(data.get_ptr(), data.get_size(), out);
+}
+
+static void compact_index(const char* path, abort_callback& abort) {
+    std::vector<signature_record> records;
+    read_index(path, records, abort);
+    keep_newest_signatures(records, SIGNATURE_LIMIT);
+
+    std::vector<t_uint8> data;
+    serialize_signature_index(records, data);
+    file::ptr out;
+    filesystem::g_open_write_new(out, path, abort);
+    out->write(data.data(), data.size(), abort);
+}
+
+// Any thread. Not abortable, so a superseded decode never leaves a torn record behind.
+static void append_index_record(const signature_record& record) {
+    abort_callback& abort = fb2k::noAbort;
+    std::lock_guard<std::mutex> lock(g_index_mutex);
+    try {
+        pfc::string8 path = get_index_path();
+        file::ptr out;
+        if (filesystem::g_exists(path, abort)) {
+            filesystem::g_open(out, path, filesystem::open_mode_write_existing, abort);
+            out->seek(out->get_size_ex(abort), abort);
+        } else {
+            t_uint8 header[SIGNATURE_INDEX_HEADER_SIZE];
+            write_signature_index_header(header);
+            filesystem::g_open_write_new(out, path, abort);
+            out->write(header, sizeof(header), abort);
+        }
+        t_uint8 data[SIGNATURE_INDEX_RECORD_SIZE];
+        write_signature_record(data, record);
+        out->write(data, sizeof(data), abort);
+        bool oversized = out->get_size_ex(abort) > SIGNATURE_INDEX_HEADER_SIZE + SIGNATURE_INDEX_RECORD_SIZE * SIGNATURE_LIMIT * 2;
+        out.release();
+        if (oversized) compact_index(path, abort);
+    } catch (...) {}
+}
+
+static album_art_data_ptr extract_front_cover(const metadb_handle_ptr& track, abort_callback& abort) {
+    album_art_data_ptr data;
+    try {
+        auto api_v3 = album_art_manager_v3::get();
+        if (api_v3.is_valid()) {
+            auto extractor = api_v3->open(
+                pfc::list_single_ref_t<metadb_handle_ptr>(track),
+                pfc::list_single_ref_t<GUID>(album_art_ids::cover_front),
+                abort
+            );
+            if (extractor.is_valid()) {
+                extractor->query(album_art_ids::cover_front, data, abort);
+            }
+        }
+    } catch (exception_aborted const&) {
+        throw;
+    } catch (...) {}
+
+    if (!data.is_valid() || data->get_size() == 0) {
+        try {
+            auto api_v2 = album_art_manager_v2::get();
+            if (api_v2.is_valid()) {
+                auto extractor = api_v2->open(
+                    pfc::list_single_ref_t<metadb_handle_ptr>(track),
+                    pfc::list_single_ref_t<GUID>(album_art_ids::cover_front),
+                    abort
+                );
+                if (extractor.is_valid()) {
+                    data = extractor->query(album_art_ids::cover_front, abort);
+                }
+            }
+        } catch (exception_aborted const&) {
+            throw;
+        } catch (...) {}
+    }
+    return data;
+}
+
+// One image decode for all three products: native-resolution bitmap, 80x80 thumbnail and
+// signature, plus the frame timing of an animated cover. Worker side; GDI+ is already started
+// by request().
+static void decode_cover(album_art_data_ptr art_data, decoded_artwork& out) {
+    TRAY_PERF_COUNT(perf_counter_artwork_decodes);
+    try {
+        CComPtr<IStream> stream;
+        stream.p = SHCreateMemStream(reinterpret_cast<const BYTE*>(art_data->get_ptr()),
+                                     static_cast<UINT>(art_data->get_size()));
+        if (!stream) return;
+
+        std::vector<uint8_t> first_frame;   // Pixels behind a cover GDI+ cannot decode
+        std::unique_ptr<Gdiplus::Image> image(new Gdiplus::Image(stream));
+        if (image->GetLastStatus() != Gdiplus::Ok || image->GetWidth() == 0 || image->GetHeight() == 0) {
+            // No GDI+ codec (WebP): WIC's first frame
+            int frame_width = 0, frame_height = 0;
+            if (!decode_first_frame(art_data, first_frame, frame_width, frame_height)) return;
+            image.reset(new Gdiplus::Bitmap(frame_width, frame_height, frame_width * 4, PixelFormat32bppARGB, first_frame.data()));
+            if (image->GetLastStatus() != Gdiplus::Ok) return;
+        }
+        UINT img_width = image->GetWidth();
+        UINT img_height = image->GetHeight();
+        if (img_width == 0 || img_height == 0) return;
+
+        // Animated covers keep their encoded image; the control panel streams the frames from it
+        if (read_animation_delays(art_data, out.frame_delays)) out.animation = art_data;
+
+        // Native resolution with highest quality settings
+        Gdiplus::Bitmap original(img_width, img_height, PixelFormat32bppARGB);
+        if (original.GetLastStatus() != Gdiplus::Ok) return;
+        {
+            Gdiplus::Graphics graphics(&original);
+            graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
+            graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
+            graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
+            graphics.SetCompositingQuality(Gdiplus::CompositingQualityHighQuality);
+            graphics.DrawImage(image.get(), 0, 0, img_width, img_height);
+        }
+
+        // The signature samples the native pixels in place
+        Gdiplus::Rect all(0, 0, (INT)img_width, (INT)img_height);
+        Gdiplus::BitmapData locked;
+        if (original.LockBits(&all, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &locked) == Gdiplus::Ok) {
+            out.has_signature = encode_artwork_signature(static_cast<const uint8_t*>(locked.Scan0),
+                (int)locked.Width, (int)locked.Height, locked.Stride, (int)img_width, (int)img_height, out.signature);
+            original.UnlockBits(&locked);
+        }
+
+        if (original.GetHBITMAP(Gdiplus::Color(0, 0, 0, 0), &out.original) != Gdiplus::Ok) {
+            out.original = nullptr;
+        } else {
+            TRAY_PERF_COUNT(perf_counter_gdi_objects);
+        }
+        out.width = (int)img_width;
+        out.height = (int)img_height;
+
+        // Thumbnail scaled to fit, letterboxed on the panel's dark gray
+        Gdiplus::Bitmap thumbnail(THUMBNAIL_SIZE, THUMBNAIL_SIZE, PixelFormat32bppARGB);
+        if (thumbnail.GetLastStatus() != Gdiplus::Ok) return;
+        int draw_width = THUMBNAIL_SIZE;
+        int draw_height = THUMBNAIL_SIZE;
+        int offset_x = 0;
+        int offset_y = 0;
+        if (img_width > img_height) {
+            draw_height = (THUMBNAIL_SIZE * img_height) / img_width;
+            offset_y = (THUMBNAIL_SIZE - draw_height) / 2;
+        } else if (img_height > img_width) {
+            draw_width = (THUMBNAIL_SIZE * img_width) / img_height;
+            offset_x = (THUMBNAIL_SIZE - draw_width) / 2;
+        }
+        {
+            Gdiplus::Graphics graphics(&thumbnail);
+            graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
+            graphics.SetSmoothingMode(Gdiplus::SmoothingModeHighQuality);
+            graphics.Clear(Gdiplus::Color(255, 32, 32, 32));
+            graphics.DrawImage(image.get(), offset_x, offset_y, draw_width, draw_height);
+        }
+        if (thumbnail.GetHBITMAP(Gdiplus::Color(32, 32, 32), &out.thumbnail) != Gdiplus::Ok) {
+            out.thumbnail = nullptr;
+        } else {
+            TRAY_PERF_COUNT(perf_counter_gdi_objects);
+        }
+    } catch (...) {}
+}
+
+decoded_artwork::decoded_artwork()
+    : thumbnail(nullptr)
+    , original(nullptr)
+    , width(0)
+    , height(0)
+    , signature()
+    , has_signature(false) {
+}
+
+decoded_artwork::~decoded_artwork() {
+    if (thumbnail) DeleteObject(thumbnail);
+    if (original) DeleteObject(original);
+}
+
+artwork_cache* artwork_cache::s_instance = nullptr;
+
+artwork_cache& artwork_cache::get_instance() {
+    if (!s_instance) {
+        s_instance = new artwork_cache();
+    }
+    return *s_instance;
+}
+
+artwork_cache::artwork_cache()
+    : m_index_requested(false)
+    , m_generation(0) {
+}
+
+void artwork_cache::initialize() {
+    if (m_index_requested) return;
+    m_index_requested = true;
+
+    artwork_cache* self = this;
+    fb2k::splitTask([self] {
+        TRAY_TRACE_SCOPE("artwork", "load signature index");
+        auto records = std::make_shared<std::vector<signature_record>>();
+        try {
+            std::lock_guard<std::mutex> lock(g_index_mutex);
+            read_index(get_index_path(), *records, fb2k::noAbort);
+        } catch (...) {}
+        keep_newest_signatures(*records, SIGNATURE_LIMIT);
+        if (records->empty()) return;
+        fb2k::inMainThread([self, records] {
+            for (const signature_record& record : *records) {
+                // Anything recorded since startup is newer than the file
+                if (self->m_signatures.find(record.key) == self->m_signatures.end()) {
+                    self->store_signature(record.key, record.signature);
+                }
+            }
+        });
+    });
+}
+
+bool artwork_cache::find_signature(const metadb_handle_ptr& track, artwork_signature& out) const {
+    if (track.is_empty()) return false;
+    try {
+        auto it = m_signatures.find(make_signature_key(track));
+        if (it == m_signatures.end()) return false;
+        out = it->second;
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+void artwork_cache::store_signature(t_uint64 key, const artwork_signature& signature) {
+    auto it = m_signatures.find(key);
+    if (it != m_signatures.end()) {
+        it->second = signature;
+        return;
+    }
+    m_signatures.emplace(key, signature);
+    m_signature_order.push_back(key);
+    if (m_signature_order.size() > SIGNATURE_LIMIT) {
+        m_signatures.erase(m_signature_order.front());
+        m_signature_order.pop_front();
+    }
+}
+
+void artwork_cache::cancel() {
+    if (m_abort) m_abort->abort();
+    m_abort.reset();
+    m_pending.release();
+    m_generation++;
+}
+
+void artwork_cache::request(const metadb_handle_ptr& track) {
+    if (track.is_empty()) return;
+    if (track == m_pending) return;
+    cancel();
+
+    // GDI+ must be running before the worker touches it
+    if (!ensure_gdiplus()) {
+        on_decoded(track, 0, std::make_shared<decoded_artwork>());
+        return;
+    }
+
+    t_uint64 key = 0;
+    artwork_signature known;
+    bool has_known = false;
+    try {
+        key = make_signature_key(track);
+        auto it = m_signatures.find(key);
+        if (it != m_signatures.end()) {
+            known = it->second;
+            has_known = true;
+        }
+    } catch (...) {}
+
+    m_pending = track;
+    m_abort = std::make_shared<abort_callback_impl>();
+    unsigned generation = m_generation;
+    artwork_cache* self = this;
+    std::shared_ptr<abort_callback_impl> abort = m_abort;
+
+    fb2k::splitTask([self, generation, track, key, known, has_known, abort] {
+        TRAY_TRACE_SCOPE("artwork", "decode cover");
+        gdiplus_work_scope gdiplus_work;  // decode_cover's Image and Graphics
+        auto art = std::make_shared<decoded_artwork>();
+        try {
+            album_art_data_ptr data = extract_front_cover(track, *abort);
+            abort->check();
+            if (data.is_valid() && data->get_size() > 0) decode_cover(data, *art);
+            abort->check();
+        } catch (exception_aborted const&) {
+            return;
+        } catch (...) {}
+
+        // Only new or changed signatures reach the disk
+        if (art->has_signature && key != 0 && (!has_known || known != art->signature)) {
+            append_index_record({ key, art->signature });
+        }
+
+        // The instance lives until process exit, so only staleness needs checking
+        fb2k::inMainThread([self, generation, track, key, art] {
+            if (generation != self->m_generation) return;
+            self->m_pending.release();
+            self->m_abort.reset();
+            self->on_decoded(track, key, art);
+        });
+    });
+}
+
+void artwork_cache::on_decoded(const metadb_handle_ptr& track, t_uint64 key, const std::shared_ptr<decoded_artwork>& art) {
+    if (art->has_signature && key != 0) store_signature(key, art->signature);
+    control_panel::get_instance().on_artwork_decoded(track, *art);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "stdafx.h"
+#include "artwork_signature.h"
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Cover art decoded for one track on a worker. Owns its bitmaps until the control panel
+// takes them; whatever is left is deleted with it.
+struct decoded_artwork {
+    HBITMAP thumbnail;          // 80x80, letterboxed like the docked cover
+    HBITMAP original;           // Native resolution
+    int width;
+    int height;
+    artwork_signature signature;
+    bool has_signature;
+    album_art_data_ptr animation;       // Encoded image when it has more than one frame; the bitmaps are its first
+    std::vector<unsigned> frame_delays; // ms per frame of the animation
+
+    decoded_artwork();
+    ~decoded_artwork();
+    decoded_artwork(const decoded_artwork&) = delete;
+    decoded_artwork& operator=(const decoded_artwork&) = delete;
+};
+
+// Local/embedded front covers for the control panel. request() extracts and decodes the cover
+// on a worker and hands it to control_panel::on_artwork_decoded; a newer request aborts the
+// running one, so only the track that sticks pays for a decode. Every decode also records the
+// cover's colour signature, kept in memory and in <profile>\foo_traycontrols_artwork.idx, so
+// the next time the track comes up a preview can be drawn before the decode has even started.
+// Main thread only.
+class artwork_cache {
+public:
+    static artwork_cache& get_instance();
+
+    // Read the on-disk signature index on a worker (idle initialization)
+    void initialize();
+
+    // Signature recorded for the track's current file, if any
+    bool find_signature(const metadb_handle_ptr& track, artwork_signature& out) const;
+
+    void request(const metadb_handle_ptr& track);
+
+    // Abort the running decode (superseded track, shutdown)
+    void cancel();
+
+private:
+    artwork_cache();
+    static artwork_cache* s_instance;
+
+    std::unordered_map<t_uint64, artwork_signature> m_signatures;
+    std::deque<t_uint64> m_signature_order;     // Oldest first, for eviction
+    bool m_index_requested;
+
+    metadb_handle_ptr m_pending;                // Track of the running decode
+    std::shared_ptr<abort_callback_impl> m_abort;
+    unsigned m_generation;                      // Bumped per decode so stale completions are dropped
+
+    void store_signature(t_uint64 key, const artwork_signature& signature);
+    void on_decoded(const metadb_handle_ptr& track, t_uint64 key, const std::shared_ptr<decoded_artwork>& art);
+
+    artwork_cache(const artwork_cache&) = delete;
+    artwork_cache& operator=(const artwork_cache&) = delete;
+};
@@ -0,0 +1,135 @@
+// artwork_pipeline.cpp - Portable artwork processing stages (no precompiled header, no Windows dependency)
+
+#include "artwork_pipeline.h"
+#include "simd.h"
+#include <vector>
+#include <algorithm>
+
+void box_blur_bgra(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride,
+    int width, int height, int radius_x, int radius_y) {
+    if (!src || !dst || width <= 0 || height <= 0) return;
+    std::vector<uint8_t> temp((size_t)width * height * 4);
+
+    // Pass 1: Horizontal blur
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = src + (size_t)y * src_stride;
+        for (int x = 0; x < width; x++) {
+            int total_b = 0, total_g = 0, total_r = 0, total_a = 0;
+            int count = 0;
+            for (int dx = -radius_x; dx <= radius_x; dx++) {
+                int sx = x + dx;
+                if (sx >= 0 && sx < width) {
+                    const uint8_t* pixel = row + sx * 4;
+                    total_b += pixel[0];
+                    total_g += pixel[1];
+                    total_r += pixel[2];
+                    total_a += pixel[3];
+                    count++;
+                }
+            }
+            uint8_t* out = &temp[((size_t)y * width + x) * 4];
+            out[0] = static_cast<uint8_t>(total_b / count);
+            out[1] = static_cast<uint8_t>(total_g / count);
+            out[2] = static_cast<uint8_t>(total_r / count);
+            out[3] = static_cast<uint8_t>(total_a / count);
+        }
+    }
+
+    // Pass 2: Vertical blur
+    for (int y = 0; y < height; y++) {
+        uint8_t* out_row = dst + (size_t)y * dst_stride;
+        for (int x = 0; x < width; x++) {
+            int total_b = 0, total_g = 0, total_r = 0, total_a = 0;
+            int count = 0;
+            for (int dy = -radius_y; dy <= radius_y; dy++) {
+                int sy = y + dy;
+                if (sy >= 0 && sy < height) {
+                    const uint8_t* pixel = &temp[((size_t)sy * width + x) * 4];
+                    total_b += pixel[0];
+                    total_g += pixel[1];
+                    total_r += pixel[2];
+                    total_a += pixel[3];
+                    count++;
+                }
+            }
+            uint8_t* out = out_row + x * 4;
+            out[0] = static_cast<uint8_t>(total_b / count);
+            out[1] = static_cast<uint8_t>(total_g / count);
+            out[2] = static_cast<uint8_t>(total_r / count);
+            out[3] = static_cast<uint8_t>(total_a / count);
+        }
+    }
+}
+
+void resample_cover_bgra(const uint8_t* src, int src_width, int src_height, int src_stride,
+    uint8_t* dst, int dst_width, int dst_height, int dst_stride) {
+    if (!src || !dst || src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0) return;
+
+    float target_aspect = static_cast<float>(dst_width) / static_cast<float>(dst_height);
+    float source_aspect = static_cast<float>(src_width) / static_cast<float>(src_height);
+    float src_x = 0, src_y = 0, src_w = static_cast<float>(src_width), src_h = static_cast<float>(src_height);
+
+    if (target_aspect > source_aspect) {
+        src_h = src_w / target_aspect;
+        src_y = (src_height - src_h) / 2.0f;
+    } else {
+        src_w = src_h * target_aspect;
+        src_x = (src_width - src_w) / 2.0f;
+    }
+
+    for (int y = 0; y < dst_height; y++) {
+        uint8_t* out_row = dst + (size_t)y * dst_stride;
+        float sy = src_y + (y / static_cast<float>(dst_height)) * src_h;
+        int y0 = static_cast<int>(sy);
+        float fy = sy - y0;
+        int y1 = (std::min)(y0 + 1, src_height - 1);
+        y0 = (std::max)(0, (std::min)(y0, src_height - 1));
+        const uint8_t* row0 = src + (size_t)y0 * src_stride;
+        const uint8_t* row1 = src + (size_t)y1 * src_stride;
+
+        for (int x = 0; x < dst_width; x++) {
+            float sx = src_x + (x / static_cast<float>(dst_width)) * src_w;
+            int x0 = static_cast<int>(sx);
+            float fx = sx - x0;
+            int x1 = (std::min)(x0 + 1, src_width - 1);
+            x0 = (std::max)(0, (std::min)(x0, src_width - 1));
+
+            const uint8_t* p00 = row0 + x0 * 4;
+            const uint8_t* p10 = row0 + x1 * 4;
+            const uint8_t* p01 = row1 + x0 * 4;
+            const uint8_t* p11 = row1 + x1 * 4;
+            for (int c = 0; c < 4; c++) {
+                float top = p00[c] * (1.0f - fx) + p10[c] * fx;
+                float bottom = p01[c] * (1.0f - fx) + p11[c] * fx;
+                out_row[x * 4 + c] = static_cast<uint8_t>(top * (1.0f - fy) + bottom * fy);
+            }
+        }
+    }
+}
+
+void crossfade_bgra(const uint8_t* from, const uint8_t* to, uint8_t* dst, size_t pixel_count, unsigned weight) {
+    if (!from || !to || !dst) return;
+    if (weight > 256) weight = 256;
+    size_t bytes = pixel_count * 4;
+    size_t i = 0;
+#if TRAY_HAVE_SSE2
+    // Four pixels per step, widened to 16 bits: 255 * 256 still fits, so no saturation is needed
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i from_weight = _mm_set1_epi16((short)(256 - weight));
+    const __m128i to_weight = _mm_set1_epi16((short)weight);
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), from_weight),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), to_weight));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), from_weight),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), to_weight));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+            _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+#endif
+    unsigned keep = 256 - weight;
+    for (; i < bytes; i++) {
+        dst[i] = static_cast<uint8_t>((from[i] * keep + to[i] * weight) >> 8);
+    }
+}
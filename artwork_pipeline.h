@@ -0,0 +1,22 @@
+#pragma once
+
+// Portable artwork processing stages on 32bpp BGRA pixels (top-down rows, stride in bytes).
+// These are the CPU-bound steps behind the Blurred Artwork background and the track-change
+// crossfade, kept free of Windows/GDI+ so they can be timed and compared outside the player.
+
+#include <cstddef>
+#include <cstdint>
+
+// Separable box blur: horizontal pass of radius_x, then vertical pass of radius_y.
+// Edge pixels average only the samples that fall inside the image.
+void box_blur_bgra(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride,
+    int width, int height, int radius_x, int radius_y);
+
+// Bilinear resample of src into dst, center-cropping src to dst's aspect ratio
+void resample_cover_bgra(const uint8_t* src, int src_width, int src_height, int src_stride,
+    uint8_t* dst, int dst_width, int dst_height, int dst_stride);
+
+// Per-channel linear blend of two premultiplied BGRA buffers of pixel_count pixels:
+// dst = (from * (256 - weight) + to * weight) >> 8, weight 0-256. Premultiplied inputs give a
+// correctly premultiplied result, alpha included. dst may alias either input.
+void crossfade_bgra(const uint8_t* from, const uint8_t* to, uint8_t* dst, size_t pixel_count, unsigned weight);
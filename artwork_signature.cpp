@@ -0,0 +1,229 @@
+#include "artwork_signature.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+static const uint8_t SIGNATURE_FORMAT = (uint8_t)(artwork_signature::COMPONENTS_X | (artwork_signature::COMPONENTS_Y << 4));
+static const int COMPONENT_COUNT = artwork_signature::COMPONENTS_X * artwork_signature::COMPONENTS_Y;
+static const int MAX_SAMPLES = 32;     // Per axis
+static const double PI = 3.14159265358979323846;
+
+struct srgb_table {
+    float linear[256];
+    srgb_table() {
+        for (int i = 0; i < 256; i++) {
+            float v = i / 255.0f;
+            linear[i] = v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+};
+
+static float srgb_to_linear(uint8_t value) {
+    static const srgb_table table;  // Encoding runs on worker threads; the static init is safe
+    return table.linear[value];
+}
+
+static uint8_t linear_to_srgb(float value) {
+    if (value <= 0.0f) return 0;
+    if (value >= 1.0f) return 255;
+    float v = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    return (uint8_t)(v * 255.0f + 0.5f);
+}
+
+// Square-root companding spends the AC bytes on the small components that dominate artwork
+static float sign_pow(float value, float exponent) {
+    return value < 0.0f ? -powf(-value, exponent) : powf(value, exponent);
+}
+
+bool artwork_signature::is_valid() const {
+    return bytes[0] == SIGNATURE_FORMAT && source_width() > 0 && source_height() > 0;
+}
+
+int artwork_signature::source_width() const {
+    return bytes[1] | (bytes[2] << 8);
+}
+
+int artwork_signature::source_height() const {
+    return bytes[3] | (bytes[4] << 8);
+}
+
+bool artwork_signature::operator==(const artwork_signature& other) const {
+    return memcmp(bytes, other.bytes, SIZE) == 0;
+}
+
+bool encode_artwork_signature(const uint8_t* pixels, int width, int height, int stride,
+    int source_width, int source_height, artwork_signature& out) {
+    if (!pixels || width <= 0 || height <= 0 || source_width <= 0 || source_height <= 0) return false;
+
+    int samples_x = width < MAX_SAMPLES ? width : MAX_SAMPLES;
+    int samples_y = height < MAX_SAMPLES ? height : MAX_SAMPLES;
+
+    float basis_x[artwork_signature::COMPONENTS_X][MAX_SAMPLES];
+    float basis_y[artwork_signature::COMPONENTS_Y][MAX_SAMPLES];
+    for (int c = 0; c < artwork_signature::COMPONENTS_X; c++) {
+        for (int i = 0; i < samples_x; i++) basis_x[c][i] = (float)cos(PI * c * (i + 0.5) / samples_x);
+    }
+    for (int c = 0; c < artwork_signature::COMPONENTS_Y; c++) {
+        for (int j = 0; j < samples_y; j++) basis_y[c][j] = (float)cos(PI * c * (j + 0.5) / samples_y);
+    }
+
+    float sums[COMPONENT_COUNT][3] = {};
+    for (int j = 0; j < samples_y; j++) {
+        const uint8_t* row = pixels + (ptrdiff_t)((j * 2 + 1) * height / (samples_y * 2)) * stride;
+        for (int i = 0; i < samples_x; i++) {
+            const uint8_t* p = row + (ptrdiff_t)((i * 2 + 1) * width / (samples_x * 2)) * 4;
+            float b = srgb_to_linear(p[0]);
+            float g = srgb_to_linear(p[1]);
+            float r = srgb_to_linear(p[2]);
+            for (int cy = 0; cy < artwork_signature::COMPONENTS_Y; cy++) {
+                for (int cx = 0; cx < artwork_signature::COMPONENTS_X; cx++) {
+                    float w = basis_x[cx][i] * basis_y[cy][j];
+                    float* sum = sums[cy * artwork_signature::COMPONENTS_X + cx];
+                    sum[0] += r * w;
+                    sum[1] += g * w;
+                    sum[2] += b * w;
+                }
+            }
+        }
+    }
+
+    float count = (float)(samples_x * samples_y);
+    float max_ac = 0.0f;
+    for (int c = 0; c < COMPONENT_COUNT; c++) {
+        float scale = (c == 0 ? 1.0f : 2.0f) / count;
+        for (int k = 0; k < 3; k++) {
+            sums[c][k] *= scale;
+            if (c > 0 && fabsf(sums[c][k]) > max_ac) max_ac = fabsf(sums[c][k]);
+        }
+    }
+
+    // AC range in 1/256 steps; components are at most 1 in magnitude
+    int range_q = (int)ceilf(max_ac * 256.0f) - 1;
+    if (range_q < 0) range_q = 0;
+    if (range_q > 255) range_q = 255;
+    float range = (range_q + 1) / 256.0f;
+
+    if (source_width > 0xFFFF) source_width = 0xFFFF;
+    if (source_height > 0xFFFF) source_height = 0xFFFF;
+    uint8_t* o = out.bytes;
+    o[0] = SIGNATURE_FORMAT;
+    o[1] = (uint8_t)(source_width & 0xFF);
+    o[2] = (uint8_t)(source_width >> 8);
+    o[3] = (uint8_t)(source_height & 0xFF);
+    o[4] = (uint8_t)(source_height >> 8);
+    o[5] = (uint8_t)range_q;
+    for (int k = 0; k < 3; k++) o[6 + k] = linear_to_srgb(sums[0][k]);
+    for (int c = 1; c < COMPONENT_COUNT; c++) {
+        for (int k = 0; k < 3; k++) {
+            float v = sign_pow(sums[c][k] / range, 0.5f) * 127.5f + 127.5f;
+            o[9 + (c - 1) * 3 + k] = (uint8_t)(v < 0.0f ? 0 : (v > 255.0f ? 255 : (int)(v + 0.5f)));
+        }
+    }
+    return true;
+}
+
+bool decode_artwork_signature(const artwork_signature& signature, uint8_t* pixels, int width, int height, int stride) {
+    if (!pixels || width <= 0 || height <= 0 || !signature.is_valid()) return false;
+
+    const uint8_t* s = signature.bytes;
+    float range = (s[5] + 1) / 256.0f;
+    float components[COMPONENT_COUNT][3];
+    for (int k = 0; k < 3; k++) components[0][k] = srgb_to_linear(s[6 + k]);
+    for (int c = 1; c < COMPONENT_COUNT; c++) {
+        for (int k = 0; k < 3; k++) {
+            float v = (s[9 + (c - 1) * 3 + k] - 127.5f) / 127.5f;
+            components[c][k] = sign_pow(v, 2.0f) * range;
+        }
+    }
+
+    std::vector<float> basis_x((size_t)width * artwork_signature::COMPONENTS_X);
+    std::vector<float> basis_y((size_t)height * artwork_signature::COMPONENTS_Y);
+    for (int i = 0; i < width; i++) {
+        for (int c = 0; c < artwork_signature::COMPONENTS_X; c++) {
+            basis_x[(size_t)i * artwork_signature::COMPONENTS_X + c] = (float)cos(PI * c * (i + 0.5) / width);
+        }
+    }
+    for (int j = 0; j < height; j++) {
+        for (int c = 0; c < artwork_signature::COMPONENTS_Y; c++) {
+            basis_y[(size_t)j * artwork_signature::COMPONENTS_Y + c] = (float)cos(PI * c * (j + 0.5) / height);
+        }
+    }
+
+    for (int j = 0; j < height; j++) {
+        // Collapse the vertical basis first: one row needs only COMPONENTS_X colours
+        float row_colors[artwork_signature::COMPONENTS_X][3] = {};
+        for (int cy = 0; cy < artwork_signature::COMPONENTS_Y; cy++) {
+            float wy = basis_y[(size_t)j * artwork_signature::COMPONENTS_Y + cy];
+            for (int cx = 0; cx < artwork_signature::COMPONENTS_X; cx++) {
+                const float* c = components[cy * artwork_signature::COMPONENTS_X + cx];
+                for (int k = 0; k < 3; k++) row_colors[cx][k] += c[k] * wy;
+            }
+        }
+        uint8_t* p = pixels + (ptrdiff_t)j * stride;
+        for (int i = 0; i < width; i++, p += 4) {
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            for (int cx = 0; cx < artwork_signature::COMPONENTS_X; cx++) {
+                float wx = basis_x[(size_t)i * artwork_signature::COMPONENTS_X + cx];
+                r += row_colors[cx][0] * wx;
+                g += row_colors[cx][1] * wx;
+                b += row_colors[cx][2] * wx;
+            }
+            p[0] = linear_to_srgb(b);
+            p[1] = linear_to_srgb(g);
+            p[2] = linear_to_srgb(r);
+            p[3] = 255;
+        }
+    }
+    return true;
+}
+
+static const uint8_t INDEX_MAGIC[4] = { 'T', 'C', 'A', 'S' };
+static const uint32_t INDEX_VERSION = 1;
+
+void write_signature_index_header(uint8_t* out) {
+    memcpy(out, INDEX_MAGIC, 4);
+    for (int i = 0; i < 4; i++) out[4 + i] = (uint8_t)(INDEX_VERSION >> (i * 8));
+}
+
+void write_signature_record(uint8_t* out, const signature_record& record) {
+    for (int i = 0; i < 8; i++) out[i] = (uint8_t)(record.key >> (i * 8));
+    memcpy(out + 8, record.signature.bytes, artwork_signature::SIZE);
+}
+
+bool parse_signature_index(const uint8_t* data, size_t size, std::vector<signature_record>& out) {
+    if (!data || size < SIGNATURE_INDEX_HEADER_SIZE) return false;
+    uint32_t version = data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t)data[7] << 24);
+    if (memcmp(data, INDEX_MAGIC, 4) != 0 || version != INDEX_VERSION) return false;
+
+    size_t count = (size - SIGNATURE_INDEX_HEADER_SIZE) / SIGNATURE_INDEX_RECORD_SIZE;
+    out.reserve(out.size() + count);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* r = data + SIGNATURE_INDEX_HEADER_SIZE + i * SIGNATURE_INDEX_RECORD_SIZE;
+        signature_record record;
+        record.key = 0;
+        for (int b = 0; b < 8; b++) record.key |= (uint64_t)r[b] << (b * 8);
+        memcpy(record.signature.bytes, r + 8, artwork_signature::SIZE);
+        if (record.signature.is_valid()) out.push_back(record);
+    }
+    return true;
+}
+
+void serialize_signature_index(const std::vector<signature_record>& records, std::vector<uint8_t>& out) {
+    out.assign(SIGNATURE_INDEX_HEADER_SIZE + records.size() * SIGNATURE_INDEX_RECORD_SIZE, 0);
+    write_signature_index_header(out.data());
+    for (size_t i = 0; i < records.size(); i++) {
+        write_signature_record(out.data() + SIGNATURE_INDEX_HEADER_SIZE + i * SIGNATURE_INDEX_RECORD_SIZE, records[i]);
+    }
+}
+
+void keep_newest_signatures(std::vector<signature_record>& records, size_t limit) {
+    std::vector<signature_record> kept;
+    std::unordered_set<uint64_t> seen;
+    for (size_t i = records.size(); i-- > 0 && kept.size() < limit;) {
+        if (seen.insert(records[i].key).second) kept.push_back(records[i]);
+    }
+    std::reverse(kept.begin(), kept.end());
+    records.swap(kept);
+}
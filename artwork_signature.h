@@ -0,0 +1,57 @@
+#pragma once
+
+// Portable colour signature of a cover image, in the spirit of BlurHash: the DC colour and the
+// lowest 4x3 cosine components of the image in linear light, quantized to 42 bytes together
+// with the source size. Decoding renders a soft, correctly proportioned preview that stands in
+// for the artwork until the real image is decoded. Free of Windows and SDK types.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct artwork_signature {
+    static const int COMPONENTS_X = 4;
+    static const int COMPONENTS_Y = 3;
+    static const size_t SIZE = 9 + (COMPONENTS_X * COMPONENTS_Y - 1) * 3;
+
+    // [0] format, [1..4] source width/height (LE), [5] AC range, [6..8] DC sRGB, then AC RGB
+    uint8_t bytes[SIZE];
+
+    bool is_valid() const;
+    int source_width() const;
+    int source_height() const;
+    bool operator==(const artwork_signature& other) const;
+    bool operator!=(const artwork_signature& other) const { return !(*this == other); }
+};
+
+// Signature of a 32bpp BGRA image (top-down rows, stride in bytes); at most 32x32 pixels are
+// sampled, so the cost does not grow with the image. source_width/height are recorded for the
+// preview's aspect ratio (the pixels may be a scaled copy).
+bool encode_artwork_signature(const uint8_t* pixels, int width, int height, int stride,
+    int source_width, int source_height, artwork_signature& out);
+
+// Render the preview into an opaque 32bpp BGRA buffer of any size
+bool decode_artwork_signature(const artwork_signature& signature, uint8_t* pixels, int width, int height, int stride);
+
+// Signatures persist in an index file: an 8-byte header (magic, version) followed by
+// fixed-size records, appended as covers are decoded, so later records supersede earlier ones
+struct signature_record {
+    uint64_t key;   // Identifies the track (see artwork_cache)
+    artwork_signature signature;
+};
+
+static const size_t SIGNATURE_INDEX_HEADER_SIZE = 8;
+static const size_t SIGNATURE_INDEX_RECORD_SIZE = 8 + artwork_signature::SIZE;
+
+void write_signature_index_header(uint8_t* out);
+void write_signature_record(uint8_t* out, const signature_record& record);
+
+// Records of a whole index file in file order. False if it is not an index of this version;
+// a torn last record (crash mid-append) and invalid signatures are skipped.
+bool parse_signature_index(const uint8_t* data, size_t size, std::vector<signature_record>& out);
+
+// Header plus records, the compacted file
+void serialize_signature_index(const std::vector<signature_record>& records, std::vector<uint8_t>& out);
+
+// The newest record per key, at most limit of them, oldest first
+void keep_newest_signatures(std::vector<signature_record>& records, size_t limit);
@@ -0,0 +1,203 @@
+// Times the artwork stages a cover goes through, per image of a corpus:
+//   decode      JPEG/PNG to 32bpp BGRA (libjpeg/libpng here; GDI+ or WIC in the player)
+//   signature   encode_artwork_signature on the full image (artwork_cache decode worker)
+//   downscale   resample_cover_bgra to 64x64, the Blurred Artwork source
+//   blur        box_blur_bgra of the 64x64 copy, radius 4 x 8
+//   background  resample_cover_bgra of the blur to a 480x320 panel
+//   crossfade   one crossfade_bgra frame of two 480x480 covers
+//
+//   artwork_pipeline_bench [--iterations N] [--json out.json] [--thresholds limits.txt] corpus_dir
+//
+// The corpus under bench/corpus is synthetic (gradients, discs, grain) so it can be checked in:
+// a baseline and a progressive JPEG, an RGBA and an RGB PNG.
+
+#include "bench_report.h"
+#include "../artwork_pipeline.h"
+#include "../artwork_signature.h"
+#include "../simd.h"
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include <jpeglib.h>
+#include <png.h>
+
+struct bgra_image {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+struct jpeg_error_handler {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+};
+
+static void on_jpeg_error(j_common_ptr info) {
+    longjmp(reinterpret_cast<jpeg_error_handler*>(info->err)->jump, 1);
+}
+
+static bool decode_jpeg(const std::vector<uint8_t>& data, bgra_image& out) {
+    jpeg_decompress_struct info;
+    jpeg_error_handler error;
+    info.err = jpeg_std_error(&error.base);
+    error.base.error_exit = on_jpeg_error;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, data.data(), (unsigned long)data.size());
+    jpeg_read_header(&info, TRUE);
+    info.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&info);
+
+    out.width = (int)info.output_width;
+    out.height = (int)info.output_height;
+    out.pixels.resize((size_t)out.width * out.height * 4);
+    std::vector<uint8_t> row((size_t)out.width * 3);
+    while (info.output_scanline < info.output_height) {
+        uint8_t* dst = &out.pixels[(size_t)info.output_scanline * out.width * 4];
+        JSAMPROW rows[1] = { row.data() };
+        jpeg_read_scanlines(&info, rows, 1);
+        for (int x = 0; x < out.width; x++) {
+            dst[x * 4] = row[x * 3 + 2];
+            dst[x * 4 + 1] = row[x * 3 + 1];
+            dst[x * 4 + 2] = row[x * 3];
+            dst[x * 4 + 3] = 255;
+        }
+    }
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    return true;
+}
+
+static bool decode_png(const std::vector<uint8_t>& data, bgra_image& out) {
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&image, data.data(), data.size())) return false;
+    image.format = PNG_FORMAT_BGRA;
+    out.width = (int)image.width;
+    out.height = (int)image.height;
+    out.pixels.resize(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, nullptr, out.pixels.data(), 0, nullptr)) {
+        png_image_free(&image);
+        return false;
+    }
+    return true;
+}
+
+static bool decode_image(const std::string& name, const std::vector<uint8_t>& data, bgra_image& out) {
+    std::string extension = std::filesystem::path(name).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == ".jpg" || extension == ".jpeg") return decode_jpeg(data, out);
+    if (extension == ".png") return decode_png(data, out);
+    return false;
+}
+
+static bool read_file(const std::filesystem::path& path, std::vector<uint8_t>& out) {
+    FILE* in = fopen(path.string().c_str(), "rb");
+    if (!in) return false;
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    out.resize(size > 0 ? (size_t)size : 0);
+    bool read = fread(out.data(), 1, out.size(), in) == out.size();
+    fclose(in);
+    return read && !out.empty();
+}
+
+int main(int argc, char** argv) {
+    bench_options options;
+    if (!parse_bench_options(argc, argv, 20, options) || options.inputs.size() != 1) {
+        fprintf(stderr, "usage: %s [--iterations N] [--json out.json] [--thresholds limits.txt] corpus_dir\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(options.inputs[0], error)) {
+        if (entry.is_regular_file()) files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    bench_report report("artwork_pipeline");
+    report.add_info("simd", TRAY_HAVE_SSE2 ? "true" : "false");
+    report.add_info("iterations", std::to_string(options.iterations));
+
+    const int BLUR_SIZE = 64;
+    const int PANEL_WIDTH = 480, PANEL_HEIGHT = 320;
+    const int FADE_SIZE = 480;
+    std::vector<uint8_t> small((size_t)BLUR_SIZE * BLUR_SIZE * 4);
+    std::vector<uint8_t> blurred(small.size());
+    std::vector<uint8_t> panel((size_t)PANEL_WIDTH * PANEL_HEIGHT * 4);
+    std::vector<uint8_t> fade_from((size_t)FADE_SIZE * FADE_SIZE * 4);
+    std::vector<uint8_t> fade_to(fade_from.size());
+    std::vector<uint8_t> fade_frame(fade_from.size());
+
+    int decoded = 0;
+    for (const std::filesystem::path& path : files) {
+        std::string name = path.filename().string();
+        std::vector<uint8_t> data;
+        bgra_image image;
+        if (!read_file(path, data) || !decode_image(name, data, image)) {
+            fprintf(stderr, "skipping %s\n", name.c_str());
+            continue;
+        }
+        decoded++;
+
+        report.time_stage(name, "decode", options.iterations, [&] {
+            bgra_image again;
+            decode_image(name, data, again);
+            bench_consume(again.pixels.data(), again.pixels.size());
+        });
+
+        int stride = image.width * 4;
+        report.time_stage(name, "signature", options.iterations, [&] {
+            artwork_signature signature;
+            encode_artwork_signature(image.pixels.data(), image.width, image.height, stride, image.width, image.height, signature);
+            bench_consume(signature.bytes, sizeof(signature.bytes));
+        });
+
+        report.time_stage(name, "downscale", options.iterations, [&] {
+            resample_cover_bgra(image.pixels.data(), image.width, image.height, stride,
+                small.data(), BLUR_SIZE, BLUR_SIZE, BLUR_SIZE * 4);
+            bench_consume(small.data(), small.size());
+        });
+
+        report.time_stage(name, "blur", options.iterations, [&] {
+            box_blur_bgra(small.data(), BLUR_SIZE * 4, blurred.data(), BLUR_SIZE * 4, BLUR_SIZE, BLUR_SIZE, 4, 8);
+            bench_consume(blurred.data(), blurred.size());
+        });
+
+        report.time_stage(name, "background", options.iterations, [&] {
+            resample_cover_bgra(blurred.data(), BLUR_SIZE, BLUR_SIZE, BLUR_SIZE * 4,
+                panel.data(), PANEL_WIDTH, PANEL_HEIGHT, PANEL_WIDTH * 4);
+            bench_consume(panel.data(), panel.size());
+        });
+
+        // The cover at panel size fades in over the previous one
+        resample_cover_bgra(image.pixels.data(), image.width, image.height, stride,
+            fade_to.data(), FADE_SIZE, FADE_SIZE, FADE_SIZE * 4);
+        unsigned weight = 0;
+        report.time_stage(name, "crossfade", options.iterations, [&] {
+            weight = (weight + 37) % 257;
+            crossfade_bgra(fade_from.data(), fade_to.data(), fade_frame.data(), (size_t)FADE_SIZE * FADE_SIZE, weight);
+            bench_consume(fade_frame.data(), fade_frame.size());
+        });
+        fade_from.swap(fade_to);
+    }
+
+    if (decoded == 0) {
+        fprintf(stderr, "no images decoded from %s\n", options.inputs[0].c_str());
+        return 2;
+    }
+    report.add_info("images", std::to_string(decoded));
+
+    bool passed = report.check_thresholds(options.thresholds_path);
+    if (!report.write(options.json_path)) return 2;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+#include "bench_report.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+bool parse_bench_options(int argc, char** argv, int default_iterations, bench_options& out) {
+    out.iterations = default_iterations;
+    out.json_path.clear();
+    out.thresholds_path.clear();
+    out.inputs.clear();
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--iterations") == 0 && has_value) {
+            out.iterations = atoi(argv[++i]);
+        } else if (strcmp(arg, "--json") == 0 && has_value) {
+            out.json_path = argv[++i];
+        } else if (strcmp(arg, "--thresholds") == 0 && has_value) {
+            out.thresholds_path = argv[++i];
+        } else if (strncmp(arg, "--", 2) == 0) {
+            fprintf(stderr, "usage: %s [--iterations N] [--json out.json] [--thresholds limits.txt] [inputs...]\n", argv[0]);
+            return false;
+        } else {
+            out.inputs.push_back(arg);
+        }
+    }
+    if (out.iterations < 1) out.iterations = 1;
+    return true;
+}
+
+bench_report::bench_report(const char* benchmark)
+    : m_benchmark(benchmark)
+    , m_passed(true) {
+}
+
+void bench_report::add_samples(const std::string& case_name, const std::string& stage, std::vector<double> samples_ms) {
+    if (samples_ms.empty()) return;
+    std::sort(samples_ms.begin(), samples_ms.end());
+    size_t n = samples_ms.size();
+    double median = n % 2 ? samples_ms[n / 2] : (samples_ms[n / 2 - 1] + samples_ms[n / 2]) / 2;
+    m_results.push_back({ case_name, stage, samples_ms.front(), median, samples_ms.back(), -1.0 });
+}
+
+void bench_report::set_allocations(const std::string& case_name, const std::string& stage, double per_iteration) {
+    for (result& r : m_results) {
+        if (r.case_name == case_name && r.stage == stage) r.allocations = per_iteration;
+    }
+}
+
+void bench_report::add_info(const std::string& key, const std::string& json_value) {
+    m_info.emplace_back(key, json_value);
+}
+
+bool bench_report::check_thresholds(const std::string& path) {
+    if (path.empty()) return true;
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "cannot read thresholds from %s\n", path.c_str());
+        m_passed = false;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        limit l;
+        if (!(fields >> l.stage >> l.limit_ms)) continue;
+        l.worst_median_ms = 0;
+        bool found = false;
+        for (const result& r : m_results) {
+            if (r.stage != l.stage) continue;
+            found = true;
+            l.worst_median_ms = std::max(l.worst_median_ms, r.median_ms);
+        }
+        // A limit on a stage that never ran is a stale file, not a pass
+        l.passed = found && l.worst_median_ms <= l.limit_ms;
+        if (!found) {
+            fprintf(stderr, "threshold for unknown stage %s\n", l.stage.c_str());
+        } else if (!l.passed) {
+            fprintf(stderr, "%s: median %.3f ms is over the %.3f ms limit\n", l.stage.c_str(), l.worst_median_ms, l.limit_ms);
+        }
+        m_passed = m_passed && l.passed;
+        m_limits.push_back(l);
+    }
+    return m_passed;
+}
+
+static std::string json_string(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) continue;
+        out += c;
+    }
+    return out + "\"";
+}
+
+std::string bench_report::to_json() const {
+    char number[64];
+    std::string out = "{\n  \"benchmark\": " + json_string(m_benchmark);
+    for (const auto& info : m_info) out += ",\n  " + json_string(info.first) + ": " + info.second;
+
+    out += ",\n  \"results\": [";
+    for (size_t i = 0; i < m_results.size(); i++) {
+        const result& r = m_results[i];
+        out += i ? ",\n    " : "\n    ";
+        out += "{\"case\": " + json_string(r.case_name) + ", \"stage\": " + json_string(r.stage);
+        snprintf(number, sizeof(number), ", \"min_ms\": %.4f", r.min_ms);
+        out += number;
+        snprintf(number, sizeof(number), ", \"median_ms\": %.4f", r.median_ms);
+        out += number;
+        snprintf(number, sizeof(number), ", \"max_ms\": %.4f", r.max_ms);
+        out += number;
+        if (r.allocations >= 0) {
+            snprintf(number, sizeof(number), ", \"allocations\": %.1f", r.allocations);
+            out += number;
+        }
+        out += "}";
+    }
+    out += "\n  ],\n  \"thresholds\": [";
+    for (size_t i = 0; i < m_limits.size(); i++) {
+        const limit& l = m_limits[i];
+        out += i ? ",\n    " : "\n    ";
+        out += "{\"stage\": " + json_string(l.stage);
+        snprintf(number, sizeof(number), ", \"limit_ms\": %.4f", l.limit_ms);
+        out += number;
+        snprintf(number, sizeof(number), ", \"worst_median_ms\": %.4f", l.worst_median_ms);
+        out += number;
+        out += l.passed ? ", \"passed\": true}" : ", \"passed\": false}";
+    }
+    out += "\n  ],\n  \"passed\": ";
+    out += m_passed ? "true" : "false";
+    out += "\n}\n";
+    return out;
+}
+
+bool bench_report::write(const std::string& json_path) const {
+    bool allocations = false;
+    for (const result& r : m_results) allocations = allocations || r.allocations >= 0;
+    printf("%-40s %-14s %10s %10s %10s", "case", "stage", "min ms", "median ms", "max ms");
+    if (allocations) printf(" %10s", "allocs");
+    printf("\n");
+    for (const result& r : m_results) {
+        printf("%-40s %-14s %10.3f %10.3f %10.3f", r.case_name.c_str(), r.stage.c_str(), r.min_ms, r.median_ms, r.max_ms);
+        if (r.allocations >= 0) printf(" %10.1f", r.allocations);
+        printf("\n");
+    }
+    if (json_path.empty()) return true;
+
+    FILE* out = fopen(json_path.c_str(), "wb");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", json_path.c_str());
+        return false;
+    }
+    std::string json = to_json();
+    bool written = fwrite(json.data(), 1, json.size(), out) == json.size();
+    return fclose(out) == 0 && written;
+}
+
+static volatile unsigned char g_sink;
+
+void bench_consume(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    unsigned char sum = 0;
+    for (size_t i = 0; i < size; i += 64) sum ^= bytes[i];
+    g_sink = sum;
+}
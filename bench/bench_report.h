@@ -0,0 +1,83 @@
+#pragma once
+
+// Shared plumbing of the benchmarks: command line, per-stage timing, JSON output and limits.
+//
+//   <bench> [--iterations N] [--json out.json] [--thresholds limits.txt] [inputs...]
+//
+// Each stage is timed iterations times per case and reported as min/median/max in ms. A
+// thresholds file lists "<stage> <ms>" per line ('#' starts a comment); the run fails when the
+// slowest case's median of a listed stage goes over its limit.
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct bench_options {
+    int iterations;
+    std::string json_path;
+    std::string thresholds_path;
+    std::vector<std::string> inputs;
+};
+
+// False (after printing usage) on a malformed command line
+bool parse_bench_options(int argc, char** argv, int default_iterations, bench_options& out);
+
+class bench_report {
+public:
+    explicit bench_report(const char* benchmark);
+
+    // Time body() iterations times; the result is kept under case_name/stage
+    template<typename body_t>
+    void time_stage(const std::string& case_name, const std::string& stage, int iterations, body_t body) {
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        for (int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        add_samples(case_name, stage, samples);
+    }
+
+    void add_samples(const std::string& case_name, const std::string& stage, std::vector<double> samples_ms);
+
+    // Heap allocations per iteration of a stage already added; reported only where set
+    void set_allocations(const std::string& case_name, const std::string& stage, double per_iteration);
+
+    // Extra top-level facts for the JSON ("simd": true, corpus size...)
+    void add_info(const std::string& key, const std::string& json_value);
+
+    // Compare against the limits file; prints every stage over its limit. A missing path passes.
+    bool check_thresholds(const std::string& path);
+
+    // Human-readable table on stdout, and the JSON file if a path was given
+    bool write(const std::string& json_path) const;
+
+private:
+    struct result {
+        std::string case_name;
+        std::string stage;
+        double min_ms;
+        double median_ms;
+        double max_ms;
+        double allocations;     // Per iteration, or negative when not measured
+    };
+    struct limit {
+        std::string stage;
+        double limit_ms;
+        double worst_median_ms;
+        bool passed;
+    };
+
+    std::string m_benchmark;
+    std::vector<std::pair<std::string, std::string>> m_info;
+    std::vector<result> m_results;
+    std::vector<limit> m_limits;
+    bool m_passed;
+
+    std::string to_json() const;
+};
+
+// Keeps the optimizer from dropping a computation whose result is otherwise unused
+void bench_consume(const void* data, size_t size);
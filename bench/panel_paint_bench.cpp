@@ -0,0 +1,101 @@
+// Control panel modes and the track popup painted on the software canvas, every mode at two
+// window sizes and 96, 144 and 192 DPI, each with the solid or the blurred artwork background
+// and with square or rounded corners. Stages:
+//   <mode>              one whole frame of that mode (docked, undocked, compact,
+//                       compact_controls, expanded, expanded_overlay, popup), including the
+//                       rounded-corner alpha pass when rounded
+//   blurred_background  building the blurred background for the window size (cached by the
+//                       window until the artwork or size changes)
+// Heap allocations per frame are reported next to the times. With an output directory, each
+// frame is written there as <mode>_<w>x<h>_<dpi>dpi_<solid|blurred>_<square|rounded>.png.
+//
+//   panel_paint_bench [--iterations N] [--json out.json] [--thresholds limits.txt] [output_dir]
+
+#include "bench_report.h"
+#include "canvas_png.h"
+#include "panel_scenes.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+int main(int argc, char** argv) {
+    bench_options options;
+    if (!parse_bench_options(argc, argv, 10, options) || options.inputs.size() > 1) return 2;
+    const std::string output_dir = options.inputs.empty() ? std::string() : options.inputs[0];
+
+    bench_report report("panel_paint");
+    report.add_info("iterations", std::to_string(options.iterations));
+
+    const float scales[] = { 1.0f, 1.5f, 2.0f };
+    bool written = true;
+    panel_scene scene;
+    for (int m = 0; m < panel_scene_mode_count; m++) {
+        panel_scene_mode mode = (panel_scene_mode)m;
+        const char* stage = panel_scene_mode_name(mode);
+        for (int large = 0; large < 2; large++) {
+            for (float scale : scales) {
+                for (int blurred = 0; blurred < 2; blurred++) {
+                    for (int rounded = 0; rounded < 2; rounded++) {
+                        panel_scene_options o = panel_scene_defaults(mode, scale);
+                        panel_scene_base_size(mode, large != 0, o.width, o.height);
+                        o.width = (int)(o.width * scale);
+                        o.height = (int)(o.height * scale);
+                        o.background_style = blurred ? 2 : 0;
+                        o.rounded = rounded != 0;
+
+                        char case_name[96];
+                        snprintf(case_name, sizeof(case_name), "%dx%d %ddpi %s %s", o.width, o.height, (int)(scale * 96),
+                            blurred ? "blurred" : "solid", rounded ? "rounded" : "square");
+
+                        if (blurred) {
+                            report.time_stage(case_name, "blurred_background", options.iterations, [&] { scene.setup(o); });
+                        } else {
+                            scene.setup(o);
+                        }
+
+                        software_canvas c(o.width, o.height);
+                        size_t allocations_before = g_allocations;
+                        report.time_stage(case_name, stage, options.iterations, [&] {
+                            c.clear(canvas_color::argb(0, 0, 0, 0));
+                            scene.paint(c);
+                            if (o.rounded) apply_rounded_corner_alpha(c.bits(), o.width, o.height, 8.0f);
+                        });
+                        report.set_allocations(case_name, stage, (double)(g_allocations - allocations_before) / options.iterations);
+                        bench_consume(c.bits(), (size_t)c.stride() * o.height);
+
+                        if (!output_dir.empty()) {
+                            char file[128];
+                            snprintf(file, sizeof(file), "/%s_%dx%d_%ddpi_%s_%s.png", stage, o.width, o.height, (int)(scale * 96),
+                                blurred ? "blurred" : "solid", rounded ? "rounded" : "square");
+                            if (!write_canvas_png(output_dir + file, c)) {
+                                fprintf(stderr, "cannot write %s%s\n", output_dir.c_str(), file);
+                                written = false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    bool passed = report.check_thresholds(options.thresholds_path);
+    if (!report.write(options.json_path) || !written) return 2;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// The portable software canvas drawing the frames the popups draw, at 96 and 144 DPI. Stages:
+//   fill        clear plus the rectangles, rounded rectangles and ellipses of a popup background
+//   polygon     star polygon, anti-aliased lines and an arc
+//   osd         a full volume feedback OSD frame (paint_volume_osd)
+//   corners     rounded-corner alpha over a finished layered window frame
+//
+//   software_canvas_bench [--iterations N] [--json out.json] [--thresholds limits.txt]
+
+#include "bench_report.h"
+#include "../software_canvas.h"
+#include "../volume_osd_paint.h"
+#include <string>
+
+static volume_osd_style make_osd_style(float scale, float volume) {
+    // volume_popup's feedback OSD
+    volume_osd_style style = {};
+    style.width = (int)(202 * scale + 0.5f);
+    style.height = (int)(36 * scale + 0.5f);
+    style.dpi_scale = scale;
+    style.dark = true;
+    style.rounded_corners = true;
+    style.volume = volume;
+    style.accent = canvas_color::rgb(0x3A, 0x8E, 0xE6);
+    style.icon_x = 14;
+    style.icon_size = 20;
+    style.track_x = 44;
+    style.text_width = 46;
+    return style;
+}
+
+int main(int argc, char** argv) {
+    bench_options options;
+    if (!parse_bench_options(argc, argv, 500, options) || !options.inputs.empty()) return 2;
+
+    bench_report report("software_canvas");
+    report.add_info("iterations", std::to_string(options.iterations));
+
+    const float scales[] = { 1.0f, 1.5f };
+    for (float scale : scales) {
+        std::string case_name = std::to_string((int)(scale * 96)) + " dpi";
+        int width = (int)(340 * scale), height = (int)(140 * scale);
+        software_canvas c(width, height);
+        float s = scale;
+
+        report.time_stage(case_name, "fill", options.iterations, [&] {
+            c.clear(canvas_color::rgb(32, 32, 32));
+            c.fill_rounded_rect(4 * s, 4 * s, width - 8 * s, height - 8 * s, 8 * s, canvas_color::rgb(44, 44, 48));
+            for (int i = 0; i < 5; i++) {
+                c.fill_ellipse((20 + i * 60) * s, 80 * s, 36 * s, 36 * s, canvas_color::argb(160, 90, 140, 230));
+                c.fill_rect((16 + i * 60) * s, 24 * s, 44 * s, 40 * s, canvas_color::rgb(70, 70, 76));
+            }
+        });
+        bench_consume(c.bits(), (size_t)c.stride() * height);
+
+        const canvas_point star[] = {
+            { 30, 8 }, { 36, 24 }, { 53, 24 }, { 39, 34 }, { 45, 51 },
+            { 30, 41 }, { 15, 51 }, { 21, 34 }, { 7, 24 }, { 24, 24 },
+        };
+        canvas_point scaled_star[10];
+        for (int i = 0; i < 10; i++) scaled_star[i] = { star[i].x * s, star[i].y * s };
+        report.time_stage(case_name, "polygon", options.iterations, [&] {
+            c.fill_polygon(scaled_star, 10, canvas_color::rgb(250, 200, 40));
+            c.draw_line(70 * s, 10 * s, 300 * s, 120 * s, 2 * s, canvas_color::argb(180, 255, 128, 0));
+            c.draw_line(70 * s, 120 * s, 300 * s, 10 * s, 1 * s, canvas_color::rgb(255, 255, 255));
+            c.draw_arc(150 * s, 40 * s, 60 * s, 60 * s, -90, 270, 3 * s, canvas_color::rgb(120, 220, 255));
+        });
+        bench_consume(c.bits(), (size_t)c.stride() * height);
+
+        volume_osd_style style = make_osd_style(scale, 0.6f);
+        software_canvas osd(style.width, style.height);
+        int frame = 0;
+        report.time_stage(case_name, "osd", options.iterations, [&] {
+            style.volume = (frame++ % 101) / 100.0f;
+            osd.clear(canvas_color::argb(0, 0, 0, 0));
+            paint_volume_osd(osd, style);
+        });
+        bench_consume(osd.bits(), (size_t)osd.stride() * style.height);
+
+        report.time_stage(case_name, "corners", options.iterations, [&] {
+            apply_rounded_corner_alpha(c.bits(), width, height, 8 * s);
+        });
+        bench_consume(c.bits(), (size_t)c.stride() * height);
+    }
+
+    bool passed = report.check_thresholds(options.thresholds_path);
+    if (!report.write(options.json_path)) return 2;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+// The Up Next pane's per-frame bookkeeping over a synthetic 1,000,000-entry playlist: viewport,
+// cache lookup, and fetching/formatting the rows that scrolled in (the fetch builds the same
+// three strings per row that up_next_view formats with titleformat). Stages, each one frame:
+//   scroll      wheel scroll by one notch (3 rows)
+//   page        page down
+//   jump        scrollbar drag to a random position
+//   edit        rows above the viewport inserted (invalidate_from), then the frame
+//
+//   up_next_rows_bench [--iterations N] [--json out.json] [--thresholds limits.txt] [item_count]
+//
+// The run also checks that the cache stays the same size for a 1,000-entry and a 1M-entry
+// playlist: memory depends on the viewport only.
+
+#include "bench_report.h"
+#include "../up_next_rows.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+static const int ROW_HEIGHT = 30;           // up_next_view at 96 DPI
+static const int VIEW_HEIGHT = 600;
+static const size_t FETCH_BATCH = 32;       // up_next_view::FETCH_BATCH
+
+struct up_next_model {
+    size_t item_count;
+    row_cache rows;
+    int64_t scroll_y;
+    size_t rows_fetched;
+
+    explicit up_next_model(size_t items)
+        : item_count(items)
+        , rows((size_t)(VIEW_HEIGHT / ROW_HEIGHT) + 2 + 2 * FETCH_BATCH)
+        , scroll_y(0)
+        , rows_fetched(0) {
+    }
+
+    // What up_next_view::paint does before drawing; returns the visible rows found in the cache
+    size_t frame() {
+        scroll_y = clamp_row_scroll(scroll_y, item_count, ROW_HEIGHT, VIEW_HEIGHT);
+        row_viewport viewport = compute_row_viewport(item_count, ROW_HEIGHT, VIEW_HEIGHT, scroll_y);
+        size_t batch_first = 0, batch_count = 0;
+        while (rows.find_missing_batch(viewport.first, viewport.count, item_count, FETCH_BATCH, batch_first, batch_count)) {
+            fetch(batch_first, batch_count);
+        }
+        size_t found = 0;
+        for (size_t i = 0; i < viewport.count; i++) {
+            const up_next_row* row = rows.find(viewport.first + i);
+            if (row) found += row->text.length() > 0;
+        }
+        return found;
+    }
+
+    void fetch(size_t first, size_t count) {
+        char buffer[96];
+        for (size_t index = first; index < first + count && index < item_count; index++) {
+            up_next_row& row = rows.insert(index);
+            size_t album = index / 12;
+            snprintf(buffer, sizeof(buffer), "Artist %zu - Track %zu of a reasonably long title", album % 997, index);
+            row.text = buffer;
+            snprintf(buffer, sizeof(buffer), "%zu:%02zu", 2 + index % 5, index % 60);
+            row.length = buffer;
+            snprintf(buffer, sizeof(buffer), "Artist %zu|Album %zu", album % 997, album);
+            row.album_key = buffer;
+            rows_fetched++;
+        }
+    }
+
+    // Upper bound on what the cache holds: slots plus the strings of a full slot
+    size_t memory_bytes() const {
+        return rows.capacity() * (sizeof(up_next_row) + 96 + 8 + 32);
+    }
+};
+
+int main(int argc, char** argv) {
+    bench_options options;
+    if (!parse_bench_options(argc, argv, 2000, options) || options.inputs.size() > 1) return 2;
+    size_t item_count = options.inputs.empty() ? 1000000 : strtoull(options.inputs[0].c_str(), nullptr, 10);
+    if (item_count == 0) return 2;
+
+    bench_report report("up_next_rows");
+    report.add_info("items", std::to_string(item_count));
+    report.add_info("iterations", std::to_string(options.iterations));
+    std::string case_name = std::to_string(item_count) + " items";
+
+    up_next_model model(item_count);
+    model.frame();
+    size_t missing = 0;
+    size_t visible = (size_t)(VIEW_HEIGHT / ROW_HEIGHT);
+
+    report.time_stage(case_name, "scroll", options.iterations, [&] {
+        model.scroll_y += 3 * ROW_HEIGHT;
+        if (model.frame() < visible) missing++;
+    });
+
+    report.time_stage(case_name, "page", options.iterations, [&] {
+        model.scroll_y += VIEW_HEIGHT;
+        if (model.frame() < visible) missing++;
+    });
+
+    std::mt19937_64 rng(43);
+    report.time_stage(case_name, "jump", options.iterations, [&] {
+        model.scroll_y = (int64_t)(rng() % item_count) * ROW_HEIGHT;
+        if (model.frame() < visible) missing++;
+    });
+
+    report.time_stage(case_name, "edit", options.iterations, [&] {
+        row_viewport viewport = compute_row_viewport(model.item_count, ROW_HEIGHT, VIEW_HEIGHT, model.scroll_y);
+        model.item_count++;
+        model.rows.invalidate_from(viewport.first > 10 ? viewport.first - 10 : 0);
+        if (model.frame() < visible) missing++;
+    });
+
+    // Same cache for a short playlist: nothing grows with the list
+    up_next_model small(1000);
+    small.frame();
+    bool constant_memory = small.memory_bytes() == model.memory_bytes();
+    report.add_info("cache_rows", std::to_string(model.rows.capacity()));
+    report.add_info("cache_bytes_bound", std::to_string(model.memory_bytes()));
+    report.add_info("rows_fetched", std::to_string(model.rows_fetched));
+    report.add_info("constant_memory", constant_memory ? "true" : "false");
+    report.add_info("frames_with_missing_rows", std::to_string(missing));
+
+    bool passed = report.check_thresholds(options.thresholds_path);
+    if (!report.write(options.json_path)) return 2;
+    if (!constant_memory) fprintf(stderr, "cache size depends on the playlist length\n");
+    if (missing > 0) fprintf(stderr, "%zu frames drew with rows missing from the cache\n", missing);
+    return passed && constant_memory && missing == 0 ? 0 : 1;
+}
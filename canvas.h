@@ -0,0 +1,127 @@
+#pragma once
+
+// Minimal 2D drawing interface used by the portable paint routines.
+// Two backends implement it: gdiplus_canvas (GDI+ on an HDC, used by the windows) and
+// software_canvas (portable premultiplied-BGRA rasterizer with no Windows dependency).
+// This header must stay free of Windows/SDK includes so portable code can use it.
+
+#include <cstdint>
+
+struct canvas_color {
+    uint8_t a;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    static canvas_color rgb(uint8_t r, uint8_t g, uint8_t b) { canvas_color c = { 255, r, g, b }; return c; }
+    static canvas_color argb(uint8_t a, uint8_t r, uint8_t g, uint8_t b) { canvas_color c = { a, r, g, b }; return c; }
+};
+
+struct canvas_point {
+    float x;
+    float y;
+};
+
+struct canvas_rect {
+    float x;
+    float y;
+    float w;
+    float h;
+};
+
+enum canvas_text_align {
+    canvas_align_near,
+    canvas_align_center,
+    canvas_align_far
+};
+
+// draw_text flags
+enum : unsigned {
+    canvas_text_end_ellipsis = 1     // Cut an overflowing line with "..." (DT_END_ELLIPSIS)
+};
+
+// Pixels a canvas can draw: 32-bit BGRA rows. A negative stride is a bottom-up bitmap, with
+// bits pointing at the top row.
+struct canvas_image {
+    const uint8_t* bits;
+    int width;
+    int height;
+    int stride;
+    bool has_alpha;         // Premultiplied alpha; false = opaque, the alpha byte is ignored
+
+    bool empty() const { return !bits || width <= 0 || height <= 0; }
+};
+
+// A UI font as LOGFONT describes it. native is the backend's own handle for it (an HFONT for
+// gdiplus_canvas), or null to have the backend create the font from the description.
+struct canvas_font {
+    wchar_t face[32];
+    int height;             // LOGFONT lfHeight: negative = character height in px, positive = cell height
+    int weight;             // 400 normal, 700 bold
+    bool italic;
+    const void* native;
+
+    static canvas_font make(const wchar_t* face, int height, int weight, bool italic = false) {
+        canvas_font f = {};
+        for (int i = 0; face && face[i] && i < 31; i++) f.face[i] = face[i];
+        f.height = height;
+        f.weight = weight;
+        f.italic = italic;
+        return f;
+    }
+};
+
+struct canvas_text_extent {
+    float width;
+    float height;           // Line height
+};
+
+class canvas {
+public:
+    virtual ~canvas() {}
+
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+
+    // Replace every pixel (including alpha) with the given color
+    virtual void clear(canvas_color color) = 0;
+
+    // Anti-aliased fills
+    virtual void fill_rect(float x, float y, float w, float h, canvas_color color) = 0;
+    virtual void fill_rounded_rect(float x, float y, float w, float h, float radius, canvas_color color) = 0;
+    virtual void fill_ellipse(float x, float y, float w, float h, canvas_color color) = 0;
+    virtual void fill_polygon(const canvas_point* points, int count, canvas_color color) = 0;
+
+    // Anti-aliased strokes centered on the geometry
+    virtual void stroke_rounded_rect(float x, float y, float w, float h, float radius, float stroke, canvas_color color) = 0;
+    virtual void draw_line(float x1, float y1, float x2, float y2, float stroke, canvas_color color) = 0;
+    // Arc of the ellipse inscribed in (x, y, w, h); angles in degrees, clockwise from 3 o'clock (GDI+ convention)
+    virtual void draw_arc(float x, float y, float w, float h, float start_deg, float sweep_deg, float stroke, canvas_color color) = 0;
+
+    // Single-line text in the UI font at size_pt points (already DPI-scaled by the caller).
+    // Vertically centered in the box, horizontally aligned as requested.
+    virtual float measure_text(const wchar_t* text, float size_pt) = 0;
+    virtual void draw_text(const wchar_t* text, float x, float y, float w, float h, float size_pt,
+        canvas_text_align align, canvas_color color) = 0;
+
+    // Single-line text in a window font. Vertically centered in the box, clipped to it, and
+    // cut with "..." when canvas_text_end_ellipsis is set and the line does not fit.
+    virtual canvas_text_extent measure_text(const canvas_font& font, const wchar_t* text) = 0;
+    virtual void draw_text(const canvas_font& font, const wchar_t* text, const canvas_rect& box,
+        canvas_text_align align, canvas_color color, unsigned flags) = 0;
+
+    // Horizontal gradient from left to right over the (optionally rounded) rect
+    virtual void fill_linear_gradient(const canvas_rect& rect, float radius, canvas_color left, canvas_color right) = 0;
+    // Several contours filled as one shape with the nonzero winding rule, so holes are
+    // contours of opposite orientation
+    virtual void fill_path(const canvas_point* points, const int* contour_sizes, int contour_count, canvas_color color) = 0;
+    // Pixel-aligned rects sharing a color (seekbar columns)
+    virtual void fill_rects(const canvas_rect* rects, int count, canvas_color color) = 0;
+
+    // Scale the source rect of image into dest, optionally clipped to a rounded rect
+    virtual void draw_image(const canvas_image& image, const canvas_rect& dest, const canvas_rect& source, float corner_radius) = 0;
+
+    // Integer clip rect for everything drawn until reset_clip()
+    virtual void set_clip(int x, int y, int w, int h) = 0;
+    virtual void reset_clip() = 0;
+};
@@ -4,43 +4,16 @@
 #include "preferences.h"
 #include "volume_popup.h"
 #include "artwork_bridge.h"
+#include "startup.h"
+#include "software_canvas.h"
+#include "gdiplus_canvas.h"
+#include "artwork_pipeline.h"
+#include "stream_metadata.h"
+#include "perf_stats.h"
+#include "tracing.h"
+#include "waveform_cache.h"
 #include <cmath>
 
-// Apply an anti-aliased rounded-rectangle alpha mask to a 32-bit ARGB (BGRA) DIB section.
-// Pixels outside the rounded rectangle are made fully transparent; the corner edge is
-// anti-aliased using a 1px signed-distance coverage falloff for silky-smooth corners.
-static void apply_rounded_corner_alpha(void* bits, int w, int h, float radius) {
-    BYTE* px = static_cast<BYTE*>(bits);
-    if (!px) return;
-    const float cx = w * 0.5f;
-    const float cy = h * 0.5f;
-    const float hw = w * 0.5f - radius;
-    const float hh = h * 0.5f - radius;
-
-    for (int y = 0; y < h; y++) {
-        const float py = (float)y + 0.5f - cy;
-        const float qy = fabsf(py) - hh;
-        const float ay = qy > 0.0f ? qy : 0.0f;
-        for (int x = 0; x < w; x++) {
-            const float p_x = (float)x + 0.5f - cx;
-            const float qx = fabsf(p_x) - hw;
-            const float ax = qx > 0.0f ? qx : 0.0f;
-            const float m = qx > qy ? qx : qy;
-            const float d = sqrtf(ax * ax + ay * ay) + (m < 0.0f ? m : 0.0f) - radius;
-            float coverage = 0.5f - d;
-            if (coverage < 0.0f) coverage = 0.0f;
-            if (coverage > 1.0f) coverage = 1.0f;
-            BYTE* p = px + (y * w + x) * 4;
-            const unsigned int a = (unsigned int)(coverage * 255.0f + 0.5f);
-            // Premultiply RGB by alpha (UpdateLayeredWindow AC_SRC_ALPHA expects premultiplied)
-            p[0] = (BYTE)(((unsigned int)p[0] * a + 127) / 255);
-            p[1] = (BYTE)(((unsigned int)p[1] * a + 127) / 255);
-            p[2] = (BYTE)(((unsigned int)p[2] * a + 127) / 255);
-            p[3] = (BYTE)a;
-        }
-    }
-}
-
 // Timer constants
 #define TIMEOUT_TIMER_ID 9999  // Use unique timer ID to avoid conflicts
 #define ANIMATION_TIMER_ID 4003
@@ -157,6 +130,9 @@ control_panel::control_panel()
     , m_slide_start_x(0)
     , m_slide_target_x(0)
     , m_slide_animation_step(0)
+    , m_visibility_hooks()
+    , m_progress_interval(0)
+    , m_repaint_after_throttle(false)
     // Theme colors - default to dark mode
     , m_is_dark_mode(true)
     , m_bg_color(RGB(32, 32, 32))
@@ -166,6 +142,39 @@ control_panel::control_panel()
     , m_progress_bg_color(RGB(80, 80, 80))
     , m_progress_fill_color(RGB(100, 149, 237))
     , m_icon_color(RGB(255, 255, 255))
+    , m_paint_surface()
+    , m_live_surface()
+    , m_prewarm_docked()
+    , m_prewarm_miniplayer()
+    , m_prewarm_docked_key(0)
+    , m_prewarm_miniplayer_key(0)
+    , m_settings_generation(0)
+    , m_prewarming(false)
+    , m_show_latency()
+    , m_roll_from()
+    , m_roll_to()
+    , m_roll_frame()
+    , m_repaint_after_move(false)
+    , m_blurred_background_width(0)
+    , m_blurred_background_height(0)
+    , m_blurred_background_source(nullptr)
+    , m_blurred_background_reuses(0)
+    , m_artwork_color_source(nullptr)
+    , m_artwork_color()
+    , m_radio_icon()
+    , m_waveform_generation(0)
+    , m_waveform_columns()
+    , m_spectrum_base()
+    , m_spectrum_base_valid(false)
+    , m_spectrum_interval(0)
+    , m_art_preview_bitmap(nullptr)
+    , m_art_decode_same_track(false)
+    , m_crossfade_from()
+    , m_crossfade_frame()
+    , m_crossfade_active(false)
+    , m_crossfade_start(0)
+    , m_crossfade_duration(0)
+    , m_cover_animation_drawn(false)
 {
     m_last_click_pos.x = 0;
     m_last_click_pos.y = 0;
@@ -190,20 +199,61 @@ public:
     traycontrols_playlist_callback()
         : playlist_callback_impl_base(playlist_callback::flag_on_playback_order_changed) {}
 
+    // Item and playlist edits are only delivered while the Up Next pane needs them
+    void set_track_items(bool track) {
+        set_callback_flags(track ? (flag_on_playback_order_changed | item_flags) : flag_on_playback_order_changed);
+    }
+
     void on_playback_order_changed(t_size) override {
         control_panel::get_instance().update_playback_order_state();
     }
+
+    void on_items_added(t_size p_playlist, t_size p_start, metadb_handle_list_cref p_data, const bit_array&) override {
+        up_next().on_items_added(p_playlist, p_start, p_data);
+    }
+    void on_items_reordered(t_size p_playlist, const t_size*, t_size) override {
+        up_next().on_items_reordered(p_playlist);
+    }
+    void on_items_removing(t_size p_playlist, const bit_array& p_mask, t_size, t_size) override {
+        up_next().on_items_removing(p_playlist, p_mask);
+    }
+    void on_items_removed(t_size p_playlist, const bit_array& p_mask, t_size p_old_count, t_size) override {
+        up_next().on_items_removed(p_playlist, p_mask, p_old_count);
+    }
+    void on_items_modified(t_size p_playlist, const bit_array& p_mask) override {
+        up_next().on_items_modified(p_playlist, p_mask);
+    }
+    void on_items_replaced(t_size p_playlist, const bit_array& p_mask, const pfc::list_base_const_t<t_on_items_replaced_entry>& p_data) override {
+        up_next().on_items_replaced(p_playlist, p_mask, p_data);
+    }
+    void on_playlist_activate(t_size, t_size) override { up_next().on_playlists_changed(); }
+    void on_playlist_created(t_size, const char*, t_size) override { up_next().on_playlists_changed(); }
+    void on_playlists_reorder(const t_size*, t_size) override { up_next().on_playlists_changed(); }
+    void on_playlists_removed(const bit_array&, t_size, t_size) override { up_next().on_playlists_changed(); }
+
+private:
+    static const t_uint32 item_flags =
+        flag_on_items_added | flag_on_items_reordered | flag_on_items_removing | flag_on_items_removed | flag_on_items_modified |
+        flag_on_items_replaced | flag_on_playlist_activate | flag_on_playlist_created |
+        flag_on_playlists_reorder | flag_on_playlists_removed;
+
+    static up_next_view& up_next() { return control_panel::get_instance().get_up_next_view(); }
 };
 
 void control_panel::initialize() {
     if (m_initialized) return;
     
+    // Painting uses GDI+
+    ensure_gdiplus();
     create_control_window();
     load_fonts();
     try {
         m_playlist_callback = std::make_unique<traycontrols_playlist_callback>();
     } catch (...) {}
     m_initialized = true;
+
+    // Pre-render the first frame once startup has settled
+    schedule_prewarm(PREWARM_STARTUP_DELAY);
 }
 
 void control_panel::cleanup() {
@@ -211,20 +261,46 @@ void control_panel::cleanup() {
         hide_control_panel_immediate(); // Use immediate hide during cleanup
     }
     
+    m_up_next.detach();
     m_playlist_callback.reset();
 
     // Kill update timers
     if (m_control_window) {
-        KillTimer(m_control_window, UPDATE_TIMER_ID);
+        stop_progress_timer();
         KillTimer(m_control_window, UPDATE_TIMER_ID + 1);
         KillTimer(m_control_window, TIMEOUT_TIMER_ID);
         KillTimer(m_control_window, ANIMATION_TIMER_ID);
         KillTimer(m_control_window, BUTTON_FADE_TIMER_ID);
         KillTimer(m_control_window, BUTTON_FADE_TIMER_ID + 1);
+        KillTimer(m_control_window, PREWARM_TIMER_ID);
+        KillTimer(m_control_window, UPDATE_TIMER_ID + 3);
+        KillTimer(m_control_window, SPECTRUM_TIMER_ID);
+        KillTimer(m_control_window, CROSSFADE_TIMER_ID);
+        KillTimer(m_control_window, COVER_ANIMATION_TIMER_ID);
     }
+    m_crossfade_active = false;
+    m_spectrum_interval = 0;
+    m_spectrum.stop();
+    m_is_rolling_animation = false;
 
     cleanup_cover_art();
     cleanup_fonts();
+    release_surface(m_paint_surface);
+    release_surface(m_live_surface);
+    release_surface(m_crossfade_from);
+    release_surface(m_crossfade_frame);
+    release_surface(m_prewarm_docked);
+    release_surface(m_prewarm_miniplayer);
+    release_surface(m_roll_from);
+    release_surface(m_roll_to);
+    release_surface(m_roll_frame);
+    release_surface(m_spectrum_base);
+    m_spectrum_base_valid = false;
+    m_prewarm_docked_key = 0;
+    m_prewarm_miniplayer_key = 0;
+
+    remove_visibility_hooks();
+    m_render_throttle.detach();
     
     if (m_control_window) {
         DestroyWindow(m_control_window);
@@ -236,6 +312,9 @@ void control_panel::cleanup() {
 
 void control_panel::show_control_panel(bool force_docked) {
     if (!m_initialized || m_visible) return;
+
+    LARGE_INTEGER show_start;
+    QueryPerformanceCounter(&show_start);
     
     // Force docked state if requested (e.g., when opened from tray icon)
     if (force_docked) {
@@ -258,7 +337,7 @@ void control_panel::show_control_panel(bool force_docked) {
     position_control_panel();
     
     // Composite the docked content BEFORE showing the window (see show_control_panel_simple).
-    composite_layered_content();
+    bool prewarmed = present_first_frame(m_prewarm_docked, m_prewarm_docked_key);
     
     // Show window immediately with proper topmost behavior for docked mode
     ShowWindow(m_control_window, SW_SHOWNOACTIVATE);
@@ -266,6 +345,8 @@ void control_panel::show_control_panel(bool force_docked) {
     SetWindowPos(m_control_window, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
     
     m_visible = true;
+    record_show_latency(show_start, prewarmed);
+    refresh_render_throttle();
     
     // Enable mouse tracking to detect when cursor leaves window
     TRACKMOUSEEVENT tme = {0};
@@ -293,7 +374,7 @@ void control_panel::show_control_panel(bool force_docked) {
         } else {
             timer_interval = m_is_undocked ? 500 : 1000; // 500ms when undocked, 1000ms when docked
         }
-        SetTimer(m_control_window, UPDATE_TIMER_ID, timer_interval, nullptr);
+        start_progress_timer(timer_interval);
     }
     
     // Start timeout timer for docked panels (5 seconds auto-hide)
@@ -309,6 +390,9 @@ void control_panel::show_control_panel(bool force_docked) {
 void control_panel::show_control_panel_simple() {
     if (!m_initialized || m_visible) return;
 
+    LARGE_INTEGER show_start;
+    QueryPerformanceCounter(&show_start);
+
     // Force clean docked state - ignore any previous undocked state
     m_is_undocked = false;
     m_is_artwork_expanded = false;
@@ -329,13 +413,20 @@ void control_panel::show_control_panel_simple() {
     // WS_EX_LAYERED, its on-screen surface is whatever UpdateLayeredWindow last pushed -
     // ShowWindow makes that stale frame visible instantly. Composing first ensures the
     // layered surface already holds the docked content when the window appears.
-    composite_layered_content();
+    bool prewarmed = present_first_frame(m_prewarm_docked, m_prewarm_docked_key);
     
     // Show window with topmost behavior (like original)
     ShowWindow(m_control_window, SW_SHOWNOACTIVATE);
     SetWindowPos(m_control_window, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
     
     m_visible = true;
+    record_show_latency(show_start, prewarmed);
+    refresh_render_throttle();
+
+    // The pre-rendered frame was made at idle - refresh the time display on the next paint
+    if (prewarmed) {
+        InvalidateRect(m_control_window, nullptr, FALSE);
+    }
     
     // Enable mouse tracking to detect when cursor leaves window
     TRACKMOUSEEVENT tme = {0};
@@ -345,7 +436,7 @@ void control_panel::show_control_panel_simple() {
     TrackMouseEvent(&tme);
     
     // Always start both timers (like original) - use timer ID from original version
-    SetTimer(m_control_window, UPDATE_TIMER_ID, 1000, nullptr);
+    start_progress_timer(1000);
     SetTimer(m_control_window, TIMEOUT_TIMER_ID, 5000, nullptr); // 5 seconds auto-close
 }
 
@@ -370,7 +461,7 @@ void control_panel::hide_control_panel_immediate() {
     }
     
     // Stop other timers
-    KillTimer(m_control_window, UPDATE_TIMER_ID);
+    stop_progress_timer();
     KillTimer(m_control_window, UPDATE_TIMER_ID + 1);
     KillTimer(m_control_window, TIMEOUT_TIMER_ID);
     KillTimer(m_control_window, SLIDE_TIMER_ID);
@@ -394,6 +485,8 @@ void control_panel::hide_control_panel_immediate() {
     // Hide immediately without animation
     ShowWindow(m_control_window, SW_HIDE);
     m_visible = false;
+    refresh_render_throttle();
+    schedule_prewarm();
 }
 
 void control_panel::toggle_control_panel() {
@@ -411,6 +504,11 @@ void control_panel::toggle_control_panel() {
 void control_panel::hide_and_remember_miniplayer() {
     if (!m_control_window || !m_visible) return;
 
+    // Land a roll in progress so the final size is what gets remembered
+    if (m_is_rolling_animation) {
+        finish_roll_animation();
+    }
+
     // Only save state if in a non-docked mode (undocked, expanded, or compact)
     if (m_is_undocked || m_is_artwork_expanded || m_is_compact_mode) {
         RECT rect;
@@ -426,7 +524,7 @@ void control_panel::hide_and_remember_miniplayer() {
     }
 
     // Hide immediately without animation
-    KillTimer(m_control_window, UPDATE_TIMER_ID);
+    stop_progress_timer();
     KillTimer(m_control_window, ANIMATION_TIMER_ID);
     KillTimer(m_control_window, TIMEOUT_TIMER_ID);
     KillTimer(m_control_window, TICKER_TIMER_ID);
@@ -434,6 +532,9 @@ void control_panel::hide_and_remember_miniplayer() {
     m_artist_ticker_active = false;
     ShowWindow(m_control_window, SW_HIDE);
     m_visible = false;
+    m_is_slid_to_side = false;
+    refresh_render_throttle();
+    schedule_prewarm();
 }
 
 void control_panel::show_miniplayer_at_saved_position() {
@@ -441,6 +542,9 @@ void control_panel::show_miniplayer_at_saved_position() {
         initialize();
     }
 
+    LARGE_INTEGER show_start;
+    QueryPerformanceCounter(&show_start);
+
     if (!m_control_window) {
         create_control_window();
     }
@@ -483,12 +587,14 @@ void control_panel::show_miniplayer_at_saved_position() {
     SetWindowPos(m_control_window, HWND_TOPMOST, x, y, width, height, SWP_NOACTIVATE);
     // Composite the MiniPlayer content BEFORE showing the window so the layered surface does
     // not flash the previously shown docked panel frame when the window appears.
-    composite_layered_content();
+    bool prewarmed = present_first_frame(m_prewarm_miniplayer, m_prewarm_miniplayer_key);
     ShowWindow(m_control_window, SW_SHOWNOACTIVATE);
     m_visible = true;
+    record_show_latency(show_start, prewarmed);
+    refresh_render_throttle();
 
     // Start update timer
-    SetTimer(m_control_window, UPDATE_TIMER_ID, 500, nullptr);
+    start_progress_timer(500);
 
     // Trigger repaint
     InvalidateRect(m_control_window, nullptr, TRUE);
@@ -513,7 +619,7 @@ void control_panel::show_undocked_miniplayer() {
     // This allows the MiniPlayer to open when clicking "Launch MiniPlayer" while docked popup is shown
     if (m_visible && !m_is_undocked && !m_is_artwork_expanded && !m_is_compact_mode) {
         // Kill all timers and hide immediately - don't animate since we're switching modes
-        KillTimer(m_control_window, UPDATE_TIMER_ID);
+        stop_progress_timer();
         KillTimer(m_control_window, UPDATE_TIMER_ID + 1);
         KillTimer(m_control_window, TIMEOUT_TIMER_ID);
         KillTimer(m_control_window, ANIMATION_TIMER_ID);
@@ -526,7 +632,7 @@ void control_panel::show_undocked_miniplayer() {
     // If MiniPlayer (Undocked/Expanded/Compact) is fully visible, either slide to side or hide
     else if (m_visible) {
         // If "Always Slide-to-Side" is enabled, slide instead of hiding
-        if (get_always_slide_to_side()) {
+        if (get_settings().always_slide_to_side) {
             slide_to_side();
         } else {
             hide_and_remember_miniplayer();
@@ -543,6 +649,9 @@ void control_panel::show_undocked_miniplayer() {
         create_control_window();
     }
 
+    LARGE_INTEGER show_start;
+    QueryPerformanceCounter(&show_start);
+
     // Update track info and load cover art
     update_track_info();
 
@@ -560,17 +669,7 @@ void control_panel::show_undocked_miniplayer() {
 
     // Set dimensions based on mode
     int width, height;
-    if (m_is_artwork_expanded) {
-        width = m_saved_expanded_width > 0 ? m_saved_expanded_width : 400;
-        height = m_saved_expanded_height > 0 ? m_saved_expanded_height : 400;
-    } else if (m_is_compact_mode) {
-        width = m_saved_compact_width > 0 ? m_saved_compact_width : 320;
-        height = 75;
-    } else {
-        // Undocked mode
-        width = m_saved_undocked_width > 0 ? m_saved_undocked_width : 338;
-        height = m_saved_undocked_height > 0 ? m_saved_undocked_height : 120;
-    }
+    get_miniplayer_launch_size(width, height);
 
     // Use saved position if available, otherwise center on screen
     int x, y;
@@ -588,12 +687,14 @@ void control_panel::show_undocked_miniplayer() {
     SetWindowPos(m_control_window, HWND_TOPMOST, x, y, width, height, SWP_NOACTIVATE);
     // Composite the MiniPlayer content BEFORE showing the window so the layered surface does
     // not flash the previously shown docked panel frame when the window appears.
-    composite_layered_content();
+    bool prewarmed = present_first_frame(m_prewarm_miniplayer, m_prewarm_miniplayer_key);
     ShowWindow(m_control_window, SW_SHOWNOACTIVATE);
     m_visible = true;
+    record_show_latency(show_start, prewarmed);
 
     // Reset slide state
     m_is_slid_to_side = false;
+    refresh_render_throttle();
 
     // Enable mouse tracking for button fade functionality
     TRACKMOUSEEVENT tme = {0};
@@ -607,7 +708,7 @@ void control_panel::show_undocked_miniplayer() {
     m_button_opacity = 100;
 
     // Start update timer
-    SetTimer(m_control_window, UPDATE_TIMER_ID, 500, nullptr);
+    start_progress_timer(500);
 
     // Trigger repaint
     InvalidateRect(m_control_window, nullptr, TRUE);
@@ -758,6 +859,12 @@ void control_panel::update_track_info(metadb_handle_ptr p_track) {
             
             // Get track length
             m_track_length = track->get_length();
+
+            // A new track drops the old waveform; the next Compact paint requests the new one
+            if (track != m_waveform_track) {
+                m_waveform_track = track;
+                set_waveform(nullptr);
+            }
             
             if (p_track.is_valid()) {
                 m_is_playing = true;
@@ -774,43 +881,7 @@ void control_panel::update_track_info(metadb_handle_ptr p_track) {
             load_cover_art(track);
             
             // Adjust window size for new artwork aspect ratio when in expanded mode
-            if (m_is_artwork_expanded && m_control_window && m_original_art_width > 0 && m_original_art_height > 0) {
-                RECT current_rect;
-                GetWindowRect(m_control_window, &current_rect);
-                int current_width = current_rect.right - current_rect.left;
-                int current_height = current_rect.bottom - current_rect.top;
-                
-                float image_aspect = (float)m_original_art_width / (float)m_original_art_height;
-                float window_aspect = (float)current_width / (float)current_height;
-                
-                // If aspect ratios differ significantly, resize the window to match the new image
-                if (abs(image_aspect - window_aspect) > 0.05f) {
-                    int new_width, new_height;
-                    
-                    // Keep the larger dimension, adjust the smaller one
-                    if (image_aspect >= 1.0f) {
-                        // Landscape or square - keep width, adjust height
-                        new_width = current_width;
-                        new_height = (int)((float)current_width / image_aspect);
-                    } else {
-                        // Portrait - keep height, adjust width
-                        new_height = current_height;
-                        new_width = (int)((float)current_height * image_aspect);
-                    }
-                    
-                    // Ensure minimum size
-                    if (new_width < 200) new_width = 200;
-                    if (new_height < 200) new_height = 200;
-                    
-                    // Update saved dimensions
-                    m_saved_expanded_width = new_width;
-                    m_saved_expanded_height = new_height;
-                    
-                    // Resize window to match new aspect ratio
-                    SetWindowPos(m_control_window, HWND_TOPMOST, 0, 0, new_width, new_height,
-                        SWP_NOMOVE | SWP_NOACTIVATE);
-                }
-            }
+            fit_expanded_window_to_artwork();
         } else {
             // Clear artwork and state if no valid track
             m_last_loaded_track = nullptr;
@@ -819,6 +890,8 @@ void control_panel::update_track_info(metadb_handle_ptr p_track) {
             m_last_stream_artist.reset();
             m_last_stream_title.reset();
             cleanup_cover_art();
+            m_waveform_track.release();
+            set_waveform(nullptr);
         }
         
     } catch (...) {
@@ -835,30 +908,12 @@ void control_panel::update_track_info(metadb_handle_ptr p_track) {
     if (m_control_window && (m_is_undocked || m_visible || m_is_artwork_expanded)) {
         InvalidateRect(m_control_window, nullptr, TRUE);
     }
-}
+    sync_spectrum_timer();
 
-static bool is_inverted_stream(const file_info& info, metadb_handle_ptr track = nullptr) {
-    try {
-        if (track.is_valid()) {
-            pfc::string8 path = track->get_path();
-            if (!path.is_empty()) {
-                std::string path_str = path.c_str();
-                std::transform(path_str.begin(), path_str.end(), path_str.begin(), ::tolower);
-                if (path_str.find("?inverted") != std::string::npos ||
-                    path_str.find("&inverted") != std::string::npos ||
-                    path_str.find("#inverted") != std::string::npos) {
-                    return true;
-                }
-            }
-        }
-        
-        t_size index = info.meta_find("STREAM_INVERTED");
-        if (index != pfc_infinite && info.meta_enum_value_count(index) > 0) {
-            const char* val = info.meta_enum_value(index, 0);
-            if (val && strcmp(val, "1") == 0) return true;
-        }
-    } catch (...) {}
-    return false;
+    // Keep the pre-rendered first frame in step with the track while hidden
+    if (!m_visible) {
+        schedule_prewarm();
+    }
 }
 
 static bool is_bypass_stream(metadb_handle_ptr track = nullptr) {
@@ -879,91 +934,21 @@ static bool is_bypass_stream(metadb_handle_ptr track = nullptr) {
     return false;
 }
 
-void control_panel::update_stream_metadata(const file_info & p_info) {
+void control_panel::update_stream_metadata(const stream_metadata& meta) {
     if (!m_initialized) return;
 
     try {
-        metadb_handle_ptr track = m_last_loaded_track;
-        if (!track.is_valid()) {
-            auto playback = playback_control::get();
-            if (!playback->get_now_playing(track) || !track.is_valid()) {
-                return;
-            }
-        }
-        pfc::string8 path = track->get_path();
-        if (!is_remote_stream_path(path.get_ptr())) {
-            return;
-        }
-
-        pfc::string8 artist, title;
-
-        const char* p_artist = safe_meta_get(p_info, "ARTIST");
-        const char* p_title = safe_meta_get(p_info, "TITLE");
-
-        const char* stream_title = safe_meta_get(p_info, "STREAMTITLE");
-        if (!stream_title) {
-            stream_title = safe_meta_get(p_info, "ICY_TITLE");
-        }
-
-        if (stream_title) {
-            const char* dash = strstr(stream_title, " - ");
-            if (dash) {
-                if (!p_artist) {
-                    artist.set_string(stream_title, dash - stream_title);
-                }
-                if (!p_title) {
-                    title.set_string(dash + 3);
-                }
-            } else if (!p_title) {
-                title = stream_title;
-            }
-        }
-
-        if (p_artist && artist.is_empty()) artist = p_artist;
-        if (p_title && title.is_empty()) title = p_title;
-
-        if (artist.is_empty()) {
-            const char* val = safe_meta_get(p_info, "ALBUMARTIST");
-            if (val) artist = val;
-        }
-        if (artist.is_empty()) {
-            const char* val = safe_meta_get(p_info, "PERFORMER");
-            if (val) artist = val;
-        }
-        if (title.is_empty()) {
-            const char* val = safe_meta_get(p_info, "DESCRIPTION");
-            if (val) title = val;
-        }
-        if (title.is_empty()) {
-            const char* val = safe_meta_get(p_info, "COMMENT");
-            if (val) title = val;
-        }
-
-        if (title.is_empty() && artist.is_empty()) return;
-
-        artist.trim(' ');
-        title.trim(' ');
-
-        if (is_inverted_stream(p_info, m_last_loaded_track)) {
-            pfc::string8 temp = artist;
-            artist = title;
-            title = temp;
-        }
-
-        bool metadata_changed = (artist != m_last_stream_artist || title != m_last_stream_title);
+        bool metadata_changed = (meta.artist != m_last_stream_artist || meta.title != m_last_stream_title);
         if (!metadata_changed) return;
 
-        m_last_stream_artist = artist;
-        m_last_stream_title = title;
-        m_current_artist = artist.is_empty() ? "Unknown Artist" : artist;
-        m_current_title = title.is_empty() ? "Unknown Title" : title;
+        m_last_stream_artist = meta.artist;
+        m_last_stream_title = meta.title;
+        m_current_artist = meta.artist.is_empty() ? "Unknown Artist" : meta.artist;
+        m_current_title = meta.title.is_empty() ? "Unknown Title" : meta.title;
 
-        // Request new artwork from foo_artwork
-        if (is_artwork_bridge_available() && !is_bypass_stream()) {
-            if (!artist.is_empty() || !title.is_empty()) {
-                request_online_artwork(artist.c_str(), title.c_str());
-                m_online_artwork_pending = true;
-            }
+        // The online search itself is issued once per update by the stream metadata dispatcher
+        if (meta.artwork_requested) {
+            m_online_artwork_pending = true;
         }
 
         if (m_control_window) {
@@ -994,12 +979,13 @@ void control_panel::create_control_window() {
     }
     
     // Load configured MiniPlayer mode sizes
-    m_saved_normal_width = get_miniplayer_undocked_width();
-    m_saved_normal_height = get_miniplayer_undocked_height();
-    m_saved_compact_width = get_miniplayer_compact_width();
-    m_saved_compact_height = get_miniplayer_compact_height();
-    m_saved_expanded_width = get_miniplayer_expanded_size();
-    m_saved_expanded_height = get_miniplayer_expanded_size();
+    const tray_settings& settings = get_settings();
+    m_saved_normal_width = settings.undocked_width;
+    m_saved_normal_height = settings.undocked_height;
+    m_saved_compact_width = settings.compact_width;
+    m_saved_compact_height = settings.compact_height;
+    m_saved_expanded_width = settings.expanded_size;
+    m_saved_expanded_height = settings.expanded_size;
 
     // Track the last-applied size configuration separately from the actual window size
     m_applied_undocked_width = m_saved_normal_width;
@@ -1027,6 +1013,9 @@ void control_panel::create_control_window() {
     
     // Apply window corner preference (rounded/square corners)
     apply_window_corner_preference();
+
+    m_render_throttle.attach(m_control_window);
+    m_up_next.attach(m_control_window);
 }
 
 void control_panel::position_control_panel() {
@@ -1069,14 +1058,12 @@ void control_panel::position_control_panel() {
 }
 
 void control_panel::on_online_artwork_received() {
+    TRAY_TRACE_SCOPE("artwork", "control_panel artwork received");
     if (has_pending_online_artwork_panel()) {
-        HBITMAP bitmap = get_pending_online_artwork_panel();
-        if (bitmap) {
-            cleanup_cover_art();
-            m_cover_art_bitmap = bitmap;
-            m_cover_art_bitmap_large = nullptr;
-            m_cover_art_bitmap_original = nullptr;
-            m_artwork_from_bridge = false; // We own the copy, cleanup_cover_art will DeleteObject
+        bridge_artwork_ptr art = get_pending_online_artwork_panel();
+        if (art) {
+            begin_crossfade();
+            set_bridge_artwork(art);
             m_online_artwork_pending = false;
 
             {
@@ -1100,52 +1087,71 @@ void control_panel::on_online_artwork_received() {
             m_last_loaded_artist = m_current_artist;
             m_last_loaded_title = m_current_title;
 
-            BITMAP bm;
-            if (GetObject(bitmap, sizeof(bm), &bm)) {
-                m_original_art_width = bm.bmWidth;
-                m_original_art_height = bm.bmHeight;
-            }
-
             // Adjust window size for new artwork aspect ratio when in expanded mode
-            if (m_is_artwork_expanded && m_control_window && m_original_art_width > 0 && m_original_art_height > 0) {
-                RECT current_rect;
-                GetWindowRect(m_control_window, &current_rect);
-                int current_width = current_rect.right - current_rect.left;
-                int current_height = current_rect.bottom - current_rect.top;
-                
-                float image_aspect = (float)m_original_art_width / (float)m_original_art_height;
-                float window_aspect = (float)current_width / (float)current_height;
-                
-                if (abs(image_aspect - window_aspect) > 0.05f) {
-                    int new_width, new_height;
-                    
-                    if (image_aspect >= 1.0f) {
-                        new_width = current_width;
-                        new_height = (int)((float)current_width / image_aspect);
-                    } else {
-                        new_height = current_height;
-                        new_width = (int)((float)current_height * image_aspect);
-                    }
-                    
-                    if (new_width < 200) new_width = 200;
-                    if (new_height < 200) new_height = 200;
-                    
-                    m_saved_expanded_width = new_width;
-                    m_saved_expanded_height = new_height;
-                    
-                    SetWindowPos(m_control_window, HWND_TOPMOST, 0, 0, new_width, new_height,
-                        SWP_NOMOVE | SWP_NOACTIVATE);
-                }
-            }
+            fit_expanded_window_to_artwork();
 
             if (m_control_window) {
                 InvalidateRect(m_control_window, nullptr, FALSE);
             }
+            if (!m_visible) {
+                schedule_prewarm();
+            }
+        }
+    }
+}
+
+void control_panel::on_waveform_ready(const metadb_handle_ptr& track) {
+    if (track != m_waveform_track || !get_settings().waveform_seekbar) return;
+    set_waveform(waveform_cache::get_instance().request(track));
+    if (m_control_window && m_is_compact_mode) {
+        InvalidateRect(m_control_window, nullptr, FALSE);
+    }
+}
+
+// Resize the Expanded window to the artwork's aspect ratio. The size is known before the
+// decode when the artwork has a recorded signature, so the window settles with the preview.
+void control_panel::fit_expanded_window_to_artwork() {
+    if (!m_is_artwork_expanded || !m_control_window || m_original_art_width <= 0 || m_original_art_height <= 0) return;
+
+    RECT current_rect;
+    GetWindowRect(m_control_window, &current_rect);
+    int current_width = current_rect.right - current_rect.left;
+    int current_height = current_rect.bottom - current_rect.top;
+    
+    float image_aspect = (float)m_original_art_width / (float)m_original_art_height;
+    float window_aspect = (float)current_width / (float)current_height;
+    
+    // If aspect ratios differ significantly, resize the window to match the new image
+    if (abs(image_aspect - window_aspect) > 0.05f) {
+        int new_width, new_height;
+        
+        // Keep the larger dimension, adjust the smaller one
+        if (image_aspect >= 1.0f) {
+            // Landscape or square - keep width, adjust height
+            new_width = current_width;
+            new_height = (int)((float)current_width / image_aspect);
+        } else {
+            // Portrait - keep height, adjust width
+            new_height = current_height;
+            new_width = (int)((float)current_height * image_aspect);
         }
+        
+        // Ensure minimum size
+        if (new_width < 200) new_width = 200;
+        if (new_height < 200) new_height = 200;
+        
+        // Update saved dimensions
+        m_saved_expanded_width = new_width;
+        m_saved_expanded_height = new_height;
+        
+        // Resize window to match new aspect ratio
+        SetWindowPos(m_control_window, HWND_TOPMOST, 0, 0, new_width, new_height,
+            SWP_NOMOVE | SWP_NOACTIVATE);
     }
 }
 
 void control_panel::load_cover_art(metadb_handle_ptr p_track) {
+    TRAY_PERF_SCOPE(perf_phase_load_cover_art);
     // Check if artwork has arrived via callback (from foo_artwork).
     if (has_pending_online_artwork_panel()) {
         on_online_artwork_received();
@@ -1175,92 +1181,39 @@ void control_panel::load_cover_art(metadb_handle_ptr p_track) {
             bool track_changed = (track != m_last_loaded_track);
 
             // Fast path: If neither metadata nor track handle has changed and artwork is present or pending, keep it
-            if (!metadata_changed && !track_changed && (m_cover_art_bitmap != nullptr || m_online_artwork_pending)) {
+            if (!metadata_changed && !track_changed &&
+                (m_cover_art_bitmap != nullptr || m_online_artwork_pending || m_art_decode_track.is_valid())) {
                 return;
             }
 
-            // Track or metadata has changed - update cache state
+            // Track or metadata has changed - fade from the frame on screen to the new content
+            begin_crossfade();
+
+            // Update cache state
             m_last_loaded_track = track;
             m_last_loaded_artist = artist;
             m_last_loaded_title = title;
             clear_pending_online_artwork();
 
-            // 1. Try local/embedded artwork ONLY for local files (NEVER for streams - prevents network lockup)
+            // 1. Try local/embedded artwork ONLY for local files (NEVER for streams - prevents network lockup).
+            // It is extracted and decoded on a worker; the signature preview stands in until then,
+            // and on_artwork_decoded falls back to online artwork if the file has none.
             if (!is_stream) {
-                album_art_data_ptr data;
-                try {
-                    auto api_v3 = album_art_manager_v3::get();
-                    if (api_v3.is_valid()) {
-                        auto extractor = api_v3->open(
-                            pfc::list_single_ref_t<metadb_handle_ptr>(track),
-                            pfc::list_single_ref_t<GUID>(album_art_ids::cover_front),
-                            fb2k::noAbort
-                        );
-                        if (extractor.is_valid()) {
-                            extractor->query(album_art_ids::cover_front, data, fb2k::noAbort);
-                        }
-                    }
-                } catch (...) {}
-
-                if (!data.is_valid() || data->get_size() == 0) {
-                    try {
-                        auto api_v2 = album_art_manager_v2::get();
-                        if (api_v2.is_valid()) {
-                            auto extractor = api_v2->open(
-                                pfc::list_single_ref_t<metadb_handle_ptr>(track),
-                                pfc::list_single_ref_t<GUID>(album_art_ids::cover_front),
-                                fb2k::noAbort
-                            );
-                            if (extractor.is_valid()) {
-                                data = extractor->query(album_art_ids::cover_front, fb2k::noAbort);
-                            }
-                        }
-                    } catch (...) {}
-                }
-
-                if (data.is_valid() && data->get_size() > 0) {
-                    cleanup_cover_art();
-                    m_last_loaded_track = track;
-                    m_last_loaded_artist = artist;
-                    m_last_loaded_title = title;
-                    m_cover_art_bitmap = convert_album_art_to_bitmap(data);
-                    m_cover_art_bitmap_original = convert_album_art_to_bitmap_original(data);
-                    m_online_artwork_pending = false;
-                    if (m_control_window) InvalidateRect(m_control_window, nullptr, FALSE);
-                    return;
-                }
+                cleanup_cover_art();
+                m_last_loaded_track = track;
+                m_last_loaded_artist = artist;
+                m_last_loaded_title = title;
+                m_online_artwork_pending = false;
+                show_artwork_preview(track);
+                m_art_decode_track = track;
+                m_art_decode_same_track = !track_changed && !metadata_changed;
+                artwork_cache::get_instance().request(track);
+                if (m_control_window) InvalidateRect(m_control_window, nullptr, FALSE);
+                return;
             }
 
             // 2. Try online artwork via foo_artwork bridge
-            cleanup_cover_art();
-            m_last_loaded_track = track;
-            m_last_loaded_artist = artist;
-            m_last_loaded_title = title;
-
-            if (is_artwork_bridge_available() && !is_bypass_stream(track)) {
-                // If restoring/reopening MiniPlayer for the same track and foo_artwork already has active artwork, grab it
-                if (!track_changed && !metadata_changed) {
-                    HBITMAP current_online = get_current_online_artwork();
-                    if (current_online) {
-                        m_cover_art_bitmap = current_online;
-                        m_artwork_from_bridge = false;
-                        m_online_artwork_pending = false;
-                        BITMAP bm;
-                        if (GetObject(m_cover_art_bitmap, sizeof(bm), &bm)) {
-                            m_original_art_width = bm.bmWidth;
-                            m_original_art_height = bm.bmHeight;
-                        }
-                        if (m_control_window) InvalidateRect(m_control_window, nullptr, FALSE);
-                        return;
-                    }
-                }
-
-                if (!artist.is_empty() || !title.is_empty()) {
-                    request_online_artwork(artist.c_str(), title.c_str());
-                    m_online_artwork_pending = true;
-                }
-            }
-            if (m_control_window) InvalidateRect(m_control_window, nullptr, FALSE);
+            request_online_cover_art(track, !track_changed && !metadata_changed);
             return;
         } else {
             // No valid track - clear artwork
@@ -1275,6 +1228,13 @@ void control_panel::load_cover_art(metadb_handle_ptr p_track) {
 }
 
 void control_panel::cleanup_cover_art() {
+    release_artwork_preview();
+    m_cover_animation.close();
+    if (m_control_window) KillTimer(m_control_window, COVER_ANIMATION_TIMER_ID);
+    if (m_art_decode_track.is_valid()) {
+        m_art_decode_track.release();
+        artwork_cache::get_instance().cancel();
+    }
     if (m_cover_art_bitmap) {
         // Do NOT delete bitmaps owned by foo_artwork bridge
         if (!m_artwork_from_bridge) {
@@ -1293,30 +1253,159 @@ void control_panel::cleanup_cover_art() {
     m_original_art_width = 0;
     m_original_art_height = 0;
     m_artwork_from_bridge = false;
+    m_bridge_artwork.reset();
+    // Handles may be reused by the next artwork - never match a cache against them
+    reset_artwork_background_cache();
     m_last_loaded_track = nullptr;
     m_last_loaded_artist.clear();
     m_last_loaded_title.clear();
 }
 
-HBITMAP control_panel::convert_album_art_to_bitmap(album_art_data_ptr art_data) {
+void control_panel::set_bridge_artwork(const bridge_artwork_ptr& art) {
+    cleanup_cover_art();
+    if (!art) return;
+    // Shared with the popup - drawn directly, never copied or deleted here
+    m_bridge_artwork = art;
+    m_cover_art_bitmap = art->bitmap();
+    m_artwork_from_bridge = true;
+    m_original_art_width = art->width();
+    m_original_art_height = art->height();
+}
+
+// Online artwork via the foo_artwork bridge; used for streams and for local files without a cover.
+// same_track: the MiniPlayer is being restored for the track already shown, so the bridge's
+// current artwork can be taken as is.
+void control_panel::request_online_cover_art(const metadb_handle_ptr& track, bool same_track) {
+    pfc::string8 artist = m_current_artist;
+    pfc::string8 title = m_current_title;
+
+    cleanup_cover_art();
+    m_last_loaded_track = track;
+    m_last_loaded_artist = artist;
+    m_last_loaded_title = title;
+
+    if (is_artwork_bridge_available() && !is_bypass_stream(track)) {
+        // If restoring/reopening MiniPlayer for the same track and foo_artwork already has active artwork, grab it
+        if (same_track) {
+            bridge_artwork_ptr current_online = get_current_online_artwork();
+            if (current_online) {
+                set_bridge_artwork(current_online);
+                m_last_loaded_track = track;
+                m_last_loaded_artist = artist;
+                m_last_loaded_title = title;
+                m_online_artwork_pending = false;
+                if (m_control_window) InvalidateRect(m_control_window, nullptr, FALSE);
+                return;
+            }
+        }
+
+        if (!artist.is_empty() || !title.is_empty()) {
+            m_online_artwork_pending = request_online_artwork(artist.c_str(), title.c_str());
+        }
+    }
+    if (m_control_window) InvalidateRect(m_control_window, nullptr, FALSE);
+}
+
+void control_panel::on_artwork_decoded(const metadb_handle_ptr& track, decoded_artwork& art) {
+    if (!m_art_decode_track.is_valid() || track != m_art_decode_track) return;
+    m_art_decode_track.release();
+    begin_crossfade();
+
+    if (!art.thumbnail && !art.original) {
+        // No embedded or local cover - the preview (if any) stays until online artwork arrives
+        HBITMAP preview = m_art_preview_bitmap;
+        m_art_preview_bitmap = nullptr;
+        request_online_cover_art(track, m_art_decode_same_track);
+        if (!m_cover_art_bitmap && preview) {
+            m_art_preview_bitmap = preview;
+        } else if (preview) {
+            DeleteObject(preview);
+        }
+        return;
+    }
+
+    m_cover_art_bitmap = art.thumbnail;
+    m_cover_art_bitmap_original = art.original;
+    art.thumbnail = nullptr;
+    art.original = nullptr;
+    m_original_art_width = art.width;
+    m_original_art_height = art.height;
+    m_artwork_from_bridge = false;
+    // The still bitmaps show the first frame; the next paint starts the stream for the rest
+    if (art.animation.is_valid()) m_cover_animation.open(art.animation, art.frame_delays);
+    release_artwork_preview();
+    fit_expanded_window_to_artwork();
+
+    if (m_control_window) InvalidateRect(m_control_window, nullptr, FALSE);
+    schedule_prewarm();
+}
+
+// Render the track's recorded signature into a small DIB that stands in for the artwork
+// until the decode completes. The preview is blurry by nature, so 32 pixels are plenty;
+// GDI+ stretches it smoothly to any size.
+void control_panel::show_artwork_preview(const metadb_handle_ptr& track) {
+    static const int PREVIEW_SIZE = 32;
+
+    release_artwork_preview();
+    artwork_signature signature;
+    if (!artwork_cache::get_instance().find_signature(track, signature)) return;
+
+    int source_width = signature.source_width();
+    int source_height = signature.source_height();
+    int width = PREVIEW_SIZE;
+    int height = PREVIEW_SIZE;
+    if (source_width > source_height) {
+        height = (std::max)(1, PREVIEW_SIZE * source_height / source_width);
+    } else if (source_height > source_width) {
+        width = (std::max)(1, PREVIEW_SIZE * source_width / source_height);
+    }
+
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height; // Top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    void* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!bitmap || !bits) {
+        if (bitmap) DeleteObject(bitmap);
+        return;
+    }
+    TRAY_PERF_COUNT(perf_counter_gdi_objects);
+    if (!decode_artwork_signature(signature, static_cast<uint8_t*>(bits), width, height, width * 4)) {
+        DeleteObject(bitmap);
+        return;
+    }
+
+    m_art_preview_bitmap = bitmap;
+    m_original_art_width = source_width;
+    m_original_art_height = source_height;
+}
+
+void control_panel::release_artwork_preview() {
+    if (!m_art_preview_bitmap) return;
+    // The background style may have been derived from the preview
+    if (m_blurred_background_source == m_art_preview_bitmap || m_artwork_color_source == m_art_preview_bitmap) {
+        reset_artwork_background_cache();
+    }
+    DeleteObject(m_art_preview_bitmap);
+    m_art_preview_bitmap = nullptr;
+}
+
+HBITMAP control_panel::convert_album_art_to_bitmap_large(album_art_data_ptr art_data) {
     if (!art_data.is_valid() || art_data->get_size() == 0) {
         return nullptr;
     }
     
     HBITMAP result = nullptr;
     
-    // Initialize GDI+ if not already done
-    static ULONG_PTR gdiplusToken = 0;
-    static bool gdiplus_initialized = false;
-    
-    if (!gdiplus_initialized) {
-        Gdiplus::GdiplusStartupInput gdiplusStartupInput;
-        if (Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr) == Gdiplus::Ok) {
-            gdiplus_initialized = true;
-        } else {
-            return nullptr;
-        }
+    // GDI+ is started once for the whole component, on first use
+    if (!ensure_gdiplus()) {
+        return nullptr;
     }
+    TRAY_PERF_COUNT(perf_counter_artwork_decodes);
     
     try {
         // Create IStream from memory buffer
@@ -1333,17 +1422,19 @@ HBITMAP control_panel::convert_album_art_to_bitmap(album_art_data_ptr art_data)
             return nullptr;
         }
         
-        // Create a bitmap with the desired size (80x80 for the cover area)
-        const int target_size = 80;
+        // Create a high-quality bitmap (300x300 for expanded view)
+        const int target_size = 300;
         Gdiplus::Bitmap bitmap(target_size, target_size, PixelFormat32bppARGB);
         if (bitmap.GetLastStatus() != Gdiplus::Ok) {
             return nullptr;
         }
         
-        // Draw the image scaled to fit the target size
+        // Draw the image with highest quality settings
         Gdiplus::Graphics graphics(&bitmap);
         graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
-        graphics.SetSmoothingMode(Gdiplus::SmoothingModeHighQuality);
+        graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
+        graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
+        graphics.SetCompositingQuality(Gdiplus::CompositingQualityHighQuality);
         
         // Calculate scaling to maintain aspect ratio
         UINT img_width = image.GetWidth();
@@ -1367,7 +1458,7 @@ HBITMAP control_panel::convert_album_art_to_bitmap(album_art_data_ptr art_data)
         // Clear background to dark gray to match panel
         graphics.Clear(Gdiplus::Color(255, 32, 32, 32));
         
-        // Draw the scaled image
+        // Draw the scaled image with highest quality
         graphics.DrawImage(&image, offset_x, offset_y, draw_width, draw_height);
         
         // Convert to HBITMAP
@@ -1379,1284 +1470,101 @@ HBITMAP control_panel::convert_album_art_to_bitmap(album_art_data_ptr art_data)
         result = nullptr;
     }
     
+    if (result) TRAY_PERF_COUNT(perf_counter_gdi_objects);
     return result;
 }
 
-HBITMAP control_panel::convert_album_art_to_bitmap_large(album_art_data_ptr art_data) {
-    if (!art_data.is_valid() || art_data->get_size() == 0) {
-        return nullptr;
+// Font management methods
+void control_panel::load_fonts() {
+    cleanup_fonts();
+    
+    // Select fonts based on current display mode
+    const tray_settings& settings = get_settings();
+    const tray_font_setting& fonts =
+        m_is_artwork_expanded ? settings.expanded_fonts :
+        m_is_compact_mode ? settings.compact_fonts :
+        m_is_undocked ? settings.undocked_fonts :
+        settings.docked_fonts;
+
+    if (fonts.custom_artist) {
+        m_artist_font = CreateFontIndirect(&fonts.artist);
+    } else {
+        LOGFONT artist_lf = get_default_font(true, 9);
+        m_artist_font = CreateFontIndirect(&artist_lf);
+    }
+    if (fonts.custom_track) {
+        m_track_font = CreateFontIndirect(&fonts.track);
+    } else {
+        LOGFONT track_lf = get_default_font(false, 11);
+        m_track_font = CreateFontIndirect(&track_lf);
     }
     
-    HBITMAP result = nullptr;
+    // Load timer font (shared across all modes except Expanded)
+    if (settings.custom_timer_font) {
+        m_timer_font = CreateFontIndirect(&settings.timer_font);
+    } else {
+        LOGFONT timer_lf = get_default_font(true, 9); // 9pt like artist
+        m_timer_font = CreateFontIndirect(&timer_lf);
+    }
+    TRAY_PERF_COUNT_N(perf_counter_gdi_objects, 3);
+}
+
+void control_panel::cleanup_fonts() {
+    // Layouts are keyed by font handle, which GDI reuses once the fonts are deleted
+    m_text_layouts.clear();
+    if (m_artist_font) {
+        DeleteObject(m_artist_font);
+        m_artist_font = nullptr;
+    }
+    if (m_track_font) {
+        DeleteObject(m_track_font);
+        m_track_font = nullptr;
+    }
+    if (m_timer_font) {
+        DeleteObject(m_timer_font);
+        m_timer_font = nullptr;
+    }
+}
+
+void control_panel::on_settings_changed(unsigned changes) {
+    // Behavior settings are read from the snapshot when used and never change a frame
+    if ((changes & ~(unsigned)settings_change_behavior) == 0) return;
+
+    // Anything else may change the rendered frame - stale the pre-rendered ones
+    m_settings_generation++;
+
+    if (changes & settings_change_fonts) {
+        load_fonts();
+    }
     
-    // Initialize GDI+ if not already done
-    static ULONG_PTR gdiplusToken = 0;
-    static bool gdiplus_initialized = false;
+    // Theme colors depend on both the theme mode and the background style
+    if (changes & (settings_change_theme | settings_change_appearance)) {
+        update_theme_colors();
+    }
     
-    if (!gdiplus_initialized) {
-        Gdiplus::GdiplusStartupInput gdiplusStartupInput;
-        if (Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr) == Gdiplus::Ok) {
-            gdiplus_initialized = true;
-        } else {
-            return nullptr;
-        }
-    }
-    
-    try {
-        // Create IStream from memory buffer
-        CComPtr<IStream> stream;
-        stream.p = SHCreateMemStream(reinterpret_cast<const BYTE*>(art_data->get_ptr()), 
-                                     static_cast<UINT>(art_data->get_size()));
-        if (!stream) {
-            return nullptr;
-        }
-        
-        // Load image from stream using GDI+
-        Gdiplus::Image image(stream);
-        if (image.GetLastStatus() != Gdiplus::Ok) {
-            return nullptr;
-        }
-        
-        // Create a high-quality bitmap (300x300 for expanded view)
-        const int target_size = 300;
-        Gdiplus::Bitmap bitmap(target_size, target_size, PixelFormat32bppARGB);
-        if (bitmap.GetLastStatus() != Gdiplus::Ok) {
-            return nullptr;
-        }
-        
-        // Draw the image with highest quality settings
-        Gdiplus::Graphics graphics(&bitmap);
-        graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
-        graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-        graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
-        graphics.SetCompositingQuality(Gdiplus::CompositingQualityHighQuality);
-        
-        // Calculate scaling to maintain aspect ratio
-        UINT img_width = image.GetWidth();
-        UINT img_height = image.GetHeight();
-        
-        int draw_width = target_size;
-        int draw_height = target_size;
-        int offset_x = 0;
-        int offset_y = 0;
-        
-        if (img_width != img_height) {
-            if (img_width > img_height) {
-                draw_height = (target_size * img_height) / img_width;
-                offset_y = (target_size - draw_height) / 2;
-            } else {
-                draw_width = (target_size * img_width) / img_height;
-                offset_x = (target_size - draw_width) / 2;
-            }
-        }
-        
-        // Clear background to dark gray to match panel
-        graphics.Clear(Gdiplus::Color(255, 32, 32, 32));
-        
-        // Draw the scaled image with highest quality
-        graphics.DrawImage(&image, offset_x, offset_y, draw_width, draw_height);
-        
-        // Convert to HBITMAP
-        if (bitmap.GetHBITMAP(Gdiplus::Color(32, 32, 32), &result) != Gdiplus::Ok) {
-            result = nullptr;
-        }
-        
-    } catch (...) {
-        result = nullptr;
-    }
-    
-    return result;
-}
-
-HBITMAP control_panel::convert_album_art_to_bitmap_original(album_art_data_ptr art_data) {
-    if (!art_data.is_valid() || art_data->get_size() == 0) {
-        return nullptr;
-    }
-    
-    HBITMAP result = nullptr;
-    
-    // Initialize GDI+ if not already done
-    static ULONG_PTR gdiplusToken = 0;
-    static bool gdiplus_initialized = false;
-    
-    if (!gdiplus_initialized) {
-        Gdiplus::GdiplusStartupInput gdiplusStartupInput;
-        if (Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr) == Gdiplus::Ok) {
-            gdiplus_initialized = true;
-        } else {
-            return nullptr;
-        }
-    }
-    
-    try {
-        // Create IStream from memory buffer
-        CComPtr<IStream> stream;
-        stream.p = SHCreateMemStream(reinterpret_cast<const BYTE*>(art_data->get_ptr()), 
-                                     static_cast<UINT>(art_data->get_size()));
-        if (!stream) {
-            return nullptr;
-        }
-        
-        // Load image from stream using GDI+
-        Gdiplus::Image image(stream);
-        if (image.GetLastStatus() != Gdiplus::Ok) {
-            return nullptr;
-        }
-        
-        // Get original dimensions
-        UINT img_width = image.GetWidth();
-        UINT img_height = image.GetHeight();
-        
-        // Store original dimensions for aspect ratio calculations
-        m_original_art_width = img_width;
-        m_original_art_height = img_height;
-        
-        // Create bitmap at original resolution (no scaling)
-        Gdiplus::Bitmap bitmap(img_width, img_height, PixelFormat32bppARGB);
-        if (bitmap.GetLastStatus() != Gdiplus::Ok) {
-            return nullptr;
-        }
-        
-        // Draw the image at original resolution with highest quality settings
-        Gdiplus::Graphics graphics(&bitmap);
-        graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
-        graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-        graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
-        graphics.SetCompositingQuality(Gdiplus::CompositingQualityHighQuality);
-        
-        // Draw at original size with no scaling
-        graphics.DrawImage(&image, 0, 0, img_width, img_height);
-        
-        // Convert to HBITMAP
-        if (bitmap.GetHBITMAP(Gdiplus::Color(0, 0, 0, 0), &result) != Gdiplus::Ok) {
-            result = nullptr;
-        }
-        
-    } catch (...) {
-        result = nullptr;
-        m_original_art_width = 0;
-        m_original_art_height = 0;
-    }
-    
-    return result;
-}
-
-
-// Alternate icon helper methods (Style 2: Outline style, Style 3: Material solid filled style)
-void control_panel::draw_alternate_play_icon(HDC hdc, int x, int y, int size, COLORREF color) {
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    float scale = size / 24.0f;
-    float cx = (float)x;
-    float cy = (float)y;
-
-    Gdiplus::Matrix oldMatrix;
-    graphics.GetTransform(&oldMatrix);
-
-    Gdiplus::Matrix matrix;
-    matrix.Translate(cx - 12.0f * scale, cy - 12.0f * scale);
-    matrix.Scale(scale, scale);
-    graphics.SetTransform(&matrix);
-
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(color), GetGValue(color), GetBValue(color)));
-    Gdiplus::GraphicsPath path;
-
-    // Outer triangle
-    path.StartFigure();
-    path.AddLine(8.0f, 19.0f, 8.0f, 5.0f);
-    path.AddLine(8.0f, 5.0f, 19.0f, 12.0f);
-    path.AddLine(19.0f, 12.0f, 8.0f, 19.0f);
-    path.CloseFigure();
-
-    // Inner triangle cutout
-    path.StartFigure();
-    path.AddLine(10.0f, 15.35f, 10.0f, 8.65f);
-    path.AddLine(10.0f, 8.65f, 15.25f, 12.0f);
-    path.AddLine(15.25f, 12.0f, 10.0f, 15.35f);
-    path.CloseFigure();
-
-    path.SetFillMode(Gdiplus::FillModeWinding);
-    graphics.FillPath(&brush, &path);
-    graphics.SetTransform(&oldMatrix);
-}
-
-void control_panel::draw_alternate_pause_icon(HDC hdc, int x, int y, int size, COLORREF color) {
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    float scale = size / 24.0f;
-    float cx = (float)x;
-    float cy = (float)y;
-
-    Gdiplus::Matrix oldMatrix;
-    graphics.GetTransform(&oldMatrix);
-
-    Gdiplus::Matrix matrix;
-    matrix.Translate(cx - 12.0f * scale, cy - 12.0f * scale);
-    matrix.Scale(scale, scale);
-    graphics.SetTransform(&matrix);
-
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(color), GetGValue(color), GetBValue(color)));
-    Gdiplus::GraphicsPath path;
-
-    // Left bar outer
-    path.StartFigure();
-    path.AddLine(5.0f, 19.0f, 5.0f, 5.0f);
-    path.AddLine(5.0f, 5.0f, 11.0f, 5.0f);
-    path.AddLine(11.0f, 5.0f, 11.0f, 19.0f);
-    path.AddLine(11.0f, 19.0f, 5.0f, 19.0f);
-    path.CloseFigure();
-
-    // Left bar inner hole
-    path.StartFigure();
-    path.AddLine(7.0f, 17.0f, 9.0f, 17.0f);
-    path.AddLine(9.0f, 17.0f, 9.0f, 7.0f);
-    path.AddLine(9.0f, 7.0f, 7.0f, 7.0f);
-    path.AddLine(7.0f, 7.0f, 7.0f, 17.0f);
-    path.CloseFigure();
-
-    // Right bar outer
-    path.StartFigure();
-    path.AddLine(13.0f, 19.0f, 13.0f, 5.0f);
-    path.AddLine(13.0f, 5.0f, 19.0f, 5.0f);
-    path.AddLine(19.0f, 5.0f, 19.0f, 19.0f);
-    path.AddLine(19.0f, 19.0f, 13.0f, 19.0f);
-    path.CloseFigure();
-
-    // Right bar inner hole
-    path.StartFigure();
-    path.AddLine(15.0f, 17.0f, 17.0f, 17.0f);
-    path.AddLine(17.0f, 17.0f, 17.0f, 7.0f);
-    path.AddLine(17.0f, 7.0f, 15.0f, 7.0f);
-    path.AddLine(15.0f, 7.0f, 15.0f, 17.0f);
-    path.CloseFigure();
-
-    path.SetFillMode(Gdiplus::FillModeWinding);
-    graphics.FillPath(&brush, &path);
-    graphics.SetTransform(&oldMatrix);
-}
-
-void control_panel::draw_style3_play_icon(HDC hdc, int x, int y, int size, COLORREF color) {
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    float scale = size / 24.0f;
-    float cx = (float)x;
-    float cy = (float)y;
-
-    Gdiplus::Matrix oldMatrix;
-    graphics.GetTransform(&oldMatrix);
-
-    Gdiplus::Matrix matrix;
-    matrix.Translate(cx - 12.0f * scale, cy - 12.0f * scale);
-    matrix.Scale(scale, scale);
-    graphics.SetTransform(&matrix);
-
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(color), GetGValue(color), GetBValue(color)));
-    Gdiplus::GraphicsPath path;
-
-    // Solid triangle (no inner cutout)
-    path.StartFigure();
-    path.AddLine(8.0f, 19.0f, 8.0f, 5.0f);
-    path.AddLine(8.0f, 5.0f, 19.0f, 12.0f);
-    path.AddLine(19.0f, 12.0f, 8.0f, 19.0f);
-    path.CloseFigure();
-
-    path.SetFillMode(Gdiplus::FillModeWinding);
-    graphics.FillPath(&brush, &path);
-    graphics.SetTransform(&oldMatrix);
-}
-
-void control_panel::draw_style3_pause_icon(HDC hdc, int x, int y, int size, COLORREF color) {
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    float scale = size / 24.0f;
-    float cx = (float)x;
-    float cy = (float)y;
-
-    Gdiplus::Matrix oldMatrix;
-    graphics.GetTransform(&oldMatrix);
-
-    Gdiplus::Matrix matrix;
-    matrix.Translate(cx - 12.0f * scale, cy - 12.0f * scale);
-    matrix.Scale(scale, scale);
-    graphics.SetTransform(&matrix);
-
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(color), GetGValue(color), GetBValue(color)));
-    Gdiplus::GraphicsPath path;
-
-    // Left bar solid
-    path.StartFigure();
-    path.AddLine(5.875f, 19.45f, 5.875f, 4.55f);
-    path.AddLine(5.875f, 4.55f, 10.125f, 4.55f);
-    path.AddLine(10.125f, 4.55f, 10.125f, 19.45f);
-    path.CloseFigure();
-
-    // Right bar solid
-    path.StartFigure();
-    path.AddLine(14.425f, 19.45f, 14.425f, 4.55f);
-    path.AddLine(14.425f, 4.55f, 18.675f, 4.55f);
-    path.AddLine(18.675f, 4.55f, 18.675f, 19.45f);
-    path.CloseFigure();
-
-    path.SetFillMode(Gdiplus::FillModeWinding);
-    graphics.FillPath(&brush, &path);
-    graphics.SetTransform(&oldMatrix);
-}
-
-// Vector-drawn icon implementations - Material Design Style
-void control_panel::draw_play_icon(HDC hdc, int x, int y, int size) {
-    if (m_hovered_button == BTN_PLAYPAUSE) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-
-    int style = get_alternative_icons_style();
-
-    if (style == 1) {
-        // Style 2: Outline style (no background circle)
-        COLORREF icon_color = (m_is_undocked && !m_is_dark_mode) ? RGB(0, 0, 0) : m_icon_color;
-        draw_alternate_play_icon(hdc, x, y, size, icon_color);
-    } else if (style == 2) {
-        // Style 3: Solid filled style (no background circle)
-        COLORREF icon_color = (m_is_undocked && !m_is_dark_mode) ? RGB(0, 0, 0) : m_icon_color;
-        draw_style3_play_icon(hdc, x, y, size, icon_color);
-    } else {
-        // Style 1 (Default): Background circle + contrasting icon symbol inside
-        Gdiplus::Graphics graphics(hdc);
-        graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-        graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-        COLORREF circle_color = m_icon_color;
-        COLORREF icon_color = m_bg_color;
-        if (m_is_undocked && !m_is_dark_mode) {
-            circle_color = RGB(0, 0, 0);       // Black circle
-            icon_color = RGB(255, 255, 255);   // White icon
-        }
-
-        int radius = size / 2;
-        Gdiplus::SolidBrush bg_brush(Gdiplus::Color(255, GetRValue(circle_color), GetGValue(circle_color), GetBValue(circle_color)));
-        graphics.FillEllipse(&bg_brush, x - radius, y - radius, size, size);
-
-        int icon_height = size * 4 / 10;
-        int half_icon = icon_height / 2;
-        int icon_width = icon_height; 
-        int center_offset_x = icon_width / 8;
-        
-        Gdiplus::Point triangle[3];
-        triangle[0] = Gdiplus::Point(x - icon_width/2 + center_offset_x, y - half_icon);
-        triangle[1] = Gdiplus::Point(x - icon_width/2 + center_offset_x, y + half_icon);
-        triangle[2] = Gdiplus::Point(x + icon_width/2 + center_offset_x, y);
-        
-        Gdiplus::SolidBrush icon_brush(Gdiplus::Color(255, GetRValue(icon_color), GetGValue(icon_color), GetBValue(icon_color)));
-        graphics.FillPolygon(&icon_brush, triangle, 3);
-    }
-}
-
-void control_panel::draw_pause_icon(HDC hdc, int x, int y, int size) {
-    if (m_hovered_button == BTN_PLAYPAUSE) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-
-    int style = get_alternative_icons_style();
-
-    if (style == 1) {
-        // Style 2: Outline style (no background circle)
-        COLORREF icon_color = (m_is_undocked && !m_is_dark_mode) ? RGB(0, 0, 0) : m_icon_color;
-        draw_alternate_pause_icon(hdc, x, y, size, icon_color);
-    } else if (style == 2) {
-        // Style 3: Solid filled style (no background circle)
-        COLORREF icon_color = (m_is_undocked && !m_is_dark_mode) ? RGB(0, 0, 0) : m_icon_color;
-        draw_style3_pause_icon(hdc, x, y, size, icon_color);
-    } else {
-        // Style 1 (Default): Background circle + contrasting icon symbol inside
-        Gdiplus::Graphics graphics(hdc);
-        graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-        graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-        COLORREF circle_color = m_icon_color;
-        COLORREF icon_color = m_bg_color;
-        if (m_is_undocked && !m_is_dark_mode) {
-            circle_color = RGB(0, 0, 0);       // Black circle
-            icon_color = RGB(255, 255, 255);   // White icon
-        }
-
-        int radius = size / 2;
-        Gdiplus::SolidBrush bg_brush(Gdiplus::Color(255, GetRValue(circle_color), GetGValue(circle_color), GetBValue(circle_color)));
-        graphics.FillEllipse(&bg_brush, x - radius, y - radius, size, size);
-
-        int icon_height = size * 4 / 10;
-        int half_icon = icon_height / 2;
-        int bar_width = icon_height / 3;
-        int gap = icon_height / 3; 
-        
-        int offset = gap / 2;
-        
-        Gdiplus::SolidBrush icon_brush(Gdiplus::Color(255, GetRValue(icon_color), GetGValue(icon_color), GetBValue(icon_color)));
-        
-        graphics.FillRectangle(&icon_brush, x - offset - bar_width, y - half_icon, bar_width, icon_height);
-        graphics.FillRectangle(&icon_brush, x + offset, y - half_icon, bar_width, icon_height);
-    }
-}
-
-// Helper for drawing hover circles behind buttons
-void control_panel::draw_hover_circle(HDC hdc, int x, int y, int size) {
-    if (!get_hover_circles_enabled()) return;
-
-    // Verify mouse cursor is still inside this control panel window
-    if (m_control_window) {
-        POINT cursor_pos;
-        GetCursorPos(&cursor_pos);
-        HWND wnd_under_cursor = WindowFromPoint(cursor_pos);
-        if (wnd_under_cursor != m_control_window && !IsChild(m_control_window, wnd_under_cursor)) {
-            m_hovered_button = 0;
-            return;
-        }
-    }
-
-    int radius = size / 2 + 4; 
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-    
-    Gdiplus::SolidBrush brush(Gdiplus::Color(45, GetRValue(m_icon_color), GetGValue(m_icon_color), GetBValue(m_icon_color)));
-    graphics.FillEllipse(&brush, x - radius, y - radius, radius * 2, radius * 2);
-}
-
-void control_panel::draw_previous_icon(HDC hdc, int x, int y, int size) {
-    if (m_hovered_button == BTN_PREV) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-    
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    // Use theme-aware icon color
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(m_icon_color), GetGValue(m_icon_color), GetBValue(m_icon_color)));
-
-    int icon_h = size * 6 / 10; 
-    int bar_width = 3; 
-    int gap = 2; 
-    
-    int half_size = size / 2;
-    
-    // Bar on LEFT
-    graphics.FillRectangle(&brush, x - icon_h/2, y - icon_h/2, bar_width, icon_h);
-    
-    // Triangle pointing left
-    int tri_start_x = x - icon_h/2 + bar_width + gap;
-    Gdiplus::Point triangle[3];
-    triangle[0] = Gdiplus::Point(x + icon_h/2, y - icon_h/2);   // Top right
-    triangle[1] = Gdiplus::Point(x + icon_h/2, y + icon_h/2);   // Bottom right
-    triangle[2] = Gdiplus::Point(tri_start_x, y);               // Left point
-    
-    graphics.FillPolygon(&brush, triangle, 3);
-}
-
-void control_panel::draw_next_icon(HDC hdc, int x, int y, int size) {
-    if (m_hovered_button == BTN_NEXT) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-    
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    // Use theme-aware icon color
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(m_icon_color), GetGValue(m_icon_color), GetBValue(m_icon_color)));
-
-    int icon_h = size * 6 / 10;
-    int bar_width = 3;
-    int gap = 2;
-    
-    // Triangle pointing right
-    int tri_start_x = x - icon_h/2; 
-    Gdiplus::Point triangle[3];
-    triangle[0] = Gdiplus::Point(tri_start_x, y - icon_h/2);     // Top left
-    triangle[1] = Gdiplus::Point(tri_start_x, y + icon_h/2);     // Bottom left
-    triangle[2] = Gdiplus::Point(tri_start_x + icon_h - bar_width - gap, y); // Right point
-    
-    graphics.FillPolygon(&brush, triangle, 3);
-    
-    // Bar on RIGHT
-    int bar_x = tri_start_x + icon_h - bar_width;
-    graphics.FillRectangle(&brush, bar_x, y - icon_h/2, bar_width, icon_h);
-}
-
-
-void control_panel::draw_shuffle_icon(HDC hdc, int x, int y, int size) {
-    if (m_hovered_button == BTN_SHUFFLE) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-    
-    // Material Design Shuffle icon from SVG
-    // Active: use full icon color, Inactive: use dimmed version
-    Gdiplus::Color color;
-    if (m_shuffle_active) {
-        color = Gdiplus::Color(255, GetRValue(m_icon_color), GetGValue(m_icon_color), GetBValue(m_icon_color));
-    } else {
-        // Dimmed inactive color - use lighter color in light mode for better contrast
-        if (m_is_dark_mode) {
-            color = Gdiplus::Color(255, GetRValue(m_text_dim_color), GetGValue(m_text_dim_color), GetBValue(m_text_dim_color));
-        } else {
-            // Light mode: use much lighter gray so inactive icons are clearly faded
-            color = Gdiplus::Color(255, 200, 200, 200);
-        }
-    }
-    
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-    
-    float scale = size / 24.0f;
-    float fx = (float)x - size / 2.0f;
-    float fy = (float)y - size / 2.0f;
-    
-    // Apply translation and scale to map 24x24 SVG to icon size
-    graphics.TranslateTransform(fx, fy);
-    graphics.ScaleTransform(scale, scale);
-    
-    Gdiplus::SolidBrush brush(color);
-    
-    // SVG Path: M10.59 9.17L5.41 4 4 5.41l5.17 5.17 1.42-1.41z
-    //           M14.5 4l2.04 2.04L4 18.59 5.41 20 17.96 7.46 20 9.5V4h-5.5z
-    //           m.33 9.41l-1.41 1.41 3.13 3.13L14.5 20H20v-5.5l-2.04 2.04-3.13-3.13z
-    
-    Gdiplus::GraphicsPath path;
-    
-    // First shape: diagonal cross section (top-left area)
-    path.StartFigure();
-    path.AddLine(10.59f, 9.17f, 5.41f, 4.0f);
-    path.AddLine(5.41f, 4.0f, 4.0f, 5.41f);
-    path.AddLine(4.0f, 5.41f, 9.17f, 10.58f);
-    path.CloseFigure();
-    
-    // Second shape: main X with top-right arrowhead
-    path.StartFigure();
-    path.AddLine(14.5f, 4.0f, 16.54f, 6.04f);
-    path.AddLine(16.54f, 6.04f, 4.0f, 18.59f);
-    path.AddLine(4.0f, 18.59f, 5.41f, 20.0f);
-    path.AddLine(5.41f, 20.0f, 17.96f, 7.46f);
-    path.AddLine(17.96f, 7.46f, 20.0f, 9.5f);
-    path.AddLine(20.0f, 9.5f, 20.0f, 4.0f);
-    path.AddLine(20.0f, 4.0f, 14.5f, 4.0f);
-    path.CloseFigure();
-    
-    // Third shape: bottom-right arrowhead
-    path.StartFigure();
-    path.AddLine(14.83f, 13.41f, 13.42f, 14.82f);
-    path.AddLine(13.42f, 14.82f, 16.55f, 17.95f);
-    path.AddLine(16.55f, 17.95f, 14.5f, 20.0f);
-    path.AddLine(14.5f, 20.0f, 20.0f, 20.0f);
-    path.AddLine(20.0f, 20.0f, 20.0f, 14.5f);
-    path.AddLine(20.0f, 14.5f, 17.96f, 16.54f);
-    path.AddLine(17.96f, 16.54f, 14.83f, 13.41f);
-    path.CloseFigure();
-    
-    graphics.FillPath(&brush, &path);
-    
-    graphics.ResetTransform();
-}
-
-void control_panel::draw_repeat_icon(HDC hdc, int x, int y, int size) {
-    if (m_hovered_button == BTN_REPEAT) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-    
-    bool is_active = (m_repeat_mode > 0);
-    // Active: use full icon color, Inactive: use dimmed version
-    Gdiplus::Color color;
-    if (is_active) {
-        color = Gdiplus::Color(255, GetRValue(m_icon_color), GetGValue(m_icon_color), GetBValue(m_icon_color));
-    } else {
-        // Dimmed inactive color - use lighter color in light mode for better contrast
-        if (m_is_dark_mode) {
-            color = Gdiplus::Color(255, GetRValue(m_text_dim_color), GetGValue(m_text_dim_color), GetBValue(m_text_dim_color));
-        } else {
-            // Light mode: use much lighter gray so inactive icons are clearly faded
-            color = Gdiplus::Color(255, 200, 200, 200);
-        }
-    }
-    
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-    
-    float scale = size / 24.0f;
-    float fx = (float)x - size / 2.0f;
-    float fy = (float)y - size / 2.0f;
-    
-    // Apply translation and scale to map 24x24 SVG to icon size
-    graphics.TranslateTransform(fx, fy);
-    graphics.ScaleTransform(scale, scale);
-    
-    Gdiplus::SolidBrush brush(color);
-    
-    // SVG Path: M7 7h10v3l4-4-4-4v3H5v6h2V7zm10 10H7v-3l-4 4 4 4v-3h12v-6h-2v4z
-    // This is a rectangular repeat icon with arrows on right and left
-    
-    Gdiplus::GraphicsPath path;
-    
-    // First shape: Top arrow (pointing right)
-    // M7 7 h10 v3 l4-4 -4-4 v3 H5 v6 h2 V7 z
-    path.StartFigure();
-    path.AddLine(7.0f, 7.0f, 17.0f, 7.0f);   // h10
-    path.AddLine(17.0f, 7.0f, 17.0f, 10.0f); // v3
-    path.AddLine(17.0f, 10.0f, 21.0f, 6.0f); // l4-4 (arrow tip)
-    path.AddLine(21.0f, 6.0f, 17.0f, 2.0f);  // -4-4
-    path.AddLine(17.0f, 2.0f, 17.0f, 5.0f);  // v3
-    path.AddLine(17.0f, 5.0f, 5.0f, 5.0f);   // H5
-    path.AddLine(5.0f, 5.0f, 5.0f, 11.0f);   // v6
-    path.AddLine(5.0f, 11.0f, 7.0f, 11.0f);  // h2
-    path.AddLine(7.0f, 11.0f, 7.0f, 7.0f);   // V7
-    path.CloseFigure();
-    
-    // Second shape: Bottom arrow (pointing left)
-    // m10 10 (relative from last point = 17,17) -> actually starts at 17,17
-    // H7 v-3 l-4 4 4 4 v-3 h12 v-6 h-2 v4 z
-    path.StartFigure();
-    path.AddLine(17.0f, 17.0f, 7.0f, 17.0f);   // H7
-    path.AddLine(7.0f, 17.0f, 7.0f, 14.0f);    // v-3
-    path.AddLine(7.0f, 14.0f, 3.0f, 18.0f);    // l-4 4 (arrow tip)
-    path.AddLine(3.0f, 18.0f, 7.0f, 22.0f);    // 4 4
-    path.AddLine(7.0f, 22.0f, 7.0f, 19.0f);    // v-3
-    path.AddLine(7.0f, 19.0f, 19.0f, 19.0f);   // h12
-    path.AddLine(19.0f, 19.0f, 19.0f, 13.0f);  // v-6
-    path.AddLine(19.0f, 13.0f, 17.0f, 13.0f);  // h-2
-    path.AddLine(17.0f, 13.0f, 17.0f, 17.0f);  // v4
-    path.CloseFigure();
-    
-    // If Track Repeat (Mode 2), add the "1" in the center from repeat_one SVG
-    // SVG path segment: m-4-2V9h-1l-2 1v1h1.5v4H13z (relative to 17,17 = absolute 13,15)
-    if (m_repeat_mode == 2) {
-        path.StartFigure();
-        path.AddLine(13.0f, 15.0f, 13.0f, 9.0f);   // V9
-        path.AddLine(13.0f, 9.0f, 12.0f, 9.0f);    // h-1
-        path.AddLine(12.0f, 9.0f, 10.0f, 10.0f);   // l-2 1
-        path.AddLine(10.0f, 10.0f, 10.0f, 11.0f);  // v1
-        path.AddLine(10.0f, 11.0f, 11.5f, 11.0f);  // h1.5
-        path.AddLine(11.5f, 11.0f, 11.5f, 15.0f);  // v4
-        path.AddLine(11.5f, 15.0f, 13.0f, 15.0f);  // H13
-        path.CloseFigure();
-    }
-    
-    graphics.FillPath(&brush, &path);
-    
-    graphics.ResetTransform();
-}
-
-void control_panel::draw_up_arrow(HDC hdc, int x, int y, int size) {
-    // Material Design Arrow Drop Up
-    int half_size = size / 2;
-    
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-    
-    Gdiplus::Point triangle[3];
-    triangle[0] = Gdiplus::Point(x, y - half_size/2);                 // Top point
-    triangle[1] = Gdiplus::Point(x - half_size, y + half_size/2);     // Bottom left
-    triangle[2] = Gdiplus::Point(x + half_size, y + half_size/2);     // Bottom right
-    
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, 255, 255, 255));
-    // Optional outline
-    Gdiplus::Pen pen(Gdiplus::Color(255, 255, 255, 255), 1.0f);
-    
-    graphics.FillPolygon(&brush, triangle, 3);
-    graphics.DrawPolygon(&pen, triangle, 3);
-}
-
-void control_panel::draw_down_arrow(HDC hdc, int x, int y, int size) {
-    // Material Design Arrow Drop Down
-    int half_size = size / 2;
-    
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-    
-    Gdiplus::Point triangle[3];
-    triangle[0] = Gdiplus::Point(x, y + half_size/2);                 // Bottom point
-    triangle[1] = Gdiplus::Point(x - half_size, y - half_size/2);     // Top left
-    triangle[2] = Gdiplus::Point(x + half_size, y - half_size/2);     // Top right
-    
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, 255, 255, 255));
-    Gdiplus::Pen pen(Gdiplus::Color(255, 255, 255, 255), 1.0f);
-    
-    graphics.FillPolygon(&brush, triangle, 3);
-    graphics.DrawPolygon(&pen, triangle, 3);
-}
-
-void control_panel::draw_up_arrow_with_opacity(HDC hdc, int x, int y, int size, int opacity) {
-    // Material Design Up Arrow with opacity
-    int half_size = size / 2;
-    
-    POINT triangle[3];
-    triangle[0] = {x, y - half_size/2};                 // Top point
-    triangle[1] = {x - half_size, y + half_size/2};     // Bottom left
-    triangle[2] = {x + half_size, y + half_size/2};     // Bottom right
-    
-    HBRUSH brush = CreateSolidBrush(RGB(opacity, opacity, opacity));
-    HBRUSH old_brush = (HBRUSH)SelectObject(hdc, brush);
-    HPEN pen = CreatePen(PS_SOLID, 1, RGB(opacity, opacity, opacity));
-    HPEN old_pen = (HPEN)SelectObject(hdc, pen);
-    
-    Polygon(hdc, triangle, 3);
-    
-    SelectObject(hdc, old_pen);
-    SelectObject(hdc, old_brush);
-    DeleteObject(pen);
-    DeleteObject(brush);
-}
-
-void control_panel::draw_down_arrow_with_opacity(HDC hdc, int x, int y, int size, int opacity) {
-    // Material Design Down Arrow with opacity
-    int half_size = size / 2;
-    
-    POINT triangle[3];
-    triangle[0] = {x, y + half_size/2};                 // Bottom point
-    triangle[1] = {x - half_size, y - half_size/2};     // Top left
-    triangle[2] = {x + half_size, y - half_size/2};     // Top right
-    
-    HBRUSH brush = CreateSolidBrush(RGB(opacity, opacity, opacity));
-    HBRUSH old_brush = (HBRUSH)SelectObject(hdc, brush);
-    HPEN pen = CreatePen(PS_SOLID, 1, RGB(opacity, opacity, opacity));
-    HPEN old_pen = (HPEN)SelectObject(hdc, pen);
-    
-    Polygon(hdc, triangle, 3);
-    
-    SelectObject(hdc, old_pen);
-    SelectObject(hdc, old_brush);
-    DeleteObject(pen);
-    DeleteObject(brush);
-}
-
-void control_panel::draw_roll_dots(HDC hdc, int x, int y, int size) {
-    // Draw six dots in two columns (3 rows x 2 columns)
-    int dot_radius = size / 8;
-    int spacing = size / 4;
-    
-    HBRUSH brush = CreateSolidBrush(RGB(180, 180, 180));
-    HBRUSH old_brush = (HBRUSH)SelectObject(hdc, brush);
-    
-    // Draw 6 dots in 2x3 grid
-    for (int row = 0; row < 3; row++) {
-        for (int col = 0; col < 2; col++) {
-            int dot_x = x + (col * spacing) - spacing/2;
-            int dot_y = y + (row * spacing) - spacing;
-            
-            Ellipse(hdc, 
-                dot_x - dot_radius, dot_y - dot_radius,
-                dot_x + dot_radius, dot_y + dot_radius);
-        }
-    }
-    
-    SelectObject(hdc, old_brush);
-    DeleteObject(brush);
-}
-
-void control_panel::draw_volume_icon(HDC hdc, int x, int y, int size) {
-    // Material Design Speaker Icon - Screenshot accurate
-    
-    // Normalize colors
-    HBRUSH brush = CreateSolidBrush(RGB(255, 255, 255));
-    HBRUSH old_brush = (HBRUSH)SelectObject(hdc, brush);
-    HPEN pen = CreatePen(PS_SOLID, 1, RGB(255, 255, 255));
-    HPEN old_pen = (HPEN)SelectObject(hdc, pen);
-    
-    // Speaker is drawn to the left of x, waves to the right
-    // Center point x,y is roughly the gap between speaker and waves
-    
-    // 1. Speaker Body
-    // Rect part
-    int body_h = size * 3 / 8; // ~37% height
-    int body_w = size / 4;
-    int flare_w = size / 4;
-    int speaker_tip_x = x - 2; // Tip of the speaker cone
-    
-    POINT speaker[6];
-    speaker[0] = {speaker_tip_x - flare_w - body_w, y - body_h/2}; // Top-left rect
-    speaker[1] = {speaker_tip_x - flare_w, y - body_h/2};          // Top-right rect
-    speaker[2] = {speaker_tip_x, y - size/2 + 2};                  // Top flare tip
-    speaker[3] = {speaker_tip_x, y + size/2 - 2};                  // Bottom flare tip
-    speaker[4] = {speaker_tip_x - flare_w, y + body_h/2};          // Bottom-right rect
-    speaker[5] = {speaker_tip_x - flare_w - body_w, y + body_h/2}; // Bottom-left rect
-    
-    Polygon(hdc, speaker, 6);
-    
-    // 2. Sound Waves
-    HPEN wave_pen = CreatePen(PS_SOLID, 2, RGB(255, 255, 255)); // 2px thickness for visibility
-    SelectObject(hdc, wave_pen);
-    HBRUSH null_brush = (HBRUSH)GetStockObject(NULL_BRUSH);
-    SelectObject(hdc, null_brush); // Don't fill arcs
-    
-    int wave_center_x = speaker_tip_x; // Waves emanate from speaker tip
-    
-    // Inner wave
-    int r1 = size / 3;
-    // Bounding box for arc
-    int r1_left = wave_center_x - r1;
-    int r1_top = y - r1;
-    int r1_right = wave_center_x + r1;
-    int r1_bottom = y + r1;
-    // Radial points for 45 degree start/end
-    int offset1 = r1 * 7 / 10; // ~sin(45)
-    Arc(hdc, r1_left, r1_top, r1_right, r1_bottom, 
-        wave_center_x + offset1, y - offset1,  // Start: Top Right
-        wave_center_x + offset1, y + offset1); // End: Bottom Right
-        
-    // Outer wave
-    int r2 = size * 2 / 3;
-    int r2_left = wave_center_x - r2;
-    int r2_top = y - r2;
-    int r2_right = wave_center_x + r2;
-    int r2_bottom = y + r2;
-    int offset2 = r2 * 7 / 10;
-    Arc(hdc, r2_left, r2_top, r2_right, r2_bottom, 
-        wave_center_x + offset2, y - offset2,
-        wave_center_x + offset2, y + offset2);
-
-    SelectObject(hdc, old_pen);
-    SelectObject(hdc, old_brush);
-    DeleteObject(pen);
-    DeleteObject(wave_pen);
-    DeleteObject(brush);
-}
-
-void control_panel::draw_volume_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity) {
-    // Material Design Volume Up with opacity - Screenshot accurate
-    
-    int color_value = 32 + ((255 - 32) * opacity) / 100;
-    
-    HBRUSH brush = CreateSolidBrush(RGB(color_value, color_value, color_value));
-    HBRUSH old_brush = (HBRUSH)SelectObject(hdc, brush);
-    HPEN pen = CreatePen(PS_SOLID, 1, RGB(color_value, color_value, color_value));
-    HPEN old_pen = (HPEN)SelectObject(hdc, pen);
-    
-    // 1. Speaker Body
-    int body_h = size * 3 / 8;
-    int body_w = size / 4;
-    int flare_w = size / 4;
-    int speaker_tip_x = x - 2;
-    
-    POINT speaker[6];
-    speaker[0] = {speaker_tip_x - flare_w - body_w, y - body_h/2}; 
-    speaker[1] = {speaker_tip_x - flare_w, y - body_h/2};          
-    speaker[2] = {speaker_tip_x, y - size/2 + 2};                  
-    speaker[3] = {speaker_tip_x, y + size/2 - 2};                  
-    speaker[4] = {speaker_tip_x - flare_w, y + body_h/2};          
-    speaker[5] = {speaker_tip_x - flare_w - body_w, y + body_h/2}; 
-    
-    Polygon(hdc, speaker, 6);
-    
-    // 2. Sound Waves
-    HPEN wave_pen = CreatePen(PS_SOLID, 2, RGB(color_value, color_value, color_value));
-    SelectObject(hdc, wave_pen);
-    HBRUSH null_brush = (HBRUSH)GetStockObject(NULL_BRUSH);
-    SelectObject(hdc, null_brush);
-    
-    int wave_center_x = speaker_tip_x;
-
-    // Inner wave
-    int r1 = size / 3;
-    int r1_left = wave_center_x - r1;
-    int r1_top = y - r1;
-    int r1_right = wave_center_x + r1;
-    int r1_bottom = y + r1;
-    int offset1 = r1 * 7 / 10;
-    Arc(hdc, r1_left, r1_top, r1_right, r1_bottom, 
-        wave_center_x + offset1, y - offset1,
-        wave_center_x + offset1, y + offset1);
-        
-    // Outer wave
-    int r2 = size * 2 / 3;
-    int r2_left = wave_center_x - r2;
-    int r2_top = y - r2;
-    int r2_right = wave_center_x + r2;
-    int r2_bottom = y + r2;
-    int offset2 = r2 * 7 / 10;
-    Arc(hdc, r2_left, r2_top, r2_right, r2_bottom, 
-        wave_center_x + offset2, y - offset2,
-        wave_center_x + offset2, y + offset2);
-
-    SelectObject(hdc, old_pen);
-    SelectObject(hdc, old_brush);
-    DeleteObject(pen);
-    DeleteObject(wave_pen);
-    DeleteObject(brush);
-}
-
-void control_panel::draw_close_icon(HDC hdc, int x, int y, int size) {
-    // Material Design Close (X)
-    int half_size = size / 2;
-    int stroke_width = 2; // Thicker clearer stroke
-    
-    HPEN pen = CreatePen(PS_SOLID, stroke_width, RGB(255, 255, 255));
-    HPEN old_pen = (HPEN)SelectObject(hdc, pen);
-    
-    MoveToEx(hdc, x - half_size, y - half_size, nullptr);
-    LineTo(hdc, x + half_size, y + half_size);
-    MoveToEx(hdc, x + half_size, y - half_size, nullptr);
-    LineTo(hdc, x - half_size, y + half_size);
-    DeleteObject(pen);
-}
-
-// Helper to draw collapse triangle
-void control_panel::draw_collapse_triangle(HDC hdc, int x, int y, int size, int opacity) {
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-    
-    // Simulate opacity
-    int alpha = (255 * opacity) / 100;
-    // Ensure minimum visibility
-    if (alpha < 50) alpha = 50; 
-    
-    // Use black for light mode, white for dark mode
-    int color_value = m_is_dark_mode ? 255 : 0;
-    Gdiplus::SolidBrush brush(Gdiplus::Color(alpha, color_value, color_value, color_value));
-    
-    // Triangle pointing diagonally down-left from top-right corner
-    // Or just a standard triangle pointing down or left?
-    // "Triangle in the top right corner... pointing inwards" usually means:
-    //  Right angle at the top-right corner? Or an equilateral pointing South-West?
-    // Let's do a right-triangle in the corner.
-    // P1: (x, y) - Corner
-    // P2: (x - size, y) - Top edge
-    // P3: (x, y + size) - Right edge
-    // Actually, user said "small white triangle... to change to undocked".
-    // A simple arrow-like triangle pointing "restore" might be better.
-    // Let's stick to a simple small triangle pointing inwards (bottom-left).
-    
-    int half = size / 2;
-    
-    // Right triangle in bottom-right corner
-    Gdiplus::Point triangle[3];
-    triangle[0] = Gdiplus::Point(x + half, y - half); // Top-Right
-    triangle[1] = Gdiplus::Point(x + half, y + half); // Bottom-Right
-    triangle[2] = Gdiplus::Point(x - half, y + half); // Bottom-Left
-    
-    graphics.FillPolygon(&brush, triangle, 3);
-}
-
-// Helper to draw close icon
-void control_panel::draw_close_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity) {
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-    
-    // Simulate opacity
-    int alpha = (255 * opacity) / 100;
-    if (alpha < 50) alpha = 50; 
-    
-    int color_value = m_is_dark_mode ? 255 : 0;
-    Gdiplus::Pen pen(Gdiplus::Color(alpha, color_value, color_value, color_value), 2.0f);
-    
-    int half_size = size / 2;
-    // Draw X
-    graphics.DrawLine(&pen, x - half_size, y - half_size, x + half_size, y + half_size);
-    graphics.DrawLine(&pen, x + half_size, y - half_size, x - half_size, y + half_size);
-}
-
-// Opacity-based icon drawing for button fade effect
-void control_panel::draw_play_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity) {
-    if (m_hovered_button == BTN_PLAYPAUSE) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-
-    int style = get_alternative_icons_style();
-    if (style == 1) {
-        int val = m_is_dark_mode ? (32 + ((255 - 32) * opacity) / 100) : (32 - (32 * opacity) / 100);
-        COLORREF color = RGB(val, val, val);
-        draw_alternate_play_icon(hdc, x, y, size, color);
-        return;
-    } else if (style == 2) {
-        int val = m_is_dark_mode ? (32 + ((255 - 32) * opacity) / 100) : (32 - (32 * opacity) / 100);
-        COLORREF color = RGB(val, val, val);
-        draw_style3_play_icon(hdc, x, y, size, color);
-        return;
-    }
-
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    // Determine circle and icon colors based on theme
-    int circle_r, circle_g, circle_b;
-    int icon_r, icon_g, icon_b;
-    
-    if (m_is_dark_mode) {
-        // Dark mode: fade circle from dark grey (32) to white (255)
-        int bg_val = 32 + ((255 - 32) * opacity) / 100;
-        circle_r = circle_g = circle_b = bg_val;
-        icon_r = icon_g = icon_b = 0; // Black icon
-    } else {
-        // Light mode (Undocked): fade circle from grey (32) to black (0)
-        int bg_val = 32 - (32 * opacity) / 100;
-        circle_r = circle_g = circle_b = bg_val;
-        icon_r = icon_g = icon_b = 255; // White icon
-    }
-    
-    // Draw circle
-    int radius = size / 2;
-    Gdiplus::SolidBrush bg_brush(Gdiplus::Color(255, circle_r, circle_g, circle_b));
-    graphics.FillEllipse(&bg_brush, x - radius, y - radius, size, size);
-    
-    // Draw icon
-    int icon_height = size * 4 / 10;
-    int half_icon = icon_height / 2;
-    int icon_width = icon_height; 
-    int center_offset_x = icon_width / 8;
-    
-    Gdiplus::Point triangle[3];
-    triangle[0] = Gdiplus::Point(x - icon_width/2 + center_offset_x, y - half_icon);
-    triangle[1] = Gdiplus::Point(x - icon_width/2 + center_offset_x, y + half_icon);
-    triangle[2] = Gdiplus::Point(x + icon_width/2 + center_offset_x, y);
-    
-    Gdiplus::SolidBrush icon_brush(Gdiplus::Color(255, icon_r, icon_g, icon_b)); 
-    graphics.FillPolygon(&icon_brush, triangle, 3);
-}
-
-void control_panel::draw_pause_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity) {
-    if (m_hovered_button == BTN_PLAYPAUSE) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-
-    int style = get_alternative_icons_style();
-    if (style == 1) {
-        int val = m_is_dark_mode ? (32 + ((255 - 32) * opacity) / 100) : (32 - (32 * opacity) / 100);
-        COLORREF color = RGB(val, val, val);
-        draw_alternate_pause_icon(hdc, x, y, size, color);
-        return;
-    } else if (style == 2) {
-        int val = m_is_dark_mode ? (32 + ((255 - 32) * opacity) / 100) : (32 - (32 * opacity) / 100);
-        COLORREF color = RGB(val, val, val);
-        draw_style3_pause_icon(hdc, x, y, size, color);
-        return;
-    }
-
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-    
-    // Determine circle and icon colors based on theme
-    int circle_r, circle_g, circle_b;
-    int icon_r, icon_g, icon_b;
-    
-    if (m_is_dark_mode) {
-        // Dark mode: fade circle from dark grey (32) to white (255)
-        int bg_val = 32 + ((255 - 32) * opacity) / 100;
-        circle_r = circle_g = circle_b = bg_val;
-        icon_r = icon_g = icon_b = 0; // Black icon
-    } else {
-        // Light mode (Undocked): fade circle from grey (32) to black (0)
-        int bg_val = 32 - (32 * opacity) / 100;
-        circle_r = circle_g = circle_b = bg_val;
-        icon_r = icon_g = icon_b = 255; // White icon
-    }
-    
-    // Background circle
-    int radius = size / 2;
-    Gdiplus::SolidBrush bg_brush(Gdiplus::Color(255, circle_r, circle_g, circle_b));
-    graphics.FillEllipse(&bg_brush, x - radius, y - radius, size, size);
-    
-    // Bars
-    int icon_height = size * 4 / 10;
-    int half_icon = icon_height / 2;
-    int bar_width = icon_height / 3;
-    int gap = icon_height / 3;
-    int offset = gap / 2;
-    
-    Gdiplus::SolidBrush icon_brush(Gdiplus::Color(255, icon_r, icon_g, icon_b));
-    graphics.FillRectangle(&icon_brush, x - offset - bar_width, y - half_icon, bar_width, icon_height);
-    graphics.FillRectangle(&icon_brush, x + offset, y - half_icon, bar_width, icon_height);
-}
-
-void control_panel::draw_previous_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity) {
-    if (m_hovered_button == BTN_PREV) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    // Solid filled style (Triangle + Bar)
-    int color_value = 32 + ((200 - 32) * opacity) / 100; 
-    
-    int half_size = size / 2;
-    int icon_h = size * 6 / 10; 
-    int bar_width = 3; 
-    int gap = 2; 
-
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, color_value, color_value, color_value));
-    
-    // Bar on LEFT
-    graphics.FillRectangle(&brush, x - icon_h/2, y - icon_h/2, bar_width, icon_h);
-    
-    // Triangle pointing left
-    int tri_start_x = x - icon_h/2 + bar_width + gap;
-    Gdiplus::Point triangle[3];
-    triangle[0] = Gdiplus::Point(x + icon_h/2, y - icon_h/2);   // Top right
-    triangle[1] = Gdiplus::Point(x + icon_h/2, y + icon_h/2);   // Bottom right
-    triangle[2] = Gdiplus::Point(tri_start_x, y);               // Left point
-    
-    graphics.FillPolygon(&brush, triangle, 3);
-}
-
-void control_panel::draw_next_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity) {
-    if (m_hovered_button == BTN_NEXT) {
-        draw_hover_circle(hdc, x, y, size);
-    }
-    
-    Gdiplus::Graphics graphics(hdc);
-    graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    // Solid filled style (Triangle + Bar)
-    int color_value = 32 + ((200 - 32) * opacity) / 100;
-    
-    int icon_h = size * 6 / 10;
-    int bar_width = 3;
-    int gap = 2;
-    
-    Gdiplus::SolidBrush brush(Gdiplus::Color(255, color_value, color_value, color_value));
-    
-    // Triangle pointing right
-    int tri_start_x = x - icon_h/2; 
-    Gdiplus::Point triangle[3];
-    triangle[0] = Gdiplus::Point(tri_start_x, y - icon_h/2);     // Top left
-    triangle[1] = Gdiplus::Point(tri_start_x, y + icon_h/2);     // Bottom left
-    triangle[2] = Gdiplus::Point(tri_start_x + icon_h - bar_width - gap, y); // Right point
-    
-    graphics.FillPolygon(&brush, triangle, 3);
-    
-    // Bar on RIGHT
-    int bar_x = tri_start_x + icon_h - bar_width;
-    graphics.FillRectangle(&brush, bar_x, y - icon_h/2, bar_width, icon_h);
-}
-
-
-// Font management methods
-void control_panel::load_fonts() {
-    cleanup_fonts();
-    
-    // Select fonts based on current display mode
-    if (m_is_artwork_expanded) {
-        // Expanded artwork mode
-        if (get_expanded_use_artist_custom_font()) {
-            LOGFONT artist_lf = get_expanded_artist_font();
-            m_artist_font = CreateFontIndirect(&artist_lf);
-        } else {
-            LOGFONT artist_lf = get_default_font(true, 9);
-            m_artist_font = CreateFontIndirect(&artist_lf);
-        }
-        if (get_expanded_use_track_custom_font()) {
-            LOGFONT track_lf = get_expanded_track_font();
-            m_track_font = CreateFontIndirect(&track_lf);
-        } else {
-            LOGFONT track_lf = get_default_font(false, 11);
-            m_track_font = CreateFontIndirect(&track_lf);
-        }
-    } else if (m_is_compact_mode) {
-        // Compact mode
-        if (get_compact_use_artist_custom_font()) {
-            LOGFONT artist_lf = get_compact_artist_font();
-            m_artist_font = CreateFontIndirect(&artist_lf);
-        } else {
-            LOGFONT artist_lf = get_default_font(true, 9);
-            m_artist_font = CreateFontIndirect(&artist_lf);
-        }
-        if (get_compact_use_track_custom_font()) {
-            LOGFONT track_lf = get_compact_track_font();
-            m_track_font = CreateFontIndirect(&track_lf);
-        } else {
-            LOGFONT track_lf = get_default_font(false, 11);
-            m_track_font = CreateFontIndirect(&track_lf);
+    if (changes & settings_change_appearance) {
+        apply_window_corner_preference();
+        // Turning the waveform off stops any decode still running for it
+        if (!get_settings().waveform_seekbar) {
+            set_waveform(nullptr);
+            waveform_cache::get_instance().cancel();
         }
-    } else if (m_is_undocked) {
-        // Undocked mode
-        if (get_undocked_use_artist_custom_font()) {
-            LOGFONT artist_lf = get_undocked_artist_font();
-            m_artist_font = CreateFontIndirect(&artist_lf);
-        } else {
-            LOGFONT artist_lf = get_default_font(true, 9);
-            m_artist_font = CreateFontIndirect(&artist_lf);
-        }
-        if (get_undocked_use_track_custom_font()) {
-            LOGFONT track_lf = get_undocked_track_font();
-            m_track_font = CreateFontIndirect(&track_lf);
-        } else {
-            LOGFONT track_lf = get_default_font(false, 11);
-            m_track_font = CreateFontIndirect(&track_lf);
-        }
-    } else {
-        // Docked mode (default)
-        if (get_cp_use_artist_custom_font()) {
-            LOGFONT artist_lf = get_cp_artist_font();
-            m_artist_font = CreateFontIndirect(&artist_lf);
-        } else {
-            LOGFONT artist_lf = get_default_font(true, 9);
-            m_artist_font = CreateFontIndirect(&artist_lf);
-        }
-        if (get_cp_use_track_custom_font()) {
-            LOGFONT track_lf = get_cp_track_font();
-            m_track_font = CreateFontIndirect(&track_lf);
-        } else {
-            LOGFONT track_lf = get_default_font(false, 11);
-            m_track_font = CreateFontIndirect(&track_lf);
-        }
-    }
-    
-    // Load timer font (shared across all modes except Expanded)
-    if (get_timer_use_custom_font()) {
-        LOGFONT timer_lf = get_timer_font();
-        m_timer_font = CreateFontIndirect(&timer_lf);
-    } else {
-        LOGFONT timer_lf = get_default_font(true, 9); // 9pt like artist
-        m_timer_font = CreateFontIndirect(&timer_lf);
-    }
-}
-
-void control_panel::cleanup_fonts() {
-    if (m_artist_font) {
-        DeleteObject(m_artist_font);
-        m_artist_font = nullptr;
-    }
-    if (m_track_font) {
-        DeleteObject(m_track_font);
-        m_track_font = nullptr;
-    }
-    if (m_timer_font) {
-        DeleteObject(m_timer_font);
-        m_timer_font = nullptr;
+        sync_spectrum_timer();
+        sync_cover_animation();
     }
-}
-
-void control_panel::on_settings_changed() {
-    // Reload fonts when settings change
-    load_fonts();
-    
-    // Update theme colors based on settings
-    update_theme_colors();
-    
-    // Apply window corner preference
-    apply_window_corner_preference();
     
     // Re-evaluate title & artist format scripts for the currently playing track
-    update_track_info();
+    if (changes & settings_change_formats) {
+        update_track_info();
+    }
     
     // Reload MiniPlayer mode size configuration
-    int undocked_w = get_miniplayer_undocked_width();
-    int undocked_h = get_miniplayer_undocked_height();
-    int compact_w = get_miniplayer_compact_width();
-    int compact_h = get_miniplayer_compact_height();
-    int expanded_s = get_miniplayer_expanded_size();
+    const tray_settings& settings = get_settings();
+    int undocked_w = settings.undocked_width;
+    int undocked_h = settings.undocked_height;
+    int compact_w = settings.compact_width;
+    int compact_h = settings.compact_height;
+    int expanded_s = settings.expanded_size;
 
     // Only resize the currently-visible MiniPlayer if its mode-specific size configuration
     // actually changed (compared against the last-applied config). A settings change unrelated
@@ -2702,14 +1610,19 @@ void control_panel::on_settings_changed() {
         m_saved_expanded_height = expanded_s;
     }
 
-    // Force the track title & artist tickers to re-evaluate and repaint if visible
-    m_ticker_title.reset();
-    m_artist_ticker_title.reset();
-    m_ticker_offset = 0;
-    m_artist_ticker_offset = 0;
+    // Force the track title & artist tickers to re-measure if their text, font or room changed
+    if (changes & (settings_change_fonts | settings_change_formats | settings_change_sizes |
+                   settings_change_ticker | settings_change_appearance)) {
+        m_ticker_title.reset();
+        m_artist_ticker_title.reset();
+        m_ticker_offset = 0;
+        m_artist_ticker_offset = 0;
+    }
 
     if (m_visible && m_control_window) {
         InvalidateRect(m_control_window, nullptr, TRUE);
+    } else {
+        schedule_prewarm();
     }
 }
 
@@ -2725,12 +1638,12 @@ bool control_panel::detect_foobar_dark_mode() {
 }
 
 void control_panel::update_theme_colors() {
-    int bg_style = get_background_style(); // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
+    int bg_style = get_settings().background_style; // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
     if (bg_style != 0) {
         // Light mode has no effect for Artwork Colors or Blurred Artwork
         m_is_dark_mode = true;
     } else {
-        int theme_mode = get_theme_mode();
+        int theme_mode = get_settings().theme_mode;
         
         // Determine if we should use dark mode
         if (theme_mode == 0) {
@@ -2774,27 +1687,58 @@ void control_panel::apply_window_corner_preference() {
     InvalidateRect(m_control_window, nullptr, TRUE);
 }
 
-// Immediately re-render and composite the layered window with the current mode's content.
-// The window is always WS_EX_LAYERED, so its visible surface is whatever UpdateLayeredWindow
-// last pushed. Calling this synchronously after showing the panel (rather than waiting for the
-// asynchronous WM_PAINT) prevents a stale frame (e.g. the previous MiniPlayer layout) from
-// flashing over the docked control panel when it re-opens.
-void control_panel::composite_layered_content() {
-    if (!m_control_window) return;
+bool control_panel::ensure_surface(layered_surface& surface, int width, int height) {
+    if (surface.bitmap && surface.width == width && surface.height == height) return true;
+    release_surface(surface);
+
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height; // Top-down DIB
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    HDC screen_dc = GetDC(nullptr);
+    surface.dc = CreateCompatibleDC(screen_dc);
+    surface.bitmap = CreateDIBSection(screen_dc, &bmi, DIB_RGB_COLORS, &surface.bits, nullptr, 0);
+    ReleaseDC(nullptr, screen_dc);
+    TRAY_PERF_COUNT_N(perf_counter_gdi_objects, 2);
+
+    if (!surface.dc || !surface.bitmap || !surface.bits) {
+        release_surface(surface);
+        return false;
+    }
+    surface.old_bitmap = (HBITMAP)SelectObject(surface.dc, surface.bitmap);
+    surface.width = width;
+    surface.height = height;
+    return true;
+}
+
+void control_panel::release_surface(layered_surface& surface) {
+    if (surface.dc) {
+        if (surface.old_bitmap) SelectObject(surface.dc, surface.old_bitmap);
+        DeleteDC(surface.dc);
+    }
+    if (surface.bitmap) DeleteObject(surface.bitmap);
+    surface = layered_surface();
+}
+
+// Render the current mode at the current client size into target as premultiplied ARGB.
+bool control_panel::render_layered_frame(layered_surface& target) {
+    if (!m_control_window) return false;
 
     RECT client_rect;
     GetClientRect(m_control_window, &client_rect);
     int width = client_rect.right - client_rect.left;
     int height = client_rect.bottom - client_rect.top;
 
-    if (width <= 0 || height <= 0) return;
-
-    HDC hdc = GetDC(m_control_window);
+    if (width <= 0 || height <= 0) return false;
+    if (!ensure_surface(m_paint_surface, width, height) || !ensure_surface(target, width, height)) return false;
+    m_spectrum_base_valid = false;  // Set again by paint_control_panel if it captures one
 
     // Double-buffering to eliminate flickering
-    HDC mem_dc = CreateCompatibleDC(hdc);
-    HBITMAP mem_bitmap = CreateCompatibleBitmap(hdc, width, height);
-    HBITMAP old_bitmap = (HBITMAP)SelectObject(mem_dc, mem_bitmap);
+    HDC mem_dc = m_paint_surface.dc;
 
     // Pre-clear memory buffer with parent window DC background or container theme color
     // so outer corners match surrounding light/dark/custom container layout seamlessly
@@ -2819,6 +1763,7 @@ void control_panel::composite_layered_content() {
             clear_color = (sys_win != CLR_INVALID) ? sys_win : RGB(255, 255, 255);
         }
         HBRUSH clear_brush = CreateSolidBrush(clear_color);
+        TRAY_PERF_COUNT(perf_counter_gdi_objects);
         FillRect(mem_dc, &client_rect, clear_brush);
         DeleteObject(clear_brush);
     }
@@ -2826,35 +1771,37 @@ void control_panel::composite_layered_content() {
     // Paint to off-screen buffer
     paint_control_panel(mem_dc);
 
-    // Create 32-bit ARGB DIBSection for per-pixel alpha compositing
-    BITMAPINFO bmi = {};
-    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth = width;
-    bmi.bmiHeader.biHeight = -height; // Top-down DIB
-    bmi.bmiHeader.biPlanes = 1;
-    bmi.bmiHeader.biBitCount = 32;
-    bmi.bmiHeader.biCompression = BI_RGB;
-
-    void* pvBits = nullptr;
-    HDC hdcScreen = GetDC(nullptr);
-    HDC alpha_dc = CreateCompatibleDC(hdcScreen);
-    HBITMAP alpha_bitmap = CreateDIBSection(alpha_dc, &bmi, DIB_RGB_COLORS, &pvBits, nullptr, 0);
-    HBITMAP old_alpha_bitmap = (HBITMAP)SelectObject(alpha_dc, alpha_bitmap);
+    finish_layered_frame(target, width, height);
+    return true;
+}
 
+// Copy the opaque frame in m_paint_surface into target and apply the corner alpha.
+void control_panel::finish_layered_frame(layered_surface& target, int width, int height) {
     // Copy opaque content into the ARGB surface
-    BitBlt(alpha_dc, 0, 0, width, height, mem_dc, 0, 0, SRCCOPY);
+    BitBlt(target.dc, 0, 0, width, height, m_paint_surface.dc, 0, 0, SRCCOPY);
+    GdiFlush(); // Finish GDI work before touching the pixels directly
 
     // Apply anti-aliased rounded-corner alpha mask
-    bool is_rounded = (get_miniplayer_border_style() == 1);
+    bool is_rounded = (get_settings().miniplayer_border_style == 1);
     if (is_rounded) {
-        apply_rounded_corner_alpha(pvBits, width, height, 12.0f);
-    } else if (pvBits) {
+        apply_rounded_corner_alpha(target.bits, width, height, 12.0f);
+    } else {
         // Square corners - fully opaque
-        BYTE* px = static_cast<BYTE*>(pvBits);
+        BYTE* px = static_cast<BYTE*>(target.bits);
         for (int i = 0; i < width * height; i++) {
             px[i * 4 + 3] = 255;
         }
     }
+}
+
+// Push a finished ARGB surface to the window at its current position.
+void control_panel::push_layered_frame(layered_surface& source) {
+    push_layered_frame(source, source.width, source.height);
+}
+
+// Push the top-left width x height region of source; the window takes that size.
+void control_panel::push_layered_frame(layered_surface& source, int width, int height) {
+    if (!m_control_window || !source.dc) return;
 
     // Composite with per-pixel alpha - the window is always WS_EX_LAYERED so
     // UpdateLayeredWindow is required in ALL modes (docked AND MiniPlayer);
@@ -2870,17 +1817,349 @@ void control_panel::composite_layered_content() {
     blend.BlendFlags = 0;
     blend.SourceConstantAlpha = 255;
     blend.AlphaFormat = AC_SRC_ALPHA;
-    UpdateLayeredWindow(m_control_window, hdcScreen, &ptDst, &size, alpha_dc, &ptSrc, 0, &blend, ULW_ALPHA);
-
-    // Cleanup
-    SelectObject(alpha_dc, old_alpha_bitmap);
-    DeleteObject(alpha_bitmap);
-    DeleteDC(alpha_dc);
-    SelectObject(mem_dc, old_bitmap);
-    DeleteObject(mem_bitmap);
-    DeleteDC(mem_dc);
+
+    HDC hdcScreen = GetDC(nullptr);
+    UpdateLayeredWindow(m_control_window, hdcScreen, &ptDst, &size, source.dc, &ptSrc, 0, &blend, ULW_ALPHA);
     ReleaseDC(nullptr, hdcScreen);
-    ReleaseDC(m_control_window, hdc);
+}
+
+// Move the window without touching its content. The surface on screen is the last one pushed,
+// so only the destination changes; SetWindowPos is the fallback if nothing was pushed yet.
+void control_panel::move_layered_window(int x, int y) {
+    if (!m_control_window) return;
+
+    POINT ptDst = { x, y };
+    if (!m_live_surface.dc ||
+        !UpdateLayeredWindow(m_control_window, nullptr, &ptDst, nullptr, nullptr, nullptr, 0, nullptr, 0)) {
+        SetWindowPos(m_control_window, nullptr, x, y, 0, 0,
+            SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOREDRAW);
+    }
+}
+
+// Catch up on paints that were deferred while the window was moving
+void control_panel::end_window_move() {
+    if (m_repaint_after_move && m_visible) {
+        composite_layered_content();
+    }
+    m_repaint_after_move = false;
+}
+
+// Immediately re-render and composite the layered window with the current mode's content.
+// The window is always WS_EX_LAYERED, so its visible surface is whatever UpdateLayeredWindow
+// last pushed. Calling this synchronously after showing the panel (rather than waiting for the
+// asynchronous WM_PAINT) prevents a stale frame (e.g. the previous MiniPlayer layout) from
+// flashing over the docked control panel when it re-opens.
+void control_panel::composite_layered_content() {
+    TRAY_PERF_SCOPE(perf_phase_composite);
+    TRAY_TRACE_SCOPE("paint", "composite_layered_content");
+    if (render_layered_frame(m_live_surface)) {
+        present_live_frame();
+        TRAY_PERF_COUNT(perf_counter_paints);
+    }
+}
+
+// Push m_live_surface, or while a crossfade runs, its blend with the snapshot being faded out
+void control_panel::present_live_frame() {
+    if (m_crossfade_active && compose_crossfade_frame()) {
+        push_layered_frame(m_crossfade_frame);
+        return;
+    }
+    push_layered_frame(m_live_surface);
+}
+
+// Snapshot the frame on screen as the start of a crossfade. Call before the content changes;
+// the new content arrives through the normal paint path. A fade already running restarts
+// from its current blend, so rapid changes never jump.
+void control_panel::begin_crossfade() {
+    DWORD duration = (DWORD)get_settings().artwork_crossfade;
+    if (duration == 0 || !m_control_window || !m_visible || m_render_throttle.is_throttled() ||
+        m_is_rolling_animation || is_moving_window()) {
+        return;
+    }
+
+    // The live surface is only what is on screen if it matches the window (a mode switch
+    // resizes the window before its first paint)
+    const layered_surface& shown = m_crossfade_active ? m_crossfade_frame : m_live_surface;
+    int width = shown.width;
+    int height = shown.height;
+    RECT client_rect;
+    GetClientRect(m_control_window, &client_rect);
+    if (!shown.bits || width <= 0 || height <= 0 ||
+        width != client_rect.right - client_rect.left || height != client_rect.bottom - client_rect.top) {
+        return;
+    }
+
+    // The only allocations of a fade, and only when the size differs from the previous one
+    if (!ensure_surface(m_crossfade_from, width, height) || !ensure_surface(m_crossfade_frame, width, height)) {
+        end_crossfade();
+        return;
+    }
+    memcpy(m_crossfade_from.bits, shown.bits, (size_t)width * height * 4);
+
+    TRAY_TRACE_INSTANT("paint", "crossfade begin");
+    m_crossfade_start = GetTickCount();
+    m_crossfade_duration = duration;
+    if (!m_crossfade_active) {
+        m_crossfade_active = true;
+        SetTimer(m_control_window, CROSSFADE_TIMER_ID, 16, nullptr); // ~60fps
+    }
+}
+
+// Blend the snapshot with the live frame at the current progress into m_crossfade_frame.
+// Both are premultiplied, so a per-channel lerp is exact; no GDI or GDI+ call is involved.
+bool control_panel::compose_crossfade_frame() {
+    TRAY_PERF_SCOPE(perf_phase_crossfade_frame);
+    int width = m_live_surface.width;
+    int height = m_live_surface.height;
+    if (!m_live_surface.bits || !m_crossfade_from.bits || width <= 0 || height <= 0) return false;
+
+    if (m_crossfade_from.width != width || m_crossfade_from.height != height) {
+        // The window changed size mid-fade (Expanded takes the new artwork's aspect ratio):
+        // rescale the snapshot once, then keep blending at the new size
+        if (!ensure_surface(m_crossfade_frame, width, height)) return false;
+        resample_cover_bgra(static_cast<const uint8_t*>(m_crossfade_from.bits), m_crossfade_from.width,
+            m_crossfade_from.height, m_crossfade_from.width * 4,
+            static_cast<uint8_t*>(m_crossfade_frame.bits), width, height, width * 4);
+        std::swap(m_crossfade_from, m_crossfade_frame);
+        if (!ensure_surface(m_crossfade_frame, width, height)) return false;
+    }
+
+    DWORD elapsed = GetTickCount() - m_crossfade_start;
+    float progress = m_crossfade_duration > 0 ? (float)elapsed / (float)m_crossfade_duration : 1.0f;
+    if (progress > 1.0f) progress = 1.0f;
+    progress = progress * progress * (3.0f - 2.0f * progress); // Smoothstep
+
+    crossfade_bgra(static_cast<const uint8_t*>(m_crossfade_from.bits), static_cast<const uint8_t*>(m_live_surface.bits),
+        static_cast<uint8_t*>(m_crossfade_frame.bits), (size_t)width * height, (unsigned)(progress * 256.0f + 0.5f));
+    return true;
+}
+
+void control_panel::update_crossfade() {
+    if (!m_crossfade_active) {
+        KillTimer(m_control_window, CROSSFADE_TIMER_ID);
+        return;
+    }
+    if (GetTickCount() - m_crossfade_start >= m_crossfade_duration || !m_visible ||
+        m_render_throttle.is_throttled() || m_is_rolling_animation) {
+        end_crossfade();
+        return;
+    }
+    // Moves keep the surface already on screen; the fade resumes with the next frame after
+    if (is_moving_window()) return;
+
+    if (compose_crossfade_frame()) {
+        push_layered_frame(m_crossfade_frame);
+    } else {
+        end_crossfade();
+    }
+}
+
+// Stop the fade and show the live frame as is. The surfaces are kept for the next fade.
+void control_panel::end_crossfade() {
+    if (!m_crossfade_active) return;
+    m_crossfade_active = false;
+    if (m_control_window) KillTimer(m_control_window, CROSSFADE_TIMER_ID);
+    if (m_visible && !m_is_rolling_animation && !is_moving_window() && !m_render_throttle.is_suspended() &&
+        m_live_surface.bits) {
+        push_layered_frame(m_live_surface);
+    }
+}
+
+bool control_panel::wants_cover_animation() const {
+    return m_control_window && m_visible && get_settings().animated_artwork &&
+        m_cover_animation.is_open() && !m_render_throttle.is_throttled();
+}
+
+// Stop the frame clock and free the decoded frames while nobody can see them. Nothing needs
+// starting here: the next paint of a visible panel restarts the stream at the frame it left.
+void control_panel::sync_cover_animation() {
+    if (wants_cover_animation()) return;
+    if (m_control_window) KillTimer(m_control_window, COVER_ANIMATION_TIMER_ID);
+    m_cover_animation.suspend();
+}
+
+// Frame of the animated cover for a paint, or null to draw the still cover
+HBITMAP control_panel::get_cover_animation_frame(int width, int height) {
+    if (!wants_cover_animation()) return nullptr;
+    m_cover_animation_drawn = true;
+    return m_cover_animation.get_frame(width, height);
+}
+
+// Show the next frame and wait out its delay
+void control_panel::update_cover_animation() {
+    if (!m_control_window) return;
+    KillTimer(m_control_window, COVER_ANIMATION_TIMER_ID);
+    // Moves and rolls keep the surface already on screen; hold the frame until they end
+    if (wants_cover_animation() && (is_moving_window() || m_is_rolling_animation)) {
+        SetTimer(m_control_window, COVER_ANIMATION_TIMER_ID, m_cover_animation.get_delay(), nullptr);
+        return;
+    }
+    // A layout that stopped drawing the cover (Up Next, cover hidden) has no use for frames
+    if (!wants_cover_animation() || !m_cover_animation_drawn) {
+        m_cover_animation.suspend();
+        return;
+    }
+    // Not decoded yet: on_cover_animation_ready() calls again once it is
+    if (!m_cover_animation.advance()) return;
+
+    m_cover_animation_drawn = false;
+    InvalidateRect(m_control_window, nullptr, FALSE);
+    SetTimer(m_control_window, COVER_ANIMATION_TIMER_ID, m_cover_animation.get_delay(), nullptr);
+}
+
+void control_panel::on_cover_animation_ready() {
+    if (!m_control_window) return;
+    if (!m_cover_animation.is_open()) {
+        // The stream failed; the still cover takes over
+        KillTimer(m_control_window, COVER_ANIMATION_TIMER_ID);
+        if (m_visible) InvalidateRect(m_control_window, nullptr, FALSE);
+        return;
+    }
+    update_cover_animation();
+}
+
+void control_panel::schedule_prewarm(UINT delay_ms) {
+    if (!m_initialized || !m_control_window || m_visible || m_prewarming) return;
+    // Re-arming the timer debounces bursts of track/metadata changes
+    SetTimer(m_control_window, PREWARM_TIMER_ID, delay_ms, nullptr);
+}
+
+void control_panel::get_miniplayer_launch_size(int& width, int& height) const {
+    if (m_is_artwork_expanded) {
+        width = m_saved_expanded_width > 0 ? m_saved_expanded_width : 400;
+        height = m_saved_expanded_height > 0 ? m_saved_expanded_height : 400;
+    } else if (m_is_compact_mode) {
+        width = m_saved_compact_width > 0 ? m_saved_compact_width : 320;
+        height = 75;
+    } else {
+        // Undocked mode
+        width = m_saved_undocked_width > 0 ? m_saved_undocked_width : 338;
+        height = m_saved_undocked_height > 0 ? m_saved_undocked_height : 120;
+    }
+}
+
+// Identifies everything a pre-rendered frame depends on except the playback position,
+// which is refreshed by a normal paint right after the window is shown.
+t_uint64 control_panel::compute_frame_key() const {
+    RECT client_rect;
+    GetClientRect(m_control_window, &client_rect);
+
+    t_uint64 hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void* data, size_t len) {
+        const BYTE* p = static_cast<const BYTE*>(data);
+        for (size_t i = 0; i < len; i++) {
+            hash ^= p[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    int state[] = {
+        client_rect.right - client_rect.left, client_rect.bottom - client_rect.top,
+        m_is_undocked, m_is_artwork_expanded, m_is_compact_mode,
+        m_is_playing, m_is_paused, m_is_dark_mode, m_shuffle_active, m_repeat_mode,
+        (int)m_settings_generation, m_up_next.is_open()
+    };
+    mix(state, sizeof(state));
+    HBITMAP art[] = { m_cover_art_bitmap, m_cover_art_bitmap_original, m_art_preview_bitmap };
+    mix(art, sizeof(art));
+    mix(&m_waveform_generation, sizeof(m_waveform_generation));
+    mix(m_current_artist.get_ptr(), m_current_artist.length());
+    mix("\x1f", 1);
+    mix(m_current_title.get_ptr(), m_current_title.length());
+    return hash | 1; // 0 is reserved for "no frame"
+}
+
+// Push the pre-rendered frame if it still matches the current content, otherwise render now.
+// Returns true if the pre-rendered frame was used.
+bool control_panel::present_first_frame(layered_surface& cache, t_uint64& cache_key) {
+    bool usable = cache_key != 0 && cache.bitmap && cache_key == compute_frame_key();
+    cache_key = 0; // Single use - the next hide schedules a fresh one
+
+    if (!usable) {
+        composite_layered_content();
+        return false;
+    }
+
+    // Hand the finished surface to the live slot instead of copying it
+    std::swap(m_live_surface, cache);
+    push_layered_frame(m_live_surface);
+    return true;
+}
+
+void control_panel::prewarm_frames() {
+    if (!m_initialized || !m_control_window || m_visible || m_animating || m_prewarming) return;
+    if (IsWindowVisible(m_control_window)) return;
+
+    m_prewarming = true;
+    bool was_undocked = m_is_undocked;
+    bool was_expanded = m_is_artwork_expanded;
+    bool was_compact = m_is_compact_mode;
+
+    try {
+        // Format lines and extract/decode art now instead of in the click handler
+        update_track_info();
+        update_playback_order_state();
+        update_theme_colors();
+
+        // Docked panel - what a tray click opens
+        m_is_undocked = false;
+        m_is_artwork_expanded = false;
+        m_is_compact_mode = false;
+        load_fonts();
+        position_control_panel();
+        m_prewarm_docked_key = render_layered_frame(m_prewarm_docked) ? compute_frame_key() : 0;
+
+        // MiniPlayer in its last-used mode (Undocked on first launch)
+        if (m_has_saved_miniplayer_state) {
+            m_is_undocked = m_saved_was_undocked;
+            m_is_artwork_expanded = m_saved_was_expanded;
+            m_is_compact_mode = m_saved_was_compact;
+        } else {
+            m_is_undocked = true;
+        }
+        int width, height;
+        get_miniplayer_launch_size(width, height);
+        load_fonts();
+        SetWindowPos(m_control_window, nullptr, 0, 0, width, height,
+            SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOREDRAW);
+        m_prewarm_miniplayer_key = render_layered_frame(m_prewarm_miniplayer) ? compute_frame_key() : 0;
+    } catch (...) {
+        m_prewarm_docked_key = 0;
+        m_prewarm_miniplayer_key = 0;
+    }
+
+    m_is_undocked = was_undocked;
+    m_is_artwork_expanded = was_expanded;
+    m_is_compact_mode = was_compact;
+    load_fonts();
+
+    // Painting may have started the ticker for a window nobody can see
+    KillTimer(m_control_window, TICKER_TIMER_ID);
+    m_ticker_active = false;
+    m_artist_ticker_active = false;
+    m_prewarming = false;
+}
+
+void control_panel::record_show_latency(const LARGE_INTEGER& start, bool prewarmed) {
+    LARGE_INTEGER end, freq;
+    QueryPerformanceCounter(&end);
+    QueryPerformanceFrequency(&freq);
+    double ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+
+    show_latency_stats& st = m_show_latency;
+    if (st.count == 0 || ms < st.min_ms) st.min_ms = ms;
+    if (ms > st.max_ms) st.max_ms = ms;
+    st.last_ms = ms;
+    st.total_ms += ms;
+    st.count++;
+    if (prewarmed) st.prewarmed_count++;
+
+#ifdef _DEBUG
+    char msg[160];
+    sprintf_s(msg, "control_panel: shown in %.2f ms (%s), avg %.2f ms over %u shows, %u pre-warmed\n",
+        ms, prewarmed ? "pre-warmed" : "cold", st.total_ms / st.count, st.count, st.prewarmed_count);
+    OutputDebugStringA(msg);
+#endif
 }
 
 void control_panel::set_undocked(bool undocked) {
@@ -2959,7 +2238,7 @@ void control_panel::toggle_artwork_expanded() {
         load_fonts();
         
         // Restart update timer for normal mini player functionality (use 500ms for responsive updates)
-        SetTimer(m_control_window, UPDATE_TIMER_ID, 500, nullptr);
+        start_progress_timer(500);
     } else {
         // Currently in undocked or compact mode - save state and switch to expanded mode
         m_was_compact_before_expanded = m_is_compact_mode; // Remember current mode
@@ -2984,7 +2263,7 @@ void control_panel::toggle_artwork_expanded() {
         KillTimer(m_control_window, TIMEOUT_TIMER_ID);
         
         // Restart update timer for track change detection (use 500ms for responsive updates)
-        SetTimer(m_control_window, UPDATE_TIMER_ID, 500, nullptr);
+        start_progress_timer(500);
         
         // Check if we have saved expanded dimensions, otherwise calculate based on artwork
         int window_width = m_saved_expanded_width;
@@ -3033,7 +2312,10 @@ void control_panel::toggle_artwork_expanded() {
 }
 
 void control_panel::toggle_compact_mode() {
-    if (!m_visible || !m_is_undocked || m_is_artwork_expanded) return;
+    if (!m_visible || !m_is_undocked || m_is_artwork_expanded || m_is_rolling_animation) return;
+
+    // Roll between the two layouts; switch instantly if the snapshots can't be taken
+    if (start_roll_animation(!m_is_compact_mode)) return;
     
     // Save current window dimensions before switching modes
     RECT current_rect;
@@ -3069,6 +2351,7 @@ void control_panel::toggle_compact_mode() {
     
     // Trigger repaint
     InvalidateRect(m_control_window, nullptr, TRUE);
+    sync_spectrum_timer();
 }
 
 void control_panel::close_panel_and_focus_foobar() {
@@ -3112,6 +2395,7 @@ void control_panel::handle_button_click(int button_id) {
                 m_is_playing = true;
                 m_is_paused = false;
             }
+            sync_spectrum_timer();
             if (m_control_window) InvalidateRect(m_control_window, nullptr, FALSE);
             return;
 
@@ -3135,7 +2419,7 @@ void control_panel::handle_button_click(int button_id) {
                     // Expanded mode overlay
                     const int overlay_height = 70;
                     int overlay_top = height - overlay_height;
-                    // Formula from draw_control_overlay
+                    // Formula from paint_control_overlay (panel_paint.cpp)
                     int center_y = overlay_top + (overlay_height / 2) + (overlay_height * 28 / 100);
                     int center_x = width / 2;
                     int button_spacing = 60;
@@ -3305,6 +2589,41 @@ void control_panel::handle_button_click(int button_id) {
     }
 }
 
+void control_panel::toggle_up_next() {
+    if (m_up_next.is_open()) {
+        m_up_next.close();
+    } else {
+        // The pane lives in the Undocked and Expanded MiniPlayer
+        if (!m_visible || !m_is_undocked) {
+            show_undocked_miniplayer();
+        } else if (m_is_slid_to_side) {
+            slide_back_from_side();
+        }
+        if (m_is_compact_mode) {
+            toggle_compact_mode();
+        }
+        m_up_next.open();
+    }
+    if (m_playlist_callback) {
+        m_playlist_callback->set_track_items(m_up_next.is_open());
+    }
+    sync_spectrum_timer();
+}
+
+void control_panel::jump_to_track() {
+    if (!m_up_next.is_open()) {
+        toggle_up_next();
+    }
+    if (!m_control_window || !m_up_next.is_open()) return;
+    // Shown without activation; keystrokes need the window in the foreground
+    SetForegroundWindow(m_control_window);
+    m_up_next.begin_search();
+}
+
+bool control_panel::is_up_next_shown() const {
+    return m_up_next.is_open() && m_is_undocked && !m_is_compact_mode && !m_is_rolling_animation;
+}
+
 void control_panel::update_playback_order_state() {
     try {
         auto playlist_api = playlist_manager::get();
@@ -3347,6 +2666,7 @@ void control_panel::handle_timer() {
     } catch (...) {
         // Ignore errors
     }
+    sync_spectrum_timer();
 }
 
 void control_panel::start_slide_out_animation() {
@@ -3365,7 +2685,7 @@ void control_panel::start_slide_out_animation() {
     m_final_y = m_start_y;
     
     // Stop other timers
-    KillTimer(m_control_window, UPDATE_TIMER_ID);
+    stop_progress_timer();
     KillTimer(m_control_window, UPDATE_TIMER_ID + 1);
     KillTimer(m_control_window, TIMEOUT_TIMER_ID);
     KillTimer(m_control_window, TICKER_TIMER_ID);
@@ -3381,12 +2701,18 @@ void control_panel::start_slide_out_animation() {
 }
 
 void control_panel::update_ticker() {
+    TRAY_PERF_SCOPE(perf_phase_ticker_step);
     if (!m_control_window || !m_visible) {
         KillTimer(m_control_window, TICKER_TIMER_ID);
         m_ticker_active = false;
         m_artist_ticker_active = false;
         return;
     }
+    if (m_render_throttle.is_throttled()) {
+        // Paused in place; sync_ticker_timer() restarts it when the throttle lifts
+        KillTimer(m_control_window, TICKER_TIMER_ID);
+        return;
+    }
 
     // Advance the offset in the current direction. Direction is +1 while scrolling
     // right-to-left (offset grows), -1 while scrolling back (offset shrinks).
@@ -3395,7 +2721,7 @@ void control_panel::update_ticker() {
     //   Slow:    0.75px @ 24ms = ~30 px/sec
     //   Fast:    1.0px @ 16ms = ~60 px/sec
     //   Fastest: 1.5px @ 12ms = ~125 px/sec
-    int speed = get_ticker_speed();
+    int speed = get_settings().ticker_speed;
     float step = 1.0f;
     switch (speed) {
         case 1: step = 0.5f; break;   // Slowest
@@ -3416,9 +2742,10 @@ void control_panel::update_ticker() {
 }
 
 void control_panel::sync_ticker_timer() {
-    bool want_ticker = m_ticker_active || m_artist_ticker_active;
+    // A throttled panel keeps the ticker text where it is; it resumes from there
+    bool want_ticker = (m_ticker_active || m_artist_ticker_active) && !m_render_throttle.is_throttled();
     if (want_ticker) {
-        int speed = get_ticker_speed();
+        int speed = get_settings().ticker_speed;
         UINT interval;
         switch (speed) {
             case 1: interval = 32; break; // ~15 px/sec
@@ -3432,67 +2759,83 @@ void control_panel::sync_ticker_timer() {
     }
 }
 
-void control_panel::update_text_ticker_internal(HDC hdc, const pfc::string8& text, HFONT font, const RECT& rect,
-                                                 float& offset, int& direction, bool& active, pfc::string8& ticker_text,
-                                                 COLORREF text_color) {
-    if (!m_control_window) return;
-
-    int area_width = rect.right - rect.left;
-    if (area_width <= 0) {
-        active = false;
-        offset = 0;
-        sync_ticker_timer();
-        return;
-    }
-
-    SelectObject(hdc, font);
-    if (text_color != CLR_INVALID) {
-        SetTextColor(hdc, text_color);
-    }
-
-    pfc::stringcvt::string_wide_from_utf8 wide_text(text.c_str());
-    SIZE text_size = {};
-    GetTextExtentPoint32W(hdc, wide_text.get_ptr(), (int)wcslen(wide_text.get_ptr()), &text_size);
+bool control_panel::wants_spectrum() const {
+    return m_control_window && m_visible &&
+        get_settings().spectrum_visualizer &&
+        (m_is_artwork_expanded || m_is_compact_mode) && !is_up_next_shown() &&
+        m_is_playing && !m_is_paused && !m_render_throttle.is_throttled();
+}
 
-    bool overflow = text_size.cx > area_width;
-    if (overflow) {
-        if (text != ticker_text) {
-            ticker_text = text;
-            offset = 0;
-            direction = 1;
+// Start, retime or stop the spectrum frame clock. The visualisation stream lives only as long
+// as the timer, so a hidden or paused panel costs nothing.
+void control_panel::sync_spectrum_timer() {
+    if (!m_control_window) return;
+    if (wants_spectrum()) {
+        m_spectrum.start();
+        UINT interval = m_spectrum.is_running() ? m_spectrum.get_interval() : 0;
+        if (interval && interval != m_spectrum_interval) {
+            SetTimer(m_control_window, SPECTRUM_TIMER_ID, interval, nullptr);
+            m_spectrum_interval = interval;
         }
-    } else {
-        ticker_text = text;
-        offset = 0;
-        direction = 1;
+    } else if (m_spectrum_interval || m_spectrum.is_running()) {
+        KillTimer(m_control_window, SPECTRUM_TIMER_ID);
+        m_spectrum_interval = 0;
+        m_spectrum.stop();
+        m_spectrum_base_valid = false;
+        // Repaint without bars
+        if (m_visible) InvalidateRect(m_control_window, nullptr, FALSE);
     }
+}
 
-    int max_offset = text_size.cx - area_width;
-    if (max_offset < 0) max_offset = 0;
-    if (offset < 0.0f) { offset = 0.0f; direction = 1; }
-    if (offset > (float)max_offset) { offset = (float)max_offset; direction = -1; }
-
-    active = overflow && (get_ticker_speed() != 0) && !is_short_title(text);
-    sync_ticker_timer();
-
-    SetBkMode(hdc, TRANSPARENT);
-    if (active) {
-        int text_y = rect.top + ((rect.bottom - rect.top - text_size.cy) / 2);
-        int rounded_offset = (int)(offset + 0.5f);
-        RECT text_clip = rect;
-        ExtTextOutW(hdc, rect.left - rounded_offset, text_y, ETO_CLIPPED, &text_clip, wide_text.get_ptr(), (UINT)wcslen(wide_text.get_ptr()), nullptr);
-    } else {
-        RECT fit_rect = rect;
-        DrawText(hdc, wide_text.get_ptr(), -1, &fit_rect, DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+// One spectrum frame. Its cost (analysis plus composite) feeds the governor, which may
+// stretch the interval.
+void control_panel::update_spectrum() {
+    if (!wants_spectrum()) {
+        sync_spectrum_timer();
+        return;
     }
+    // Moves and rolls own the surface on screen; the next frame after them catches up
+    if (is_moving_window() || m_is_rolling_animation) return;
+
+    LARGE_INTEGER start, end, freq;
+    QueryPerformanceCounter(&start);
+    m_spectrum.step();
+    composite_spectrum_frame();
+    QueryPerformanceCounter(&end);
+    QueryPerformanceFrequency(&freq);
+    m_spectrum.add_frame_cost((double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart);
+    sync_spectrum_timer();
 }
 
-void control_panel::update_title_ticker(HDC hdc, const pfc::string8& title, HFONT font, const RECT& rect) {
-    update_text_ticker_internal(hdc, title, font, rect, m_ticker_offset, m_ticker_direction, m_ticker_active, m_ticker_title, CLR_INVALID);
+void control_panel::composite_spectrum_frame() {
+    TRAY_PERF_SCOPE(perf_phase_spectrum_frame);
+    RECT client_rect;
+    GetClientRect(m_control_window, &client_rect);
+    int width = client_rect.right - client_rect.left;
+    int height = client_rect.bottom - client_rect.top;
+
+    // Expanded: restore the last artwork frame and blend the new bars over it
+    if (m_is_artwork_expanded && !m_overlay_visible && m_spectrum_base_valid &&
+        m_spectrum_base.width == width && m_spectrum_base.height == height &&
+        m_paint_surface.width == width && m_paint_surface.height == height &&
+        ensure_surface(m_live_surface, width, height)) {
+        BitBlt(m_paint_surface.dc, 0, 0, width, height, m_spectrum_base.dc, 0, 0, SRCCOPY);
+        RECT bars = {0, height - height / 3, width, height};
+        draw_spectrum(m_paint_surface, bars, SPECTRUM_EXPANDED_ALPHA);
+        finish_layered_frame(m_live_surface, width, height);
+        present_live_frame();
+        TRAY_PERF_COUNT(perf_counter_paints);
+        return;
+    }
+    composite_layered_content();
+    ValidateRect(m_control_window, nullptr);
 }
 
-void control_panel::update_artist_ticker(HDC hdc, const pfc::string8& artist, HFONT font, const RECT& rect, COLORREF text_color) {
-    update_text_ticker_internal(hdc, artist, font, rect, m_artist_ticker_offset, m_artist_ticker_direction, m_artist_ticker_active, m_artist_ticker_title, text_color);
+// Blend the current bars straight into a surface's pixels
+void control_panel::draw_spectrum(layered_surface& surface, const RECT& area, BYTE alpha) {
+    if (!surface.bits || area.right <= area.left || area.bottom <= area.top) return;
+    GdiFlush(); // Finish GDI work before touching the pixels directly
+    m_spectrum.draw(surface.bits, surface.width * 4, area, get_settings().compact_progress_color, alpha);
 }
 
 void control_panel::update_animation() {
@@ -3508,10 +2851,15 @@ void control_panel::update_animation() {
         KillTimer(m_control_window, ANIMATION_TIMER_ID);
         
         if (m_closing) {
-            // Actually hide the window now
+            // Actually hide the window now - nothing deferred during the slide-out is worth painting
             ShowWindow(m_control_window, SW_HIDE);
             m_visible = false;
             m_closing = false;
+            m_repaint_after_move = false;
+            refresh_render_throttle();
+            schedule_prewarm();
+        } else {
+            end_window_move();
         }
     } else {
         // Calculate current position using ease-out curve
@@ -3521,14 +2869,13 @@ void control_panel::update_animation() {
         int current_x = m_start_x + (int)((m_final_x - m_start_x) * eased_progress);
         int current_y = m_start_y + (int)((m_final_y - m_start_y) * eased_progress);
         
-        // Move window to current position
-        SetWindowPos(m_control_window, HWND_TOPMOST, current_x, current_y, 0, 0, 
-                     SWP_NOSIZE | SWP_NOACTIVATE);
+        // Move window to current position (content unchanged - no repaint)
+        move_layered_window(current_x, current_y);
     }
 }
 
 void control_panel::slide_to_side() {
-    if (m_sliding_animation || m_is_slid_to_side || !m_control_window || !m_visible || get_disable_slide_to_side()) {
+    if (m_sliding_animation || m_is_slid_to_side || !m_control_window || !m_visible || get_settings().disable_slide_to_side) {
         return;
     }
     
@@ -3553,7 +2900,7 @@ void control_panel::slide_to_side() {
     m_sliding_to_side = true;
     m_slide_animation_step = 0;
     
-    int slide_interval = get_slide_duration() / SLIDE_ANIMATION_STEPS;
+    int slide_interval = get_settings().slide_duration / SLIDE_ANIMATION_STEPS;
     if (slide_interval < 1) slide_interval = 1;
     SetTimer(m_control_window, SLIDE_TIMER_ID, slide_interval, nullptr);
 }
@@ -3575,7 +2922,7 @@ void control_panel::slide_back_from_side() {
     m_sliding_to_side = false;
     m_slide_animation_step = 0;
     
-    int slide_interval = get_slide_duration() / SLIDE_ANIMATION_STEPS;
+    int slide_interval = get_settings().slide_duration / SLIDE_ANIMATION_STEPS;
     if (slide_interval < 1) slide_interval = 1;
     SetTimer(m_control_window, SLIDE_TIMER_ID, slide_interval, nullptr);
 }
@@ -3598,14 +2945,14 @@ void control_panel::update_slide_animation() {
             m_is_slid_to_side = false;
         }
         
-        // Final position
+        // Final position, re-asserting topmost once now the slide is over
         RECT window_rect;
         GetWindowRect(m_control_window, &window_rect);
-        int window_height = window_rect.bottom - window_rect.top;
-        int window_width = window_rect.right - window_rect.left;
-        
-        SetWindowPos(m_control_window, HWND_TOPMOST, m_slide_target_x, window_rect.top, 
-                     window_width, window_height, SWP_NOACTIVATE);
+        move_layered_window(m_slide_target_x, window_rect.top);
+        SetWindowPos(m_control_window, HWND_TOPMOST, 0, 0, 0, 0,
+                     SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_NOREDRAW);
+        end_window_move();
+        refresh_render_throttle();
     } else {
         // Calculate current position using ease-out curve
         float progress = (float)m_slide_animation_step / SLIDE_ANIMATION_STEPS;
@@ -3613,12 +2960,120 @@ void control_panel::update_slide_animation() {
         
         int current_x = m_slide_start_x + (int)((m_slide_target_x - m_slide_start_x) * eased_progress);
         
-        // Move window to current position
-        SetWindowPos(m_control_window, HWND_TOPMOST, current_x, m_pre_slide_y, 0, 0, 
-                     SWP_NOSIZE | SWP_NOACTIVATE);
+        // Move window to current position (content unchanged - no repaint)
+        move_layered_window(current_x, m_pre_slide_y);
+    }
+}
+
+void control_panel::start_progress_timer(UINT interval_ms) {
+    m_progress_interval = interval_ms;
+    if (!m_control_window) return;
+    UINT interval = m_render_throttle.get_progress_interval(interval_ms);
+    if (interval) {
+        SetTimer(m_control_window, UPDATE_TIMER_ID, interval, nullptr);
+    } else {
+        KillTimer(m_control_window, UPDATE_TIMER_ID);
+    }
+    sync_spectrum_timer();
+}
+
+void control_panel::stop_progress_timer() {
+    m_progress_interval = 0;
+    if (m_control_window) {
+        KillTimer(m_control_window, UPDATE_TIMER_ID);
+    }
+    sync_spectrum_timer();
+}
+
+// Re-evaluate the throttle reasons that depend on the window itself (the session and power
+// ones arrive as messages). Called on show/hide, slide end and window show/move/cloak events.
+void control_panel::refresh_render_throttle() {
+    if (!m_control_window) return;
+    // Other windows only matter while the panel is on screen
+    if (m_visible) {
+        install_visibility_hooks();
+    } else {
+        remove_visibility_hooks();
+        // A fade has nothing to show while hidden; its snapshots are not worth keeping either
+        end_crossfade();
+        release_surface(m_crossfade_from);
+        release_surface(m_crossfade_frame);
+        sync_cover_animation();
+    }
+
+    unsigned previous = m_render_throttle.get_reasons();
+    m_render_throttle.refresh_visibility();
+    m_render_throttle.set_reason(render_throttle_peeking, m_visible && m_is_slid_to_side);
+    if (m_render_throttle.get_reasons() != previous) {
+        on_render_throttle_changed(previous);
+    }
+}
+
+void control_panel::on_render_throttle_changed(unsigned previous) {
+    TRAY_TRACE_INSTANT("power", "control_panel throttle changed");
+    if (!m_visible || !m_control_window) {
+        m_repaint_after_throttle = false;
+        return;
+    }
+
+    if (m_progress_interval) {
+        start_progress_timer(m_progress_interval);
+    }
+    sync_ticker_timer();
+    sync_spectrum_timer();
+    sync_cover_animation();
+
+    bool was_suspended = (previous & render_throttle_hidden_mask) != 0;
+    if (!m_render_throttle.is_suspended() && (was_suspended || m_repaint_after_throttle)) {
+        // One catch-up frame at the current position rather than replaying what was skipped
+        m_repaint_after_throttle = false;
+        handle_timer();
+        if (is_moving_window()) {
+            m_repaint_after_move = true;
+        } else if (!m_is_rolling_animation) {
+            composite_layered_content();
+            ValidateRect(m_control_window, nullptr);
+        }
+    }
+}
+
+void control_panel::install_visibility_hooks() {
+    // Events after which a window may newly cover (or stop covering) the panel. Out-of-context
+    // hooks are delivered on this thread through its message loop, so no locking is needed.
+    static const DWORD event_ranges[][2] = {
+        { EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND },
+        { EVENT_SYSTEM_MOVESIZEEND, EVENT_SYSTEM_MOVESIZEEND },
+        { EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND },
+        { EVENT_OBJECT_DESTROY, EVENT_OBJECT_HIDE },
+        { EVENT_OBJECT_CLOAKED, EVENT_OBJECT_UNCLOAKED }
+    };
+    static_assert(_countof(event_ranges) == _countof(m_visibility_hooks), "one hook per event range");
+
+    for (size_t i = 0; i < _countof(event_ranges); i++) {
+        if (!m_visibility_hooks[i]) {
+            m_visibility_hooks[i] = SetWinEventHook(event_ranges[i][0], event_ranges[i][1], nullptr,
+                visibility_event_proc, 0, 0, WINEVENT_OUTOFCONTEXT);
+        }
     }
 }
 
+void control_panel::remove_visibility_hooks() {
+    for (HWINEVENTHOOK& hook : m_visibility_hooks) {
+        if (hook) {
+            UnhookWinEvent(hook);
+            hook = nullptr;
+        }
+    }
+}
+
+void CALLBACK control_panel::visibility_event_proc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+                                                   LONG id_object, LONG id_child, DWORD thread_id, DWORD time) {
+    if (id_object != OBJID_WINDOW || id_child != CHILDID_SELF || !s_instance || !s_instance->m_visible) return;
+    // Only top-level windows can cover the panel
+    if (hwnd && GetAncestor(hwnd, GA_PARENT) != GetDesktopWindow()) return;
+    s_instance->refresh_render_throttle();
+}
+
 LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
     control_panel* panel = nullptr;
     
@@ -3634,9 +3089,19 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
         switch (msg) {
         case WM_PAINT:
             {
+                TRAY_TRACE_SCOPE("paint", "control_panel WM_PAINT");
                 PAINTSTRUCT ps;
                 BeginPaint(hwnd, &ps);
-                panel->composite_layered_content();
+                // Mid-roll frames come from the snapshots; the final composite happens when it ends.
+                // Mid-move paints are folded into one composite when the move ends.
+                // Frames nobody can see are folded into one catch-up composite when that ends.
+                if (panel->is_moving_window()) {
+                    panel->m_repaint_after_move = true;
+                } else if (panel->m_render_throttle.is_suspended()) {
+                    panel->m_repaint_after_throttle = true;
+                } else if (!panel->m_is_rolling_animation) {
+                    panel->composite_layered_content();
+                }
                 EndPaint(hwnd, &ps);
                 return 0;
             }
@@ -3647,19 +3112,32 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
 
         case WM_WINDOWPOSCHANGED:
             if (panel) {
-                // Only repaint when the window size actually changed (not during drag moves).
-                // The rounded-corner alpha mask is computed per-pixel from the current client size.
-                RECT rc;
-                GetClientRect(hwnd, &rc);
-                static RECT s_last_rc = {0, 0, 0, 0};
-                if (rc.right != s_last_rc.right || rc.bottom != s_last_rc.bottom) {
-                    s_last_rc = rc;
-                    panel->apply_window_corner_preference();
+                // Only repaint when the window size actually changed (not during drag or animation moves).
+                // The rounded-corner alpha mask is computed per-pixel from the current client size,
+                // so compare against the size of the surface last pushed to this window.
+                const WINDOWPOS* wp = reinterpret_cast<const WINDOWPOS*>(lparam);
+                if (!(wp->flags & SWP_NOSIZE) && !panel->m_prewarming && !panel->m_is_rolling_animation) {
+                    RECT rc;
+                    GetClientRect(hwnd, &rc);
+                    if (rc.right != panel->m_live_surface.width || rc.bottom != panel->m_live_surface.height) {
+                        panel->apply_window_corner_preference();
+                    }
                 }
             }
             break;
             
         case WM_LBUTTONDOWN:
+            // Up Next pane: close button, rows (play) and the rest of the list area
+            if (panel && panel->is_up_next_shown() && !panel->m_is_slid_to_side) {
+                POINT pt = {(short)LOWORD(lparam), (short)HIWORD(lparam)};
+                if (panel->m_up_next.handle_click(pt)) {
+                    if (!panel->m_up_next.is_open() && panel->m_playlist_callback) {
+                        panel->m_playlist_callback->set_track_items(false);
+                    }
+                    return 0;
+                }
+            }
+            
             // Handle compact mode click
             if (panel && panel->m_is_compact_mode) {
                 POINT pt = {LOWORD(lparam), HIWORD(lparam)};
@@ -3703,8 +3181,8 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                 // Check if click is on progress bar in compact mode
                 int text_left = margin + art_size + margin;
                 int text_right = window_width - margin;
-                int progress_bar_height = 5;
-                int progress_bar_y = window_height - progress_bar_height - 2 - (int)(window_height * 0.1);
+                int progress_bar_y, progress_bar_height;
+                panel->get_compact_progress_band(window_height, progress_bar_y, progress_bar_height);
                 int progress_bar_left = text_left;
                 int progress_bar_width = text_right - text_left - 40; // Leave space for time display
                 
@@ -3729,9 +3207,9 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                 
                 // Check if click is on compact control overlay buttons
                 if (panel->m_compact_controls_visible) {
-                    // Calculate button positions (same as in draw_compact_control_overlay)
-                    bool show_art = get_show_cover_art();
-                    bool has_margin = get_cover_margin();
+                    // Calculate button positions (same as in paint_compact_controls, panel_paint.cpp)
+                    bool show_art = get_settings().show_cover_art;
+                    bool has_margin = get_settings().cover_margin;
                     int art_size_calc = show_art ? (has_margin ? (window_height - 2 * margin) : window_height) : 0;
 
                     int text_left = 0;
@@ -3966,8 +3444,8 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                 int button_spacing = (panel->m_is_undocked) ? 40 : 60;
                 
                 // Mirror paint logic: center in area right of artwork
-                bool show_art = get_show_cover_art();
-                bool has_margin = get_cover_margin();
+                bool show_art = get_settings().show_cover_art;
+                bool has_margin = get_settings().cover_margin;
                 int art_size = 0;
                 if (show_art) {
                     if (has_margin) {
@@ -4164,7 +3642,7 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     int art_x = margin;
                     int art_y = margin;
                     
-                    bool show_art = get_show_cover_art();
+                    bool show_art = get_settings().show_cover_art;
                     bool over_artwork = show_art && (pt.x >= art_x && pt.x <= art_x + art_size && 
                                        pt.y >= art_y && pt.y <= art_y + art_size);
                     
@@ -4220,7 +3698,7 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     art_size = (art_size < (window_height - 30) ? art_size : (window_height - 30));
                     int art_x = 15;
                     int art_y = 15;
-                    bool show_art = get_show_cover_art();
+                    bool show_art = get_settings().show_cover_art;
                     
                     if (show_art && pt.x >= art_x && pt.x <= art_x + art_size && 
                         pt.y >= art_y && pt.y <= art_y + art_size) {
@@ -4302,8 +3780,8 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     int button_spacing = 60;
 
                     // Mirror paint logic: center in area right of artwork
-                    bool show_art = get_show_cover_art();
-                    bool has_margin = get_cover_margin();
+                    bool show_art = get_settings().show_cover_art;
+                    bool has_margin = get_settings().cover_margin;
                     int art_size = 0;
                     if (show_art) {
                         if (has_margin) {
@@ -4421,8 +3899,8 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                      int button_y = window_height - 30;
                      int button_spacing = 40;
                      
-                     bool show_art = get_show_cover_art();
-                     bool has_margin = get_cover_margin();
+                     bool show_art = get_settings().show_cover_art;
+                     bool has_margin = get_settings().cover_margin;
                      int art_size = 0;
                      if (show_art) {
                          if (has_margin) {
@@ -4560,6 +4038,16 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
             if (panel) {
                 LRESULT hit = DefWindowProc(hwnd, msg, wparam, lparam);
                 
+                // Up Next pane: the list and its close button are clickable, the header drags
+                if (panel->is_up_next_shown() && !panel->m_is_slid_to_side) {
+                    POINT pt = {(short)LOWORD(lparam), (short)HIWORD(lparam)};
+                    ScreenToClient(hwnd, &pt);
+                    if (!panel->m_up_next.is_header_drag_area(pt)) {
+                        return HTCLIENT;
+                    }
+                    return get_settings().disable_miniplayer ? HTCLIENT : HTCAPTION;
+                }
+                
                 // In artwork expanded mode, enable dragging and resizing
                 if (panel->m_is_artwork_expanded) {
                     // Convert screen coordinates to client coordinates
@@ -4626,8 +4114,8 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     // Check if over progress bar area - return HTCLIENT for click handling
                     int text_left = margin + art_size + margin;
                     int text_right = window_width - margin;
-                    int progress_bar_height = 5;
-                    int progress_bar_y = window_height - progress_bar_height - 2 - (int)(window_height * 0.1);
+                    int progress_bar_y, progress_bar_height;
+                    panel->get_compact_progress_band(window_height, progress_bar_y, progress_bar_height);
                     int progress_bar_left = text_left;
                     int progress_bar_width = text_right - text_left - 40; // Leave space for time display
                     
@@ -4665,7 +4153,7 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     }
                     
                     // Allow dragging from anywhere else on the compact panel (unless disabled)
-                    if (get_disable_miniplayer()) {
+                    if (get_settings().disable_miniplayer) {
                         return HTCLIENT; // Prevent dragging when miniPlayer is disabled
                     }
                     return HTCAPTION;
@@ -4697,8 +4185,8 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     int button_y = window_height - 30;
                     int button_spacing = 40;
                     
-                    bool show_art = get_show_cover_art();
-                    bool has_margin = get_cover_margin();
+                    bool show_art = get_settings().show_cover_art;
+                    bool has_margin = get_settings().cover_margin;
                     int art_size = 0;
                     if (show_art) {
                         if (has_margin) {
@@ -4770,7 +4258,7 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     }
                     
                     // Allow dragging from everywhere else (unless disabled)
-                    if (get_disable_miniplayer()) {
+                    if (get_settings().disable_miniplayer) {
                         return HTCLIENT; // Prevent dragging when miniPlayer is disabled
                     }
                     return HTCAPTION;
@@ -4789,8 +4277,8 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     int button_y = window_height - 30;
                     int button_spacing = 60;
                     
-                    bool show_art = get_show_cover_art();
-                    bool has_margin = get_cover_margin();
+                    bool show_art = get_settings().show_cover_art;
+                    bool has_margin = get_settings().cover_margin;
                     int art_size = 0;
                     if (show_art) {
                         if (has_margin) {
@@ -4822,7 +4310,7 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                     }
                     
                     // For docked mode, allow dragging from everywhere else (except buttons and artwork, unless disabled)
-                    if (get_disable_miniplayer()) {
+                    if (get_settings().disable_miniplayer) {
                         return HTCLIENT; // Prevent dragging when miniPlayer is disabled
                     }
                     return HTCAPTION;
@@ -4891,7 +4379,8 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
 
         case WM_SIZE:
             // Handle window resizing without recursive SetWindowPos
-            if (panel) {
+            // (pre-warm and the roll animation resize the window and must not overwrite the remembered sizes)
+            if (panel && !panel->m_prewarming && !panel->m_is_rolling_animation) {
                 int new_width = LOWORD(lparam);
                 int new_height = HIWORD(lparam);
                 if (new_width > 0 && new_height > 0) {
@@ -4913,6 +4402,7 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
             break;
             
         case WM_TIMER:
+            TRAY_TRACE_INSTANT("timer", "control_panel WM_TIMER");
             if (wparam == UPDATE_TIMER_ID) {
                 panel->handle_timer();
                 return 0;
@@ -4928,6 +4418,15 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                 // Track title ticker animation timer
                 if (panel) panel->update_ticker();
                 return 0;
+            } else if (wparam == CROSSFADE_TIMER_ID) {
+                if (panel) panel->update_crossfade();
+                return 0;
+            } else if (wparam == COVER_ANIMATION_TIMER_ID) {
+                if (panel) panel->update_cover_animation();
+                return 0;
+            } else if (wparam == SPECTRUM_TIMER_ID) {
+                if (panel) panel->update_spectrum();
+                return 0;
             } else if (wparam == MOUSE_POLL_TIMER_ID) {
                 if (panel) {
                     POINT pt;
@@ -5059,1318 +4558,487 @@ LRESULT CALLBACK control_panel::control_window_proc(HWND hwnd, UINT msg, WPARAM
                 // Handle slide-to-side animation
                 if (panel) panel->update_slide_animation();
                 return 0;
+            } else if (wparam == PREWARM_TIMER_ID) {
+                KillTimer(hwnd, PREWARM_TIMER_ID);
+                if (panel) panel->prewarm_frames();
+                return 0;
             }
             break;
             
-        case WM_KILLFOCUS:
-        case WM_ACTIVATE:
-            if (LOWORD(wparam) == WA_INACTIVE) {
-                // TEMPORARILY DISABLED: Hide panel when it loses focus - testing timeout timer
-                // if (panel && !panel->m_is_undocked) {
-                //     panel->hide_control_panel_immediate();
-                // }
-                return 0;
-            }
-        }
-    }
-    
-    return DefWindowProc(hwnd, msg, wparam, lparam);
-}
-
-static void add_rounded_rect_path(Gdiplus::GraphicsPath& path, float x, float y, float w, float h, float radius) {
-    float d = radius * 2.0f;
-    path.AddArc(x, y, d, d, 180, 90);
-    path.AddArc(x + w - d, y, d, d, 270, 90);
-    path.AddArc(x + w - d, y + h - d, d, d, 0, 90);
-    path.AddArc(x, y + h - d, d, d, 90, 90);
-    path.CloseFigure();
-}
-
-static std::unique_ptr<Gdiplus::Bitmap> create_gdiplus_bitmap_from_hbitmap(HDC hdc, HBITMAP hbmp) {
-    if (!hbmp || !hdc) return nullptr;
-
-    BITMAP bmp;
-    if (!GetObject(hbmp, sizeof(bmp), &bmp) || bmp.bmWidth <= 0 || bmp.bmHeight <= 0) return nullptr;
-
-    std::unique_ptr<Gdiplus::Bitmap> gdi_bmp(Gdiplus::Bitmap::FromHBITMAP(hbmp, nullptr));
-    if (gdi_bmp && gdi_bmp->GetLastStatus() == Gdiplus::Ok) {
-        return gdi_bmp;
-    }
-
-    // Fallback: Copy via GDI BitBlt
-    std::unique_ptr<Gdiplus::Bitmap> copy_bmp(new Gdiplus::Bitmap(bmp.bmWidth, bmp.bmHeight, PixelFormat32bppARGB));
-    Gdiplus::Graphics g(copy_bmp.get());
-    HDC g_dc = g.GetHDC();
-    if (g_dc) {
-        HDC mem_dc = CreateCompatibleDC(hdc);
-        HBITMAP old_bm = (HBITMAP)SelectObject(mem_dc, hbmp);
-        BitBlt(g_dc, 0, 0, bmp.bmWidth, bmp.bmHeight, mem_dc, 0, 0, SRCCOPY);
-        SelectObject(mem_dc, old_bm);
-        DeleteDC(mem_dc);
-        g.ReleaseHDC(g_dc);
-    }
-    return copy_bmp;
-}
-
-void control_panel::paint_background_style(HDC hdc, const RECT& rect) {
-    if (!hdc) return;
-    int bg_style = get_background_style(); // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
-    HBITMAP art_bm = m_cover_art_bitmap_original ? m_cover_art_bitmap_original : m_cover_art_bitmap;
-    bool is_rounded = (get_miniplayer_border_style() == 1);
-
-    int w = rect.right - rect.left;
-    int h = rect.bottom - rect.top;
-    if (w <= 0 || h <= 0) return;
-
-    Gdiplus::Graphics g(hdc);
-    g.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    float stroke = 1.0f;
-    float pad = stroke * 0.5f;
-    float radius = 8.0f;
-    Gdiplus::GraphicsPath card_path;
-    if (is_rounded) {
-        add_rounded_rect_path(card_path, pad, pad, (float)w - stroke, (float)h - stroke, radius);
-    }
-
-    if (bg_style == 1 && art_bm) {
-        BITMAP bmp;
-        if (GetObject(art_bm, sizeof(bmp), &bmp) && bmp.bmWidth > 0 && bmp.bmHeight > 0) {
-            HDC mem_dc = CreateCompatibleDC(hdc);
-            HBITMAP old_bm = (HBITMAP)SelectObject(mem_dc, art_bm);
-
-            long total_r = 0, total_g = 0, total_b = 0;
-            int pixel_count = 0;
-            const int grid_size = 8;
-
-            for (int y = 0; y < grid_size; y++) {
-                int sample_y = (bmp.bmHeight * (y + 1)) / (grid_size + 1);
-                for (int x = 0; x < grid_size; x++) {
-                    int sample_x = (bmp.bmWidth * (x + 1)) / (grid_size + 1);
-                    COLORREF c = GetPixel(mem_dc, sample_x, sample_y);
-                    if (c != CLR_INVALID) {
-                        total_r += GetRValue(c);
-                        total_g += GetGValue(c);
-                        total_b += GetBValue(c);
-                        pixel_count++;
-                    }
-                }
-            }
-
-            SelectObject(mem_dc, old_bm);
-            DeleteDC(mem_dc);
-
-            if (pixel_count > 0) {
-                int avg_r = total_r / pixel_count;
-                int avg_g = total_g / pixel_count;
-                int avg_b = total_b / pixel_count;
-
-                Gdiplus::Color primary(255, avg_r, avg_g, avg_b);
-                Gdiplus::Color secondary(255, avg_r * 65 / 100, avg_g * 65 / 100, avg_b * 65 / 100);
-
-                Gdiplus::Rect g_rect(rect.left, rect.top, w, h);
-                Gdiplus::LinearGradientBrush brush(
-                    Gdiplus::Point(rect.left, rect.top),
-                    Gdiplus::Point(rect.left + w, rect.top),
-                    secondary,
-                    primary
-                );
-
-                BYTE overlay_alpha = m_is_dark_mode ? 70 : 30;
-                Gdiplus::SolidBrush overlay(Gdiplus::Color(overlay_alpha, 0, 0, 0));
-
-                if (is_rounded) {
-                    g.FillPath(&brush, &card_path);
-                    g.FillPath(&overlay, &card_path);
-                } else {
-                    g.FillRectangle(&brush, g_rect);
-                    g.FillRectangle(&overlay, g_rect);
-                }
-                return;
-            }
-        }
-    } else if (bg_style == 2 && art_bm) {
-        int target_width = rect.right - rect.left;
-        int target_height = rect.bottom - rect.top;
-        if (target_width > 0 && target_height > 0) {
-            std::unique_ptr<Gdiplus::Bitmap> src_bitmap = create_gdiplus_bitmap_from_hbitmap(hdc, art_bm);
-            if (src_bitmap && src_bitmap->GetLastStatus() == Gdiplus::Ok) {
-                const int blur_size = 64;
-                Gdiplus::Bitmap scaled(blur_size, blur_size, PixelFormat32bppARGB);
-                {
-                    Gdiplus::Graphics gfx(&scaled);
-                    gfx.SetInterpolationMode(Gdiplus::InterpolationModeBilinear);
-                    gfx.DrawImage(src_bitmap.get(), 0, 0, blur_size, blur_size);
-                }
-
-                Gdiplus::Rect lockRect(0, 0, blur_size, blur_size);
-                Gdiplus::BitmapData scaledData;
-                if (scaled.LockBits(&lockRect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &scaledData) == Gdiplus::Ok) {
-                    std::vector<BYTE> tempBuffer(blur_size * blur_size * 4);
-                    std::vector<BYTE> blurBuffer(blur_size * blur_size * 4);
-
-                    BYTE* srcPixels = static_cast<BYTE*>(scaledData.Scan0);
-                    int srcStride = scaledData.Stride;
-                    const int radius_val = 4;
-
-                    // Pass 1: Horizontal blur
-                    for (int y = 0; y < blur_size; y++) {
-                        for (int x = 0; x < blur_size; x++) {
-                            int total_r = 0, total_g = 0, total_b = 0, total_a = 0;
-                            int count = 0;
-                            for (int dx = -radius_val; dx <= radius_val; dx++) {
-                                int sx = x + dx;
-                                if (sx >= 0 && sx < blur_size) {
-                                    BYTE* pixel = srcPixels + y * srcStride + sx * 4;
-                                    total_b += pixel[0];
-                                    total_g += pixel[1];
-                                    total_r += pixel[2];
-                                    total_a += pixel[3];
-                                    count++;
-                                }
-                            }
-                            int dstIdx = (y * blur_size + x) * 4;
-                            tempBuffer[dstIdx + 0] = static_cast<BYTE>(total_b / count);
-                            tempBuffer[dstIdx + 1] = static_cast<BYTE>(total_g / count);
-                            tempBuffer[dstIdx + 2] = static_cast<BYTE>(total_r / count);
-                            tempBuffer[dstIdx + 3] = static_cast<BYTE>(total_a / count);
-                        }
-                    }
-
-                    scaled.UnlockBits(&scaledData);
-
-                    // Pass 2: Vertical blur
-                    for (int y = 0; y < blur_size; y++) {
-                        for (int x = 0; x < blur_size; x++) {
-                            int total_r = 0, total_g = 0, total_b = 0, total_a = 0;
-                            int count = 0;
-                            for (int dy = -radius; dy <= radius; dy++) {
-                                int sy = y + dy;
-                                if (sy >= 0 && sy < blur_size) {
-                                    int srcIdx = (sy * blur_size + x) * 4;
-                                    total_b += tempBuffer[srcIdx + 0];
-                                    total_g += tempBuffer[srcIdx + 1];
-                                    total_r += tempBuffer[srcIdx + 2];
-                                    total_a += tempBuffer[srcIdx + 3];
-                                    count++;
-                                }
-                            }
-                            int dstIdx = (y * blur_size + x) * 4;
-                            blurBuffer[dstIdx + 0] = static_cast<BYTE>(total_b / count);
-                            blurBuffer[dstIdx + 1] = static_cast<BYTE>(total_g / count);
-                            blurBuffer[dstIdx + 2] = static_cast<BYTE>(total_r / count);
-                            blurBuffer[dstIdx + 3] = static_cast<BYTE>(total_a / count);
-                        }
-                    }
-
-                    Gdiplus::Bitmap blurred_artwork(target_width, target_height, PixelFormat32bppARGB);
-                    Gdiplus::Rect outRect(0, 0, target_width, target_height);
-                    Gdiplus::BitmapData outData;
-                    if (blurred_artwork.LockBits(&outRect, Gdiplus::ImageLockModeWrite, PixelFormat32bppARGB, &outData) == Gdiplus::Ok) {
-                        BYTE* outPixels = static_cast<BYTE*>(outData.Scan0);
-                        int outStride = outData.Stride;
-
-                        float targetAspect = static_cast<float>(target_width) / static_cast<float>(target_height);
-                        float srcX = 0, srcY = 0, srcW = static_cast<float>(blur_size), srcH = static_cast<float>(blur_size);
-
-                        if (targetAspect > 1.0f) {
-                            srcH = blur_size / targetAspect;
-                            srcY = (blur_size - srcH) / 2.0f;
-                        } else {
-                            srcW = blur_size * targetAspect;
-                            srcX = (blur_size - srcW) / 2.0f;
-                        }
-
-                        for (int y = 0; y < target_height; y++) {
-                            BYTE* outRow = outPixels + y * outStride;
-                            float sy_base = srcY + (y / static_cast<float>(target_height)) * srcH;
-
-                            for (int x = 0; x < target_width; x++) {
-                                float sx = srcX + (x / static_cast<float>(target_width)) * srcW;
-                                float sy = sy_base;
-
-                                int x0 = static_cast<int>(sx);
-                                int y0 = static_cast<int>(sy);
-                                int x1 = (std::min)(x0 + 1, blur_size - 1);
-                                int y1 = (std::min)(y0 + 1, blur_size - 1);
-                                x0 = (std::max)(0, (std::min)(x0, blur_size - 1));
-                                y0 = (std::max)(0, (std::min)(y0, blur_size - 1));
-
-                                float fx = sx - static_cast<int>(sx);
-                                float fy = sy - static_cast<int>(sy);
-                                float fx_inv = 1.0f - fx;
-                                float fy_inv = 1.0f - fy;
-
-                                int idx00 = (y0 * blur_size + x0) * 4;
-                                int idx10 = (y0 * blur_size + x1) * 4;
-                                int idx01 = (y1 * blur_size + x0) * 4;
-                                int idx11 = (y1 * blur_size + x1) * 4;
-
-                                for (int c = 0; c < 4; c++) {
-                                    float top_ch = blurBuffer[idx00 + c] * fx_inv + blurBuffer[idx10 + c] * fx;
-                                    float bottom_ch = blurBuffer[idx01 + c] * fx_inv + blurBuffer[idx11 + c] * fx;
-                                    outRow[x * 4 + c] = static_cast<BYTE>(top_ch * fy_inv + bottom_ch * fy);
-                                }
-                            }
-                        }
-
-                        blurred_artwork.UnlockBits(&outData);
-
-                        BYTE overlay_alpha = m_is_dark_mode ? 120 : 160;
-                        Gdiplus::Color overlayColor(overlay_alpha, 0, 0, 0);
-                        Gdiplus::SolidBrush overlayBrush(overlayColor);
-
-                        if (is_rounded) {
-                            Gdiplus::TextureBrush texBrush(&blurred_artwork, Gdiplus::WrapModeClamp);
-                            g.FillPath(&texBrush, &card_path);
-                            g.FillPath(&overlayBrush, &card_path);
-                        } else {
-                            g.DrawImage(&blurred_artwork, rect.left, rect.top, target_width, target_height);
-                            g.FillRectangle(&overlayBrush, rect.left, rect.top, target_width, target_height);
-                        }
-                        return;
-                    }
-                }
-            }
-        }
-    }
-
-    Gdiplus::SolidBrush bg_brush(Gdiplus::Color(255, GetRValue(m_bg_color), GetGValue(m_bg_color), GetBValue(m_bg_color)));
-    if (is_rounded) {
-        g.FillPath(&bg_brush, &card_path);
-    } else {
-        HBRUSH h_brush = CreateSolidBrush(m_bg_color);
-        FillRect(hdc, &rect, h_brush);
-        DeleteObject(h_brush);
-    }
-}
-
-void control_panel::draw_cover_art_styled(HDC hdc, HBITMAP hbmp, const RECT& rect, bool is_rounded) {
-    int w = rect.right - rect.left;
-    int h = rect.bottom - rect.top;
-    if (w <= 0 || h <= 0) return;
-
-    if (is_rounded) {
-        float radius = (w < h ? (float)w : (float)h) * 0.10f;
-        if (radius < 4.0f) radius = 4.0f;
-        if (radius > 12.0f) radius = 12.0f;
-        float d = radius * 2.0f;
-
-        // Draw artwork into an off-screen GDI+ bitmap for smooth anti-aliased corner rendering
-        Gdiplus::Bitmap offscreen(w, h, PixelFormat32bppPARGB);
-        {
-            Gdiplus::Graphics og(&offscreen);
-            og.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
-            og.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
-
-            if (hbmp) {
-                Gdiplus::Bitmap srcBitmap(hbmp, nullptr);
-                int srcW = srcBitmap.GetWidth();
-                int srcH = srcBitmap.GetHeight();
-                if (srcW > 0 && srcH > 0) {
-                    float srcAspect = (float)srcW / (float)srcH;
-                    float dstAspect = (float)w / (float)h;
-                    int cropX = 0, cropY = 0, cropW = srcW, cropH = srcH;
-                    if (srcAspect > dstAspect) {
-                        cropH = srcH;
-                        cropW = (int)(srcH * dstAspect);
-                        cropX = (srcW - cropW) / 2;
-                    } else {
-                        cropW = srcW;
-                        cropH = (int)(srcW / dstAspect);
-                        cropY = (srcH - cropH) / 2;
-                    }
-                    Gdiplus::Rect destRect(0, 0, w, h);
-                    og.DrawImage(&srcBitmap, destRect, cropX, cropY, cropW, cropH, Gdiplus::UnitPixel);
-                } else {
-                    Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(m_placeholder_color), GetGValue(m_placeholder_color), GetBValue(m_placeholder_color)));
-                    og.FillRectangle(&brush, 0, 0, w, h);
-                }
-            } else {
-                Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(m_placeholder_color), GetGValue(m_placeholder_color), GetBValue(m_placeholder_color)));
-                og.FillRectangle(&brush, 0, 0, w, h);
-            }
-        }
-
-        // Build rounded-rect path in destination coordinates
-        float x = (float)rect.left;
-        float y = (float)rect.top;
-        float fw = (float)w;
-        float fh = (float)h;
-
-        Gdiplus::GraphicsPath roundedPath;
-        roundedPath.AddArc(x, y, d, d, 180, 90);
-        roundedPath.AddArc(x + fw - d, y, d, d, 270, 90);
-        roundedPath.AddArc(x + fw - d, y + fh - d, d, d, 0, 90);
-        roundedPath.AddArc(x, y + fh - d, d, d, 90, 90);
-        roundedPath.CloseFigure();
-
-        // TextureBrush + FillPath with AntiAlias produces silky-smooth rounded corners
-        Gdiplus::Graphics g(hdc);
-        Gdiplus::TextureBrush texBrush(&offscreen, Gdiplus::WrapModeClamp);
-        texBrush.TranslateTransform((float)rect.left, (float)rect.top);
-
-        Gdiplus::SmoothingMode prevSmoothing = g.GetSmoothingMode();
-        g.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-        g.FillPath(&texBrush, &roundedPath);
-        g.SetSmoothingMode(prevSmoothing);
-    } else {
-        if (hbmp) {
-            HDC cover_dc = CreateCompatibleDC(hdc);
-            HBITMAP old_bm = (HBITMAP)SelectObject(cover_dc, hbmp);
-            BITMAP bmp_info;
-            GetObject(hbmp, sizeof(BITMAP), &bmp_info);
-            SetStretchBltMode(hdc, HALFTONE);
-            StretchBlt(hdc, rect.left, rect.top, w, h, cover_dc, 0, 0, bmp_info.bmWidth, bmp_info.bmHeight, SRCCOPY);
-            SelectObject(cover_dc, old_bm);
-            DeleteDC(cover_dc);
-        } else {
-            HBRUSH cover_brush = CreateSolidBrush(m_placeholder_color);
-            FillRect(hdc, &rect, cover_brush);
-        }
-    }
-}
-
-static void draw_panel_border_style(HDC hdc, const RECT& rect, bool is_dark, bool is_rounded) {
-    int w = rect.right - rect.left;
-    int h = rect.bottom - rect.top;
-    if (w <= 0 || h <= 0) return;
-
-    COLORREF border_color = is_dark ? RGB(60, 60, 64) : RGB(218, 218, 222);
-    Gdiplus::Graphics g(hdc);
-    g.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    Gdiplus::Pen pen(Gdiplus::Color(255, GetRValue(border_color), GetGValue(border_color), GetBValue(border_color)), 1.0f);
-
-    if (is_rounded) {
-        float stroke = 1.0f;
-        float pad = stroke * 0.5f;
-        float radius = 8.0f;
-        float x = pad, y = pad, fw = (float)w - stroke, fh = (float)h - stroke;
-
-        Gdiplus::GraphicsPath path;
-        add_rounded_rect_path(path, x, y, fw, fh, radius);
-        g.DrawPath(&pen, &path);
-    } else {
-        g.DrawRectangle(&pen, 0, 0, w - 1, h - 1);
-    }
-}
-
-void control_panel::paint_control_panel(HDC hdc) {
-    if (!hdc || !m_control_window) return;
-
-    RECT client_rect;
-    GetClientRect(m_control_window, &client_rect);
-    
-    // Handle artwork expanded mode
-    if (m_is_artwork_expanded) {
-        paint_artwork_expanded(hdc, client_rect);
-        return;
-    }
-    
-    // Handle compact mode
-    if (m_is_compact_mode) {
-        paint_compact_mode(hdc, client_rect);
-        return;
-    }
-    
-    // Fill background using configured background style
-    paint_background_style(hdc, client_rect);
-    
-    int window_width = client_rect.right - client_rect.left;
-    int window_height = client_rect.bottom - client_rect.top;
-    
-    bool show_art = get_show_cover_art();
-    int art_size = 0;
-    
-    if (show_art) {
-        bool has_margin = get_cover_margin();
-        RECT cover_rect;
-        if (has_margin) {
-            art_size = (80 < (window_width - 30) ? 80 : (window_width - 30));
-            art_size = (art_size < (window_height - 30) ? art_size : (window_height - 30));
-            cover_rect = {15, 15, 15 + art_size, 15 + art_size};
-        } else {
-            art_size = window_height;
-            cover_rect = {0, 0, art_size, art_size};
-        }
-        
-        bool is_rounded = (get_cover_style() == 1);
-        draw_cover_art_styled(hdc, m_cover_art_bitmap, cover_rect, is_rounded);
-        
-        if (!m_cover_art_bitmap && m_is_stream) {
-            // Draw stream/radio icon placeholder for internet streams
-            HICON radio_icon = (HICON)LoadImage(g_hIns, MAKEINTRESOURCE(IDI_RADIO_ICON), IMAGE_ICON, art_size/2, art_size/2, LR_DEFAULTCOLOR);
-            if (!radio_icon) radio_icon = LoadIcon(g_hIns, MAKEINTRESOURCE(IDI_RADIO_ICON));
-            if (radio_icon) {
-                int icon_size = art_size / 2;
-                int icon_x = cover_rect.left + (art_size - icon_size) / 2;
-                int icon_y = cover_rect.top + (art_size - icon_size) / 2;
-                DrawIconEx(hdc, icon_x, icon_y, radio_icon, icon_size, icon_size, 0, nullptr, DI_NORMAL);
-                DestroyIcon(radio_icon);
-            }
-        }
-    }
-    
-    // Draw track info (pass art_size for adaptive layout)
-    draw_track_info(hdc, client_rect, art_size);
-
-    // Draw time info
-    draw_time_info(hdc, client_rect);
-
-    // Draw undocked artwork overlay if hovering over artwork
-    if (m_undocked_overlay_visible) {
-        draw_undocked_artwork_overlay(hdc, window_width, window_height);
-    }
-
-    // Draw control buttons using custom vector graphics - adapt to window size
-    int button_y = window_height - 30; // 30px from bottom
-    
-    // Spacing depends on mode: 
-    // Undocked: 5 buttons -> Tighter spacing (40)
-    // Docked: 3 buttons -> Wider spacing (60)
-    // Center buttons in the area to the right of artwork (artwork is ~95px including margin)
-    int button_area_left = 15 + art_size + 10; // x after artwork area
-    int button_area_width = window_width - button_area_left - 10; // Available width for buttons
-    int center_x = button_area_left + button_area_width / 2;
-
-    int button_spacing = (m_is_undocked) ? 40 : 60;
-    int icon_size = 24; // Size for shuffle, repeat, prev, next
-    int play_icon_size = 36; // Play/Pause button size (reduced by 5% from 38px to 36px)
-
-    // Dynamically scale button sizes and spacing for extremely narrow undocked window widths (< 280px)
-    if (m_is_undocked && window_width < 280) {
-        button_spacing = (button_area_width * 16) / 100;
-        if (button_spacing < 24) button_spacing = 24;
-
-        icon_size = (button_area_width * 9) / 100;
-        if (icon_size < 16) icon_size = 16;
-
-        play_icon_size = (button_area_width * 14) / 100;
-        if (play_icon_size < 24) play_icon_size = 24;
-    }
-
-    // Draw Previous button (enlarged on hover)
-    int prev_x = center_x - button_spacing;
-    int prev_size = (m_hovered_button == BTN_PREV) ? (int)(icon_size * HOVER_ZOOM_FACTOR) : icon_size;
-    draw_previous_icon(hdc, prev_x, button_y, prev_size);
-
-    // Draw Play/Pause button (Larger) - enlarged on hover (15% zoom factor)
-    float play_zoom_factor = HOVER_ZOOM_FACTOR - 0.15f;
-    int play_size = (m_hovered_button == BTN_PLAYPAUSE) ? (int)(play_icon_size * play_zoom_factor) : play_icon_size;
-    if (m_is_undocked && !m_is_artwork_expanded) {
-        if (m_is_playing && !m_is_paused) {
-            draw_pause_icon_with_opacity(hdc, center_x, button_y, play_size, m_button_opacity);
-        } else {
-            draw_play_icon_with_opacity(hdc, center_x, button_y, play_size, m_button_opacity);
-        }
-    } else {
-        if (m_is_playing && !m_is_paused) {
-            draw_pause_icon(hdc, center_x, button_y, play_size);
-        } else {
-            draw_play_icon(hdc, center_x, button_y, play_size);
-        }
-    }
-
-    // Draw Next button (enlarged on hover)
-    int next_x = center_x + button_spacing;
-    int next_size = (m_hovered_button == BTN_NEXT) ? (int)(icon_size * HOVER_ZOOM_FACTOR) : icon_size;
-    draw_next_icon(hdc, next_x, button_y, next_size);
-    
-    // Draw Shuffle and Repeat ONLY in undocked mode
-    if (m_is_undocked) {
-        // Draw Shuffle button (left of Previous) - enlarged on hover
-        int shuffle_x = center_x - button_spacing * 2;
-        int shuffle_size = (m_hovered_button == BTN_SHUFFLE) ? (int)(icon_size * HOVER_ZOOM_FACTOR) : icon_size;
-        draw_shuffle_icon(hdc, shuffle_x, button_y, shuffle_size);
-        
-        // Draw Repeat button (right of Next) - enlarged on hover
-        int repeat_x = center_x + button_spacing * 2;
-        int repeat_size = (m_hovered_button == BTN_REPEAT) ? (int)(icon_size * HOVER_ZOOM_FACTOR) : icon_size;
-        draw_repeat_icon(hdc, repeat_x, button_y, repeat_size);
-    }
-
-    // Draw Close button in upper right corner and Collapse triangle in bottom right corner
-    if (m_is_undocked && !m_is_artwork_expanded && m_mouse_in_window) {
-        POINT cursor_pos;
-        GetCursorPos(&cursor_pos);
-        RECT window_rect;
-        GetWindowRect(m_control_window, &window_rect);
-        
-        // Check if cursor is within window bounds
-        bool cursor_in_window = (cursor_pos.x >= window_rect.left && cursor_pos.x < window_rect.right &&
-                                 cursor_pos.y >= window_rect.top && cursor_pos.y < window_rect.bottom);
-        
-        if (!cursor_in_window) {
-            m_mouse_in_window = false;
-        } else {
-            // Also exclude artwork area
-            POINT client_pt = cursor_pos;
-            ScreenToClient(m_control_window, &client_pt);
-            int art_size = (80 < (window_width - 30) ? 80 : (window_width - 30));
-            art_size = (art_size < (window_height - 30) ? art_size : (window_height - 30));
-            if (client_pt.x >= 15 && client_pt.x < 15 + art_size && 
-                client_pt.y >= 15 && client_pt.y < 15 + art_size) {
-                cursor_in_window = false; // Don't show corner controls when over artwork
+        case WM_WTSSESSION_CHANGE:
+        case WM_POWERBROADCAST:
+            {
+                unsigned previous = panel->m_render_throttle.get_reasons();
+                panel->m_render_throttle.handle_message(msg, wparam, lparam);
+                if (panel->m_render_throttle.get_reasons() != previous) {
+                    panel->on_render_throttle_changed(previous);
+                }
             }
-        }
-        
-        if (cursor_in_window) {
-            // Draw close button in upper right corner
-            int close_size = 12;
-            int close_x = window_width - 15;
-            int close_y = 15;
-            draw_close_icon_with_opacity(hdc, close_x, close_y, close_size, 100);
-
-            // Draw collapse triangle in bottom right corner
-            int collapse_size = 12;
-            int collapse_x = window_width - 15;
-            int collapse_y = window_height - 15;
-            draw_collapse_triangle(hdc, collapse_x, collapse_y, collapse_size, 100);
-        }
-    }
-    
-    bool is_rounded_border = (get_miniplayer_border_style() == 1);
-    draw_panel_border_style(hdc, client_rect, m_is_dark_mode, is_rounded_border);
-}
-
-void control_panel::paint_artwork_expanded(HDC hdc, const RECT& client_rect) {
-    // Calculate artwork display area
-    int window_width = client_rect.right - client_rect.left;
-    int window_height = client_rect.bottom - client_rect.top;
-    
-    // Use double buffering to prevent flicker during overlay animations
-    HDC buffer_dc = CreateCompatibleDC(hdc);
-    HBITMAP buffer_bitmap = CreateCompatibleBitmap(hdc, window_width, window_height);
-    HBITMAP old_buffer_bitmap = (HBITMAP)SelectObject(buffer_dc, buffer_bitmap);
-    
-    // Use original resolution bitmap if available, otherwise fall back to standard bitmap
-    // (bridge artwork from foo_artwork only provides m_cover_art_bitmap, not the _original variant)
-    HBITMAP art_bitmap = m_cover_art_bitmap_original ? m_cover_art_bitmap_original : m_cover_art_bitmap;
-    int art_width = m_original_art_width;
-    int art_height = m_original_art_height;
-
-    // For bridge artwork (no original bitmap), get dimensions from the standard bitmap
-    if (!m_cover_art_bitmap_original && m_cover_art_bitmap) {
-        BITMAP bm;
-        if (GetObject(m_cover_art_bitmap, sizeof(bm), &bm)) {
-            art_width = bm.bmWidth;
-            art_height = bm.bmHeight;
-        }
-    }
-
-    if (art_bitmap && art_width > 0 && art_height > 0) {
-        HDC cover_dc = CreateCompatibleDC(buffer_dc);
-        HBITMAP old_bitmap = (HBITMAP)SelectObject(cover_dc, art_bitmap);
-
-        // Set high-quality stretching mode
-        SetStretchBltMode(buffer_dc, HALFTONE);
-        SetBrushOrgEx(buffer_dc, 0, 0, nullptr);
+            break;
 
-        // Since window maintains aspect ratio, artwork should fill entire window
-        // Draw the artwork to fill the entire client area (no black bars)
-        StretchBlt(buffer_dc, 0, 0, window_width, window_height,
-                   cover_dc, 0, 0, art_width, art_height, SRCCOPY);
+        case WM_MOUSEWHEEL:
+            if (panel->is_up_next_shown() && panel->m_up_next.handle_wheel(GET_WHEEL_DELTA_WPARAM(wparam))) {
+                return 0;
+            }
+            break;
 
-        SelectObject(cover_dc, old_bitmap);
-        DeleteDC(cover_dc);
+        // Type-to-search in the Up Next pane
+        case WM_CHAR:
+            if (panel->is_up_next_shown() && panel->m_up_next.handle_char((wchar_t)wparam)) {
+                return 0;
+            }
+            break;
 
-        // Draw track info overlay if hovering
-        if (m_overlay_visible) {
-            draw_track_info_overlay(buffer_dc, window_width, window_height);
-            draw_control_overlay(buffer_dc, window_width, window_height);
-        }
-        
-    } else {
-        // Draw placeholder for no artwork
-        RECT artwork_rect = {0, 0, window_width, window_height};
-        HBRUSH placeholder_brush = CreateSolidBrush(RGB(60, 60, 60));
-        FillRect(buffer_dc, &artwork_rect, placeholder_brush);
-        DeleteObject(placeholder_brush);
-        
-        // Check if current track is a stream and show radio icon
-        if (m_is_stream) {
-            // Load and draw radio icon for internet streams (use larger size for expanded view)
-            int icon_size = (window_width < window_height ? window_width : window_height) / 4; // Quarter of smallest dimension
-            HICON radio_icon = (HICON)LoadImage(g_hIns, MAKEINTRESOURCE(IDI_RADIO_ICON), IMAGE_ICON, icon_size, icon_size, LR_DEFAULTCOLOR);
-            
-            if (!radio_icon) {
-                radio_icon = LoadIcon(g_hIns, MAKEINTRESOURCE(IDI_RADIO_ICON));
+        case WM_KEYDOWN:
+            if (panel->is_up_next_shown() && panel->m_up_next.handle_key((UINT)wparam)) {
+                return 0;
             }
-            
-            if (radio_icon) {
-                int icon_x = (window_width - icon_size) / 2;
-                int icon_y = (window_height - icon_size) / 2;
-                
-                DrawIconEx(buffer_dc, icon_x, icon_y, radio_icon, icon_size, icon_size, 0, nullptr, DI_NORMAL);
-                DestroyIcon(radio_icon);
-            } else {
-                // Fallback to text if icon can't be loaded
-                SetTextColor(buffer_dc, RGB(200, 200, 200));
-                SetBkMode(buffer_dc, TRANSPARENT);
-                int font_size = (window_width < window_height ? window_width : window_height) / 8; // Larger font for expanded view
-                HFONT symbol_font = CreateFont(font_size, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                               DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                               DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI Symbol");
-                HFONT old_symbol_font = (HFONT)SelectObject(buffer_dc, symbol_font);
-                
-                DrawText(buffer_dc, L"📻", -1, &artwork_rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
-                
-                SelectObject(buffer_dc, old_symbol_font);
-                DeleteObject(symbol_font);
+            break;
+
+        case WM_KILLFOCUS:
+        case WM_ACTIVATE:
+            if (LOWORD(wparam) == WA_INACTIVE) {
+                // TEMPORARILY DISABLED: Hide panel when it loses focus - testing timeout timer
+                // if (panel && !panel->m_is_undocked) {
+                //     panel->hide_control_panel_immediate();
+                // }
+                return 0;
             }
-        } else {
-            // Draw musical note symbol for local files
-            SetTextColor(buffer_dc, RGB(200, 200, 200));
-            SetBkMode(buffer_dc, TRANSPARENT);
-            int font_size = (window_width < window_height ? window_width : window_height) / 8;
-            HFONT symbol_font = CreateFont(font_size, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                           DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                           DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI Symbol");
-            HFONT old_symbol_font = (HFONT)SelectObject(buffer_dc, symbol_font);
-            
-            DrawText(buffer_dc, L"♪", -1, &artwork_rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
-            
-            SelectObject(buffer_dc, old_symbol_font);
-            DeleteObject(symbol_font);
-        }
-        
-        // Draw overlay even when no artwork (controls should appear on hover)
-        if (m_overlay_visible) {
-            draw_track_info_overlay(buffer_dc, window_width, window_height);
-            draw_control_overlay(buffer_dc, window_width, window_height);
         }
     }
     
-    // Copy the complete buffered image to the screen in one operation
-    BitBlt(hdc, 0, 0, window_width, window_height, buffer_dc, 0, 0, SRCCOPY);
-    
-    // Cleanup buffer
-    SelectObject(buffer_dc, old_buffer_bitmap);
-    DeleteObject(buffer_bitmap);
-    DeleteDC(buffer_dc);
+    return DefWindowProc(hwnd, msg, wparam, lparam);
 }
 
-void control_panel::draw_track_info(HDC hdc, const RECT& client_rect, int art_size) {
-    SetTextColor(hdc, m_text_color);
-    SetBkMode(hdc, TRANSPARENT);
-    
-    // Calculate text area based on artwork size and window dimensions
-    int text_left = 15 + art_size + 10; // 10px gap after artwork
-    int text_right = client_rect.right - 70; // Leave space for time display
-    
-    // Determine font styles based on mode (docked vs undocked)
-    bool is_docked = !m_is_undocked;
-    
-    if (is_docked) {
-        // DOCKED MODE: Track title large and bold, Artist small and normal
-        // Draw track title using larger, bold font
-        HFONT title_font_to_use = m_track_font ? m_track_font : CreateFont(get_dpi_scaled_font_height(14), 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                                                                           DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                                                           DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
-        HFONT old_font = (HFONT)SelectObject(hdc, title_font_to_use);
-        
-        RECT title_rect = {text_left, 20, text_right, 45};
-        // Track title with ticker animation (right-to-left and back) for long titles
-        update_title_ticker(hdc, m_current_title, title_font_to_use, title_rect);
-        
-        // Draw artist using smaller, normal font
-        HFONT artist_font_to_use = m_artist_font ? m_artist_font : CreateFont(get_dpi_scaled_font_height(11), 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                                                              DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                                                              DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
-        
-        RECT artist_rect = {text_left, 50, text_right, 70};
-        update_artist_ticker(hdc, m_current_artist, artist_font_to_use, artist_rect, m_text_dim_color);
-        
-        // Cleanup fonts (only delete fallback fonts, not our member fonts)
-        SelectObject(hdc, old_font);
-        if (!m_track_font && title_font_to_use) {
-            DeleteObject(title_font_to_use);
-        }
-        if (!m_artist_font && artist_font_to_use) {
-            DeleteObject(artist_font_to_use);
-        }
-    } else {
-        // UNDOCKED MODE: Keep original behavior (title bold 18, artist normal 14)
-        // Draw track title using custom or default font
-        HFONT font_to_use = m_track_font ? m_track_font : CreateFont(get_dpi_scaled_font_height(14), 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                                                                     DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                                                     DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
-        HFONT old_font = (HFONT)SelectObject(hdc, font_to_use);
-        
-        RECT title_rect = {text_left, 20, text_right, 45};
-        // Track title with ticker animation (right-to-left and back) for long titles
-        update_title_ticker(hdc, m_current_title, font_to_use, title_rect);
-        
-        // Draw artist using custom or default font
-        HFONT artist_font_to_use = m_artist_font ? m_artist_font : CreateFont(get_dpi_scaled_font_height(11), 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                                                              DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                                                              DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
-        
-        RECT artist_rect = {text_left, 50, text_right, 70};
-        update_artist_ticker(hdc, m_current_artist, artist_font_to_use, artist_rect, m_text_dim_color);
-        
-        // Cleanup fonts (only delete fallback fonts, not our member fonts)
-        SelectObject(hdc, old_font);
-        if (!m_track_font && font_to_use) {
-            DeleteObject(font_to_use);
-        }
-        if (!m_artist_font && artist_font_to_use) {
-            DeleteObject(artist_font_to_use);
-        }
-    }
-
-    bool is_rounded_border = (get_miniplayer_border_style() == 1);
-    draw_panel_border_style(hdc, client_rect, m_is_dark_mode, is_rounded_border);
+panel_theme control_panel::get_panel_theme() const {
+    panel_theme theme;
+    theme.dark = m_is_dark_mode;
+    theme.background = canvas_color_from_colorref(m_bg_color);
+    theme.text = canvas_color_from_colorref(m_text_color);
+    theme.text_dim = canvas_color_from_colorref(m_text_dim_color);
+    theme.placeholder = canvas_color_from_colorref(m_placeholder_color);
+    theme.progress_background = canvas_color_from_colorref(m_progress_bg_color);
+    theme.icon = canvas_color_from_colorref(m_icon_color);
+    return theme;
 }
 
-void control_panel::paint_compact_mode(HDC hdc, const RECT& rect) {
-    if (!hdc) return;
-    
-    // Fill background using configured background style
-    paint_background_style(hdc, rect);
-    
-    int window_width = rect.right - rect.left;
-    int window_height = rect.bottom - rect.top;
-    
-    int margin = 5;
-    bool show_art = get_show_cover_art();
-    bool has_margin = get_cover_margin();
-    int art_size = 0;
-    
-    if (show_art) {
-        RECT art_rect;
-        if (has_margin) {
-            art_size = window_height - (2 * margin);
-            art_rect = {margin, margin, margin + art_size, margin + art_size};
-        } else {
-            art_size = window_height;
-            art_rect = {0, 0, art_size, art_size};
-        }
+panel_button control_panel::get_hovered_panel_button() const {
+    switch (m_hovered_button) {
+    case BTN_PREV: return panel_button_prev;
+    case BTN_PLAYPAUSE: return panel_button_play_pause;
+    case BTN_NEXT: return panel_button_next;
+    case BTN_SHUFFLE: return panel_button_shuffle;
+    case BTN_REPEAT: return panel_button_repeat;
+    default: return panel_button_none;
+    }
+}
 
-        bool is_rounded = (get_cover_style() == 1);
-        draw_cover_art_styled(hdc, m_cover_art_bitmap, art_rect, is_rounded);
-        
-        if (m_undocked_overlay_visible) {
-            draw_undocked_artwork_overlay(hdc, window_width, window_height);
+// Loaded once, large enough to stay sharp when scaled down to the artwork
+const canvas_image& control_panel::get_radio_icon() {
+    if (m_radio_icon.empty()) {
+        const int size = 128;
+        HICON icon = (HICON)LoadImage(g_hIns, MAKEINTRESOURCE(IDI_RADIO_ICON), IMAGE_ICON, size, size, LR_DEFAULTCOLOR);
+        if (icon) {
+            canvas_image_from_icon(icon, size, m_radio_icon, m_radio_icon_pixels);
+            DestroyIcon(icon);
         }
     }
-    
-    // Set text properties
-    SetTextColor(hdc, m_text_color);
-    SetBkMode(hdc, TRANSPARENT);
-    
-    // Calculate text area based on cover artwork and margin settings
-    int text_left = margin + 5;
-    if (show_art && art_size > 0) {
-        text_left = has_margin ? (margin + art_size + margin + 10) : (art_size + 10);
-    }
-    int text_right = window_width - margin;
-    
-    // Draw song title (use configured track font, fallback to default if not set)
-    HFONT title_font = m_track_font;
-    bool need_delete_title = false;
-    if (!title_font) {
-        title_font = CreateFont(get_dpi_scaled_font_height(15), 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                                  DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                  DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Microsoft YaHei UI");
-        need_delete_title = true;
-    }
-    HFONT old_font = (HFONT)SelectObject(hdc, title_font);
-    
-    HFONT artist_font = m_artist_font;
-    bool need_delete_artist = false;
-    if (!artist_font) {
-        artist_font = CreateFont(get_dpi_scaled_font_height(12), 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                   DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                   DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Microsoft YaHei UI");
-        need_delete_artist = true;
-    }
-
-    // Draw track title and artist text only when control overlay is not active
-    if (!m_compact_controls_visible) {
-        int title_bottom = margin + (int)(window_height * 0.36);
-        RECT title_rect = {text_left, margin, text_right, title_bottom};
-        // Track title with ticker animation (right-to-left and back) for long titles
-        update_title_ticker(hdc, m_current_title, title_font, title_rect);
-        
-                        int artist_top = margin + (int)(window_height * 0.31);
-        int artist_bottom = margin + (int)(window_height * 0.63);
-        RECT artist_rect = {text_left, artist_top, text_right, artist_bottom};
-        update_artist_ticker(hdc, m_current_artist, artist_font, artist_rect, m_text_dim_color);
-    }
-    
-    // Calculate elapsed time text dimensions dynamically using active m_timer_font to prevent clipping at high DPI / 2160p
-    wchar_t time_str[16] = L"";
-    int time_width_needed = 0;
-    int time_height_needed = 0;
-    
-    if (m_is_playing) {
-        int elapsed_min = (int)(m_current_time / 60);
-        int elapsed_sec = (int)m_current_time % 60;
-        swprintf_s(time_str, 16, L"%d:%02d", elapsed_min, elapsed_sec);
-        
-        HFONT old_font = (HFONT)SelectObject(hdc, m_timer_font);
-        SIZE text_size = {};
-        GetTextExtentPoint32W(hdc, time_str, (int)wcslen(time_str), &text_size);
-        
-        SIZE sample_size = {};
-        GetTextExtentPoint32W(hdc, L"00:00", 5, &sample_size);
-        
-        time_width_needed = (std::max)((int)text_size.cx, (int)sample_size.cx);
-        time_height_needed = (std::max)((int)text_size.cy, (int)sample_size.cy);
-        SelectObject(hdc, old_font);
-    }
-    
-    // Draw progress bar at bottom - moved up by 10%
-    int progress_bar_height = 5;
-    int progress_bar_y = window_height - progress_bar_height - 2 - (int)(window_height * 0.1); // Move up by 10%
-    int progress_bar_left = text_left; // Start under artist name
-    
-    // Dynamically calculate progress_bar_width based on exact time text width + gap
-    int gap = 6;
-    int reserved_right_space = (m_is_playing && time_width_needed > 0) ? (time_width_needed + gap) : 0;
-    int progress_bar_width = text_right - text_left - reserved_right_space;
-    if (progress_bar_width < 10) progress_bar_width = 10;
-    
-    // Calculate progress
-    double progress_ratio = (m_track_length > 0) ? (m_current_time / m_track_length) : 0.0;
-    if (progress_ratio > 1.0) progress_ratio = 1.0;
-    if (progress_ratio < 0.0) progress_ratio = 0.0;
-    
-    // Draw progress bar background
-    RECT progress_bg_rect = {progress_bar_left, progress_bar_y, progress_bar_left + progress_bar_width, progress_bar_y + progress_bar_height};
-    HBRUSH progress_bg_brush = CreateSolidBrush(m_progress_bg_color);
-    FillRect(hdc, &progress_bg_rect, progress_bg_brush);
-    DeleteObject(progress_bg_brush);
-    
-    // Draw progress bar fill
-    int progress_fill_width = (int)(progress_bar_width * progress_ratio);
-    if (progress_fill_width > 0) {
-        RECT progress_fill_rect = {progress_bar_left, progress_bar_y, progress_bar_left + progress_fill_width, progress_bar_y + progress_bar_height};
-        // User-configurable accent color (Progress Accent preference)
-        HBRUSH progress_fill_brush = CreateSolidBrush(get_compact_progress_color());
-        FillRect(hdc, &progress_fill_rect, progress_fill_brush);
-        DeleteObject(progress_fill_brush);
-    }
-    
-    // Draw elapsed time (count up, like Docked and Undocked modes)
-    if (m_is_playing && time_width_needed > 0) {
-        // Use the configurable timer font
-        HFONT old_font = (HFONT)SelectObject(hdc, m_timer_font);
-        SetTextColor(hdc, m_text_color); // Match artist color
-        SetBkMode(hdc, TRANSPARENT);
-        
-        // Dynamically center time_rect vertically relative to progress bar center line to avoid vertical clipping
-        int bar_center_y = progress_bar_y + (progress_bar_height / 2);
-        int half_rect_height = (time_height_needed / 2) + 4;
-        int time_top = bar_center_y - half_rect_height;
-        int time_bottom = bar_center_y + half_rect_height;
-        
-        RECT time_rect = {text_right - time_width_needed, time_top, text_right, time_bottom};
-        DrawText(hdc, time_str, -1, &time_rect, DT_RIGHT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
-        
-        SelectObject(hdc, old_font);
-    }
-    
-    // Draw compact control overlay if hovering over text area
-    draw_compact_control_overlay(hdc, window_width, window_height);
-    
-    // Draw Close button in upper right corner and Collapse triangle in bottom right corner when mouse is over compact window
-    POINT cursor_pos;
-    GetCursorPos(&cursor_pos);
-    RECT window_rect;
-    GetWindowRect(m_control_window, &window_rect);
-    
-    bool cursor_in_window = (cursor_pos.x >= window_rect.left && cursor_pos.x < window_rect.right &&
-                             cursor_pos.y >= window_rect.top && cursor_pos.y < window_rect.bottom);
-    
-    if (cursor_in_window) {
-        int close_size = 12;
-        int close_x = window_width - 15;
-        int close_y = 15;
-        draw_close_icon_with_opacity(hdc, close_x, close_y, close_size, 100);
-    }
-    
-    // Cleanup fonts
-    SelectObject(hdc, old_font);
-    if (need_delete_title) {
-        DeleteObject(title_font);
-    }
-    if (need_delete_artist) {
-        DeleteObject(artist_font);
-    }
-
-    bool is_rounded_border = (get_miniplayer_border_style() == 1);
-    draw_panel_border_style(hdc, rect, m_is_dark_mode, is_rounded_border);
+    return m_radio_icon;
 }
 
-void control_panel::draw_time_info(HDC hdc, const RECT& client_rect) {
-    if (!m_is_playing) return;
-
-    SetTextColor(hdc, m_text_color); // Same color as track title
-    SetBkMode(hdc, TRANSPARENT);
-    
-    // Format current position time in 24hr format (MM:SS with leading zeros)
-    int current_min = (int)(m_current_time / 60);
-    int current_sec = (int)m_current_time % 60;
-    
-    pfc::string8 time_str;
-    time_str << pfc::format_int(current_min, 2) << ":" << pfc::format_int(current_sec, 2);
-    
-    // Use the configurable timer font
-    HFONT old_font = (HFONT)SelectObject(hdc, m_timer_font);
-    
-    pfc::stringcvt::string_wide_from_utf8 wide_time(time_str.c_str());
-    SIZE text_size = {};
-    GetTextExtentPoint32W(hdc, wide_time.get_ptr(), (int)wcslen(wide_time.get_ptr()), &text_size);
+void control_panel::paint_control_panel(HDC hdc) {
+    if (!hdc || !m_control_window) return;
 
-    int width = (std::max)((int)text_size.cx + 8, 50);
-    int height = (std::max)((int)text_size.cy + 8, 25);
-    int center_y = 32; // middle of title/artist height area
-    
-    RECT time_rect = {client_rect.right - width - 10, center_y - (height / 2), client_rect.right - 10, center_y + (height / 2)};
-    DrawText(hdc, wide_time.get_ptr(), -1, &time_rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
-    
-    SelectObject(hdc, old_font);
-}
+    RECT client_rect;
+    GetClientRect(m_control_window, &client_rect);
+    const int width = client_rect.right - client_rect.left;
+    const int height = client_rect.bottom - client_rect.top;
+    if (width <= 0 || height <= 0) return;
+    const tray_settings& settings = get_settings();
+
+    // Spectrum bars and perf phases need the window's surface and counters
+    class window_layers : public panel_paint_layers {
+    public:
+        explicit window_layers(control_panel& panel) : m_panel(panel), m_gfx(nullptr) {}
+        void attach(gdiplus_canvas* gfx) { m_gfx = gfx; }
+
+        void spectrum(canvas&, int left, int top, int right, int bottom) override {
+            // The bars blend straight into the surface's pixels
+            if (m_gfx) m_gfx->flush();
+            RECT bars = { left, top, right, bottom };
+            m_panel.draw_spectrum(m_panel.m_paint_surface, bars, control_panel::SPECTRUM_COMPACT_ALPHA);
+        }
 
-void control_panel::draw_track_info_overlay(HDC hdc, int window_width, int window_height) {
-    // Don't return early when no title/artist - overlay should still appear for controls
-    
-    // Track title (use configured track font, fallback to default if not set)
-    HFONT title_font = m_track_font;
-    bool need_delete_title = false;
-    if (!title_font) {
-        title_font = CreateFont(get_dpi_scaled_font_height(20), 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                                 DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                 DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
-        need_delete_title = true;
-    }
-    
-    // Artist name (use configured artist font, fallback to default if not set)
-    HFONT artist_font = m_artist_font;
-    bool need_delete_artist = false;
-    if (!artist_font) {
-        artist_font = CreateFont(get_dpi_scaled_font_height(14), 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                  DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                  DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
-        need_delete_artist = true;
-    }
-
-    // Dynamically measure font metrics to guarantee sufficient bounding box heights and proper line spacing
-    TEXTMETRIC tm_title = {};
-    HFONT old_font = (HFONT)SelectObject(hdc, title_font);
-    GetTextMetrics(hdc, &tm_title);
-    SelectObject(hdc, old_font);
-
-    TEXTMETRIC tm_artist = {};
-    old_font = (HFONT)SelectObject(hdc, artist_font);
-    GetTextMetrics(hdc, &tm_artist);
-    SelectObject(hdc, old_font);
-
-    int title_h = tm_title.tmHeight;
-    int artist_h = tm_artist.tmHeight;
-    if (title_h <= 0) title_h = 24;
-    if (artist_h <= 0) artist_h = 18;
-
-    // Dynamic line spacing proportional to font size (min 6px for comfortable breathing room)
-    int spacing = (std::max)(6, (int)(artist_h * 0.35f));
-    int total_text_h = title_h + spacing + artist_h;
-
-    // Calculate dynamic overlay height (minimum 70px, or dynamic height if text block is larger)
-    int padding_v = (std::max)(10, (int)(title_h * 0.35f));
-    int overlay_height = (std::max)(70, total_text_h + (padding_v * 2));
-
-    if (m_overlay_opacity > 0) {
-        // Use GDI+ for true alpha blending (glass effect)
-        Gdiplus::Graphics graphics(hdc);
-        graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-        
-        // Calculate alpha based on overlay opacity (0-100 -> 0-255 range, but make it semi-transparent)
-        // Use around 60% max opacity for glass effect
-        int alpha = (180 * m_overlay_opacity) / 100;
-        
-        // Use theme-aware overlay color: dark overlay for dark mode, light overlay for light mode
-        int overlay_color = m_is_dark_mode ? 20 : 240;
-        Gdiplus::SolidBrush overlayBrush(Gdiplus::Color(alpha, overlay_color, overlay_color, overlay_color));
-        // Start at -1 to eliminate sub-pixel gap at top edge from anti-aliasing
-        Gdiplus::RectF overlayRect(-1.0f, -1.0f, (float)window_width + 2.0f, (float)overlay_height + 1.0f);
-        graphics.FillRectangle(&overlayBrush, overlayRect);
-    }
-    
-    // Draw track info text on top of the overlay (only when overlay has opacity)
-    if (m_overlay_opacity > 0) {
-        // Use theme-aware text color: white for dark mode, black for light mode
-        SetTextColor(hdc, m_is_dark_mode ? RGB(255, 255, 255) : RGB(32, 32, 32));
-        SetBkMode(hdc, TRANSPARENT);
-    
-        int start_y = (overlay_height - total_text_h) / 2;
-
-        // Position title - dynamic rect based on tmHeight
-        old_font = (HFONT)SelectObject(hdc, title_font);
-        RECT title_rect = {15, start_y, window_width - 15, start_y + title_h};
-        if (!m_current_title.is_empty()) {
-            pfc::stringcvt::string_wide_from_utf8 wide_title(m_current_title.c_str());
-            DrawText(hdc, wide_title.get_ptr(), -1, &title_rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
-        } else {
-            DrawText(hdc, L"[No Track Title]", -1, &title_rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+#if TRAYCONTROLS_PERF_STATS
+        void phase_begin(panel_paint_phase phase) override {
+            if (perf_enabled()) QueryPerformanceCounter(&m_start[phase]);
+            else m_start[phase].QuadPart = 0;
         }
-        SelectObject(hdc, old_font);
-
-        // Position artist - dynamic rect based on tmHeight and spacing
-        old_font = (HFONT)SelectObject(hdc, artist_font);
-        int artist_y = start_y + title_h + spacing;
-        RECT artist_rect = {15, artist_y, window_width - 15, artist_y + artist_h};
-        if (!m_current_artist.is_empty()) {
-            pfc::stringcvt::string_wide_from_utf8 wide_artist(m_current_artist.c_str());
-            DrawText(hdc, wide_artist.get_ptr(), -1, &artist_rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
-        } else {
-            DrawText(hdc, L"[No Artist]", -1, &artist_rect, DT_CENTER | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+        void phase_end(panel_paint_phase phase) override {
+            if (!m_start[phase].QuadPart) return;
+            static const perf_phase phases[] = { perf_phase_background, perf_phase_cover_art, perf_phase_ticker_layout };
+            LARGE_INTEGER end;
+            QueryPerformanceCounter(&end);
+            perf_record(phases[phase], end.QuadPart - m_start[phase].QuadPart);
+        }
+#endif
+
+    private:
+        control_panel& m_panel;
+        gdiplus_canvas* m_gfx;
+#if TRAYCONTROLS_PERF_STATS
+        LARGE_INTEGER m_start[3];
+#endif
+    };
+    window_layers layers(*this);
+
+    // A hover left behind by a pointer that moved onto another window draws no hover circle
+    if (m_hovered_button && settings.hover_circles) {
+        POINT cursor_pos;
+        GetCursorPos(&cursor_pos);
+        HWND wnd_under_cursor = WindowFromPoint(cursor_pos);
+        if (wnd_under_cursor != m_control_window && !IsChild(m_control_window, wnd_under_cursor)) {
+            m_hovered_button = 0;
         }
-        SelectObject(hdc, old_font);
-    } // End of should_draw_overlay condition
-
-    if (need_delete_title) {
-        DeleteObject(title_font);
-    }
-    if (need_delete_artist) {
-        DeleteObject(artist_font);
     }
-}
 
-void control_panel::draw_control_overlay(HDC hdc, int window_width, int window_height) {
-    // Create bottom overlay with glass effect using GDI+ alpha blending
-    const int overlay_height = 70; // Height for control buttons
-    
-    if (m_overlay_opacity > 0) {
-        // Use GDI+ for true alpha blending (glass effect)
-        Gdiplus::Graphics graphics(hdc);
-        graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-        
-        // Calculate alpha based on overlay opacity (around 60% max opacity for glass effect)
-        int alpha = (180 * m_overlay_opacity) / 100;
-        
-        // Use theme-aware overlay color: dark overlay for dark mode, light overlay for light mode
-        int overlay_color = m_is_dark_mode ? 20 : 240;
-        Gdiplus::SolidBrush overlayBrush(Gdiplus::Color(alpha, overlay_color, overlay_color, overlay_color));
-        // Start at -1 and extend extra pixels to eliminate sub-pixel gap at edges from anti-aliasing
-        Gdiplus::RectF overlayRect(-1.0f, (float)(window_height - overlay_height), (float)window_width + 2.0f, (float)overlay_height + 1.0f);
-        graphics.FillRectangle(&overlayBrush, overlayRect);
-        
-        // Draw control buttons (Previous, Play/Pause, Next, Shuffle, Repeat)
-        int button_size = 24; // Size of each button except play
-        int play_button_size = 38; // Larger play button
-        int button_spacing = 60; // Space between button centers
-        
-        // Dynamically scale button sizes and spacing for smaller window widths (e.g., Small Expanded Mode)
-        if (window_width < 360) {
-            button_spacing = (window_width * 16) / 100;
-            if (button_spacing < 32) button_spacing = 32;
-
-            button_size = (window_width * 8) / 100;
-            if (button_size < 16) button_size = 16;
-            if (button_size > 24) button_size = 24;
-
-            play_button_size = (window_width * 13) / 100;
-            if (play_button_size < 26) play_button_size = 26;
-            if (play_button_size > 38) play_button_size = 38;
+    panel_paint_state state = {};
+    state.width = width;
+    state.height = height;
+    state.mode = m_is_artwork_expanded ? panel_mode_expanded : (m_is_compact_mode ? panel_mode_compact : panel_mode_panel);
+    state.undocked = m_is_undocked;
+    state.theme = get_panel_theme();
+    state.accent = canvas_color_from_colorref(settings.compact_progress_color);
+    state.background_style = settings.background_style;
+    state.rounded_border = settings.miniplayer_border_style == 1;
+    state.show_cover_art = settings.show_cover_art;
+    state.cover_margin = settings.cover_margin;
+    state.rounded_cover = settings.cover_style == 1;
+    state.icon_style = settings.alternative_icons_style;
+    state.hover_circles = settings.hover_circles;
+    state.layers = &layers;
+
+    // Up Next pane replaces the track view in the Undocked and Expanded MiniPlayer
+    const bool up_next = is_up_next_shown();
+
+    // Artwork-derived backgrounds; the preview's colours stand in until the decode lands
+    HBITMAP background_art = m_cover_art_bitmap_original ? m_cover_art_bitmap_original : m_cover_art_bitmap;
+    if (!background_art) background_art = m_art_preview_bitmap;
+    if (background_art && (up_next || state.mode != panel_mode_expanded)) {
+        if (settings.background_style == 1) {
+            state.has_artwork_color = get_artwork_color(background_art, state.artwork_color);
+        } else if (settings.background_style == 2) {
+            get_blurred_background(background_art, width, height, state.blurred_background);
         }
+    }
 
-        int center_x = window_width / 2;
-        // Calculate center of the bottom overlay area
-        int overlay_top = window_height - overlay_height;
-        int center_y = overlay_top + (overlay_height / 2); // Perfectly centered vertically
-        
-        // Previous button (enlarged on hover)
-        int prev_x = center_x - button_spacing;
-        int prev_y = center_y;
-        int prev_size = (m_hovered_button == BTN_PREV) ? (int)(button_size * HOVER_ZOOM_FACTOR) : button_size;
-        if (m_is_undocked && !m_is_artwork_expanded) {
-            draw_previous_icon_with_opacity(hdc, prev_x, prev_y, prev_size, m_button_opacity);
-        } else {
-            draw_previous_icon(hdc, prev_x, prev_y, prev_size);
+    if (up_next) {
+        {
+            gdiplus_canvas gfx(hdc, width, height, &m_text_layouts);
+            paint_panel_background(gfx, state);
         }
-        
-        // Play/Pause button (enlarged on hover - 15% zoom factor)
-        int play_x = center_x;
-        int play_y = center_y;
-        float play_zoom_factor = HOVER_ZOOM_FACTOR - 0.15f;
-        int play_size = (m_hovered_button == BTN_PLAYPAUSE) ? (int)(play_button_size * play_zoom_factor) : play_button_size;
-        if (m_is_undocked && !m_is_artwork_expanded) {
-            if (m_is_playing && !m_is_paused) {
-                draw_pause_icon_with_opacity(hdc, play_x, play_y, play_size, m_button_opacity);
-            } else {
-                draw_play_icon_with_opacity(hdc, play_x, play_y, play_size, m_button_opacity);
-            }
-        } else {
-            if (m_is_playing && !m_is_paused) {
-                draw_pause_icon(hdc, play_x, play_y, play_size);
-            } else {
-                draw_play_icon(hdc, play_x, play_y, play_size);
+        m_up_next.paint(hdc, client_rect, m_text_color, m_text_dim_color, m_progress_fill_color);
+        gdiplus_canvas gfx(hdc, width, height, &m_text_layouts);
+        paint_panel_border(gfx, state);
+        return;
+    }
+
+    // Artwork: the animation frame on show, else the still bitmaps, else the signature preview.
+    // Bitmaps that are not 32bpp DIB sections are copied into these for the paint.
+    std::vector<uint8_t> cover_pixels, preview_pixels;
+    if (state.mode == panel_mode_expanded) {
+        HBITMAP art = get_cover_animation_frame(width, height);
+        if (!art) art = m_cover_art_bitmap_original ? m_cover_art_bitmap_original : m_cover_art_bitmap;
+        canvas_image_from_hbitmap(art, state.expanded_art, cover_pixels);
+    } else if (state.show_cover_art) {
+        int art_size = panel_cover_size(state);
+        HBITMAP frame = art_size > 0 ? get_cover_animation_frame(art_size, art_size) : nullptr;
+        canvas_image_from_hbitmap(frame ? frame : m_cover_art_bitmap, state.cover, cover_pixels);
+    }
+    canvas_image_from_hbitmap(m_art_preview_bitmap, state.preview, preview_pixels);
+    state.stream_placeholder = m_is_stream && !m_cover_art_bitmap;
+    if (state.stream_placeholder) state.radio_icon = get_radio_icon();
+
+    // Window fonts, or the ones each layout falls back to while they are missing
+    const bool compact = state.mode == panel_mode_compact;
+    const bool expanded = state.mode == panel_mode_expanded;
+    const wchar_t* face = compact ? L"Microsoft YaHei UI" : L"Segoe UI";
+    state.title_font = m_track_font ? canvas_font_from_hfont(m_track_font) :
+        canvas_font::make(face, get_dpi_scaled_font_height(compact ? 15 : (expanded ? 20 : 14)), FW_BOLD);
+    state.artist_font = m_artist_font ? canvas_font_from_hfont(m_artist_font) :
+        canvas_font::make(face, get_dpi_scaled_font_height(compact ? 12 : (expanded ? 14 : 11)), FW_NORMAL);
+    state.timer_font = m_timer_font ? canvas_font_from_hfont(m_timer_font) :
+        canvas_font::make(L"Segoe UI", get_dpi_scaled_font_height(11), FW_NORMAL);
+
+    // Title and artist scroll (right-to-left and back) when they overflow
+    const bool ticker_on = settings.ticker_speed != 0;
+    panel_ticker title_ticker = { m_ticker_offset, m_ticker_direction, ticker_on && !is_short_title(m_current_title),
+        m_current_title != m_ticker_title, m_ticker_active };
+    panel_ticker artist_ticker = { m_artist_ticker_offset, m_artist_ticker_direction, ticker_on && !is_short_title(m_current_artist),
+        m_current_artist != m_artist_ticker_title, m_artist_ticker_active };
+    state.title = m_title_line.update(m_current_title);
+    state.artist = m_artist_line.update(m_current_artist);
+    state.title_ticker = &title_ticker;
+    state.artist_ticker = &artist_ticker;
+
+    state.playing = m_is_playing;
+    state.paused = m_is_paused;
+    state.position = m_current_time;
+    state.length = m_track_length;
+    state.shuffle = m_shuffle_active;
+    state.repeat_mode = m_repeat_mode;
+
+    state.hovered = get_hovered_panel_button();
+    state.button_opacity = m_button_opacity;
+    state.overlay_visible = m_overlay_visible;
+    state.overlay_opacity = m_overlay_opacity;
+    state.artwork_overlay_visible = m_undocked_overlay_visible;
+    state.artwork_overlay_opacity = m_undocked_overlay_opacity;
+    state.compact_controls_visible = m_compact_controls_visible;
+
+    // Close (and, undocked, collapse) in the corners while the pointer is over the window, but
+    // not while it is on the undocked artwork
+    if (compact || (state.mode == panel_mode_panel && m_is_undocked && m_mouse_in_window)) {
+        POINT cursor_pos;
+        GetCursorPos(&cursor_pos);
+        RECT window_rect;
+        GetWindowRect(m_control_window, &window_rect);
+        bool cursor_in_window = PtInRect(&window_rect, cursor_pos) != FALSE;
+        if (!cursor_in_window && !compact) {
+            m_mouse_in_window = false;
+        } else if (cursor_in_window && !compact) {
+            POINT client_pt = cursor_pos;
+            ScreenToClient(m_control_window, &client_pt);
+            int art_size = (std::min)((std::min)(80, width - 30), height - 30);
+            if (client_pt.x >= 15 && client_pt.x < 15 + art_size && client_pt.y >= 15 && client_pt.y < 15 + art_size) {
+                cursor_in_window = false;
             }
         }
-        
-        // Next button (enlarged on hover)
-        int next_x = center_x + button_spacing;
-        int next_y = center_y;
-        int next_size = (m_hovered_button == BTN_NEXT) ? (int)(button_size * HOVER_ZOOM_FACTOR) : button_size;
-        if (m_is_undocked && !m_is_artwork_expanded) {
-            draw_next_icon_with_opacity(hdc, next_x, next_y, next_size, m_button_opacity);
-        } else {
-            draw_next_icon(hdc, next_x, next_y, next_size);
-        }
-        
-        // Shuffle button (left of Previous) - enlarged on hover
-        int shuffle_x = center_x - button_spacing * 2;
-        int shuffle_size = (m_hovered_button == BTN_SHUFFLE) ? (int)(button_size * HOVER_ZOOM_FACTOR) : button_size;
-        draw_shuffle_icon(hdc, shuffle_x, center_y, shuffle_size);
-        
-        // Repeat button (right of Next) - enlarged on hover
-        int repeat_x = center_x + button_spacing * 2;
-        int repeat_size = (m_hovered_button == BTN_REPEAT) ? (int)(button_size * HOVER_ZOOM_FACTOR) : button_size;
-        draw_repeat_icon(hdc, repeat_x, center_y, repeat_size);
-
-
-        // Close button in upper right corner
-        int close_size = 12;
-        int close_x = window_width - 15;
-        int close_y = 15;
-        draw_close_icon_with_opacity(hdc, close_x, close_y, close_size, m_button_opacity);
-        
-        // Draw collapse triangle in bottom right corner
-        int collapse_size = 12;
-        int collapse_x = window_width - 15;
-        int collapse_y = window_height - 15;
-        draw_collapse_triangle(hdc, collapse_x, collapse_y, collapse_size, m_button_opacity);
-        
+        state.corner_controls = cursor_in_window;
     }
-}
 
+    // Waveform seekbar: peaks are requested on first Compact paint, flat bar until they arrive
+    if (compact) {
+        if (settings.waveform_seekbar && !m_waveform && m_waveform_track.is_valid()) {
+            set_waveform(waveform_cache::get_instance().request(m_waveform_track));
+        }
+        m_waveform_columns.peaks = m_waveform.get();
+        m_waveform_columns.generation = m_waveform_generation;
+        state.waveform = &m_waveform_columns;
+    }
+    state.waveform_seekbar = settings.waveform_seekbar;
+    // Compact bars go behind the text, so the painter asks for them mid-frame
+    state.spectrum = compact && m_spectrum.is_running() && hdc == m_paint_surface.dc;
+
+    {
+        gdiplus_canvas gfx(hdc, width, height, &m_text_layouts);
+        layers.attach(&gfx);
+        paint_panel(gfx, state);
+        layers.attach(nullptr);
+    }
+
+    // Lines laid out this frame keep scrolling from where they are; new text starts over
+    if (!title_ticker.changed) m_ticker_title = m_current_title;
+    if (!artist_ticker.changed) m_artist_ticker_title = m_current_artist;
+    m_ticker_offset = title_ticker.offset;
+    m_ticker_direction = title_ticker.direction;
+    m_ticker_active = title_ticker.active;
+    m_artist_ticker_offset = artist_ticker.offset;
+    m_artist_ticker_direction = artist_ticker.direction;
+    m_artist_ticker_active = artist_ticker.active;
+    sync_ticker_timer();
 
-void control_panel::draw_undocked_artwork_overlay(HDC hdc, int window_width, int window_height) {
-    // Calculate artwork area (different for compact vs normal mode)
-    int art_size, art_x, art_y;
-    if (m_is_compact_mode) {
-        // Compact mode artwork positioning
-        int margin = 5;
-        art_size = window_height - (2 * margin);
-        art_x = margin;
-        art_y = margin;
-    } else {
-        // Normal undocked mode artwork positioning
-        art_size = (80 < (window_width - 30) ? 80 : (window_width - 30));
-        art_size = (art_size < (window_height - 30) ? art_size : (window_height - 30));
-        art_x = 15;
-        art_y = 15;
-    }
-    
-    // Draw vertical arrows with opacity (no background overlay)
-    if (m_undocked_overlay_opacity > 0) {
-        // Calculate arrow opacity based on overlay opacity
-        int arrow_opacity = (255 * m_undocked_overlay_opacity) / 100;
-        
-        // Draw vertical arrows centered in the artwork area
-        int center_x = art_x + art_size / 2;
-        int arrow_size = 16;
-        int arrow_spacing = 20;
-        
-        // Up arrow (closer to top)
-        int up_arrow_y = art_y + art_size / 4;
-        draw_up_arrow_with_opacity(hdc, center_x, up_arrow_y, arrow_size, arrow_opacity);
-        
-        // Down arrow (closer to bottom)
-        int down_arrow_y = art_y + (3 * art_size) / 4;
-        draw_down_arrow_with_opacity(hdc, center_x, down_arrow_y, arrow_size, arrow_opacity);
+    // Spectrum over the lower third of the artwork. The frame without bars is kept so spectrum
+    // frames can start from it instead of re-stretching the artwork; the hover overlay takes
+    // the whole frame, so no bars (and no base) while it is shown.
+    if (expanded && m_spectrum.is_running() && !m_overlay_visible && hdc == m_paint_surface.dc) {
+        if (ensure_surface(m_spectrum_base, width, height)) {
+            BitBlt(m_spectrum_base.dc, 0, 0, width, height, hdc, 0, 0, SRCCOPY);
+            m_spectrum_base_valid = true;
+        }
+        RECT bars = {0, height - height / 3, width, height};
+        draw_spectrum(m_paint_surface, bars, SPECTRUM_EXPANDED_ALPHA);
     }
 }
 
-void control_panel::draw_compact_control_overlay(HDC hdc, int window_width, int window_height) {
-    if (!m_compact_controls_visible) {
-        return;
-    }
-
-    int margin = 5;
-    bool show_art = get_show_cover_art();
-    bool has_margin = get_cover_margin();
-    int art_size = show_art ? (has_margin ? (window_height - 2 * margin) : window_height) : 0;
+void control_panel::reset_artwork_background_cache() {
+    m_blurred_background.clear();
+    m_blurred_background_width = 0;
+    m_blurred_background_height = 0;
+    m_blurred_background_source = nullptr;
+    m_blurred_background_reuses = 0;
+    m_artwork_color_source = nullptr;
+}
 
-    int text_left = 0;
-    if (show_art && art_size > 0) {
-        text_left = has_margin ? (margin + art_size + margin) : art_size;
+// Average of an 8x8 interior sample grid, for the Artwork Colors gradient
+bool control_panel::get_artwork_color(HBITMAP art_bm, canvas_color& color) {
+    if (art_bm != m_artwork_color_source) {
+        std::vector<uint8_t> scratch;
+        canvas_image art;
+        if (!canvas_image_from_hbitmap(art_bm, art, scratch) || !average_artwork_color(art, m_artwork_color)) return false;
+        m_artwork_color_source = art_bm;
     }
-    int text_right = window_width;
-    int text_area_width = text_right - text_left;
+    color = m_artwork_color;
+    return true;
+}
 
-    int overlay_bottom = window_height - 18; // Leave minimal space for progress bar and time
+// Blurred Artwork background at the panel size (build_blurred_background). Rebuilt only when
+// the artwork or the panel size changes.
+bool control_panel::get_blurred_background(HBITMAP art_bm, int width, int height, canvas_image& out) {
+    out = {};
+    if (width <= 0 || height <= 0) return false;
+    if (!m_blurred_background.empty() && m_blurred_background_source == art_bm &&
+        m_blurred_background_width == width && m_blurred_background_height == height) {
+        m_blurred_background_reuses++;
+    } else {
+        LARGE_INTEGER build_start;
+        QueryPerformanceCounter(&build_start);
+
+        std::vector<uint8_t> scratch;
+        canvas_image art;
+        if (!canvas_image_from_hbitmap(art_bm, art, scratch)) return false;
+        // Horizontal radius 4, vertical radius 8 - the look the background has always had
+        build_blurred_background(art, width, height, 4, 8, m_blurred_background);
+        if (m_blurred_background.empty()) return false;
+
+#ifdef _DEBUG
+        LARGE_INTEGER build_end, freq;
+        QueryPerformanceCounter(&build_end);
+        QueryPerformanceFrequency(&freq);
+        char msg[160];
+        sprintf_s(msg, "control_panel: blurred background %dx%d built in %.2f ms (previous reused %u times)\n",
+            width, height, (double)(build_end.QuadPart - build_start.QuadPart) * 1000.0 / (double)freq.QuadPart,
+            m_blurred_background_reuses);
+        OutputDebugStringA(msg);
+#endif
+
+        m_blurred_background_source = art_bm;
+        m_blurred_background_width = width;
+        m_blurred_background_height = height;
+        m_blurred_background_reuses = 0;
+    }
+
+    out.bits = m_blurred_background.data();
+    out.width = width;
+    out.height = height;
+    out.stride = width * 4;
+    out.has_alpha = false;
+    return true;
+}
 
-    int button_size = 24; 
-    int play_button_size = 34; // Play/Pause button size (reduced by 5% from 36px to 34px)
-    int button_spacing = 10;
-    
-    int total_buttons_width = (4 * button_size) + play_button_size + (4 * button_spacing);
+void control_panel::set_waveform(std::shared_ptr<const waveform_peaks> peaks) {
+    if (peaks == m_waveform) return;
+    m_waveform = std::move(peaks);
+    m_waveform_generation++;
+}
 
-    // Center the buttons horizontally in the text/overlay area
-    int buttons_start_x = text_left + (text_area_width - total_buttons_width) / 2;
-    if (show_art) {
-        buttons_start_x -= 15;
-    }
+void control_panel::get_compact_progress_band(int window_height, int& top, int& height) const {
+    panel_compact_progress_band(window_height, m_waveform && get_settings().waveform_seekbar, top, height);
+}
 
-    int center_y_line = (overlay_bottom / 2) + 5;
+bool control_panel::start_roll_animation(bool to_compact) {
+    if (!m_visible || !m_is_undocked || m_is_artwork_expanded || m_is_rolling_animation) return false;
 
-    int shuffle_x = buttons_start_x + button_size / 2;
-    int prev_x = shuffle_x + button_size/2 + button_spacing + button_size/2;
-    int play_x = prev_x + button_size/2 + button_spacing + play_button_size/2;
-    int next_x = play_x + play_button_size/2 + button_spacing + button_size/2;
-    int repeat_x = next_x + button_size/2 + button_spacing + button_size/2;
+    int normal_width = m_saved_normal_width >= 300 ? m_saved_normal_width : 338;
+    int normal_height = m_saved_normal_height >= 110 ? m_saved_normal_height : 120;
+    int compact_width = m_saved_compact_width > 0 ? m_saved_compact_width : 320;
+    int compact_height = m_saved_compact_height > 0 ? m_saved_compact_height : 75;
 
-    // Create background overlay (Solid mode paints solid background, Artwork Colors and Blurred Artwork are transparent)
-    int bg_style = get_background_style();
-    if (bg_style == 0) {
-        RECT overlay_rect = {show_art ? text_left : 0, 0, window_width, overlay_bottom};
-        HBRUSH overlay_brush = CreateSolidBrush(m_bg_color);
-        FillRect(hdc, &overlay_rect, overlay_brush);
-        DeleteObject(overlay_brush);
+    RECT client_rect;
+    GetClientRect(m_control_window, &client_rect);
+    int from_width = client_rect.right - client_rect.left;
+    int from_height = client_rect.bottom - client_rect.top;
+
+    // Start snapshot - reuse the frame already on screen when it is current
+    if (m_live_surface.bits && m_live_surface.width == from_width && m_live_surface.height == from_height &&
+        ensure_surface(m_roll_from, from_width, from_height)) {
+        memcpy(m_roll_from.bits, m_live_surface.bits, (size_t)from_width * from_height * 4);
+    } else if (!render_layered_frame(m_roll_from)) {
+        return false;
     }
 
-    // Draw control buttons (all enlarged on hover)
-    // Shuffle button
-    int shuffle_size = (m_hovered_button == BTN_SHUFFLE) ? (int)(button_size * HOVER_ZOOM_FACTOR) : button_size;
-    draw_shuffle_icon(hdc, shuffle_x, center_y_line, shuffle_size);
-    
-    // Previous button
-    int prev_size = (m_hovered_button == BTN_PREV) ? (int)(button_size * HOVER_ZOOM_FACTOR) : button_size;
-    draw_previous_icon(hdc, prev_x, center_y_line, prev_size);
-    
-    // Play/Pause button (15% zoom factor)
-    float play_zoom_factor = HOVER_ZOOM_FACTOR - 0.15f;
-    int play_size = (m_hovered_button == BTN_PLAYPAUSE) ? (int)(play_button_size * play_zoom_factor) : play_button_size;
-    if (m_is_playing && !m_is_paused) {
-        draw_pause_icon(hdc, play_x, center_y_line, play_size);
-    } else {
-        draw_play_icon(hdc, play_x, center_y_line, play_size);
+    if (to_compact) {
+        // Save current normal dimensions before switching
+        m_saved_normal_width = from_width;
+        m_saved_normal_height = from_height;
+        normal_width = from_width;
+        normal_height = from_height;
     }
-    // Next button
-    int next_size = (m_hovered_button == BTN_NEXT) ? (int)(button_size * HOVER_ZOOM_FACTOR) : button_size;
-    draw_next_icon(hdc, next_x, center_y_line, next_size);
-    
-    // Repeat button
-    int repeat_size = (m_hovered_button == BTN_REPEAT) ? (int)(button_size * HOVER_ZOOM_FACTOR) : button_size;
-    draw_repeat_icon(hdc, repeat_x, center_y_line, repeat_size);
-}
+    int to_width = to_compact ? compact_width : normal_width;
+    int to_height = to_compact ? compact_height : normal_height;
 
-void control_panel::start_roll_animation(bool to_compact) {
-    if (!m_visible || !m_is_undocked || m_is_artwork_expanded || m_is_rolling_animation) return;
-    
+    // End snapshot - the one real layout pass of the roll. WM_SIZE and WM_PAINT are
+    // ignored while m_is_rolling_animation is set, so the resize below is invisible.
     m_is_rolling_animation = true;
     m_rolling_to_compact = to_compact;
+    bool was_compact = m_is_compact_mode;
+    m_is_compact_mode = to_compact;
+    load_fonts();
+    SetWindowPos(m_control_window, nullptr, 0, 0, to_width, to_height,
+        SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOREDRAW);
+
+    if (!render_layered_frame(m_roll_to) ||
+        !ensure_surface(m_roll_frame, (std::max)(from_width, to_width), (std::max)(from_height, to_height))) {
+        // Put everything back and let the caller switch without animation
+        m_is_compact_mode = was_compact;
+        load_fonts();
+        SetWindowPos(m_control_window, nullptr, 0, 0, from_width, from_height,
+            SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOREDRAW);
+        m_is_rolling_animation = false;
+        release_surface(m_roll_from);
+        release_surface(m_roll_to);
+        release_surface(m_roll_frame);
+        return false;
+    }
+
     m_roll_animation_step = 0;
     m_roll_animation_start_time = GetTickCount();
-    
+
+    // First frame immediately - this also sizes the window back to the start layout
+    compose_roll_frame(0.0f, from_width, from_height);
+    push_layered_frame(m_roll_frame, from_width, from_height);
+
     // Set timer for animation updates
     SetTimer(m_control_window, UPDATE_TIMER_ID + 3, 16, nullptr); // ~60fps - use unique timer ID
+    return true;
+}
+
+// Cross-blend the start and end snapshots at the given progress, each anchored top-left and
+// cropped (or padded with transparency) to width x height. Both snapshots are premultiplied,
+// so a per-channel lerp gives the correct premultiplied result.
+void control_panel::compose_roll_frame(float progress, int width, int height) {
+    BYTE* dst_bits = static_cast<BYTE*>(m_roll_frame.bits);
+    if (!dst_bits) return;
+
+    const unsigned int to_weight = (unsigned int)(progress * 256.0f + 0.5f);
+    const unsigned int from_weight = 256 - to_weight;
+    const BYTE* from_bits = static_cast<const BYTE*>(m_roll_from.bits);
+    const BYTE* to_bits = static_cast<const BYTE*>(m_roll_to.bits);
+
+    for (int y = 0; y < height; y++) {
+        BYTE* dst = dst_bits + (size_t)y * m_roll_frame.width * 4;
+        const BYTE* from_row = y < m_roll_from.height ? from_bits + (size_t)y * m_roll_from.width * 4 : nullptr;
+        const BYTE* to_row = y < m_roll_to.height ? to_bits + (size_t)y * m_roll_to.width * 4 : nullptr;
+        int from_cols = from_row ? (std::min)(width, m_roll_from.width) : 0;
+        int to_cols = to_row ? (std::min)(width, m_roll_to.width) : 0;
+
+        for (int x = 0; x < width; x++) {
+            unsigned int b = 0, g = 0, r = 0, a = 0;
+            if (x < from_cols) {
+                const BYTE* p = from_row + x * 4;
+                b = p[0] * from_weight; g = p[1] * from_weight; r = p[2] * from_weight; a = p[3] * from_weight;
+            }
+            if (x < to_cols) {
+                const BYTE* p = to_row + x * 4;
+                b += p[0] * to_weight; g += p[1] * to_weight; r += p[2] * to_weight; a += p[3] * to_weight;
+            }
+            dst[0] = (BYTE)(b >> 8);
+            dst[1] = (BYTE)(g >> 8);
+            dst[2] = (BYTE)(r >> 8);
+            dst[3] = (BYTE)(a >> 8);
+            dst += 4;
+        }
+    }
 }
 
 void control_panel::update_roll_animation() {
@@ -6379,37 +5047,8 @@ void control_panel::update_roll_animation() {
     DWORD current_time = GetTickCount();
     DWORD elapsed = current_time - m_roll_animation_start_time;
     
-    if (elapsed >= ROLL_ANIMATION_DURATION) {
-        // Animation complete
-        m_is_rolling_animation = false;
-        KillTimer(m_control_window, UPDATE_TIMER_ID + 3);
-        
-        // Switch modes
-        if (m_rolling_to_compact) {
-            // Save current normal dimensions and switch to compact
-            RECT current_rect;
-            GetWindowRect(m_control_window, &current_rect);
-            m_saved_normal_width = current_rect.right - current_rect.left;
-            m_saved_normal_height = current_rect.bottom - current_rect.top;
-            m_is_compact_mode = true;
-            
-            // Resize to compact dimensions
-            int compact_width = m_saved_compact_width > 0 ? m_saved_compact_width : 320;
-            int compact_height = m_saved_compact_height > 0 ? m_saved_compact_height : 75;
-            SetWindowPos(m_control_window, nullptr, 0, 0, compact_width, compact_height, 
-                SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
-        } else {
-            // Switch to normal undocked mode
-            m_is_compact_mode = false;
-            
-            // Resize to normal dimensions
-            int normal_width = m_saved_normal_width >= 300 ? m_saved_normal_width : 338;
-            int normal_height = m_saved_normal_height >= 110 ? m_saved_normal_height : 120;
-            SetWindowPos(m_control_window, nullptr, 0, 0, normal_width, normal_height, 
-                SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
-        }
-        
-        InvalidateRect(m_control_window, nullptr, TRUE);
+    if (elapsed >= ROLL_ANIMATION_DURATION || !m_visible) {
+        finish_roll_animation();
         return;
     }
     
@@ -6420,33 +5059,32 @@ void control_panel::update_roll_animation() {
     // Apply easing function for smooth animation
     progress = progress * progress * (3.0f - 2.0f * progress); // Smoothstep
     
-    // Get current and target dimensions
-    RECT current_rect;
-    GetWindowRect(m_control_window, &current_rect);
-    int current_width = current_rect.right - current_rect.left;
-    int current_height = current_rect.bottom - current_rect.top;
-    
-    int start_width, start_height, target_width, target_height;
-    
-    if (m_rolling_to_compact) {
-        start_width = m_saved_normal_width >= 300 ? m_saved_normal_width : 338;
-        start_height = m_saved_normal_height >= 110 ? m_saved_normal_height : 120;
-        target_width = m_saved_compact_width > 0 ? m_saved_compact_width : 320;
-        target_height = m_saved_compact_height > 0 ? m_saved_compact_height : 75;
-    } else {
-        start_width = m_saved_compact_width > 0 ? m_saved_compact_width : 320;
-        start_height = m_saved_compact_height > 0 ? m_saved_compact_height : 75;
-        target_width = m_saved_normal_width >= 300 ? m_saved_normal_width : 338;
-        target_height = m_saved_normal_height >= 110 ? m_saved_normal_height : 120;
-    }
-    
-    // Interpolate dimensions
+    // Interpolate dimensions between the two snapshots
+    int start_width = m_roll_from.width;
+    int start_height = m_roll_from.height;
+    int target_width = m_roll_to.width;
+    int target_height = m_roll_to.height;
     int new_width = start_width + (int)((target_width - start_width) * progress);
     int new_height = start_height + (int)((target_height - start_height) * progress);
     
-    // Apply new dimensions
-    SetWindowPos(m_control_window, nullptr, 0, 0, new_width, new_height, 
-        SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
-    
-    InvalidateRect(m_control_window, nullptr, TRUE);
+    // Compose from the snapshots and resize + present in one UpdateLayeredWindow call
+    compose_roll_frame(progress, new_width, new_height);
+    push_layered_frame(m_roll_frame, new_width, new_height);
+    m_roll_animation_step++;
+}
+
+void control_panel::finish_roll_animation() {
+    // Animation complete
+    m_is_rolling_animation = false;
+    KillTimer(m_control_window, UPDATE_TIMER_ID + 3);
+
+    // Commit the mode switch (already applied when the end snapshot was taken) at its final size
+    SetWindowPos(m_control_window, nullptr, 0, 0, m_roll_to.width, m_roll_to.height,
+        SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOREDRAW);
+    composite_layered_content();
+
+    release_surface(m_roll_from);
+    release_surface(m_roll_to);
+    release_surface(m_roll_frame);
+    sync_spectrum_timer();
 }
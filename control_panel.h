@@ -1,9 +1,19 @@
 #pragma once
 
 #include "stdafx.h"
+#include "animated_artwork.h"
+#include "artwork_bridge.h"
+#include "artwork_cache.h"
+#include "panel_paint.h"
+#include "render_throttle.h"
+#include "text_layout.h"
+#include "spectrum_visualizer.h"
+#include "up_next_view.h"
+#include "waveform_peaks.h"
 #include <memory>
 
 class traycontrols_playlist_callback;
+struct stream_metadata;
 
 // Control panel popup window class
 class control_panel {
@@ -23,14 +33,23 @@ public:
     
     // Update with current track info
     void update_track_info(metadb_handle_ptr p_track = nullptr);
-    void update_stream_metadata(const file_info & p_info);
+    void update_stream_metadata(const stream_metadata& meta);
     
-    // Settings change notification
-    void on_settings_changed();
+    // Settings change notification; changes is a set of settings_change bits (preferences.h)
+    void on_settings_changed(unsigned changes = ~0u);
     void update_playback_order_state();
     
     // Online artwork notification from foo_artwork bridge
     void on_online_artwork_received();
+
+    // Seekbar peaks for a track finished extracting (waveform_cache)
+    void on_waveform_ready(const metadb_handle_ptr& track);
+
+    // Local cover finished decoding (artwork_cache); takes the bitmaps if the track still wants them
+    void on_artwork_decoded(const metadb_handle_ptr& track, decoded_artwork& art);
+
+    // An animated cover frame was decoded after advance() ran dry, or the stream failed (animated_artwork)
+    void on_cover_animation_ready();
     
     // Public accessors for tray manager
     bool is_undocked() const { return m_is_undocked; }
@@ -46,11 +65,28 @@ public:
     void show_undocked_miniplayer(); // Launch MiniPlayer directly in Undocked mode (for toolbar button)
     void hide_and_remember_miniplayer(); // Hide and remember miniplayer state and position
     
+    // Up Next pane (Undocked and Expanded MiniPlayer); opening it shows the MiniPlayer if needed
+    void toggle_up_next();
+    void jump_to_track(); // Opens Up Next with keyboard focus for type-to-search
+    up_next_view& get_up_next_view() { return m_up_next; }
+    
     // Slide-to-side feature (panel peeks from screen edge)
     void slide_to_side();
     void slide_back_from_side();
     bool is_slid_to_side() const { return m_is_slid_to_side; }
+    // Click-to-visible latency of show_control_panel* / show_*miniplayer* (entry to ShowWindow)
+    struct show_latency_stats {
+        unsigned int count;
+        unsigned int prewarmed_count; // Shows that used a pre-rendered first frame
+        double last_ms;
+        double min_ms;
+        double max_ms;
+        double total_ms;
+    };
+    const show_latency_stats& get_show_latency_stats() const { return m_show_latency; }
+
     HBITMAP get_cover_art_bitmap() const { return m_cover_art_bitmap_original ? m_cover_art_bitmap_original : m_cover_art_bitmap; }
+    bridge_artwork_ptr get_bridge_artwork() const { return m_bridge_artwork; } // Shared image if current art came from foo_artwork
     
 private:
     control_panel();
@@ -71,9 +107,6 @@ private:
     static const int BTN_CLOSE = 1007;
     static const int BTN_SHUFFLE = 1008;
     static const int BTN_REPEAT = 1009;
-
-    // Hover zoom: buttons render 30% larger while hovered for a pronounced visual effect.
-    static constexpr float HOVER_ZOOM_FACTOR = 1.30f;
     
     // Timer for updating time display
     static const UINT UPDATE_TIMER_ID = 4001;
@@ -181,14 +214,14 @@ private:
     pfc::string8 m_artist_ticker_title; // Artist currently being scrolled (to detect artist changes)
 
     void update_ticker();     // Advances the ticker and invalidates the window
-    void update_title_ticker(HDC hdc, const pfc::string8& title, HFONT font, const RECT& rect); // Draws scrolling title and manages ticker state
-    void update_artist_ticker(HDC hdc, const pfc::string8& artist, HFONT font, const RECT& rect, COLORREF text_color = CLR_INVALID); // Draws scrolling artist and manages ticker state
-    void update_text_ticker_internal(HDC hdc, const pfc::string8& text, HFONT font, const RECT& rect,
-                                     float& offset, int& direction, bool& active, pfc::string8& ticker_text,
-                                     COLORREF text_color);
     void sync_ticker_timer(); // Starts or stops TICKER_TIMER_ID based on m_ticker_active and m_artist_ticker_active
     static bool is_short_title(const pfc::string8& title) { return title.length() > 0 && title.length() < 30; }
 
+    // Measured and ellipsized title/artist lines; cleared with the fonts
+    text_layout_cache m_text_layouts;
+    utf16_line m_title_line;
+    utf16_line m_artist_line;
+
     
     
     // Album art
@@ -205,8 +238,19 @@ private:
     pfc::string8 m_last_stream_artist;
     pfc::string8 m_last_stream_title;
     bool m_online_artwork_pending;
-    bool m_artwork_from_bridge; // true if m_cover_art_bitmap is owned by foo_artwork (do NOT DeleteObject)
+    bool m_artwork_from_bridge; // true if m_cover_art_bitmap belongs to m_bridge_artwork (do NOT DeleteObject)
+    bridge_artwork_ptr m_bridge_artwork; // Shared image kept alive while displayed
     bool m_is_stream;
+
+    // Local covers decode on a worker. Until one lands, the colour signature artwork_cache
+    // recorded for the track is drawn as a soft preview; the decoded cover crossfades over it.
+    HBITMAP m_art_preview_bitmap;
+    metadb_handle_ptr m_art_decode_track;   // Track whose decode is outstanding
+    bool m_art_decode_same_track;           // Reload of the track already shown (online fallback)
+    void show_artwork_preview(const metadb_handle_ptr& track);
+    void release_artwork_preview();
+    void request_online_cover_art(const metadb_handle_ptr& track, bool same_track);
+    void fit_expanded_window_to_artwork();
     
     // Custom fonts
     HFONT m_artist_font;
@@ -225,33 +269,7 @@ private:
     void update_theme_colors();   // Updates colors based on theme mode setting
     bool detect_foobar_dark_mode(); // Detects foobar2000 main window theme
 
-    // Vector icon drawing
-    void draw_hover_circle(HDC hdc, int x, int y, int size);
-    void draw_play_icon(HDC hdc, int x, int y, int size);
-    void draw_pause_icon(HDC hdc, int x, int y, int size);
-    void draw_alternate_play_icon(HDC hdc, int x, int y, int size, COLORREF color);
-    void draw_alternate_pause_icon(HDC hdc, int x, int y, int size, COLORREF color);
-    void draw_style3_play_icon(HDC hdc, int x, int y, int size, COLORREF color);
-    void draw_style3_pause_icon(HDC hdc, int x, int y, int size, COLORREF color);
-    void draw_previous_icon(HDC hdc, int x, int y, int size);
-    void draw_next_icon(HDC hdc, int x, int y, int size);
-    void draw_play_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity);
-    void draw_pause_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity);
-    void draw_previous_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity);
-    void draw_next_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity);
-    void draw_up_arrow(HDC hdc, int x, int y, int size);
-    void draw_down_arrow(HDC hdc, int x, int y, int size);
-    void draw_up_arrow_with_opacity(HDC hdc, int x, int y, int size, int opacity);
-    void draw_down_arrow_with_opacity(HDC hdc, int x, int y, int size, int opacity);
-    void draw_roll_dots(HDC hdc, int x, int y, int size);
-    void draw_volume_icon(HDC hdc, int x, int y, int size);
-    void draw_volume_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity);
-    void draw_close_icon(HDC hdc, int x, int y, int size);
-    void draw_close_icon_with_opacity(HDC hdc, int x, int y, int size, int opacity);
-    void draw_collapse_triangle(HDC hdc, int x, int y, int size, int opacity);
-    void draw_shuffle_icon(HDC hdc, int x, int y, int size);
-    void draw_repeat_icon(HDC hdc, int x, int y, int size);
-    void start_roll_animation(bool to_compact);
+    bool start_roll_animation(bool to_compact);
     void update_roll_animation();
     
     // Animation state
@@ -278,6 +296,23 @@ private:
     static const int SLIDE_ANIMATION_STEPS = 15;
     static const int SLIDE_ANIMATION_DURATION = 200; // ms
     void update_slide_animation();
+
+    // Power/visibility throttling: while the panel is occluded, cloaked, locked away or the
+    // display is off nothing is composited and the progress timer stops; while peeking or on
+    // battery saver the ticker pauses and progress ticks slowly. Leaving a throttled state
+    // draws one catch-up frame. m_progress_interval is the unthrottled UPDATE_TIMER_ID rate.
+    render_throttle m_render_throttle;
+    HWINEVENTHOOK m_visibility_hooks[5];
+    UINT m_progress_interval;
+    bool m_repaint_after_throttle;
+    void start_progress_timer(UINT interval_ms);
+    void stop_progress_timer();
+    void refresh_render_throttle();
+    void on_render_throttle_changed(unsigned previous);
+    void install_visibility_hooks();
+    void remove_visibility_hooks();
+    static void CALLBACK visibility_event_proc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+                                               LONG id_object, LONG id_child, DWORD thread_id, DWORD time);
     
     // Window management
     void create_control_window();
@@ -286,9 +321,8 @@ private:
     void update_play_button();
     void load_cover_art(metadb_handle_ptr p_track = nullptr);
     void cleanup_cover_art();
-    HBITMAP convert_album_art_to_bitmap(album_art_data_ptr art_data);
+    void set_bridge_artwork(const bridge_artwork_ptr& art);
     HBITMAP convert_album_art_to_bitmap_large(album_art_data_ptr art_data);
-    HBITMAP convert_album_art_to_bitmap_original(album_art_data_ptr art_data);
     void load_fonts();
     void cleanup_fonts();
     void apply_window_corner_preference();
@@ -305,19 +339,147 @@ private:
     // Window procedure
     static LRESULT CALLBACK control_window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
     
-    // Drawing
+    // Drawing. Every mode is painted by paint_panel (panel_paint.h) on a gdiplus_canvas; the
+    // window only gathers what the frame shows and keeps the artwork-derived caches.
     void paint_control_panel(HDC hdc);
-    void paint_artwork_expanded(HDC hdc, const RECT& rect);
-    void paint_compact_mode(HDC hdc, const RECT& rect);
-    void paint_background_style(HDC hdc, const RECT& rect);
-    void draw_cover_art_styled(HDC hdc, HBITMAP hbmp, const RECT& rect, bool is_rounded);
-    void draw_track_info(HDC hdc, const RECT& rect, int art_size = 80);
-    void draw_time_info(HDC hdc, const RECT& rect);
-    void draw_track_info_overlay(HDC hdc, int window_width, int window_height);
-    void draw_control_overlay(HDC hdc, int window_width, int window_height);
-    void draw_undocked_artwork_overlay(HDC hdc, int window_width, int window_height);
-    void draw_compact_control_overlay(HDC hdc, int window_width, int window_height);
-    
+    panel_theme get_panel_theme() const;
+    panel_button get_hovered_panel_button() const;
+
+    // Artwork-derived backgrounds depend only on the artwork (and, for the blur, the panel size),
+    // so they are built once per artwork/size and reused by every paint until either changes.
+    std::vector<uint8_t> m_blurred_background;
+    int m_blurred_background_width;
+    int m_blurred_background_height;
+    HBITMAP m_blurred_background_source;
+    unsigned int m_blurred_background_reuses;
+    HBITMAP m_artwork_color_source;
+    canvas_color m_artwork_color;
+    bool get_blurred_background(HBITMAP art_bm, int width, int height, canvas_image& out);
+    bool get_artwork_color(HBITMAP art_bm, canvas_color& color);
+    void reset_artwork_background_cache();
+
+    // Radio icon shown in place of the artwork of streams, loaded once
+    std::vector<uint8_t> m_radio_icon_pixels;
+    canvas_image m_radio_icon;
+    const canvas_image& get_radio_icon();
+
+    // Waveform seekbar (Compact mode). Peaks come from waveform_cache; the per-column envelope
+    // is rebuilt only when the bar width or the peaks change. Changes are told apart by a
+    // generation rather than the buffer's address, which a new buffer can reuse.
+    metadb_handle_ptr m_waveform_track;
+    std::shared_ptr<const waveform_peaks> m_waveform;
+    unsigned m_waveform_generation;     // Bumped by set_waveform
+    panel_waveform m_waveform_columns;  // Envelope and column rects the seekbar paints from
+    // Vertical band of the Compact progress bar; taller once a waveform is drawn in it
+    void set_waveform(std::shared_ptr<const waveform_peaks> peaks);
+    void get_compact_progress_band(int window_height, int& top, int& height) const;
+    
+    // Layered window surfaces. Paint goes to m_paint_surface, then is copied into an ARGB
+    // surface, alpha-masked and pushed with UpdateLayeredWindow. Surfaces are kept between
+    // frames and only reallocated when the size changes.
+    struct layered_surface {
+        HDC dc;
+        HBITMAP bitmap;
+        HBITMAP old_bitmap;
+        void* bits;
+        int width;
+        int height;
+    };
+    layered_surface m_paint_surface;
+    layered_surface m_live_surface;       // Last frame pushed to the window
+    bool ensure_surface(layered_surface& surface, int width, int height);
+    void release_surface(layered_surface& surface);
+    bool render_layered_frame(layered_surface& target);
+    void push_layered_frame(layered_surface& source);
+    void push_layered_frame(layered_surface& source, int width, int height);
+
+    // Position-only animations (slide-out, slide-to-side, slide-back) move the window with
+    // UpdateLayeredWindow(pptDst) and keep the surface already on screen. Paints requested
+    // meanwhile (ticker frames, progress) are deferred to one composite when the move ends.
+    bool m_repaint_after_move;
+    bool is_moving_window() const { return m_animating || m_sliding_animation; }
+    void move_layered_window(int x, int y);
+    void end_window_move();
+
+    // First-frame pre-warm: at idle while hidden, load track info/art and pre-render the docked
+    // and last-used MiniPlayer frames so the next show only has to push a finished surface.
+    layered_surface m_prewarm_docked;
+    layered_surface m_prewarm_miniplayer;
+    t_uint64 m_prewarm_docked_key;
+    t_uint64 m_prewarm_miniplayer_key;
+    unsigned int m_settings_generation;   // Bumped on settings/theme changes to stale the keys
+    bool m_prewarming;
+    show_latency_stats m_show_latency;
+    static const UINT PREWARM_TIMER_ID = 4040;
+    static const UINT PREWARM_STARTUP_DELAY = 1500; // ms after initialize()
+    static const UINT PREWARM_REFRESH_DELAY = 750;  // ms after a track/art change while hidden
+    void schedule_prewarm(UINT delay_ms = PREWARM_REFRESH_DELAY);
+    void prewarm_frames();
+    void get_miniplayer_launch_size(int& width, int& height) const;
+    t_uint64 compute_frame_key() const;
+    bool present_first_frame(layered_surface& cache, t_uint64& cache_key);
+    void record_show_latency(const LARGE_INTEGER& start, bool prewarmed);
+
+    // Roll animation snapshots: both layouts are rendered once when the roll starts and
+    // intermediate frames are cropped/cross-blended from them into a surface sized for the
+    // larger of the two, so the window is never re-laid-out or re-painted mid-roll.
+    layered_surface m_roll_from;
+    layered_surface m_roll_to;
+    layered_surface m_roll_frame;
+    void compose_roll_frame(float progress, int width, int height);
+    void finish_roll_animation();
+
+    // Virtualized playlist pane; while it is open the playlist callback also tracks item edits
+    up_next_view m_up_next;
+    bool is_up_next_shown() const;
+
+    // Spectrum visualizer (Expanded and Compact). SPECTRUM_TIMER_ID is the frame clock; it runs
+    // only while the panel is visible, playing and not throttled, at the governor's interval.
+    // Expanded frames reuse m_spectrum_base, the finished artwork frame without bars, so a
+    // spectrum frame is one blit and one blend; Compact bars sit under the text and repaint fully.
+    spectrum_visualizer m_spectrum;
+    layered_surface m_spectrum_base;
+    bool m_spectrum_base_valid;
+    UINT m_spectrum_interval;       // Interval the timer is running at, 0 when stopped
+    static const UINT SPECTRUM_TIMER_ID = 4050;
+    static const BYTE SPECTRUM_EXPANDED_ALPHA = 110;
+    static const BYTE SPECTRUM_COMPACT_ALPHA = 56;
+    bool wants_spectrum() const;
+    void sync_spectrum_timer();
+    void update_spectrum();
+    void composite_spectrum_frame();
+    void draw_spectrum(layered_surface& surface, const RECT& area, BYTE alpha);
+    void finish_layered_frame(layered_surface& target, int width, int height);
+
+    // Track-change crossfade. When the track or its artwork changes, the frame on screen is
+    // copied into m_crossfade_from; until the fade ends, every frame presented is that snapshot
+    // blended with the current m_live_surface into m_crossfade_frame. Paints keep updating the
+    // live surface as usual, and CROSSFADE_TIMER_ID only re-blends, so a frame costs one pass
+    // over the pixels. Surfaces are sized when a fade starts and reused by the next one.
+    layered_surface m_crossfade_from;
+    layered_surface m_crossfade_frame;
+    bool m_crossfade_active;
+    DWORD m_crossfade_start;
+    DWORD m_crossfade_duration;
+    static const UINT CROSSFADE_TIMER_ID = 4060;
+    void begin_crossfade();
+    void update_crossfade();
+    void end_crossfade();
+    bool compose_crossfade_frame();
+    void present_live_frame();
+
+    // Animated cover. Paints ask m_cover_animation for the frame at the size they draw the
+    // cover, which starts its decode stream; COVER_ANIMATION_TIMER_ID is re-armed with each
+    // frame's own delay. Only a visible, unthrottled panel animates - anything else suspends
+    // the stream and frees its frames until the next paint.
+    animated_artwork m_cover_animation;
+    bool m_cover_animation_drawn;   // A paint drew the animation since its last frame change
+    static const UINT COVER_ANIMATION_TIMER_ID = 4070;
+    bool wants_cover_animation() const;
+    void sync_cover_animation();
+    void update_cover_animation();
+    HBITMAP get_cover_animation_frame(int width, int height);
+
     std::unique_ptr<traycontrols_playlist_callback> m_playlist_callback;
     static control_panel* s_instance;
 };
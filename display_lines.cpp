@@ -0,0 +1,98 @@
+#include "stdafx.h"
+#include "display_lines.h"
+#include "perf_stats.h"
+
+static const char* safe_meta_get_pref(const file_info& info, const char* name) {
+    t_size index = info.meta_find(name);
+    if (index != pfc_infinite && info.meta_enum_value_count(index) > 0) {
+        const char* val = info.meta_enum_value(index, 0);
+        if (val && val[0] != '\0') return val;
+    }
+    return nullptr;
+}
+
+void format_display_lines_track(metadb_handle_ptr track, pfc::string8& line1_out, pfc::string8& line2_out) {
+    if (!track.is_valid()) return;
+    TRAY_PERF_SCOPE(perf_phase_format_lines);
+    try {
+        pfc::string8 line1_fmt = get_line1_format();
+        pfc::string8 line2_fmt = get_line2_format();
+
+        if (line1_fmt.is_empty()) line1_fmt = "%title%";
+        if (line2_fmt.is_empty()) line2_fmt = "%artist%";
+
+        static_api_ptr_t<titleformat_compiler> compiler;
+        service_ptr_t<titleformat_object> script1;
+        service_ptr_t<titleformat_object> script2;
+        compiler->compile_safe(script1, line1_fmt);
+        compiler->compile_safe(script2, line2_fmt);
+
+        if (script1.is_valid()) {
+            track->format_title(nullptr, line1_out, script1, nullptr);
+        }
+        if (script2.is_valid()) {
+            track->format_title(nullptr, line2_out, script2, nullptr);
+        }
+
+        // Direct metadata tag fallback via get_info_ref() and file_info
+        if (line1_out.is_empty() || line2_out.is_empty()) {
+            metadb_info_container::ptr info_container = track->get_info_ref();
+            if (info_container.is_valid()) {
+                const file_info& info = info_container->info();
+                if (line1_out.is_empty()) {
+                    const char* val = safe_meta_get_pref(info, "TITLE");
+                    if (!val) val = safe_meta_get_pref(info, "title");
+                    if (val) line1_out = val;
+                    else line1_out = pfc::string_filename_ext(track->get_path());
+                }
+                if (line2_out.is_empty()) {
+                    const char* val = safe_meta_get_pref(info, "ARTIST");
+                    if (!val) val = safe_meta_get_pref(info, "artist");
+                    if (!val) val = safe_meta_get_pref(info, "ALBUMARTIST");
+                    if (!val) val = safe_meta_get_pref(info, "albumartist");
+                    if (!val) val = safe_meta_get_pref(info, "PERFORMER");
+                    if (!val) val = safe_meta_get_pref(info, "performer");
+                    if (val) line2_out = val;
+                }
+            }
+        }
+
+        // Check for external stream metadata discovered via foo_artwork (e.g. ?azuracast_api / ?radioreg_api)
+        static service_ptr_t<titleformat_object> tf_fa_title, tf_fa_artist;
+        if (!tf_fa_title.is_valid()) {
+            compiler->compile_safe(tf_fa_title, "%foo_artwork_title%");
+        }
+        if (!tf_fa_artist.is_valid()) {
+            compiler->compile_safe(tf_fa_artist, "%foo_artwork_artist%");
+        }
+        pfc::string8 fa_title, fa_artist;
+        track->format_title(nullptr, fa_title, tf_fa_title, nullptr);
+        track->format_title(nullptr, fa_artist, tf_fa_artist, nullptr);
+
+        if (!fa_title.is_empty() && fa_title != "?") {
+            if (line1_fmt == "%title%" || line1_out.is_empty() ||
+                line1_out.find_first("http://") == 0 || line1_out.find_first("https://") == 0) {
+                line1_out = fa_title;
+            }
+        }
+        if (!fa_artist.is_empty() && fa_artist != "?") {
+            if (line2_fmt == "%artist%" || line2_out.is_empty()) {
+                line2_out = fa_artist;
+            }
+        }
+    } catch (...) {
+        // Leave outputs unchanged on error
+    }
+}
+
+void format_display_lines(pfc::string8& line1_out, pfc::string8& line2_out) {
+    try {
+        auto playback = playback_control::get();
+        metadb_handle_ptr track;
+        if (playback->get_now_playing(track) && track.is_valid()) {
+            format_display_lines_track(track, line1_out, line2_out);
+        }
+    } catch (...) {
+        // Leave outputs unchanged on error
+    }
+}
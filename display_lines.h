@@ -0,0 +1,14 @@
+#pragma once
+
+// The two display lines (title and artist by default) the tray tooltip, control panel and
+// popup show for a track, formatted with the user's title formatting scripts.
+
+#include "stdafx.h"
+
+// Scripts from Preferences (preferences.cpp); empty means the %title% / %artist% default
+pfc::string8 get_line1_format();
+pfc::string8 get_line2_format();
+
+// Lines of the playing track; outputs are left unchanged when nothing is playing
+void format_display_lines(pfc::string8& line1_out, pfc::string8& line2_out);
+void format_display_lines_track(metadb_handle_ptr track, pfc::string8& line1_out, pfc::string8& line2_out);
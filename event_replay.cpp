@@ -0,0 +1,233 @@
+#include "stdafx.h"
+#include "event_replay.h"
+
+#if TRAYCONTROLS_PERF_STATS
+
+#include "playback_events.h"
+#include "replay_script.h"
+#include "stream_metadata.h"
+#include <memory>
+
+// Time given to the last event's deferred work (coalesced refreshes, paints) before reporting
+static const UINT REPLAY_SETTLE_MS = 500;
+
+static const perf_counter g_replay_counters[] = {
+    perf_counter_paints,
+    perf_counter_gdi_objects,
+    perf_counter_artwork_decodes,
+    perf_counter_text_layouts
+};
+static const size_t REPLAY_COUNTER_COUNT = sizeof(g_replay_counters) / sizeof(g_replay_counters[0]);
+
+// Main-thread state at a point in time
+struct replay_sample {
+    uint64_t cpu_us;
+    LONGLONG qpc;
+    std::vector<uint64_t> counters;
+};
+
+struct replay_session {
+    std::vector<replay_event> events;
+    size_t next_event = 0;
+    replay_stats stats{ std::vector<const char*>{ "paints", "GDI objects", "art decodes", "text layouts" } };
+
+    LONGLONG start_qpc = 0;
+    LONGLONG frequency = 1;
+    bool was_collecting = false;        // Statistics switch to restore; the counters need it on
+    bool has_open_event = false;
+    replay_event_type open_type = replay_event_track;
+    replay_sample open_sample;
+};
+
+static std::unique_ptr<replay_session> g_replay;
+static UINT_PTR g_replay_timer = 0;
+
+static void end_session() {
+    if (!g_replay) return;
+    perf_set_enabled(g_replay->was_collecting);
+    g_replay.reset();
+}
+
+static replay_sample take_sample() {
+    replay_sample sample;
+    FILETIME creation, exit, kernel, user;
+    sample.cpu_us = 0;
+    if (GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        ULARGE_INTEGER k, u;
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+        sample.cpu_us = (k.QuadPart + u.QuadPart) / 10; // 100 ns units
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    sample.qpc = now.QuadPart;
+    for (perf_counter counter : g_replay_counters) {
+        sample.counters.push_back(perf_get_counter(counter));
+    }
+    return sample;
+}
+
+// Attribute everything since the open event was dispatched to its type
+static void close_open_event(replay_session& session) {
+    if (!session.has_open_event) return;
+    replay_sample now = take_sample();
+    std::vector<uint64_t> deltas(REPLAY_COUNTER_COUNT);
+    for (size_t i = 0; i < REPLAY_COUNTER_COUNT; i++) {
+        deltas[i] = now.counters[i] - session.open_sample.counters[i];
+    }
+    uint64_t wall_us = (uint64_t)((now.qpc - session.open_sample.qpc) * 1000000 / session.frequency);
+    session.stats.add(session.open_type, now.cpu_us - session.open_sample.cpu_us, wall_us, deltas);
+    session.has_open_event = false;
+}
+
+static void dispatch_event(const replay_event& e) {
+    try {
+        switch (e.type) {
+        case replay_event_track:
+            handle_playback_new_track(metadb::get()->handle_create(e.text.c_str(), 0));
+            break;
+        case replay_event_icy: {
+            // Only reaches the windows while a remote stream is actually playing
+            file_info_impl info;
+            info.meta_set("STREAMTITLE", e.text.c_str());
+            on_stream_dynamic_info(info);
+            break;
+        }
+        case replay_event_pause:
+            handle_playback_pause(e.value != 0.0);
+            break;
+        case replay_event_seek:
+            // The component does not react to seeks; replayed so the script stays faithful
+            break;
+        case replay_event_stop:
+            handle_playback_stop(play_control::stop_reason_user);
+            break;
+        case replay_event_metadb: {
+            metadb_handle_ptr track;
+            if (!playback_control::get()->get_now_playing(track) || !track.is_valid()) break;
+            metadb_handle_list items;
+            items.add_item(track);
+            for (unsigned i = 0; i < (unsigned)e.value; i++) {
+                handle_metadb_changed(items);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    } catch (...) {}
+}
+
+static void finish_replay() {
+    if (!g_replay) return;
+    close_open_event(*g_replay);
+
+    console::print("Tray Controls: event replay finished");
+    std::string report = g_replay->stats.format_report();
+    size_t start = 0;
+    while (start < report.size()) {
+        size_t end = report.find('\n', start);
+        if (end == std::string::npos) end = report.size();
+        console::print(pfc::string8(report.c_str() + start, end - start));
+        start = end + 1;
+    }
+    end_session();
+}
+
+static VOID CALLBACK replay_timer_proc(HWND hwnd, UINT msg, UINT_PTR timer_id, DWORD time) {
+    KillTimer(nullptr, timer_id);
+    g_replay_timer = 0;
+    if (!g_replay) return;
+    replay_session& session = *g_replay;
+
+    if (session.next_event >= session.events.size()) {
+        finish_replay();
+        return;
+    }
+
+    close_open_event(session);
+
+    const replay_event& e = session.events[session.next_event++];
+    session.open_type = e.type;
+    session.open_sample = take_sample();
+    session.has_open_event = true;
+    dispatch_event(e);
+
+    // Schedule the next event relative to the replay start so slow handlers don't stretch the script
+    UINT delay = REPLAY_SETTLE_MS;
+    if (session.next_event < session.events.size()) {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        LONGLONG elapsed_ms = (now.QuadPart - session.start_qpc) * 1000 / session.frequency;
+        LONGLONG due_ms = (LONGLONG)session.events[session.next_event].time_ms;
+        delay = due_ms > elapsed_ms ? (UINT)(due_ms - elapsed_ms) : USER_TIMER_MINIMUM;
+    }
+    g_replay_timer = SetTimer(nullptr, 0, delay, replay_timer_proc);
+    if (!g_replay_timer) finish_replay();
+}
+
+void cancel_event_replay() {
+    if (g_replay_timer) {
+        KillTimer(nullptr, g_replay_timer);
+        g_replay_timer = 0;
+    }
+    end_session();
+}
+
+void run_event_replay() {
+    if (g_replay) {
+        console::print("Tray Controls: an event replay is already running");
+        return;
+    }
+
+    pfc::string8 path;
+    if (!uGetOpenFileName(core_api::get_main_window(), "Event scripts|*.txt|All files|*.*", 0, "txt",
+            "Replay Event Script", nullptr, path, FALSE)) {
+        return;
+    }
+
+    std::string script;
+    try {
+        fb2k::memBlockRef data = filesystem::g_readWholeFile(path, 16 * 1024 * 1024, fb2k::noAbort);
+        script.assign((const char*)data->data(), data->size());
+    } catch (std::exception const& e) {
+        pfc::string8 msg;
+        msg << "Tray Controls: could not read event script: " << e.what();
+        console::print(msg);
+        return;
+    }
+
+    auto session = std::make_unique<replay_session>();
+    std::string error;
+    if (!parse_replay_script(script, session->events, error)) {
+        pfc::string8 msg;
+        msg << "Tray Controls: bad event script, " << error.c_str();
+        console::print(msg);
+        return;
+    }
+    if (session->events.empty()) {
+        console::print("Tray Controls: event script has no events");
+        return;
+    }
+
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    session->start_qpc = now.QuadPart;
+    session->frequency = freq.QuadPart;
+    session->was_collecting = perf_enabled();
+    perf_set_enabled(true);
+
+    pfc::string8 msg;
+    msg << "Tray Controls: replaying " << (unsigned)session->events.size() << " events from " << path;
+    console::print(msg);
+
+    g_replay = std::move(session);
+    UINT first_delay = g_replay->events[0].time_ms > 0 ? g_replay->events[0].time_ms : USER_TIMER_MINIMUM;
+    g_replay_timer = SetTimer(nullptr, 0, first_delay, replay_timer_proc);
+    if (!g_replay_timer) end_session();
+}
+
+#endif
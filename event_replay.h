@@ -0,0 +1,19 @@
+#pragma once
+
+// Replays a recorded playback event script (see replay_script.h) against the live component
+// and reports main-thread CPU time, wall time and work counters per event type.
+// Built with the rest of the instrumentation (TRAYCONTROLS_PERF_STATS, see perf_stats.h).
+
+#include "stdafx.h"
+#include "perf_stats.h"
+
+#if TRAYCONTROLS_PERF_STATS
+
+// Ask for a script file and start replaying it; the report is printed to the console when
+// the last event has settled. Main thread only; ignored while a replay is running.
+void run_event_replay();
+
+// Stop a running replay without reporting (component shutdown)
+void cancel_event_replay();
+
+#endif
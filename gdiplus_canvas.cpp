@@ -0,0 +1,431 @@
+#include "stdafx.h"
+#include "gdiplus_canvas.h"
+#include "perf_stats.h"
+#include <cmath>
+#include <vector>
+
+static inline Gdiplus::Color to_gdiplus(canvas_color c) {
+    return Gdiplus::Color(c.a, c.r, c.g, c.b);
+}
+
+void add_rounded_rect_to_path(Gdiplus::GraphicsPath& path, float x, float y, float width, float height, float radius) {
+    float diameter = radius * 2.0f;
+    if (diameter > width) diameter = width;
+    if (diameter > height) diameter = height;
+    if (diameter <= 0.0f) {
+        path.AddRectangle(Gdiplus::RectF(x, y, width, height));
+        return;
+    }
+
+    path.AddArc(x, y, diameter, diameter, 180.0f, 90.0f);
+    path.AddArc(x + width - diameter, y, diameter, diameter, 270.0f, 90.0f);
+    path.AddArc(x + width - diameter, y + height - diameter, diameter, diameter, 0.0f, 90.0f);
+    path.AddArc(x, y + height - diameter, diameter, diameter, 90.0f, 90.0f);
+    path.CloseFigure();
+}
+
+gdiplus_canvas::gdiplus_canvas(HDC hdc, int width, int height, text_layout_cache* layouts)
+    : m_graphics(hdc)
+    , m_width(width)
+    , m_height(height)
+    , m_layouts(layouts)
+{
+    m_graphics.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
+    m_graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
+    m_graphics.SetTextRenderingHint(Gdiplus::TextRenderingHintAntiAliasGridFit);
+    m_clip = { 0, 0, width, height };
+}
+
+gdiplus_canvas::~gdiplus_canvas() {
+    m_own_layouts.clear();
+    for (const owned_font& f : m_fonts) {
+        DeleteObject(f.handle);
+    }
+}
+
+void gdiplus_canvas::flush() {
+    m_graphics.Flush(Gdiplus::FlushIntentionSync);
+    GdiFlush();
+}
+
+void gdiplus_canvas::clear(canvas_color color) {
+    m_graphics.Clear(to_gdiplus(color));
+}
+
+void gdiplus_canvas::fill_rect(float x, float y, float w, float h, canvas_color color) {
+    Gdiplus::SolidBrush brush(to_gdiplus(color));
+    m_graphics.FillRectangle(&brush, x, y, w, h);
+}
+
+void gdiplus_canvas::fill_rounded_rect(float x, float y, float w, float h, float radius, canvas_color color) {
+    Gdiplus::GraphicsPath path;
+    add_rounded_rect_to_path(path, x, y, w, h, radius);
+    Gdiplus::SolidBrush brush(to_gdiplus(color));
+    m_graphics.FillPath(&brush, &path);
+}
+
+void gdiplus_canvas::fill_ellipse(float x, float y, float w, float h, canvas_color color) {
+    Gdiplus::SolidBrush brush(to_gdiplus(color));
+    m_graphics.FillEllipse(&brush, x, y, w, h);
+}
+
+void gdiplus_canvas::fill_polygon(const canvas_point* points, int count, canvas_color color) {
+    if (!points || count < 3) return;
+    std::vector<Gdiplus::PointF> pts(count);
+    for (int i = 0; i < count; i++) {
+        pts[i] = Gdiplus::PointF(points[i].x, points[i].y);
+    }
+    Gdiplus::SolidBrush brush(to_gdiplus(color));
+    m_graphics.FillPolygon(&brush, pts.data(), count);
+}
+
+void gdiplus_canvas::stroke_rounded_rect(float x, float y, float w, float h, float radius, float stroke, canvas_color color) {
+    Gdiplus::GraphicsPath path;
+    add_rounded_rect_to_path(path, x, y, w, h, radius);
+    Gdiplus::Pen pen(to_gdiplus(color), stroke);
+    m_graphics.DrawPath(&pen, &path);
+}
+
+void gdiplus_canvas::draw_line(float x1, float y1, float x2, float y2, float stroke, canvas_color color) {
+    Gdiplus::Pen pen(to_gdiplus(color), stroke);
+    m_graphics.DrawLine(&pen, x1, y1, x2, y2);
+}
+
+void gdiplus_canvas::draw_arc(float x, float y, float w, float h, float start_deg, float sweep_deg, float stroke, canvas_color color) {
+    Gdiplus::Pen pen(to_gdiplus(color), stroke);
+    m_graphics.DrawArc(&pen, x, y, w, h, start_deg, sweep_deg);
+}
+
+float gdiplus_canvas::measure_text(const wchar_t* text, float size_pt) {
+    if (!text) return 0.0f;
+    Gdiplus::Font font(L"Segoe UI", size_pt, Gdiplus::FontStyleRegular, Gdiplus::UnitPoint);
+    Gdiplus::StringFormat format;
+    format.SetFormatFlags(Gdiplus::StringFormatFlagsNoWrap);
+    Gdiplus::RectF bounds;
+    m_graphics.MeasureString(text, (int)wcslen(text), &font, Gdiplus::PointF(0.0f, 0.0f), &format, &bounds);
+    return bounds.Width;
+}
+
+void gdiplus_canvas::draw_text(const wchar_t* text, float x, float y, float w, float h, float size_pt,
+    canvas_text_align align, canvas_color color) {
+    if (!text) return;
+    Gdiplus::Font font(L"Segoe UI", size_pt, Gdiplus::FontStyleRegular, Gdiplus::UnitPoint);
+    Gdiplus::SolidBrush brush(to_gdiplus(color));
+    Gdiplus::StringFormat format;
+    format.SetAlignment(align == canvas_align_far ? Gdiplus::StringAlignmentFar :
+        align == canvas_align_center ? Gdiplus::StringAlignmentCenter : Gdiplus::StringAlignmentNear);
+    format.SetLineAlignment(Gdiplus::StringAlignmentCenter);
+    format.SetFormatFlags(Gdiplus::StringFormatFlagsNoWrap);
+    m_graphics.DrawString(text, (int)wcslen(text), &font, Gdiplus::RectF(x, y, w, h), &format, &brush);
+}
+
+HFONT gdiplus_canvas::resolve_font(const canvas_font& font, text_layout_cache*& layouts) {
+    if (font.native) {
+        layouts = m_layouts ? m_layouts : &m_own_layouts;
+        return (HFONT)font.native;
+    }
+
+    layouts = &m_own_layouts;
+    for (const owned_font& f : m_fonts) {
+        if (f.description.height == font.height && f.description.weight == font.weight &&
+            f.description.italic == font.italic && wcscmp(f.description.face, font.face) == 0) {
+            return f.handle;
+        }
+    }
+
+    LOGFONTW lf = {};
+    lf.lfHeight = font.height;
+    lf.lfWeight = font.weight;
+    lf.lfItalic = font.italic ? TRUE : FALSE;
+    lf.lfCharSet = DEFAULT_CHARSET;
+    lf.lfQuality = DEFAULT_QUALITY;
+    lf.lfPitchAndFamily = DEFAULT_PITCH | FF_DONTCARE;
+    wcsncpy_s(lf.lfFaceName, font.face, _TRUNCATE);
+    HFONT handle = CreateFontIndirectW(&lf);
+    if (!handle) return nullptr;
+    TRAY_PERF_COUNT(perf_counter_gdi_objects);
+
+    owned_font owned = { font, handle };
+    owned.description.native = nullptr;
+    m_fonts.push_back(owned);
+    return handle;
+}
+
+canvas_text_extent gdiplus_canvas::measure_text(const canvas_font& font, const wchar_t* text) {
+    canvas_text_extent extent = { 0.0f, 0.0f };
+    text_layout_cache* layouts = nullptr;
+    HFONT handle = resolve_font(font, layouts);
+    if (!handle) return extent;
+
+    HDC hdc = m_graphics.GetHDC();
+    const text_layout& layout = layouts->measure(hdc, text, handle);
+    m_graphics.ReleaseHDC(hdc);
+    extent.width = (float)layout.extent.cx;
+    extent.height = (float)layout.extent.cy;
+    return extent;
+}
+
+void gdiplus_canvas::draw_text(const canvas_font& font, const wchar_t* text, const canvas_rect& box,
+    canvas_text_align align, canvas_color color, unsigned flags) {
+    if (!text || box.w <= 0.0f || box.h <= 0.0f) return;
+    text_layout_cache* layouts = nullptr;
+    HFONT handle = resolve_font(font, layouts);
+    if (!handle) return;
+
+    RECT rect = { (LONG)floorf(box.x), (LONG)floorf(box.y), (LONG)ceilf(box.x + box.w), (LONG)ceilf(box.y + box.h) };
+    RECT clip;
+    if (!IntersectRect(&clip, &rect, &m_clip)) return;
+
+    // GDI text on the graphics' own DC, clipped by hand since GDI+ clipping does not reach it
+    HDC hdc = m_graphics.GetHDC();
+    const text_layout& layout = (flags & canvas_text_end_ellipsis)
+        ? layouts->get(hdc, text, handle, rect.right - rect.left)
+        : layouts->measure(hdc, text, handle);
+    const std::wstring& run = (flags & canvas_text_end_ellipsis) ? layout.fitted : layout.text;
+    const SIZE& extent = (flags & canvas_text_end_ellipsis) ? layout.fitted_extent : layout.extent;
+
+    int x = rect.left;
+    if (align == canvas_align_center) {
+        x += ((rect.right - rect.left) - extent.cx) / 2;
+        if (x < rect.left) x = rect.left;
+    } else if (align == canvas_align_far) {
+        x = rect.right - extent.cx;
+    }
+    int y = rect.top + ((rect.bottom - rect.top) - extent.cy) / 2;
+
+    HFONT old_font = (HFONT)SelectObject(hdc, handle);
+    COLORREF old_color = SetTextColor(hdc, RGB(color.r, color.g, color.b));
+    int old_mode = SetBkMode(hdc, TRANSPARENT);
+    ExtTextOutW(hdc, x, y, ETO_CLIPPED, &clip, run.c_str(), (UINT)run.length(), nullptr);
+    SetBkMode(hdc, old_mode);
+    SetTextColor(hdc, old_color);
+    SelectObject(hdc, old_font);
+    m_graphics.ReleaseHDC(hdc);
+}
+
+void gdiplus_canvas::fill_linear_gradient(const canvas_rect& rect, float radius, canvas_color left, canvas_color right) {
+    if (rect.w <= 0.0f || rect.h <= 0.0f) return;
+    Gdiplus::LinearGradientBrush brush(Gdiplus::PointF(rect.x, rect.y), Gdiplus::PointF(rect.x + rect.w, rect.y),
+        to_gdiplus(left), to_gdiplus(right));
+    if (radius > 0.0f) {
+        Gdiplus::GraphicsPath path;
+        add_rounded_rect_to_path(path, rect.x, rect.y, rect.w, rect.h, radius);
+        m_graphics.FillPath(&brush, &path);
+    } else {
+        m_graphics.FillRectangle(&brush, rect.x, rect.y, rect.w, rect.h);
+    }
+}
+
+void gdiplus_canvas::fill_path(const canvas_point* points, const int* contour_sizes, int contour_count, canvas_color color) {
+    if (!points || !contour_sizes || contour_count <= 0) return;
+    Gdiplus::GraphicsPath path(Gdiplus::FillModeWinding);
+    const canvas_point* contour = points;
+    for (int c = 0; c < contour_count; c++) {
+        const int count = contour_sizes[c];
+        if (count >= 3) {
+            m_points.resize(count);
+            for (int i = 0; i < count; i++) {
+                m_points[i] = Gdiplus::PointF(contour[i].x, contour[i].y);
+            }
+            path.AddPolygon(m_points.data(), count);
+        }
+        contour += count;
+    }
+    Gdiplus::SolidBrush brush(to_gdiplus(color));
+    m_graphics.FillPath(&brush, &path);
+}
+
+void gdiplus_canvas::fill_rects(const canvas_rect* rects, int count, canvas_color color) {
+    if (!rects || count <= 0) return;
+    std::vector<Gdiplus::RectF> gdiplus_rects(count);
+    for (int i = 0; i < count; i++) {
+        gdiplus_rects[i] = Gdiplus::RectF(rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+    }
+    Gdiplus::SolidBrush brush(to_gdiplus(color));
+    m_graphics.FillRectangles(&brush, gdiplus_rects.data(), count);
+}
+
+void gdiplus_canvas::draw_image(const canvas_image& image, const canvas_rect& dest, const canvas_rect& source, float corner_radius) {
+    if (image.empty() || dest.w <= 0.0f || dest.h <= 0.0f || source.w <= 0.0f || source.h <= 0.0f) return;
+
+    const bool whole_image = source.x == 0.0f && source.y == 0.0f &&
+        source.w == (float)image.width && source.h == (float)image.height;
+    const bool packed = image.stride == image.width * 4 || image.stride == -image.width * 4;
+    const bool enlarged = dest.w > (float)image.width || dest.h > (float)image.height;
+    if (corner_radius <= 0.0f && !image.has_alpha && whole_image && packed && !enlarged) {
+        // Opaque, whole and shrunk: GDI HALFTONE stretch, as the windows always drew cover art.
+        // Enlarged images (the 32px signature preview) go through bicubic below, not blocky HALFTONE.
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = image.width;
+        bmi.bmiHeader.biHeight = image.stride > 0 ? -image.height : image.height;
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        const uint8_t* first_row = image.stride > 0 ? image.bits : image.bits + (ptrdiff_t)(image.height - 1) * image.stride;
+
+        HDC hdc = m_graphics.GetHDC();
+        int saved = SaveDC(hdc);
+        IntersectClipRect(hdc, m_clip.left, m_clip.top, m_clip.right, m_clip.bottom);
+        SetStretchBltMode(hdc, HALFTONE);
+        SetBrushOrgEx(hdc, 0, 0, nullptr);
+        StretchDIBits(hdc, (int)lroundf(dest.x), (int)lroundf(dest.y), (int)lroundf(dest.w), (int)lroundf(dest.h),
+            0, 0, image.width, image.height, first_row, &bmi, DIB_RGB_COLORS, SRCCOPY);
+        RestoreDC(hdc, saved);
+        m_graphics.ReleaseHDC(hdc);
+        return;
+    }
+
+    Gdiplus::Bitmap bitmap(image.width, image.height, image.stride,
+        image.has_alpha ? PixelFormat32bppPARGB : PixelFormat32bppRGB, const_cast<BYTE*>(image.bits));
+    if (bitmap.GetLastStatus() != Gdiplus::Ok) return;
+    Gdiplus::ImageAttributes attributes;
+    attributes.SetWrapMode(Gdiplus::WrapModeTileFlipXY);
+
+    if (corner_radius <= 0.0f) {
+        Gdiplus::InterpolationMode previous = m_graphics.GetInterpolationMode();
+        m_graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
+        m_graphics.DrawImage(&bitmap, Gdiplus::RectF(dest.x, dest.y, dest.w, dest.h),
+            source.x, source.y, source.w, source.h, Gdiplus::UnitPixel, &attributes);
+        m_graphics.SetInterpolationMode(previous);
+        return;
+    }
+
+    // Scale into an offscreen bitmap, then fill the rounded path with it: TextureBrush +
+    // FillPath with AntiAlias gives smooth corners
+    Gdiplus::Bitmap scaled((INT)ceilf(dest.w), (INT)ceilf(dest.h), PixelFormat32bppPARGB);
+    if (scaled.GetLastStatus() != Gdiplus::Ok) return;
+    {
+        Gdiplus::Graphics g(&scaled);
+        g.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
+        g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
+        g.DrawImage(&bitmap, Gdiplus::RectF(0.0f, 0.0f, dest.w, dest.h),
+            source.x, source.y, source.w, source.h, Gdiplus::UnitPixel, &attributes);
+    }
+    Gdiplus::TextureBrush brush(&scaled, Gdiplus::WrapModeClamp);
+    brush.TranslateTransform(dest.x, dest.y);
+    Gdiplus::GraphicsPath path;
+    add_rounded_rect_to_path(path, dest.x, dest.y, dest.w, dest.h, corner_radius);
+    m_graphics.FillPath(&brush, &path);
+}
+
+void gdiplus_canvas::set_clip(int x, int y, int w, int h) {
+    m_clip = { x, y, x + w, y + h };
+    RECT bounds = { 0, 0, m_width, m_height };
+    IntersectRect(&m_clip, &m_clip, &bounds);
+    m_graphics.SetClip(Gdiplus::Rect(x, y, w, h));
+}
+
+void gdiplus_canvas::reset_clip() {
+    m_clip = { 0, 0, m_width, m_height };
+    m_graphics.ResetClip();
+}
+
+canvas_font canvas_font_from_hfont(HFONT font) {
+    LOGFONTW lf = {};
+    GetObjectW(font, sizeof(lf), &lf);
+    canvas_font result = canvas_font::make(lf.lfFaceName, lf.lfHeight, lf.lfWeight, lf.lfItalic != 0);
+    result.native = font;
+    return result;
+}
+
+bool canvas_image_from_hbitmap(HBITMAP bitmap, canvas_image& out, std::vector<uint8_t>& scratch) {
+    out = {};
+    if (!bitmap) return false;
+
+    DIBSECTION dib = {};
+    if (GetObject(bitmap, sizeof(dib), &dib) == sizeof(dib) && dib.dsBm.bmBits && dib.dsBm.bmBitsPixel == 32) {
+        // Bottom-up DIB sections store the last row first
+        const int row = dib.dsBm.bmWidthBytes;
+        const bool bottom_up = dib.dsBmih.biHeight > 0;
+        const uint8_t* bits = static_cast<const uint8_t*>(dib.dsBm.bmBits);
+        out.bits = bottom_up ? bits + (ptrdiff_t)(dib.dsBm.bmHeight - 1) * row : bits;
+        out.width = dib.dsBm.bmWidth;
+        out.height = dib.dsBm.bmHeight;
+        out.stride = bottom_up ? -row : row;
+        out.has_alpha = false;
+        return true;
+    }
+
+    BITMAP bm = {};
+    if (!GetObject(bitmap, sizeof(bm), &bm) || bm.bmWidth <= 0 || bm.bmHeight <= 0) return false;
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = bm.bmWidth;
+    bmi.bmiHeader.biHeight = -bm.bmHeight;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    scratch.resize((size_t)bm.bmWidth * bm.bmHeight * 4);
+    HDC screen_dc = GetDC(nullptr);
+    int lines = GetDIBits(screen_dc, bitmap, 0, bm.bmHeight, scratch.data(), &bmi, DIB_RGB_COLORS);
+    ReleaseDC(nullptr, screen_dc);
+    if (lines != bm.bmHeight) return false;
+
+    out.bits = scratch.data();
+    out.width = bm.bmWidth;
+    out.height = bm.bmHeight;
+    out.stride = bm.bmWidth * 4;
+    out.has_alpha = false;
+    return true;
+}
+
+bool canvas_image_from_icon(HICON icon, int size, canvas_image& out, std::vector<uint8_t>& pixels) {
+    out = {};
+    if (!icon || size <= 0) return false;
+
+    // Render onto a top-down DIB, once over black and once over white: where the two agree the
+    // icon is opaque, and the difference gives the alpha of the rest
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = size;
+    bmi.bmiHeader.biHeight = -size;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    void* bits = nullptr;
+    HDC screen_dc = GetDC(nullptr);
+    HBITMAP dib = CreateDIBSection(screen_dc, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    HDC mem_dc = CreateCompatibleDC(screen_dc);
+    ReleaseDC(nullptr, screen_dc);
+    if (!dib || !mem_dc) {
+        if (dib) DeleteObject(dib);
+        if (mem_dc) DeleteDC(mem_dc);
+        return false;
+    }
+    TRAY_PERF_COUNT_N(perf_counter_gdi_objects, 2);
+    HBITMAP old_bm = (HBITMAP)SelectObject(mem_dc, dib);
+
+    const size_t bytes = (size_t)size * size * 4;
+    pixels.resize(bytes);
+    memset(bits, 0, bytes);
+    DrawIconEx(mem_dc, 0, 0, icon, size, size, 0, nullptr, DI_NORMAL);
+    GdiFlush();
+    memcpy(pixels.data(), bits, bytes);
+    memset(bits, 0xFF, bytes);
+    DrawIconEx(mem_dc, 0, 0, icon, size, size, 0, nullptr, DI_NORMAL);
+    GdiFlush();
+
+    const uint8_t* over_white = static_cast<const uint8_t*>(bits);
+    for (size_t i = 0; i < bytes; i += 4) {
+        // Over black the pixel is c*a; over white it is c*a + (1 - a)
+        int alpha = 255 - ((int)over_white[i + 1] - (int)pixels[i + 1]);
+        if (alpha < 0) alpha = 0;
+        if (alpha > 255) alpha = 255;
+        pixels[i + 3] = (uint8_t)alpha;
+        for (int k = 0; k < 3; k++) {
+            if (pixels[i + k] > alpha) pixels[i + k] = (uint8_t)alpha;
+        }
+    }
+
+    SelectObject(mem_dc, old_bm);
+    DeleteDC(mem_dc);
+    DeleteObject(dib);
+
+    out.bits = pixels.data();
+    out.width = size;
+    out.height = size;
+    out.stride = size * 4;
+    out.has_alpha = true;
+    return true;
+}
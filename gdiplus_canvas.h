@@ -0,0 +1,82 @@
+#pragma once
+
+#include "stdafx.h"
+#include "canvas.h"
+#include "text_layout.h"
+#include <vector>
+
+// GDI+ backend for canvas, drawing on an HDC (normally a 32bpp DIB section selected into a
+// memory DC). Anti-aliased with half-pixel offset, matching the hand-written GDI+ paint code.
+//
+// Window-font text goes through GDI (ExtTextOut) like the rest of the windows' text, laid out
+// by the window's text_layout_cache when one is passed; fonts given only by description are
+// created on first use and live as long as the canvas.
+class gdiplus_canvas : public canvas {
+public:
+    gdiplus_canvas(HDC hdc, int width, int height, text_layout_cache* layouts = nullptr);
+    ~gdiplus_canvas();
+
+    int width() const override { return m_width; }
+    int height() const override { return m_height; }
+    Gdiplus::Graphics& graphics() { return m_graphics; }
+
+    // Finish pending GDI+ drawing before the bits are touched directly
+    void flush();
+
+    void clear(canvas_color color) override;
+    void fill_rect(float x, float y, float w, float h, canvas_color color) override;
+    void fill_rounded_rect(float x, float y, float w, float h, float radius, canvas_color color) override;
+    void fill_ellipse(float x, float y, float w, float h, canvas_color color) override;
+    void fill_polygon(const canvas_point* points, int count, canvas_color color) override;
+    void stroke_rounded_rect(float x, float y, float w, float h, float radius, float stroke, canvas_color color) override;
+    void draw_line(float x1, float y1, float x2, float y2, float stroke, canvas_color color) override;
+    void draw_arc(float x, float y, float w, float h, float start_deg, float sweep_deg, float stroke, canvas_color color) override;
+    float measure_text(const wchar_t* text, float size_pt) override;
+    void draw_text(const wchar_t* text, float x, float y, float w, float h, float size_pt,
+        canvas_text_align align, canvas_color color) override;
+    canvas_text_extent measure_text(const canvas_font& font, const wchar_t* text) override;
+    void draw_text(const canvas_font& font, const wchar_t* text, const canvas_rect& box,
+        canvas_text_align align, canvas_color color, unsigned flags) override;
+    void fill_linear_gradient(const canvas_rect& rect, float radius, canvas_color left, canvas_color right) override;
+    void fill_path(const canvas_point* points, const int* contour_sizes, int contour_count, canvas_color color) override;
+    void fill_rects(const canvas_rect* rects, int count, canvas_color color) override;
+    void draw_image(const canvas_image& image, const canvas_rect& dest, const canvas_rect& source, float corner_radius) override;
+    void set_clip(int x, int y, int w, int h) override;
+    void reset_clip() override;
+
+private:
+    struct owned_font {
+        canvas_font description;
+        HFONT handle;
+    };
+
+    Gdiplus::Graphics m_graphics;
+    int m_width;
+    int m_height;
+    RECT m_clip;
+    text_layout_cache* m_layouts;       // The window's cache, for its own fonts
+    text_layout_cache m_own_layouts;    // Layouts of the fonts this canvas created
+    std::vector<owned_font> m_fonts;
+    std::vector<Gdiplus::PointF> m_points;
+
+    HFONT resolve_font(const canvas_font& font, text_layout_cache*& layouts);
+};
+
+// Add rounded rectangle with smooth arcs to GDI+ GraphicsPath
+void add_rounded_rect_to_path(Gdiplus::GraphicsPath& path, float x, float y, float width, float height, float radius);
+
+inline canvas_color canvas_color_from_colorref(COLORREF color) {
+    return canvas_color::rgb(GetRValue(color), GetGValue(color), GetBValue(color));
+}
+
+// Description of a font the window created, drawn with that very handle by gdiplus_canvas
+canvas_font canvas_font_from_hfont(HFONT font);
+
+// Pixels of a bitmap for canvas::draw_image, as an opaque image (the alpha byte is ignored, as
+// StretchBlt does). 32bpp DIB sections are used in place; any other bitmap is copied into
+// scratch, which must outlive the image.
+bool canvas_image_from_hbitmap(HBITMAP bitmap, canvas_image& out, std::vector<uint8_t>& scratch);
+
+// Premultiplied pixels of an icon drawn at size x size, for drawing it on any canvas. Works
+// for alpha and mask-only icons alike.
+bool canvas_image_from_icon(HICON icon, int size, canvas_image& out, std::vector<uint8_t>& pixels);
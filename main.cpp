@@ -6,6 +6,14 @@
 #include "popup_window.h"
 #include "control_panel.h"
 #include "artwork_bridge.h"
+#include "stream_metadata.h"
+#include "track_notification.h"
+#include "startup.h"
+#include "tracing.h"
+#include "event_replay.h"
+#include "playback_events.h"
+#include "waveform_cache.h"
+#include "artwork_cache.h"
 
 // Component's DLL instance handle
 HINSTANCE g_hIns = NULL;
@@ -40,54 +48,86 @@ DECLARE_COMPONENT_VERSION(
 // Validate component compatibility using the proper SDK macro
 VALIDATE_COMPONENT_FILENAME("foo_traycontrols.dll");
 
-static ULONG_PTR g_gdiplusToken = 0;
+// Deferred initialization runs off a thread timer; WM_TIMER is only generated when the
+// message queue is otherwise empty, so it lands after foobar2000 has finished starting up
+static const UINT DEFERRED_INIT_DELAY_MS = 250;
+static UINT_PTR g_deferred_init_timer = 0;
 
-// Metadb callback to update control panel, popup window, and tray tooltip when stream metadata or display fields change
-class tray_metadb_callback : public metadb_io_callback_dynamic_impl_base {
-public:
-    void on_changed_sorted(metadb_handle_list_cref p_items_sorted, bool p_fromhook) override {
-        auto playback = playback_control::get();
-        if (!playback->is_playing() && !playback->is_paused()) return;
-
-        metadb_handle_ptr track;
-        if (playback->get_now_playing(track) && track.is_valid()) {
-            if (metadb_handle_list_helper::bsearch_by_pointer(p_items_sorted, track) != pfc_infinite) {
-                control_panel::get_instance().update_track_info(track);
-                popup_window::get_instance().update_track_info(track);
-                tray_manager::get_instance().update_tooltip(track);
-            }
-        }
-    }
-};
+static VOID CALLBACK deferred_init_timer_proc(HWND hwnd, UINT msg, UINT_PTR timer_id, DWORD time) {
+    KillTimer(nullptr, timer_id);
+    g_deferred_init_timer = 0;
+
+    LARGE_INTEGER phase_start;
+    try {
+        // Mouse hook, initial tooltip, popup and control panel windows
+        tray_manager::get_instance().complete_initialization();
+
+        // Initialize foo_artwork bridge for online artwork support
+        QueryPerformanceCounter(&phase_start);
+        init_artwork_bridge();
+        record_startup_phase("artwork bridge", phase_start);
+
+        // Initialize metadb callback for dynamic stream metadata updates
+        QueryPerformanceCounter(&phase_start);
+        start_metadb_notifications();
+        record_startup_phase("metadb callback", phase_start);
 
-static std::unique_ptr<tray_metadb_callback> g_metadb_callback;
+        // Artwork signature index is read on a worker; previews start once it lands
+        QueryPerformanceCounter(&phase_start);
+        artwork_cache::get_instance().initialize();
+        record_startup_phase("artwork signature index", phase_start);
+    } catch (...) {}
+
+    log_startup_phases();
+}
 
 // Tray Controls initialization handler
 class tray_init : public initquit {
 public:
     void on_init() override {
-        // Initialize GDI+ globally
-        Gdiplus::GdiplusStartupInput gdiplusStartupInput;
-        Gdiplus::GdiplusStartup(&g_gdiplusToken, &gdiplusStartupInput, nullptr);
-
-        // Initialize the popup window and tray manager
-        popup_window::get_instance().initialize();
+#if TRAYCONTROLS_PERF_STATS
+        perf_set_enabled(get_perf_stats_enabled());
+#endif
+        // Only the tray icon is registered on foobar2000's startup path; GDI+ starts on
+        // first use and windows, hooks and bridge discovery wait for idle
+        LARGE_INTEGER phase_start;
+        QueryPerformanceCounter(&phase_start);
         tray_manager::get_instance().initialize();
-        // Initialize foo_artwork bridge for online artwork support
-        init_artwork_bridge();
-        // Initialize metadb callback for dynamic stream metadata updates
-        g_metadb_callback = std::make_unique<tray_metadb_callback>();
+        record_startup_phase("tray icon registration", phase_start);
+
+        g_deferred_init_timer = SetTimer(nullptr, 0, DEFERRED_INIT_DELAY_MS, deferred_init_timer_proc);
+        if (!g_deferred_init_timer) {
+            // No timer available - initialize synchronously rather than not at all
+            deferred_init_timer_proc(nullptr, WM_TIMER, 0, 0);
+        }
     }
 
     void on_quit() override {
+        // Idle initialization may not have happened yet
+        if (g_deferred_init_timer) {
+            KillTimer(nullptr, g_deferred_init_timer);
+            g_deferred_init_timer = 0;
+        }
+#if TRAYCONTROLS_PERF_STATS
+        cancel_event_replay();
+#endif
         // Destroy metadb callback
-        g_metadb_callback.reset();
+        stop_metadb_notifications();
+        // Drop any coalesced stream metadata still waiting for its flush
+        reset_stream_metadata();
+        reset_track_notification();
         // Unregister foo_artwork callback before other cleanup
         shutdown_artwork_bridge();
+        // Stop any seekbar peak decode so it does not hold the file open during shutdown
+        waveform_cache::get_instance().cancel();
+        artwork_cache::get_instance().cancel();
         // Clean up the tray manager, popup window, and control panel
         tray_manager::get_instance().cleanup();
         popup_window::get_instance().cleanup();
         control_panel::get_instance().cleanup();
+        // The windows above took their GDI+ objects with them; this waits for the
+        // cancelled decode workers to let go of theirs
+        shutdown_gdiplus();
     }
 };
 
@@ -100,51 +140,33 @@ public:
 class tray_play_callback : public play_callback_static {
 public:
     void on_playback_new_track(metadb_handle_ptr p_track) override {
-        // Update tray tooltip with new track information
-        tray_manager::get_instance().update_tooltip(p_track);
-        // Update control panel with new track information
-        control_panel::get_instance().update_track_info(p_track);
-        // Show popup notification for new tracks
-        popup_window::get_instance().show_track_info(p_track);
+        handle_playback_new_track(p_track);
     }
     
     void on_playback_starting(play_control::t_track_command p_command, bool p_paused) override {}
     
     void on_playback_pause(bool p_state) override {
-        // Update tray tooltip to show pause state
-        tray_manager::get_instance().update_playback_state(p_state ? "Paused" : "Playing");
-        // Update control panel playback state
-        control_panel::get_instance().update_track_info();
+        handle_playback_pause(p_state);
     }
     
     void on_playback_stop(play_control::t_stop_reason p_reason) override {
-        if (p_reason == play_control::stop_reason_starting_another) {
-            return;
-        }
-        // Update tray tooltip to show stopped state
-        tray_manager::get_instance().update_playback_state("Stopped");
-        // Update control panel playback state
-        control_panel::get_instance().update_track_info();
-        popup_window::get_instance().hide_popup();
+        handle_playback_stop(p_reason);
     }
     
     // Required overrides for play_callback_static
     void on_playback_seek(double p_time) override {}
     void on_playback_edited(metadb_handle_ptr p_track) override {
-        // Update tooltip when track metadata is edited
-        tray_manager::get_instance().update_tooltip(p_track);
-        // Update control panel when track metadata is edited
-        control_panel::get_instance().update_track_info(p_track);
+        handle_playback_edited(p_track);
     }
     void on_playback_dynamic_info(const file_info & p_info) override {
-        tray_manager::get_instance().update_tooltip_with_dynamic_info(p_info);
-        control_panel::get_instance().update_stream_metadata(p_info);
-        popup_window::get_instance().update_stream_metadata(p_info);
+        TRAY_TRACE_SCOPE("playback", "on_playback_dynamic_info");
+        // Parsed once, deduplicated and coalesced before reaching tray, control panel and popup
+        on_stream_dynamic_info(p_info);
     }
     void on_playback_dynamic_info_track(const file_info & p_info) override {
-        tray_manager::get_instance().update_tooltip_with_dynamic_info(p_info);
-        control_panel::get_instance().update_stream_metadata(p_info);
-        popup_window::get_instance().update_stream_metadata(p_info);
+        TRAY_TRACE_SCOPE("playback", "on_playback_dynamic_info_track");
+        // Parsed once, deduplicated and coalesced before reaching tray, control panel and popup
+        on_stream_dynamic_info(p_info);
     }
     void on_playback_time(double p_time) override {}
     void on_volume_change(float p_new_val) override {}
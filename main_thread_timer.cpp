@@ -0,0 +1,29 @@
+#include "stdafx.h"
+#include "main_thread_timer.h"
+#include <map>
+
+// Timer procedures by thread timer id; a thread timer cannot carry a context pointer
+static std::map<UINT_PTR, main_thread_timer_proc> g_timer_procs;
+
+static VOID CALLBACK main_thread_timer_thunk(HWND hwnd, UINT msg, UINT_PTR timer_id, DWORD time) {
+    KillTimer(nullptr, timer_id);
+    auto it = g_timer_procs.find(timer_id);
+    if (it == g_timer_procs.end()) return;
+    main_thread_timer_proc proc = it->second;
+    g_timer_procs.erase(it);
+    proc();
+}
+
+main_thread_timer_id start_main_thread_timer(main_thread_timer_id id, unsigned delay_ms, main_thread_timer_proc proc) {
+    // An id that is not a pending thread timer is ignored and a new one is created
+    UINT_PTR timer = SetTimer(nullptr, (UINT_PTR)id, delay_ms, main_thread_timer_thunk);
+    if (id && timer != id) g_timer_procs.erase(id);
+    if (timer) g_timer_procs[timer] = proc;
+    return timer;
+}
+
+void stop_main_thread_timer(main_thread_timer_id id) {
+    if (!id) return;
+    KillTimer(nullptr, (UINT_PTR)id);
+    g_timer_procs.erase(id);
+}
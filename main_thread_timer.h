@@ -0,0 +1,17 @@
+#pragma once
+
+// One-shot timers on the main thread, for work deferred by a frame or a settle window.
+// main_thread_timer.cpp runs them as thread timers (SetTimer without a window, so WM_TIMER
+// ordering is unchanged); the Linux event replay harness runs them on its simulated clock.
+
+#include <cstdint>
+
+typedef uintptr_t main_thread_timer_id;     // 0 = no timer
+typedef void (*main_thread_timer_proc)();
+
+// Call proc once, delay_ms from now. Passing a pending timer moves it instead of starting
+// another. Returns 0 when no timer is available; callers then do the work synchronously.
+main_thread_timer_id start_main_thread_timer(main_thread_timer_id id, unsigned delay_ms, main_thread_timer_proc proc);
+
+// Cancel a pending timer; 0 and timers that already fired are ignored
+void stop_main_thread_timer(main_thread_timer_id id);
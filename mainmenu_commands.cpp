@@ -3,11 +3,23 @@
 
 #include "stdafx.h"
 #include "control_panel.h"
+#include "preferences.h"
+#include "perf_stats.h"
+#include "tracing.h"
+#include "event_replay.h"
 
 // GUIDs for menu group and commands
 // Generate unique GUIDs for this component
 static const GUID guid_traycontrols_menu_group = { 0x8a7b3c4d, 0x5e6f, 0x4a1b, { 0x9c, 0x2d, 0x3e, 0x4f, 0x5a, 0x6b, 0x7c, 0x8d } };
 static const GUID guid_launch_miniplayer = { 0x1a2b3c4d, 0x5e6f, 0x7a8b, { 0x9c, 0xad, 0xbe, 0xcf, 0xd0, 0xe1, 0xf2, 0x03 } };
+static const GUID guid_toggle_up_next = { 0x6c2d8e1f, 0x4b73, 0x4a59, { 0x91, 0xe0, 0x3f, 0x5a, 0xc8, 0x27, 0xd4, 0x6b } };
+static const GUID guid_jump_to_track = { 0x2f8a41d7, 0x93c6, 0x4e1b, { 0xa5, 0x0d, 0x7b, 0x36, 0xe9, 0x12, 0xc8, 0x54 } };
+#if TRAYCONTROLS_PERF_STATS
+static const GUID guid_collect_perf_stats = { 0x71c4e6a3, 0x0d9b, 0x4f52, { 0x8e, 0x37, 0xa9, 0x1b, 0x5c, 0x60, 0xf2, 0xd4 } };
+static const GUID guid_dump_perf_report = { 0x5d3e9a71, 0x2c48, 0x4f06, { 0xb1, 0x7e, 0x64, 0x0a, 0xd2, 0x93, 0x58, 0xc4 } };
+static const GUID guid_export_trace = { 0x9e41b2c6, 0x7a05, 0x4d3f, { 0x86, 0x1c, 0x2b, 0xe7, 0x50, 0x9f, 0x14, 0xa8 } };
+static const GUID guid_replay_events = { 0x3b6f0d84, 0xe15a, 0x4c97, { 0xa2, 0x38, 0x7d, 0x0e, 0x41, 0xc5, 0x96, 0x2b } };
+#endif
 
 // Register "Tray Controls" menu group under View menu
 static mainmenu_group_popup_factory g_traycontrols_menu_group(
@@ -22,6 +34,14 @@ class mainmenu_commands_traycontrols : public mainmenu_commands {
 public:
     enum {
         cmd_launch_miniplayer = 0,
+        cmd_toggle_up_next,
+        cmd_jump_to_track,
+#if TRAYCONTROLS_PERF_STATS
+        cmd_collect_perf_stats,
+        cmd_dump_perf_report,
+        cmd_export_trace,
+        cmd_replay_events,
+#endif
         cmd_total
     };
     
@@ -32,6 +52,14 @@ public:
     GUID get_command(t_uint32 p_index) override {
         switch(p_index) {
             case cmd_launch_miniplayer: return guid_launch_miniplayer;
+            case cmd_toggle_up_next: return guid_toggle_up_next;
+            case cmd_jump_to_track: return guid_jump_to_track;
+#if TRAYCONTROLS_PERF_STATS
+            case cmd_collect_perf_stats: return guid_collect_perf_stats;
+            case cmd_dump_perf_report: return guid_dump_perf_report;
+            case cmd_export_trace: return guid_export_trace;
+            case cmd_replay_events: return guid_replay_events;
+#endif
             default: uBugCheck();
         }
     }
@@ -39,6 +67,14 @@ public:
     void get_name(t_uint32 p_index, pfc::string_base & p_out) override {
         switch(p_index) {
             case cmd_launch_miniplayer: p_out = "Launch MiniPlayer"; break;
+            case cmd_toggle_up_next: p_out = "Up Next"; break;
+            case cmd_jump_to_track: p_out = "Jump to Track"; break;
+#if TRAYCONTROLS_PERF_STATS
+            case cmd_collect_perf_stats: p_out = "Collect Performance Statistics"; break;
+            case cmd_dump_perf_report: p_out = "Dump Performance Report"; break;
+            case cmd_export_trace: p_out = "Export Performance Trace"; break;
+            case cmd_replay_events: p_out = "Replay Event Script..."; break;
+#endif
             default: uBugCheck();
         }
     }
@@ -48,11 +84,40 @@ public:
             case cmd_launch_miniplayer: 
                 p_out = "Opens the MiniPlayer in Undocked mode at its previous position."; 
                 return true;
+            case cmd_toggle_up_next:
+                p_out = "Shows or hides the playing playlist inside the MiniPlayer.";
+                return true;
+            case cmd_jump_to_track:
+                p_out = "Opens Up Next in the MiniPlayer ready to search the playlist and library by typing.";
+                return true;
+#if TRAYCONTROLS_PERF_STATS
+            case cmd_collect_perf_stats:
+                p_out = "Records paint timings, work counters and trace events for the commands below and the Diagnostics tab.";
+                return true;
+            case cmd_dump_perf_report:
+                p_out = "Prints paint timings and work counters to the console.";
+                return true;
+            case cmd_export_trace:
+                p_out = "Writes recent callback, timer and paint events as a Chrome trace (chrome://tracing, Perfetto) to the profile folder.";
+                return true;
+            case cmd_replay_events:
+                p_out = "Replays a recorded playback event script and prints the cost per event type to the console.";
+                return true;
+#endif
             default: 
                 return false;
         }
     }
     
+    bool get_display(t_uint32 p_index, pfc::string_base & p_text, t_uint32 & p_flags) override {
+        p_flags = 0;
+        get_name(p_index, p_text);
+#if TRAYCONTROLS_PERF_STATS
+        if (p_index == cmd_collect_perf_stats && perf_enabled()) p_flags = flag_checked;
+#endif
+        return true;
+    }
+
     GUID get_parent() override {
         return guid_traycontrols_menu_group;
     }
@@ -62,6 +127,26 @@ public:
             case cmd_launch_miniplayer:
                 control_panel::get_instance().show_undocked_miniplayer();
                 break;
+            case cmd_toggle_up_next:
+                control_panel::get_instance().toggle_up_next();
+                break;
+            case cmd_jump_to_track:
+                control_panel::get_instance().jump_to_track();
+                break;
+#if TRAYCONTROLS_PERF_STATS
+            case cmd_collect_perf_stats:
+                set_perf_stats_enabled(!perf_enabled());
+                break;
+            case cmd_dump_perf_report:
+                perf_dump_to_console();
+                break;
+            case cmd_export_trace:
+                export_trace_to_profile();
+                break;
+            case cmd_replay_events:
+                run_event_replay();
+                break;
+#endif
             default:
                 uBugCheck();
         }
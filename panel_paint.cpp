@@ -0,0 +1,805 @@
+// panel_paint.cpp - Portable control panel painting (no precompiled header, no Windows dependency)
+
+#include "panel_paint.h"
+#include "artwork_pipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cwchar>
+
+namespace {
+
+const float HOVER_ZOOM_FACTOR = 1.30f;
+const float PLAY_ZOOM_FACTOR = HOVER_ZOOM_FACTOR - 0.15f;
+const int PROGRESS_BAR_HEIGHT = 5;
+const int WAVEFORM_HEIGHT = 13;
+
+canvas_color gray(int value) {
+    return canvas_color::rgb((uint8_t)value, (uint8_t)value, (uint8_t)value);
+}
+
+canvas_color with_alpha(canvas_color color, int alpha) {
+    color.a = (uint8_t)alpha;
+    return color;
+}
+
+canvas_rect make_rect(int x, int y, int w, int h) {
+    canvas_rect r = { (float)x, (float)y, (float)w, (float)h };
+    return r;
+}
+
+canvas_rect whole_image(const canvas_image& image) {
+    return make_rect(0, 0, image.width, image.height);
+}
+
+// Center crop of image to the destination's aspect ratio
+canvas_rect center_crop(const canvas_image& image, float dest_aspect) {
+    canvas_rect r = whole_image(image);
+    if (r.w / r.h > dest_aspect) {
+        float cropped = r.h * dest_aspect;
+        r.x = (r.w - cropped) / 2.0f;
+        r.w = cropped;
+    } else {
+        float cropped = r.w / dest_aspect;
+        r.y = (r.h - cropped) / 2.0f;
+        r.h = cropped;
+    }
+    return r;
+}
+
+class phase_scope {
+public:
+    phase_scope(const panel_paint_state& state, panel_paint_phase phase) : m_layers(state.layers), m_phase(phase) {
+        if (m_layers) m_layers->phase_begin(m_phase);
+    }
+    ~phase_scope() {
+        if (m_layers) m_layers->phase_end(m_phase);
+    }
+
+private:
+    panel_paint_layers* m_layers;
+    panel_paint_phase m_phase;
+};
+
+// Icons on the 24x24 Material Design grid. Contours are filled with the nonzero rule, so the
+// outline pause bars keep their holes (wound the other way) and the outline play triangle,
+// whose inner contour runs the same way, comes out solid - as the GDI+ paths always drew it.
+const canvas_point OUTLINE_PLAY[] = {
+    { 8.0f, 19.0f }, { 8.0f, 5.0f }, { 19.0f, 12.0f },
+    { 10.0f, 15.35f }, { 10.0f, 8.65f }, { 15.25f, 12.0f }
+};
+const int OUTLINE_PLAY_CONTOURS[] = { 3, 3 };
+
+const canvas_point OUTLINE_PAUSE[] = {
+    { 5.0f, 19.0f }, { 5.0f, 5.0f }, { 11.0f, 5.0f }, { 11.0f, 19.0f },
+    { 7.0f, 17.0f }, { 9.0f, 17.0f }, { 9.0f, 7.0f }, { 7.0f, 7.0f },
+    { 13.0f, 19.0f }, { 13.0f, 5.0f }, { 19.0f, 5.0f }, { 19.0f, 19.0f },
+    { 15.0f, 17.0f }, { 17.0f, 17.0f }, { 17.0f, 7.0f }, { 15.0f, 7.0f }
+};
+const int OUTLINE_PAUSE_CONTOURS[] = { 4, 4, 4, 4 };
+
+const canvas_point SOLID_PLAY[] = {
+    { 8.0f, 19.0f }, { 8.0f, 5.0f }, { 19.0f, 12.0f }
+};
+const int SOLID_PLAY_CONTOURS[] = { 3 };
+
+const canvas_point SOLID_PAUSE[] = {
+    { 5.875f, 19.45f }, { 5.875f, 4.55f }, { 10.125f, 4.55f }, { 10.125f, 19.45f },
+    { 14.425f, 19.45f }, { 14.425f, 4.55f }, { 18.675f, 4.55f }, { 18.675f, 19.45f }
+};
+const int SOLID_PAUSE_CONTOURS[] = { 4, 4 };
+
+// M10.59 9.17L5.41 4 4 5.41l5.17 5.17 1.42-1.41zM14.5 4l2.04 2.04L4 18.59 5.41 20 17.96 7.46
+// 20 9.5V4h-5.5zm.33 9.41l-1.41 1.41 3.13 3.13L14.5 20H20v-5.5l-2.04 2.04-3.13-3.13z
+const canvas_point SHUFFLE[] = {
+    { 10.59f, 9.17f }, { 5.41f, 4.0f }, { 4.0f, 5.41f }, { 9.17f, 10.58f },
+    { 14.5f, 4.0f }, { 16.54f, 6.04f }, { 4.0f, 18.59f }, { 5.41f, 20.0f }, { 17.96f, 7.46f }, { 20.0f, 9.5f }, { 20.0f, 4.0f },
+    { 14.83f, 13.41f }, { 13.42f, 14.82f }, { 16.55f, 17.95f }, { 14.5f, 20.0f }, { 20.0f, 20.0f }, { 20.0f, 14.5f }, { 17.96f, 16.54f }
+};
+const int SHUFFLE_CONTOURS[] = { 4, 7, 7 };
+
+// M7 7h10v3l4-4-4-4v3H5v6h2V7zm10 10H7v-3l-4 4 4 4v-3h12v-6h-2v4z, plus the "1" of
+// repeat_one (m-4-2V9h-1l-2 1v1h1.5v4H13z) for Track Repeat
+const canvas_point REPEAT[] = {
+    { 7.0f, 7.0f }, { 17.0f, 7.0f }, { 17.0f, 10.0f }, { 21.0f, 6.0f }, { 17.0f, 2.0f }, { 17.0f, 5.0f }, { 5.0f, 5.0f }, { 5.0f, 11.0f }, { 7.0f, 11.0f },
+    { 17.0f, 17.0f }, { 7.0f, 17.0f }, { 7.0f, 14.0f }, { 3.0f, 18.0f }, { 7.0f, 22.0f }, { 7.0f, 19.0f }, { 19.0f, 19.0f }, { 19.0f, 13.0f }, { 17.0f, 13.0f },
+    { 13.0f, 15.0f }, { 13.0f, 9.0f }, { 12.0f, 9.0f }, { 10.0f, 10.0f }, { 10.0f, 11.0f }, { 11.5f, 11.0f }, { 11.5f, 15.0f }
+};
+const int REPEAT_CONTOURS[] = { 9, 9, 7 };
+
+// Grid contours with the grid origin at (x, y), scale px per grid unit
+void fill_grid_path(canvas& c, const canvas_point* grid, const int* contour_sizes, int contour_count,
+    float x, float y, float scale, canvas_color color) {
+    canvas_point points[32];
+    int total = 0;
+    for (int i = 0; i < contour_count; i++) total += contour_sizes[i];
+    for (int i = 0; i < total; i++) {
+        points[i].x = x + grid[i].x * scale;
+        points[i].y = y + grid[i].y * scale;
+    }
+    c.fill_path(points, contour_sizes, contour_count, color);
+}
+
+// Outline (style 1) or solid (style 2) play/pause glyph centered on (x, y)
+void paint_glyph(canvas& c, int style, bool pause, int x, int y, int size, canvas_color color) {
+    float scale = size / 24.0f;
+    float left = (float)x - 12.0f * scale;
+    float top = (float)y - 12.0f * scale;
+    if (style == 1) {
+        if (pause) fill_grid_path(c, OUTLINE_PAUSE, OUTLINE_PAUSE_CONTOURS, 4, left, top, scale, color);
+        else fill_grid_path(c, OUTLINE_PLAY, OUTLINE_PLAY_CONTOURS, 2, left, top, scale, color);
+    } else {
+        if (pause) fill_grid_path(c, SOLID_PAUSE, SOLID_PAUSE_CONTOURS, 2, left, top, scale, color);
+        else fill_grid_path(c, SOLID_PLAY, SOLID_PLAY_CONTOURS, 1, left, top, scale, color);
+    }
+}
+
+// Default style: filled circle with the symbol cut out in a contrasting color
+void paint_circle_glyph(canvas& c, bool pause, int x, int y, int size, canvas_color circle, canvas_color symbol) {
+    int radius = size / 2;
+    c.fill_ellipse((float)(x - radius), (float)(y - radius), (float)size, (float)size, circle);
+
+    int icon_height = size * 4 / 10;
+    int half_icon = icon_height / 2;
+    if (pause) {
+        int bar_width = icon_height / 3;
+        int offset = (icon_height / 3) / 2;
+        c.fill_rect((float)(x - offset - bar_width), (float)(y - half_icon), (float)bar_width, (float)icon_height, symbol);
+        c.fill_rect((float)(x + offset), (float)(y - half_icon), (float)bar_width, (float)icon_height, symbol);
+    } else {
+        int icon_width = icon_height;
+        int center_offset_x = icon_width / 8;
+        const canvas_point triangle[3] = {
+            { (float)(x - icon_width / 2 + center_offset_x), (float)(y - half_icon) },
+            { (float)(x - icon_width / 2 + center_offset_x), (float)(y + half_icon) },
+            { (float)(x + icon_width / 2 + center_offset_x), (float)y }
+        };
+        c.fill_polygon(triangle, 3, symbol);
+    }
+}
+
+void paint_hover_circle(canvas& c, const panel_paint_state& s, panel_button button, int x, int y, int size) {
+    if (s.hovered != button || !s.hover_circles) return;
+    int radius = size / 2 + 4;
+    c.fill_ellipse((float)(x - radius), (float)(y - radius), (float)(radius * 2), (float)(radius * 2), with_alpha(s.theme.icon, 45));
+}
+
+int hover_size(const panel_paint_state& s, panel_button button, int size) {
+    return s.hovered == button ? (int)(size * HOVER_ZOOM_FACTOR) : size;
+}
+
+void paint_play_pause(canvas& c, const panel_paint_state& s, int x, int y, int size) {
+    paint_hover_circle(c, s, panel_button_play_pause, x, y, size);
+    bool pause = s.playing && !s.paused;
+    // Light undocked windows draw the button in black for contrast
+    bool black = s.undocked && !s.theme.dark;
+    if (s.icon_style == 1 || s.icon_style == 2) {
+        paint_glyph(c, s.icon_style, pause, x, y, size, black ? gray(0) : s.theme.icon);
+    } else if (black) {
+        paint_circle_glyph(c, pause, x, y, size, gray(0), gray(255));
+    } else {
+        paint_circle_glyph(c, pause, x, y, size, s.theme.icon, s.theme.background);
+    }
+}
+
+// Undocked play button, faded in with the other controls (opacity 0-100)
+void paint_play_pause_faded(canvas& c, const panel_paint_state& s, int x, int y, int size, int opacity) {
+    paint_hover_circle(c, s, panel_button_play_pause, x, y, size);
+    bool pause = s.playing && !s.paused;
+    // Dark: grey 32 up to white; light: grey 32 down to black
+    int value = s.theme.dark ? (32 + ((255 - 32) * opacity) / 100) : (32 - (32 * opacity) / 100);
+    if (s.icon_style == 1 || s.icon_style == 2) {
+        paint_glyph(c, s.icon_style, pause, x, y, size, gray(value));
+    } else {
+        paint_circle_glyph(c, pause, x, y, size, gray(value), s.theme.dark ? gray(0) : gray(255));
+    }
+}
+
+void paint_previous(canvas& c, const panel_paint_state& s, int x, int y, int size) {
+    paint_hover_circle(c, s, panel_button_prev, x, y, size);
+    const int bar_width = 3;
+    const int gap = 2;
+    int icon_h = size * 6 / 10;
+    c.fill_rect((float)(x - icon_h / 2), (float)(y - icon_h / 2), (float)bar_width, (float)icon_h, s.theme.icon);
+
+    int tri_start_x = x - icon_h / 2 + bar_width + gap;
+    const canvas_point triangle[3] = {
+        { (float)(x + icon_h / 2), (float)(y - icon_h / 2) },
+        { (float)(x + icon_h / 2), (float)(y + icon_h / 2) },
+        { (float)tri_start_x, (float)y }
+    };
+    c.fill_polygon(triangle, 3, s.theme.icon);
+}
+
+void paint_next(canvas& c, const panel_paint_state& s, int x, int y, int size) {
+    paint_hover_circle(c, s, panel_button_next, x, y, size);
+    const int bar_width = 3;
+    const int gap = 2;
+    int icon_h = size * 6 / 10;
+    int tri_start_x = x - icon_h / 2;
+    const canvas_point triangle[3] = {
+        { (float)tri_start_x, (float)(y - icon_h / 2) },
+        { (float)tri_start_x, (float)(y + icon_h / 2) },
+        { (float)(tri_start_x + icon_h - bar_width - gap), (float)y }
+    };
+    c.fill_polygon(triangle, 3, s.theme.icon);
+    c.fill_rect((float)(tri_start_x + icon_h - bar_width), (float)(y - icon_h / 2), (float)bar_width, (float)icon_h, s.theme.icon);
+}
+
+// Active toggles take the icon color; inactive ones are dimmed, much lighter in light mode
+canvas_color toggle_color(const panel_paint_state& s, bool active) {
+    if (active) return s.theme.icon;
+    return s.theme.dark ? s.theme.text_dim : gray(200);
+}
+
+void paint_shuffle(canvas& c, const panel_paint_state& s, int x, int y, int size) {
+    paint_hover_circle(c, s, panel_button_shuffle, x, y, size);
+    fill_grid_path(c, SHUFFLE, SHUFFLE_CONTOURS, 3, (float)x - size / 2.0f, (float)y - size / 2.0f, size / 24.0f,
+        toggle_color(s, s.shuffle));
+}
+
+void paint_repeat(canvas& c, const panel_paint_state& s, int x, int y, int size) {
+    paint_hover_circle(c, s, panel_button_repeat, x, y, size);
+    fill_grid_path(c, REPEAT, REPEAT_CONTOURS, s.repeat_mode == 2 ? 3 : 2, (float)x - size / 2.0f, (float)y - size / 2.0f,
+        size / 24.0f, toggle_color(s, s.repeat_mode > 0));
+}
+
+// Corner controls: white on dark, black on light, never fainter than alpha 50
+canvas_color corner_color(const panel_paint_state& s, int opacity) {
+    int alpha = (std::max)(50, (255 * opacity) / 100);
+    return with_alpha(gray(s.theme.dark ? 255 : 0), alpha);
+}
+
+void paint_close(canvas& c, const panel_paint_state& s, int x, int y, int size, int opacity) {
+    canvas_color color = corner_color(s, opacity);
+    int half = size / 2;
+    c.draw_line((float)(x - half), (float)(y - half), (float)(x + half), (float)(y + half), 2.0f, color);
+    c.draw_line((float)(x + half), (float)(y - half), (float)(x - half), (float)(y + half), 2.0f, color);
+}
+
+// Right triangle in the bottom-right corner: switches the MiniPlayer to Compact
+void paint_collapse(canvas& c, const panel_paint_state& s, int x, int y, int size, int opacity) {
+    int half = size / 2;
+    const canvas_point triangle[3] = {
+        { (float)(x + half), (float)(y - half) },
+        { (float)(x + half), (float)(y + half) },
+        { (float)(x - half), (float)(y + half) }
+    };
+    c.fill_polygon(triangle, 3, corner_color(s, opacity));
+}
+
+// Up/down arrows over the artwork (Material Design arrow drop), in grey value
+void paint_arrow(canvas& c, int x, int y, int size, bool up, int value) {
+    int half = size / 2;
+    int tip = up ? -half / 2 : half / 2;
+    const canvas_point triangle[3] = {
+        { (float)x, (float)(y + tip) },
+        { (float)(x - half), (float)(y - tip) },
+        { (float)(x + half), (float)(y - tip) }
+    };
+    c.fill_polygon(triangle, 3, gray(value));
+}
+
+// Artwork (or the signature preview, or a placeholder) in a size x size square at (x, y)
+void paint_cover(canvas& c, const panel_paint_state& s, int x, int y, int size) {
+    if (size <= 0) return;
+    phase_scope phase(s, panel_phase_cover_art);
+    canvas_rect dest = make_rect(x, y, size, size);
+    if (s.rounded_cover) {
+        float radius = (std::min)((std::max)(size * 0.10f, 4.0f), 12.0f);
+        if (!s.cover.empty()) {
+            c.draw_image(s.cover, dest, center_crop(s.cover, 1.0f), radius);
+        } else if (!s.preview.empty()) {
+            c.draw_image(s.preview, dest, center_crop(s.preview, 1.0f), radius);
+        } else {
+            c.fill_rounded_rect(dest.x, dest.y, dest.w, dest.h, radius, s.theme.placeholder);
+        }
+    } else {
+        if (!s.cover.empty()) {
+            c.draw_image(s.cover, dest, whole_image(s.cover), 0.0f);
+        } else if (!s.preview.empty()) {
+            c.draw_image(s.preview, dest, whole_image(s.preview), 0.0f);
+        } else {
+            c.fill_rect(dest.x, dest.y, dest.w, dest.h, s.theme.placeholder);
+        }
+    }
+}
+
+// Title or artist line. A line that overflows scrolls by the ticker's offset when the ticker
+// is enabled and is cut with "..." otherwise.
+void paint_ticker_line(canvas& c, const panel_paint_state& s, const canvas_font& font, const wchar_t* text,
+    const canvas_rect& box, canvas_color color, panel_ticker* ticker) {
+    phase_scope phase(s, panel_phase_text);
+    if (!text) text = L"";
+    if (!ticker) {
+        c.draw_text(font, text, box, canvas_align_near, color, canvas_text_end_ellipsis);
+        return;
+    }
+    if (box.w <= 0.0f) {
+        ticker->active = false;
+        ticker->offset = 0.0f;
+        return;
+    }
+
+    canvas_text_extent extent = c.measure_text(font, text);
+    bool overflow = extent.width > box.w;
+    // New text starts over from the left; so does text that fits
+    if (!overflow || ticker->changed) {
+        ticker->offset = 0.0f;
+        ticker->direction = 1;
+    }
+    ticker->changed = false;
+
+    float max_offset = (std::max)(0.0f, std::floor(extent.width - box.w));
+    if (ticker->offset < 0.0f) { ticker->offset = 0.0f; ticker->direction = 1; }
+    if (ticker->offset > max_offset) { ticker->offset = max_offset; ticker->direction = -1; }
+    ticker->active = overflow && ticker->enabled;
+
+    if (ticker->active) {
+        c.set_clip((int)box.x, (int)box.y, (int)box.w, (int)box.h);
+        canvas_rect run = { box.x - std::floor(ticker->offset + 0.5f), box.y, extent.width, box.h };
+        c.draw_text(font, text, run, canvas_align_near, color, 0);
+        c.reset_clip();
+    } else {
+        c.draw_text(font, text, box, canvas_align_near, color, canvas_text_end_ellipsis);
+    }
+}
+
+// Up/down arrows over the artwork while the pointer is on it (switch artwork source)
+void paint_artwork_arrows(canvas& c, const panel_paint_state& s) {
+    if (s.artwork_overlay_opacity <= 0) return;
+    int art_size, art_x, art_y;
+    if (s.mode == panel_mode_compact) {
+        const int margin = 5;
+        art_size = s.height - 2 * margin;
+        art_x = margin;
+        art_y = margin;
+    } else {
+        art_size = (std::min)((std::min)(80, s.width - 30), s.height - 30);
+        art_x = 15;
+        art_y = 15;
+    }
+    int value = (255 * s.artwork_overlay_opacity) / 100;
+    int center_x = art_x + art_size / 2;
+    paint_arrow(c, center_x, art_y + art_size / 4, 16, true, value);
+    paint_arrow(c, center_x, art_y + (3 * art_size) / 4, 16, false, value);
+}
+
+void format_time(wchar_t* out, size_t size, const wchar_t* format, double seconds) {
+    int whole = (int)seconds;
+    swprintf(out, size, format, whole / 60, whole % 60);
+}
+
+void paint_docked(canvas& c, const panel_paint_state& s) {
+    paint_panel_background(c, s);
+    const int w = s.width;
+    const int h = s.height;
+
+    int art_size = panel_cover_size(s);
+    if (s.show_cover_art) {
+        int art_xy = s.cover_margin ? 15 : 0;
+        paint_cover(c, s, art_xy, art_xy, art_size);
+        if (s.stream_placeholder && !s.radio_icon.empty() && art_size > 0) {
+            int icon_size = art_size / 2;
+            int icon_xy = art_xy + (art_size - icon_size) / 2;
+            c.draw_image(s.radio_icon, make_rect(icon_xy, icon_xy, icon_size, icon_size), whole_image(s.radio_icon), 0.0f);
+        }
+    }
+
+    // Track info right of the artwork, leaving room for the time
+    int text_left = 15 + art_size + 10;
+    int text_right = w - 70;
+    paint_ticker_line(c, s, s.title_font, s.title, make_rect(text_left, 20, text_right - text_left, 25), s.theme.text, s.title_ticker);
+    paint_ticker_line(c, s, s.artist_font, s.artist, make_rect(text_left, 50, text_right - text_left, 20), s.theme.text_dim, s.artist_ticker);
+
+    if (s.playing) {
+        phase_scope phase(s, panel_phase_text);
+        wchar_t time[16];
+        format_time(time, 16, L"%02d:%02d", s.position);
+        canvas_text_extent extent = c.measure_text(s.timer_font, time);
+        int time_w = (std::max)((int)extent.width + 8, 50);
+        int time_h = (std::max)((int)extent.height + 8, 25);
+        const int center_y = 32; // Middle of the title/artist lines
+        c.draw_text(s.timer_font, time, make_rect(w - time_w - 10, center_y - time_h / 2, time_w, (time_h / 2) * 2),
+            canvas_align_center, s.theme.text, 0);
+    }
+
+    if (s.artwork_overlay_visible) paint_artwork_arrows(c, s);
+
+    // Buttons centered right of the artwork: undocked has five, docked three and more room
+    int button_y = h - 30;
+    int button_area_left = 15 + art_size + 10;
+    int button_area_width = w - button_area_left - 10;
+    int center_x = button_area_left + button_area_width / 2;
+
+    int button_spacing = s.undocked ? 40 : 60;
+    int icon_size = 24;
+    int play_icon_size = 36;
+    if (s.undocked && w < 280) {
+        button_spacing = (std::max)(24, (button_area_width * 16) / 100);
+        icon_size = (std::max)(16, (button_area_width * 9) / 100);
+        play_icon_size = (std::max)(24, (button_area_width * 14) / 100);
+    }
+
+    paint_previous(c, s, center_x - button_spacing, button_y, hover_size(s, panel_button_prev, icon_size));
+    int play_size = s.hovered == panel_button_play_pause ? (int)(play_icon_size * PLAY_ZOOM_FACTOR) : play_icon_size;
+    if (s.undocked) {
+        paint_play_pause_faded(c, s, center_x, button_y, play_size, s.button_opacity);
+    } else {
+        paint_play_pause(c, s, center_x, button_y, play_size);
+    }
+    paint_next(c, s, center_x + button_spacing, button_y, hover_size(s, panel_button_next, icon_size));
+    if (s.undocked) {
+        paint_shuffle(c, s, center_x - button_spacing * 2, button_y, hover_size(s, panel_button_shuffle, icon_size));
+        paint_repeat(c, s, center_x + button_spacing * 2, button_y, hover_size(s, panel_button_repeat, icon_size));
+    }
+
+    if (s.corner_controls) {
+        paint_close(c, s, w - 15, 15, 12, 100);
+        paint_collapse(c, s, w - 15, h - 15, 12, 100);
+    }
+
+    paint_panel_border(c, s);
+}
+
+// Controls over the compact text area while the pointer is on it
+void paint_compact_controls(canvas& c, const panel_paint_state& s) {
+    const int w = s.width;
+    const int h = s.height;
+    const int margin = 5;
+    int art_size = s.show_cover_art ? (s.cover_margin ? h - 2 * margin : h) : 0;
+    int text_left = 0;
+    if (s.show_cover_art && art_size > 0) {
+        text_left = s.cover_margin ? margin + art_size + margin : art_size;
+    }
+    int text_area_width = w - text_left;
+    int overlay_bottom = h - 18; // Progress bar and time stay visible below
+
+    const int button_size = 24;
+    const int play_button_size = 34;
+    const int button_spacing = 10;
+    int total_buttons_width = 4 * button_size + play_button_size + 4 * button_spacing;
+    int buttons_start_x = text_left + (text_area_width - total_buttons_width) / 2;
+    if (s.show_cover_art) buttons_start_x -= 15;
+    int center_y = overlay_bottom / 2 + 5;
+
+    int shuffle_x = buttons_start_x + button_size / 2;
+    int prev_x = shuffle_x + button_size / 2 + button_spacing + button_size / 2;
+    int play_x = prev_x + button_size / 2 + button_spacing + play_button_size / 2;
+    int next_x = play_x + play_button_size / 2 + button_spacing + button_size / 2;
+    int repeat_x = next_x + button_size / 2 + button_spacing + button_size / 2;
+
+    // Solid backgrounds hide the text behind the buttons; artwork backgrounds show through
+    if (s.background_style == 0) {
+        int left = s.show_cover_art ? text_left : 0;
+        c.fill_rect((float)left, 0.0f, (float)(w - left), (float)overlay_bottom, s.theme.background);
+    }
+
+    paint_shuffle(c, s, shuffle_x, center_y, hover_size(s, panel_button_shuffle, button_size));
+    paint_previous(c, s, prev_x, center_y, hover_size(s, panel_button_prev, button_size));
+    int play_size = s.hovered == panel_button_play_pause ? (int)(play_button_size * PLAY_ZOOM_FACTOR) : play_button_size;
+    paint_play_pause(c, s, play_x, center_y, play_size);
+    paint_next(c, s, next_x, center_y, hover_size(s, panel_button_next, button_size));
+    paint_repeat(c, s, repeat_x, center_y, hover_size(s, panel_button_repeat, button_size));
+}
+
+// One-pixel columns from the cached envelope; played columns take the Progress Accent color
+void paint_waveform_seekbar(canvas& c, const panel_paint_state& s, int left, int top, int width, int height, int fill_width) {
+    panel_waveform& waveform = *s.waveform;
+    if (width <= 0) return;
+    if (waveform.columns_generation != waveform.generation || (int)waveform.column_max.size() != width) {
+        peak_envelope(*waveform.peaks, width, waveform.column_min, waveform.column_max);
+        waveform.columns_generation = waveform.generation;
+    }
+
+    waveform.played.clear();
+    waveform.remaining.clear();
+    int half = height / 2;
+    int center = top + half;
+    for (int x = 0; x < width; x++) {
+        int up = waveform.column_max[x] > 0 ? (waveform.column_max[x] * half + 63) / 127 : 0;
+        int down = waveform.column_min[x] < 0 ? (-waveform.column_min[x] * half + 63) / 127 : 0;
+        canvas_rect column = make_rect(left + x, center - up, 1, up + down + 1);
+        (x < fill_width ? waveform.played : waveform.remaining).push_back(column);
+    }
+    c.fill_rects(waveform.played.data(), (int)waveform.played.size(), s.accent);
+    c.fill_rects(waveform.remaining.data(), (int)waveform.remaining.size(), s.theme.progress_background);
+}
+
+void paint_compact(canvas& c, const panel_paint_state& s) {
+    paint_panel_background(c, s);
+    const int w = s.width;
+    const int h = s.height;
+    const int margin = 5;
+
+    int art_size = panel_cover_size(s);
+    if (s.show_cover_art) {
+        int art_xy = s.cover_margin ? margin : 0;
+        paint_cover(c, s, art_xy, art_xy, art_size);
+        if (s.artwork_overlay_visible) paint_artwork_arrows(c, s);
+    }
+
+    int text_left = margin + 5;
+    if (s.show_cover_art && art_size > 0) {
+        text_left = s.cover_margin ? margin + art_size + margin + 10 : art_size + 10;
+    }
+    int text_right = w - margin;
+
+    bool has_waveform = s.waveform && s.waveform->peaks && s.waveform_seekbar;
+    int band_top = 0, band_height = 0;
+    panel_compact_progress_band(h, has_waveform, band_top, band_height);
+
+    // Spectrum behind the text, above the progress band
+    if (s.spectrum && s.layers) {
+        s.layers->spectrum(c, text_left, margin, text_right, band_top - 2);
+    }
+
+    if (!s.compact_controls_visible) {
+        int title_bottom = margin + (int)(h * 0.36);
+        paint_ticker_line(c, s, s.title_font, s.title, make_rect(text_left, margin, text_right - text_left, title_bottom - margin),
+            s.theme.text, s.title_ticker);
+        int artist_top = margin + (int)(h * 0.31);
+        int artist_bottom = margin + (int)(h * 0.63);
+        paint_ticker_line(c, s, s.artist_font, s.artist, make_rect(text_left, artist_top, text_right - text_left, artist_bottom - artist_top),
+            s.theme.text_dim, s.artist_ticker);
+    }
+
+    // Elapsed time, sized for at least "00:00" so the bar does not jump as it counts
+    wchar_t time[16] = L"";
+    int time_w = 0, time_h = 0;
+    if (s.playing) {
+        format_time(time, 16, L"%d:%02d", s.position);
+        canvas_text_extent extent = c.measure_text(s.timer_font, time);
+        canvas_text_extent sample = c.measure_text(s.timer_font, L"00:00");
+        time_w = (int)(std::max)(extent.width, sample.width);
+        time_h = (int)(std::max)(extent.height, sample.height);
+    }
+
+    int bar_y = h - PROGRESS_BAR_HEIGHT - 2 - (int)(h * 0.1);
+    int reserved = (s.playing && time_w > 0) ? time_w + 6 : 0;
+    int bar_width = (std::max)(10, text_right - text_left - reserved);
+    double ratio = s.length > 0 ? s.position / s.length : 0.0;
+    ratio = (std::min)((std::max)(ratio, 0.0), 1.0);
+    int fill_width = (int)(bar_width * ratio);
+
+    if (has_waveform && band_height > PROGRESS_BAR_HEIGHT) {
+        paint_waveform_seekbar(c, s, text_left, band_top, bar_width, band_height, fill_width);
+    } else {
+        c.fill_rect((float)text_left, (float)bar_y, (float)bar_width, (float)PROGRESS_BAR_HEIGHT, s.theme.progress_background);
+        if (fill_width > 0) {
+            c.fill_rect((float)text_left, (float)bar_y, (float)fill_width, (float)PROGRESS_BAR_HEIGHT, s.accent);
+        }
+    }
+
+    if (s.playing && time_w > 0) {
+        phase_scope phase(s, panel_phase_text);
+        // Centered on the bar's line so tall DPI-scaled fonts are not clipped
+        int bar_center_y = bar_y + PROGRESS_BAR_HEIGHT / 2;
+        int half_height = time_h / 2 + 4;
+        c.draw_text(s.timer_font, time, make_rect(text_right - time_w, bar_center_y - half_height, time_w, half_height * 2),
+            canvas_align_far, s.theme.text, 0);
+    }
+
+    if (s.compact_controls_visible) paint_compact_controls(c, s);
+    if (s.corner_controls) paint_close(c, s, w - 15, 15, 12, 100);
+
+    paint_panel_border(c, s);
+}
+
+// Glass strip with the track title and artist across the top of the expanded artwork
+void paint_track_overlay(canvas& c, const panel_paint_state& s) {
+    if (s.overlay_opacity <= 0) return;
+    const int w = s.width;
+    int title_h = (int)c.measure_text(s.title_font, L"").height;
+    int artist_h = (int)c.measure_text(s.artist_font, L"").height;
+    if (title_h <= 0) title_h = 24;
+    if (artist_h <= 0) artist_h = 18;
+
+    int spacing = (std::max)(6, (int)(artist_h * 0.35f));
+    int total_text_h = title_h + spacing + artist_h;
+    int padding_v = (std::max)(10, (int)(title_h * 0.35f));
+    int overlay_height = (std::max)(70, total_text_h + padding_v * 2);
+
+    int alpha = (180 * s.overlay_opacity) / 100;
+    // Starts at -1 so anti-aliasing leaves no gap along the top edge
+    c.fill_rect(-1.0f, -1.0f, (float)w + 2.0f, (float)overlay_height + 1.0f, with_alpha(gray(s.theme.dark ? 20 : 240), alpha));
+
+    phase_scope phase(s, panel_phase_text);
+    canvas_color text = s.theme.dark ? gray(255) : gray(32);
+    int start_y = (overlay_height - total_text_h) / 2;
+    const wchar_t* title = s.title && *s.title ? s.title : L"[No Track Title]";
+    const wchar_t* artist = s.artist && *s.artist ? s.artist : L"[No Artist]";
+    c.draw_text(s.title_font, title, make_rect(15, start_y, w - 30, title_h), canvas_align_center, text, canvas_text_end_ellipsis);
+    c.draw_text(s.artist_font, artist, make_rect(15, start_y + title_h + spacing, w - 30, artist_h), canvas_align_center, text,
+        canvas_text_end_ellipsis);
+}
+
+// Glass strip with the five buttons along the bottom of the expanded artwork
+void paint_control_overlay(canvas& c, const panel_paint_state& s) {
+    if (s.overlay_opacity <= 0) return;
+    const int w = s.width;
+    const int h = s.height;
+    const int overlay_height = 70;
+
+    int alpha = (180 * s.overlay_opacity) / 100;
+    c.fill_rect(-1.0f, (float)(h - overlay_height), (float)w + 2.0f, (float)overlay_height + 1.0f,
+        with_alpha(gray(s.theme.dark ? 20 : 240), alpha));
+
+    int button_size = 24;
+    int play_button_size = 38;
+    int button_spacing = 60;
+    // Small Expanded windows shrink the row
+    if (w < 360) {
+        button_spacing = (std::max)(32, (w * 16) / 100);
+        button_size = (std::min)((std::max)((w * 8) / 100, 16), 24);
+        play_button_size = (std::min)((std::max)((w * 13) / 100, 26), 38);
+    }
+
+    int center_x = w / 2;
+    int center_y = h - overlay_height + overlay_height / 2;
+    paint_previous(c, s, center_x - button_spacing, center_y, hover_size(s, panel_button_prev, button_size));
+    int play_size = s.hovered == panel_button_play_pause ? (int)(play_button_size * PLAY_ZOOM_FACTOR) : play_button_size;
+    paint_play_pause(c, s, center_x, center_y, play_size);
+    paint_next(c, s, center_x + button_spacing, center_y, hover_size(s, panel_button_next, button_size));
+    paint_shuffle(c, s, center_x - button_spacing * 2, center_y, hover_size(s, panel_button_shuffle, button_size));
+    paint_repeat(c, s, center_x + button_spacing * 2, center_y, hover_size(s, panel_button_repeat, button_size));
+
+    paint_close(c, s, w - 15, 15, 12, s.button_opacity);
+    paint_collapse(c, s, w - 15, h - 15, 12, s.button_opacity);
+}
+
+void paint_expanded(canvas& c, const panel_paint_state& s) {
+    const int w = s.width;
+    const int h = s.height;
+    canvas_rect full = make_rect(0, 0, w, h);
+    {
+        phase_scope phase(s, panel_phase_cover_art);
+        // The window keeps the artwork's aspect ratio, so the artwork fills it
+        if (!s.expanded_art.empty()) {
+            c.draw_image(s.expanded_art, full, whole_image(s.expanded_art), 0.0f);
+        } else if (!s.preview.empty()) {
+            c.draw_image(s.preview, full, center_crop(s.preview, (float)w / (float)h), 0.0f);
+        } else {
+            c.fill_rect(0.0f, 0.0f, (float)w, (float)h, gray(60));
+            int smallest = (std::min)(w, h);
+            if (s.stream_placeholder && !s.radio_icon.empty()) {
+                int icon_size = smallest / 4;
+                c.draw_image(s.radio_icon, make_rect((w - icon_size) / 2, (h - icon_size) / 2, icon_size, icon_size),
+                    whole_image(s.radio_icon), 0.0f);
+            } else {
+                // Radio for streams, a note for local files
+                canvas_font symbol = canvas_font::make(L"Segoe UI Symbol", smallest / 8, 400);
+                c.draw_text(symbol, s.stream_placeholder ? L"\U0001F4FB" : L"\u266A", full, canvas_align_center, gray(200), 0);
+            }
+        }
+    }
+
+    if (s.overlay_visible) {
+        paint_track_overlay(c, s);
+        paint_control_overlay(c, s);
+    }
+}
+
+} // namespace
+
+void paint_panel(canvas& c, const panel_paint_state& state) {
+    if (state.width <= 0 || state.height <= 0) return;
+    switch (state.mode) {
+    case panel_mode_compact:
+        paint_compact(c, state);
+        break;
+    case panel_mode_expanded:
+        paint_expanded(c, state);
+        break;
+    default:
+        paint_docked(c, state);
+        break;
+    }
+}
+
+void paint_panel_background(canvas& c, const panel_paint_state& s) {
+    const int w = s.width;
+    const int h = s.height;
+    if (w <= 0 || h <= 0) return;
+    phase_scope phase(s, panel_phase_background);
+
+    // Rounded windows fill a card inset by half the border's width
+    float radius = s.rounded_border ? 8.0f : 0.0f;
+    canvas_rect card = s.rounded_border ? canvas_rect{ 0.5f, 0.5f, (float)w - 1.0f, (float)h - 1.0f } : make_rect(0, 0, w, h);
+
+    if (s.background_style == 1 && s.has_artwork_color) {
+        const canvas_color primary = s.artwork_color;
+        const canvas_color secondary = canvas_color::rgb(primary.r * 65 / 100, primary.g * 65 / 100, primary.b * 65 / 100);
+        c.fill_linear_gradient(card, radius, secondary, primary);
+        c.fill_rounded_rect(card.x, card.y, card.w, card.h, radius, with_alpha(gray(0), s.theme.dark ? 70 : 30));
+        return;
+    }
+    if (s.background_style == 2 && !s.blurred_background.empty()) {
+        // Drawn 1:1, the card only decides which pixels are kept
+        c.draw_image(s.blurred_background, card, card, radius);
+        c.fill_rounded_rect(card.x, card.y, card.w, card.h, radius, with_alpha(gray(0), s.theme.dark ? 120 : 160));
+        return;
+    }
+    c.fill_rounded_rect(card.x, card.y, card.w, card.h, radius, s.theme.background);
+}
+
+void paint_panel_border(canvas& c, const panel_paint_state& s) {
+    if (s.width <= 0 || s.height <= 0) return;
+    canvas_color color = s.theme.dark ? canvas_color::rgb(60, 60, 64) : canvas_color::rgb(218, 218, 222);
+    c.stroke_rounded_rect(0.5f, 0.5f, (float)s.width - 1.0f, (float)s.height - 1.0f, s.rounded_border ? 8.0f : 0.0f, 1.0f, color);
+}
+
+int panel_cover_size(const panel_paint_state& s) {
+    if (!s.show_cover_art) return 0;
+    if (s.mode == panel_mode_compact) return s.cover_margin ? s.height - 10 : s.height;
+    return s.cover_margin ? (std::min)((std::min)(80, s.width - 30), s.height - 30) : s.height;
+}
+
+void panel_compact_progress_band(int window_height, bool waveform, int& top, int& height) {
+    int bar_y = window_height - PROGRESS_BAR_HEIGHT - 2 - (int)(window_height * 0.1);
+    if (waveform) {
+        // Centered on the flat bar's line so the elapsed time stays aligned with it
+        height = WAVEFORM_HEIGHT;
+        top = bar_y + PROGRESS_BAR_HEIGHT / 2 - WAVEFORM_HEIGHT / 2;
+    } else {
+        height = PROGRESS_BAR_HEIGHT;
+        top = bar_y;
+    }
+}
+
+void build_blurred_background(const canvas_image& art, int width, int height, int radius_x, int radius_y,
+    std::vector<uint8_t>& out) {
+    out.clear();
+    if (art.empty() || width <= 0 || height <= 0) return;
+
+    // Area average down to 64x64: every source pixel counts, so large covers do not alias
+    const int blur_size = 64;
+    uint8_t scaled[blur_size * blur_size * 4];
+    uint8_t blurred[blur_size * blur_size * 4];
+    for (int dy = 0; dy < blur_size; dy++) {
+        int y0 = dy * art.height / blur_size;
+        int y1 = (std::max)(y0 + 1, (dy + 1) * art.height / blur_size);
+        for (int dx = 0; dx < blur_size; dx++) {
+            int x0 = dx * art.width / blur_size;
+            int x1 = (std::max)(x0 + 1, (dx + 1) * art.width / blur_size);
+            unsigned sum[3] = { 0, 0, 0 };
+            for (int y = y0; y < y1; y++) {
+                const uint8_t* row = art.bits + (ptrdiff_t)y * art.stride;
+                for (int x = x0; x < x1; x++) {
+                    sum[0] += row[x * 4 + 0];
+                    sum[1] += row[x * 4 + 1];
+                    sum[2] += row[x * 4 + 2];
+                }
+            }
+            unsigned count = (unsigned)((y1 - y0) * (x1 - x0));
+            uint8_t* px = scaled + (dy * blur_size + dx) * 4;
+            px[0] = (uint8_t)(sum[0] / count);
+            px[1] = (uint8_t)(sum[1] / count);
+            px[2] = (uint8_t)(sum[2] / count);
+            px[3] = 255;
+        }
+    }
+
+    box_blur_bgra(scaled, blur_size * 4, blurred, blur_size * 4, blur_size, blur_size, radius_x, radius_y);
+    out.resize((size_t)width * height * 4);
+    resample_cover_bgra(blurred, blur_size, blur_size, blur_size * 4, out.data(), width, height, width * 4);
+}
+
+bool average_artwork_color(const canvas_image& art, canvas_color& color) {
+    if (art.empty()) return false;
+    const int grid_size = 8;
+    unsigned total_r = 0, total_g = 0, total_b = 0;
+    for (int y = 0; y < grid_size; y++) {
+        int sample_y = (art.height * (y + 1)) / (grid_size + 1);
+        const uint8_t* row = art.bits + (ptrdiff_t)sample_y * art.stride;
+        for (int x = 0; x < grid_size; x++) {
+            const uint8_t* px = row + ((art.width * (x + 1)) / (grid_size + 1)) * 4;
+            total_b += px[0];
+            total_g += px[1];
+            total_r += px[2];
+        }
+    }
+    const unsigned count = grid_size * grid_size;
+    color = canvas_color::rgb((uint8_t)(total_r / count), (uint8_t)(total_g / count), (uint8_t)(total_b / count));
+    return true;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+// Control panel drawing for every mode (docked, undocked, compact, expanded) and their hover
+// overlays, written against canvas. The window gathers what a frame shows into a
+// panel_paint_state and hands it to paint_panel with a gdiplus_canvas; the bench and the
+// golden-image tests paint the same frames on a software_canvas. No Windows dependency.
+
+#include "canvas.h"
+#include "waveform_peaks.h"
+#include <cstdint>
+#include <vector>
+
+enum panel_mode {
+    panel_mode_panel,       // Docked or undocked panel (panel_paint_state::undocked)
+    panel_mode_compact,
+    panel_mode_expanded
+};
+
+// Button under the pointer, drawn enlarged (and with a hover circle)
+enum panel_button {
+    panel_button_none = 0,
+    panel_button_prev = 1,
+    panel_button_play_pause = 2,
+    panel_button_next = 3,
+    panel_button_shuffle = 4,
+    panel_button_repeat = 5
+};
+
+struct panel_theme {
+    bool dark;
+    canvas_color background;
+    canvas_color text;
+    canvas_color text_dim;
+    canvas_color placeholder;
+    canvas_color progress_background;
+    canvas_color icon;
+};
+
+// Scrolling state of a title or artist line that does not fit. The window owns it and steps
+// offset on its ticker timer; painting lays the line out, clamps offset to the overflow and
+// reports whether the line scrolls.
+struct panel_ticker {
+    float offset;
+    int direction;      // +1 while the offset grows, -1 on the way back
+    bool enabled;       // Ticker Speed is not Off and the text is not a short title
+    bool changed;       // Text differs from the one last laid out; cleared once laid out
+    bool active;        // Out: the line overflows and scrolls (left as is when not painted)
+};
+
+// Waveform seekbar peaks plus the per-column envelope built from them, kept across frames
+struct panel_waveform {
+    const waveform_peaks* peaks;
+    unsigned generation;            // Bumped by the owner whenever peaks changes
+    std::vector<int8_t> column_min;
+    std::vector<int8_t> column_max;
+    unsigned columns_generation;
+    std::vector<canvas_rect> played;
+    std::vector<canvas_rect> remaining;
+};
+
+enum panel_paint_phase {
+    panel_phase_background,
+    panel_phase_cover_art,
+    panel_phase_text
+};
+
+// Hooks for what only the window can do while a frame is painted
+class panel_paint_layers {
+public:
+    virtual ~panel_paint_layers() {}
+    // Spectrum bars over the (left, top, right, bottom) area, on the pixels painted so far
+    virtual void spectrum(canvas& c, int left, int top, int right, int bottom) = 0;
+    // Brackets each timed part of the frame (perf counters)
+    virtual void phase_begin(panel_paint_phase) {}
+    virtual void phase_end(panel_paint_phase) {}
+};
+
+struct panel_paint_state {
+    int width;
+    int height;
+    panel_mode mode;
+    bool undocked;
+    panel_theme theme;
+    canvas_color accent;            // Progress Accent
+
+    // Preferences
+    int background_style;           // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
+    bool rounded_border;
+    bool show_cover_art;
+    bool cover_margin;
+    bool rounded_cover;
+    int icon_style;                 // 0 = circle, 1 = outline, 2 = solid
+    bool hover_circles;
+
+    // Artwork. cover is the bitmap (or animation frame) at panel size, expanded_art the full
+    // resolution one; preview is the signature preview shown while the artwork decodes.
+    canvas_image cover;
+    canvas_image expanded_art;
+    canvas_image preview;
+    canvas_image radio_icon;
+    canvas_image blurred_background;    // Window sized, from build_blurred_background
+    bool has_artwork_color;
+    canvas_color artwork_color;
+    bool stream_placeholder;        // A stream with no artwork: radio icon where the art goes
+
+    // Track
+    const wchar_t* title;
+    const wchar_t* artist;
+    canvas_font title_font;
+    canvas_font artist_font;
+    canvas_font timer_font;
+    panel_ticker* title_ticker;
+    panel_ticker* artist_ticker;
+    bool playing;
+    bool paused;
+    double position;
+    double length;
+    bool shuffle;
+    int repeat_mode;                // 0 = off, 1 = playlist, 2 = track
+
+    // Hover state
+    panel_button hovered;
+    int button_opacity;             // 0-100
+    bool overlay_visible;           // Expanded: track and control overlays
+    int overlay_opacity;
+    bool artwork_overlay_visible;   // Artwork up/down arrows
+    int artwork_overlay_opacity;
+    bool compact_controls_visible;
+    bool corner_controls;           // Close (and collapse) in the corners
+
+    panel_waveform* waveform;       // Null or no peaks: flat progress bar
+    bool waveform_seekbar;          // Waveform Seekbar preference
+    bool spectrum;                  // Ask layers for spectrum bars
+    panel_paint_layers* layers;
+};
+
+// Paints a whole frame for state.mode
+void paint_panel(canvas& c, const panel_paint_state& state);
+
+void paint_panel_background(canvas& c, const panel_paint_state& state);
+void paint_panel_border(canvas& c, const panel_paint_state& state);
+
+// Side of the square cover in the panel and compact layouts (0 when the cover is hidden; can
+// come out zero or negative in a tiny window). The window sizes animated frames by it.
+int panel_cover_size(const panel_paint_state& state);
+
+// Compact progress band: the flat bar, or the taller waveform centered on the bar's line
+void panel_compact_progress_band(int window_height, bool waveform, int& top, int& height);
+
+// Blurred Artwork background at width x height: area-averaged to 64x64, box blurred, then
+// center-cropped and scaled up. out receives opaque top-down BGRA rows of width * 4 bytes.
+void build_blurred_background(const canvas_image& art, int width, int height, int radius_x, int radius_y,
+    std::vector<uint8_t>& out);
+
+// Average of an 8x8 interior sample grid, for the Artwork Colors gradient
+bool average_artwork_color(const canvas_image& art, canvas_color& color);
@@ -0,0 +1,262 @@
+#include "stdafx.h"
+#include "perf_stats.h"
+#include "control_panel.h"
+#include "startup.h"
+
+#if TRAYCONTROLS_PERF_STATS
+
+std::atomic<bool> g_perf_enabled(false);
+
+// Histogram buckets are in microseconds: 0-15 us get one bucket each, above that every
+// power of two is split into 4 sub-buckets (so any reported percentile is within ~12%).
+// 128 buckets cover up to ~35 minutes, far beyond anything a paint should take.
+static const unsigned LINEAR_BUCKETS = 16;
+static const unsigned SUB_BUCKETS = 4;
+static const unsigned BUCKET_COUNT = 128;
+
+struct perf_histogram {
+    std::atomic<uint32_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total_us;
+    std::atomic<uint64_t> max_us;
+};
+
+static perf_histogram g_histograms[perf_phase_count];
+static std::atomic<uint64_t> g_counters[perf_counter_count];
+
+// Reset point and the previous report, for the paints-per-second figures (report is main thread only)
+static std::atomic<LONGLONG> g_reset_qpc(0);
+static LONGLONG g_last_report_qpc = 0;
+static uint64_t g_last_report_paints = 0;
+
+static const char* const g_phase_names[] = {
+    "composite",
+    "background",
+    "cover art",
+    "ticker layout",
+    "ticker step",
+    "load cover art",
+    "format lines",
+    "mouse hook",
+    "spectrum frame",
+    "crossfade frame"
+};
+static_assert(_countof(g_phase_names) == perf_phase_count, "one name per perf_phase");
+
+static const char* const g_counter_names[] = {
+    "paints",
+    "GDI objects created",
+    "artwork decodes",
+    "text layouts",
+    "search queries",
+    "waveform decodes",
+    "animation frames"
+};
+static_assert(_countof(g_counter_names) == perf_counter_count, "one name per perf_counter");
+
+static LONGLONG get_qpc_frequency() {
+    static LONGLONG s_frequency = 0;
+    if (s_frequency == 0) {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        s_frequency = freq.QuadPart;
+    }
+    return s_frequency;
+}
+
+static LONGLONG get_qpc_now() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+static unsigned bucket_for(uint64_t us) {
+    if (us < LINEAR_BUCKETS) return (unsigned)us;
+    unsigned exponent = 4; // 2^4 == LINEAR_BUCKETS
+    while ((us >> (exponent + 1)) != 0) exponent++;
+    unsigned sub = (unsigned)(us >> (exponent - 2)) & (SUB_BUCKETS - 1);
+    unsigned index = LINEAR_BUCKETS + (exponent - 4) * SUB_BUCKETS + sub;
+    return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+// Representative value of a bucket (midpoint of its range)
+static double bucket_value(unsigned index) {
+    if (index < LINEAR_BUCKETS) return (double)index;
+    unsigned exponent = 4 + (index - LINEAR_BUCKETS) / SUB_BUCKETS;
+    unsigned sub = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+    double lower = (double)((uint64_t)(SUB_BUCKETS + sub) << (exponent - 2));
+    double width = (double)((uint64_t)1 << (exponent - 2));
+    return lower + width * 0.5;
+}
+
+void perf_set_enabled(bool enabled) {
+    g_perf_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void perf_record(perf_phase phase, LONGLONG ticks) {
+    if (phase < 0 || phase >= perf_phase_count || ticks < 0) return;
+
+    uint64_t us = (uint64_t)(ticks * 1000000 / get_qpc_frequency());
+    perf_histogram& h = g_histograms[phase];
+    h.buckets[bucket_for(us)].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.total_us.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t prev = h.max_us.load(std::memory_order_relaxed);
+    while (us > prev && !h.max_us.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+    }
+}
+
+void perf_count(perf_counter counter, unsigned amount) {
+    if (!perf_enabled()) return;
+    if (counter < 0 || counter >= perf_counter_count) return;
+    g_counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+uint64_t perf_get_counter(perf_counter counter) {
+    if (counter < 0 || counter >= perf_counter_count) return 0;
+    return g_counters[counter].load(std::memory_order_relaxed);
+}
+
+void perf_reset() {
+    for (auto& h : g_histograms) {
+        for (auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+        h.count.store(0, std::memory_order_relaxed);
+        h.total_us.store(0, std::memory_order_relaxed);
+        h.max_us.store(0, std::memory_order_relaxed);
+    }
+    for (auto& c : g_counters) c.store(0, std::memory_order_relaxed);
+
+    LONGLONG now = get_qpc_now();
+    g_reset_qpc.store(now, std::memory_order_relaxed);
+    g_last_report_qpc = now;
+    g_last_report_paints = 0;
+}
+
+// Percentiles from a bucket snapshot; counts may be slightly torn against concurrent writers,
+// which only moves a percentile by a sample or two.
+static void compute_percentiles(const uint32_t* buckets, uint64_t total, double& p50, double& p95, double& p99) {
+    const double targets[3] = { 0.50, 0.95, 0.99 };
+    double* outputs[3] = { &p50, &p95, &p99 };
+    unsigned next = 0;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < BUCKET_COUNT && next < 3; i++) {
+        seen += buckets[i];
+        while (next < 3 && (double)seen >= targets[next] * (double)total) {
+            *outputs[next] = bucket_value(i);
+            next++;
+        }
+    }
+    while (next < 3) {
+        *outputs[next] = bucket_value(BUCKET_COUNT - 1);
+        next++;
+    }
+}
+
+pfc::string8 perf_format_report() {
+    pfc::string8 report;
+    char line[160];
+
+    LONGLONG freq = get_qpc_frequency();
+    LONGLONG now = get_qpc_now();
+    if (g_reset_qpc.load(std::memory_order_relaxed) == 0) {
+        // First report: measure rates from here on
+        g_reset_qpc.store(now, std::memory_order_relaxed);
+        g_last_report_qpc = now;
+    }
+    double since_reset = (double)(now - g_reset_qpc.load(std::memory_order_relaxed)) / (double)freq;
+
+    sprintf_s(line, "Tray Controls performance (%.1f s sampled)\r\n", since_reset);
+    report += line;
+    report += perf_enabled() ? "\r\n" : "Collection is off; figures are from while it was on.\r\n\r\n";
+    sprintf_s(line, "%-16s %8s %9s %9s %9s %9s %9s\r\n", "phase (us)", "count", "mean", "p50", "p95", "p99", "max");
+    report += line;
+
+    for (int phase = 0; phase < perf_phase_count; phase++) {
+        const perf_histogram& h = g_histograms[phase];
+        uint32_t buckets[BUCKET_COUNT];
+        for (unsigned i = 0; i < BUCKET_COUNT; i++) buckets[i] = h.buckets[i].load(std::memory_order_relaxed);
+        uint64_t count = h.count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            sprintf_s(line, "%-16s %8u %9s %9s %9s %9s %9s\r\n", g_phase_names[phase], 0u, "-", "-", "-", "-", "-");
+            report += line;
+            continue;
+        }
+
+        uint64_t bucket_total = 0;
+        for (unsigned i = 0; i < BUCKET_COUNT; i++) bucket_total += buckets[i];
+        double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+        compute_percentiles(buckets, bucket_total, p50, p95, p99);
+        double mean = (double)h.total_us.load(std::memory_order_relaxed) / (double)count;
+        sprintf_s(line, "%-16s %8llu %9.1f %9.1f %9.1f %9.1f %9llu\r\n", g_phase_names[phase],
+            (unsigned long long)count, mean, p50, p95, p99,
+            (unsigned long long)h.max_us.load(std::memory_order_relaxed));
+        report += line;
+    }
+
+    report += "\r\n";
+    for (int counter = 0; counter < perf_counter_count; counter++) {
+        sprintf_s(line, "%-22s %10llu\r\n", g_counter_names[counter],
+            (unsigned long long)g_counters[counter].load(std::memory_order_relaxed));
+        report += line;
+    }
+
+    uint64_t paints = g_counters[perf_counter_paints].load(std::memory_order_relaxed);
+    double since_last = (double)(now - g_last_report_qpc) / (double)freq;
+    double recent_rate = since_last > 0.0 ? (double)(paints - g_last_report_paints) / since_last : 0.0;
+    double average_rate = since_reset > 0.0 ? (double)paints / since_reset : 0.0;
+    sprintf_s(line, "%-22s %10.1f (since last report: %.1f)\r\n", "paints per second", average_rate, recent_rate);
+    report += line;
+    g_last_report_qpc = now;
+    g_last_report_paints = paints;
+
+    sprintf_s(line, "%-22s %10lu (USER: %lu)\r\n", "GDI handles in use",
+        GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS),
+        GetGuiResources(GetCurrentProcess(), GR_USEROBJECTS));
+    report += line;
+
+    // Measured on every show whether or not collection is on, and never reset
+    const control_panel::show_latency_stats& shows = control_panel::get_instance().get_show_latency_stats();
+    report += "\r\n";
+    sprintf_s(line, "%-16s %8s %9s %9s %9s %9s\r\n", "MiniPlayer (ms)", "shows", "last", "min", "mean", "max");
+    report += line;
+    if (shows.count == 0) {
+        sprintf_s(line, "%-16s %8u %9s %9s %9s %9s\r\n", "show latency", 0u, "-", "-", "-", "-");
+    } else {
+        sprintf_s(line, "%-16s %8u %9.2f %9.2f %9.2f %9.2f (%u pre-warmed)\r\n", "show latency",
+            shows.count, shows.last_ms, shows.min_ms, shows.total_ms / shows.count, shows.max_ms,
+            shows.prewarmed_count);
+    }
+    report += line;
+
+    const startup_phase* phases = nullptr;
+    size_t phase_count = get_startup_phases(phases);
+    double startup_total = 0.0;
+    report += "\r\n";
+    sprintf_s(line, "%-26s %10s\r\n", "startup phase", "us");
+    report += line;
+    for (size_t i = 0; i < phase_count; i++) {
+        sprintf_s(line, "%-26s %10.1f\r\n", phases[i].name, phases[i].microseconds);
+        report += line;
+        startup_total += phases[i].microseconds;
+    }
+    sprintf_s(line, "%-26s %10.1f\r\n", "total", startup_total);
+    report += line;
+
+    return report;
+}
+
+void perf_dump_to_console() {
+    pfc::string8 report = perf_format_report();
+    // The console wants one entry per line
+    const char* start = report.get_ptr();
+    while (*start) {
+        const char* end = strstr(start, "\r\n");
+        size_t length = end ? (size_t)(end - start) : strlen(start);
+        console::print(pfc::string8(start, length));
+        if (!end) break;
+        start = end + 2;
+    }
+}
+
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+// Runtime cost instrumentation: QueryPerformanceCounter scopes feeding lock-free per-phase
+// latency histograms, plus a few work counters. Read back through the hidden Diagnostics tab
+// in Preferences (hold Shift while opening the page) or the "Dump Performance Report" command.
+//
+// Compiled into every build but off until switched on at runtime ("Collect Performance
+// Statistics" in the Tray Controls menu, or the Diagnostics tab); while off a scope costs one
+// relaxed load. Define TRAYCONTROLS_PERF_STATS to 0 in the project settings to strip it out;
+// the macros below then expand to nothing and no code is generated.
+
+#include "stdafx.h"
+
+#ifndef TRAYCONTROLS_PERF_STATS
+#define TRAYCONTROLS_PERF_STATS 1
+#endif
+
+#if TRAYCONTROLS_PERF_STATS
+
+#include <atomic>
+
+enum perf_phase {
+    perf_phase_composite,       // control_panel::composite_layered_content
+    perf_phase_background,      // paint_panel_background (control panel frames)
+    perf_phase_cover_art,       // paint_panel cover art
+    perf_phase_ticker_layout,   // paint_panel title, artist and time text (measure and draw)
+    perf_phase_ticker_step,     // control_panel::update_ticker (timer tick)
+    perf_phase_load_cover_art,  // control_panel::load_cover_art
+    perf_phase_format_lines,    // format_display_lines_track
+    perf_phase_mouse_hook,      // tray_manager::low_level_mouse_proc
+    perf_phase_spectrum_frame,  // control_panel::composite_spectrum_frame
+    perf_phase_crossfade_frame, // control_panel::compose_crossfade_frame
+    perf_phase_count
+};
+
+enum perf_counter {
+    perf_counter_paints,            // layered frames pushed to the screen
+    perf_counter_gdi_objects,       // DCs, bitmaps, fonts, brushes and pens created on paint paths
+    perf_counter_artwork_decodes,   // album art images decoded into bitmaps
+    perf_counter_text_layouts,      // title/artist lines measured and ellipsized (text_layout_cache misses)
+    perf_counter_search_queries,    // jump-to-track searches run against track_search_index
+    perf_counter_waveform_decodes,  // tracks decoded for seekbar peaks (disk cache misses)
+    perf_counter_animation_frames,  // animated cover frames decoded and scaled on the worker
+    perf_counter_count
+};
+
+extern std::atomic<bool> g_perf_enabled;
+
+// Whether samples and counts are being collected. Any thread.
+inline bool perf_enabled() { return g_perf_enabled.load(std::memory_order_relaxed); }
+
+// Start or stop collecting; what was collected so far is kept. Main thread.
+// set_perf_stats_enabled() in preferences.h also saves the choice for the next session.
+void perf_set_enabled(bool enabled);
+
+// Record one sample of the given phase, in QueryPerformanceCounter ticks. Any thread.
+void perf_record(perf_phase phase, LONGLONG ticks);
+
+// Add to a work counter. Any thread.
+void perf_count(perf_counter counter, unsigned amount = 1);
+
+// Current value of a work counter
+uint64_t perf_get_counter(perf_counter counter);
+
+// Clear all histograms and counters
+void perf_reset();
+
+// Human-readable report: p50/p95/p99/max per phase, counters, paint rate, MiniPlayer show
+// latency and the startup phases.
+// Lines are separated with "\r\n" so the text can go straight into an edit control.
+pfc::string8 perf_format_report();
+
+// Print the report to the foobar2000 console
+void perf_dump_to_console();
+
+class perf_scope {
+public:
+    explicit perf_scope(perf_phase phase) : m_phase(phase), m_active(perf_enabled()) {
+        if (m_active) QueryPerformanceCounter(&m_start);
+    }
+    ~perf_scope() {
+        if (!m_active) return;
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&end);
+        perf_record(m_phase, end.QuadPart - m_start.QuadPart);
+    }
+
+private:
+    perf_phase m_phase;
+    bool m_active;
+    LARGE_INTEGER m_start;
+
+    perf_scope(const perf_scope&) = delete;
+    perf_scope& operator=(const perf_scope&) = delete;
+};
+
+#define TRAY_PERF_CONCAT_INNER(a, b) a##b
+#define TRAY_PERF_CONCAT(a, b) TRAY_PERF_CONCAT_INNER(a, b)
+#define TRAY_PERF_SCOPE(phase) perf_scope TRAY_PERF_CONCAT(perf_scope_, __LINE__)(phase)
+#define TRAY_PERF_COUNT(counter) perf_count(counter)
+#define TRAY_PERF_COUNT_N(counter, amount) perf_count(counter, (unsigned)(amount))
+
+#else
+
+#define TRAY_PERF_SCOPE(phase) ((void)0)
+#define TRAY_PERF_COUNT(counter) ((void)0)
+#define TRAY_PERF_COUNT_N(counter, amount) ((void)0)
+
+#endif
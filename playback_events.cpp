@@ -0,0 +1,167 @@
+#include "stdafx.h"
+#include "playback_events.h"
+#include "playback_ui.h"
+#include "display_lines.h"
+#include "stream_metadata.h"
+#include "track_notification.h"
+#include "main_thread_timer.h"
+#include "tracing.h"
+
+// Metadb callback to update control panel, popup window, and tray tooltip when stream metadata or display fields change.
+// Library rescans and mass tag edits deliver hundreds of batches per second, so notifications only mark the
+// now-playing track dirty; a single refresh runs on the next frame, and only if its displayed tags changed.
+class tray_metadb_callback : public metadb_io_callback_dynamic_impl_base {
+public:
+    ~tray_metadb_callback() {
+        stop_main_thread_timer(m_refresh_timer);
+    }
+
+    void on_changed_sorted(metadb_handle_list_cref p_items_sorted, bool p_fromhook) override {
+        TRAY_TRACE_SCOPE("metadb", "on_changed_sorted");
+        m_notifications++;
+
+        // Search keys of indexed tracks follow tag edits, playing or not
+        playback_ui_tracks_changed(p_items_sorted);
+
+        auto playback = playback_control::get();
+        if (!playback->is_playing() && !playback->is_paused()) return;
+
+        metadb_handle_ptr track;
+        if (playback->get_now_playing(track) && track.is_valid()) {
+            if (metadb_handle_list_helper::bsearch_by_pointer(p_items_sorted, track) != pfc_infinite) {
+                m_dirty = true;
+                if (!m_refresh_timer) {
+                    m_refresh_timer = start_main_thread_timer(0, REFRESH_DELAY_MS, refresh_timer_proc);
+                    if (!m_refresh_timer) refresh_now_playing(); // No timer available - refresh synchronously
+                }
+            }
+        }
+    }
+
+private:
+    static const unsigned REFRESH_DELAY_MS = 16; // One frame
+
+    static void refresh_timer_proc();
+
+    void refresh_now_playing() {
+        stop_main_thread_timer(m_refresh_timer);
+        m_refresh_timer = 0;
+        if (!m_dirty) return;
+        m_dirty = false;
+        TRAY_TRACE_SCOPE("metadb", "refresh_now_playing");
+
+        try {
+            auto playback = playback_control::get();
+            if (!playback->is_playing() && !playback->is_paused()) return;
+
+            metadb_handle_ptr track;
+            if (!playback->get_now_playing(track) || !track.is_valid()) return;
+
+            // Hash what the windows actually display; rating/playcount-only edits leave it unchanged
+            pfc::string8 line1, line2;
+            format_display_lines_track(track, line1, line2);
+            t_uint64 hash = hash_display_lines(line1, line2);
+            if (track == m_last_track && hash == m_last_hash) {
+                m_skipped_unchanged++;
+                log_stats();
+                return;
+            }
+            m_last_track = track;
+            m_last_hash = hash;
+            m_refreshes++;
+            log_stats();
+
+            playback_ui_now_playing_changed(track);
+        } catch (...) {}
+    }
+
+    // FNV-1a over both lines with a separator so ("ab","c") and ("a","bc") differ
+    static t_uint64 hash_display_lines(const pfc::string8& line1, const pfc::string8& line2) {
+        t_uint64 hash = 14695981039346656037ULL;
+        auto mix = [&hash](const char* p, t_size len) {
+            for (t_size i = 0; i < len; i++) {
+                hash ^= (unsigned char)p[i];
+                hash *= 1099511628211ULL;
+            }
+        };
+        mix(line1.get_ptr(), line1.length());
+        mix("\x1f", 1);
+        mix(line2.get_ptr(), line2.length());
+        return hash;
+    }
+
+    void log_stats() {
+#ifdef _DEBUG
+        char msg[128];
+        sprintf_s(msg, "metadb refresh: notifications=%lu refreshes=%lu skipped_unchanged=%lu\n",
+            m_notifications, m_refreshes, m_skipped_unchanged);
+        OutputDebugStringA(msg);
+#endif
+    }
+
+    bool m_dirty = false;
+    main_thread_timer_id m_refresh_timer = 0;
+    metadb_handle_ptr m_last_track;
+    t_uint64 m_last_hash = 0;
+
+    // Notifications received vs. refreshes actually performed
+    unsigned long m_notifications = 0;
+    unsigned long m_refreshes = 0;
+    unsigned long m_skipped_unchanged = 0;
+};
+
+static std::unique_ptr<tray_metadb_callback> g_metadb_callback;
+
+void tray_metadb_callback::refresh_timer_proc() {
+    if (g_metadb_callback) {
+        g_metadb_callback->m_refresh_timer = 0;
+        g_metadb_callback->refresh_now_playing();
+    }
+}
+
+void start_metadb_notifications() {
+    if (!g_metadb_callback) {
+        g_metadb_callback = std::make_unique<tray_metadb_callback>();
+    }
+}
+
+void stop_metadb_notifications() {
+    g_metadb_callback.reset();
+}
+
+void handle_playback_new_track(metadb_handle_ptr p_track) {
+    TRAY_TRACE_SCOPE("playback", "on_playback_new_track");
+    reset_stream_metadata();
+    // Tooltip, control panel and popup follow once the track settles (track_notification.cpp)
+    on_new_track_notification(p_track);
+}
+
+void handle_playback_pause(bool p_state) {
+    TRAY_TRACE_SCOPE("playback", "on_playback_pause");
+    // Tray tooltip and control panel show the pause state
+    playback_ui_state(p_state ? "Paused" : "Playing");
+}
+
+void handle_playback_stop(play_control::t_stop_reason p_reason) {
+    if (p_reason == play_control::stop_reason_starting_another) {
+        return;
+    }
+    TRAY_TRACE_SCOPE("playback", "on_playback_stop");
+    reset_stream_metadata();
+    reset_track_notification();
+    // Tray tooltip and control panel show the stopped state
+    playback_ui_state("Stopped");
+    playback_ui_hide_popup();
+}
+
+void handle_playback_edited(metadb_handle_ptr p_track) {
+    TRAY_TRACE_SCOPE("playback", "on_playback_edited");
+    // Tooltip and control panel follow tag edits
+    playback_ui_track_edited(p_track);
+}
+
+void handle_metadb_changed(metadb_handle_list_cref p_items_sorted) {
+    if (g_metadb_callback) {
+        g_metadb_callback->on_changed_sorted(p_items_sorted, false);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Playback and metadb notifications, routed to the windows through playback_ui.h.
+// tray_play_callback (main.cpp) and the metadb callback call these; so do the in-process event
+// replay (event_replay.cpp) and the Linux replay harness (replay/), which feed them recorded
+// events. Main thread only.
+
+#include "stdafx.h"
+
+void handle_playback_new_track(metadb_handle_ptr p_track);
+void handle_playback_pause(bool p_state);
+void handle_playback_stop(play_control::t_stop_reason p_reason);
+void handle_playback_edited(metadb_handle_ptr p_track);
+
+// Delivered to the metadb callback as if the core had sent it; ignored while it is not registered
+void handle_metadb_changed(metadb_handle_list_cref p_items_sorted);
+
+// Register and drop the metadb callback. Storms of notifications only mark the playing track
+// dirty; one refresh follows on the next frame, and only if its display lines changed.
+void start_metadb_notifications();
+void stop_metadb_notifications();
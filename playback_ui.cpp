@@ -0,0 +1,57 @@
+#include "stdafx.h"
+#include "playback_ui.h"
+#include "stream_metadata.h"
+#include "tray_manager.h"
+#include "control_panel.h"
+#include "popup_window.h"
+#include "artwork_bridge.h"
+
+void playback_ui_new_track(metadb_handle_ptr track) {
+    // Update tray tooltip with new track information
+    tray_manager::get_instance().update_tooltip(track);
+    // Update control panel with new track information
+    control_panel::get_instance().update_track_info(track);
+    control_panel::get_instance().get_up_next_view().on_playing_track_changed();
+    // Show popup notification for new tracks
+    popup_window::get_instance().show_track_info(track);
+}
+
+void playback_ui_cancel_artwork() {
+    clear_pending_online_artwork();
+    popup_window::get_instance().cancel_artwork_wait();
+}
+
+void playback_ui_state(const char* state) {
+    tray_manager::get_instance().update_playback_state(state);
+    control_panel::get_instance().update_track_info();
+}
+
+void playback_ui_hide_popup() {
+    popup_window::get_instance().hide_popup();
+}
+
+void playback_ui_track_edited(metadb_handle_ptr track) {
+    tray_manager::get_instance().update_tooltip(track);
+    control_panel::get_instance().update_track_info(track);
+}
+
+void playback_ui_now_playing_changed(metadb_handle_ptr track) {
+    control_panel::get_instance().update_track_info(track);
+    popup_window::get_instance().update_track_info(track);
+    tray_manager::get_instance().update_tooltip(track);
+}
+
+void playback_ui_tracks_changed(metadb_handle_list_cref items) {
+    control_panel::get_instance().get_up_next_view().on_tracks_changed(items);
+}
+
+void playback_ui_stream_metadata(stream_metadata& meta) {
+    // One online search per distinct update; the bridge applies rate limiting and the negative cache
+    if (is_artwork_bridge_available() && !meta.bypass_artwork) {
+        meta.artwork_requested = request_online_artwork(meta.artist.c_str(), meta.title.c_str());
+    }
+
+    tray_manager::get_instance().update_tooltip_with_dynamic_info(meta);
+    control_panel::get_instance().update_stream_metadata(meta);
+    popup_window::get_instance().update_stream_metadata(meta);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// What the playback handlers (playback_events.h, stream_metadata.h, track_notification.h) tell
+// the tray icon, control panel and popup. playback_ui.cpp forwards to the windows; the Linux
+// event replay harness (replay/) links stand-ins that count the calls instead, so the handlers
+// and their coalescing run there unchanged. Main thread only.
+
+#include "stdafx.h"
+
+struct stream_metadata;
+
+// A new track has settled: tooltip, control panel, Up Next and popup
+void playback_ui_new_track(metadb_handle_ptr track);
+
+// A newer track arrived; artwork the previous one was still waiting for can no longer be shown
+void playback_ui_cancel_artwork();
+
+// Play state shown by the tray and the control panel: "Playing", "Paused" or "Stopped"
+void playback_ui_state(const char* state);
+
+// Playback stopped: the popup goes away
+void playback_ui_hide_popup();
+
+// Tags of the playing track were edited: tooltip and control panel
+void playback_ui_track_edited(metadb_handle_ptr track);
+
+// The displayed lines of the playing track changed: control panel, popup and tooltip
+void playback_ui_now_playing_changed(metadb_handle_ptr track);
+
+// Tracks were changed in the library (sorted by pointer): Up Next search keys
+void playback_ui_tracks_changed(metadb_handle_list_cref items);
+
+// New artist/title on a stream: online artwork is requested (setting meta.artwork_requested)
+// and the windows updated
+void playback_ui_stream_metadata(stream_metadata& meta);
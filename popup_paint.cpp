@@ -0,0 +1,83 @@
+// popup_paint.cpp - Portable track change popup painting (no precompiled header, no Windows dependency)
+
+#include "popup_paint.h"
+#include <algorithm>
+
+static canvas_rect make_rect(int x, int y, int w, int h) {
+    canvas_rect r = { (float)x, (float)y, (float)w, (float)h };
+    return r;
+}
+
+static void paint_popup_background(canvas& c, const popup_paint_state& s) {
+    const int w = s.width;
+    const int h = s.height;
+    if (s.background_style == 1 && s.has_artwork_color) {
+        const canvas_color primary = s.artwork_color;
+        const canvas_color secondary = canvas_color::rgb(primary.r * 65 / 100, primary.g * 65 / 100, primary.b * 65 / 100);
+        c.fill_linear_gradient(make_rect(0, 0, w, h), 0.0f, secondary, primary);
+        c.fill_rect(0.0f, 0.0f, (float)w, (float)h, canvas_color::argb(50, 0, 0, 0));
+        return;
+    }
+    if (s.background_style == 2 && !s.blurred_background.empty()) {
+        canvas_rect full = make_rect(0, 0, w, h);
+        c.draw_image(s.blurred_background, full, full, 0.0f);
+        c.fill_rect(0.0f, 0.0f, (float)w, (float)h, canvas_color::argb(140, 0, 0, 0));
+        return;
+    }
+    c.fill_rect(0.0f, 0.0f, (float)w, (float)h, s.dark ? canvas_color::rgb(45, 45, 48) : canvas_color::rgb(245, 245, 245));
+}
+
+static void paint_popup_cover(canvas& c, const popup_paint_state& s) {
+    const int size = s.cover_margin ? 60 : s.height;
+    const int xy = s.cover_margin ? 10 : 0;
+    if (size <= 0) return;
+    const canvas_color placeholder = s.dark ? canvas_color::rgb(80, 80, 80) : canvas_color::rgb(220, 220, 220);
+    canvas_rect dest = make_rect(xy, xy, size, size);
+
+    if (s.rounded_cover) {
+        float radius = (std::min)((std::max)(size * 0.10f, 4.0f), 12.0f);
+        if (s.cover.empty()) {
+            c.fill_rounded_rect(dest.x, dest.y, dest.w, dest.h, radius, placeholder);
+            return;
+        }
+        // Center crop to the square
+        canvas_rect source = make_rect(0, 0, s.cover.width, s.cover.height);
+        if (source.w > source.h) {
+            source.x = (source.w - source.h) / 2.0f;
+            source.w = source.h;
+        } else {
+            source.y = (source.h - source.w) / 2.0f;
+            source.h = source.w;
+        }
+        c.draw_image(s.cover, dest, source, radius);
+    } else if (!s.cover.empty()) {
+        c.draw_image(s.cover, dest, make_rect(0, 0, s.cover.width, s.cover.height), 0.0f);
+    } else {
+        c.fill_rect(dest.x, dest.y, dest.w, dest.h, placeholder);
+    }
+}
+
+void paint_popup(canvas& c, const popup_paint_state& s) {
+    const int w = s.width;
+    const int h = s.height;
+    if (w <= 0 || h <= 0) return;
+
+    paint_popup_background(c, s);
+    c.stroke_rounded_rect(0.5f, 0.5f, (float)w - 1.0f, (float)h - 1.0f, 0.0f, 1.0f,
+        s.dark ? canvas_color::rgb(100, 100, 100) : canvas_color::rgb(200, 200, 200));
+
+    if (s.show_cover_art) paint_popup_cover(c, s);
+
+    // Dark text only on the light solid background
+    bool light = s.background_style == 0 && !s.dark;
+    canvas_color title_color = light ? canvas_color::rgb(20, 20, 20) : canvas_color::rgb(255, 255, 255);
+    canvas_color artist_color = light ? canvas_color::rgb(80, 80, 80) : canvas_color::rgb(220, 220, 220);
+    int text_left = 15;
+    if (s.show_cover_art) text_left = s.cover_margin ? 85 : h + 10;
+    int text_width = w - 10 - text_left;
+
+    const wchar_t* title = s.title && *s.title ? s.title : L"Unknown Title";
+    const wchar_t* artist = s.artist && *s.artist ? s.artist : L"Unknown Artist";
+    c.draw_text(s.title_font, title, make_rect(text_left, 15, text_width, 20), canvas_align_near, title_color, canvas_text_end_ellipsis);
+    c.draw_text(s.artist_font, artist, make_rect(text_left, 40, text_width, 20), canvas_align_near, artist_color, canvas_text_end_ellipsis);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Track change popup drawing, written against canvas like the control panel's modes.
+// popup_window paints it with a gdiplus_canvas; the bench and tests use a software_canvas.
+// No Windows dependency.
+
+#include "canvas.h"
+
+struct popup_paint_state {
+    int width;
+    int height;
+    bool dark;                      // Artwork backgrounds are always dark
+    int background_style;           // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
+    bool has_artwork_color;
+    canvas_color artwork_color;
+    canvas_image blurred_background;    // Window sized, from build_blurred_background
+    bool show_cover_art;
+    bool cover_margin;
+    bool rounded_cover;
+    canvas_image cover;
+    const wchar_t* title;           // Empty shows "Unknown Title"
+    const wchar_t* artist;          // Empty shows "Unknown Artist"
+    canvas_font title_font;
+    canvas_font artist_font;
+};
+
+void paint_popup(canvas& c, const popup_paint_state& state);
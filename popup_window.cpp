@@ -2,7 +2,14 @@
 #include "popup_window.h"
 #include "preferences.h"
 #include "artwork_bridge.h"
+#include "startup.h"
 #include "control_panel.h"
+#include "gdiplus_canvas.h"
+#include "panel_paint.h"
+#include "popup_paint.h"
+#include "stream_metadata.h"
+#include "perf_stats.h"
+#include "tracing.h"
 #include <dwmapi.h>
 #pragma comment(lib, "dwmapi.lib")
 
@@ -42,7 +49,9 @@ popup_window::popup_window()
     , m_artwork_from_bridge(false)
     , m_is_stream(false)
     , m_pending_track(nullptr)
-    , m_artwork_wait_count(0) {
+    , m_artwork_wait_count(0)
+    , m_title_font(nullptr)
+    , m_artist_font(nullptr) {
 }
 
 popup_window::~popup_window() {
@@ -59,6 +68,8 @@ popup_window& popup_window::get_instance() {
 void popup_window::initialize() {
     if (m_initialized) return;
     
+    // Painting uses GDI+
+    ensure_gdiplus();
     create_popup_window();
     m_initialized = true;
 }
@@ -79,6 +90,7 @@ void popup_window::cleanup() {
     m_pending_track = nullptr;
     m_artwork_wait_count = 0;
     cleanup_cover_art();
+    cleanup_fonts();
     
     if (m_popup_window) {
         DestroyWindow(m_popup_window);
@@ -143,7 +155,7 @@ void popup_window::show_track_info(metadb_handle_ptr p_track) {
     if (!m_popup_window) {
         create_popup_window();
     }
-    if (!m_initialized || !m_popup_window || !get_show_popup_notification() || !p_track.is_valid()) {
+    if (!m_initialized || !m_popup_window || !get_settings().show_popup_notification || !p_track.is_valid()) {
         return;
     }
     
@@ -190,12 +202,20 @@ void popup_window::show_track_info(metadb_handle_ptr p_track) {
         SetWindowPos(m_popup_window, HWND_TOPMOST, m_final_x, m_final_y, 320, 80, SWP_NOACTIVATE);
         ShowWindow(m_popup_window, SW_SHOWNOACTIVATE);
         InvalidateRect(m_popup_window, nullptr, TRUE);
-        SetTimer(m_popup_window, POPUP_TIMER_ID, get_popup_duration(), hide_timer_proc);
+        SetTimer(m_popup_window, POPUP_TIMER_ID, get_settings().popup_duration, hide_timer_proc);
     } else {
         start_slide_in_animation();
     }
 }
 
+void popup_window::cancel_artwork_wait() {
+    if (m_popup_window) {
+        KillTimer(m_popup_window, ARTWORK_WAIT_TIMER_ID);
+    }
+    m_pending_track = nullptr;
+    m_artwork_wait_count = 0;
+}
+
 static HBITMAP copy_hbitmap_surface(HBITMAP src_bmp) {
     if (!src_bmp) return nullptr;
     BITMAP bmp;
@@ -249,7 +269,7 @@ void popup_window::show_preview() {
             if (m_visible && !m_animating) {
                 SetWindowPos(m_popup_window, HWND_TOPMOST, m_final_x, m_final_y, 320, 80, SWP_NOACTIVATE);
                 InvalidateRect(m_popup_window, nullptr, TRUE);
-                SetTimer(m_popup_window, POPUP_TIMER_ID, get_popup_duration(), hide_timer_proc);
+                SetTimer(m_popup_window, POPUP_TIMER_ID, get_settings().popup_duration, hide_timer_proc);
             } else if (!m_visible) {
                 start_slide_in_animation();
             }
@@ -266,14 +286,14 @@ void popup_window::show_preview() {
     if (m_visible && !m_animating) {
         SetWindowPos(m_popup_window, HWND_TOPMOST, m_final_x, m_final_y, 320, 80, SWP_NOACTIVATE);
         InvalidateRect(m_popup_window, nullptr, TRUE);
-        SetTimer(m_popup_window, POPUP_TIMER_ID, get_popup_duration(), hide_timer_proc);
+        SetTimer(m_popup_window, POPUP_TIMER_ID, get_settings().popup_duration, hide_timer_proc);
     } else if (!m_visible) {
         start_slide_in_animation();
     }
 }
 
 void popup_window::on_artwork_wait_timer() {
-    if (!m_initialized || !get_show_popup_notification() || !m_pending_track.is_valid()) {
+    if (!m_initialized || !get_settings().show_popup_notification || !m_pending_track.is_valid()) {
         if (m_popup_window) KillTimer(m_popup_window, ARTWORK_WAIT_TIMER_ID);
         return;
     }
@@ -282,11 +302,9 @@ void popup_window::on_artwork_wait_timer() {
     
     // Check if artwork has arrived via foo_artwork callback
     if (has_pending_online_artwork_popup()) {
-        HBITMAP bitmap = get_pending_online_artwork_popup();
-        if (bitmap) {
-            cleanup_cover_art();
-            m_cover_art_bitmap = bitmap;
-            m_artwork_from_bridge = false;
+        bridge_artwork_ptr art = get_pending_online_artwork_popup();
+        if (art) {
+            set_bridge_artwork(art);
         }
     }
     
@@ -312,7 +330,7 @@ void popup_window::on_artwork_wait_timer() {
         if (m_visible && !m_animating) {
             SetWindowPos(m_popup_window, HWND_TOPMOST, m_final_x, m_final_y, 320, 80, SWP_NOACTIVATE);
             InvalidateRect(m_popup_window, nullptr, TRUE);
-            SetTimer(m_popup_window, POPUP_TIMER_ID, get_popup_duration(), hide_timer_proc);
+            SetTimer(m_popup_window, POPUP_TIMER_ID, get_settings().popup_duration, hide_timer_proc);
         } else if (!m_visible) {
             start_slide_in_animation();
         }
@@ -334,7 +352,7 @@ void popup_window::refresh_track_info() {
 }
 
 void popup_window::on_settings_changed() {
-    if (!get_show_popup_notification()) {
+    if (!get_settings().show_popup_notification) {
         if (m_popup_window) {
             KillTimer(m_popup_window, ARTWORK_WAIT_TIMER_ID);
         }
@@ -343,9 +361,12 @@ void popup_window::on_settings_changed() {
         }
     }
     
+    // Fonts follow the Docked Control Panel font settings; recreate them on next paint
+    cleanup_fonts();
+    
     // Update window corner preference
     if (m_popup_window) {
-        DWORD corner_pref = get_use_rounded_corners() ? 2 : 1;
+        DWORD corner_pref = get_settings().use_rounded_corners ? 2 : 1;
         DwmSetWindowAttribute(m_popup_window, 33, &corner_pref, sizeof(corner_pref));
     }
     
@@ -396,7 +417,7 @@ void popup_window::create_popup_window() {
     
     // Apply window corner preference (rounded/square corners)
     // DWMWA_WINDOW_CORNER_PREFERENCE = 33
-    DWORD corner_pref = get_use_rounded_corners() ? 2 : 1;
+    DWORD corner_pref = get_settings().use_rounded_corners ? 2 : 1;
     DwmSetWindowAttribute(m_popup_window, 33, &corner_pref, sizeof(corner_pref));
 }
 
@@ -415,7 +436,7 @@ void popup_window::position_popup() {
     const int popup_height = 80;
     const int margin = 10;
     
-    int popup_position = get_popup_position();
+    int popup_position = get_settings().popup_position;
     if (popup_position < 0 || popup_position > 5) popup_position = 0;
     bool is_right_side = (popup_position >= 3);
 
@@ -531,7 +552,7 @@ void popup_window::update_track_info(metadb_handle_ptr p_track) {
                 // Load cover art for the stream track
                 load_cover_art(p_track, false);
 
-                if (get_show_popup_notification()) {
+                if (get_settings().show_popup_notification) {
                     if (m_popup_window) {
                         KillTimer(m_popup_window, ARTWORK_WAIT_TIMER_ID);
                         KillTimer(m_popup_window, ANIMATION_TIMER_ID);
@@ -545,7 +566,7 @@ void popup_window::update_track_info(metadb_handle_ptr p_track) {
                         SetWindowPos(m_popup_window, HWND_TOPMOST, m_final_x, m_final_y, 320, 80, SWP_NOACTIVATE);
                         ShowWindow(m_popup_window, SW_SHOWNOACTIVATE);
                         InvalidateRect(m_popup_window, nullptr, TRUE);
-                        SetTimer(m_popup_window, POPUP_TIMER_ID, get_popup_duration(), hide_timer_proc);
+                        SetTimer(m_popup_window, POPUP_TIMER_ID, get_settings().popup_duration, hide_timer_proc);
                     } else {
                         start_slide_in_animation();
                     }
@@ -563,109 +584,12 @@ void popup_window::update_track_info(metadb_handle_ptr p_track) {
     }
 }
 
-static bool is_inverted_stream_popup(const file_info& info, metadb_handle_ptr track = nullptr) {
-    try {
-        if (track.is_valid()) {
-            pfc::string8 path = track->get_path();
-            if (!path.is_empty()) {
-                std::string path_str = path.c_str();
-                std::transform(path_str.begin(), path_str.end(), path_str.begin(), ::tolower);
-                if (path_str.find("?inverted") != std::string::npos ||
-                    path_str.find("&inverted") != std::string::npos ||
-                    path_str.find("#inverted") != std::string::npos) {
-                    return true;
-                }
-            }
-        }
-        
-        t_size index = info.meta_find("STREAM_INVERTED");
-        if (index != pfc_infinite && info.meta_enum_value_count(index) > 0) {
-            const char* val = info.meta_enum_value(index, 0);
-            if (val && strcmp(val, "1") == 0) return true;
-        }
-    } catch (...) {}
-    return false;
-}
-
-void popup_window::update_stream_metadata(const file_info & p_info) {
-    if (!m_initialized || !get_show_popup_notification()) return;
+void popup_window::update_stream_metadata(const stream_metadata& meta) {
+    if (!m_initialized || !get_settings().show_popup_notification) return;
 
     try {
-        metadb_handle_ptr track = m_pending_track.is_valid() ? m_pending_track : m_current_track;
-        if (!track.is_valid()) {
-            auto playback = playback_control::get();
-            if (!playback->get_now_playing(track) || !track.is_valid()) {
-                return;
-            }
-        }
-        pfc::string8 path = track->get_path();
-        if (!is_remote_stream_path(path.get_ptr())) {
-            return;
-        }
-
-        pfc::string8 artist, title;
-
-        const char* p_artist = safe_meta_get_popup(p_info, "ARTIST");
-        const char* p_title = safe_meta_get_popup(p_info, "TITLE");
-
-        const char* stream_title = safe_meta_get_popup(p_info, "STREAMTITLE");
-        if (!stream_title) {
-            stream_title = safe_meta_get_popup(p_info, "ICY_TITLE");
-        }
-
-        if (stream_title) {
-            const char* dash = strstr(stream_title, " - ");
-            if (dash) {
-                if (!p_artist) {
-                    artist.set_string(stream_title, dash - stream_title);
-                }
-                if (!p_title) {
-                    title.set_string(dash + 3);
-                }
-            } else if (!p_title) {
-                title = stream_title;
-            }
-        }
-
-        if (p_artist && artist.is_empty()) artist = p_artist;
-        if (p_title && title.is_empty()) title = p_title;
-
-        if (artist.is_empty() && !title.is_empty()) {
-            pfc::string8 temp = title;
-            const char* dash = strstr(temp.get_ptr(), " - ");
-            if (dash) {
-                artist.set_string(temp.get_ptr(), dash - temp.get_ptr());
-                title = dash + 3;
-            }
-        }
-
-        if (artist.is_empty()) {
-            const char* val = safe_meta_get_popup(p_info, "ALBUMARTIST");
-            if (val) artist = val;
-        }
-        if (artist.is_empty()) {
-            const char* val = safe_meta_get_popup(p_info, "PERFORMER");
-            if (val) artist = val;
-        }
-        if (title.is_empty()) {
-            const char* val = safe_meta_get_popup(p_info, "DESCRIPTION");
-            if (val) title = val;
-        }
-        if (title.is_empty()) {
-            const char* val = safe_meta_get_popup(p_info, "COMMENT");
-            if (val) title = val;
-        }
-
-        if (title.is_empty() && artist.is_empty()) return;
-
-        artist.trim(' ');
-        title.trim(' ');
-
-        if (is_inverted_stream_popup(p_info, m_pending_track.is_valid() ? m_pending_track : m_current_track)) {
-            pfc::string8 temp = artist;
-            artist = title;
-            title = temp;
-        }
+        const pfc::string8& artist = meta.artist;
+        const pfc::string8& title = meta.title;
 
         pfc::string8 stream_id;
         stream_id << artist << " - " << title;
@@ -690,7 +614,7 @@ void popup_window::update_stream_metadata(const file_info & p_info) {
             SetWindowPos(m_popup_window, HWND_TOPMOST, m_final_x, m_final_y, 320, 80, SWP_NOACTIVATE);
             ShowWindow(m_popup_window, SW_SHOWNOACTIVATE);
             InvalidateRect(m_popup_window, nullptr, TRUE);
-            SetTimer(m_popup_window, POPUP_TIMER_ID, get_popup_duration(), hide_timer_proc);
+            SetTimer(m_popup_window, POPUP_TIMER_ID, get_settings().popup_duration, hide_timer_proc);
         } else {
             start_slide_in_animation();
         }
@@ -698,12 +622,11 @@ void popup_window::update_stream_metadata(const file_info & p_info) {
 }
 
 void popup_window::on_online_artwork_received() {
+    TRAY_TRACE_SCOPE("artwork", "popup artwork received");
     if (has_pending_online_artwork_popup()) {
-        HBITMAP bitmap = get_pending_online_artwork_popup();
-        if (bitmap) {
-            cleanup_cover_art();
-            m_cover_art_bitmap = bitmap;
-            m_artwork_from_bridge = false; // We own the copy
+        bridge_artwork_ptr art = get_pending_online_artwork_popup();
+        if (art) {
+            set_bridge_artwork(art);
 
             // Refresh track title and artist if stream metadata was discovered
             auto playback = playback_control::get();
@@ -730,7 +653,7 @@ void popup_window::on_online_artwork_received() {
 
                     if (has_valid_title && stream_id != m_last_track_path) {
                         m_last_track_path = stream_id;
-                        if (get_show_popup_notification()) {
+                        if (get_settings().show_popup_notification) {
                             if (m_popup_window) {
                                 KillTimer(m_popup_window, ARTWORK_WAIT_TIMER_ID);
                                 KillTimer(m_popup_window, ANIMATION_TIMER_ID);
@@ -744,7 +667,7 @@ void popup_window::on_online_artwork_received() {
                                 SetWindowPos(m_popup_window, HWND_TOPMOST, m_final_x, m_final_y, 320, 80, SWP_NOACTIVATE);
                                 ShowWindow(m_popup_window, SW_SHOWNOACTIVATE);
                                 InvalidateRect(m_popup_window, nullptr, TRUE);
-                                SetTimer(m_popup_window, POPUP_TIMER_ID, get_popup_duration(), hide_timer_proc);
+                                SetTimer(m_popup_window, POPUP_TIMER_ID, get_settings().popup_duration, hide_timer_proc);
                             } else {
                                 start_slide_in_animation();
                             }
@@ -771,11 +694,9 @@ void popup_window::load_cover_art(metadb_handle_ptr p_track, bool allow_stale_fa
 
     // Check if artwork has arrived via callback from foo_artwork for this search
     if (has_pending_online_artwork_popup()) {
-        HBITMAP bitmap = get_pending_online_artwork_popup();
-        if (bitmap) {
-            cleanup_cover_art();
-            m_cover_art_bitmap = bitmap;
-            m_artwork_from_bridge = false;
+        bridge_artwork_ptr art = get_pending_online_artwork_popup();
+        if (art) {
+            set_bridge_artwork(art);
             if (m_popup_window) KillTimer(m_popup_window, ARTWORK_POLL_TIMER_ID);
             return;
         }
@@ -788,11 +709,9 @@ void popup_window::load_cover_art(metadb_handle_ptr p_track, bool allow_stale_fa
         if (is_stream) {
             // Check if foo_artwork already has active artwork ready
             try {
-                HBITMAP online_art = get_current_online_artwork();
+                bridge_artwork_ptr online_art = get_current_online_artwork();
                 if (online_art) {
-                    cleanup_cover_art();
-                    m_cover_art_bitmap = online_art;
-                    m_artwork_from_bridge = false;
+                    set_bridge_artwork(online_art);
                     if (m_popup_window) KillTimer(m_popup_window, ARTWORK_POLL_TIMER_ID);
                     return;
                 }
@@ -844,19 +763,22 @@ void popup_window::load_cover_art(metadb_handle_ptr p_track, bool allow_stale_fa
         if (allow_stale_fallback) {
             // Fallback 1: Check foo_artwork active or last received online artwork
             try {
-                HBITMAP online_art = get_current_online_artwork();
+                bridge_artwork_ptr online_art = get_current_online_artwork();
                 if (!online_art) {
                     online_art = get_last_online_artwork();
                 }
                 if (online_art) {
-                    cleanup_cover_art();
-                    m_cover_art_bitmap = online_art;
-                    m_artwork_from_bridge = false;
+                    set_bridge_artwork(online_art);
                     return;
                 }
             } catch (...) {}
 
-            // Fallback 2: Check Control Panel active artwork bitmap
+            // Fallback 2: Check Control Panel active artwork - share it when it came from the bridge
+            bridge_artwork_ptr cp_shared = control_panel::get_instance().get_bridge_artwork();
+            if (cp_shared) {
+                set_bridge_artwork(cp_shared);
+                return;
+            }
             HBITMAP cp_art = control_panel::get_instance().get_cover_art_bitmap();
             if (cp_art) {
                 cleanup_cover_art();
@@ -881,6 +803,15 @@ void popup_window::cleanup_cover_art() {
         m_cover_art_bitmap = nullptr;
     }
     m_artwork_from_bridge = false;
+    m_bridge_artwork.reset();
+}
+
+void popup_window::set_bridge_artwork(const bridge_artwork_ptr& art) {
+    cleanup_cover_art();
+    if (!art) return;
+    m_bridge_artwork = art;
+    m_cover_art_bitmap = art->bitmap();
+    m_artwork_from_bridge = true;
 }
 
 HBITMAP popup_window::convert_album_art_to_bitmap(album_art_data_ptr art_data) {
@@ -890,18 +821,11 @@ HBITMAP popup_window::convert_album_art_to_bitmap(album_art_data_ptr art_data) {
     
     HBITMAP result = nullptr;
     
-    // Initialize GDI+ if not already done
-    static ULONG_PTR gdiplusToken = 0;
-    static bool gdiplus_initialized = false;
-    
-    if (!gdiplus_initialized) {
-        Gdiplus::GdiplusStartupInput gdiplusStartupInput;
-        if (Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr) == Gdiplus::Ok) {
-            gdiplus_initialized = true;
-        } else {
-            return nullptr;
-        }
+    // GDI+ is started once for the whole component, on first use
+    if (!ensure_gdiplus()) {
+        return nullptr;
     }
+    TRAY_PERF_COUNT(perf_counter_artwork_decodes);
     
     try {
         // Create IStream from memory buffer
@@ -964,6 +888,7 @@ HBITMAP popup_window::convert_album_art_to_bitmap(album_art_data_ptr art_data) {
         result = nullptr;
     }
     
+    if (result) TRAY_PERF_COUNT(perf_counter_gdi_objects);
     return result;
 }
 
@@ -982,6 +907,7 @@ LRESULT CALLBACK popup_window::popup_window_proc(HWND hwnd, UINT msg, WPARAM wpa
         switch (msg) {
         case WM_PAINT:
             {
+                TRAY_TRACE_SCOPE("paint", "popup WM_PAINT");
                 PAINTSTRUCT ps;
                 HDC hdc = BeginPaint(hwnd, &ps);
                 RECT client_rect;
@@ -1015,6 +941,7 @@ LRESULT CALLBACK popup_window::popup_window_proc(HWND hwnd, UINT msg, WPARAM wpa
             return 0;
             
         case WM_TIMER:
+            TRAY_TRACE_INSTANT("timer", "popup WM_TIMER");
             if (wparam == POPUP_TIMER_ID) {
                 popup->hide_popup();
                 return 0;
@@ -1024,11 +951,9 @@ LRESULT CALLBACK popup_window::popup_window_proc(HWND hwnd, UINT msg, WPARAM wpa
             } else if (wparam == ARTWORK_POLL_TIMER_ID) {
                 // Poll foo_artwork for completed artwork search
                 if (popup && has_pending_online_artwork_popup()) {
-                    HBITMAP bitmap = get_pending_online_artwork_popup();
-                    if (bitmap) {
-                        popup->cleanup_cover_art();
-                        popup->m_cover_art_bitmap = bitmap;
-                        popup->m_artwork_from_bridge = false; // We own the copy
+                    bridge_artwork_ptr art = get_pending_online_artwork_popup();
+                    if (art) {
+                        popup->set_bridge_artwork(art);
                         KillTimer(hwnd, ARTWORK_POLL_TIMER_ID);
                         InvalidateRect(hwnd, nullptr, FALSE);
                     }
@@ -1058,40 +983,14 @@ VOID CALLBACK popup_window::animation_timer_proc(HWND hwnd, UINT msg, UINT_PTR t
     }
 }
 
-static std::unique_ptr<Gdiplus::Bitmap> create_gdiplus_bitmap_from_hbitmap(HDC hdc, HBITMAP hbmp) {
-    if (!hbmp || !hdc) return nullptr;
-
-    BITMAP bmp;
-    if (!GetObject(hbmp, sizeof(bmp), &bmp) || bmp.bmWidth <= 0 || bmp.bmHeight <= 0) return nullptr;
-
-    std::unique_ptr<Gdiplus::Bitmap> gdi_bmp(Gdiplus::Bitmap::FromHBITMAP(hbmp, nullptr));
-    if (gdi_bmp && gdi_bmp->GetLastStatus() == Gdiplus::Ok) {
-        return gdi_bmp;
-    }
-
-    // Fallback: Copy via GDI BitBlt
-    std::unique_ptr<Gdiplus::Bitmap> copy_bmp(new Gdiplus::Bitmap(bmp.bmWidth, bmp.bmHeight, PixelFormat32bppARGB));
-    Gdiplus::Graphics g(copy_bmp.get());
-    HDC g_dc = g.GetHDC();
-    if (g_dc) {
-        HDC mem_dc = CreateCompatibleDC(hdc);
-        HBITMAP old_bm = (HBITMAP)SelectObject(mem_dc, hbmp);
-        BitBlt(g_dc, 0, 0, bmp.bmWidth, bmp.bmHeight, mem_dc, 0, 0, SRCCOPY);
-        SelectObject(mem_dc, old_bm);
-        DeleteDC(mem_dc);
-        g.ReleaseHDC(g_dc);
-    }
-    return copy_bmp;
-}
-
 static bool is_popup_dark_mode() {
-    int bg_style = get_background_style(); // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
+    int bg_style = get_settings().background_style; // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
     if (bg_style != 0) {
         // Light mode has no effect for Artwork Colors or Blurred Artwork
         return true;
     }
 
-    int theme_mode = get_theme_mode(); // 0 = Auto, 1 = Dark, 2 = Light
+    int theme_mode = get_settings().theme_mode; // 0 = Auto, 1 = Dark, 2 = Light
     if (theme_mode == 0) {
         try {
             fb2k::CCoreDarkModeHooks darkModeHooks;
@@ -1108,385 +1007,84 @@ static bool is_popup_dark_mode() {
 
 void popup_window::paint_popup(HDC hdc) {
     if (!hdc) return;
-    
+
     RECT client_rect;
     GetClientRect(m_popup_window, &client_rect);
     int window_width = client_rect.right - client_rect.left;
     int window_height = client_rect.bottom - client_rect.top;
-    
-    int bg_style = get_background_style(); // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
-    bool bg_painted = false;
-
-    if (bg_style == 1 && m_cover_art_bitmap) {
-        if (window_width > 0 && window_height > 0) {
-            BITMAP bmp;
-            if (GetObject(m_cover_art_bitmap, sizeof(bmp), &bmp) && bmp.bmWidth > 0 && bmp.bmHeight > 0) {
-                HDC mem_dc = CreateCompatibleDC(hdc);
-                HBITMAP old_bm = (HBITMAP)SelectObject(mem_dc, m_cover_art_bitmap);
-
-                long total_r = 0, total_g = 0, total_b = 0;
-                int pixel_count = 0;
-                const int grid_size = 8;
-
-                for (int y = 0; y < grid_size; y++) {
-                    int sample_y = (bmp.bmHeight * (y + 1)) / (grid_size + 1);
-                    for (int x = 0; x < grid_size; x++) {
-                        int sample_x = (bmp.bmWidth * (x + 1)) / (grid_size + 1);
-                        COLORREF c = GetPixel(mem_dc, sample_x, sample_y);
-                        if (c != CLR_INVALID) {
-                            total_r += GetRValue(c);
-                            total_g += GetGValue(c);
-                            total_b += GetBValue(c);
-                            pixel_count++;
-                        }
-                    }
-                }
-
-                SelectObject(mem_dc, old_bm);
-                DeleteDC(mem_dc);
-
-                if (pixel_count > 0) {
-                    int avg_r = total_r / pixel_count;
-                    int avg_g = total_g / pixel_count;
-                    int avg_b = total_b / pixel_count;
-
-                    Gdiplus::Color primary(255, avg_r, avg_g, avg_b);
-                    Gdiplus::Color secondary(255, avg_r * 65 / 100, avg_g * 65 / 100, avg_b * 65 / 100);
-
-                    Gdiplus::Graphics g(hdc);
-                    Gdiplus::Rect g_rect(0, 0, window_width, window_height);
-                    Gdiplus::LinearGradientBrush brush(
-                        Gdiplus::Point(0, 0),
-                        Gdiplus::Point(window_width, 0),
-                        secondary,
-                        primary
-                    );
-                    g.FillRectangle(&brush, g_rect);
-
-                    Gdiplus::SolidBrush overlay(Gdiplus::Color(50, 0, 0, 0));
-                    g.FillRectangle(&overlay, g_rect);
-                    bg_painted = true;
-                }
-            }
-        }
-    } else if (bg_style == 2 && m_cover_art_bitmap) {
-        if (window_width > 0 && window_height > 0) {
-            std::unique_ptr<Gdiplus::Bitmap> src_bitmap = create_gdiplus_bitmap_from_hbitmap(hdc, m_cover_art_bitmap);
-            if (src_bitmap && src_bitmap->GetLastStatus() == Gdiplus::Ok) {
-                const int blur_size = 64;
-                Gdiplus::Bitmap scaled(blur_size, blur_size, PixelFormat32bppARGB);
-                {
-                    Gdiplus::Graphics gfx(&scaled);
-                    gfx.SetInterpolationMode(Gdiplus::InterpolationModeBilinear);
-                    gfx.DrawImage(src_bitmap.get(), 0, 0, blur_size, blur_size);
-                }
-
-                Gdiplus::Rect lockRect(0, 0, blur_size, blur_size);
-                Gdiplus::BitmapData scaledData;
-                if (scaled.LockBits(&lockRect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &scaledData) == Gdiplus::Ok) {
-                    std::vector<BYTE> tempBuffer(blur_size * blur_size * 4);
-                    std::vector<BYTE> blurBuffer(blur_size * blur_size * 4);
-
-                    BYTE* srcPixels = static_cast<BYTE*>(scaledData.Scan0);
-                    int srcStride = scaledData.Stride;
-                    const int radius = 4;
-
-                    // Pass 1: Horizontal blur
-                    for (int y = 0; y < blur_size; y++) {
-                        for (int x = 0; x < blur_size; x++) {
-                            int total_r = 0, total_g = 0, total_b = 0, total_a = 0;
-                            int count = 0;
-                            for (int dx = -radius; dx <= radius; dx++) {
-                                int sx = x + dx;
-                                if (sx >= 0 && sx < blur_size) {
-                                    BYTE* pixel = srcPixels + y * srcStride + sx * 4;
-                                    total_b += pixel[0];
-                                    total_g += pixel[1];
-                                    total_r += pixel[2];
-                                    total_a += pixel[3];
-                                    count++;
-                                }
-                            }
-                            int dstIdx = (y * blur_size + x) * 4;
-                            tempBuffer[dstIdx + 0] = static_cast<BYTE>(total_b / count);
-                            tempBuffer[dstIdx + 1] = static_cast<BYTE>(total_g / count);
-                            tempBuffer[dstIdx + 2] = static_cast<BYTE>(total_r / count);
-                            tempBuffer[dstIdx + 3] = static_cast<BYTE>(total_a / count);
-                        }
-                    }
-
-                    scaled.UnlockBits(&scaledData);
-
-                    // Pass 2: Vertical blur
-                    for (int y = 0; y < blur_size; y++) {
-                        for (int x = 0; x < blur_size; x++) {
-                            int total_r = 0, total_g = 0, total_b = 0, total_a = 0;
-                            int count = 0;
-                            for (int dy = -radius; dy <= radius; dy++) {
-                                int sy = y + dy;
-                                if (sy >= 0 && sy < blur_size) {
-                                    int srcIdx = (sy * blur_size + x) * 4;
-                                    total_b += tempBuffer[srcIdx + 0];
-                                    total_g += tempBuffer[srcIdx + 1];
-                                    total_r += tempBuffer[srcIdx + 2];
-                                    total_a += tempBuffer[srcIdx + 3];
-                                    count++;
-                                }
-                            }
-                            int dstIdx = (y * blur_size + x) * 4;
-                            blurBuffer[dstIdx + 0] = static_cast<BYTE>(total_b / count);
-                            blurBuffer[dstIdx + 1] = static_cast<BYTE>(total_g / count);
-                            blurBuffer[dstIdx + 2] = static_cast<BYTE>(total_r / count);
-                            blurBuffer[dstIdx + 3] = static_cast<BYTE>(total_a / count);
-                        }
-                    }
-
-                    Gdiplus::Bitmap blurred_artwork(window_width, window_height, PixelFormat32bppARGB);
-                    Gdiplus::Rect outRect(0, 0, window_width, window_height);
-                    Gdiplus::BitmapData outData;
-                    if (blurred_artwork.LockBits(&outRect, Gdiplus::ImageLockModeWrite, PixelFormat32bppARGB, &outData) == Gdiplus::Ok) {
-                        BYTE* outPixels = static_cast<BYTE*>(outData.Scan0);
-                        int outStride = outData.Stride;
-
-                        float targetAspect = static_cast<float>(window_width) / static_cast<float>(window_height);
-                        float srcX = 0, srcY = 0, srcW = static_cast<float>(blur_size), srcH = static_cast<float>(blur_size);
-
-                        if (targetAspect > 1.0f) {
-                            srcH = blur_size / targetAspect;
-                            srcY = (blur_size - srcH) / 2.0f;
-                        } else {
-                            srcW = blur_size * targetAspect;
-                            srcX = (blur_size - srcW) / 2.0f;
-                        }
-
-                        for (int y = 0; y < window_height; y++) {
-                            BYTE* outRow = outPixels + y * outStride;
-                            float sy_base = srcY + (y / static_cast<float>(window_height)) * srcH;
-
-                            for (int x = 0; x < window_width; x++) {
-                                float sx = srcX + (x / static_cast<float>(window_width)) * srcW;
-                                float sy = sy_base;
-
-                                int x0 = static_cast<int>(sx);
-                                int y0 = static_cast<int>(sy);
-                                int x1 = (std::min)(x0 + 1, blur_size - 1);
-                                int y1 = (std::min)(y0 + 1, blur_size - 1);
-                                x0 = (std::max)(0, (std::min)(x0, blur_size - 1));
-                                y0 = (std::max)(0, (std::min)(y0, blur_size - 1));
-
-                                float fx = sx - static_cast<int>(sx);
-                                float fy = sy - static_cast<int>(sy);
-                                float fx_inv = 1.0f - fx;
-                                float fy_inv = 1.0f - fy;
-
-                                int idx00 = (y0 * blur_size + x0) * 4;
-                                int idx10 = (y0 * blur_size + x1) * 4;
-                                int idx01 = (y1 * blur_size + x0) * 4;
-                                int idx11 = (y1 * blur_size + x1) * 4;
-
-                                for (int c = 0; c < 4; c++) {
-                                    float top_ch = blurBuffer[idx00 + c] * fx_inv + blurBuffer[idx10 + c] * fx;
-                                    float bottom_ch = blurBuffer[idx01 + c] * fx_inv + blurBuffer[idx11 + c] * fx;
-                                    outRow[x * 4 + c] = static_cast<BYTE>(top_ch * fy_inv + bottom_ch * fy);
-                                }
-                            }
-                        }
-
-                        blurred_artwork.UnlockBits(&outData);
-
-                        Gdiplus::Graphics g(hdc);
-                        g.DrawImage(&blurred_artwork, 0, 0, window_width, window_height);
-
-                        Gdiplus::SolidBrush overlay(Gdiplus::Color(140, 0, 0, 0));
-                        g.FillRectangle(&overlay, 0, 0, window_width, window_height);
-                        bg_painted = true;
-                    }
-                }
-            }
-        }
-    }
+    if (window_width <= 0 || window_height <= 0) return;
 
-    bool is_dark = is_popup_dark_mode();
-
-    if (!bg_painted) {
-        COLORREF bg_color = is_dark ? RGB(45, 45, 48) : RGB(245, 245, 245);
-        HBRUSH bg_brush = CreateSolidBrush(bg_color);
-        FillRect(hdc, &client_rect, bg_brush);
-        DeleteObject(bg_brush);
+    if (!m_title_font || !m_artist_font) {
+        load_fonts();
     }
-    
-    // Draw border
-    COLORREF border_color = is_dark ? RGB(100, 100, 100) : RGB(200, 200, 200);
-    HPEN border_pen = CreatePen(PS_SOLID, 1, border_color);
-    HPEN old_pen = (HPEN)SelectObject(hdc, border_pen);
-    HBRUSH old_brush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
-    
-    Rectangle(hdc, 0, 0, client_rect.right, client_rect.bottom);
-    
-    SelectObject(hdc, old_pen);
-    SelectObject(hdc, old_brush);
-    DeleteObject(border_pen);
-    
-    bool show_art = get_show_cover_art();
-    if (show_art) {
-        bool has_margin = get_cover_margin();
-        bool is_rounded = (get_cover_style() == 1);
-        COLORREF placeholder_color = is_dark ? RGB(80, 80, 80) : RGB(220, 220, 220);
-        
-        RECT cover_rect = has_margin ? RECT{10, 10, 70, 70} : RECT{0, 0, window_height, window_height};
-        int art_w = cover_rect.right - cover_rect.left;
-        int art_h = cover_rect.bottom - cover_rect.top;
-
-        if (is_rounded) {
-            float radius = (art_w < art_h ? (float)art_w : (float)art_h) * 0.10f;
-            if (radius < 4.0f) radius = 4.0f;
-            if (radius > 12.0f) radius = 12.0f;
-            float d = radius * 2.0f;
 
-            Gdiplus::Bitmap offscreen(art_w, art_h, PixelFormat32bppPARGB);
-            {
-                Gdiplus::Graphics og(&offscreen);
-                og.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
-                og.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
-
-                if (m_cover_art_bitmap) {
-                    Gdiplus::Bitmap srcBitmap(m_cover_art_bitmap, nullptr);
-                    int srcW = srcBitmap.GetWidth();
-                    int srcH = srcBitmap.GetHeight();
-                    if (srcW > 0 && srcH > 0) {
-                        float srcAspect = (float)srcW / (float)srcH;
-                        float dstAspect = (float)art_w / (float)art_h;
-                        int cropX = 0, cropY = 0, cropW = srcW, cropH = srcH;
-                        if (srcAspect > dstAspect) {
-                            cropH = srcH;
-                            cropW = (int)(srcH * dstAspect);
-                            cropX = (srcW - cropW) / 2;
-                        } else {
-                            cropW = srcW;
-                            cropH = (int)(srcW / dstAspect);
-                            cropY = (srcH - cropH) / 2;
-                        }
-                        Gdiplus::Rect destRect(0, 0, art_w, art_h);
-                        og.DrawImage(&srcBitmap, destRect, cropX, cropY, cropW, cropH, Gdiplus::UnitPixel);
-                    } else {
-                        Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(placeholder_color), GetGValue(placeholder_color), GetBValue(placeholder_color)));
-                        og.FillRectangle(&brush, 0, 0, art_w, art_h);
-                    }
-                } else {
-                    Gdiplus::SolidBrush brush(Gdiplus::Color(255, GetRValue(placeholder_color), GetGValue(placeholder_color), GetBValue(placeholder_color)));
-                    og.FillRectangle(&brush, 0, 0, art_w, art_h);
-                }
-            }
-
-            float x = (float)cover_rect.left;
-            float y = (float)cover_rect.top;
-            float fw = (float)art_w;
-            float fh = (float)art_h;
-
-            Gdiplus::GraphicsPath roundedPath;
-            roundedPath.AddArc(x, y, d, d, 180, 90);
-            roundedPath.AddArc(x + fw - d, y, d, d, 270, 90);
-            roundedPath.AddArc(x + fw - d, y + fh - d, d, d, 0, 90);
-            roundedPath.AddArc(x, y + fh - d, d, d, 90, 90);
-            roundedPath.CloseFigure();
-
-            Gdiplus::Graphics g(hdc);
-            Gdiplus::TextureBrush texBrush(&offscreen, Gdiplus::WrapModeClamp);
-            texBrush.TranslateTransform((float)cover_rect.left, (float)cover_rect.top);
-
-            Gdiplus::SmoothingMode prevSmoothing = g.GetSmoothingMode();
-            g.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-            g.FillPath(&texBrush, &roundedPath);
-            g.SetSmoothingMode(prevSmoothing);
-        } else {
-            if (m_cover_art_bitmap) {
-                HDC bitmap_dc = CreateCompatibleDC(hdc);
-                HBITMAP old_bitmap = (HBITMAP)SelectObject(bitmap_dc, m_cover_art_bitmap);
-                BITMAP bmp_info;
-                GetObject(m_cover_art_bitmap, sizeof(BITMAP), &bmp_info);
-                SetStretchBltMode(hdc, HALFTONE);
-                StretchBlt(hdc, cover_rect.left, cover_rect.top, art_w, art_h,
-                           bitmap_dc, 0, 0, bmp_info.bmWidth, bmp_info.bmHeight, SRCCOPY);
-                SelectObject(bitmap_dc, old_bitmap);
-                DeleteDC(bitmap_dc);
-            } else {
-                HBRUSH cover_brush = CreateSolidBrush(placeholder_color);
-                FillRect(hdc, &cover_rect, cover_brush);
-                DeleteObject(cover_brush);
+    const tray_settings& settings = get_settings();
+    popup_paint_state state = {};
+    state.width = window_width;
+    state.height = window_height;
+    state.dark = is_popup_dark_mode();
+    state.background_style = settings.background_style;
+    state.show_cover_art = settings.show_cover_art;
+    state.cover_margin = settings.cover_margin;
+    state.rounded_cover = settings.cover_style == 1;
+    state.title = m_title_line.update(m_current_title);
+    state.artist = m_artist_line.update(m_current_artist);
+    state.title_font = canvas_font_from_hfont(m_title_font);
+    state.artist_font = canvas_font_from_hfont(m_artist_font);
+
+    // The popup is painted a handful of times per track, so its backgrounds are not cached
+    std::vector<uint8_t> cover_pixels;
+    if (canvas_image_from_hbitmap(m_cover_art_bitmap, state.cover, cover_pixels)) {
+        if (state.background_style == 1) {
+            state.has_artwork_color = average_artwork_color(state.cover, state.artwork_color);
+        } else if (state.background_style == 2) {
+            build_blurred_background(state.cover, window_width, window_height, 4, 4, m_blurred_background);
+            if (!m_blurred_background.empty()) {
+                state.blurred_background.bits = m_blurred_background.data();
+                state.blurred_background.width = window_width;
+                state.blurred_background.height = window_height;
+                state.blurred_background.stride = window_width * 4;
             }
         }
     }
-    
-    // Draw track info (right side)
-    draw_track_info(hdc, client_rect);
-}
 
-void popup_window::draw_track_info(HDC hdc, const RECT& client_rect) {
-    if (!hdc) return;
-    
-    pfc::string8 title = m_current_title;
-    pfc::string8 artist = m_current_artist;
-
-    if (title.is_empty()) title = "Unknown Title";
-    if (artist.is_empty()) artist = "Unknown Artist";
-    
-    // Setup text colors based on theme mode and background style
-    bool is_dark = is_popup_dark_mode();
-    int bg_style = get_background_style(); // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
-    
-    COLORREF title_color = (bg_style == 0 && !is_dark) ? RGB(20, 20, 20) : RGB(255, 255, 255);
-    COLORREF artist_color = (bg_style == 0 && !is_dark) ? RGB(80, 80, 80) : RGB(220, 220, 220);
+    gdiplus_canvas gfx(hdc, window_width, window_height, &m_text_layouts);
+    ::paint_popup(gfx, state);
+}
 
-    SetBkMode(hdc, TRANSPARENT);
+void popup_window::load_fonts() {
+    cleanup_fonts();
     
     // Use Docked Control Panel fonts for consistency between popup and docked panel
-    HFONT artist_font, title_font;
-    
-    if (get_cp_use_artist_custom_font()) {
-        LOGFONT artist_lf = get_cp_artist_font();
-        artist_font = CreateFontIndirect(&artist_lf);
+    const tray_font_setting& fonts = get_settings().docked_fonts;
+    if (fonts.custom_artist) {
+        m_artist_font = CreateFontIndirect(&fonts.artist);
     } else {
-        artist_font = CreateFont(get_dpi_scaled_font_height(9), 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                 DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                 DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Microsoft YaHei UI");
+        m_artist_font = CreateFont(get_dpi_scaled_font_height(9), 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
+                                   DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+                                   DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Microsoft YaHei UI");
     }
 
-    if (get_cp_use_track_custom_font()) {
-        LOGFONT title_lf = get_cp_track_font();
-        title_font = CreateFontIndirect(&title_lf);
+    if (fonts.custom_track) {
+        m_title_font = CreateFontIndirect(&fonts.track);
     } else {
-        title_font = CreateFont(get_dpi_scaled_font_height(11), 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-                                DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Microsoft YaHei UI");
-    }
-    
-    bool show_art = get_show_cover_art();
-    bool has_margin = get_cover_margin();
-    int text_left = 15;
-    if (show_art) {
-        text_left = has_margin ? 85 : (client_rect.bottom - client_rect.top + 10);
+        m_title_font = CreateFont(get_dpi_scaled_font_height(11), 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
+                                  DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+                                  DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Microsoft YaHei UI");
     }
+}
 
-    // Draw title first (top line)
-    HFONT old_font = (HFONT)SelectObject(hdc, title_font);
-    SetTextColor(hdc, title_color);
-    
-    RECT title_rect = {text_left, 15, client_rect.right - 10, 35};
-    pfc::stringcvt::string_wide_from_utf8 wide_title(title.c_str());
-    DrawText(hdc, wide_title.get_ptr(), -1, &title_rect, DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
-    
-    // Draw artist second (bottom line)
-    SelectObject(hdc, artist_font);
-    SetTextColor(hdc, artist_color);
-    
-    RECT artist_rect = {text_left, 40, client_rect.right - 10, 60};
-    pfc::stringcvt::string_wide_from_utf8 wide_artist(artist.c_str());
-    DrawText(hdc, wide_artist.get_ptr(), -1, &artist_rect, DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
-    
-    // Cleanup fonts
-    SelectObject(hdc, old_font);
-    DeleteObject(artist_font);
-    DeleteObject(title_font);
+void popup_window::cleanup_fonts() {
+    // Layouts are keyed by font handle, which GDI reuses once the fonts are deleted
+    m_text_layouts.clear();
+    if (m_title_font) {
+        DeleteObject(m_title_font);
+        m_title_font = nullptr;
+    }
+    if (m_artist_font) {
+        DeleteObject(m_artist_font);
+        m_artist_font = nullptr;
+    }
 }
 
 void popup_window::start_slide_in_animation() {
@@ -1497,7 +1095,7 @@ void popup_window::start_slide_in_animation() {
     m_animating = false;
 
     // Determine if sliding from right or left based on popup position
-    int popup_position = get_popup_position();
+    int popup_position = get_settings().popup_position;
     if (popup_position < 0 || popup_position > 5) popup_position = 0;
     bool is_right_side = (popup_position >= 3);
 
@@ -1538,7 +1136,7 @@ void popup_window::start_slide_out_animation() {
     m_animating = false;
 
     // Determine if sliding to right or left based on popup position
-    int popup_position = get_popup_position();
+    int popup_position = get_settings().popup_position;
     if (popup_position < 0 || popup_position > 5) popup_position = 0;
     bool is_right_side = (popup_position >= 3);
 
@@ -1594,7 +1192,7 @@ void popup_window::update_animation() {
         
         if (m_sliding_in) {
             // Animation complete, start auto-hide timer using configurable duration
-            SetTimer(m_popup_window, POPUP_TIMER_ID, get_popup_duration(), hide_timer_proc);
+            SetTimer(m_popup_window, POPUP_TIMER_ID, get_settings().popup_duration, hide_timer_proc);
         } else {
             // Slide-out complete, hide window
             ShowWindow(m_popup_window, SW_HIDE);
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "stdafx.h"
+#include "artwork_bridge.h"
+#include "text_layout.h"
+
+struct stream_metadata;
 
 // Popup notification window class
 class popup_window {
@@ -14,10 +18,12 @@ public:
     // Show popup with track information
     void show_track_info(metadb_handle_ptr p_track);
     void update_track_info(metadb_handle_ptr p_track);
-    void update_stream_metadata(const file_info & p_info);
+    void update_stream_metadata(const stream_metadata& meta);
     void show_preview();
     void hide_popup();
     void refresh_track_info();
+    // Stop waiting for the current track's online artwork (a newer track is about to replace it)
+    void cancel_artwork_wait();
     
     // Settings
     void on_settings_changed();
@@ -56,7 +62,8 @@ private:
     
     // Cover art and track info
     HBITMAP m_cover_art_bitmap;
-    bool m_artwork_from_bridge; // true if m_cover_art_bitmap is owned by foo_artwork (do NOT DeleteObject)
+    bool m_artwork_from_bridge; // true if m_cover_art_bitmap belongs to m_bridge_artwork (do NOT DeleteObject)
+    bridge_artwork_ptr m_bridge_artwork; // Shared image kept alive while displayed
     pfc::string8 m_last_track_path;
     pfc::string8 m_current_title;
     pfc::string8 m_current_artist;
@@ -65,11 +72,20 @@ private:
     metadb_handle_ptr m_pending_track;
     int m_artwork_wait_count;
     
+    // Docked panel fonts, created on first paint and dropped when settings change
+    HFONT m_title_font;
+    HFONT m_artist_font;
+    text_layout_cache m_text_layouts;
+    utf16_line m_title_line;
+    utf16_line m_artist_line;
+    std::vector<uint8_t> m_blurred_background;  // Blurred Artwork, rebuilt per paint
+    
     // Window management
     void create_popup_window();
     void position_popup();
     void load_cover_art(metadb_handle_ptr p_track, bool allow_stale_fallback = false);
     void cleanup_cover_art();
+    void set_bridge_artwork(const bridge_artwork_ptr& art);
     HBITMAP convert_album_art_to_bitmap(album_art_data_ptr art_data);
     void on_artwork_wait_timer();
     
@@ -85,8 +101,8 @@ private:
     
     // Drawing
     void paint_popup(HDC hdc);
-    void draw_cover_art(HDC hdc, const RECT& rect);
-    void draw_track_info(HDC hdc, const RECT& rect);
+    void load_fonts();
+    void cleanup_fonts();
     
     static popup_window* s_instance;
 };
@@ -2,7 +2,9 @@
 #include "preferences.h"
 #include "tray_manager.h"
 #include "control_panel.h"
+#include "perf_stats.h"
 #include <uxtheme.h>
+#include <atomic>
 #include <cstdlib>
 #pragma comment(lib, "uxtheme.lib")
 
@@ -38,6 +40,11 @@ static cfg_int cfg_ticker_speed(GUID{0x1234568C, 0x9abc, 0xdef0, {0x12, 0x34, 0x
 // Accent colors (default: vibrant orange, matching the previous hard-coded fills)
 static cfg_int cfg_compact_progress_color(GUID{0x1234568E, 0x9abc, 0xdef0, {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}}, RGB(255, 140, 0)); // Compact MiniPlayer track progress fill
 static cfg_int cfg_volume_osd_color(GUID{0x123456A4, 0x9abc, 0xdef0, {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}}, RGB(255, 140, 0)); // Volume OSD bar fill
+static cfg_int cfg_waveform_seekbar(GUID{0x123456A5, 0x9abc, 0xdef0, {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}}, 0); // 1=Waveform, 0=Flat bar (default)
+static cfg_int cfg_spectrum_visualizer(GUID{0x123456A6, 0x9abc, 0xdef0, {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}}, 0); // 1=Spectrum bars in Expanded/Compact, 0=Off (default)
+static cfg_int cfg_artwork_crossfade(GUID{0x123456A7, 0x9abc, 0xdef0, {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}}, 250); // Track-change crossfade in ms, 0=Off; default 250ms
+static cfg_int cfg_animated_artwork(GUID{0x123456A8, 0x9abc, 0xdef0, {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}}, 1); // 1=Play animated covers (default), 0=First frame only
+static cfg_int cfg_perf_stats(GUID{0x123456A9, 0x9abc, 0xdef0, {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}}, 0); // 1=Collect performance statistics, 0=Off (default)
 static cfg_string cfg_color_picker_custom(GUID{0x123456D6, 0x9abc, 0xdef0, {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}}, ""); // 16 custom slots for ChooseColor
 
 // MiniPlayer mode size configuration
@@ -304,6 +311,37 @@ COLORREF get_volume_osd_color() {
     return (COLORREF)cfg_volume_osd_color.get_value();
 }
 
+bool get_waveform_seekbar() {
+    return cfg_waveform_seekbar != 0;
+}
+
+bool get_spectrum_visualizer() {
+    return cfg_spectrum_visualizer != 0;
+}
+
+int get_artwork_crossfade() {
+    int duration = cfg_artwork_crossfade;
+    // Clamp to valid range (0 = Off, at most one second)
+    if (duration < 0) duration = 0;
+    if (duration > 1000) duration = 1000;
+    return duration;
+}
+
+bool get_animated_artwork() {
+    return cfg_animated_artwork != 0;
+}
+
+bool get_perf_stats_enabled() {
+    return cfg_perf_stats != 0;
+}
+
+void set_perf_stats_enabled(bool enabled) {
+    cfg_perf_stats = enabled ? 1 : 0;
+#if TRAYCONTROLS_PERF_STATS
+    perf_set_enabled(enabled);
+#endif
+}
+
 bool get_hover_circles_enabled() {
     return cfg_hover_circles != 0;
 }
@@ -387,100 +425,6 @@ pfc::string8 get_line2_format() {
     return cfg_line2_format.get();
 }
 
-static const char* safe_meta_get_pref(const file_info& info, const char* name) {
-    t_size index = info.meta_find(name);
-    if (index != pfc_infinite && info.meta_enum_value_count(index) > 0) {
-        const char* val = info.meta_enum_value(index, 0);
-        if (val && val[0] != '\0') return val;
-    }
-    return nullptr;
-}
-
-void format_display_lines_track(metadb_handle_ptr track, pfc::string8& line1_out, pfc::string8& line2_out) {
-    if (!track.is_valid()) return;
-    try {
-        pfc::string8 line1_fmt = get_line1_format();
-        pfc::string8 line2_fmt = get_line2_format();
-
-        if (line1_fmt.is_empty()) line1_fmt = "%title%";
-        if (line2_fmt.is_empty()) line2_fmt = "%artist%";
-
-        static_api_ptr_t<titleformat_compiler> compiler;
-        service_ptr_t<titleformat_object> script1;
-        service_ptr_t<titleformat_object> script2;
-        compiler->compile_safe(script1, line1_fmt);
-        compiler->compile_safe(script2, line2_fmt);
-
-        if (script1.is_valid()) {
-            track->format_title(nullptr, line1_out, script1, nullptr);
-        }
-        if (script2.is_valid()) {
-            track->format_title(nullptr, line2_out, script2, nullptr);
-        }
-
-        // Direct metadata tag fallback via get_info_ref() and file_info
-        if (line1_out.is_empty() || line2_out.is_empty()) {
-            metadb_info_container::ptr info_container = track->get_info_ref();
-            if (info_container.is_valid()) {
-                const file_info& info = info_container->info();
-                if (line1_out.is_empty()) {
-                    const char* val = safe_meta_get_pref(info, "TITLE");
-                    if (!val) val = safe_meta_get_pref(info, "title");
-                    if (!val) val = pfc::string_filename_ext(track->get_path()).get_ptr();
-                    if (val) line1_out = val;
-                }
-                if (line2_out.is_empty()) {
-                    const char* val = safe_meta_get_pref(info, "ARTIST");
-                    if (!val) val = safe_meta_get_pref(info, "artist");
-                    if (!val) val = safe_meta_get_pref(info, "ALBUMARTIST");
-                    if (!val) val = safe_meta_get_pref(info, "albumartist");
-                    if (!val) val = safe_meta_get_pref(info, "PERFORMER");
-                    if (!val) val = safe_meta_get_pref(info, "performer");
-                    if (val) line2_out = val;
-                }
-            }
-        }
-
-        // Check for external stream metadata discovered via foo_artwork (e.g. ?azuracast_api / ?radioreg_api)
-        static service_ptr_t<titleformat_object> tf_fa_title, tf_fa_artist;
-        if (!tf_fa_title.is_valid()) {
-            compiler->compile_safe(tf_fa_title, "%foo_artwork_title%");
-        }
-        if (!tf_fa_artist.is_valid()) {
-            compiler->compile_safe(tf_fa_artist, "%foo_artwork_artist%");
-        }
-        pfc::string8 fa_title, fa_artist;
-        track->format_title(nullptr, fa_title, tf_fa_title, nullptr);
-        track->format_title(nullptr, fa_artist, tf_fa_artist, nullptr);
-
-        if (!fa_title.is_empty() && fa_title != "?") {
-            if (line1_fmt == "%title%" || line1_out.is_empty() ||
-                line1_out.find_first("http://") == 0 || line1_out.find_first("https://") == 0) {
-                line1_out = fa_title;
-            }
-        }
-        if (!fa_artist.is_empty() && fa_artist != "?") {
-            if (line2_fmt == "%artist%" || line2_out.is_empty()) {
-                line2_out = fa_artist;
-            }
-        }
-    } catch (...) {
-        // Leave outputs unchanged on error
-    }
-}
-
-void format_display_lines(pfc::string8& line1_out, pfc::string8& line2_out) {
-    try {
-        auto playback = playback_control::get();
-        metadb_handle_ptr track;
-        if (playback->get_now_playing(track) && track.is_valid()) {
-            format_display_lines_track(track, line1_out, line2_out);
-        }
-    } catch (...) {
-        // Leave outputs unchanged on error
-    }
-}
-
 // MiniPlayer mode size configuration access functions
 int get_miniplayer_undocked_width() { return cfg_miniplayer_undocked_width; }
 int get_miniplayer_undocked_height() { return cfg_miniplayer_undocked_height; }
@@ -671,6 +615,184 @@ LOGFONT get_default_font(bool is_artist, int size) {
     return lf;
 }
 
+//=============================================================================
+// Settings snapshot
+//=============================================================================
+
+static tray_settings_ptr g_settings;                         // Owner, swapped with std::atomic_store
+static std::atomic<const tray_settings*> g_settings_current; // Same object, for the one-load hot path
+static unsigned g_settings_generation = 0;
+
+static void read_font_setting(tray_font_setting& out, cfg_int& use_artist, cfg_int& use_track,
+                              cfg_struct_t<LOGFONT>& artist, cfg_struct_t<LOGFONT>& track) {
+    out.custom_artist = use_artist != 0;
+    out.custom_track = use_track != 0;
+    out.artist = artist.get_value();
+    out.track = track.get_value();
+}
+
+static bool same_font(const LOGFONT& a, const LOGFONT& b) {
+    return memcmp(&a, &b, sizeof(LOGFONT)) == 0;
+}
+
+static bool same_font_setting(const tray_font_setting& a, const tray_font_setting& b) {
+    // The LOGFONTs only matter while the matching custom flag is set
+    if (a.custom_artist != b.custom_artist || a.custom_track != b.custom_track) return false;
+    if (a.custom_artist && !same_font(a.artist, b.artist)) return false;
+    if (a.custom_track && !same_font(a.track, b.track)) return false;
+    return true;
+}
+
+unsigned diff_settings(const tray_settings& before, const tray_settings& after) {
+    unsigned changes = 0;
+
+    if (before.always_minimize_to_tray != after.always_minimize_to_tray ||
+        before.double_click_actions != after.double_click_actions ||
+        before.show_popup_notification != after.show_popup_notification ||
+        before.popup_position != after.popup_position ||
+        before.popup_duration != after.popup_duration ||
+        before.disable_miniplayer != after.disable_miniplayer ||
+        before.disable_slide_to_side != after.disable_slide_to_side ||
+        before.slide_duration != after.slide_duration ||
+        before.always_slide_to_side != after.always_slide_to_side ||
+        before.show_volume_feedback != after.show_volume_feedback) {
+        changes |= settings_change_behavior;
+    }
+
+    if (before.theme_mode != after.theme_mode ||
+        before.compact_progress_color != after.compact_progress_color ||
+        before.volume_osd_color != after.volume_osd_color) {
+        changes |= settings_change_theme;
+    }
+
+    if (before.use_rounded_corners != after.use_rounded_corners ||
+        before.show_cover_art != after.show_cover_art ||
+        before.cover_margin != after.cover_margin ||
+        before.cover_style != after.cover_style ||
+        before.background_style != after.background_style ||
+        before.miniplayer_border_style != after.miniplayer_border_style ||
+        before.hover_circles != after.hover_circles ||
+        before.alternative_icons_style != after.alternative_icons_style ||
+        before.waveform_seekbar != after.waveform_seekbar ||
+        before.spectrum_visualizer != after.spectrum_visualizer ||
+        before.artwork_crossfade != after.artwork_crossfade ||
+        before.animated_artwork != after.animated_artwork) {
+        changes |= settings_change_appearance;
+    }
+
+    if (before.ticker_speed != after.ticker_speed) {
+        changes |= settings_change_ticker;
+    }
+
+    if (before.undocked_width != after.undocked_width ||
+        before.undocked_height != after.undocked_height ||
+        before.compact_width != after.compact_width ||
+        before.compact_height != after.compact_height ||
+        before.expanded_size != after.expanded_size) {
+        changes |= settings_change_sizes;
+    }
+
+    if (strcmp(before.line1_format, after.line1_format) != 0 ||
+        strcmp(before.line2_format, after.line2_format) != 0) {
+        changes |= settings_change_formats;
+    }
+
+    if (!same_font_setting(before.popup_fonts, after.popup_fonts) ||
+        !same_font_setting(before.docked_fonts, after.docked_fonts) ||
+        !same_font_setting(before.undocked_fonts, after.undocked_fonts) ||
+        !same_font_setting(before.expanded_fonts, after.expanded_fonts) ||
+        !same_font_setting(before.compact_fonts, after.compact_fonts) ||
+        before.custom_timer_font != after.custom_timer_font ||
+        (after.custom_timer_font && !same_font(before.timer_font, after.timer_font))) {
+        changes |= settings_change_fonts;
+    }
+
+    return changes;
+}
+
+unsigned publish_settings() {
+    auto next = std::make_shared<tray_settings>();
+    tray_settings& s = *next;
+    s.generation = ++g_settings_generation;
+
+    s.always_minimize_to_tray = get_always_minimize_to_tray();
+    s.double_click_actions = get_double_click_actions();
+    s.show_popup_notification = get_show_popup_notification();
+    s.popup_position = get_popup_position();
+    s.popup_duration = get_popup_duration();
+    s.disable_miniplayer = get_disable_miniplayer();
+    s.disable_slide_to_side = get_disable_slide_to_side();
+    s.slide_duration = get_slide_duration();
+    s.always_slide_to_side = get_always_slide_to_side();
+    s.show_volume_feedback = get_show_volume_feedback();
+
+    s.theme_mode = get_theme_mode();
+    s.use_rounded_corners = get_use_rounded_corners();
+    s.show_cover_art = get_show_cover_art();
+    s.cover_margin = get_cover_margin();
+    s.cover_style = get_cover_style();
+    s.background_style = get_background_style();
+    s.miniplayer_border_style = get_miniplayer_border_style();
+    s.ticker_speed = get_ticker_speed();
+    s.hover_circles = get_hover_circles_enabled();
+    s.alternative_icons_style = get_alternative_icons_style();
+    s.compact_progress_color = get_compact_progress_color();
+    s.volume_osd_color = get_volume_osd_color();
+    s.waveform_seekbar = get_waveform_seekbar();
+    s.spectrum_visualizer = get_spectrum_visualizer();
+    s.artwork_crossfade = get_artwork_crossfade();
+    s.animated_artwork = get_animated_artwork();
+
+    s.undocked_width = get_miniplayer_undocked_width();
+    s.undocked_height = get_miniplayer_undocked_height();
+    s.compact_width = get_miniplayer_compact_width();
+    s.compact_height = get_miniplayer_compact_height();
+    s.expanded_size = get_miniplayer_expanded_size();
+
+    s.line1_format = cfg_line1_format.get();
+    s.line2_format = cfg_line2_format.get();
+
+    read_font_setting(s.popup_fonts, cfg_use_artist_custom_font, cfg_use_track_custom_font,
+                      cfg_artist_font, cfg_track_font);
+    read_font_setting(s.docked_fonts, cfg_cp_use_artist_custom_font, cfg_cp_use_track_custom_font,
+                      cfg_cp_artist_font, cfg_cp_track_font);
+    read_font_setting(s.undocked_fonts, cfg_undocked_use_artist_custom_font, cfg_undocked_use_track_custom_font,
+                      cfg_undocked_artist_font, cfg_undocked_track_font);
+    read_font_setting(s.expanded_fonts, cfg_expanded_use_artist_custom_font, cfg_expanded_use_track_custom_font,
+                      cfg_expanded_artist_font, cfg_expanded_track_font);
+    read_font_setting(s.compact_fonts, cfg_compact_use_artist_custom_font, cfg_compact_use_track_custom_font,
+                      cfg_compact_artist_font, cfg_compact_track_font);
+    s.custom_timer_font = get_timer_use_custom_font();
+    s.timer_font = get_timer_font();
+
+    tray_settings_ptr previous = std::atomic_load(&g_settings);
+    unsigned changes = previous ? diff_settings(*previous, s) : settings_change_all;
+
+    tray_settings_ptr published = std::move(next);
+    g_settings_current.store(published.get(), std::memory_order_release);
+    std::atomic_store(&g_settings, std::move(published));
+    return changes;
+}
+
+const tray_settings& get_settings() {
+    const tray_settings* current = g_settings_current.load(std::memory_order_acquire);
+    if (!current) {
+        // First read: configuration is loaded long before any window paints
+        publish_settings();
+        current = g_settings_current.load(std::memory_order_acquire);
+    }
+    return *current;
+}
+
+tray_settings_ptr get_settings_ptr() {
+    tray_settings_ptr current = std::atomic_load(&g_settings);
+    if (!current) {
+        publish_settings();
+        current = std::atomic_load(&g_settings);
+    }
+    return current;
+}
+
 // GUID for our preferences page
 static const GUID guid_preferences_page_tray = 
 { 0x12345678, 0x9abc, 0xdef0, { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 } };
@@ -727,7 +849,7 @@ void tray_preferences::reset() {
     update_font_displays();
     
     // Notify control panel to reload fonts
-    control_panel::get_instance().on_settings_changed();
+    control_panel::get_instance().on_settings_changed(publish_settings());
     
     m_has_changes = false;
     m_callback->on_state_changed();
@@ -741,6 +863,13 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
         SetWindowLongPtr(hwnd, GWLP_USERDATA, lp);
         p_this->m_hwnd = hwnd;
         
+#if TRAYCONTROLS_PERF_STATS
+        // Created before the dark mode hooks so they get themed with the rest
+        if (GetKeyState(VK_SHIFT) < 0) {
+            p_this->create_diagnostics_controls();
+        }
+#endif
+        
         // Initialize dark mode hooks
         p_this->m_darkMode.AddDialogWithControls(hwnd);
         
@@ -851,6 +980,22 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
         SendMessage(hTickerSpeedCombo, CB_ADDSTRING, 0, (LPARAM)L"Fastest");
         SendMessage(hTickerSpeedCombo, CB_SETCURSEL, cfg_ticker_speed, 0);
 
+        HWND hCrossfadeCombo = GetDlgItem(hwnd, IDC_ARTWORK_CROSSFADE_COMBO);
+        SendMessage(hCrossfadeCombo, CB_RESETCONTENT, 0, 0);
+        SendMessage(hCrossfadeCombo, CB_ADDSTRING, 0, (LPARAM)L"Off");
+        SendMessage(hCrossfadeCombo, CB_ADDSTRING, 0, (LPARAM)L"Quick (150 ms)");
+        SendMessage(hCrossfadeCombo, CB_ADDSTRING, 0, (LPARAM)L"Normal (250 ms)");
+        SendMessage(hCrossfadeCombo, CB_ADDSTRING, 0, (LPARAM)L"Smooth (400 ms)");
+        SendMessage(hCrossfadeCombo, CB_ADDSTRING, 0, (LPARAM)L"Slow (600 ms)");
+
+        int crossfade_index = 2; // Default 250ms
+        if (cfg_artwork_crossfade == 0) crossfade_index = 0;
+        else if (cfg_artwork_crossfade == 150) crossfade_index = 1;
+        else if (cfg_artwork_crossfade == 250) crossfade_index = 2;
+        else if (cfg_artwork_crossfade == 400) crossfade_index = 3;
+        else if (cfg_artwork_crossfade == 600) crossfade_index = 4;
+        SendMessage(hCrossfadeCombo, CB_SETCURSEL, crossfade_index, 0);
+
         // Initialize icons tab comboboxes
         HWND hHoverCirclesCombo = GetDlgItem(hwnd, IDC_HOVER_CIRCLES_COMBO);
         SendMessage(hHoverCirclesCombo, CB_RESETCONTENT, 0, 0);
@@ -867,6 +1012,9 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
 
         CheckDlgButton(hwnd, IDC_SHOW_VOLUME_FEEDBACK, cfg_show_volume_feedback ? BST_CHECKED : BST_UNCHECKED);
         update_volume_color_button_state(hwnd);
+        CheckDlgButton(hwnd, IDC_WAVEFORM_SEEKBAR, cfg_waveform_seekbar ? BST_CHECKED : BST_UNCHECKED);
+        CheckDlgButton(hwnd, IDC_SPECTRUM_VISUALIZER, cfg_spectrum_visualizer ? BST_CHECKED : BST_UNCHECKED);
+        CheckDlgButton(hwnd, IDC_ANIMATED_ARTWORK, cfg_animated_artwork ? BST_CHECKED : BST_UNCHECKED);
 
         // Initialize display format edit fields
         uSetDlgItemText(hwnd, IDC_LINE1_FORMAT_EDIT, cfg_line1_format);
@@ -951,6 +1099,9 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
         case IDC_DISABLE_MINIPLAYER:
         case IDC_DISABLE_SLIDE_TO_SIDE:
         case IDC_SHOW_VOLUME_FEEDBACK:
+        case IDC_WAVEFORM_SEEKBAR:
+        case IDC_SPECTRUM_VISUALIZER:
+        case IDC_ANIMATED_ARTWORK:
             if (HIWORD(wp) == BN_CLICKED) {
                 if (LOWORD(wp) == IDC_DISABLE_MINIPLAYER) {
                     update_slide_controls_state(hwnd, IsDlgButtonChecked(hwnd, IDC_DISABLE_MINIPLAYER) == BST_CHECKED);
@@ -1089,6 +1240,7 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
                 int pos_sel = (int)SendMessage(GetDlgItem(hwnd, IDC_POPUP_POSITION_COMBO), CB_GETCURSEL, 0, 0);
                 if (pos_sel >= 0) {
                     cfg_popup_position = pos_sel;
+                    publish_settings();
                     popup_window::get_instance().on_settings_changed();
                 }
                 p_this->on_changed();
@@ -1101,6 +1253,7 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
                 int duration_values[] = {1000, 2000, 3000, 4000, 5000, 7000, 10000};
                 if (duration_index >= 0 && duration_index < 7) {
                     cfg_popup_duration = duration_values[duration_index];
+                    publish_settings();
                     popup_window::get_instance().on_settings_changed();
                 }
                 p_this->on_changed();
@@ -1112,8 +1265,9 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
                 int sel = (int)SendMessage(GetDlgItem(hwnd, IDC_THEME_MODE_COMBO), CB_GETCURSEL, 0, 0);
                 if (sel >= 0) {
                     cfg_theme_mode = sel;
+                    unsigned changes = publish_settings();
                     popup_window::get_instance().on_settings_changed();
-                    control_panel::get_instance().on_settings_changed();
+                    control_panel::get_instance().on_settings_changed(changes);
                 }
                 p_this->on_changed();
             }
@@ -1124,8 +1278,9 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
                 int sel = (int)SendMessage(GetDlgItem(hwnd, IDC_BACKGROUND_STYLE_COMBO), CB_GETCURSEL, 0, 0);
                 if (sel >= 0) {
                     cfg_background_style = sel;
+                    unsigned changes = publish_settings();
                     popup_window::get_instance().on_settings_changed();
-                    control_panel::get_instance().on_settings_changed();
+                    control_panel::get_instance().on_settings_changed(changes);
                 }
                 p_this->on_changed();
             }
@@ -1137,6 +1292,7 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
         case IDC_COVER_STYLE_COMBO:
         case IDC_MINIPLAYER_BORDER_COMBO:
         case IDC_TICKER_SPEED_COMBO:
+        case IDC_ARTWORK_CROSSFADE_COMBO:
         case IDC_HOVER_CIRCLES_COMBO:
         case IDC_ALTERNATIVE_ICONS_COMBO:
             if (HIWORD(wp) == CBN_SELCHANGE) {
@@ -1225,6 +1381,29 @@ INT_PTR CALLBACK tray_preferences::ConfigProc(HWND hwnd, UINT msg, WPARAM wp, LP
                 p_this->select_timer_font();
             }
             break;
+
+#if TRAYCONTROLS_PERF_STATS
+        case IDC_DIAGNOSTICS_REFRESH:
+            if (HIWORD(wp) == BN_CLICKED) {
+                p_this->refresh_diagnostics();
+            }
+            break;
+
+        case IDC_DIAGNOSTICS_RESET:
+            if (HIWORD(wp) == BN_CLICKED) {
+                perf_reset();
+                p_this->refresh_diagnostics();
+            }
+            break;
+
+        case IDC_DIAGNOSTICS_COLLECT:
+            if (HIWORD(wp) == BN_CLICKED) {
+                // Takes effect immediately, like the menu command; not part of Apply
+                set_perf_stats_enabled(IsDlgButtonChecked(hwnd, IDC_DIAGNOSTICS_COLLECT) == BST_CHECKED);
+                p_this->refresh_diagnostics();
+            }
+            break;
+#endif
         }
         break;
         
@@ -1290,6 +1469,9 @@ bool tray_preferences::has_changed() {
     int current_popup_position = (int)SendMessage(GetDlgItem(m_hwnd, IDC_POPUP_POSITION_COMBO), CB_GETCURSEL, 0, 0);
     int current_show_volume_feedback = (IsDlgButtonChecked(m_hwnd, IDC_SHOW_VOLUME_FEEDBACK) == BST_CHECKED) ? 1 : 0;
     int current_alternative_icons = (int)SendMessage(GetDlgItem(m_hwnd, IDC_ALTERNATIVE_ICONS_COMBO), CB_GETCURSEL, 0, 0);
+    int current_waveform_seekbar = (IsDlgButtonChecked(m_hwnd, IDC_WAVEFORM_SEEKBAR) == BST_CHECKED) ? 1 : 0;
+    int current_spectrum_visualizer = (IsDlgButtonChecked(m_hwnd, IDC_SPECTRUM_VISUALIZER) == BST_CHECKED) ? 1 : 0;
+    int current_animated_artwork = (IsDlgButtonChecked(m_hwnd, IDC_ANIMATED_ARTWORK) == BST_CHECKED) ? 1 : 0;
     
     return (current_minimize_to_tray != cfg_always_minimize_to_tray) || 
            (current_double_click != cfg_double_click_actions) ||
@@ -1298,7 +1480,10 @@ bool tray_preferences::has_changed() {
            (current_disable_slide != cfg_disable_slide_to_side) ||
            (current_popup_position != cfg_popup_position) ||
            (current_show_volume_feedback != cfg_show_volume_feedback) ||
-           (current_alternative_icons != cfg_alternative_icons);
+           (current_alternative_icons != cfg_alternative_icons) ||
+           (current_waveform_seekbar != cfg_waveform_seekbar) ||
+           (current_spectrum_visualizer != cfg_spectrum_visualizer) ||
+           (current_animated_artwork != cfg_animated_artwork);
 
 }
 
@@ -1339,6 +1524,16 @@ void tray_preferences::apply_settings() {
         cfg_hover_circles = (hover_circles_sel == 0) ? 1 : 0;
         cfg_alternative_icons = (int)SendMessage(GetDlgItem(m_hwnd, IDC_ALTERNATIVE_ICONS_COMBO), CB_GETCURSEL, 0, 0);
         cfg_show_volume_feedback = (IsDlgButtonChecked(m_hwnd, IDC_SHOW_VOLUME_FEEDBACK) == BST_CHECKED) ? 1 : 0;
+        cfg_waveform_seekbar = (IsDlgButtonChecked(m_hwnd, IDC_WAVEFORM_SEEKBAR) == BST_CHECKED) ? 1 : 0;
+        cfg_spectrum_visualizer = (IsDlgButtonChecked(m_hwnd, IDC_SPECTRUM_VISUALIZER) == BST_CHECKED) ? 1 : 0;
+        cfg_animated_artwork = (IsDlgButtonChecked(m_hwnd, IDC_ANIMATED_ARTWORK) == BST_CHECKED) ? 1 : 0;
+
+        // Convert crossfade combo index to milliseconds
+        int crossfade_index = (int)SendMessage(GetDlgItem(m_hwnd, IDC_ARTWORK_CROSSFADE_COMBO), CB_GETCURSEL, 0, 0);
+        int crossfade_values[] = {0, 150, 250, 400, 600};
+        if (crossfade_index >= 0 && crossfade_index < 5) {
+            cfg_artwork_crossfade = crossfade_values[crossfade_index];
+        }
 
         // Save display format strings
         {
@@ -1365,8 +1560,9 @@ void tray_preferences::apply_settings() {
         if (w_translated && e_s >= 200 && e_s <= 1000) cfg_miniplayer_expanded_size = e_s;
 
         // Notify tray manager and control panel of settings change
+        unsigned changes = publish_settings();
         tray_manager::get_instance().on_settings_changed();
-        control_panel::get_instance().on_settings_changed();
+        control_panel::get_instance().on_settings_changed(changes);
     }
 }
 
@@ -1392,6 +1588,10 @@ void tray_preferences::reset_settings() {
         cfg_show_volume_feedback = 1;     // Default: Yes (1)
         cfg_compact_progress_color = RGB(255, 140, 0); // Default: orange
         cfg_volume_osd_color = RGB(255, 140, 0);       // Default: orange
+        cfg_waveform_seekbar = 0;         // Default: Flat bar (0)
+        cfg_spectrum_visualizer = 0;      // Default: Off (0)
+        cfg_artwork_crossfade = 250;      // Default: 250ms (Normal)
+        cfg_animated_artwork = 1;         // Default: Play (1)
         cfg_line1_format = "%title%";     // Default: title
         cfg_line2_format = "%artist%";    // Default: artist
 
@@ -1419,10 +1619,14 @@ void tray_preferences::reset_settings() {
         SendMessage(GetDlgItem(m_hwnd, IDC_BACKGROUND_STYLE_COMBO), CB_SETCURSEL, 0, 0);      // Solid
         SendMessage(GetDlgItem(m_hwnd, IDC_MINIPLAYER_BORDER_COMBO), CB_SETCURSEL, 1, 0);     // Rounded (index 1)
         SendMessage(GetDlgItem(m_hwnd, IDC_TICKER_SPEED_COMBO), CB_SETCURSEL, 2, 0);           // Slow (index 2)
+        SendMessage(GetDlgItem(m_hwnd, IDC_ARTWORK_CROSSFADE_COMBO), CB_SETCURSEL, 2, 0);      // Normal 250ms (index 2)
         SendMessage(GetDlgItem(m_hwnd, IDC_HOVER_CIRCLES_COMBO), CB_SETCURSEL, 0, 0);          // Show (index 0)
         SendMessage(GetDlgItem(m_hwnd, IDC_ALTERNATIVE_ICONS_COMBO), CB_SETCURSEL, 0, 0);      // Style 1 (index 0)
         CheckDlgButton(m_hwnd, IDC_SHOW_VOLUME_FEEDBACK, BST_CHECKED);
         update_volume_color_button_state(m_hwnd);
+        CheckDlgButton(m_hwnd, IDC_WAVEFORM_SEEKBAR, BST_UNCHECKED);
+        CheckDlgButton(m_hwnd, IDC_SPECTRUM_VISUALIZER, BST_UNCHECKED);
+        CheckDlgButton(m_hwnd, IDC_ANIMATED_ARTWORK, BST_CHECKED);
         // Repaint the color swatch buttons with the reset colors
         InvalidateRect(GetDlgItem(m_hwnd, IDC_PROGRESS_ACCENT_BTN), nullptr, TRUE);
         InvalidateRect(GetDlgItem(m_hwnd, IDC_VOLUME_OSD_COLOR_BTN), nullptr, TRUE);
@@ -1444,8 +1648,9 @@ void tray_preferences::reset_settings() {
         s_ignore_edit_change = false;
 
         // Notify components of settings change
+        unsigned changes = publish_settings();
         tray_manager::get_instance().on_settings_changed();
-        control_panel::get_instance().on_settings_changed();
+        control_panel::get_instance().on_settings_changed(changes);
         
         update_font_displays();
     }
@@ -1877,7 +2082,7 @@ void tray_preferences::select_timer_font() {
         on_changed();
         
         // Notify control panel to reload fonts
-        control_panel::get_instance().on_settings_changed();
+        control_panel::get_instance().on_settings_changed(publish_settings());
     }
 }
 
@@ -1906,7 +2111,7 @@ void tray_preferences::reset_all_fonts_to_default() {
     on_changed();
     
     // Notify control panel to reload fonts
-    control_panel::get_instance().on_settings_changed();
+    control_panel::get_instance().on_settings_changed(publish_settings());
 }
 
 pfc::string8 tray_preferences::format_font_name(const LOGFONT& lf) {
@@ -1960,6 +2165,13 @@ void tray_preferences::init_tab_control() {
     
     tie.pszText = const_cast<LPWSTR>(L"Fonts");
     TabCtrl_InsertItem(hTab, 4, &tie);
+
+#if TRAYCONTROLS_PERF_STATS
+    if (GetDlgItem(m_hwnd, IDC_DIAGNOSTICS_REPORT)) {
+        tie.pszText = const_cast<LPWSTR>(L"Diagnostics");
+        TabCtrl_InsertItem(hTab, 5, &tie);
+    }
+#endif
     
     // Select first tab
     TabCtrl_SetCurSel(hTab, 0);
@@ -2016,8 +2228,13 @@ void tray_preferences::switch_tab(int tab) {
         IDC_TICKER_SPEED_COMBO,
         IDC_PROGRESS_ACCENT_LABEL,
         IDC_PROGRESS_ACCENT_BTN,
+        IDC_WAVEFORM_SEEKBAR,
         IDC_SHOW_VOLUME_FEEDBACK,
-        IDC_VOLUME_OSD_COLOR_BTN
+        IDC_VOLUME_OSD_COLOR_BTN,
+        IDC_SPECTRUM_VISUALIZER,
+        IDC_ARTWORK_CROSSFADE_LABEL,
+        IDC_ARTWORK_CROSSFADE_COMBO,
+        IDC_ANIMATED_ARTWORK
     };
 
     // Icons tab controls
@@ -2128,7 +2345,74 @@ void tray_preferences::switch_tab(int tab) {
         HWND hCtrl = GetDlgItem(m_hwnd, id);
         if (hCtrl) ShowWindow(hCtrl, show_fonts);
     }
+
+#if TRAYCONTROLS_PERF_STATS
+    // Show/hide Diagnostics controls (only present when the hidden tab was created)
+    int diagnostics_controls[] = {
+        IDC_DIAGNOSTICS_REPORT,
+        IDC_DIAGNOSTICS_REFRESH,
+        IDC_DIAGNOSTICS_RESET,
+        IDC_DIAGNOSTICS_COLLECT
+    };
+    int show_diagnostics = (tab == 5) ? SW_SHOW : SW_HIDE;
+    for (int id : diagnostics_controls) {
+        HWND hCtrl = GetDlgItem(m_hwnd, id);
+        if (hCtrl) ShowWindow(hCtrl, show_diagnostics);
+    }
+    if (tab == 5) refresh_diagnostics();
+#endif
+}
+
+#if TRAYCONTROLS_PERF_STATS
+void tray_preferences::create_diagnostics_controls() {
+    if (!m_hwnd) return;
+
+    // Same tab page area as the other tabs, in dialog units
+    RECT report_rc = { 12, 26, 284, 266 };
+    RECT refresh_rc = { 12, 272, 62, 286 };
+    RECT reset_rc = { 66, 272, 116, 286 };
+    RECT collect_rc = { 126, 274, 226, 284 };
+    MapDialogRect(m_hwnd, &report_rc);
+    MapDialogRect(m_hwnd, &refresh_rc);
+    MapDialogRect(m_hwnd, &reset_rc);
+    MapDialogRect(m_hwnd, &collect_rc);
+
+    HFONT dialog_font = (HFONT)SendMessage(m_hwnd, WM_GETFONT, 0, 0);
+
+    HWND report = CreateWindowEx(0, L"EDIT", L"",
+        WS_CHILD | WS_VSCROLL | WS_HSCROLL | WS_BORDER | ES_MULTILINE | ES_READONLY | ES_AUTOVSCROLL | ES_AUTOHSCROLL,
+        report_rc.left, report_rc.top, report_rc.right - report_rc.left, report_rc.bottom - report_rc.top,
+        m_hwnd, (HMENU)(INT_PTR)IDC_DIAGNOSTICS_REPORT, g_hIns, nullptr);
+    if (report) {
+        // Fixed pitch so the report columns line up
+        SendMessage(report, WM_SETFONT, (WPARAM)GetStockObject(ANSI_FIXED_FONT), FALSE);
+    }
+
+    HWND refresh = CreateWindowEx(0, L"BUTTON", L"Refresh", WS_CHILD | WS_TABSTOP | BS_PUSHBUTTON,
+        refresh_rc.left, refresh_rc.top, refresh_rc.right - refresh_rc.left, refresh_rc.bottom - refresh_rc.top,
+        m_hwnd, (HMENU)(INT_PTR)IDC_DIAGNOSTICS_REFRESH, g_hIns, nullptr);
+    if (refresh) SendMessage(refresh, WM_SETFONT, (WPARAM)dialog_font, FALSE);
+
+    HWND reset = CreateWindowEx(0, L"BUTTON", L"Reset", WS_CHILD | WS_TABSTOP | BS_PUSHBUTTON,
+        reset_rc.left, reset_rc.top, reset_rc.right - reset_rc.left, reset_rc.bottom - reset_rc.top,
+        m_hwnd, (HMENU)(INT_PTR)IDC_DIAGNOSTICS_RESET, g_hIns, nullptr);
+    if (reset) SendMessage(reset, WM_SETFONT, (WPARAM)dialog_font, FALSE);
+
+    HWND collect = CreateWindowEx(0, L"BUTTON", L"Collect statistics", WS_CHILD | WS_TABSTOP | BS_AUTOCHECKBOX,
+        collect_rc.left, collect_rc.top, collect_rc.right - collect_rc.left, collect_rc.bottom - collect_rc.top,
+        m_hwnd, (HMENU)(INT_PTR)IDC_DIAGNOSTICS_COLLECT, g_hIns, nullptr);
+    if (collect) {
+        SendMessage(collect, WM_SETFONT, (WPARAM)dialog_font, FALSE);
+        SendMessage(collect, BM_SETCHECK, perf_enabled() ? BST_CHECKED : BST_UNCHECKED, 0);
+    }
+}
+
+void tray_preferences::refresh_diagnostics() {
+    if (!m_hwnd) return;
+    pfc::string8 report = perf_format_report();
+    uSetDlgItemText(m_hwnd, IDC_DIAGNOSTICS_REPORT, report);
 }
+#endif
 
 //=============================================================================
 // tray_preferences_page - preferences page factory implementation
@@ -2,8 +2,102 @@
 
 #include "stdafx.h"
 #include "resource.h"
+#include "perf_stats.h"
+#include "display_lines.h"
+#include <memory>
 
-// Configuration access functions
+// Custom font choice for one display mode (artist + track line)
+struct tray_font_setting {
+    bool custom_artist;
+    bool custom_track;
+    LOGFONT artist;
+    LOGFONT track;
+};
+
+// Immutable copy of every setting, with ranges already clamped. Rebuilt from the stored
+// configuration and swapped in by publish_settings() whenever Preferences apply a change,
+// so paint and timer paths read plain fields instead of going through cfg_var storage.
+struct tray_settings {
+    unsigned generation; // Bumped on every publish
+
+    // General
+    bool always_minimize_to_tray;
+    bool double_click_actions;
+    bool show_popup_notification;
+    int popup_position;
+    int popup_duration;             // ms, 1000-10000
+    bool disable_miniplayer;
+    bool disable_slide_to_side;
+    int slide_duration;             // ms
+    bool always_slide_to_side;
+    bool show_volume_feedback;
+
+    // Appearance
+    int theme_mode;                 // 0=Auto, 1=Force Dark, 2=Force Light
+    bool use_rounded_corners;
+    bool show_cover_art;
+    bool cover_margin;
+    int cover_style;                // 0=Square, 1=Rounded
+    int background_style;           // 0=Solid, 1=Artwork Colors, 2=Blurred Artwork
+    int miniplayer_border_style;    // 0=Square, 1=Rounded
+    int ticker_speed;               // 0=Off, 1=Slowest, 2=Slow, 3=Fast, 4=Fastest
+    bool hover_circles;
+    int alternative_icons_style;    // 0=Style 1, 1=Style 2, 2=Style 3
+    COLORREF compact_progress_color;
+    COLORREF volume_osd_color;
+    bool waveform_seekbar;
+    bool spectrum_visualizer;
+    int artwork_crossfade;          // ms, 0=Off
+    bool animated_artwork;
+
+    // MiniPlayer mode sizes
+    int undocked_width;
+    int undocked_height;
+    int compact_width;
+    int compact_height;
+    int expanded_size;
+
+    // Display format scripts
+    pfc::string8 line1_format;
+    pfc::string8 line2_format;
+
+    // Fonts
+    tray_font_setting popup_fonts;
+    tray_font_setting docked_fonts;
+    tray_font_setting undocked_fonts;
+    tray_font_setting expanded_fonts;
+    tray_font_setting compact_fonts;
+    bool custom_timer_font;
+    LOGFONT timer_font;
+};
+
+typedef std::shared_ptr<const tray_settings> tray_settings_ptr;
+
+// What differs between two snapshots, so consumers rebuild only what depends on it
+enum settings_change : unsigned {
+    settings_change_behavior   = 1u << 0, // Read when used (minimize, popup, slide options)
+    settings_change_theme      = 1u << 1, // Theme mode and accent colors
+    settings_change_appearance = 1u << 2, // Cover art, corners, background, icons: redraw only
+    settings_change_ticker     = 1u << 3,
+    settings_change_sizes      = 1u << 4,
+    settings_change_formats    = 1u << 5,
+    settings_change_fonts      = 1u << 6,
+    settings_change_all        = ~0u
+};
+
+// Current snapshot. Main thread: the reference stays valid until the next publish_settings().
+// Hold a get_settings_ptr() copy to keep one across publishes or to read from other threads.
+const tray_settings& get_settings();
+tray_settings_ptr get_settings_ptr();
+
+// Rebuild the snapshot from the stored configuration and publish it (main thread).
+// Returns the settings_change bits that differ from the previously published snapshot.
+unsigned publish_settings();
+
+unsigned diff_settings(const tray_settings& before, const tray_settings& after);
+
+// Configuration access functions. These read the stored configuration directly (Preferences
+// page and cold paths); rendering code reads get_settings().
 bool get_always_minimize_to_tray();
 bool get_double_click_actions();
 bool get_show_popup_notification();
@@ -26,6 +120,12 @@ bool get_hover_circles_enabled(); // true=Show (default), false=Hide
 int get_alternative_icons_style(); // 0=Style 1 (default), 1=Style 2, 2=Style 3
 COLORREF get_compact_progress_color(); // Compact MiniPlayer track progress bar fill color
 COLORREF get_volume_osd_color();       // Volume OSD bar fill color
+bool get_waveform_seekbar(); // Compact MiniPlayer draws the track's waveform as its progress bar
+bool get_spectrum_visualizer(); // Expanded and Compact MiniPlayer draw spectrum bars of the playing audio
+int get_artwork_crossfade(); // Track-change crossfade of the control panel in milliseconds (0=Off)
+bool get_animated_artwork(); // MiniPlayer plays animated (GIF, WebP) covers instead of their first frame
+bool get_perf_stats_enabled(); // Collect timings and counters for the Diagnostics tab (see perf_stats.h)
+void set_perf_stats_enabled(bool enabled); // Saves the choice and switches collection on or off
 
 // MiniPlayer mode size functions
 int get_miniplayer_undocked_width();
@@ -34,11 +134,7 @@ int get_miniplayer_compact_width();
 int get_miniplayer_compact_height();
 int get_miniplayer_expanded_size();
 
-// Display format functions
-pfc::string8 get_line1_format();
-pfc::string8 get_line2_format();
-void format_display_lines(pfc::string8& line1_out, pfc::string8& line2_out);
-void format_display_lines_track(metadb_handle_ptr track, pfc::string8& line1_out, pfc::string8& line2_out);
+// Display format functions: see display_lines.h
 
 // Opens the Preferences dialog at this component's page (General tab is shown first)
 void show_preferences_page();
@@ -98,7 +194,7 @@ private:
     preferences_page_callback::ptr m_callback;
     bool m_has_changes;
     fb2k::CCoreDarkModeHooks m_darkMode;
-    int m_current_tab; // 0 = General, 1 = Appearance, 2 = Icons, 3 = MiniPlayer, 4 = Fonts
+    int m_current_tab; // 0 = General, 1 = Appearance, 2 = Icons, 3 = MiniPlayer, 4 = Fonts, 5 = Diagnostics (hidden)
     
 public:
     tray_preferences(preferences_page_callback::ptr callback);
@@ -132,6 +228,12 @@ private:
     void select_font_for_mode(int mode, bool is_artist); // mode: 1=undocked, 2=expanded, 3=compact
     void select_timer_font();
     void reset_all_fonts_to_default();
+
+#if TRAYCONTROLS_PERF_STATS
+    // Hidden Diagnostics tab: shown only when Shift is held while the page opens
+    void create_diagnostics_controls();
+    void refresh_diagnostics();
+#endif
 };
 
 // Preferences page factory
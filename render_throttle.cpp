@@ -0,0 +1,179 @@
+#include "stdafx.h"
+#include "render_throttle.h"
+#include <dwmapi.h>
+#include <wtsapi32.h>
+#pragma comment(lib, "dwmapi.lib")
+#pragma comment(lib, "wtsapi32.lib")
+
+// Power setting GUIDs, spelled out so no initguid/uuid.lib dance is needed
+// GUID_CONSOLE_DISPLAY_STATE: 0 = off, 1 = on, 2 = dimmed
+static const GUID g_console_display_state =
+    { 0x6fe69556, 0x704a, 0x47a0, { 0x8f, 0x24, 0xc2, 0x8d, 0x93, 0x6f, 0xda, 0x47 } };
+// GUID_POWER_SAVING_STATUS: 0 = battery saver off, 1 = on
+static const GUID g_power_saving_status =
+    { 0xe00958c0, 0xc213, 0x4ace, { 0xac, 0x77, 0xfe, 0xcc, 0xed, 0x2e, 0xee, 0xa5 } };
+
+// Slowest the progress bar may tick while the panel is still visible but throttled
+static const UINT THROTTLED_PROGRESS_INTERVAL = 2000; // ms
+
+render_throttle::render_throttle()
+    : m_hwnd(nullptr)
+    , m_display_notify(nullptr)
+    , m_saver_notify(nullptr)
+    , m_session_registered(false)
+    , m_reasons(0) {
+}
+
+render_throttle::~render_throttle() {
+    detach();
+}
+
+void render_throttle::attach(HWND hwnd) {
+    detach();
+    if (!hwnd) return;
+    m_hwnd = hwnd;
+
+    m_session_registered = WTSRegisterSessionNotification(hwnd, NOTIFY_FOR_THIS_SESSION) != FALSE;
+
+    // Both registrations immediately deliver the current value as a PBT_POWERSETTINGCHANGE.
+    // Battery saver is Windows 10+; older systems just fail the registration.
+    m_display_notify = RegisterPowerSettingNotification(hwnd, &g_console_display_state, DEVICE_NOTIFY_WINDOW_HANDLE);
+    m_saver_notify = RegisterPowerSettingNotification(hwnd, &g_power_saving_status, DEVICE_NOTIFY_WINDOW_HANDLE);
+}
+
+void render_throttle::detach() {
+    if (m_display_notify) {
+        UnregisterPowerSettingNotification(m_display_notify);
+        m_display_notify = nullptr;
+    }
+    if (m_saver_notify) {
+        UnregisterPowerSettingNotification(m_saver_notify);
+        m_saver_notify = nullptr;
+    }
+    if (m_session_registered) {
+        WTSUnRegisterSessionNotification(m_hwnd);
+        m_session_registered = false;
+    }
+    m_hwnd = nullptr;
+    m_reasons = 0;
+}
+
+bool render_throttle::handle_message(UINT msg, WPARAM wparam, LPARAM lparam) {
+    if (msg == WM_WTSSESSION_CHANGE) {
+        switch (wparam) {
+        case WTS_SESSION_LOCK:
+        case WTS_CONSOLE_DISCONNECT:
+        case WTS_REMOTE_DISCONNECT:
+            set_reason(render_throttle_locked, true);
+            break;
+        case WTS_SESSION_UNLOCK:
+        case WTS_CONSOLE_CONNECT:
+        case WTS_REMOTE_CONNECT:
+            set_reason(render_throttle_locked, false);
+            break;
+        }
+        return true;
+    }
+
+    if (msg == WM_POWERBROADCAST) {
+        if (wparam == PBT_POWERSETTINGCHANGE && lparam) {
+            const POWERBROADCAST_SETTING* setting = reinterpret_cast<const POWERBROADCAST_SETTING*>(lparam);
+            if (setting->DataLength >= sizeof(DWORD)) {
+                DWORD value = *reinterpret_cast<const DWORD*>(setting->Data);
+                if (IsEqualGUID(setting->PowerSetting, g_console_display_state)) {
+                    set_reason(render_throttle_display_off, value == 0);
+                } else if (IsEqualGUID(setting->PowerSetting, g_power_saving_status)) {
+                    set_reason(render_throttle_battery_saver, value != 0);
+                }
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+static bool is_window_cloaked(HWND hwnd) {
+    DWORD cloaked = 0;
+    return SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked != 0;
+}
+
+// True if a window above us paints an opaque rectangle over its bounds. Click-through and
+// translucent overlays (including per-pixel-alpha layered windows, whose shape is unknown) do not count.
+static bool is_opaque_cover(HWND hwnd) {
+    if (!IsWindowVisible(hwnd) || IsIconic(hwnd) || is_window_cloaked(hwnd)) return false;
+
+    LONG_PTR ex_style = GetWindowLongPtr(hwnd, GWL_EXSTYLE);
+    if (ex_style & WS_EX_TRANSPARENT) return false;
+    if (ex_style & WS_EX_LAYERED) {
+        BYTE alpha = 255;
+        DWORD flags = 0;
+        if (!GetLayeredWindowAttributes(hwnd, nullptr, &alpha, &flags)) return false;
+        if ((flags & LWA_COLORKEY) || ((flags & LWA_ALPHA) && alpha < 255)) return false;
+    }
+    return true;
+}
+
+static void get_visible_bounds(HWND hwnd, RECT& rect) {
+    // Skip the invisible resize borders DWM adds around normal frames
+    if (FAILED(DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &rect, sizeof(rect)))) {
+        GetWindowRect(hwnd, &rect);
+    }
+}
+
+void render_throttle::refresh_visibility() {
+    if (!m_hwnd || !IsWindowVisible(m_hwnd)) {
+        set_reason(render_throttle_cloaked, false);
+        set_reason(render_throttle_occluded, false);
+        return;
+    }
+
+    set_reason(render_throttle_cloaked, is_window_cloaked(m_hwnd));
+
+    // Subtract every window above ours from our on-screen rectangle. The panel is topmost, so
+    // only the (few) other topmost windows are walked.
+    RECT bounds;
+    GetWindowRect(m_hwnd, &bounds);
+    RECT screen = { GetSystemMetrics(SM_XVIRTUALSCREEN), GetSystemMetrics(SM_YVIRTUALSCREEN), 0, 0 };
+    screen.right = screen.left + GetSystemMetrics(SM_CXVIRTUALSCREEN);
+    screen.bottom = screen.top + GetSystemMetrics(SM_CYVIRTUALSCREEN);
+
+    bool occluded = false;
+    RECT on_screen;
+    if (!IntersectRect(&on_screen, &bounds, &screen)) {
+        occluded = true;
+    } else {
+        HRGN visible = CreateRectRgnIndirect(&on_screen);
+        if (visible) {
+            for (HWND above = GetWindow(m_hwnd, GW_HWNDPREV); above; above = GetWindow(above, GW_HWNDPREV)) {
+                if (!is_opaque_cover(above)) continue;
+                RECT cover_rect;
+                get_visible_bounds(above, cover_rect);
+                HRGN cover = CreateRectRgnIndirect(&cover_rect);
+                if (!cover) break;
+                int result = CombineRgn(visible, visible, cover, RGN_DIFF);
+                DeleteObject(cover);
+                if (result == NULLREGION) {
+                    occluded = true;
+                    break;
+                }
+            }
+            DeleteObject(visible);
+        }
+    }
+    set_reason(render_throttle_occluded, occluded);
+}
+
+void render_throttle::set_reason(render_throttle_reason reason, bool active) {
+    if (active) {
+        m_reasons |= reason;
+    } else {
+        m_reasons &= ~(unsigned)reason;
+    }
+}
+
+UINT render_throttle::get_progress_interval(UINT base_ms) const {
+    if (base_ms == 0 || is_suspended()) return 0;
+    if (is_throttled() && base_ms < THROTTLED_PROGRESS_INTERVAL) return THROTTLED_PROGRESS_INTERVAL;
+    return base_ms;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Why the control panel's frames are currently worth less than usual. Tracked as a bit set
+// so overlapping causes (e.g. locked while peeking) release independently.
+enum render_throttle_reason : unsigned {
+    // Nothing of the window can be seen: draw nothing, stop the progress timer
+    render_throttle_occluded      = 1u << 0, // Covered by other topmost windows
+    render_throttle_cloaked       = 1u << 1, // DWM cloaked (other virtual desktop, shell transitions)
+    render_throttle_locked        = 1u << 2, // Workstation locked / session disconnected
+    render_throttle_display_off   = 1u << 3, // Console display powered off
+    // Still visible but low priority: no ticker, slow progress updates
+    render_throttle_peeking       = 1u << 4, // Slid to the screen edge with only the peek strip showing
+    render_throttle_battery_saver = 1u << 5  // Windows battery saver is on
+};
+
+static const unsigned render_throttle_hidden_mask =
+    render_throttle_occluded | render_throttle_cloaked | render_throttle_locked | render_throttle_display_off;
+
+// Visibility and power state of one window, fed by session/power notifications and by
+// on-demand occlusion checks. Owns no timers; the window decides what to do with the state.
+class render_throttle {
+public:
+    render_throttle();
+    ~render_throttle();
+
+    // Register hwnd for WM_WTSSESSION_CHANGE and WM_POWERBROADCAST (display state, battery saver)
+    void attach(HWND hwnd);
+    void detach();
+
+    // Update from a window message; returns true if the message was a session/power message
+    bool handle_message(UINT msg, WPARAM wparam, LPARAM lparam);
+
+    // Re-check DWM cloaking and occlusion of the attached window by the windows above it
+    void refresh_visibility();
+
+    void set_reason(render_throttle_reason reason, bool active);
+    unsigned get_reasons() const { return m_reasons; }
+
+    bool is_suspended() const { return (m_reasons & render_throttle_hidden_mask) != 0; }
+    bool is_throttled() const { return m_reasons != 0; }
+
+    // Progress timer interval for a window that normally updates every base_ms (0 = no timer)
+    UINT get_progress_interval(UINT base_ms) const;
+
+private:
+    HWND m_hwnd;
+    HPOWERNOTIFY m_display_notify;
+    HPOWERNOTIFY m_saver_notify;
+    bool m_session_registered;
+    unsigned m_reasons;
+
+    render_throttle(const render_throttle&) = delete;
+    render_throttle& operator=(const render_throttle&) = delete;
+};
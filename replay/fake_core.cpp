@@ -0,0 +1,105 @@
+#include "../stdafx.h"
+#include <SDK/component.h>
+#include "../main_thread_timer.h"
+#include "fake_core.h"
+#include <map>
+
+namespace {
+    // The core's service registry over the factories linked into this binary; a class is
+    // referred to by the GUID of its first factory
+    class fake_api : public foobar2000_api {
+    public:
+        service_class_ref service_enum_find_class(const GUID& p_guid) override {
+            for (service_factory_base* f = service_factory_base::__internal__list; f; f = f->__internal__next) {
+                if (f->get_class_guid() == p_guid) return &f->get_class_guid();
+            }
+            return nullptr;
+        }
+        bool service_enum_create(service_ptr_t<service_base>& p_out, service_class_ref p_class, t_size p_index) override {
+            service_factory_base* f = find_factory(p_class, p_index);
+            if (!f) return false;
+            f->instance_create(p_out);
+            return true;
+        }
+        t_size service_enum_get_count(service_class_ref p_class) override {
+            t_size count = 0;
+            while (find_factory(p_class, count)) count++;
+            return count;
+        }
+        fb2k::hwnd_t get_main_window() override { return nullptr; }
+        bool assert_main_thread() override { return true; }
+        bool is_main_thread() override { return true; }
+        bool is_shutting_down() override { return false; }
+        const char* get_profile_path() override { return "file:///tmp"; }
+        bool is_initializing() override { return false; }
+        bool is_portable_mode_enabled() override { return false; }
+        bool is_quiet_mode_enabled() override { return true; }
+
+    private:
+        static service_factory_base* find_factory(service_class_ref p_class, t_size p_index) {
+            if (!p_class) return nullptr;
+            const GUID& guid = *static_cast<const GUID*>(p_class);
+            for (service_factory_base* f = service_factory_base::__internal__list; f; f = f->__internal__next) {
+                if (f->get_class_guid() == guid && p_index-- == 0) return f;
+            }
+            return nullptr;
+        }
+    };
+
+    struct pending_timer {
+        main_thread_timer_id id;
+        main_thread_timer_proc proc;
+    };
+}
+
+static fake_api g_api;
+static uint64_t g_now_ms = 0;
+static main_thread_timer_id g_next_timer_id = 1;
+
+// By deadline, then by start order, like WM_TIMER for timers due together
+static std::multimap<uint64_t, pending_timer> g_timers;
+
+void fake_core_install() {
+    g_foobar2000_api = &g_api;
+}
+
+uint64_t fake_core_now_ms() {
+    return g_now_ms;
+}
+
+void fake_core_advance_to(uint64_t time_ms) {
+    while (!g_timers.empty() && g_timers.begin()->first <= time_ms) {
+        auto it = g_timers.begin();
+        if (it->first > g_now_ms) g_now_ms = it->first;
+        main_thread_timer_proc proc = it->second.proc;
+        g_timers.erase(it);
+        proc();
+    }
+    if (time_ms > g_now_ms) g_now_ms = time_ms;
+}
+
+size_t fake_core_pending_timers() {
+    return g_timers.size();
+}
+
+void stop_main_thread_timer(main_thread_timer_id id) {
+    if (!id) return;
+    for (auto it = g_timers.begin(); it != g_timers.end(); ++it) {
+        if (it->second.id == id) {
+            g_timers.erase(it);
+            return;
+        }
+    }
+}
+
+main_thread_timer_id start_main_thread_timer(main_thread_timer_id id, unsigned delay_ms, main_thread_timer_proc proc) {
+    bool pending = false;
+    for (const auto& entry : g_timers) pending |= entry.second.id == id;
+    if (id && pending) {
+        stop_main_thread_timer(id);
+    } else {
+        id = g_next_timer_id++;
+    }
+    g_timers.insert({ g_now_ms + delay_ms, pending_timer{ id, proc } });
+    return id;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Stand-in for the foobar2000 core on Linux: serves the services registered in this process
+// (stub_services.cpp) through the SDK's service enumeration, and runs one main thread on a
+// simulated clock. main_thread_timer.h timers fire when the clock passes their deadline, so a
+// replay runs as fast as the handlers allow while deferred work lands in script order.
+
+#include <cstdint>
+
+// Make the services of this process available; call once before any service is used
+void fake_core_install();
+
+// Simulated time in ms since the start
+uint64_t fake_core_now_ms();
+
+// Fire every timer due by time_ms in deadline order, moving the clock to each; the clock then
+// stays at time_ms
+void fake_core_advance_to(uint64_t time_ms);
+
+// Timers still pending
+size_t fake_core_pending_timers();
@@ -0,0 +1,189 @@
+// Replays recorded playback event scripts (replay_script.h) through the component's playback
+// handlers against stub SDK services, on a simulated clock, and reports main-thread CPU time,
+// wall time and work counters per event type, as the in-process replay (event_replay.cpp) does
+// on Windows. Everything from dispatching an event until the next one is attributed to it, so
+// settle windows and coalesced refreshes are included.
+//
+//   event_replay <script>
+//
+// A script can state the work it should cost with "# expect <counter> <total>" comment lines,
+// counters named as in the report with spaces as underscores (e.g. "# expect new_tracks 1").
+// The exit code is 1 when an expectation is not met or deferred work is still pending after
+// the final settle window, 2 for an unreadable or malformed script.
+
+#include "../playback_events.h"
+#include "../replay_script.h"
+#include "../stream_metadata.h"
+#include "../track_notification.h"
+#include "fake_core.h"
+#include "stub_services.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <time.h>
+
+// Time given to the last event's deferred work before reporting, as in event_replay.cpp
+static const uint32_t REPLAY_SETTLE_MS = 500;
+
+struct replay_sample {
+    uint64_t cpu_us;
+    std::chrono::steady_clock::time_point wall;
+    uint64_t counters[replay_counter_count];
+};
+
+static replay_sample take_sample() {
+    replay_sample sample;
+    timespec cpu;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    sample.cpu_us = (uint64_t)cpu.tv_sec * 1000000 + (uint64_t)cpu.tv_nsec / 1000;
+    sample.wall = std::chrono::steady_clock::now();
+    for (int i = 0; i < replay_counter_count; i++) sample.counters[i] = g_replay_counters[i];
+    return sample;
+}
+
+static void add_event_cost(replay_stats& stats, replay_event_type type, const replay_sample& start) {
+    replay_sample now = take_sample();
+    std::vector<uint64_t> deltas(replay_counter_count);
+    for (int i = 0; i < replay_counter_count; i++) deltas[i] = now.counters[i] - start.counters[i];
+    uint64_t wall_us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now.wall - start.wall).count();
+    stats.add(type, now.cpu_us - start.cpu_us, wall_us, deltas);
+}
+
+// What the core does before and while notifying the component
+static void dispatch_event(const replay_event& e) {
+    switch (e.type) {
+    case replay_event_track: {
+        metadb_handle_ptr track = metadb::get()->handle_create(e.text.c_str(), 0);
+        stub_playback_set_state(track, false);
+        handle_playback_new_track(track);
+        break;
+    }
+    case replay_event_icy: {
+        file_info_impl info;
+        info.meta_set("STREAMTITLE", e.text.c_str());
+        on_stream_dynamic_info(info);
+        break;
+    }
+    case replay_event_pause: {
+        metadb_handle_ptr track;
+        playback_control::get()->get_now_playing(track);
+        stub_playback_set_state(track, e.value != 0.0);
+        handle_playback_pause(e.value != 0.0);
+        break;
+    }
+    case replay_event_seek:
+        // The component does not react to seeks; replayed so the script stays faithful
+        break;
+    case replay_event_stop:
+        stub_playback_set_state(nullptr, false);
+        handle_playback_stop(play_control::stop_reason_user);
+        break;
+    case replay_event_metadb: {
+        metadb_handle_ptr track;
+        if (!playback_control::get()->get_now_playing(track)) break;
+        metadb_handle_list items;
+        items.add_item(track);
+        for (unsigned i = 0; i < (unsigned)e.value; i++) handle_metadb_changed(items);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+struct replay_expectation {
+    std::string counter;
+    uint64_t total;
+};
+
+static bool parse_expectations(const std::string& script, std::vector<replay_expectation>& out, std::string& error) {
+    std::istringstream lines(script);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream words(line);
+        std::string hash, keyword;
+        if (!(words >> hash >> keyword) || hash != "#" || keyword != "expect") continue;
+        replay_expectation expectation;
+        if (!(words >> expectation.counter >> expectation.total)) {
+            error = "bad expectation: " + line;
+            return false;
+        }
+        for (char& c : expectation.counter) {
+            if (c == '_') c = ' ';
+        }
+        out.push_back(expectation);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: event_replay <script>\n");
+        return 2;
+    }
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "could not read %s\n", argv[1]);
+        return 2;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string script = buffer.str();
+
+    std::vector<replay_event> events;
+    std::vector<replay_expectation> expectations;
+    std::string error;
+    if (!parse_replay_script(script, events, error) || !parse_expectations(script, expectations, error)) {
+        fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+        return 2;
+    }
+    if (events.empty()) {
+        fprintf(stderr, "%s: no events\n", argv[1]);
+        return 2;
+    }
+
+    fake_core_install();
+    start_metadb_notifications();
+
+    std::vector<const char*> counter_names;
+    for (int i = 0; i < replay_counter_count; i++) counter_names.push_back(get_replay_counter_name((replay_counter)i));
+    replay_stats stats(counter_names);
+
+    replay_sample open_sample = take_sample();
+    for (size_t i = 0; i < events.size(); i++) {
+        // Deferred work due before this event still belongs to the previous one
+        fake_core_advance_to(events[i].time_ms);
+        if (i > 0) add_event_cost(stats, events[i - 1].type, open_sample);
+        open_sample = take_sample();
+        dispatch_event(events[i]);
+    }
+    fake_core_advance_to(events.back().time_ms + REPLAY_SETTLE_MS);
+    add_event_cost(stats, events.back().type, open_sample);
+    size_t pending = fake_core_pending_timers();
+
+    printf("%s: %zu events over %u ms\n%s", argv[1], events.size(), events.back().time_ms, stats.format_report().c_str());
+
+    bool passed = true;
+    for (const replay_expectation& expectation : expectations) {
+        int counter = 0;
+        while (counter < replay_counter_count && expectation.counter != get_replay_counter_name((replay_counter)counter)) counter++;
+        if (counter == replay_counter_count) {
+            fprintf(stderr, "unknown counter \"%s\"\n", expectation.counter.c_str());
+            passed = false;
+        } else if (g_replay_counters[counter] != expectation.total) {
+            fprintf(stderr, "%s: %llu, expected %llu\n", expectation.counter.c_str(),
+                (unsigned long long)g_replay_counters[counter], (unsigned long long)expectation.total);
+            passed = false;
+        }
+    }
+    if (pending > 0) {
+        fprintf(stderr, "%zu timers still pending %u ms after the last event\n", pending, REPLAY_SETTLE_MS);
+        passed = false;
+    }
+
+    stop_metadb_notifications();
+    reset_stream_metadata();
+    reset_track_notification();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+#include "stub_services.h"
+#include <SDK/metadb_info_container_impl.h>
+#include <map>
+#include <string>
+
+uint64_t g_replay_counters[replay_counter_count];
+
+const char* get_replay_counter_name(replay_counter counter) {
+    static const char* const names[replay_counter_count] = {
+        "new tracks", "stream updates", "refreshes", "state updates", "title formats"
+    };
+    return counter < replay_counter_count ? names[counter] : "";
+}
+
+namespace {
+    // %field% from the track's tags, %filename% and %path%. %title% falls back to the file name
+    // as it does in the core; other missing fields are not found.
+    class stub_titleformat_hook : public titleformat_hook {
+    public:
+        stub_titleformat_hook(const playable_location& location, const file_info& info)
+            : m_location(location), m_info(info) {}
+
+        bool process_field(titleformat_text_out* p_out, const char* p_name, t_size p_name_length, bool& p_found_flag) override {
+            pfc::string8 name(p_name, p_name_length);
+            p_found_flag = false;
+            if (pfc::stringEqualsI_ascii(name, "filename")) {
+                pfc::string8 file = pfc::string_filename(m_location.get_path());
+                p_out->write(titleformat_inputtypes::unknown, file.c_str());
+                p_found_flag = true;
+            } else if (pfc::stringEqualsI_ascii(name, "path")) {
+                p_out->write(titleformat_inputtypes::unknown, m_location.get_path());
+                p_found_flag = true;
+            } else {
+                const char* value = m_info.meta_get(name, 0);
+                if (value) {
+                    p_out->write(titleformat_inputtypes::meta, value);
+                    p_found_flag = true;
+                } else if (pfc::stringEqualsI_ascii(name, "title")) {
+                    pfc::string8 file = pfc::string_filename(m_location.get_path());
+                    p_out->write(titleformat_inputtypes::unknown, file.c_str());
+                    p_found_flag = true;
+                }
+            }
+            return true;
+        }
+
+        bool process_function(titleformat_text_out*, const char*, t_size, titleformat_hook_function_params*, bool& p_found_flag) override {
+            p_found_flag = false;
+            return false;
+        }
+
+    private:
+        const playable_location& m_location;
+        const file_info& m_info;
+    };
+
+    class string_text_out : public titleformat_text_out {
+    public:
+        explicit string_text_out(pfc::string_base& out) : m_out(out) {}
+        void write(const GUID&, const char* p_data, t_size p_data_length) override {
+            m_out.add_string(p_data, p_data_length);
+        }
+
+    private:
+        pfc::string_base& m_out;
+    };
+
+    // Literal text and %field% references; [], ' and $functions are not interpreted
+    class stub_titleformat_object : public titleformat_object {
+    public:
+        explicit stub_titleformat_object(const char* spec) : m_spec(spec) {}
+
+        void run(titleformat_hook* p_source, pfc::string_base& p_out, titleformat_text_filter*) override {
+            g_replay_counters[replay_counter_title_formats]++;
+            p_out.reset();
+            string_text_out out(p_out);
+            const char* p = m_spec.c_str();
+            while (*p) {
+                const char* field = p[0] == '%' ? strchr(p + 1, '%') : nullptr;
+                if (!field) {
+                    const char* next = strchr(p + 1, '%');
+                    size_t length = next ? (size_t)(next - p) : strlen(p);
+                    p_out.add_string(p, length);
+                    p += length;
+                    continue;
+                }
+                bool found = false;
+                if (p_source) p_source->process_field(&out, p + 1, field - p - 1, found);
+                if (!found) p_out.add_string("?");
+                p = field + 1;
+            }
+        }
+
+    private:
+        pfc::string8 m_spec;
+    };
+
+    class stub_titleformat_compiler : public titleformat_compiler {
+    public:
+        bool compile(titleformat_object::ptr& p_out, const char* p_spec) override {
+            p_out = new service_impl_t<stub_titleformat_object>(p_spec);
+            return true;
+        }
+    };
+
+    class stub_metadb_handle : public metadb_handle {
+    public:
+        explicit stub_metadb_handle(const char* path) {
+            m_location.set_path(path);
+            m_location.set_subsong(0);
+            m_info_ref = new service_impl_t<metadb_info_container_const_impl>();
+        }
+
+        const playable_location& get_location() const override { return m_location; }
+
+        bool format_title(titleformat_hook* p_hook, pfc::string_base& p_out, const service_ptr_t<titleformat_object>& p_script, titleformat_text_filter* p_filter) override {
+            format_title_from_external_info(info(), p_hook, p_out, p_script, p_filter);
+            return true;
+        }
+        void format_title_from_external_info(const file_info& p_info, titleformat_hook* p_hook, pfc::string_base& p_out, const service_ptr_t<titleformat_object>& p_script, titleformat_text_filter* p_filter) override {
+            if (p_script.is_empty()) {
+                p_out.reset();
+                return;
+            }
+            stub_titleformat_hook track_hook(m_location, p_info);
+            titleformat_hook_impl_splitter hook(p_hook, &track_hook);
+            p_script->run(&hook, p_out, p_filter);
+        }
+        bool format_title_nonlocking(titleformat_hook* p_hook, pfc::string_base& p_out, const service_ptr_t<titleformat_object>& p_script, titleformat_text_filter* p_filter) override {
+            return format_title(p_hook, p_out, p_script, p_filter);
+        }
+        void format_title_from_external_info_nonlocking(const file_info& p_info, titleformat_hook* p_hook, pfc::string_base& p_out, const service_ptr_t<titleformat_object>& p_script, titleformat_text_filter* p_filter) override {
+            format_title_from_external_info(p_info, p_hook, p_out, p_script, p_filter);
+        }
+
+        void metadb_lock() override {}
+        void metadb_unlock() override {}
+        t_filestats get_filestats() const override { return filestats_invalid; }
+
+        bool is_info_loaded() const override { return true; }
+        bool get_info(file_info& p_info) const override { p_info = info(); return true; }
+        bool get_info_locked(const file_info*& p_info) const override { p_info = &info(); return true; }
+        bool is_info_loaded_async() const override { return true; }
+        bool get_info_async(file_info& p_info) const override { return get_info(p_info); }
+        bool get_info_async_locked(const file_info*& p_info) const override { return get_info_locked(p_info); }
+        bool get_browse_info(file_info&, t_filetimestamp&) const override { return false; }
+        bool get_browse_info_locked(const file_info*&, t_filetimestamp&) const override { return false; }
+
+        bool get_info_ref(metadb_info_container::ptr& outInfo) const override { outInfo = m_info_ref; return true; }
+        bool get_async_info_ref(metadb_info_container::ptr& outInfo) const override { return get_info_ref(outInfo); }
+        void get_browse_info_ref(metadb_info_container::ptr& outInfo, metadb_info_container::ptr& outBrowse) const override {
+            outInfo = m_info_ref;
+            outBrowse.release();
+        }
+        metadb_info_container::ptr get_info_ref() const override { return m_info_ref; }
+        metadb_info_container::ptr get_async_info_ref() const override { return m_info_ref; }
+
+    private:
+        const file_info& info() const { return m_info_ref->info(); }
+
+        playable_location_impl m_location;
+        metadb_info_container::ptr m_info_ref;
+    };
+
+    // One handle per location, as the real database hands out: handles compare by pointer
+    class stub_metadb : public metadb {
+    public:
+        void database_lock() override {}
+        void database_unlock() override {}
+        void handle_create(metadb_handle_ptr& p_out, const playable_location& p_location) override {
+            std::string key = p_location.get_path();
+            key += '|';
+            key += std::to_string(p_location.get_subsong());
+            metadb_handle_ptr& handle = m_handles[key];
+            if (handle.is_empty()) handle = new service_impl_t<stub_metadb_handle>(p_location.get_path());
+            p_out = handle;
+        }
+
+    private:
+        std::map<std::string, metadb_handle_ptr> m_handles;
+    };
+
+    metadb_handle_ptr g_now_playing;
+    bool g_paused = false;
+
+    class stub_playback_control : public playback_control {
+    public:
+        bool get_now_playing(metadb_handle_ptr& p_out) override {
+            p_out = g_now_playing;
+            return g_now_playing.is_valid();
+        }
+        void start(t_track_command, bool) override {}
+        void stop() override {}
+        bool is_playing() override { return g_now_playing.is_valid(); }
+        bool is_paused() override { return g_now_playing.is_valid() && g_paused; }
+        void pause(bool) override {}
+        bool get_stop_after_current() override { return false; }
+        void set_stop_after_current(bool) override {}
+        void set_volume(float) override {}
+        float get_volume() override { return 0; }
+        void volume_up() override {}
+        void volume_down() override {}
+        void volume_mute_toggle() override {}
+        void playback_seek(double) override {}
+        void playback_seek_delta(double) override {}
+        bool playback_can_seek() override { return true; }
+        double playback_get_position() override { return 0; }
+        bool playback_format_title(titleformat_hook* p_hook, pfc::string_base& p_out, const service_ptr_t<titleformat_object>& p_script, titleformat_text_filter* p_filter, t_display_level) override {
+            if (g_now_playing.is_empty()) return false;
+            return g_now_playing->format_title(p_hook, p_out, p_script, p_filter);
+        }
+    };
+
+    std::vector<metadb_io_callback_dynamic*> g_metadb_callbacks;
+
+    class stub_metadb_io : public metadb_io_v3 {
+    public:
+        void register_callback(metadb_io_callback_dynamic* p_callback) override { g_metadb_callbacks.push_back(p_callback); }
+        void unregister_callback(metadb_io_callback_dynamic* p_callback) override {
+            g_metadb_callbacks.erase(std::remove(g_metadb_callbacks.begin(), g_metadb_callbacks.end(), p_callback), g_metadb_callbacks.end());
+        }
+
+        // Tag reading and writing are not part of a replay
+        bool is_busy() override { return false; }
+        bool is_updating_disabled() override { return false; }
+        bool is_file_updating_blocked() override { return false; }
+        void highlight_running_process() override {}
+        t_load_info_state load_info_multi(metadb_handle_list_cref, t_load_info_type, fb2k::hwnd_t, bool) override { return load_info_aborted; }
+        t_update_info_state update_info_multi(metadb_handle_list_cref, const pfc::list_base_const_t<file_info*>&, fb2k::hwnd_t, bool) override { return update_info_aborted; }
+        t_update_info_state rewrite_info_multi(metadb_handle_list_cref, fb2k::hwnd_t, bool) override { return update_info_aborted; }
+        t_update_info_state remove_info_multi(metadb_handle_list_cref, fb2k::hwnd_t, bool) override { return update_info_aborted; }
+        void hint_multi(metadb_handle_list_cref, const pfc::list_base_const_t<const file_info*>&, const pfc::list_base_const_t<t_filestats>&, const bit_array&) override {}
+        void hint_multi_async(metadb_handle_list_cref, const pfc::list_base_const_t<const file_info*>&, const pfc::list_base_const_t<t_filestats>&, const bit_array&) override {}
+        void hint_reader(service_ptr_t<class input_info_reader>, const char*, abort_callback&) override {}
+        void path_to_handles_simple(const char* p_path, pfc::list_base_t<metadb_handle_ptr>& p_out) override {
+            p_out.add_item(metadb::get()->handle_create(p_path, 0));
+        }
+        void dispatch_refresh(metadb_handle_list_cref p_list) override {
+            for (metadb_io_callback_dynamic* callback : g_metadb_callbacks) callback->on_changed_sorted(p_list, false);
+        }
+        void load_info_async(metadb_handle_list_cref, t_load_info_type, fb2k::hwnd_t, t_uint32, completion_notify_ptr) override {}
+        void update_info_async(metadb_handle_list_cref, service_ptr_t<file_info_filter>, fb2k::hwnd_t, t_uint32, completion_notify_ptr) override {}
+        void rewrite_info_async(metadb_handle_list_cref, fb2k::hwnd_t, t_uint32, completion_notify_ptr) override {}
+        void remove_info_async(metadb_handle_list_cref, fb2k::hwnd_t, t_uint32, completion_notify_ptr) override {}
+        metadb_hint_list::ptr create_hint_list() override { return nullptr; }
+    };
+}
+
+void stub_playback_set_state(metadb_handle_ptr track, bool paused) {
+    g_now_playing = track;
+    g_paused = paused;
+}
+
+size_t stub_metadb_callback_count() {
+    return g_metadb_callbacks.size();
+}
+
+FB2K_SERVICE_FACTORY(stub_titleformat_compiler);
+FB2K_SERVICE_FACTORY(stub_metadb);
+FB2K_SERVICE_FACTORY(stub_playback_control);
+FB2K_SERVICE_FACTORY(stub_metadb_io);
@@ -0,0 +1,30 @@
+#pragma once
+
+// SDK services the playback pipeline reaches, stubbed for the Linux replay harness:
+// playback_control (now playing and play state, set by the replay), metadb and metadb_handle
+// (one handle per path, no tags, so display lines fall back to the file name),
+// titleformat_compiler (%field% substitution only) and metadb_io_v3 (callback registration).
+// Album art, playlists and the rest are only reached from the windows, which do not build here.
+
+#include "../stdafx.h"
+
+// Work counted while replaying, next to the calls the windows receive (stub_ui.cpp)
+enum replay_counter {
+    replay_counter_new_tracks,      // settled track changes shown (playback_ui_new_track)
+    replay_counter_stream_updates,  // stream titles shown (playback_ui_stream_metadata)
+    replay_counter_refreshes,       // now-playing refreshes after tag changes
+    replay_counter_state_updates,   // play state, popup and tag-edit updates
+    replay_counter_title_formats,   // title formatting scripts run
+    replay_counter_count
+};
+
+extern uint64_t g_replay_counters[replay_counter_count];
+
+// Display names, as replay_stats takes them
+const char* get_replay_counter_name(replay_counter counter);
+
+// What playback_control reports; a null track means stopped
+void stub_playback_set_state(metadb_handle_ptr track, bool paused);
+
+// Dynamic metadb callbacks registered through metadb_io_v3
+size_t stub_metadb_callback_count();
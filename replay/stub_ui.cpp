@@ -0,0 +1,46 @@
+#include "stub_services.h"
+#include "../playback_ui.h"
+#include "../display_lines.h"
+#include "../stream_metadata.h"
+
+// The windows, reduced to counting what they are asked to show. Each call stands for the
+// tooltip, control panel and popup work it triggers in the component.
+
+void playback_ui_new_track(metadb_handle_ptr) {
+    g_replay_counters[replay_counter_new_tracks]++;
+}
+
+void playback_ui_cancel_artwork() {}
+
+void playback_ui_state(const char*) {
+    g_replay_counters[replay_counter_state_updates]++;
+}
+
+void playback_ui_hide_popup() {
+    g_replay_counters[replay_counter_state_updates]++;
+}
+
+void playback_ui_track_edited(metadb_handle_ptr) {
+    g_replay_counters[replay_counter_state_updates]++;
+}
+
+void playback_ui_now_playing_changed(metadb_handle_ptr) {
+    g_replay_counters[replay_counter_refreshes]++;
+}
+
+void playback_ui_tracks_changed(metadb_handle_list_cref) {}
+
+void playback_ui_stream_metadata(stream_metadata& meta) {
+    // No foo_artwork to ask
+    meta.artwork_requested = false;
+    g_replay_counters[replay_counter_stream_updates]++;
+}
+
+// Preferences are not stored here; the default scripts apply
+pfc::string8 get_line1_format() {
+    return "%title%";
+}
+
+pfc::string8 get_line2_format() {
+    return "%artist%";
+}
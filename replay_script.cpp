@@ -0,0 +1,149 @@
+#include "replay_script.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const char* const g_type_names[replay_event_type_count] = {
+    "track",
+    "icy",
+    "pause",
+    "seek",
+    "stop",
+    "metadb"
+};
+
+const char* get_replay_event_type_name(replay_event_type type) {
+    if (type < 0 || type >= replay_event_type_count) return "?";
+    return g_type_names[type];
+}
+
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return std::string();
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Splits off the first whitespace-delimited word; rest receives the trimmed remainder
+static std::string next_word(const std::string& line, std::string& rest) {
+    size_t end = line.find_first_of(" \t");
+    if (end == std::string::npos) {
+        rest.clear();
+        return line;
+    }
+    rest = trim(line.substr(end));
+    return line.substr(0, end);
+}
+
+static bool parse_number(const std::string& text, double& out) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    out = strtod(text.c_str(), &end);
+    return end && *end == '\0';
+}
+
+bool parse_replay_script(const std::string& script, std::vector<replay_event>& out, std::string& error) {
+    out.clear();
+    error.clear();
+
+    uint32_t last_time = 0;
+    size_t line_number = 0;
+    size_t pos = 0;
+    while (pos <= script.size()) {
+        size_t end = script.find('\n', pos);
+        if (end == std::string::npos) end = script.size();
+        std::string line = trim(script.substr(pos, end - pos));
+        pos = end + 1;
+        line_number++;
+
+        if (line.empty() || line[0] == '#') continue;
+
+        auto fail = [&](const char* what) {
+            char prefix[32];
+            snprintf(prefix, sizeof(prefix), "line %u: ", (unsigned)line_number);
+            error = prefix;
+            error += what;
+            return false;
+        };
+
+        std::string rest;
+        double time_ms = 0.0;
+        if (!parse_number(next_word(line, rest), time_ms) || time_ms < 0.0) return fail("expected a time in milliseconds");
+        if ((uint32_t)time_ms < last_time) return fail("time goes backwards");
+
+        std::string argument;
+        std::string type_name = next_word(rest, argument);
+
+        replay_event e;
+        e.time_ms = (uint32_t)time_ms;
+        e.type = replay_event_type_count;
+        e.value = 0.0;
+        for (int i = 0; i < replay_event_type_count; i++) {
+            if (type_name == g_type_names[i]) e.type = (replay_event_type)i;
+        }
+
+        switch (e.type) {
+        case replay_event_track:
+        case replay_event_icy:
+            if (argument.empty()) return fail("missing text");
+            e.text = argument;
+            break;
+        case replay_event_pause:
+        case replay_event_seek:
+        case replay_event_metadb:
+            if (!parse_number(argument, e.value) || e.value < 0.0) return fail("expected a number");
+            break;
+        case replay_event_stop:
+            break;
+        default:
+            return fail("unknown event type");
+        }
+
+        last_time = e.time_ms;
+        out.push_back(e);
+    }
+    return true;
+}
+
+replay_stats::replay_stats(const std::vector<const char*>& counter_names)
+    : m_counter_names(counter_names) {
+    for (auto& t : m_totals) t.counters.assign(m_counter_names.size(), 0);
+}
+
+void replay_stats::add(replay_event_type type, uint64_t cpu_us, uint64_t wall_us, const std::vector<uint64_t>& counter_deltas) {
+    if (type < 0 || type >= replay_event_type_count) return;
+    totals& t = m_totals[type];
+    t.events++;
+    t.cpu_us += cpu_us;
+    t.wall_us += wall_us;
+    for (size_t i = 0; i < t.counters.size() && i < counter_deltas.size(); i++) {
+        t.counters[i] += counter_deltas[i];
+    }
+}
+
+std::string replay_stats::format_report() const {
+    std::string report;
+    char cell[64];
+
+    snprintf(cell, sizeof(cell), "%-8s %7s %12s %12s", "event", "count", "cpu us/evt", "wall us/evt");
+    report += cell;
+    for (const char* name : m_counter_names) {
+        snprintf(cell, sizeof(cell), " %14.14s", name);
+        report += cell;
+    }
+    report += "\n";
+
+    for (int type = 0; type < replay_event_type_count; type++) {
+        const totals& t = m_totals[type];
+        if (t.events == 0) continue;
+        snprintf(cell, sizeof(cell), "%-8s %7llu %12.1f %12.1f", g_type_names[type], (unsigned long long)t.events,
+            (double)t.cpu_us / (double)t.events, (double)t.wall_us / (double)t.events);
+        report += cell;
+        for (uint64_t total : t.counters) {
+            snprintf(cell, sizeof(cell), " %14.2f", (double)total / (double)t.events);
+            report += cell;
+        }
+        report += "\n";
+    }
+    return report;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+// Recorded playback event scripts and per-event-type cost accounting for the event replay
+// tool (event_replay.h). No Windows or SDK dependency, so scripts can be generated, parsed
+// and checked anywhere.
+//
+// Script format, one event per line; blank lines and lines starting with # are ignored:
+//
+//   <time_ms> track <path>          new track (on_playback_new_track)
+//   <time_ms> icy <stream title>    stream dynamic info, "Artist - Title"
+//   <time_ms> pause <0|1>           pause state change
+//   <time_ms> seek <seconds>        seek
+//   <time_ms> stop                  playback stopped
+//   <time_ms> metadb <count>        burst of <count> metadb notifications for the playing track
+//
+// Times are milliseconds from the start of the replay and must not decrease.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum replay_event_type {
+    replay_event_track,
+    replay_event_icy,
+    replay_event_pause,
+    replay_event_seek,
+    replay_event_stop,
+    replay_event_metadb,
+    replay_event_type_count
+};
+
+struct replay_event {
+    uint32_t time_ms;
+    replay_event_type type;
+    std::string text;   // track: path, icy: stream title
+    double value;       // pause: 0/1, seek: seconds, metadb: notification count
+};
+
+const char* get_replay_event_type_name(replay_event_type type);
+
+// Parse a whole script. On failure returns false and describes the first bad line in error.
+bool parse_replay_script(const std::string& script, std::vector<replay_event>& out, std::string& error);
+
+// Cost attributed to each event type: everything the main thread did from dispatching an
+// event until the next one (so deferred paints and timers are included)
+class replay_stats {
+public:
+    // Names of the work counters sampled around each event (static strings)
+    explicit replay_stats(const std::vector<const char*>& counter_names);
+
+    void add(replay_event_type type, uint64_t cpu_us, uint64_t wall_us, const std::vector<uint64_t>& counter_deltas);
+
+    // Table with one row per event type, figures averaged per event; lines end in "\n"
+    std::string format_report() const;
+
+private:
+    struct totals {
+        uint64_t events = 0;
+        uint64_t cpu_us = 0;
+        uint64_t wall_us = 0;
+        std::vector<uint64_t> counters;
+    };
+
+    std::vector<const char*> m_counter_names;
+    totals m_totals[replay_event_type_count];
+};
@@ -98,6 +98,11 @@
 #define IDC_PROGRESS_ACCENT_LABEL    297
 #define IDC_PROGRESS_ACCENT_BTN      298
 #define IDC_VOLUME_OSD_COLOR_BTN     299
+#define IDC_WAVEFORM_SEEKBAR         336
+#define IDC_SPECTRUM_VISUALIZER      337
+#define IDC_ARTWORK_CROSSFADE_LABEL  338
+#define IDC_ARTWORK_CROSSFADE_COMBO  339
+#define IDC_ANIMATED_ARTWORK         343
 
 // Icons tab options
 #define IDC_HOVER_CIRCLES_LABEL      330
@@ -150,6 +155,12 @@
 #define IDC_MINIPLAYER_EXPANDED_SIZE_LABEL   323
 #define IDC_MINIPLAYER_EXPANDED_SIZE_EDIT    324
 
+// Diagnostics tab (hidden; created at runtime only in instrumented builds)
+#define IDC_DIAGNOSTICS_REPORT       340
+#define IDC_DIAGNOSTICS_REFRESH      341
+#define IDC_DIAGNOSTICS_RESET        342
+#define IDC_DIAGNOSTICS_COLLECT      344
+
 
 // Keep old IDs for backward compatibility (mapped to docked)
 #define IDC_CP_ARTIST_FONT_LABEL         IDC_DOCKED_ARTIST_LABEL
@@ -0,0 +1,13 @@
+#pragma once
+
+// SSE2 is part of every x64 target and of x86 builds with /arch:SSE2 (the MSVC default);
+// portable stages keep a scalar path for anything else, which is also what they are checked against.
+// Defining TRAY_NO_SIMD forces the scalar paths (the tests build both).
+#if defined(TRAY_NO_SIMD)
+#define TRAY_HAVE_SSE2 0
+#elif defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define TRAY_HAVE_SSE2 1
+#include <emmintrin.h>
+#else
+#define TRAY_HAVE_SSE2 0
+#endif
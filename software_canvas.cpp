@@ -0,0 +1,526 @@
+// software_canvas.cpp - Portable canvas backend (no precompiled header, no Windows dependency)
+
+#include "software_canvas.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <cwchar>
+#include <algorithm>
+
+static const float PI = 3.14159265358979f;
+
+static inline float clamp01(float v) {
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+// Signed distance from (px, py) to a rounded rectangle given by center and half extents
+static inline float rounded_rect_distance(float px, float py, float cx, float cy, float hw, float hh, float radius) {
+    const float qx = fabsf(px - cx) - (hw - radius);
+    const float qy = fabsf(py - cy) - (hh - radius);
+    const float ax = qx > 0.0f ? qx : 0.0f;
+    const float ay = qy > 0.0f ? qy : 0.0f;
+    const float m = qx > qy ? qx : qy;
+    return sqrtf(ax * ax + ay * ay) + (m < 0.0f ? m : 0.0f) - radius;
+}
+
+software_canvas::software_canvas(int width, int height)
+    : m_storage((size_t)(width > 0 ? width : 0) * (height > 0 ? height : 0) * 4)
+    , m_bits(m_storage.empty() ? nullptr : m_storage.data())
+    , m_width(width > 0 ? width : 0)
+    , m_height(height > 0 ? height : 0)
+    , m_stride(m_width * 4)
+{
+    reset_clip();
+}
+
+software_canvas::software_canvas(void* bits, int width, int height, int stride)
+    : m_bits(static_cast<uint8_t*>(bits))
+    , m_width(bits ? width : 0)
+    , m_height(bits ? height : 0)
+    , m_stride(stride)
+{
+    reset_clip();
+}
+
+void software_canvas::set_clip(int x, int y, int w, int h) {
+    m_clip_x0 = (std::max)(0, x);
+    m_clip_y0 = (std::max)(0, y);
+    m_clip_x1 = (std::min)(m_width, x + (std::max)(0, w));
+    m_clip_y1 = (std::min)(m_height, y + (std::max)(0, h));
+}
+
+void software_canvas::reset_clip() {
+    m_clip_x0 = 0;
+    m_clip_y0 = 0;
+    m_clip_x1 = m_width;
+    m_clip_y1 = m_height;
+}
+
+void software_canvas::blend_pixel(int x, int y, canvas_color color, float coverage) {
+    if (x < m_clip_x0 || y < m_clip_y0 || x >= m_clip_x1 || y >= m_clip_y1 || coverage <= 0.0f) return;
+    const unsigned int a = (unsigned int)(color.a * clamp01(coverage) + 0.5f);
+    if (a == 0) return;
+
+    // Source-over in premultiplied space
+    uint8_t* p = m_bits + (size_t)y * m_stride + (size_t)x * 4;
+    const unsigned int inv = 255 - a;
+    p[0] = (uint8_t)((color.b * a + p[0] * inv + 127) / 255);
+    p[1] = (uint8_t)((color.g * a + p[1] * inv + 127) / 255);
+    p[2] = (uint8_t)((color.r * a + p[2] * inv + 127) / 255);
+    p[3] = (uint8_t)(a + (p[3] * inv + 127) / 255);
+}
+
+void software_canvas::blend_premultiplied(int x, int y, const unsigned int bgra[4], float coverage) {
+    if (x < m_clip_x0 || y < m_clip_y0 || x >= m_clip_x1 || y >= m_clip_y1 || coverage <= 0.0f) return;
+    const unsigned int scale = (unsigned int)(clamp01(coverage) * 255.0f + 0.5f);
+    const unsigned int a = (bgra[3] * scale + 127) / 255;
+    if (a == 0 && bgra[0] + bgra[1] + bgra[2] == 0) return;
+
+    uint8_t* p = m_bits + (size_t)y * m_stride + (size_t)x * 4;
+    const unsigned int inv = 255 - a;
+    for (int k = 0; k < 3; k++) {
+        const unsigned int v = (bgra[k] * scale + 127) / 255 + (p[k] * inv + 127) / 255;
+        p[k] = (uint8_t)(v > 255 ? 255 : v);
+    }
+    p[3] = (uint8_t)(a + (p[3] * inv + 127) / 255);
+}
+
+void software_canvas::clear(canvas_color color) {
+    if (!m_bits) return;
+    // Stored premultiplied
+    const uint8_t px[4] = {
+        (uint8_t)((color.b * color.a + 127) / 255),
+        (uint8_t)((color.g * color.a + 127) / 255),
+        (uint8_t)((color.r * color.a + 127) / 255),
+        color.a
+    };
+    for (int y = 0; y < m_height; y++) {
+        uint8_t* row = m_bits + (size_t)y * m_stride;
+        for (int x = 0; x < m_width; x++) {
+            memcpy(row + x * 4, px, 4);
+        }
+    }
+}
+
+void software_canvas::fill_rect(float x, float y, float w, float h, canvas_color color) {
+    if (!m_bits || w <= 0.0f || h <= 0.0f) return;
+    const int x0 = (std::max)(0, (int)floorf(x));
+    const int y0 = (std::max)(0, (int)floorf(y));
+    const int x1 = (std::min)(m_width, (int)ceilf(x + w));
+    const int y1 = (std::min)(m_height, (int)ceilf(y + h));
+
+    // Exact area coverage of each pixel square
+    for (int py = y0; py < y1; py++) {
+        const float cov_y = (std::min)((float)py + 1.0f, y + h) - (std::max)((float)py, y);
+        for (int px = x0; px < x1; px++) {
+            const float cov_x = (std::min)((float)px + 1.0f, x + w) - (std::max)((float)px, x);
+            blend_pixel(px, py, color, cov_x * cov_y);
+        }
+    }
+}
+
+void software_canvas::fill_rounded_rect(float x, float y, float w, float h, float radius, canvas_color color) {
+    if (!m_bits || w <= 0.0f || h <= 0.0f) return;
+    const float hw = w * 0.5f;
+    const float hh = h * 0.5f;
+    radius = (std::max)(0.0f, (std::min)(radius, (std::min)(hw, hh)));
+    const float cx = x + hw;
+    const float cy = y + hh;
+
+    const int x0 = (std::max)(0, (int)floorf(x) - 1);
+    const int y0 = (std::max)(0, (int)floorf(y) - 1);
+    const int x1 = (std::min)(m_width, (int)ceilf(x + w) + 1);
+    const int y1 = (std::min)(m_height, (int)ceilf(y + h) + 1);
+    for (int py = y0; py < y1; py++) {
+        for (int px = x0; px < x1; px++) {
+            const float d = rounded_rect_distance((float)px + 0.5f, (float)py + 0.5f, cx, cy, hw, hh, radius);
+            blend_pixel(px, py, color, 0.5f - d);
+        }
+    }
+}
+
+void software_canvas::stroke_rounded_rect(float x, float y, float w, float h, float radius, float stroke, canvas_color color) {
+    if (!m_bits || w <= 0.0f || h <= 0.0f || stroke <= 0.0f) return;
+    const float hw = w * 0.5f;
+    const float hh = h * 0.5f;
+    radius = (std::max)(0.0f, (std::min)(radius, (std::min)(hw, hh)));
+    const float cx = x + hw;
+    const float cy = y + hh;
+    const float half = stroke * 0.5f;
+
+    const int x0 = (std::max)(0, (int)floorf(x - half) - 1);
+    const int y0 = (std::max)(0, (int)floorf(y - half) - 1);
+    const int x1 = (std::min)(m_width, (int)ceilf(x + w + half) + 1);
+    const int y1 = (std::min)(m_height, (int)ceilf(y + h + half) + 1);
+    for (int py = y0; py < y1; py++) {
+        for (int px = x0; px < x1; px++) {
+            const float d = rounded_rect_distance((float)px + 0.5f, (float)py + 0.5f, cx, cy, hw, hh, radius);
+            blend_pixel(px, py, color, half + 0.5f - fabsf(d));
+        }
+    }
+}
+
+void software_canvas::fill_ellipse(float x, float y, float w, float h, canvas_color color) {
+    if (!m_bits || w <= 0.0f || h <= 0.0f) return;
+    const float rx = w * 0.5f;
+    const float ry = h * 0.5f;
+    const float cx = x + rx;
+    const float cy = y + ry;
+
+    const int x0 = (std::max)(0, (int)floorf(x) - 1);
+    const int y0 = (std::max)(0, (int)floorf(y) - 1);
+    const int x1 = (std::min)(m_width, (int)ceilf(x + w) + 1);
+    const int y1 = (std::min)(m_height, (int)ceilf(y + h) + 1);
+    for (int py = y0; py < y1; py++) {
+        for (int px = x0; px < x1; px++) {
+            // First-order distance approximation to the ellipse boundary
+            const float dx = (float)px + 0.5f - cx;
+            const float dy = (float)py + 0.5f - cy;
+            const float k0 = sqrtf((dx / rx) * (dx / rx) + (dy / ry) * (dy / ry));
+            const float k1 = sqrtf((dx / (rx * rx)) * (dx / (rx * rx)) + (dy / (ry * ry)) * (dy / (ry * ry)));
+            const float d = k1 > 0.0f ? k0 * (k0 - 1.0f) / k1 : -(std::min)(rx, ry);
+            blend_pixel(px, py, color, 0.5f - d);
+        }
+    }
+}
+
+void software_canvas::fill_polygon(const canvas_point* points, int count, canvas_color color) {
+    fill_contours(points, &count, 1, false, color);
+}
+
+void software_canvas::fill_path(const canvas_point* points, const int* contour_sizes, int contour_count, canvas_color color) {
+    fill_contours(points, contour_sizes, contour_count, true, color);
+}
+
+// 4x4 supersampled coverage of closed contours, even-odd or nonzero winding
+void software_canvas::fill_contours(const canvas_point* points, const int* contour_sizes, int contour_count, bool nonzero, canvas_color color) {
+    if (!m_bits || !points || !contour_sizes || contour_count <= 0) return;
+
+    int total = 0;
+    for (int c = 0; c < contour_count; c++) total += contour_sizes[c];
+    if (total < 3) return;
+
+    float min_x = points[0].x, max_x = points[0].x, min_y = points[0].y, max_y = points[0].y;
+    for (int i = 1; i < total; i++) {
+        min_x = (std::min)(min_x, points[i].x);
+        max_x = (std::max)(max_x, points[i].x);
+        min_y = (std::min)(min_y, points[i].y);
+        max_y = (std::max)(max_y, points[i].y);
+    }
+    const int x0 = (std::max)(m_clip_x0, (int)floorf(min_x));
+    const int y0 = (std::max)(m_clip_y0, (int)floorf(min_y));
+    const int x1 = (std::min)(m_clip_x1, (int)ceilf(max_x));
+    const int y1 = (std::min)(m_clip_y1, (int)ceilf(max_y));
+
+    for (int py = y0; py < y1; py++) {
+        for (int px = x0; px < x1; px++) {
+            int inside = 0;
+            for (int sy = 0; sy < 4; sy++) {
+                const float fy = (float)py + (sy + 0.5f) * 0.25f;
+                for (int sx = 0; sx < 4; sx++) {
+                    const float fx = (float)px + (sx + 0.5f) * 0.25f;
+                    int winding = 0;
+                    const canvas_point* contour = points;
+                    for (int c = 0; c < contour_count; c++) {
+                        const int count = contour_sizes[c];
+                        for (int i = 0, j = count - 1; i < count; j = i++) {
+                            const canvas_point& a = contour[i];
+                            const canvas_point& b = contour[j];
+                            if ((a.y > fy) != (b.y > fy) &&
+                                fx < (b.x - a.x) * (fy - a.y) / (b.y - a.y) + a.x) {
+                                winding += a.y > b.y ? 1 : -1;
+                            }
+                        }
+                        contour += count;
+                    }
+                    if (nonzero ? winding != 0 : (winding & 1) != 0) inside++;
+                }
+            }
+            if (inside) blend_pixel(px, py, color, inside / 16.0f);
+        }
+    }
+}
+
+void software_canvas::fill_rects(const canvas_rect* rects, int count, canvas_color color) {
+    if (!rects) return;
+    for (int i = 0; i < count; i++) {
+        fill_rect(rects[i].x, rects[i].y, rects[i].w, rects[i].h, color);
+    }
+}
+
+void software_canvas::fill_linear_gradient(const canvas_rect& rect, float radius, canvas_color left, canvas_color right) {
+    if (!m_bits || rect.w <= 0.0f || rect.h <= 0.0f) return;
+    const float hw = rect.w * 0.5f;
+    const float hh = rect.h * 0.5f;
+    radius = (std::max)(0.0f, (std::min)(radius, (std::min)(hw, hh)));
+    const float cx = rect.x + hw;
+    const float cy = rect.y + hh;
+
+    const int x0 = (std::max)(m_clip_x0, (int)floorf(rect.x));
+    const int y0 = (std::max)(m_clip_y0, (int)floorf(rect.y));
+    const int x1 = (std::min)(m_clip_x1, (int)ceilf(rect.x + rect.w));
+    const int y1 = (std::min)(m_clip_y1, (int)ceilf(rect.y + rect.h));
+    for (int py = y0; py < y1; py++) {
+        const float cov_y = (std::min)((float)py + 1.0f, rect.y + rect.h) - (std::max)((float)py, rect.y);
+        for (int px = x0; px < x1; px++) {
+            float coverage;
+            if (radius > 0.0f) {
+                coverage = 0.5f - rounded_rect_distance((float)px + 0.5f, (float)py + 0.5f, cx, cy, hw, hh, radius);
+            } else {
+                coverage = ((std::min)((float)px + 1.0f, rect.x + rect.w) - (std::max)((float)px, rect.x)) * cov_y;
+            }
+            const float t = clamp01(((float)px + 0.5f - rect.x) / rect.w);
+            const canvas_color c = {
+                (uint8_t)(left.a + (right.a - left.a) * t + 0.5f),
+                (uint8_t)(left.r + (right.r - left.r) * t + 0.5f),
+                (uint8_t)(left.g + (right.g - left.g) * t + 0.5f),
+                (uint8_t)(left.b + (right.b - left.b) * t + 0.5f)
+            };
+            blend_pixel(px, py, c, coverage);
+        }
+    }
+}
+
+void software_canvas::draw_image(const canvas_image& image, const canvas_rect& dest, const canvas_rect& source, float corner_radius) {
+    if (!m_bits || image.empty() || dest.w <= 0.0f || dest.h <= 0.0f || source.w <= 0.0f || source.h <= 0.0f) return;
+    const float hw = dest.w * 0.5f;
+    const float hh = dest.h * 0.5f;
+    const float radius = (std::max)(0.0f, (std::min)(corner_radius, (std::min)(hw, hh)));
+    const float cx = dest.x + hw;
+    const float cy = dest.y + hh;
+    const float scale_x = source.w / dest.w;
+    const float scale_y = source.h / dest.h;
+
+    // Samples are clamped to the source rect, like GDI+ with WrapModeTileFlipXY
+    const float min_sx = (std::max)(0.0f, source.x);
+    const float min_sy = (std::max)(0.0f, source.y);
+    const float max_sx = (std::min)((float)image.width - 1.0f, source.x + source.w - 1.0f);
+    const float max_sy = (std::min)((float)image.height - 1.0f, source.y + source.h - 1.0f);
+    if (max_sx < min_sx || max_sy < min_sy) return;
+
+    const int x0 = (std::max)(m_clip_x0, (int)floorf(dest.x));
+    const int y0 = (std::max)(m_clip_y0, (int)floorf(dest.y));
+    const int x1 = (std::min)(m_clip_x1, (int)ceilf(dest.x + dest.w));
+    const int y1 = (std::min)(m_clip_y1, (int)ceilf(dest.y + dest.h));
+    for (int py = y0; py < y1; py++) {
+        const float cov_y = (std::min)((float)py + 1.0f, dest.y + dest.h) - (std::max)((float)py, dest.y);
+        float sy = source.y + ((float)py + 0.5f - dest.y) * scale_y - 0.5f;
+        sy = (std::max)(min_sy, (std::min)(max_sy, sy));
+        const int ty = (int)sy;
+        const int ty1 = (std::min)(ty + 1, (int)max_sy);
+        const unsigned int fy = (unsigned int)((sy - (float)ty) * 256.0f);
+        const uint8_t* row0 = image.bits + (ptrdiff_t)ty * image.stride;
+        const uint8_t* row1 = image.bits + (ptrdiff_t)ty1 * image.stride;
+
+        for (int px = x0; px < x1; px++) {
+            float coverage;
+            if (radius > 0.0f) {
+                coverage = 0.5f - rounded_rect_distance((float)px + 0.5f, (float)py + 0.5f, cx, cy, hw, hh, radius);
+            } else {
+                coverage = ((std::min)((float)px + 1.0f, dest.x + dest.w) - (std::max)((float)px, dest.x)) * cov_y;
+            }
+            if (coverage <= 0.0f) continue;
+
+            float sx = source.x + ((float)px + 0.5f - dest.x) * scale_x - 0.5f;
+            sx = (std::max)(min_sx, (std::min)(max_sx, sx));
+            const int tx = (int)sx;
+            const int tx1 = (std::min)(tx + 1, (int)max_sx);
+            const unsigned int fx = (unsigned int)((sx - (float)tx) * 256.0f);
+
+            const uint8_t* p00 = row0 + tx * 4;
+            const uint8_t* p01 = row0 + tx1 * 4;
+            const uint8_t* p10 = row1 + tx * 4;
+            const uint8_t* p11 = row1 + tx1 * 4;
+            unsigned int bgra[4];
+            for (int k = 0; k < 4; k++) {
+                const unsigned int top = p00[k] * (256 - fx) + p01[k] * fx;
+                const unsigned int bottom = p10[k] * (256 - fx) + p11[k] * fx;
+                bgra[k] = (top * (256 - fy) + bottom * fy + 32768) >> 16;
+            }
+            if (!image.has_alpha) bgra[3] = 255;
+            blend_premultiplied(px, py, bgra, coverage);
+        }
+    }
+}
+
+// Stroke a connected polyline using the distance to the nearest segment, so joints are not
+// blended twice
+void software_canvas::stroke_polyline(const canvas_point* points, int count, float stroke, canvas_color color) {
+    if (!m_bits || !points || count < 2 || stroke <= 0.0f) return;
+    const float half = stroke * 0.5f;
+
+    float min_x = points[0].x, max_x = points[0].x, min_y = points[0].y, max_y = points[0].y;
+    for (int i = 1; i < count; i++) {
+        min_x = (std::min)(min_x, points[i].x);
+        max_x = (std::max)(max_x, points[i].x);
+        min_y = (std::min)(min_y, points[i].y);
+        max_y = (std::max)(max_y, points[i].y);
+    }
+    const int x0 = (std::max)(0, (int)floorf(min_x - half) - 1);
+    const int y0 = (std::max)(0, (int)floorf(min_y - half) - 1);
+    const int x1 = (std::min)(m_width, (int)ceilf(max_x + half) + 1);
+    const int y1 = (std::min)(m_height, (int)ceilf(max_y + half) + 1);
+
+    for (int py = y0; py < y1; py++) {
+        const float fy = (float)py + 0.5f;
+        for (int px = x0; px < x1; px++) {
+            const float fx = (float)px + 0.5f;
+            float best = 1e30f;
+            for (int i = 0; i + 1 < count; i++) {
+                const float ax = points[i].x, ay = points[i].y;
+                const float bx = points[i + 1].x - ax, by = points[i + 1].y - ay;
+                const float len2 = bx * bx + by * by;
+                float t = len2 > 0.0f ? ((fx - ax) * bx + (fy - ay) * by) / len2 : 0.0f;
+                t = clamp01(t);
+                const float dx = fx - (ax + bx * t);
+                const float dy = fy - (ay + by * t);
+                best = (std::min)(best, dx * dx + dy * dy);
+            }
+            blend_pixel(px, py, color, half + 0.5f - sqrtf(best));
+        }
+    }
+}
+
+void software_canvas::draw_line(float x1, float y1, float x2, float y2, float stroke, canvas_color color) {
+    const canvas_point points[2] = { { x1, y1 }, { x2, y2 } };
+    stroke_polyline(points, 2, stroke, color);
+}
+
+void software_canvas::draw_arc(float x, float y, float w, float h, float start_deg, float sweep_deg, float stroke, canvas_color color) {
+    if (w <= 0.0f || h <= 0.0f || sweep_deg == 0.0f) return;
+    const float rx = w * 0.5f;
+    const float ry = h * 0.5f;
+    const float cx = x + rx;
+    const float cy = y + ry;
+
+    // GDI+ angles are true angles from the center, not parametric ones
+    const int segments = (std::max)(8, (std::min)(128, (int)(fabsf(sweep_deg) / 4.0f)));
+    std::vector<canvas_point> points(segments + 1);
+    for (int i = 0; i <= segments; i++) {
+        const float angle = (start_deg + sweep_deg * i / segments) * PI / 180.0f;
+        const float c = cosf(angle);
+        const float s = sinf(angle);
+        const float t = 1.0f / sqrtf((c / rx) * (c / rx) + (s / ry) * (s / ry));
+        points[i].x = cx + c * t;
+        points[i].y = cy + s * t;
+    }
+    stroke_polyline(points.data(), (int)points.size(), stroke, color);
+}
+
+float software_canvas::measure_text(const wchar_t* text, float size_pt) {
+    if (!text) return 0.0f;
+    // Average UI-font advance is a little over half an em
+    const float size_px = size_pt * 96.0f / 72.0f;
+    return (float)wcslen(text) * size_px * 0.55f;
+}
+
+void software_canvas::draw_text(const wchar_t* text, float x, float y, float w, float h, float size_pt,
+    canvas_text_align align, canvas_color color) {
+    const float text_w = (std::min)(measure_text(text, size_pt), w);
+    if (text_w <= 0.0f) return;
+
+    const float bar_h = size_pt * 96.0f / 72.0f * 0.7f;
+    float text_x = x;
+    if (align == canvas_align_center) text_x = x + (w - text_w) * 0.5f;
+    else if (align == canvas_align_far) text_x = x + w - text_w;
+    fill_rect(text_x, y + (h - bar_h) * 0.5f, text_w, bar_h, color);
+}
+
+// Character height in px of a LOGFONT height; a positive (cell) height includes internal leading
+static float font_pixel_size(const canvas_font& font) {
+    if (font.height < 0) return (float)-font.height;
+    if (font.height > 0) return (float)font.height * 0.77f;
+    return 12.0f;
+}
+
+float software_canvas::text_advance(const canvas_font& font) const {
+    // Bold faces run a little wider
+    return font_pixel_size(font) * (font.weight >= 600 ? 0.6f : 0.55f);
+}
+
+canvas_text_extent software_canvas::measure_text(const canvas_font& font, const wchar_t* text) {
+    canvas_text_extent extent = { 0.0f, ceilf(font_pixel_size(font) * 1.3f) };
+    if (text) extent.width = (float)wcslen(text) * text_advance(font);
+    return extent;
+}
+
+void software_canvas::draw_text(const canvas_font& font, const wchar_t* text, const canvas_rect& box,
+    canvas_text_align align, canvas_color color, unsigned flags) {
+    if (!m_bits || !text || box.w <= 0.0f || box.h <= 0.0f) return;
+    const float advance = text_advance(font);
+    const float size_px = font_pixel_size(font);
+    size_t length = wcslen(text);
+    float text_w = (float)length * advance;
+
+    // An ellipsized line keeps the characters that fit in front of "..."
+    bool ellipsis = false;
+    const float dots_w = 3.0f * advance * 0.5f;
+    if ((flags & canvas_text_end_ellipsis) && text_w > box.w) {
+        const float room = box.w - dots_w;
+        length = room > 0.0f ? (size_t)(room / advance) : 0;
+        text_w = (float)length * advance + dots_w;
+        ellipsis = true;
+    }
+    if (text_w <= 0.0f) return;
+
+    float text_x = box.x;
+    if (align == canvas_align_center) text_x = (std::max)(box.x, box.x + (box.w - text_w) * 0.5f);
+    else if (align == canvas_align_far) text_x = box.x + box.w - text_w;
+
+    // Clipped to the box, as ExtTextOut(ETO_CLIPPED)
+    const int saved[4] = { m_clip_x0, m_clip_y0, m_clip_x1, m_clip_y1 };
+    m_clip_x0 = (std::max)(m_clip_x0, (int)floorf(box.x));
+    m_clip_y0 = (std::max)(m_clip_y0, (int)floorf(box.y));
+    m_clip_x1 = (std::min)(m_clip_x1, (int)ceilf(box.x + box.w));
+    m_clip_y1 = (std::min)(m_clip_y1, (int)ceilf(box.y + box.h));
+
+    const float bar_h = size_px * 0.7f;
+    const float bar_y = box.y + (box.h - bar_h) * 0.5f;
+    fill_rect(text_x, bar_y, (float)length * advance, bar_h, color);
+    if (ellipsis) {
+        const float dot = (std::max)(1.0f, size_px * 0.12f);
+        for (int i = 0; i < 3; i++) {
+            fill_rect(text_x + (float)length * advance + (i + 0.5f) * advance * 0.5f - dot * 0.5f,
+                bar_y + bar_h - dot, dot, dot, color);
+        }
+    }
+
+    m_clip_x0 = saved[0];
+    m_clip_y0 = saved[1];
+    m_clip_x1 = saved[2];
+    m_clip_y1 = saved[3];
+}
+
+// Pixels outside the rounded rectangle are made fully transparent; the corner edge is
+// anti-aliased using a 1px signed-distance coverage falloff for silky-smooth corners.
+void apply_rounded_corner_alpha(void* bits, int w, int h, float radius) {
+    uint8_t* px = static_cast<uint8_t*>(bits);
+    if (!px) return;
+    const float cx = w * 0.5f;
+    const float cy = h * 0.5f;
+    const float hw = w * 0.5f - radius;
+    const float hh = h * 0.5f - radius;
+
+    for (int y = 0; y < h; y++) {
+        const float py = (float)y + 0.5f - cy;
+        const float qy = fabsf(py) - hh;
+        const float ay = qy > 0.0f ? qy : 0.0f;
+        for (int x = 0; x < w; x++) {
+            const float p_x = (float)x + 0.5f - cx;
+            const float qx = fabsf(p_x) - hw;
+            const float ax = qx > 0.0f ? qx : 0.0f;
+            const float m = qx > qy ? qx : qy;
+            const float d = sqrtf(ax * ax + ay * ay) + (m < 0.0f ? m : 0.0f) - radius;
+            float coverage = 0.5f - d;
+            if (coverage < 0.0f) coverage = 0.0f;
+            if (coverage > 1.0f) coverage = 1.0f;
+            uint8_t* p = px + (y * w + x) * 4;
+            const unsigned int a = (unsigned int)(coverage * 255.0f + 0.5f);
+            // Premultiply RGB by alpha (UpdateLayeredWindow AC_SRC_ALPHA expects premultiplied)
+            p[0] = (uint8_t)(((unsigned int)p[0] * a + 127) / 255);
+            p[1] = (uint8_t)(((unsigned int)p[1] * a + 127) / 255);
+            p[2] = (uint8_t)(((unsigned int)p[2] * a + 127) / 255);
+            p[3] = (uint8_t)a;
+        }
+    }
+}
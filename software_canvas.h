@@ -0,0 +1,73 @@
+#pragma once
+
+// Portable software backend for canvas: renders into a top-down premultiplied BGRA buffer,
+// the same layout as the 32bpp DIB sections pushed with UpdateLayeredWindow. Coverage is
+// computed analytically (signed distance) for rects, rounded rects, ellipses and strokes,
+// and by 4x4 supersampling for polygons and paths. Images are scaled bilinearly. No Windows
+// dependency - builds anywhere.
+//
+// Text has no font rasterizer here: it is measured with a fixed average advance and drawn
+// as a flat bar of that extent, so layout and fill cost stay representative. An ellipsized
+// line ends in three dots.
+
+#include "canvas.h"
+#include <vector>
+
+class software_canvas : public canvas {
+public:
+    // Owns its pixel buffer
+    software_canvas(int width, int height);
+    // Draws into caller-owned memory (e.g. DIB section bits); stride is in bytes
+    software_canvas(void* bits, int width, int height, int stride);
+
+    int width() const override { return m_width; }
+    int height() const override { return m_height; }
+    uint8_t* bits() { return m_bits; }
+    const uint8_t* bits() const { return m_bits; }
+    int stride() const { return m_stride; }
+
+    void clear(canvas_color color) override;
+    void fill_rect(float x, float y, float w, float h, canvas_color color) override;
+    void fill_rounded_rect(float x, float y, float w, float h, float radius, canvas_color color) override;
+    void fill_ellipse(float x, float y, float w, float h, canvas_color color) override;
+    void fill_polygon(const canvas_point* points, int count, canvas_color color) override;
+    void stroke_rounded_rect(float x, float y, float w, float h, float radius, float stroke, canvas_color color) override;
+    void draw_line(float x1, float y1, float x2, float y2, float stroke, canvas_color color) override;
+    void draw_arc(float x, float y, float w, float h, float start_deg, float sweep_deg, float stroke, canvas_color color) override;
+    float measure_text(const wchar_t* text, float size_pt) override;
+    void draw_text(const wchar_t* text, float x, float y, float w, float h, float size_pt,
+        canvas_text_align align, canvas_color color) override;
+    canvas_text_extent measure_text(const canvas_font& font, const wchar_t* text) override;
+    void draw_text(const canvas_font& font, const wchar_t* text, const canvas_rect& box,
+        canvas_text_align align, canvas_color color, unsigned flags) override;
+    void fill_linear_gradient(const canvas_rect& rect, float radius, canvas_color left, canvas_color right) override;
+    void fill_path(const canvas_point* points, const int* contour_sizes, int contour_count, canvas_color color) override;
+    void fill_rects(const canvas_rect* rects, int count, canvas_color color) override;
+    void draw_image(const canvas_image& image, const canvas_rect& dest, const canvas_rect& source, float corner_radius) override;
+    void set_clip(int x, int y, int w, int h) override;
+    void reset_clip() override;
+
+private:
+    std::vector<uint8_t> m_storage;
+    uint8_t* m_bits;
+    int m_width;
+    int m_height;
+    int m_stride;
+    // Pixels outside [x0, x1) x [y0, y1) are never written
+    int m_clip_x0;
+    int m_clip_y0;
+    int m_clip_x1;
+    int m_clip_y1;
+
+    void blend_pixel(int x, int y, canvas_color color, float coverage);
+    // Source-over of an already premultiplied BGRA pixel
+    void blend_premultiplied(int x, int y, const unsigned int bgra[4], float coverage);
+    void fill_contours(const canvas_point* points, const int* contour_sizes, int contour_count, bool nonzero, canvas_color color);
+    void stroke_polyline(const canvas_point* points, int count, float stroke, canvas_color color);
+    float text_advance(const canvas_font& font) const;
+};
+
+// Apply an anti-aliased rounded-rectangle alpha mask to an opaque 32-bit BGRA buffer
+// (width * 4 byte rows). Pixels outside the rounded rectangle become fully transparent and
+// RGB is premultiplied by the resulting alpha, ready for UpdateLayeredWindow(AC_SRC_ALPHA).
+void apply_rounded_corner_alpha(void* bits, int w, int h, float radius);
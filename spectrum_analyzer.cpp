@@ -0,0 +1,261 @@
+#include "spectrum_analyzer.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const float spectrum_analyzer::ATTACK_SECONDS = 0.025f;
+const float spectrum_analyzer::RELEASE_SECONDS = 0.25f;
+const float spectrum_analyzer::RANGE_DB = 70.0f;
+
+static const double PI = 3.14159265358979323846;
+static const float SILENT_LEVEL = 0.002f;    // Below a pixel on any bar; snapped to zero
+
+spectrum_analyzer::spectrum_analyzer()
+    : m_size(0)
+    , m_sample_rate(0.0f) {
+}
+
+void spectrum_analyzer::configure(unsigned fft_size, unsigned band_count, float sample_rate, float min_hz, float max_hz) {
+    unsigned log2_size = 6;
+    while ((2u << log2_size) <= fft_size && log2_size < 16) log2_size++;
+    unsigned size = 1u << log2_size;
+    m_size = size;
+    m_sample_rate = sample_rate;
+
+    m_window.resize(size);
+    for (unsigned i = 0; i < size; i++) {
+        m_window[i] = (float)(0.5 - 0.5 * cos(2.0 * PI * i / size));
+    }
+    m_input.assign(size, 0.0f);
+    m_re.assign(size, 0.0f);
+    m_im.assign(size, 0.0f);
+
+    m_cos.resize(size / 2);
+    m_sin.resize(size / 2);
+    for (unsigned k = 0; k < size / 2; k++) {
+        m_cos[k] = (float)cos(2.0 * PI * k / size);
+        m_sin[k] = (float)sin(2.0 * PI * k / size);
+    }
+
+    m_bit_reverse.resize(size);
+    for (unsigned i = 0; i < size; i++) {
+        unsigned reversed = 0;
+        for (unsigned bit = 0; bit < log2_size; bit++) {
+            if (i & (1u << bit)) reversed |= 1u << (log2_size - 1 - bit);
+        }
+        m_bit_reverse[i] = reversed;
+    }
+
+    m_power.assign(size / 2 + 1, 0.0f);
+
+    // Log-spaced band edges mapped to bins; bands narrower than a bin share their nearest bin
+    float nyquist = sample_rate / 2.0f;
+    if (max_hz > nyquist) max_hz = nyquist;
+    if (min_hz < 1.0f) min_hz = 1.0f;
+    if (min_hz >= max_hz) min_hz = max_hz / 2.0f;
+    float bin_hz = sample_rate / size;
+    m_band_first.resize(band_count);
+    m_band_last.resize(band_count);
+    for (unsigned b = 0; b < band_count; b++) {
+        float low = min_hz * powf(max_hz / min_hz, (float)b / band_count);
+        float high = min_hz * powf(max_hz / min_hz, (float)(b + 1) / band_count);
+        unsigned first = (unsigned)(low / bin_hz + 0.5f);
+        unsigned last = (unsigned)(high / bin_hz + 0.5f);
+        if (last > first) last--;
+        first = std::min(std::max(first, 1u), size / 2);
+        last = std::min(std::max(last, first), size / 2);
+        m_band_first[b] = first;
+        m_band_last[b] = last;
+    }
+    m_targets.assign(band_count, 0.0f);
+    m_levels.assign(band_count, 0.0f);
+}
+
+template<typename sample_t>
+void spectrum_analyzer::load_samples(const sample_t* samples, size_t frames, unsigned channels) {
+    if (m_size == 0 || channels == 0) return;
+    float* out = m_input.data();
+    if (frames >= m_size) {
+        samples += (frames - m_size) * channels;
+        frames = m_size;
+    } else {
+        size_t pad = m_size - frames;
+        memset(out, 0, pad * sizeof(float));
+        out += pad;
+    }
+
+    if (channels == 1) {
+        for (size_t i = 0; i < frames; i++) out[i] = (float)samples[i];
+        return;
+    }
+    float gain = 1.0f / channels;
+    for (size_t i = 0; i < frames; i++) {
+        sample_t sum = 0;
+        for (unsigned c = 0; c < channels; c++) sum += samples[c];
+        out[i] = (float)sum * gain;
+        samples += channels;
+    }
+}
+
+void spectrum_analyzer::load(const float* samples, size_t frames, unsigned channels) {
+    load_samples(samples, frames, channels);
+}
+
+void spectrum_analyzer::load(const double* samples, size_t frames, unsigned channels) {
+    load_samples(samples, frames, channels);
+}
+
+void spectrum_analyzer::transform() {
+    unsigned size = m_size;
+    spectrum_apply_window(m_input.data(), m_window.data(), m_im.data(), size);
+
+    // Real input: the imaginary buffer held the windowed samples only to be permuted into re
+    float* re = m_re.data();
+    float* im = m_im.data();
+    for (unsigned i = 0; i < size; i++) re[m_bit_reverse[i]] = im[i];
+    memset(im, 0, size * sizeof(float));
+
+    for (unsigned length = 2; length <= size; length <<= 1) {
+        unsigned half = length / 2;
+        unsigned step = size / length;
+        for (unsigned start = 0; start < size; start += length) {
+            for (unsigned j = 0; j < half; j++) {
+                float wr = m_cos[j * step];
+                float wi = -m_sin[j * step];
+                unsigned a = start + j;
+                unsigned b = a + half;
+                float vr = re[b] * wr - im[b] * wi;
+                float vi = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - vr;
+                im[b] = im[a] - vi;
+                re[a] += vr;
+                im[a] += vi;
+            }
+        }
+    }
+
+    // Hann coherent gain is 1/2, so a full-scale sine peaks at N/4
+    float scale = 4.0f / size;
+    spectrum_power(re, im, m_power.data(), size / 2 + 1, scale * scale);
+}
+
+void spectrum_analyzer::analyze(float dt) {
+    if (m_size == 0) return;
+    transform();
+
+    for (size_t b = 0; b < m_targets.size(); b++) {
+        float peak = 0.0f;
+        for (unsigned k = m_band_first[b]; k <= m_band_last[b]; k++) {
+            if (m_power[k] > peak) peak = m_power[k];
+        }
+        float db = 10.0f * log10f(peak + 1e-12f);
+        float target = (db + RANGE_DB) / RANGE_DB;
+        m_targets[b] = target < 0.0f ? 0.0f : (target > 1.0f ? 1.0f : target);
+    }
+
+    float attack = 1.0f - expf(-dt / ATTACK_SECONDS);
+    float release = 1.0f - expf(-dt / RELEASE_SECONDS);
+    for (size_t b = 0; b < m_levels.size(); b++) {
+        float delta = m_targets[b] - m_levels[b];
+        m_levels[b] += delta * (delta > 0.0f ? attack : release);
+        if (m_levels[b] < SILENT_LEVEL) m_levels[b] = 0.0f;
+    }
+}
+
+void spectrum_analyzer::decay(float dt) {
+    float keep = expf(-dt / RELEASE_SECONDS);
+    for (float& level : m_levels) {
+        level *= keep;
+        if (level < SILENT_LEVEL) level = 0.0f;
+    }
+}
+
+void spectrum_analyzer::reset() {
+    std::fill(m_levels.begin(), m_levels.end(), 0.0f);
+}
+
+bool spectrum_analyzer::is_silent() const {
+    for (float level : m_levels) {
+        if (level > 0.0f) return false;
+    }
+    return true;
+}
+
+void spectrum_apply_window(const float* input, const float* window, float* out, size_t n) {
+    size_t i = 0;
+#if TRAY_HAVE_SSE2
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(input + i), _mm_loadu_ps(window + i)));
+    }
+#endif
+    for (; i < n; i++) out[i] = input[i] * window[i];
+}
+
+void spectrum_power(const float* re, const float* im, float* out, size_t n, float scale) {
+    size_t i = 0;
+#if TRAY_HAVE_SSE2
+    __m128 s = _mm_set1_ps(scale);
+    for (; i + 4 <= n; i += 4) {
+        __m128 r = _mm_loadu_ps(re + i);
+        __m128 m = _mm_loadu_ps(im + i);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)), s));
+    }
+#endif
+    for (; i < n; i++) out[i] = (re[i] * re[i] + im[i] * im[i]) * scale;
+}
+
+void blend_spectrum_bars_bgra(uint8_t* pixels, int stride, int x, int y, int width, int height,
+    const float* levels, unsigned count, uint32_t color, uint8_t alpha) {
+    if (!pixels || count == 0 || width <= 0 || height <= 0) return;
+    unsigned a = alpha;
+    unsigned src_b = (color & 0xFF) * a;
+    unsigned src_g = ((color >> 8) & 0xFF) * a;
+    unsigned src_r = ((color >> 16) & 0xFF) * a;
+    unsigned keep = 255 - a;
+
+    for (unsigned bar = 0; bar < count; bar++) {
+        int left = x + (int)((int64_t)width * bar / count);
+        int right = x + (int)((int64_t)width * (bar + 1) / count);
+        if (right - left >= 3) right--;
+        int bar_height = (int)(levels[bar] * height + 0.5f);
+        if (bar_height <= 0 || right <= left) continue;
+        if (bar_height > height) bar_height = height;
+
+        for (int row = y + height - bar_height; row < y + height; row++) {
+            uint8_t* p = pixels + (ptrdiff_t)row * stride + (ptrdiff_t)left * 4;
+            for (int col = left; col < right; col++, p += 4) {
+                p[0] = (uint8_t)((p[0] * keep + src_b + 127) / 255);
+                p[1] = (uint8_t)((p[1] * keep + src_g + 127) / 255);
+                p[2] = (uint8_t)((p[2] * keep + src_r + 127) / 255);
+            }
+        }
+    }
+}
+
+spectrum_frame_governor::spectrum_frame_governor(unsigned min_interval_ms, unsigned max_interval_ms, float cpu_share)
+    : m_min_interval_ms(min_interval_ms)
+    , m_max_interval_ms(max_interval_ms)
+    , m_cpu_share(cpu_share)
+    , m_average_ms(0.0)
+    , m_interval_ms(min_interval_ms)
+    , m_frames(0) {
+}
+
+void spectrum_frame_governor::reset() {
+    m_average_ms = 0.0;
+    m_interval_ms = m_min_interval_ms;
+    m_frames = 0;
+}
+
+void spectrum_frame_governor::add_frame_cost(double ms) {
+    // Plain mean over the first frames, then a moving average that forgets a one-off stall
+    m_frames++;
+    double weight = m_frames < 10 ? 1.0 / m_frames : 0.1;
+    m_average_ms += (ms - m_average_ms) * weight;
+
+    double wanted = m_average_ms / m_cpu_share;
+    if (wanted < m_min_interval_ms) wanted = m_min_interval_ms;
+    if (wanted > m_max_interval_ms) wanted = m_max_interval_ms;
+    m_interval_ms = (unsigned)ceil(wanted);
+}
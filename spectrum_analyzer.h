@@ -0,0 +1,100 @@
+#pragma once
+
+// Portable DSP core of the spectrum visualizer: downmix, Hann window, radix-2 FFT, power
+// spectrum, log-frequency bands and attack/release smoothing. configure() allocates every
+// buffer and table up front; analyze() and decay() then run without touching the heap.
+// Free of Windows and SDK types, so it can be checked against synthetic sines.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class spectrum_analyzer {
+public:
+    spectrum_analyzer();
+
+    // fft_size must be a power of two (rounded down otherwise). Bands split min_hz..max_hz
+    // evenly on a log scale; max_hz is clamped to Nyquist. Resets the smoothed levels.
+    void configure(unsigned fft_size, unsigned band_count, float sample_rate, float min_hz, float max_hz);
+    bool is_configured() const { return m_size > 0; }
+    unsigned fft_size() const { return m_size; }
+    float sample_rate() const { return m_sample_rate; }
+
+    // Downmix interleaved samples into the FFT input. The newest fft_size frames are kept;
+    // fewer are zero-padded at the front.
+    void load(const float* samples, size_t frames, unsigned channels);
+    void load(const double* samples, size_t frames, unsigned channels);
+
+    // Transform the loaded input and move the band levels toward it; dt is the time since the
+    // previous frame, in seconds
+    void analyze(float dt);
+
+    // Let the levels fall toward silence (no data yet, gap in the stream)
+    void decay(float dt);
+    // Drop straight to silence
+    void reset();
+    // True once every band has fallen to zero
+    bool is_silent() const;
+
+    // Smoothed level of each band, 0..1 (bottom of the dB range .. full scale)
+    const float* levels() const { return m_levels.data(); }
+    unsigned band_count() const { return (unsigned)m_levels.size(); }
+
+    // Unsmoothed power of bin k (0 .. fft_size/2) from the last analyze(); full-scale sine = 1
+    float bin_power(unsigned k) const { return m_power[k]; }
+
+    // Shorter attack than release keeps peaks readable without flicker
+    static const float ATTACK_SECONDS;
+    static const float RELEASE_SECONDS;
+    static const float RANGE_DB;
+
+private:
+    unsigned m_size;
+    float m_sample_rate;
+    std::vector<float> m_window;
+    std::vector<float> m_input;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    std::vector<float> m_cos;           // Twiddles, fft_size/2 entries
+    std::vector<float> m_sin;
+    std::vector<uint32_t> m_bit_reverse;
+    std::vector<float> m_power;         // fft_size/2 + 1 bins
+    std::vector<uint32_t> m_band_first; // Bin range of each band
+    std::vector<uint32_t> m_band_last;
+    std::vector<float> m_targets;
+    std::vector<float> m_levels;
+
+    template<typename sample_t>
+    void load_samples(const sample_t* samples, size_t frames, unsigned channels);
+    void transform();
+};
+
+// Windowed multiply and squared magnitude, SSE2 where available
+void spectrum_apply_window(const float* input, const float* window, float* out, size_t n);
+void spectrum_power(const float* re, const float* im, float* out, size_t n, float scale);
+
+// Blend one bar per level into an opaque 32bpp BGRA area, bottom-aligned, with a 1 px gap
+// once bars are at least 3 px wide. color is 0x00RRGGBB; alpha 255 is opaque.
+void blend_spectrum_bars_bgra(uint8_t* pixels, int stride, int x, int y, int width, int height,
+    const float* levels, unsigned count, uint32_t color, uint8_t alpha);
+
+// Keeps the visualizer inside a CPU budget: measured frame costs feed an average, and the
+// frame interval stretches until cost / interval is under the allowed share of one core.
+class spectrum_frame_governor {
+public:
+    spectrum_frame_governor(unsigned min_interval_ms, unsigned max_interval_ms, float cpu_share);
+
+    void reset();
+    void add_frame_cost(double ms);
+
+    unsigned interval_ms() const { return m_interval_ms; }
+    double average_cost_ms() const { return m_average_ms; }
+
+private:
+    unsigned m_min_interval_ms;
+    unsigned m_max_interval_ms;
+    float m_cpu_share;
+    double m_average_ms;
+    unsigned m_interval_ms;
+    unsigned m_frames;
+};
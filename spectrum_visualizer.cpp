@@ -0,0 +1,76 @@
+#include "stdafx.h"
+#include "spectrum_visualizer.h"
+
+static const unsigned FFT_SIZE = 2048;
+static const unsigned BAND_COUNT = 32;
+static const float MIN_HZ = 40.0f;
+static const float MAX_HZ = 16000.0f;
+// 30 fps at most; at 5% of one core a 5 ms frame drops to 10 fps
+static const unsigned MIN_INTERVAL_MS = 33;
+static const unsigned MAX_INTERVAL_MS = 200;
+static const float CPU_SHARE = 0.05f;
+
+spectrum_visualizer::spectrum_visualizer()
+    : m_governor(MIN_INTERVAL_MS, MAX_INTERVAL_MS, CPU_SHARE) {
+    m_last_step.QuadPart = 0;
+}
+
+void spectrum_visualizer::start() {
+    if (m_stream.is_valid()) return;
+    try {
+        visualisation_manager::get()->create_stream(m_stream, 0);
+        visualisation_stream_v2::ptr v2;
+        if (v2 &= m_stream) v2->set_channel_mode(visualisation_stream_v2::channel_mode_mono);
+    } catch (...) {
+        m_stream.release();
+        return;
+    }
+    m_governor.reset();
+    m_last_step.QuadPart = 0;
+}
+
+void spectrum_visualizer::stop() {
+    m_stream.release();
+    m_analyzer.reset();
+}
+
+void spectrum_visualizer::step() {
+    if (!m_stream.is_valid()) return;
+
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    float dt = m_last_step.QuadPart ? (float)(now.QuadPart - m_last_step.QuadPart) / (float)freq.QuadPart : 0.0f;
+    if (dt > 0.2f) dt = 0.2f;   // After a stall, move as if one slow frame had passed
+    m_last_step = now;
+
+    // One FFT window ending at the audio being heard now
+    float rate = m_analyzer.is_configured() ? m_analyzer.sample_rate() : 44100.0f;
+    double length = (double)FFT_SIZE / rate;
+    double time = 0;
+    bool have_data = false;
+    try {
+        have_data = m_stream->get_absolute_time(time) &&
+            m_stream->get_chunk_absolute(m_chunk, time - length, length) &&
+            !m_chunk.is_empty();
+    } catch (...) {}
+    if (!have_data) {
+        m_analyzer.decay(dt);
+        return;
+    }
+
+    // Configuring allocates, so it happens only on the first chunk and on sample rate changes
+    if (!m_analyzer.is_configured() || m_analyzer.sample_rate() != (float)m_chunk.get_sample_rate()) {
+        m_analyzer.configure(FFT_SIZE, BAND_COUNT, (float)m_chunk.get_sample_rate(), MIN_HZ, MAX_HZ);
+    }
+    m_analyzer.load(m_chunk.get_data(), m_chunk.get_sample_count(), m_chunk.get_channels());
+    m_analyzer.analyze(dt);
+}
+
+void spectrum_visualizer::draw(void* bits, int stride, const RECT& area, COLORREF color, BYTE alpha) const {
+    if (!bits || !m_stream.is_valid() || m_analyzer.is_silent()) return;
+    uint32_t rgb = ((uint32_t)GetRValue(color) << 16) | ((uint32_t)GetGValue(color) << 8) | GetBValue(color);
+    blend_spectrum_bars_bgra(static_cast<uint8_t*>(bits), stride, area.left, area.top,
+        area.right - area.left, area.bottom - area.top,
+        m_analyzer.levels(), m_analyzer.band_count(), rgb, alpha);
+}
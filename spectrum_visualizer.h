@@ -0,0 +1,37 @@
+#pragma once
+
+#include "stdafx.h"
+#include "spectrum_analyzer.h"
+
+// Spectrum bars for the Expanded and Compact MiniPlayer. Owns a visualisation_stream only while
+// running, so the core stops buffering audio for it once the panel no longer wants frames.
+// Each step() takes the newest FFT window of played audio and runs it through
+// spectrum_analyzer; the control panel times every frame (step plus composite) and the
+// governor stretches the frame interval when that cost exceeds its CPU share. Main thread only.
+class spectrum_visualizer {
+public:
+    spectrum_visualizer();
+
+    void start();
+    void stop();    // Also clears the bars, so a resume starts from silence
+    bool is_running() const { return m_stream.is_valid(); }
+
+    // Pull the audio ending at the current playback time and advance the levels
+    void step();
+
+    // Blend the bars into a 32bpp DIB (opaque pixels)
+    void draw(void* bits, int stride, const RECT& area, COLORREF color, BYTE alpha) const;
+
+    void add_frame_cost(double ms) { m_governor.add_frame_cost(ms); }
+    UINT get_interval() const { return m_governor.interval_ms(); }
+
+private:
+    visualisation_stream::ptr m_stream;
+    audio_chunk_impl m_chunk;       // Keeps its buffer between frames
+    spectrum_analyzer m_analyzer;
+    spectrum_frame_governor m_governor;
+    LARGE_INTEGER m_last_step;
+
+    spectrum_visualizer(const spectrum_visualizer&) = delete;
+    spectrum_visualizer& operator=(const spectrum_visualizer&) = delete;
+};
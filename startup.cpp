@@ -0,0 +1,88 @@
+#include "stdafx.h"
+#include "startup.h"
+#include <condition_variable>
+#include <mutex>
+
+static const size_t MAX_STARTUP_PHASES = 16;
+
+// How long shutdown waits for a decode worker to leave GDI+ (one large cover, or one frame)
+static const unsigned GDIPLUS_WORK_WAIT_MS = 3000;
+
+static ULONG_PTR g_gdiplus_token = 0;
+static bool g_gdiplus_started = false;
+
+static std::mutex g_gdiplus_work_mutex;
+static std::condition_variable g_gdiplus_work_idle;
+static unsigned g_gdiplus_work_count = 0;
+
+static startup_phase g_phases[MAX_STARTUP_PHASES];
+static size_t g_phase_count = 0;
+
+bool ensure_gdiplus() {
+    if (g_gdiplus_started) return true;
+
+    Gdiplus::GdiplusStartupInput gdiplusStartupInput;
+    if (Gdiplus::GdiplusStartup(&g_gdiplus_token, &gdiplusStartupInput, nullptr) != Gdiplus::Ok) {
+        g_gdiplus_token = 0;
+        return false;
+    }
+    g_gdiplus_started = true;
+    return true;
+}
+
+gdiplus_work_scope::gdiplus_work_scope() {
+    std::lock_guard<std::mutex> lock(g_gdiplus_work_mutex);
+    g_gdiplus_work_count++;
+}
+
+gdiplus_work_scope::~gdiplus_work_scope() {
+    std::lock_guard<std::mutex> lock(g_gdiplus_work_mutex);
+    if (--g_gdiplus_work_count == 0) g_gdiplus_work_idle.notify_all();
+}
+
+void shutdown_gdiplus() {
+    if (!g_gdiplus_started) return;
+    {
+        // Workers were told to abort; each finishes at most the image it is on
+        std::unique_lock<std::mutex> lock(g_gdiplus_work_mutex);
+        if (!g_gdiplus_work_idle.wait_for(lock, std::chrono::milliseconds(GDIPLUS_WORK_WAIT_MS),
+                [] { return g_gdiplus_work_count == 0; })) {
+            console::print("Tray Controls: an image decode did not finish; GDI+ left running for exit");
+            return;
+        }
+    }
+    Gdiplus::GdiplusShutdown(g_gdiplus_token);
+    g_gdiplus_token = 0;
+    g_gdiplus_started = false;
+}
+
+void record_startup_phase(const char* name, const LARGE_INTEGER& start) {
+    LARGE_INTEGER end, freq;
+    QueryPerformanceCounter(&end);
+    QueryPerformanceFrequency(&freq);
+
+    if (g_phase_count >= MAX_STARTUP_PHASES) return;
+    g_phases[g_phase_count].name = name;
+    g_phases[g_phase_count].microseconds = (double)(end.QuadPart - start.QuadPart) * 1000000.0 / (double)freq.QuadPart;
+    g_phase_count++;
+}
+
+size_t get_startup_phases(const startup_phase*& phases) {
+    phases = g_phases;
+    return g_phase_count;
+}
+
+void log_startup_phases() {
+#ifdef _DEBUG
+    double total = 0.0;
+    for (size_t i = 0; i < g_phase_count; i++) {
+        char msg[128];
+        sprintf_s(msg, "startup: %-24s %10.1f us\n", g_phases[i].name, g_phases[i].microseconds);
+        OutputDebugStringA(msg);
+        total += g_phases[i].microseconds;
+    }
+    char msg[128];
+    sprintf_s(msg, "startup: %-24s %10.1f us\n", "total", total);
+    OutputDebugStringA(msg);
+#endif
+}
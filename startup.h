@@ -0,0 +1,40 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Start GDI+ on first use. Safe to call from every GDI+ code path; only the
+// first successful call pays the startup cost. Main thread only.
+bool ensure_gdiplus();
+
+// Shut GDI+ down if ensure_gdiplus() started it (on_quit, after the windows are gone).
+// Waits for open gdiplus_work_scopes first; if a worker is still busy after a few seconds
+// GDI+ is left running rather than pulled from under it.
+void shutdown_gdiplus();
+
+// Marks GDI+ use on a worker thread (cover decodes, thumbnails, animation frames) so that
+// shutdown_gdiplus() waits for it. Every GDI+ object the worker creates or releases must be
+// gone before the scope closes. Any thread.
+class gdiplus_work_scope {
+public:
+    gdiplus_work_scope();
+    ~gdiplus_work_scope();
+
+private:
+    gdiplus_work_scope(const gdiplus_work_scope&) = delete;
+    gdiplus_work_scope& operator=(const gdiplus_work_scope&) = delete;
+};
+
+// Startup phase timing, in microseconds, from QueryPerformanceCounter
+struct startup_phase {
+    const char* name;
+    double microseconds;
+};
+
+// Record the time elapsed since start under the given (static) phase name
+void record_startup_phase(const char* name, const LARGE_INTEGER& start);
+
+// Phases recorded so far, in the order they completed (listed in the performance report)
+size_t get_startup_phases(const startup_phase*& phases);
+
+// Write all recorded phases to the debugger output (debug builds)
+void log_startup_phases();
@@ -9,7 +9,10 @@
 #include <vector>
 #include <algorithm>
 
-// Windows headers - include COM definitions
+// Windows headers - include COM definitions. Elsewhere only the SDK is included: the playback
+// pipeline (playback_events.cpp and what it calls) also builds on Linux for the event replay
+// harness in replay/.
+#ifdef _WIN32
 #ifndef _WIN32_WINNT
 #define _WIN32_WINNT 0x0601
 #endif
@@ -23,6 +26,7 @@
 #include <gdiplus.h>
 #include <atlbase.h>
 #include <shlwapi.h>
+#endif
 
 // Include the full foobar2000 SDK
 #include "lib/foobar2000_SDK/foobar2000/SDK/foobar2000.h"
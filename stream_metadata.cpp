@@ -0,0 +1,220 @@
+#include "stdafx.h"
+#include "stream_metadata.h"
+#include "track_notification.h"
+#include "playback_ui.h"
+#include "main_thread_timer.h"
+
+// Bursts of dynamic info are flushed at most once per frame (~60 Hz)
+static const unsigned STREAM_METADATA_FLUSH_MS = 16;
+
+static stream_metadata g_pending_metadata;
+static bool g_has_pending_metadata = false;
+static pfc::string8 g_last_dispatched_artist;
+static pfc::string8 g_last_dispatched_title;
+static bool g_has_dispatched_metadata = false;
+static main_thread_timer_id g_flush_timer = 0;
+
+static bool starts_with_nocase(const char* text, const char* prefix) {
+    for (; *prefix; text++, prefix++) {
+        if (tolower((unsigned char)*text) != *prefix) return false;
+    }
+    return true;
+}
+
+static bool is_remote_stream_path(const char* path) {
+    if (!path || path[0] == '\0') return false;
+
+    try {
+        service_ptr_t<filesystem> fs;
+        if (filesystem::g_get_interface(fs, path)) {
+            return fs->is_remote(path);
+        }
+    } catch (...) {}
+
+    return starts_with_nocase(path, "http://") ||
+           starts_with_nocase(path, "https://") ||
+           starts_with_nocase(path, "mms://") ||
+           starts_with_nocase(path, "rtsp://") ||
+           starts_with_nocase(path, "rtmp://") ||
+           starts_with_nocase(path, "icy://") ||
+           starts_with_nocase(path, "icecast://") ||
+           starts_with_nocase(path, "hls://");
+}
+
+static const char* safe_meta_get(const file_info& info, const char* name) {
+    t_size index = info.meta_find(name);
+    if (index != pfc_infinite && info.meta_enum_value_count(index) > 0) {
+        const char* val = info.meta_enum_value(index, 0);
+        if (val && val[0] != '\0') return val;
+    }
+    return nullptr;
+}
+
+// Case-insensitive check for a ?flag, &flag or #flag marker in the stream URL
+static bool path_has_flag(const char* path, const char* flag) {
+    std::string path_str = path;
+    std::transform(path_str.begin(), path_str.end(), path_str.begin(), ::tolower);
+    const char prefixes[] = { '?', '&', '#' };
+    for (char prefix : prefixes) {
+        std::string marker(1, prefix);
+        marker += flag;
+        if (path_str.find(marker) != std::string::npos) return true;
+    }
+    return false;
+}
+
+bool parse_stream_metadata(const file_info& info, metadb_handle_ptr track, stream_metadata& out) {
+    if (!track.is_valid()) return false;
+
+    pfc::string8 path = track->get_path();
+    if (!is_remote_stream_path(path.get_ptr())) return false;
+
+    pfc::string8 artist, title;
+
+    const char* p_artist = safe_meta_get(info, "ARTIST");
+    const char* p_title = safe_meta_get(info, "TITLE");
+
+    const char* stream_title = safe_meta_get(info, "STREAMTITLE");
+    if (!stream_title) {
+        stream_title = safe_meta_get(info, "ICY_TITLE");
+    }
+
+    if (stream_title) {
+        const char* dash = strstr(stream_title, " - ");
+        if (dash) {
+            if (!p_artist) {
+                artist.set_string(stream_title, dash - stream_title);
+            }
+            if (!p_title) {
+                title.set_string(dash + 3);
+            }
+        } else if (!p_title) {
+            title = stream_title;
+        }
+    }
+
+    if (p_artist && artist.is_empty()) artist = p_artist;
+    if (p_title && title.is_empty()) title = p_title;
+
+    // Some stations put "Artist - Title" in TITLE with no ARTIST
+    if (artist.is_empty() && !title.is_empty()) {
+        pfc::string8 temp = title;
+        const char* dash = strstr(temp.get_ptr(), " - ");
+        if (dash) {
+            artist.set_string(temp.get_ptr(), dash - temp.get_ptr());
+            title = dash + 3;
+        }
+    }
+
+    if (artist.is_empty()) {
+        const char* val = safe_meta_get(info, "ALBUMARTIST");
+        if (val) artist = val;
+    }
+    if (artist.is_empty()) {
+        const char* val = safe_meta_get(info, "PERFORMER");
+        if (val) artist = val;
+    }
+    if (title.is_empty()) {
+        const char* val = safe_meta_get(info, "DESCRIPTION");
+        if (val) title = val;
+    }
+    if (title.is_empty()) {
+        const char* val = safe_meta_get(info, "COMMENT");
+        if (val) title = val;
+    }
+
+    if (artist.is_empty() && title.is_empty()) return false;
+
+    artist.trim(' ');
+    title.trim(' ');
+
+    // Stations that send "Title - Artist" are marked via URL flag or STREAM_INVERTED=1
+    bool inverted = path_has_flag(path.get_ptr(), "inverted");
+    if (!inverted) {
+        const char* val = safe_meta_get(info, "STREAM_INVERTED");
+        inverted = val && strcmp(val, "1") == 0;
+    }
+    if (inverted) {
+        pfc::string8 temp = artist;
+        artist = title;
+        title = temp;
+    }
+
+    out.artist = artist;
+    out.title = title;
+    out.bypass_artwork = path_has_flag(path.get_ptr(), "bypass");
+    out.artwork_requested = false;
+    return true;
+}
+
+static void dispatch_stream_metadata(stream_metadata& meta) {
+    g_last_dispatched_artist = meta.artist;
+    g_last_dispatched_title = meta.title;
+    g_has_dispatched_metadata = true;
+    playback_ui_stream_metadata(meta);
+}
+
+static void flush_timer_proc() {
+    g_flush_timer = 0;
+
+    if (!g_has_pending_metadata) return;
+
+    // The new track itself has not been delivered yet; its popup and panel reset would wipe
+    // this update, so hold it until the track settles
+    if (is_track_notification_pending()) {
+        g_flush_timer = start_main_thread_timer(0, STREAM_METADATA_FLUSH_MS, flush_timer_proc);
+        if (g_flush_timer) return;
+    }
+    g_has_pending_metadata = false;
+
+    // A burst may have flipped back to what is already on screen
+    if (g_has_dispatched_metadata &&
+        g_pending_metadata.artist == g_last_dispatched_artist &&
+        g_pending_metadata.title == g_last_dispatched_title) {
+        return;
+    }
+
+    try {
+        dispatch_stream_metadata(g_pending_metadata);
+    } catch (...) {}
+}
+
+void on_stream_dynamic_info(const file_info& info) {
+    try {
+        metadb_handle_ptr track;
+        auto playback = playback_control::get();
+        if (!playback->get_now_playing(track) || !track.is_valid()) return;
+
+        stream_metadata meta;
+        if (!parse_stream_metadata(info, track, meta)) return;
+
+        // Drop repeats of what is already pending or already dispatched
+        if (g_has_pending_metadata) {
+            if (meta.artist == g_pending_metadata.artist && meta.title == g_pending_metadata.title) return;
+        } else if (g_has_dispatched_metadata &&
+                   meta.artist == g_last_dispatched_artist && meta.title == g_last_dispatched_title) {
+            return;
+        }
+
+        // Latest update wins; the flush timer delivers it on the next frame
+        g_pending_metadata = meta;
+        g_has_pending_metadata = true;
+        if (!g_flush_timer) {
+            g_flush_timer = start_main_thread_timer(0, STREAM_METADATA_FLUSH_MS, flush_timer_proc);
+            if (!g_flush_timer) {
+                // No timer available - deliver synchronously rather than lose the update
+                g_has_pending_metadata = false;
+                dispatch_stream_metadata(g_pending_metadata);
+            }
+        }
+    } catch (...) {}
+}
+
+void reset_stream_metadata() {
+    stop_main_thread_timer(g_flush_timer);
+    g_flush_timer = 0;
+    g_has_pending_metadata = false;
+    g_has_dispatched_metadata = false;
+    g_last_dispatched_artist.reset();
+    g_last_dispatched_title.reset();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Artist/title extracted from stream dynamic info (ICY/Shoutcast/HLS).
+// Parsed once per update and handed to the tray, control panel and popup.
+struct stream_metadata {
+    pfc::string8 artist;
+    pfc::string8 title;
+    bool bypass_artwork;    // Stream URL carries ?bypass - never search online artwork
+    bool artwork_requested; // An online artwork search was issued or queued for this update
+};
+
+// Parse dynamic info for the given (remote stream) track.
+// Returns false if the track is not a remote stream or no usable artist/title was found.
+bool parse_stream_metadata(const file_info& info, metadb_handle_ptr track, stream_metadata& out);
+
+// Entry point for play_callback dynamic info notifications (main thread).
+// Drops identical artist/title pairs and coalesces bursts into at most one dispatch per frame.
+void on_stream_dynamic_info(const file_info& info);
+
+// Forget the last dispatched metadata (new track, stop, shutdown)
+void reset_stream_metadata();
@@ -1,17 +1,14 @@
 #include "stdafx.h"
 #include "svg_icon.h"
+#include "startup.h"
 
 using namespace Gdiplus;
 
 HICON svg_icon::create_tray_icon(int width, int height) {
     HICON icon = nullptr;
     
-    // Initialize GDI+ if not already done
-    GdiplusStartupInput gdiplusStartupInput;
-    ULONG_PTR gdiplusToken;
-    Status status = GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
-    
-    if (status != Ok) {
+    // GDI+ is started once for the whole component, on first use
+    if (!ensure_gdiplus()) {
         return nullptr;
     }
     
@@ -19,13 +16,11 @@ HICON svg_icon::create_tray_icon(int width, int height) {
         // Create bitmap
         Bitmap bitmap(width, height, PixelFormat32bppARGB);
         if (bitmap.GetLastStatus() != Ok) {
-            GdiplusShutdown(gdiplusToken);
             return nullptr;
         }
         
         Graphics graphics(&bitmap);
         if (graphics.GetLastStatus() != Ok) {
-            GdiplusShutdown(gdiplusToken);
             return nullptr;
         }
         
@@ -45,8 +40,40 @@ HICON svg_icon::create_tray_icon(int width, int height) {
         icon = nullptr;
     }
     
-    // Cleanup GDI+
-    GdiplusShutdown(gdiplusToken);
+    return icon;
+}
+
+HICON svg_icon::create_tray_icon(int size, tray_icon_state state, bool light_taskbar) {
+    HICON icon = nullptr;
+    
+    // GDI+ is started once for the whole component, on first use
+    if (!ensure_gdiplus()) {
+        return nullptr;
+    }
+    
+    try {
+        Bitmap bitmap(size, size, PixelFormat32bppARGB);
+        if (bitmap.GetLastStatus() != Ok) {
+            return nullptr;
+        }
+        
+        Graphics graphics(&bitmap);
+        if (graphics.GetLastStatus() != Ok) {
+            return nullptr;
+        }
+        
+        graphics.SetSmoothingMode(SmoothingModeAntiAlias);
+        graphics.SetInterpolationMode(InterpolationModeHighQualityBicubic);
+        graphics.SetPixelOffsetMode(PixelOffsetModeHighQuality);
+        
+        render_foobar_logo(graphics, size, size);
+        render_state_badge(graphics, size, state, light_taskbar);
+        
+        icon = bitmap_to_icon(&bitmap);
+    }
+    catch (...) {
+        icon = nullptr;
+    }
     
     return icon;
 }
@@ -54,12 +81,8 @@ HICON svg_icon::create_tray_icon(int width, int height) {
 HBITMAP svg_icon::create_tray_bitmap(int width, int height) {
     HBITMAP hbitmap = nullptr;
     
-    // Initialize GDI+ if not already done
-    GdiplusStartupInput gdiplusStartupInput;
-    ULONG_PTR gdiplusToken;
-    Status status = GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
-    
-    if (status != Ok) {
+    // GDI+ is started once for the whole component, on first use
+    if (!ensure_gdiplus()) {
         return nullptr;
     }
     
@@ -67,13 +90,11 @@ HBITMAP svg_icon::create_tray_bitmap(int width, int height) {
         // Create bitmap
         Bitmap bitmap(width, height, PixelFormat32bppARGB);
         if (bitmap.GetLastStatus() != Ok) {
-            GdiplusShutdown(gdiplusToken);
             return nullptr;
         }
         
         Graphics graphics(&bitmap);
         if (graphics.GetLastStatus() != Ok) {
-            GdiplusShutdown(gdiplusToken);
             return nullptr;
         }
         
@@ -93,9 +114,6 @@ HBITMAP svg_icon::create_tray_bitmap(int width, int height) {
         hbitmap = nullptr;
     }
     
-    // Cleanup GDI+
-    GdiplusShutdown(gdiplusToken);
-    
     return hbitmap;
 }
 
@@ -200,6 +218,43 @@ void svg_icon::render_foobar_logo(Graphics& graphics, int width, int height) {
     delete bgPath;
 }
 
+void svg_icon::render_state_badge(Graphics& graphics, int size, tray_icon_state state, bool light_taskbar) {
+    if (state != tray_icon_playing && state != tray_icon_paused) return;
+    
+    // Badge covers the bottom-right ~55% of the icon so the glyph stays legible at 16 px
+    float badge = size * 0.56f;
+    float x = size - badge;
+    float y = size - badge;
+    
+    // Ring separating the badge from the logo: a white badge on a dark taskbar gets a dark ring,
+    // a dark badge on a light taskbar gets a light one
+    float ring = (std::max)(1.0f, size / 16.0f);
+    SolidBrush ringBrush(light_taskbar ? Color(255, 255, 255, 255) : Color(255, 0x1B, 0x18, 0x17));
+    graphics.FillEllipse(&ringBrush, x - ring, y - ring, badge + ring, badge + ring);
+    
+    SolidBrush badgeBrush(light_taskbar ? Color(255, 0x1B, 0x18, 0x17) : Color(255, 255, 255, 255));
+    graphics.FillEllipse(&badgeBrush, x, y, badge - ring, badge - ring);
+    
+    SolidBrush glyphBrush(light_taskbar ? Color(255, 255, 255, 255) : Color(255, 0x1B, 0x18, 0x17));
+    float cx = x + (badge - ring) * 0.5f;
+    float cy = y + (badge - ring) * 0.5f;
+    float g = (badge - ring) * 0.26f; // Glyph half-extent
+    
+    if (state == tray_icon_playing) {
+        // Triangle nudged right so it looks optically centered
+        PointF play[] = {
+            PointF(cx - g * 0.75f, cy - g),
+            PointF(cx + g * 1.05f, cy),
+            PointF(cx - g * 0.75f, cy + g)
+        };
+        graphics.FillPolygon(&glyphBrush, play, 3);
+    } else {
+        float bar = g * 0.65f;
+        graphics.FillRectangle(&glyphBrush, cx - g * 0.9f, cy - g, bar, g * 2.0f);
+        graphics.FillRectangle(&glyphBrush, cx + g * 0.9f - bar, cy - g, bar, g * 2.0f);
+    }
+}
+
 GraphicsPath* svg_icon::create_rounded_rect(RectF rect, float radius) {
     GraphicsPath* path = new GraphicsPath();
     
@@ -3,11 +3,23 @@
 #include "stdafx.h"
 #include <gdiplus.h>
 
+// Playback state shown as a badge on the tray icon
+enum tray_icon_state {
+    tray_icon_stopped,  // Plain logo
+    tray_icon_playing,
+    tray_icon_paused,
+    tray_icon_state_count
+};
+
 // SVG-based icon renderer for foobar2000 tray controls
 class svg_icon {
 public:
     // Create HICON from SVG data at specified size
     static HICON create_tray_icon(int width, int height);
+
+    // Create a square tray icon with the playback state badge in the bottom-right corner.
+    // light_taskbar outlines the badge so it stays visible on a light taskbar.
+    static HICON create_tray_icon(int size, tray_icon_state state, bool light_taskbar);
     
     // Create HBITMAP from SVG data at specified size  
     static HBITMAP create_tray_bitmap(int width, int height);
@@ -15,6 +27,9 @@ public:
 private:
     // Render the foobar2000 logo using GDI+
     static void render_foobar_logo(Gdiplus::Graphics& graphics, int width, int height);
+
+    // Render the play/pause badge over the logo
+    static void render_state_badge(Gdiplus::Graphics& graphics, int size, tray_icon_state state, bool light_taskbar);
     
     // Helper to create rounded rectangle path
     static Gdiplus::GraphicsPath* create_rounded_rect(Gdiplus::RectF rect, float radius);
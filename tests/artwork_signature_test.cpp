@@ -0,0 +1,200 @@
+#include "test_harness.h"
+#include "../artwork_signature.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Opaque BGRA image with a smooth two-axis gradient, the kind of content a signature keeps
+std::vector<uint8_t> make_gradient(int width, int height) {
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t* p = &pixels[((size_t)y * width + x) * 4];
+            p[0] = (uint8_t)(40 + 160 * y / (height - 1));
+            p[1] = 90;
+            p[2] = (uint8_t)(220 - 180 * x / (width - 1));
+            p[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+double mean_abs_difference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    double total = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (i % 4 == 3) continue;
+        total += abs((int)a[i] - (int)b[i]);
+    }
+    return total / (a.size() * 3 / 4);
+}
+
+signature_record make_record(uint64_t key, uint8_t shade) {
+    std::vector<uint8_t> pixels(4 * 4 * 4, shade);
+    signature_record record;
+    record.key = key;
+    encode_artwork_signature(pixels.data(), 4, 4, 16, 100 + shade, 100, record.signature);
+    return record;
+}
+
+}
+
+TEST_CASE(artwork_signature, round_trip_keeps_the_picture) {
+    const int width = 120, height = 90;
+    std::vector<uint8_t> pixels = make_gradient(width, height);
+    artwork_signature signature;
+    REQUIRE(encode_artwork_signature(pixels.data(), width, height, width * 4, 1200, 900, signature));
+    CHECK(signature.is_valid());
+    CHECK(signature.source_width() == 1200);
+    CHECK(signature.source_height() == 900);
+
+    std::vector<uint8_t> preview(pixels.size(), 0);
+    REQUIRE(decode_artwork_signature(signature, preview.data(), width, height, width * 4));
+    CHECK(mean_abs_difference(pixels, preview) < 6.0);
+    for (size_t i = 3; i < preview.size(); i += 4) CHECK(preview[i] == 255);
+
+    // The gradient survives in direction: the preview's red falls left to right, blue grows downwards
+    const uint8_t* top_left = &preview[0];
+    const uint8_t* bottom_right = &preview[((size_t)(height - 1) * width + width - 1) * 4];
+    CHECK(top_left[2] > bottom_right[2] + 100);
+    CHECK(bottom_right[0] > top_left[0] + 100);
+
+    // Encoding is deterministic, and the result does not depend on the stride
+    std::vector<uint8_t> padded((size_t)(width * 4 + 12) * height, 0);
+    for (int y = 0; y < height; y++) memcpy(&padded[(size_t)y * (width * 4 + 12)], &pixels[(size_t)y * width * 4], width * 4);
+    artwork_signature again;
+    REQUIRE(encode_artwork_signature(padded.data(), width, height, width * 4 + 12, 1200, 900, again));
+    CHECK(again == signature);
+}
+
+TEST_CASE(artwork_signature, solid_colour_decodes_flat) {
+    const uint8_t colours[][3] = { { 0, 0, 0 }, { 255, 255, 255 }, { 30, 144, 255 }, { 200, 16, 46 } };
+    for (const uint8_t* colour : colours) {
+        std::vector<uint8_t> pixels(64 * 64 * 4);
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            pixels[i] = colour[2];
+            pixels[i + 1] = colour[1];
+            pixels[i + 2] = colour[0];
+            pixels[i + 3] = 255;
+        }
+        artwork_signature signature;
+        REQUIRE(encode_artwork_signature(pixels.data(), 64, 64, 64 * 4, 64, 64, signature));
+
+        std::vector<uint8_t> preview(37 * 23 * 4);
+        REQUIRE(decode_artwork_signature(signature, preview.data(), 37, 23, 37 * 4));
+        int worst = 0;
+        for (size_t i = 0; i < preview.size(); i += 4) {
+            for (int k = 0; k < 3; k++) {
+                int difference = abs((int)preview[i + k] - (int)colour[2 - k]);
+                if (difference > worst) worst = difference;
+            }
+        }
+        CHECK(worst <= 2);
+    }
+}
+
+TEST_CASE(artwork_signature, rejects_invalid_input) {
+    artwork_signature signature;
+    memset(signature.bytes, 0, sizeof(signature.bytes));
+    CHECK(!signature.is_valid());
+    uint8_t pixel[4] = { 1, 2, 3, 255 };
+    std::vector<uint8_t> preview(16 * 16 * 4, 7);
+    CHECK(!decode_artwork_signature(signature, preview.data(), 16, 16, 64));
+    CHECK(preview[0] == 7);
+
+    CHECK(!encode_artwork_signature(nullptr, 1, 1, 4, 1, 1, signature));
+    CHECK(!encode_artwork_signature(pixel, 0, 1, 4, 1, 1, signature));
+    CHECK(!encode_artwork_signature(pixel, 1, 1, 4, 0, 1, signature));
+    REQUIRE(encode_artwork_signature(pixel, 1, 1, 4, 1, 1, signature));
+    CHECK(signature.is_valid());
+    CHECK(!decode_artwork_signature(signature, preview.data(), 0, 16, 64));
+
+    // A signature from another format version, or without a source size, is not used
+    artwork_signature other = signature;
+    other.bytes[0] ^= 0xFF;
+    CHECK(!other.is_valid());
+    other = signature;
+    other.bytes[1] = other.bytes[2] = 0;
+    CHECK(!other.is_valid());
+    CHECK(other != signature);
+}
+
+TEST_CASE(artwork_signature, index_read_skips_torn_and_invalid_records) {
+    std::vector<signature_record> records;
+    for (uint64_t key = 1; key <= 5; key++) records.push_back(make_record(key * 0x0101010101010101ULL, (uint8_t)(key * 40)));
+    records[2].signature.bytes[0] = 0;   // Not a valid signature any more
+
+    std::vector<uint8_t> file;
+    serialize_signature_index(records, file);
+    CHECK(file.size() == SIGNATURE_INDEX_HEADER_SIZE + 5 * SIGNATURE_INDEX_RECORD_SIZE);
+
+    // A crash in the middle of an append leaves part of a record at the end
+    signature_record torn = make_record(99, 10);
+    std::vector<uint8_t> tail(SIGNATURE_INDEX_RECORD_SIZE);
+    write_signature_record(tail.data(), torn);
+    file.insert(file.end(), tail.begin(), tail.begin() + 20);
+
+    std::vector<signature_record> read;
+    REQUIRE(parse_signature_index(file.data(), file.size(), read));
+    REQUIRE(read.size() == 4);
+    const size_t expected[] = { 0, 1, 3, 4 };
+    for (size_t i = 0; i < 4; i++) {
+        CHECK(read[i].key == records[expected[i]].key);
+        CHECK(read[i].signature == records[expected[i]].signature);
+    }
+
+    // Header only, another version, not an index at all
+    std::vector<uint8_t> header(SIGNATURE_INDEX_HEADER_SIZE);
+    write_signature_index_header(header.data());
+    read.clear();
+    CHECK(parse_signature_index(header.data(), header.size(), read));
+    CHECK(read.empty());
+    header[4] = 2;
+    CHECK(!parse_signature_index(header.data(), header.size(), read));
+    CHECK(!parse_signature_index(file.data(), 5, read));
+    file[0] = 'X';
+    CHECK(!parse_signature_index(file.data(), file.size(), read));
+}
+
+TEST_CASE(artwork_signature, index_compaction_keeps_newest_per_track) {
+    // Appends in order: track 1, 2, 3, 1 again (cover changed), 4, 2 again
+    std::vector<signature_record> records = {
+        make_record(1, 10), make_record(2, 20), make_record(3, 30),
+        make_record(1, 11), make_record(4, 40), make_record(2, 21),
+    };
+
+    std::vector<signature_record> kept = records;
+    keep_newest_signatures(kept, 100);
+    REQUIRE(kept.size() == 4);
+    // Oldest first, each track once, with its latest signature
+    CHECK(kept[0].key == 3 && kept[0].signature == records[2].signature);
+    CHECK(kept[1].key == 1 && kept[1].signature == records[3].signature);
+    CHECK(kept[2].key == 4);
+    CHECK(kept[3].key == 2 && kept[3].signature == records[5].signature);
+
+    // Over the limit the least recently recorded tracks go
+    kept = records;
+    keep_newest_signatures(kept, 2);
+    REQUIRE(kept.size() == 2);
+    CHECK(kept[0].key == 4);
+    CHECK(kept[1].key == 2);
+
+    // Compacting writes a file that reads back as the kept records
+    kept = records;
+    keep_newest_signatures(kept, 100);
+    std::vector<uint8_t> file;
+    serialize_signature_index(kept, file);
+    std::vector<signature_record> read;
+    REQUIRE(parse_signature_index(file.data(), file.size(), read));
+    REQUIRE(read.size() == kept.size());
+    for (size_t i = 0; i < read.size(); i++) {
+        CHECK(read[i].key == kept[i].key);
+        CHECK(read[i].signature == kept[i].signature);
+    }
+
+    std::vector<signature_record> empty;
+    keep_newest_signatures(empty, 10);
+    CHECK(empty.empty());
+}
@@ -0,0 +1,44 @@
+#include "canvas_png.h"
+#include <algorithm>
+#include <cstring>
+#include <png.h>
+
+bool write_canvas_png(const std::string& path, const software_canvas& c) {
+    std::vector<uint8_t> straight((size_t)c.width() * c.height() * 4);
+    for (int y = 0; y < c.height(); y++) {
+        const uint8_t* src = c.bits() + (size_t)y * c.stride();
+        uint8_t* dst = &straight[(size_t)y * c.width() * 4];
+        for (int x = 0; x < c.width() * 4; x += 4) {
+            unsigned a = src[x + 3];
+            for (int k = 0; k < 3; k++) dst[x + k] = a ? (uint8_t)std::min(255u, (src[x + k] * 255 + a / 2) / a) : 0;
+            dst[x + 3] = (uint8_t)a;
+        }
+    }
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    image.width = c.width();
+    image.height = c.height();
+    image.format = PNG_FORMAT_BGRA;
+    return png_image_write_to_file(&image, path.c_str(), 0, straight.data(), 0, nullptr) != 0;
+}
+
+bool read_canvas_png(const std::string& path, int& width, int& height, std::vector<uint8_t>& out) {
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, path.c_str())) return false;
+    image.format = PNG_FORMAT_BGRA;
+    width = (int)image.width;
+    height = (int)image.height;
+    out.resize(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, nullptr, out.data(), 0, nullptr)) {
+        png_image_free(&image);
+        return false;
+    }
+    for (size_t i = 0; i < out.size(); i += 4) {
+        unsigned a = out[i + 3];
+        for (int k = 0; k < 3; k++) out[i + k] = (uint8_t)((out[i + k] * a + 127) / 255);
+    }
+    return true;
+}
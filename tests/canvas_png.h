@@ -0,0 +1,16 @@
+#pragma once
+
+// PNG files of software_canvas frames, for the golden images and the frames panel_paint_bench
+// writes. The canvas holds premultiplied BGRA; PNG holds straight alpha, so images are
+// converted on the way out and back, which loses nothing the golden tolerance does not
+// already allow for.
+
+#include "../software_canvas.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+bool write_canvas_png(const std::string& path, const software_canvas& c);
+
+// Premultiplied BGRA rows of width * 4 bytes, as the canvas stores them
+bool read_canvas_png(const std::string& path, int& width, int& height, std::vector<uint8_t>& out);
@@ -0,0 +1,52 @@
+#include "golden_image.h"
+#include "canvas_png.h"
+#include "test_harness.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const int TOLERANCE = 2;
+
+bool updating_goldens() {
+    const char* value = getenv("TRAYCONTROLS_UPDATE_GOLDENS");
+    return value && *value && strcmp(value, "0") != 0;
+}
+
+std::string golden_path(const char* scene) {
+    return std::string(TRAYCONTROLS_GOLDEN_DIR) + "/" + scene + ".png";
+}
+
+}
+
+void check_golden(const char* scene, const software_canvas& c) {
+    std::string path = golden_path(scene);
+    int width = 0, height = 0;
+    std::vector<uint8_t> golden;
+    if (updating_goldens() || !read_canvas_png(path, width, height, golden)) {
+        bool written = write_canvas_png(path, c);
+        fprintf(stderr, "%s %s\n", written ? "wrote" : "could not write", path.c_str());
+        CHECK(written && updating_goldens());
+        return;
+    }
+
+    REQUIRE(width == c.width() && height == c.height());
+    int worst = 0;
+    size_t differing = 0;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* actual = c.bits() + (size_t)y * c.stride();
+        const uint8_t* expected = &golden[(size_t)y * width * 4];
+        for (int i = 0; i < width * 4; i++) {
+            int difference = abs((int)actual[i] - (int)expected[i]);
+            if (difference > worst) worst = difference;
+            if (difference > TOLERANCE) differing++;
+        }
+    }
+    if (differing > 0) {
+        std::string actual_path = std::string(scene) + ".actual.png";
+        write_canvas_png(actual_path, c);
+        fprintf(stderr, "%s: %zu channels differ by more than %d (worst %d); see %s\n",
+            scene, differing, TOLERANCE, worst, actual_path.c_str());
+    }
+    CHECK(differing == 0);
+}
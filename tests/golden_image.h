@@ -0,0 +1,10 @@
+#pragma once
+
+// Golden images: each scene is rendered and compared with tests/golden/<scene>.png, allowing
+// for rounding differences between compilers. A scene without a golden, or any scene when
+// TRAYCONTROLS_UPDATE_GOLDENS is set, writes the golden instead (and fails unless updating).
+// A mismatch writes <scene>.actual.png to the working directory for inspection.
+
+#include "../software_canvas.h"
+
+void check_golden(const char* scene, const software_canvas& c);
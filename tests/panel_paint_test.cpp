@@ -0,0 +1,222 @@
+#include "test_harness.h"
+#include "golden_image.h"
+#include "panel_scenes.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A frame as the layered window ends up with it: transparent outside the painted area, corners
+// cut when the border is rounded
+void render(panel_scene& scene, software_canvas& c) {
+    c.clear(canvas_color::argb(0, 0, 0, 0));
+    scene.paint(c);
+    if (scene.options().rounded) apply_rounded_corner_alpha(c.bits(), c.width(), c.height(), 8.0f);
+}
+
+void check_scene(const char* name, const panel_scene_options& options) {
+    panel_scene scene;
+    scene.setup(options);
+    software_canvas c(options.width, options.height);
+    render(scene, c);
+    check_golden(name, c);
+}
+
+// Records what paint_panel asks of the window
+class recording_layers : public panel_paint_layers {
+public:
+    recording_layers() : spectrum_calls(0), depth(0), max_depth(0), balanced(true) {}
+
+    void spectrum(canvas&, int left, int top, int right, int bottom) override {
+        spectrum_calls++;
+        area[0] = left;
+        area[1] = top;
+        area[2] = right;
+        area[3] = bottom;
+    }
+    void phase_begin(panel_paint_phase) override {
+        depth++;
+        if (depth > max_depth) max_depth = depth;
+    }
+    void phase_end(panel_paint_phase) override {
+        depth--;
+        if (depth < 0) balanced = false;
+    }
+
+    int spectrum_calls;
+    int area[4];
+    int depth;
+    int max_depth;
+    bool balanced;
+};
+
+}
+
+TEST_CASE(panel_paint, docked_golden) {
+    check_scene("panel_docked_dark", panel_scene_defaults(panel_scene_docked, 1.0f));
+
+    panel_scene_options options = panel_scene_defaults(panel_scene_docked, 1.5f);
+    options.background_style = 1;
+    check_scene("panel_docked_artwork_colors_150dpi", options);
+}
+
+TEST_CASE(panel_paint, undocked_golden) {
+    panel_scene_options options = panel_scene_defaults(panel_scene_undocked, 1.0f);
+    options.dark = false;
+    options.rounded = true;
+    options.hovered = panel_button_next;
+    check_scene("panel_undocked_light_rounded_hover", options);
+}
+
+TEST_CASE(panel_paint, compact_golden) {
+    panel_scene_options options = panel_scene_defaults(panel_scene_compact, 1.0f);
+    options.background_style = 2;
+    check_scene("panel_compact_blurred_waveform", options);
+
+    options = panel_scene_defaults(panel_scene_compact_controls, 1.0f);
+    options.hovered = panel_button_play_pause;
+    check_scene("panel_compact_controls", options);
+}
+
+TEST_CASE(panel_paint, expanded_golden) {
+    check_scene("panel_expanded_overlay", panel_scene_defaults(panel_scene_expanded_overlay, 1.0f));
+
+    panel_scene_options options = panel_scene_defaults(panel_scene_expanded, 1.0f);
+    options.cover = false;
+    check_scene("panel_expanded_placeholder", options);
+}
+
+TEST_CASE(panel_paint, popup_golden) {
+    panel_scene_options options = panel_scene_defaults(panel_scene_popup, 1.0f);
+    options.background_style = 2;
+    options.rounded = true;
+    check_scene("popup_blurred_rounded", options);
+
+    options = panel_scene_defaults(panel_scene_popup, 1.0f);
+    options.dark = false;
+    options.cover = false;
+    check_scene("popup_light_placeholder", options);
+}
+
+TEST_CASE(panel_paint, ticker_scrolls_only_overflowing_lines) {
+    panel_scene scene;
+    panel_scene_options options = panel_scene_defaults(panel_scene_docked, 1.0f);
+    scene.setup(options);
+    panel_paint_state& state = scene.panel();
+    software_canvas c(options.width, options.height);
+
+    // The long title overflows and scrolls; the short artist fits
+    scene.paint(c);
+    CHECK(state.title_ticker->active);
+    CHECK(!state.title_ticker->changed);
+    CHECK(!state.artist_ticker->active);
+    CHECK(state.artist_ticker->offset == 0.0f);
+
+    // Offsets past the overflow are clamped and turn the ticker around
+    state.title_ticker->offset = 100000.0f;
+    scene.paint(c);
+    CHECK(state.title_ticker->offset > 0.0f && state.title_ticker->offset < 1000.0f);
+    CHECK(state.title_ticker->direction == -1);
+    float end = state.title_ticker->offset;
+
+    // A new title starts over from the left
+    state.title_ticker->changed = true;
+    scene.paint(c);
+    CHECK(state.title_ticker->offset == 0.0f && state.title_ticker->direction == 1);
+
+    // Ticker Speed Off: the line is cut instead
+    state.title_ticker->enabled = false;
+    state.title_ticker->offset = end;
+    scene.paint(c);
+    CHECK(!state.title_ticker->active);
+}
+
+TEST_CASE(panel_paint, cover_size_follows_mode_and_margin) {
+    panel_scene scene;
+    scene.setup(panel_scene_defaults(panel_scene_docked, 1.0f));
+    panel_paint_state& state = scene.panel();
+    state.width = 340;
+    state.height = 110;
+    CHECK(panel_cover_size(state) == 80);
+    state.height = 90;
+    CHECK(panel_cover_size(state) == 60);
+    state.cover_margin = false;
+    CHECK(panel_cover_size(state) == 90);
+    state.show_cover_art = false;
+    CHECK(panel_cover_size(state) == 0);
+
+    state.show_cover_art = true;
+    state.cover_margin = true;
+    state.mode = panel_mode_compact;
+    state.height = 72;
+    CHECK(panel_cover_size(state) == 62);
+}
+
+TEST_CASE(panel_paint, compact_asks_for_spectrum_and_caches_waveform_columns) {
+    panel_scene scene;
+    panel_scene_options options = panel_scene_defaults(panel_scene_compact, 1.0f);
+    scene.setup(options);
+    panel_paint_state& state = scene.panel();
+    recording_layers layers;
+    state.layers = &layers;
+    state.spectrum = true;
+    software_canvas c(options.width, options.height);
+    scene.paint(c);
+
+    CHECK(layers.spectrum_calls == 1);
+    int band_top = 0, band_height = 0;
+    panel_compact_progress_band(options.height, true, band_top, band_height);
+    CHECK(layers.area[1] == 5 && layers.area[3] == band_top - 2);
+    CHECK(layers.area[0] < layers.area[2] && layers.area[2] == options.width - 5);
+    CHECK(layers.balanced && layers.depth == 0 && layers.max_depth >= 1);
+
+    // One column per pixel of the bar, split at the playback position
+    panel_waveform& waveform = *state.waveform;
+    CHECK(waveform.columns_generation == waveform.generation);
+    CHECK(!waveform.column_max.empty());
+    CHECK(waveform.played.size() + waveform.remaining.size() == waveform.column_max.size());
+    size_t played = waveform.played.size();
+    CHECK(played > 0 && played < waveform.column_max.size());
+
+    // A later position moves the split without rebuilding the envelope
+    state.position = state.length;
+    scene.paint(c);
+    CHECK(waveform.played.size() > played);
+    CHECK(waveform.remaining.empty());
+}
+
+TEST_CASE(panel_paint, compact_progress_band_centers_waveform_on_bar) {
+    int bar_top = 0, bar_height = 0, wave_top = 0, wave_height = 0;
+    panel_compact_progress_band(72, false, bar_top, bar_height);
+    panel_compact_progress_band(72, true, wave_top, wave_height);
+    CHECK(wave_height > bar_height);
+    CHECK(std::abs((wave_top + wave_height / 2) - (bar_top + bar_height / 2)) <= 1);
+}
+
+TEST_CASE(panel_paint, artwork_backgrounds_from_a_solid_cover) {
+    std::vector<uint8_t> pixels(40 * 30 * 4);
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        pixels[i + 0] = 30;
+        pixels[i + 1] = 90;
+        pixels[i + 2] = 200;
+        pixels[i + 3] = 255;
+    }
+    canvas_image art = { pixels.data(), 40, 30, 40 * 4, false };
+
+    canvas_color color = {};
+    REQUIRE(average_artwork_color(art, color));
+    CHECK(color.r == 200 && color.g == 90 && color.b == 30 && color.a == 255);
+
+    std::vector<uint8_t> blurred;
+    build_blurred_background(art, 50, 20, 4, 8, blurred);
+    REQUIRE(blurred.size() == (size_t)50 * 20 * 4);
+    for (size_t i = 0; i < blurred.size(); i += 4) {
+        CHECK(blurred[i + 0] == 30 && blurred[i + 1] == 90 && blurred[i + 2] == 200 && blurred[i + 3] == 255);
+    }
+
+    canvas_image empty = {};
+    CHECK(!average_artwork_color(empty, color));
+    build_blurred_background(empty, 50, 20, 4, 8, blurred);
+    CHECK(blurred.empty());
+}
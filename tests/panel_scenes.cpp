@@ -0,0 +1,223 @@
+#include "panel_scenes.h"
+#include <cmath>
+
+namespace {
+
+const int COVER_SIZE = 300;
+
+panel_theme make_theme(bool dark) {
+    // control_panel::update_theme_colors
+    panel_theme theme;
+    theme.dark = dark;
+    if (dark) {
+        theme.background = canvas_color::rgb(32, 32, 32);
+        theme.text = canvas_color::rgb(255, 255, 255);
+        theme.text_dim = canvas_color::rgb(180, 180, 180);
+        theme.placeholder = canvas_color::rgb(60, 60, 60);
+        theme.progress_background = canvas_color::rgb(80, 80, 80);
+        theme.icon = canvas_color::rgb(255, 255, 255);
+    } else {
+        theme.background = canvas_color::rgb(245, 245, 245);
+        theme.text = canvas_color::rgb(32, 32, 32);
+        theme.text_dim = canvas_color::rgb(100, 100, 100);
+        theme.placeholder = canvas_color::rgb(200, 200, 200);
+        theme.progress_background = canvas_color::rgb(200, 200, 200);
+        theme.icon = canvas_color::rgb(50, 50, 50);
+    }
+    return theme;
+}
+
+// Points to a LOGFONT height at the scene's DPI, as get_dpi_scaled_font_height does
+int font_height(int points, float dpi_scale) {
+    return -(int)std::floor(points * 96.0f * dpi_scale / 72.0f + 0.5f);
+}
+
+// Opaque cover with hard edges and gradients, so scaling, cropping and blurring all show
+void paint_cover(software_canvas& c) {
+    const float s = (float)COVER_SIZE;
+    canvas_rect all = { 0, 0, s, s };
+    c.fill_linear_gradient(all, 0.0f, canvas_color::rgb(40, 20, 90), canvas_color::rgb(230, 120, 40));
+    c.fill_ellipse(s * 0.15f, s * 0.2f, s * 0.5f, s * 0.5f, canvas_color::argb(200, 250, 220, 80));
+    c.fill_rect(s * 0.55f, s * 0.55f, s * 0.35f, s * 0.3f, canvas_color::rgb(20, 140, 160));
+    c.draw_line(0, s, s, 0, s * 0.03f, canvas_color::rgb(255, 255, 255));
+}
+
+}
+
+const char* panel_scene_mode_name(panel_scene_mode mode) {
+    switch (mode) {
+    case panel_scene_docked: return "docked";
+    case panel_scene_undocked: return "undocked";
+    case panel_scene_compact: return "compact";
+    case panel_scene_compact_controls: return "compact_controls";
+    case panel_scene_expanded: return "expanded";
+    case panel_scene_expanded_overlay: return "expanded_overlay";
+    case panel_scene_popup: return "popup";
+    default: return "unknown";
+    }
+}
+
+void panel_scene_base_size(panel_scene_mode mode, bool large, int& width, int& height) {
+    switch (mode) {
+    case panel_scene_compact:
+    case panel_scene_compact_controls:
+        width = large ? 420 : 300;
+        height = large ? 96 : 72;
+        break;
+    case panel_scene_expanded:
+    case panel_scene_expanded_overlay:
+        width = height = large ? 500 : 300;
+        break;
+    case panel_scene_popup:
+        width = large ? 420 : 320;
+        height = 80;
+        break;
+    default:
+        width = large ? 480 : 340;
+        height = 110;
+        break;
+    }
+}
+
+panel_scene_options panel_scene_defaults(panel_scene_mode mode, float dpi_scale) {
+    panel_scene_options options = {};
+    options.mode = mode;
+    panel_scene_base_size(mode, false, options.width, options.height);
+    options.width = (int)(options.width * dpi_scale);
+    options.height = (int)(options.height * dpi_scale);
+    options.dpi_scale = dpi_scale;
+    options.dark = true;
+    options.background_style = 0;
+    options.rounded = false;
+    options.cover = true;
+    options.hovered = panel_button_none;
+    return options;
+}
+
+panel_scene::panel_scene()
+    : m_options(panel_scene_defaults(panel_scene_docked, 1.0f))
+    , m_cover(COVER_SIZE, COVER_SIZE)
+    , m_cover_image()
+    , m_peaks()
+    , m_waveform()
+    , m_title_ticker()
+    , m_artist_ticker()
+    , m_panel()
+    , m_popup() {
+    paint_cover(m_cover);
+    m_cover_image = { m_cover.bits(), m_cover.width(), m_cover.height(), m_cover.stride(), false };
+
+    // A decaying tone with a swell in the middle, enough buckets for any width
+    const int buckets = 2000;
+    m_peaks.min.resize(buckets);
+    m_peaks.max.resize(buckets);
+    for (int i = 0; i < buckets; i++) {
+        float t = (float)i / buckets;
+        float level = 0.25f + 0.7f * std::fabs(std::sin(t * 9.0f)) * (1.0f - 0.5f * t);
+        m_peaks.max[i] = (int8_t)(127 * level);
+        m_peaks.min[i] = (int8_t)(-127 * level * 0.9f);
+    }
+    m_waveform.peaks = &m_peaks;
+    m_waveform.generation = 1;
+}
+
+void panel_scene::setup(const panel_scene_options& o) {
+    m_options = o;
+    const float dpi = o.dpi_scale;
+    const bool compact = o.mode == panel_scene_compact || o.mode == panel_scene_compact_controls;
+    const bool expanded = o.mode == panel_scene_expanded || o.mode == panel_scene_expanded_overlay;
+
+    canvas_color artwork_color = {};
+    bool has_artwork_color = o.cover && average_artwork_color(m_cover_image, artwork_color);
+    m_blurred_background.clear();
+    canvas_image blurred = {};
+    if (o.cover && o.background_style == 2) {
+        // The popup blurs evenly; the panel blurs twice as far vertically (control_panel)
+        int radius_y = o.mode == panel_scene_popup ? 4 : 8;
+        build_blurred_background(m_cover_image, o.width, o.height, 4, radius_y, m_blurred_background);
+        blurred = { m_blurred_background.data(), o.width, o.height, o.width * 4, false };
+    }
+
+    if (o.mode == panel_scene_popup) {
+        m_popup = popup_paint_state();
+        m_popup.width = o.width;
+        m_popup.height = o.height;
+        m_popup.dark = o.dark || o.background_style != 0;
+        m_popup.background_style = o.background_style;
+        m_popup.has_artwork_color = has_artwork_color;
+        m_popup.artwork_color = artwork_color;
+        m_popup.blurred_background = blurred;
+        m_popup.show_cover_art = true;
+        m_popup.cover_margin = true;
+        m_popup.rounded_cover = o.rounded;
+        if (o.cover) m_popup.cover = m_cover_image;
+        m_popup.title = L"Midnight City (Extended Version)";
+        m_popup.artist = L"M83";
+        m_popup.title_font = canvas_font::make(L"Segoe UI", font_height(11, dpi), 700);
+        m_popup.artist_font = canvas_font::make(L"Segoe UI", font_height(9, dpi), 400);
+        return;
+    }
+
+    m_title_ticker = { 0.0f, 1, true, true, false };
+    m_artist_ticker = { 0.0f, 1, true, true, false };
+
+    panel_paint_state& s = m_panel;
+    s = panel_paint_state();
+    s.width = o.width;
+    s.height = o.height;
+    s.mode = compact ? panel_mode_compact : (expanded ? panel_mode_expanded : panel_mode_panel);
+    s.undocked = o.mode == panel_scene_undocked;
+    s.theme = make_theme(o.dark);
+    s.accent = canvas_color::rgb(100, 149, 237);
+    s.background_style = o.background_style;
+    s.rounded_border = o.rounded;
+    s.show_cover_art = true;
+    s.cover_margin = true;
+    s.rounded_cover = o.rounded;
+    s.icon_style = 0;
+    s.hover_circles = true;
+    if (o.cover) {
+        s.cover = m_cover_image;
+        s.expanded_art = m_cover_image;
+    }
+    s.blurred_background = blurred;
+    s.has_artwork_color = has_artwork_color;
+    s.artwork_color = artwork_color;
+    s.stream_placeholder = false;
+
+    s.title = L"Midnight City (Extended Version)";
+    s.artist = L"M83";
+    s.title_font = canvas_font::make(L"Segoe UI", font_height(compact ? 15 : (expanded ? 20 : 14), dpi), 700);
+    s.artist_font = canvas_font::make(L"Segoe UI", font_height(compact ? 12 : (expanded ? 14 : 11), dpi), 400);
+    s.timer_font = canvas_font::make(L"Segoe UI", font_height(11, dpi), 400);
+    s.title_ticker = &m_title_ticker;
+    s.artist_ticker = &m_artist_ticker;
+    s.playing = true;
+    s.paused = false;
+    s.position = 83.0;
+    s.length = 243.0;
+    s.shuffle = true;
+    s.repeat_mode = 1;
+
+    s.hovered = o.hovered;
+    s.button_opacity = 100;
+    s.overlay_visible = o.mode == panel_scene_expanded_overlay;
+    s.overlay_opacity = s.overlay_visible ? 100 : 0;
+    s.artwork_overlay_visible = false;
+    s.artwork_overlay_opacity = 0;
+    s.compact_controls_visible = o.mode == panel_scene_compact_controls;
+    s.corner_controls = s.undocked || s.compact_controls_visible;
+
+    s.waveform = compact ? &m_waveform : nullptr;
+    s.waveform_seekbar = compact;
+    s.spectrum = false;
+    s.layers = nullptr;
+}
+
+void panel_scene::paint(canvas& c) {
+    if (m_options.mode == panel_scene_popup) {
+        paint_popup(c, m_popup);
+    } else {
+        paint_panel(c, m_panel);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+// Control panel and popup frames as the window paints them, for the golden-image tests and
+// panel_paint_bench: a synthetic cover, the window's default themes and fonts, and a
+// panel_paint_state (or popup_paint_state) per mode at any size and DPI scale.
+
+#include "../panel_paint.h"
+#include "../popup_paint.h"
+#include "../software_canvas.h"
+#include <vector>
+
+enum panel_scene_mode {
+    panel_scene_docked,
+    panel_scene_undocked,
+    panel_scene_compact,
+    panel_scene_compact_controls,   // Compact with the pointer over it
+    panel_scene_expanded,
+    panel_scene_expanded_overlay,   // Expanded with the track and control overlays
+    panel_scene_popup,
+    panel_scene_mode_count
+};
+
+const char* panel_scene_mode_name(panel_scene_mode mode);
+
+// Window size of a mode at 96 DPI; large is the bigger of the two sizes the bench renders
+void panel_scene_base_size(panel_scene_mode mode, bool large, int& width, int& height);
+
+struct panel_scene_options {
+    panel_scene_mode mode;
+    int width;
+    int height;
+    float dpi_scale;            // Fonts scale with it; the caller scales the size
+    bool dark;
+    int background_style;       // 0 = Solid, 1 = Artwork Colors, 2 = Blurred Artwork
+    bool rounded;               // Rounded border (and rounded artwork)
+    bool cover;                 // False: no artwork loaded (the placeholder)
+    panel_button hovered;
+};
+
+panel_scene_options panel_scene_defaults(panel_scene_mode mode, float dpi_scale);
+
+// Owns everything a state points at. setup() rebuilds the state (and the blurred background,
+// as the window does when the artwork or size changes); paint() draws one frame.
+class panel_scene {
+public:
+    panel_scene();
+
+    void setup(const panel_scene_options& options);
+    void paint(canvas& c);
+
+    const panel_scene_options& options() const { return m_options; }
+    panel_paint_state& panel() { return m_panel; }
+    const canvas_image& cover() const { return m_cover_image; }
+
+private:
+    panel_scene_options m_options;
+    software_canvas m_cover;
+    canvas_image m_cover_image;
+    std::vector<uint8_t> m_blurred_background;
+    waveform_peaks m_peaks;
+    panel_waveform m_waveform;
+    panel_ticker m_title_ticker;
+    panel_ticker m_artist_ticker;
+    panel_paint_state m_panel;
+    popup_paint_state m_popup;
+};
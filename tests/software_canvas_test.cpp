@@ -0,0 +1,162 @@
+#include "test_harness.h"
+#include "../software_canvas.h"
+#include "../volume_osd_paint.h"
+#include "golden_image.h"
+#include <vector>
+
+namespace {
+
+volume_osd_style make_osd_style(float scale, bool dark, float volume) {
+    // volume_popup's feedback OSD
+    volume_osd_style style = {};
+    style.width = (int)(202 * scale + 0.5f);
+    style.height = (int)(36 * scale + 0.5f);
+    style.dpi_scale = scale;
+    style.dark = dark;
+    style.rounded_corners = true;
+    style.volume = volume;
+    style.accent = canvas_color::rgb(0x3A, 0x8E, 0xE6);
+    style.icon_x = 14;
+    style.icon_size = 20;
+    style.track_x = 44;
+    style.text_width = 46;
+    return style;
+}
+
+}
+
+TEST_CASE(software_canvas, primitives_golden) {
+    software_canvas c(160, 120);
+    c.clear(canvas_color::rgb(24, 24, 28));
+    c.fill_rect(8.5f, 8.25f, 40.0f, 20.5f, canvas_color::rgb(230, 60, 60));
+    c.fill_rounded_rect(56, 8, 44, 30, 9, canvas_color::argb(200, 60, 200, 90));
+    c.fill_ellipse(108, 6, 44, 34, canvas_color::rgb(70, 120, 240));
+    const canvas_point star[] = {
+        { 30, 48 }, { 36, 64 }, { 53, 64 }, { 39, 74 }, { 45, 91 },
+        { 30, 81 }, { 15, 91 }, { 21, 74 }, { 7, 64 }, { 24, 64 },
+    };
+    c.fill_polygon(star, 10, canvas_color::rgb(250, 200, 40));
+    c.stroke_rounded_rect(62, 50, 40, 36, 8, 2.5f, canvas_color::rgb(240, 240, 240));
+    c.draw_line(110, 50, 152, 90, 3.0f, canvas_color::argb(180, 255, 128, 0));
+    c.draw_line(110, 90, 152, 52, 1.0f, canvas_color::rgb(255, 255, 255));
+    c.draw_arc(10, 96, 20, 20, -90, 270, 2.0f, canvas_color::rgb(120, 220, 255));
+    c.draw_text(L"100%", 40, 96, 110, 20, 9.0f, canvas_align_center, canvas_color::rgb(200, 200, 200));
+    check_golden("primitives", c);
+}
+
+TEST_CASE(software_canvas, panel_primitives_golden) {
+    // What the control panel modes add: gradients, paths with holes, images, font text and clips
+    software_canvas c(160, 120);
+    c.clear(canvas_color::rgb(24, 24, 28));
+    canvas_rect band = { 4, 4, 152, 24 };
+    c.fill_linear_gradient(band, 6.0f, canvas_color::rgb(30, 60, 120), canvas_color::rgb(200, 90, 40));
+
+    const canvas_point ring[] = {
+        { 8, 36 }, { 48, 36 }, { 48, 76 }, { 8, 76 },
+        { 18, 46 }, { 18, 66 }, { 38, 66 }, { 38, 46 },
+    };
+    const int ring_sizes[] = { 4, 4 };
+    c.fill_path(ring, ring_sizes, 2, canvas_color::rgb(240, 200, 60));
+
+    std::vector<uint8_t> pixels(8 * 8 * 4);
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            uint8_t* px = &pixels[(y * 8 + x) * 4];
+            px[0] = (uint8_t)(x * 32);
+            px[1] = (uint8_t)(y * 32);
+            px[2] = (uint8_t)((x ^ y) & 1 ? 255 : 60);
+            px[3] = 255;
+        }
+    }
+    canvas_image image = { pixels.data(), 8, 8, 8 * 4, false };
+    canvas_rect image_source = { 0, 0, 8, 8 };
+    canvas_rect image_dest = { 56, 36, 40, 40 };
+    c.draw_image(image, image_dest, image_source, 8.0f);
+    canvas_rect rows[] = { { 104, 36, 4, 40 }, { 112, 46, 4, 30 }, { 120, 56, 4, 20 }, { 128, 66, 4, 10 } };
+    c.fill_rects(rows, 4, canvas_color::rgb(100, 149, 237));
+
+    canvas_font font = canvas_font::make(L"Segoe UI", -12, 700);
+    canvas_rect line = { 8, 84, 70, 16 };
+    c.draw_text(font, L"A title far too long to fit", line, canvas_align_near, canvas_color::rgb(255, 255, 255),
+        canvas_text_end_ellipsis);
+    c.set_clip(90, 84, 60, 16);
+    canvas_rect scrolled = { 70, 84, 200, 16 };
+    c.draw_text(font, L"Scrolled and clipped", scrolled, canvas_align_near, canvas_color::rgb(180, 180, 180), 0);
+    c.reset_clip();
+    c.fill_rect(8, 104, 144, 8, canvas_color::argb(128, 255, 255, 255));
+    check_golden("panel_primitives", c);
+}
+
+TEST_CASE(software_canvas, volume_osd_golden) {
+    struct scene {
+        const char* name;
+        float scale;
+        bool dark;
+        float volume;
+    };
+    const scene scenes[] = {
+        { "volume_osd_dark_60", 1.0f, true, 0.6f },
+        { "volume_osd_light_muted", 1.0f, false, 0.0f },
+        { "volume_osd_dark_150dpi", 1.5f, true, 1.0f },
+    };
+    for (const scene& s : scenes) {
+        volume_osd_style style = make_osd_style(s.scale, s.dark, s.volume);
+        software_canvas c(style.width, style.height);
+        c.clear(canvas_color::argb(0, 0, 0, 0));
+        paint_volume_osd(c, style);
+        check_golden(s.name, c);
+    }
+}
+
+TEST_CASE(software_canvas, rounded_corner_alpha_golden) {
+    software_canvas c(64, 48);
+    c.clear(canvas_color::rgb(200, 100, 50));
+    apply_rounded_corner_alpha(c.bits(), c.width(), c.height(), 12.0f);
+    check_golden("rounded_corner_alpha", c);
+
+    // Corners are transparent, the middle untouched, and the result stays premultiplied
+    CHECK(c.bits()[3] == 0);
+    const uint8_t* middle = c.bits() + (size_t)24 * c.stride() + 32 * 4;
+    CHECK(middle[3] == 255 && middle[2] == 200 && middle[1] == 100 && middle[0] == 50);
+    for (int i = 0; i < c.width() * c.height() * 4; i += 4) {
+        const uint8_t* p = c.bits() + i;
+        CHECK(p[0] <= p[3] && p[1] <= p[3] && p[2] <= p[3]);
+    }
+}
+
+TEST_CASE(software_canvas, blends_premultiplied_source_over) {
+    software_canvas c(4, 4);
+    c.clear(canvas_color::argb(128, 255, 0, 0));
+    const uint8_t* p = c.bits();
+    CHECK(p[0] == 0 && p[1] == 0 && p[2] == 128 && p[3] == 128);
+
+    // Whole pixels are covered exactly; half a pixel blends at half strength
+    c.fill_rect(0, 0, 1, 1, canvas_color::rgb(0, 0, 255));
+    CHECK(p[0] == 255 && p[1] == 0 && p[2] == 0 && p[3] == 255);
+    c.fill_rect(1, 0, 0.5f, 1, canvas_color::rgb(0, 255, 0));
+    CHECK(p[4 + 1] == 128 && p[4 + 2] == 64 && p[4 + 3] == 192);
+
+    // Nothing drawn outside the canvas or with nothing to fill
+    c.fill_rect(-10, -10, 5, 5, canvas_color::rgb(255, 255, 255));
+    c.fill_rect(2, 2, 0, 5, canvas_color::rgb(255, 255, 255));
+    const uint8_t* untouched = p + 2 * c.stride() + 2 * 4;
+    CHECK(untouched[2] == 128 && untouched[3] == 128);
+}
+
+TEST_CASE(software_canvas, draws_into_caller_memory_within_stride) {
+    // A DIB section row can be wider than the image; the padding must survive
+    const int width = 5, height = 3, stride = 28;
+    std::vector<uint8_t> bits(stride * height, 0xAB);
+    software_canvas c(bits.data(), width, height, stride);
+    c.clear(canvas_color::rgb(1, 2, 3));
+    c.fill_ellipse(-2, -2, 12, 8, canvas_color::rgb(9, 9, 9));
+    for (int y = 0; y < height; y++) {
+        for (int i = width * 4; i < stride; i++) CHECK(bits[y * stride + i] == 0xAB);
+        CHECK(bits[y * stride + 3] == 255);
+    }
+
+    software_canvas empty(nullptr, 10, 10, 40);
+    CHECK(empty.width() == 0 && empty.height() == 0);
+    empty.clear(canvas_color::rgb(0, 0, 0));
+    empty.fill_rect(0, 0, 5, 5, canvas_color::rgb(0, 0, 0));
+}
@@ -0,0 +1,225 @@
+#include "test_harness.h"
+#include "../spectrum_analyzer.h"
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+// Counts every allocation in the test program, so the suite can check that analyze() and
+// decay() stay off the heap as the visualizer's frame loop expects
+static std::atomic<size_t> g_allocations(0);
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+std::vector<float> make_sine(size_t frames, double hz, double sample_rate, double amplitude) {
+    std::vector<float> samples(frames);
+    for (size_t i = 0; i < frames; i++) samples[i] = (float)(amplitude * sin(2 * PI * hz * (double)i / sample_rate));
+    return samples;
+}
+
+// Power of bin k the slow way, with the analyzer's Hann window and full-scale normalization
+double dft_power(const std::vector<float>& input, unsigned k) {
+    size_t n = input.size();
+    double re = 0, im = 0;
+    for (size_t i = 0; i < n; i++) {
+        double windowed = input[i] * (0.5 - 0.5 * cos(2.0 * PI * (double)i / (double)n));
+        re += windowed * cos(2.0 * PI * (double)k * (double)i / (double)n);
+        im -= windowed * sin(2.0 * PI * (double)k * (double)i / (double)n);
+    }
+    double scale = 4.0 / (double)n;
+    return (re * re + im * im) * scale * scale;
+}
+
+unsigned loudest_band(const spectrum_analyzer& analyzer) {
+    unsigned loudest = 0;
+    for (unsigned b = 1; b < analyzer.band_count(); b++) {
+        if (analyzer.levels()[b] > analyzer.levels()[loudest]) loudest = b;
+    }
+    return loudest;
+}
+
+}
+
+TEST_CASE(spectrum_analyzer, fft_matches_dft) {
+    const unsigned sizes[] = { 64, 256, 2048 };
+    std::mt19937 rng(46);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    for (unsigned size : sizes) {
+        // Noise plus a tone, so every bin has something in it
+        std::vector<float> input = make_sine(size, 1000.0, 44100.0, 0.5);
+        for (float& s : input) s += 0.3f * noise(rng);
+
+        spectrum_analyzer analyzer;
+        analyzer.configure(size, 16, 44100.0f, 20.0f, 20000.0f);
+        REQUIRE(analyzer.fft_size() == size);
+        analyzer.load(input.data(), size, 1);
+        analyzer.analyze(0.016f);
+
+        double peak = 0;
+        for (unsigned k = 0; k <= size / 2; k++) peak = std::max(peak, dft_power(input, k));
+        for (unsigned k = 0; k <= size / 2; k++) {
+            CHECK_NEAR(analyzer.bin_power(k), dft_power(input, k), 1e-4 * peak);
+        }
+    }
+}
+
+TEST_CASE(spectrum_analyzer, sine_sweep_peaks_in_its_bin_and_band) {
+    const unsigned size = 4096;
+    const float rate = 48000.0f;
+    const double bin_hz = rate / size;
+    spectrum_analyzer analyzer;
+    analyzer.configure(size, 24, rate, 30.0f, 16000.0f);
+
+    unsigned last_band = 0;
+    for (unsigned bin = 4; bin < size / 2; bin = bin * 5 / 4 + 1) {
+        if (bin * bin_hz > 16000.0) break;
+        // Stereo, one channel phase-shifted, at a bin centre: a full-scale sine reads as 1
+        std::vector<float> mono = make_sine(size, bin * bin_hz, rate, 1.0);
+        std::vector<float> stereo(size * 2);
+        for (unsigned i = 0; i < size; i++) stereo[2 * i] = stereo[2 * i + 1] = mono[i];
+
+        analyzer.reset();
+        analyzer.load(stereo.data(), size, 2);
+        for (int frame = 0; frame < 20; frame++) analyzer.analyze(0.016f);
+
+        unsigned peak_bin = 0;
+        for (unsigned k = 1; k <= size / 2; k++) {
+            if (analyzer.bin_power(k) > analyzer.bin_power(peak_bin)) peak_bin = k;
+        }
+        CHECK(peak_bin == bin);
+        CHECK_NEAR(analyzer.bin_power(bin), 1.0, 0.01);
+
+        // Bands are ordered by frequency, so the loudest one walks up with the sweep
+        unsigned band = loudest_band(analyzer);
+        CHECK(band >= last_band);
+        CHECK(analyzer.levels()[band] > 0.95f);
+        last_band = band;
+    }
+    CHECK(last_band >= analyzer.band_count() - 2);
+}
+
+TEST_CASE(spectrum_analyzer, attack_and_release) {
+    spectrum_analyzer analyzer;
+    analyzer.configure(1024, 8, 44100.0f, 50.0f, 15000.0f);
+    std::vector<float> tone = make_sine(1024, 1000.0, 44100.0, 1.0);
+    analyzer.load(tone.data(), tone.size(), 1);
+
+    // Attack is ten times faster than release
+    analyzer.analyze(spectrum_analyzer::ATTACK_SECONDS);
+    unsigned band = loudest_band(analyzer);
+    float attacked = analyzer.levels()[band];
+    CHECK(attacked > 0.55f && attacked < 0.7f);
+
+    for (int frame = 0; frame < 50; frame++) analyzer.analyze(0.016f);
+    float full = analyzer.levels()[band];
+    analyzer.decay(spectrum_analyzer::ATTACK_SECONDS);
+    CHECK(analyzer.levels()[band] > 0.85f * full);
+    CHECK(!analyzer.is_silent());
+
+    for (int frame = 0; frame < 200 && !analyzer.is_silent(); frame++) analyzer.decay(0.016f);
+    CHECK(analyzer.is_silent());
+
+    analyzer.analyze(0.016f);
+    CHECK(!analyzer.is_silent());
+    analyzer.reset();
+    CHECK(analyzer.is_silent());
+}
+
+TEST_CASE(spectrum_analyzer, frame_loop_does_not_allocate) {
+    spectrum_analyzer analyzer;
+    analyzer.configure(2048, 32, 44100.0f, 20.0f, 20000.0f);
+    std::vector<float> samples = make_sine(4096 * 2, 440.0, 44100.0, 0.7);
+    std::vector<double> samples_d(samples.begin(), samples.end());
+
+    size_t before = g_allocations.load();
+    for (int frame = 0; frame < 100; frame++) {
+        analyzer.load(samples.data(), 4096, 2);
+        analyzer.analyze(0.016f);
+        analyzer.load(samples_d.data(), 1000, 2);
+        analyzer.analyze(0.016f);
+        analyzer.decay(0.016f);
+    }
+    CHECK(g_allocations.load() == before);
+
+    // The counter does see allocations
+    std::vector<float>* probe = new std::vector<float>(16);
+    CHECK(g_allocations.load() > before);
+    delete probe;
+}
+
+TEST_CASE(spectrum_analyzer, simd_helpers_match_scalar) {
+    std::mt19937 rng(4646);
+    std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+    for (size_t n = 0; n <= 19; n++) {
+        std::vector<float> a(n), b(n), out(n);
+        for (size_t i = 0; i < n; i++) {
+            a[i] = value(rng);
+            b[i] = value(rng);
+        }
+        spectrum_apply_window(a.data(), b.data(), out.data(), n);
+        for (size_t i = 0; i < n; i++) CHECK(out[i] == a[i] * b[i]);
+        spectrum_power(a.data(), b.data(), out.data(), n, 0.5f);
+        for (size_t i = 0; i < n; i++) CHECK(out[i] == (a[i] * a[i] + b[i] * b[i]) * 0.5f);
+    }
+}
+
+TEST_CASE(spectrum_analyzer, bars_blend_bottom_aligned) {
+    const int width = 8, height = 10, stride = width * 4;
+    std::vector<uint8_t> pixels(stride * height, 0);
+    const float levels[2] = { 0.5f, 0.0f };
+    blend_spectrum_bars_bgra(pixels.data(), stride, 0, 0, width, height, levels, 2, 0x00FF8000, 255);
+
+    // First bar: 4 px wide less a 1 px gap, bottom 5 rows
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            const uint8_t* p = &pixels[row * stride + col * 4];
+            bool lit = row >= 5 && col < 3;
+            CHECK(p[2] == (lit ? 0xFF : 0));
+            CHECK(p[1] == (lit ? 0x80 : 0));
+            CHECK(p[0] == 0);
+        }
+    }
+}
+
+TEST_CASE(spectrum_analyzer, governor_stretches_interval_to_budget) {
+    // 16..100 ms, at most 5% of a core
+    spectrum_frame_governor governor(16, 100, 0.05f);
+    CHECK(governor.interval_ms() == 16);
+
+    for (int frame = 0; frame < 30; frame++) governor.add_frame_cost(0.4);
+    CHECK(governor.interval_ms() == 16);
+
+    // 2 ms frames need 40 ms between them
+    for (int frame = 0; frame < 100; frame++) governor.add_frame_cost(2.0);
+    CHECK_NEAR(governor.average_cost_ms(), 2.0, 0.01);
+    CHECK(governor.interval_ms() >= 40 && governor.interval_ms() <= 41);
+
+    // A single stall stretches the interval only for a while, and never past the maximum
+    governor.add_frame_cost(500.0);
+    CHECK(governor.interval_ms() == 100);
+    for (int frame = 0; frame < 100; frame++) governor.add_frame_cost(2.0);
+    CHECK(governor.interval_ms() <= 41);
+
+    governor.reset();
+    CHECK(governor.interval_ms() == 16);
+    CHECK(governor.average_cost_ms() == 0.0);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Minimal test runner for the platform-independent modules (see CMakeLists.txt). Test cases
+// register themselves; traycontrols_tests runs every case, or only the suites named on the
+// command line, and exits non-zero if any check failed.
+//
+//   TEST_CASE(trace_recorder, wraps_oldest_first) {
+//       CHECK(recorder.capacity() == 8);
+//       CHECK_NEAR(value, 1.0, 1e-6);
+//   }
+
+#include <cstdio>
+#include <exception>
+
+namespace test_harness {
+
+typedef void (*test_function)();
+
+// Registration happens during static initialization; the return value only gives the
+// registering statement something to initialize
+int register_test(const char* suite, const char* name, test_function function);
+
+// Record a failed check; the case keeps running
+void report_failure(const char* file, int line, const char* expression);
+
+// Thrown by REQUIRE to abandon the current case after recording the failure
+struct abort_case : std::exception {};
+
+}
+
+#define TEST_CASE(suite, name)                                                                      \
+    static void test_##suite##_##name();                                                            \
+    static const int test_##suite##_##name##_registered =                                           \
+        test_harness::register_test(#suite, #name, &test_##suite##_##name);                         \
+    static void test_##suite##_##name()
+
+#define CHECK(expression)                                                                           \
+    do {                                                                                            \
+        if (!(expression)) test_harness::report_failure(__FILE__, __LINE__, #expression);           \
+    } while (0)
+
+#define REQUIRE(expression)                                                                         \
+    do {                                                                                            \
+        if (!(expression)) {                                                                        \
+            test_harness::report_failure(__FILE__, __LINE__, #expression);                          \
+            throw test_harness::abort_case();                                                       \
+        }                                                                                           \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                                     \
+    do {                                                                                            \
+        double test_actual_ = (double)(actual);                                                     \
+        double test_expected_ = (double)(expected);                                                 \
+        double test_difference_ = test_actual_ - test_expected_;                                    \
+        if (test_difference_ < 0) test_difference_ = -test_difference_;                             \
+        if (!(test_difference_ <= (double)(tolerance))) {                                           \
+            char test_message_[256];                                                                \
+            snprintf(test_message_, sizeof(test_message_), "%s == %s (%g vs %g, tolerance %g)",     \
+                #actual, #expected, test_actual_, test_expected_, (double)(tolerance));             \
+            test_harness::report_failure(__FILE__, __LINE__, test_message_);                        \
+        }                                                                                           \
+    } while (0)
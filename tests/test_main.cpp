@@ -0,0 +1,68 @@
+#include "test_harness.h"
+#include <cstring>
+#include <vector>
+
+namespace test_harness {
+
+struct registered_test {
+    const char* suite;
+    const char* name;
+    test_function function;
+};
+
+// Function-local so registration from other translation units does not depend on their
+// static initialization order
+static std::vector<registered_test>& get_tests() {
+    static std::vector<registered_test> tests;
+    return tests;
+}
+
+static int g_failures = 0;
+
+int register_test(const char* suite, const char* name, test_function function) {
+    get_tests().push_back({ suite, name, function });
+    return (int)get_tests().size();
+}
+
+void report_failure(const char* file, int line, const char* expression) {
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    g_failures++;
+}
+
+}
+
+using namespace test_harness;
+
+static bool is_selected(const char* suite, int argc, char** argv) {
+    if (argc < 2) return true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], suite) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    int cases = 0;
+    int failed_cases = 0;
+    for (const registered_test& test : get_tests()) {
+        if (!is_selected(test.suite, argc, argv)) continue;
+        cases++;
+        int failures_before = g_failures;
+        try {
+            test.function();
+        } catch (const abort_case&) {
+        } catch (const std::exception& e) {
+            report_failure(test.suite, 0, e.what());
+        }
+        bool passed = g_failures == failures_before;
+        if (!passed) failed_cases++;
+        printf("%-6s %s.%s\n", passed ? "ok" : "FAILED", test.suite, test.name);
+    }
+
+    if (cases == 0) {
+        fprintf(stderr, "no test cases selected\n");
+        return 1;
+    }
+    printf("%d of %d test cases passed\n", cases - failed_cases, cases);
+    return failed_cases == 0 ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+#include "test_harness.h"
+#include "../trace_recorder.h"
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Several threads record while another one snapshots, the way the Diagnostics export reads the
+// recorder the tracing macros keep writing to. Every event is tagged with its writer's
+// category and name, so a slot read halfway through a rewrite shows up as a mismatch.
+
+namespace {
+
+const int WRITERS = 4;
+const int EVENTS_PER_WRITER = 200000;
+
+const char* const g_categories[WRITERS] = { "writer0", "writer1", "writer2", "writer3" };
+const char* const g_names[WRITERS] = { "event0", "event1", "event2", "event3" };
+
+// A snapshot is oldest first, and each writer's timestamps only go up
+bool is_consistent(const std::vector<trace_event>& events) {
+    uint64_t last_timestamp[WRITERS] = {};
+    bool seen[WRITERS] = {};
+    for (size_t i = 0; i < events.size(); i++) {
+        const trace_event& event = events[i];
+        if (event.thread_id >= (uint32_t)WRITERS) return false;
+        if (event.category != g_categories[event.thread_id]) return false;
+        if (event.name != g_names[event.thread_id]) return false;
+        if (event.phase != trace_phase_instant) return false;
+        if (i > 0 && event.timestamp_us < events[i - 1].timestamp_us) return false;
+        if (seen[event.thread_id] && event.timestamp_us <= last_timestamp[event.thread_id]) return false;
+        seen[event.thread_id] = true;
+        last_timestamp[event.thread_id] = event.timestamp_us;
+    }
+    return true;
+}
+
+// Just enough of a JSON parser to tell whether the export loads in a trace viewer
+class json_checker {
+public:
+    explicit json_checker(const std::string& text) : m_text(text), m_pos(0) {}
+
+    bool is_valid() {
+        if (!value()) return false;
+        skip_space();
+        return m_pos == m_text.size();
+    }
+
+private:
+    const std::string& m_text;
+    size_t m_pos;
+
+    void skip_space() {
+        while (m_pos < m_text.size() && strchr(" \t\r\n", m_text[m_pos])) m_pos++;
+    }
+
+    bool consume(char c) {
+        skip_space();
+        if (m_pos >= m_text.size() || m_text[m_pos] != c) return false;
+        m_pos++;
+        return true;
+    }
+
+    bool string() {
+        if (!consume('"')) return false;
+        while (m_pos < m_text.size()) {
+            unsigned char c = (unsigned char)m_text[m_pos++];
+            if (c == '"') return true;
+            if (c < 0x20) return false;
+            if (c == '\\') {
+                if (m_pos >= m_text.size()) return false;
+                char escape = m_text[m_pos++];
+                if (escape == 'u') {
+                    for (int i = 0; i < 4; i++, m_pos++) {
+                        if (m_pos >= m_text.size() || !isxdigit((unsigned char)m_text[m_pos])) return false;
+                    }
+                } else if (!strchr("\"\\/bfnrt", escape)) {
+                    return false;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool number() {
+        size_t start = m_pos;
+        if (m_pos < m_text.size() && m_text[m_pos] == '-') m_pos++;
+        while (m_pos < m_text.size() && strchr("0123456789.eE+-", m_text[m_pos])) m_pos++;
+        return m_pos > start;
+    }
+
+    bool value() {
+        skip_space();
+        if (m_pos >= m_text.size()) return false;
+        char c = m_text[m_pos];
+        if (c == '{') {
+            m_pos++;
+            if (consume('}')) return true;
+            do {
+                if (!string() || !consume(':') || !value()) return false;
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            m_pos++;
+            if (consume(']')) return true;
+            do {
+                if (!value()) return false;
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') return string();
+        for (const char* word : { "true", "false", "null" }) {
+            if (m_text.compare(m_pos, strlen(word), word) == 0) {
+                m_pos += strlen(word);
+                return true;
+            }
+        }
+        return number();
+    }
+};
+
+size_t count_occurrences(const std::string& text, const char* needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) count++;
+    return count;
+}
+
+}
+
+TEST_CASE(trace_recorder, rounds_capacity_to_power_of_two) {
+    CHECK(trace_recorder(0).capacity() == 2);
+    CHECK(trace_recorder(1).capacity() == 2);
+    CHECK(trace_recorder(5).capacity() == 8);
+    CHECK(trace_recorder(64).capacity() == 64);
+    CHECK(trace_recorder(65).capacity() == 128);
+}
+
+TEST_CASE(trace_recorder, wraps_oldest_first) {
+    trace_recorder recorder(8);
+    for (uint64_t i = 0; i < 20; i++) recorder.record(trace_phase_instant, "cat", "name", 100 + i, 1);
+
+    std::vector<trace_event> events;
+    recorder.snapshot(events);
+    CHECK(recorder.total_recorded() == 20);
+    REQUIRE(events.size() == 8);
+    for (size_t i = 0; i < events.size(); i++) CHECK(events[i].timestamp_us == 112 + i);
+
+    CHECK(recorder.total_dropped() == 0);
+
+    recorder.clear();
+    recorder.snapshot(events);
+    CHECK(events.empty());
+    CHECK(recorder.total_recorded() == 0);
+}
+
+TEST_CASE(trace_recorder, concurrent_writers_and_reader) {
+    trace_recorder recorder(4096);
+    std::atomic<uint64_t> clock(1);
+    std::atomic<int> writers_running(WRITERS);
+    std::vector<std::thread> writers;
+    for (int writer = 0; writer < WRITERS; writer++) {
+        writers.emplace_back([&, writer] {
+            for (int i = 0; i < EVENTS_PER_WRITER; i++) {
+                uint64_t timestamp = clock.fetch_add(1, std::memory_order_relaxed);
+                recorder.record(trace_phase_instant, g_categories[writer], g_names[writer], timestamp, (uint32_t)writer);
+            }
+            writers_running.fetch_sub(1);
+        });
+    }
+
+    // Snapshots taken while the ring is being overwritten skip the slots in flight but must
+    // never return a torn or out-of-order event
+    int snapshots = 0;
+    int inconsistent = 0;
+    std::vector<trace_event> events;
+    while (writers_running.load() > 0) {
+        recorder.snapshot(events);
+        if (events.size() > recorder.capacity() || !is_consistent(events)) inconsistent++;
+        snapshots++;
+    }
+    for (std::thread& writer : writers) writer.join();
+    CHECK(snapshots > 0);
+    CHECK(inconsistent == 0);
+
+    // Once quiet, the ring holds the newest capacity() events, less any a writer preempted for
+    // a whole ring collided with (that writer drops its event instead of corrupting the slot)
+    CHECK(recorder.total_recorded() == (uint64_t)WRITERS * EVENTS_PER_WRITER);
+    recorder.snapshot(events);
+    CHECK(events.size() <= recorder.capacity());
+    CHECK(events.size() + recorder.total_dropped() >= recorder.capacity());
+    CHECK(recorder.total_dropped() < recorder.capacity() / 8);
+    CHECK(is_consistent(events));
+
+    CHECK(json_checker(format_chrome_trace(events, 7)).is_valid());
+}
+
+TEST_CASE(trace_recorder, chrome_trace_export) {
+    trace_recorder recorder(16);
+    recorder.record(trace_phase_end, "ui", "orphan", 5, 1);        // Its begin was overwritten
+    recorder.record(trace_phase_begin, "ui", "paint", 10, 1);
+    recorder.record(trace_phase_instant, "io", "say \"hi\"\\\n\t\x01", 12, 2);
+    recorder.record(trace_phase_end, "ui", "paint", 20, 1);
+    recorder.record(trace_phase_end, "ui", "orphan", 25, 2);       // Begin was on another thread
+
+    std::vector<trace_event> events;
+    recorder.snapshot(events);
+    REQUIRE(events.size() == 5);
+    std::string json = format_chrome_trace(events, 42);
+
+    CHECK(json_checker(json).is_valid());
+    CHECK(json.compare(0, 15, "{\"traceEvents\":") == 0);
+    CHECK(json.find("\"displayTimeUnit\":\"ms\"") != std::string::npos);
+    CHECK(json.find("orphan") == std::string::npos);
+    CHECK(count_occurrences(json, "\"ph\":\"B\"") == 1);
+    CHECK(count_occurrences(json, "\"ph\":\"E\"") == 1);
+    CHECK(count_occurrences(json, "\"ph\":\"i\"") == 1);
+    CHECK(count_occurrences(json, "\"s\":\"t\"") == 1);
+    CHECK(count_occurrences(json, "\"pid\":42") == 3);
+    CHECK(json.find("say \\\"hi\\\"\\\\\\n\\t\\u0001") != std::string::npos);
+
+    CHECK(json_checker(format_chrome_trace(std::vector<trace_event>(), 1)).is_valid());
+}
@@ -0,0 +1,188 @@
+#include "test_harness.h"
+#include "../track_search_index.h"
+#include "../track_search_key.h"
+#include <cctype>
+#include <functional>
+#include <pfc/SmartStrStr.h>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// The index must give exactly what matching every track against SmartStrStr one by one would:
+// the same tracks, in the same order, for any query. Keys come from a small alphabet with
+// mixed case and accented letters so that words collide often; keys and queries are folded
+// with make_search_key, as track_search does.
+//
+// SmartStrStr matches asymmetrically (a lowercase query letter matches either case, an
+// uppercase one only itself) and folds accents on lowercase letters only. The index ignores case
+// and accents both ways, so the reference sees the query lowercased and the keys use lowercase
+// accented letters.
+
+namespace {
+
+const char* const g_letters[] = {
+    "a", "b", "c", "d", "e", "A", "B", "C", "D", "E", " ", " ", "1", "2",
+    "\xC3\xA9",     // é
+    "\xC3\xBC",     // ü
+    "\xC3\xB6",     // ö
+};
+const char g_query_letters[] = "abcdeABCDE12ou";
+
+std::string random_text(std::mt19937& rng, size_t min_length, size_t max_length) {
+    size_t length = min_length + rng() % (max_length - min_length + 1);
+    std::string text;
+    for (size_t i = 0; i < length; i++) text += g_letters[rng() % std::size(g_letters)];
+    return text;
+}
+
+std::string fold(const std::string& text) {
+    pfc::string8 key;
+    make_search_key(text.c_str(), text.length(), key);
+    return key.c_str();
+}
+
+// Brute force: every whitespace-separated query word occurs in the track text
+bool brute_force_matches(const std::string& text, std::string query) {
+    for (char& c : query) c = (char)tolower((unsigned char)c);
+    size_t words = 0;
+    size_t pos = 0;
+    while (pos < query.length()) {
+        while (pos < query.length() && (query[pos] == ' ' || query[pos] == '\t')) pos++;
+        size_t end = pos;
+        while (end < query.length() && query[end] != ' ' && query[end] != '\t') end++;
+        if (end > pos) {
+            words++;
+            if (!SmartStrStr::global().testSubstring(text.c_str(), query.substr(pos, end - pos).c_str())) return false;
+        }
+        pos = end;
+    }
+    return words > 0;
+}
+
+struct library {
+    track_search_index index;
+    std::vector<std::string> texts;     // By entry id
+    std::vector<bool> live;
+
+    void add(const std::string& text) {
+        track_search_index::entry_id id = index.add(fold(text));
+        REQUIRE(id == texts.size());
+        texts.push_back(text);
+        live.push_back(true);
+    }
+
+    void remove(track_search_index::entry_id id) {
+        index.remove(id);
+        live[id] = false;
+    }
+
+    std::vector<track_search_index::entry_id> expected(const std::string& query, size_t max_results) const {
+        std::vector<track_search_index::entry_id> ids;
+        for (size_t id = 0; id < texts.size() && ids.size() < max_results; id++) {
+            if (live[id] && brute_force_matches(texts[id], query)) ids.push_back((track_search_index::entry_id)id);
+        }
+        return ids;
+    }
+
+    std::vector<track_search_index::entry_id> actual(const std::string& query, size_t max_results) const {
+        std::vector<track_search_index::entry_id> ids;
+        index.search(fold(query).c_str(), max_results, ids);
+        return ids;
+    }
+};
+
+std::string random_query(std::mt19937& rng, const library& lib) {
+    std::string query;
+    size_t words = 1 + rng() % 3;
+    for (size_t w = 0; w < words; w++) {
+        if (w > 0) query += rng() % 4 ? " " : "  ";
+        if (rng() % 2 && !lib.texts.empty()) {
+            // A piece of a stored key, so that most queries have hits
+            std::string key = fold(lib.texts[rng() % lib.texts.size()]);
+            std::string word;
+            size_t start = rng() % (key.length() + 1);
+            size_t length = 1 + rng() % 4;
+            for (size_t i = start; i < key.length() && word.length() < length; i++) {
+                unsigned char c = (unsigned char)key[i];
+                if (c == ' ') break;
+                if (c < 0x80) word += (char)(rng() % 2 ? toupper(c) : c);
+            }
+            if (!word.empty()) {
+                query += word;
+                continue;
+            }
+        }
+        size_t length = 1 + rng() % 4;
+        for (size_t i = 0; i < length; i++) query += g_query_letters[rng() % (sizeof(g_query_letters) - 1)];
+    }
+    return query;
+}
+
+int check_queries(std::mt19937& rng, const library& lib, int count) {
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        std::string query = random_query(rng, lib);
+        size_t max_results = rng() % 4 ? (size_t)-1 : 1 + rng() % 5;
+        if (lib.actual(query, max_results) != lib.expected(query, max_results)) {
+            if (mismatches++ < 5) fprintf(stderr, "mismatch for query \"%s\" (limit %zu)\n", query.c_str(), max_results);
+        }
+    }
+    return mismatches;
+}
+
+}
+
+TEST_CASE(track_search_index, keys_fold_case_and_accents) {
+    // Substring search on folded text has to see what SmartStrStr sees in the original
+    CHECK(fold("Caf\xC3\xA9 M\xC3\xBCller") == "cafe muller");
+    CHECK(fold("\xC3\x96STERREICH") == "osterreich");
+    CHECK(SmartStrStr::global().testSubstring("Caf\xC3\xA9 M\xC3\xBCller", "cafe"));
+    CHECK(SmartStrStr::global().testSubstring("Caf\xC3\xA9 M\xC3\xBCller", "mull"));
+}
+
+TEST_CASE(track_search_index, matches_brute_force) {
+    std::mt19937 rng(20261019);
+    library lib;
+    for (int i = 0; i < 3000; i++) lib.add(random_text(rng, 0, 24));
+    CHECK(check_queries(rng, lib, 3000) == 0);
+
+    // Remove a third, add more behind them, and remove some of the new ones too
+    for (track_search_index::entry_id id = 0; id < lib.texts.size(); id++) {
+        if (rng() % 3 == 0) lib.remove(id);
+    }
+    for (int i = 0; i < 1000; i++) lib.add(random_text(rng, 0, 24));
+    for (int i = 0; i < 200; i++) {
+        track_search_index::entry_id id = (track_search_index::entry_id)(rng() % lib.texts.size());
+        if (lib.live[id]) lib.remove(id);
+    }
+    CHECK(check_queries(rng, lib, 3000) == 0);
+
+    size_t live = 0;
+    for (bool l : lib.live) live += l;
+    CHECK(lib.index.size() == live);
+}
+
+TEST_CASE(track_search_index, empty_and_limited_queries) {
+    library lib;
+    lib.add("Alpha Beta");
+    lib.add("beta gamma");
+    lib.add("");
+    lib.add("Gamma");
+
+    CHECK(lib.actual("", 10).empty());
+    CHECK(lib.actual("   ", 10).empty());
+    CHECK(lib.actual("beta", 0).empty());
+    CHECK(lib.actual("zzz", 10).empty());
+    CHECK(lib.actual("BETA", 10) == (std::vector<track_search_index::entry_id>{ 0, 1 }));
+    CHECK(lib.actual("a", 2) == (std::vector<track_search_index::entry_id>{ 0, 1 }));
+    CHECK(lib.actual("gam bet", 10) == (std::vector<track_search_index::entry_id>{ 1 }));
+
+    lib.remove(1);
+    CHECK(!lib.index.is_live(1));
+    CHECK(lib.actual("gamma", 10) == (std::vector<track_search_index::entry_id>{ 3 }));
+
+    lib.index.clear();
+    CHECK(lib.index.size() == 0);
+    CHECK(lib.index.add("gamma") == 0);
+}
@@ -0,0 +1,204 @@
+#include "test_harness.h"
+#include "../waveform_peaks.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// What reduce_min_max computes, one sample at a time
+template<typename sample_t>
+void reference_min_max(const sample_t* samples, size_t n, float& lo, float& hi) {
+    double lo_d = lo, hi_d = hi;
+    for (size_t i = 0; i < n; i++) {
+        if (samples[i] < lo_d) lo_d = samples[i];
+        if (samples[i] > hi_d) hi_d = samples[i];
+    }
+    lo = (float)lo_d;
+    hi = (float)hi_d;
+}
+
+// Every length around the vector widths, at every alignment, from a few starting values
+template<typename sample_t>
+int count_reduce_mismatches() {
+    std::mt19937 rng(45);
+    std::uniform_real_distribution<double> value(-1.5, 1.5);
+    std::vector<sample_t> samples(64 + 3);
+    int mismatches = 0;
+    for (int round = 0; round < 50; round++) {
+        for (sample_t& s : samples) s = (sample_t)value(rng);
+        for (size_t offset = 0; offset < 3; offset++) {
+            for (size_t n = 0; n <= 64; n++) {
+                float start = round % 3 == 0 ? 0.0f : (float)value(rng);
+                float lo = start, hi = start;
+                float expected_lo = start, expected_hi = start;
+                reduce_min_max(samples.data() + offset, n, lo, hi);
+                reference_min_max(samples.data() + offset, n, expected_lo, expected_hi);
+                if (lo != expected_lo || hi != expected_hi) mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Interleaved stereo: left a sine of the given amplitude, right its negation at half the size
+std::vector<float> make_stereo_sine(size_t frames, double amplitude, double cycles) {
+    std::vector<float> samples(frames * 2);
+    for (size_t i = 0; i < frames; i++) {
+        double v = amplitude * sin(2 * PI * cycles * (double)i / (double)frames);
+        samples[2 * i] = (float)v;
+        samples[2 * i + 1] = (float)(-0.5 * v);
+    }
+    return samples;
+}
+
+}
+
+TEST_CASE(waveform_peaks, reduce_matches_scalar_float) {
+    CHECK(count_reduce_mismatches<float>() == 0);
+}
+
+TEST_CASE(waveform_peaks, reduce_matches_scalar_double) {
+    CHECK(count_reduce_mismatches<double>() == 0);
+}
+
+TEST_CASE(waveform_peaks, reduce_finds_extremes_in_every_lane) {
+    for (size_t position = 0; position < 19; position++) {
+        std::vector<float> samples(19, 0.25f);
+        samples[position] = -0.75f;
+        samples[(position + 7) % samples.size()] = 0.9f;
+        float lo = 0.0f, hi = 0.0f;
+        reduce_min_max(samples.data(), samples.size(), lo, hi);
+        CHECK(lo == -0.75f);
+        CHECK(hi == 0.9f);
+    }
+}
+
+TEST_CASE(waveform_peaks, buckets_hold_min_and_max) {
+    // One full sine cycle over 4 buckets: the first half is positive, the second negative
+    const size_t frames = 44100;
+    std::vector<float> samples = make_stereo_sine(frames, 0.8, 1.0);
+    peak_accumulator accumulator;
+    accumulator.reset(frames, 4);
+    // Odd block sizes so runs straddle bucket boundaries
+    for (size_t done = 0; done < frames; ) {
+        size_t block = std::min<size_t>(1021, frames - done);
+        accumulator.add(samples.data() + done * 2, block, 2);
+        done += block;
+    }
+    CHECK(accumulator.frames() == frames);
+
+    waveform_peaks peaks;
+    accumulator.finish(peaks);
+    REQUIRE(peaks.size() == 4);
+    // Each bucket also includes the other channel and the zero it starts from
+    const int8_t full = (int8_t)lrint(0.8 * 127), half = (int8_t)lrint(0.4 * 127);
+    CHECK(peaks.max[0] == full);
+    CHECK(peaks.min[0] == -half);
+    CHECK(peaks.max[1] == full);
+    CHECK(peaks.min[1] == -half);
+    CHECK(peaks.max[2] == half);
+    CHECK(peaks.min[2] == -full);
+    CHECK(peaks.max[3] == half);
+    CHECK(peaks.min[3] == -full);
+}
+
+TEST_CASE(waveform_peaks, float_and_double_agree) {
+    const size_t frames = 10000;
+    std::vector<float> samples = make_stereo_sine(frames, 0.6, 7.3);
+    std::vector<double> samples_d(samples.begin(), samples.end());
+
+    peak_accumulator from_float, from_double;
+    from_float.reset(frames, 100);
+    from_double.reset(frames, 100);
+    from_float.add(samples.data(), frames, 2);
+    from_double.add(samples_d.data(), frames, 2);
+
+    waveform_peaks a, b;
+    from_float.finish(a);
+    from_double.finish(b);
+    CHECK(a.size() == 100);
+    CHECK(a.min == b.min);
+    CHECK(a.max == b.max);
+}
+
+TEST_CASE(waveform_peaks, clips_and_handles_length_mismatch) {
+    std::vector<float> loud(1000 * 2);
+    for (size_t i = 0; i < loud.size(); i++) loud[i] = i % 2 ? -3.0f : 2.0f;
+
+    // Longer than expected: the excess lands in the last bucket
+    peak_accumulator accumulator;
+    accumulator.reset(500, 10);
+    accumulator.add(loud.data(), 1000, 2);
+    waveform_peaks peaks;
+    accumulator.finish(peaks);
+    REQUIRE(peaks.size() == 10);
+    CHECK(peaks.max[9] == 127);
+    CHECK(peaks.min[9] == -127);
+
+    // Shorter than expected: buckets never reached are dropped
+    accumulator.reset(1000, 10);
+    accumulator.add(loud.data(), 250, 2);
+    accumulator.finish(peaks);
+    CHECK(peaks.size() == 3);
+
+    // Nothing decoded, or nothing to decode into
+    accumulator.reset(0, 10);
+    accumulator.finish(peaks);
+    CHECK(peaks.empty());
+    accumulator.reset(1000, 0);
+    accumulator.add(loud.data(), 1000, 2);
+    accumulator.finish(peaks);
+    CHECK(peaks.empty());
+}
+
+TEST_CASE(waveform_peaks, record_round_trip) {
+    waveform_peaks peaks;
+    for (int i = 0; i < 300; i++) {
+        peaks.min.push_back((int8_t)(-(i % 128)));
+        peaks.max.push_back((int8_t)(i % 128));
+    }
+    std::string key = make_peak_cache_key("C:\\Music\\a.flac", 2, 123456789, 987654321);
+    CHECK(key != make_peak_cache_key("C:\\Music\\a.flac", 3, 123456789, 987654321));
+    CHECK(hash_peak_cache_key(key) != hash_peak_cache_key(make_peak_cache_key("C:\\Music\\a.flac", 2, 123456789, 987654322)));
+
+    std::vector<uint8_t> record;
+    serialize_peaks(key, peaks, record);
+    waveform_peaks parsed;
+    REQUIRE(parse_peaks(record.data(), record.size(), key, parsed));
+    CHECK(parsed.min == peaks.min);
+    CHECK(parsed.max == peaks.max);
+
+    CHECK(!parse_peaks(record.data(), record.size(), key + "x", parsed));
+    CHECK(!parse_peaks(record.data(), record.size() - 1, key, parsed));
+    CHECK(!parse_peaks(record.data(), 4, key, parsed));
+    record[4]++;
+    CHECK(!parse_peaks(record.data(), record.size(), key, parsed));
+}
+
+TEST_CASE(waveform_peaks, envelope_covers_every_bucket) {
+    waveform_peaks peaks;
+    peaks.min = { -1, -5, -2, -9, -3, -4, -7 };
+    peaks.max = { 1, 5, 2, 9, 3, 4, 7 };
+
+    std::vector<int8_t> lo, hi;
+    peak_envelope(peaks, 3, lo, hi);
+    REQUIRE(lo.size() == 3);
+    // Columns cover buckets [0,2), [2,4), [4,7)
+    CHECK(lo[0] == -5 && hi[0] == 5);
+    CHECK(lo[1] == -9 && hi[1] == 9);
+    CHECK(lo[2] == -7 && hi[2] == 7);
+
+    // More columns than buckets repeat buckets instead of leaving gaps
+    peak_envelope(peaks, 20, lo, hi);
+    REQUIRE(hi.size() == 20);
+    for (int8_t value : hi) CHECK(value > 0);
+
+    peak_envelope(peaks, 0, lo, hi);
+    CHECK(lo.empty() && hi.empty());
+    peak_envelope(waveform_peaks(), 5, lo, hi);
+    CHECK(lo.size() == 5 && lo[0] == 0 && hi[4] == 0);
+}
@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "text_layout.h"
+#include "perf_stats.h"
+#include <climits>
+
+// DrawText's DT_END_ELLIPSIS uses three periods, not U+2026
+static const wchar_t ELLIPSIS[] = L"...";
+static const int ELLIPSIS_LENGTH = 3;
+
+const wchar_t* utf16_line::update(const pfc::string8& text) {
+    if (!m_valid || m_source != text) {
+        m_source = text;
+        m_wide = pfc::stringcvt::string_wide_from_utf8(text.c_str()).get_ptr();
+        m_valid = true;
+    }
+    return m_wide.c_str();
+}
+
+void utf16_line::clear() {
+    m_source.reset();
+    m_wide.clear();
+    m_valid = false;
+}
+
+text_layout_cache::text_layout_cache()
+    : m_clock(0) {
+    clear();
+}
+
+void text_layout_cache::clear() {
+    for (entry& e : m_entries) {
+        e.last_use = 0;
+        e.font = nullptr;
+        e.layout = text_layout();
+    }
+}
+
+text_layout_cache::entry& text_layout_cache::victim() {
+    entry* oldest = &m_entries[0];
+    for (entry& e : m_entries) {
+        if (e.last_use < oldest->last_use) oldest = &e;
+    }
+    return *oldest;
+}
+
+const text_layout& text_layout_cache::get(HDC hdc, const wchar_t* text, HFONT font, int max_width) {
+    if (!text) text = L"";
+    int dpi = GetDeviceCaps(hdc, LOGPIXELSY);
+    for (entry& e : m_entries) {
+        if (e.last_use && e.font == font && e.max_width == max_width && e.dpi == dpi && e.layout.text == text) {
+            e.last_use = ++m_clock;
+            return e.layout;
+        }
+    }
+
+    entry& e = victim();
+    e.last_use = ++m_clock;
+    e.font = font;
+    e.max_width = max_width;
+    e.dpi = dpi;
+    build(hdc, text, font, max_width, e.layout);
+    return e.layout;
+}
+
+const text_layout& text_layout_cache::measure(HDC hdc, const wchar_t* text, HFONT font) {
+    if (!text) text = L"";
+    int dpi = GetDeviceCaps(hdc, LOGPIXELSY);
+    for (entry& e : m_entries) {
+        if (e.last_use && e.font == font && e.dpi == dpi && e.layout.text == text) {
+            e.last_use = ++m_clock;
+            return e.layout;
+        }
+    }
+    return get(hdc, text, font, INT_MAX);
+}
+
+void text_layout_cache::build(HDC hdc, const wchar_t* text, HFONT font, int max_width, text_layout& out) {
+    TRAY_PERF_COUNT(perf_counter_text_layouts);
+    HFONT old_font = (HFONT)SelectObject(hdc, font);
+
+    out.text = text;
+    const std::wstring& wide = out.text;
+    out.extent = {};
+    GetTextExtentPoint32W(hdc, wide.c_str(), (int)wide.length(), &out.extent);
+    if (out.extent.cy == 0) {
+        // Empty line: keep the font height so vertical centering matches DrawText
+        TEXTMETRIC tm = {};
+        GetTextMetrics(hdc, &tm);
+        out.extent.cy = tm.tmHeight;
+    }
+    out.overflow = out.extent.cx > max_width;
+
+    if (!out.overflow) {
+        out.fitted = wide;
+        out.fitted_extent = out.extent;
+    } else {
+        SIZE ellipsis_size = {};
+        GetTextExtentPoint32W(hdc, ELLIPSIS, ELLIPSIS_LENGTH, &ellipsis_size);
+
+        int fit = 0;
+        int room = max_width - ellipsis_size.cx;
+        if (room > 0) {
+            SIZE ignored = {};
+            GetTextExtentExPointW(hdc, wide.c_str(), (int)wide.length(), room, &fit, nullptr, &ignored);
+            // Never split a surrogate pair
+            if (fit > 0 && IS_HIGH_SURROGATE(wide[fit - 1])) fit--;
+        }
+        out.fitted.assign(wide, 0, (size_t)fit);
+        out.fitted += ELLIPSIS;
+        out.fitted_extent = {};
+        GetTextExtentPoint32W(hdc, out.fitted.c_str(), (int)out.fitted.length(), &out.fitted_extent);
+        out.fitted_extent.cy = out.extent.cy;
+    }
+
+    SelectObject(hdc, old_font);
+}
+
+void text_layout_cache::draw(HDC hdc, const text_layout& layout, const RECT& rect, bool centered) {
+    int x = rect.left;
+    if (centered) {
+        x += ((rect.right - rect.left) - layout.fitted_extent.cx) / 2;
+        if (x < rect.left) x = rect.left;
+    }
+    int y = rect.top + ((rect.bottom - rect.top) - layout.fitted_extent.cy) / 2;
+    ExtTextOutW(hdc, x, y, ETO_CLIPPED, &rect, layout.fitted.c_str(), (UINT)layout.fitted.length(), nullptr);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "stdafx.h"
+#include <string>
+
+// UTF-16 copy of a UTF-8 line, converted again only when the line changes
+class utf16_line {
+public:
+    utf16_line() : m_valid(false) {}
+
+    const wchar_t* update(const pfc::string8& text);
+    const wchar_t* c_str() const { return m_wide.c_str(); }
+    void clear();
+
+private:
+    pfc::string8 m_source;
+    std::wstring m_wide;
+    bool m_valid;
+};
+
+// One line of text measured in one font and fitted into one width
+struct text_layout {
+    std::wstring text;      // Full line, UTF-16
+    SIZE extent;            // Extent of the full line
+    std::wstring fitted;    // What a static draw shows: the full line, or an end-ellipsized run
+    SIZE fitted_extent;
+    bool overflow;          // The full line is wider than the layout width
+};
+
+// Per-window cache of single-line layouts, keyed by (text, font, width, DPI). Static
+// title/artist lines are otherwise measured and ellipsized on every paint; with the cache that
+// happens once per track, font or window size. The least recently used layout is replaced.
+//
+// Fonts are keyed by handle: call clear() before deleting a font that was passed in, since
+// GDI hands freed handle values out again. Main thread only.
+class text_layout_cache {
+public:
+    text_layout_cache();
+
+    // Layout of text drawn with font into max_width pixels. The reference is valid until the
+    // next get(), measure() or clear().
+    const text_layout& get(HDC hdc, const wchar_t* text, HFONT font, int max_width);
+
+    // Layout of text at any width, for its full extent: reuses whichever layout of the same
+    // text and font is cached
+    const text_layout& measure(HDC hdc, const wchar_t* text, HFONT font);
+
+    void clear();
+
+    // Draw the fitted run vertically centered in rect, left aligned or centered - the
+    // equivalent of DrawText(DT_SINGLELINE | DT_VCENTER | DT_END_ELLIPSIS). Font, color and
+    // background mode are the caller's, as with DrawText.
+    static void draw(HDC hdc, const text_layout& layout, const RECT& rect, bool centered);
+
+private:
+    static const unsigned ENTRY_COUNT = 12;
+
+    struct entry {
+        unsigned last_use;      // 0 = unused
+        HFONT font;
+        int max_width;
+        int dpi;
+        text_layout layout;
+    };
+
+    entry m_entries[ENTRY_COUNT];
+    unsigned m_clock;
+
+    entry& victim();
+    void build(HDC hdc, const wchar_t* text, HFONT font, int max_width, text_layout& out);
+};
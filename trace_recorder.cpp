@@ -0,0 +1,156 @@
+#include "trace_recorder.h"
+#include <algorithm>
+#include <cstdio>
+
+static size_t round_up_pow2(size_t value) {
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+trace_recorder::trace_recorder(size_t capacity)
+    : m_capacity(round_up_pow2(capacity < 2 ? 2 : capacity))
+    , m_mask(m_capacity - 1)
+    , m_next(0)
+    , m_dropped(0) {
+    m_slots.reset(new slot[m_capacity]);
+    clear();
+}
+
+void trace_recorder::record(char phase, const char* category, const char* name, uint64_t timestamp_us, uint32_t thread_id) {
+    uint64_t index = m_next.fetch_add(1, std::memory_order_relaxed);
+    slot& s = m_slots[(size_t)index & m_mask];
+
+    // Take the slot only from a finished, older event. A writer preempted for a whole ring
+    // would otherwise write over a newer event, or interleave its stores with another writer's.
+    uint64_t writing = 2 * index + 1;
+    uint64_t current = s.sequence.load(std::memory_order_relaxed);
+    do {
+        if ((current & 1) || current >= writing) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    } while (!s.sequence.compare_exchange_weak(current, writing, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+    s.category.store(category, std::memory_order_relaxed);
+    s.name.store(name, std::memory_order_relaxed);
+    s.timestamp_us.store(timestamp_us, std::memory_order_relaxed);
+    s.thread_id.store(thread_id, std::memory_order_relaxed);
+    s.phase.store(phase, std::memory_order_relaxed);
+    s.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void trace_recorder::snapshot(std::vector<trace_event>& out) const {
+    out.clear();
+    uint64_t end = m_next.load(std::memory_order_acquire);
+    uint64_t begin = end > m_capacity ? end - m_capacity : 0;
+    out.reserve((size_t)(end - begin));
+
+    for (uint64_t index = begin; index < end; index++) {
+        const slot& s = m_slots[(size_t)index & m_mask];
+        uint64_t expected = 2 * index + 2;
+        if (s.sequence.load(std::memory_order_acquire) != expected) continue; // Unfinished or already reused
+
+        trace_event e;
+        e.category = s.category.load(std::memory_order_relaxed);
+        e.name = s.name.load(std::memory_order_relaxed);
+        e.timestamp_us = s.timestamp_us.load(std::memory_order_relaxed);
+        e.thread_id = s.thread_id.load(std::memory_order_relaxed);
+        e.phase = s.phase.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.sequence.load(std::memory_order_relaxed) != expected) continue; // Overwritten while copying
+        out.push_back(e);
+    }
+
+    // Slots are claimed in index order but written by several threads; present them in time order
+    std::stable_sort(out.begin(), out.end(), [](const trace_event& a, const trace_event& b) {
+        return a.timestamp_us < b.timestamp_us;
+    });
+}
+
+void trace_recorder::clear() {
+    for (size_t i = 0; i < m_capacity; i++) {
+        slot& s = m_slots[i];
+        s.sequence.store(0, std::memory_order_relaxed);
+        s.category.store(nullptr, std::memory_order_relaxed);
+        s.name.store(nullptr, std::memory_order_relaxed);
+        s.timestamp_us.store(0, std::memory_order_relaxed);
+        s.thread_id.store(0, std::memory_order_relaxed);
+        s.phase.store(0, std::memory_order_relaxed);
+    }
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_next.store(0, std::memory_order_release);
+}
+
+static void append_json_string(std::string& out, const char* text) {
+    out += '"';
+    for (const char* p = text ? text : ""; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += (char)c;
+            }
+            break;
+        }
+    }
+    out += '"';
+}
+
+std::string format_chrome_trace(const std::vector<trace_event>& events, uint32_t process_id) {
+    // Open begin events per thread, to drop ends whose begin fell out of the ring buffer
+    struct thread_depth {
+        uint32_t thread_id;
+        int depth;
+    };
+    std::vector<thread_depth> depths;
+
+    std::string out;
+    out.reserve(events.size() * 96 + 64);
+    out += "{\"traceEvents\":[";
+
+    bool first = true;
+    char number[64];
+    for (const trace_event& e : events) {
+        auto it = std::find_if(depths.begin(), depths.end(),
+            [&e](const thread_depth& d) { return d.thread_id == e.thread_id; });
+        if (it == depths.end()) {
+            depths.push_back({ e.thread_id, 0 });
+            it = depths.end() - 1;
+        }
+        if (e.phase == trace_phase_begin) {
+            it->depth++;
+        } else if (e.phase == trace_phase_end) {
+            if (it->depth == 0) continue;
+            it->depth--;
+        }
+
+        if (!first) out += ',';
+        first = false;
+
+        out += "\n{\"name\":";
+        append_json_string(out, e.name);
+        out += ",\"cat\":";
+        append_json_string(out, e.category);
+        snprintf(number, sizeof(number), ",\"ph\":\"%c\",\"ts\":%llu,\"pid\":%u,\"tid\":%u",
+            e.phase, (unsigned long long)e.timestamp_us, process_id, e.thread_id);
+        out += number;
+        if (e.phase == trace_phase_instant) {
+            out += ",\"s\":\"t\""; // Thread-scoped instant
+        }
+        out += '}';
+    }
+
+    out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return out;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+// Fixed-size ring buffer of timestamped trace events, exportable as Chrome trace_event JSON
+// (chrome://tracing, Perfetto). No Windows dependency - the caller supplies timestamps and
+// thread ids, so the recorder can be driven and checked anywhere.
+//
+// record() is lock-free: one fetch_add claims an index, a compare-exchange on the slot's
+// sequence number takes the slot, then plain atomic stores fill it. When the buffer wraps the
+// oldest events are overwritten. A writer that finds its slot taken by a newer index, or still
+// being filled by a writer a whole ring behind, drops its event rather than mixing its fields
+// with the other writer's. Readers use the sequence number to skip slots that are being
+// rewritten while the snapshot is taken.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum trace_phase : char {
+    trace_phase_begin = 'B',
+    trace_phase_end = 'E',
+    trace_phase_instant = 'i'
+};
+
+struct trace_event {
+    const char* category;   // Static string
+    const char* name;       // Static string
+    uint64_t timestamp_us;
+    uint32_t thread_id;
+    char phase;             // trace_phase
+};
+
+class trace_recorder {
+public:
+    // Capacity is rounded up to a power of two
+    explicit trace_recorder(size_t capacity);
+
+    // Category and name must outlive the recorder (string literals)
+    void record(char phase, const char* category, const char* name, uint64_t timestamp_us, uint32_t thread_id);
+
+    // Copy of the retained events, oldest first
+    void snapshot(std::vector<trace_event>& out) const;
+
+    // Forget everything recorded so far. Not safe against concurrent record() calls.
+    void clear();
+
+    size_t capacity() const { return m_capacity; }
+    uint64_t total_recorded() const { return m_next.load(std::memory_order_relaxed); }
+    // Events lost to a slot collision (see above); they count in total_recorded() too
+    uint64_t total_dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    trace_recorder(const trace_recorder&) = delete;
+    trace_recorder& operator=(const trace_recorder&) = delete;
+
+private:
+    struct slot {
+        // 2 * index + 1 while being written, 2 * index + 2 once complete, 0 if never written
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char*> category;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> timestamp_us;
+        std::atomic<uint32_t> thread_id;
+        std::atomic<char> phase;
+    };
+
+    std::unique_ptr<slot[]> m_slots;
+    size_t m_capacity;
+    size_t m_mask;
+    std::atomic<uint64_t> m_next;
+    std::atomic<uint64_t> m_dropped;
+};
+
+// Chrome trace_event JSON object ({"traceEvents":[...]}). End events whose begin was
+// overwritten by the ring buffer are dropped so the viewer does not mis-nest slices.
+std::string format_chrome_trace(const std::vector<trace_event>& events, uint32_t process_id);
@@ -0,0 +1,66 @@
+#include "stdafx.h"
+#include "tracing.h"
+
+#if TRAYCONTROLS_PERF_STATS
+
+#include "trace_recorder.h"
+
+// ~64K events: a few minutes of normal use, several seconds of a ticker animating at 60 fps
+static const size_t TRACE_CAPACITY = 65536;
+
+static trace_recorder g_trace(TRACE_CAPACITY);
+
+static LONGLONG query_qpc(bool frequency) {
+    LARGE_INTEGER value;
+    if (frequency) QueryPerformanceFrequency(&value);
+    else QueryPerformanceCounter(&value);
+    return value.QuadPart;
+}
+
+// Timestamps are microseconds since the component was loaded
+static const LONGLONG g_trace_frequency = query_qpc(true);
+static const LONGLONG g_trace_origin = query_qpc(false);
+
+static uint64_t trace_now_us() {
+    LONGLONG elapsed = query_qpc(false) - g_trace_origin;
+    if (elapsed < 0) return 0;
+    return (uint64_t)(elapsed / g_trace_frequency) * 1000000 + (uint64_t)(elapsed % g_trace_frequency) * 1000000 / (uint64_t)g_trace_frequency;
+}
+
+void trace_begin(const char* category, const char* name) {
+    g_trace.record(trace_phase_begin, category, name, trace_now_us(), GetCurrentThreadId());
+}
+
+void trace_end(const char* category, const char* name) {
+    g_trace.record(trace_phase_end, category, name, trace_now_us(), GetCurrentThreadId());
+}
+
+void trace_instant(const char* category, const char* name) {
+    g_trace.record(trace_phase_instant, category, name, trace_now_us(), GetCurrentThreadId());
+}
+
+void export_trace_to_profile() {
+    std::vector<trace_event> events;
+    g_trace.snapshot(events);
+    std::string json = format_chrome_trace(events, GetCurrentProcessId());
+
+    pfc::string8 path = core_api::get_profile_path();
+    path.add_filename("foo_traycontrols_trace.json");
+
+    try {
+        file::ptr out;
+        filesystem::g_open_write_new(out, path, fb2k::noAbort);
+        out->write(json.data(), json.size(), fb2k::noAbort);
+
+        pfc::string8 msg;
+        msg << "Tray Controls: wrote " << (unsigned)events.size() << " trace events to "
+            << filesystem::g_get_native_path(path);
+        console::print(msg);
+    } catch (std::exception const& e) {
+        pfc::string8 msg;
+        msg << "Tray Controls: could not write trace: " << e.what();
+        console::print(msg);
+    }
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+// Timeline tracing on top of trace_recorder: begin/end and instant events for playback
+// callbacks, metadb notifications, artwork requests, timers, paints and composites.
+// Safe to call from any thread, including foo_artwork's callback thread; recording never
+// blocks. "Export Performance Trace" writes the buffer as Chrome trace_event JSON.
+//
+// Built together with the other instrumentation (TRAYCONTROLS_PERF_STATS, see perf_stats.h)
+// and recording only while its collection switch is on.
+
+#include "stdafx.h"
+#include "perf_stats.h"
+
+#if TRAYCONTROLS_PERF_STATS
+
+// Category and name must be string literals
+void trace_begin(const char* category, const char* name);
+void trace_end(const char* category, const char* name);
+void trace_instant(const char* category, const char* name);
+
+// Write the retained events to foo_traycontrols_trace.json in the profile folder and
+// print the location to the console
+void export_trace_to_profile();
+
+class trace_scope {
+public:
+    trace_scope(const char* category, const char* name)
+        : m_category(category), m_name(name), m_active(perf_enabled()) {
+        if (m_active) trace_begin(category, name);
+    }
+    ~trace_scope() {
+        if (m_active) trace_end(m_category, m_name);
+    }
+
+private:
+    const char* m_category;
+    const char* m_name;
+    bool m_active;                      // Begin was recorded, so the end must be too
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+};
+
+#define TRAY_TRACE_SCOPE(category, name) trace_scope TRAY_PERF_CONCAT(trace_scope_, __LINE__)(category, name)
+#define TRAY_TRACE_INSTANT(category, name) (perf_enabled() ? trace_instant(category, name) : (void)0)
+
+#else
+
+#define TRAY_TRACE_SCOPE(category, name) ((void)0)
+#define TRAY_TRACE_INSTANT(category, name) ((void)0)
+
+#endif
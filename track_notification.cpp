@@ -0,0 +1,64 @@
+#include "stdafx.h"
+#include "track_notification.h"
+#include "playback_ui.h"
+#include "main_thread_timer.h"
+#include "tracing.h"
+
+// Longer than the gap between rapid Next clicks and key repeats, short enough that a natural
+// track change still looks immediate
+static const unsigned TRACK_SETTLE_MS = 200;
+
+static metadb_handle_ptr g_pending_track;
+static bool g_has_pending_track = false;
+static main_thread_timer_id g_settle_timer = 0;
+
+static void dispatch_track_notification(metadb_handle_ptr track) {
+    TRAY_TRACE_SCOPE("playback", "dispatch_track_notification");
+    playback_ui_new_track(track);
+}
+
+static void settle_timer_proc() {
+    g_settle_timer = 0;
+
+    if (!g_has_pending_track) return;
+    g_has_pending_track = false;
+    metadb_handle_ptr track = g_pending_track;
+    g_pending_track.release();
+
+    try {
+        dispatch_track_notification(track);
+    } catch (...) {}
+}
+
+void on_new_track_notification(metadb_handle_ptr track) {
+    try {
+        if (g_has_pending_track) {
+            TRAY_TRACE_INSTANT("playback", "track notification superseded");
+        }
+
+        // Whatever the previous track was still waiting for can no longer be shown
+        playback_ui_cancel_artwork();
+
+        // Latest track wins; every change restarts the settle window
+        g_pending_track = track;
+        g_has_pending_track = true;
+        g_settle_timer = start_main_thread_timer(g_settle_timer, TRACK_SETTLE_MS, settle_timer_proc);
+        if (!g_settle_timer) {
+            // No timer available - deliver synchronously rather than lose the track
+            g_has_pending_track = false;
+            g_pending_track.release();
+            dispatch_track_notification(track);
+        }
+    } catch (...) {}
+}
+
+bool is_track_notification_pending() {
+    return g_has_pending_track;
+}
+
+void reset_track_notification() {
+    stop_main_thread_timer(g_settle_timer);
+    g_settle_timer = 0;
+    g_has_pending_track = false;
+    g_pending_track.release();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "stdafx.h"
+
+// Entry point for play_callback new-track notifications (main thread).
+// The tray tooltip, control panel and popup are updated once the track has been playing for a
+// short settle window; a newer track arriving meanwhile supersedes the pending one, so skipping
+// through a playlist loads artwork and animates the popup for the last track only.
+void on_new_track_notification(metadb_handle_ptr track);
+
+// True while a new track is waiting out its settle window
+bool is_track_notification_pending();
+
+// Drop the pending track without delivering it (stop, shutdown)
+void reset_track_notification();
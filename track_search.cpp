@@ -0,0 +1,272 @@
+#include "stdafx.h"
+#include "track_search.h"
+#include "track_search_key.h"
+#include "perf_stats.h"
+#include "tracing.h"
+
+// Library membership changes; tag edits arrive through the metadb callback instead
+class track_search::library_listener : public library_callback_dynamic_impl_base {
+public:
+    explicit library_listener(track_search& owner) : m_owner(owner) {}
+
+    void on_items_added(metadb_handle_list_cref p_data) override { m_owner.on_library_items_added(p_data); }
+    void on_items_removed(metadb_handle_list_cref p_data) override { m_owner.on_library_items_removed(p_data); }
+
+private:
+    track_search& m_owner;
+};
+
+// Folded "artist title album" key of a track. Any thread.
+static void make_key(const metadb_handle_ptr& track, const titleformat_object::ptr& script, pfc::string8& buffer, pfc::string8& key) {
+    track->format_title(nullptr, buffer, script, nullptr);
+    make_search_key(buffer.c_str(), buffer.length(), key);
+}
+
+bool track_search::store::add(const metadb_handle_ptr& track, const titleformat_object::ptr& script, pfc::string8& buffer) {
+    auto it = slots.find(track.get_ptr());
+    if (it != slots.end()) {
+        it->second.refs++;
+        return false;
+    }
+    pfc::string8 key;
+    make_key(track, script, buffer, key);
+    track_search_index::entry_id id = index.add(key.c_str(), key.length());
+    if (tracks.size() <= id) tracks.resize(id + 1);
+    tracks[id] = track;
+    slots.emplace(track.get_ptr(), slot{ id, 1 });
+    return true;
+}
+
+bool track_search::store::remove(const metadb_handle_ptr& track) {
+    auto it = slots.find(track.get_ptr());
+    if (it == slots.end()) return false;
+    if (--it->second.refs > 0) return false;
+    index.remove(it->second.id);
+    tracks[it->second.id].release();
+    slots.erase(it);
+    return true;
+}
+
+bool track_search::store::change(const metadb_handle_ptr& track, const titleformat_object::ptr& script, pfc::string8& buffer) {
+    auto it = slots.find(track.get_ptr());
+    if (it == slots.end()) return false;
+
+    // Re-key under a new id; the reference count carries over
+    pfc::string8 key;
+    make_key(track, script, buffer, key);
+    size_t old_length = 0;
+    const char* old_key = index.key(it->second.id, old_length);
+    if (old_length == key.length() && memcmp(old_key, key.c_str(), old_length) == 0) return false;
+    index.remove(it->second.id);
+    tracks[it->second.id].release();
+    track_search_index::entry_id id = index.add(key.c_str(), key.length());
+    if (tracks.size() <= id) tracks.resize(id + 1);
+    tracks[id] = track;
+    it->second.id = id;
+    return true;
+}
+
+void track_search::store::clear() {
+    index.clear();
+    tracks.clear();
+    slots.clear();
+}
+
+track_search::track_search()
+    : m_open(false)
+    , m_building(false)
+    , m_playlist(pfc_infinite)
+    , m_generation(0)
+    , m_alive(std::make_shared<bool>(true)) {
+}
+
+track_search::~track_search() {
+    m_alive.reset();
+    close();
+}
+
+void track_search::open(size_t playlist, std::function<void()> on_changed) {
+    m_on_changed = std::move(on_changed);
+    if (m_open) {
+        set_playlist(playlist);
+        return;
+    }
+    m_open = true;
+    m_playlist = playlist;
+    if (m_key_script.is_empty()) {
+        titleformat_compiler::get()->compile_safe_ex(m_key_script, "[%artist% ][%title% ][%album%]");
+    }
+    try {
+        m_library = std::make_unique<library_listener>(*this);
+    } catch (...) {}
+    start_build();
+}
+
+void track_search::close() {
+    if (!m_open) return;
+    m_open = false;
+    m_building = false;
+    m_generation++;
+    m_library.reset();
+    m_pending.clear();
+    m_store = store();
+    m_on_changed = nullptr;
+}
+
+void track_search::set_playlist(size_t playlist) {
+    if (!m_open || playlist == m_playlist) return;
+    m_playlist = playlist;
+    start_build();
+}
+
+void track_search::start_build() {
+    TRAY_TRACE_SCOPE("search", "snapshot tracks");
+    m_building = true;
+    m_pending.clear();
+    unsigned generation = ++m_generation;
+
+    // Handle lists are gathered here; keys are formatted and indexed on the worker
+    metadb_handle_list tracks;
+    try {
+        auto library = library_manager::get();
+        if (library->is_library_enabled()) library->get_all_items(tracks);
+        if (m_playlist != pfc_infinite) {
+            metadb_handle_list playlist_tracks;
+            playlist_manager::get()->playlist_get_all_items(m_playlist, playlist_tracks);
+            tracks.add_items(playlist_tracks);
+        }
+    } catch (...) {}
+
+    std::weak_ptr<bool> alive = m_alive;
+    track_search* self = this;
+    titleformat_object::ptr script = m_key_script;
+    fb2k::splitTask([alive, self, generation, tracks, script] {
+        LARGE_INTEGER start, end, freq;
+        QueryPerformanceCounter(&start);
+
+        auto result = std::make_shared<store>();
+        try {
+            result->tracks.reserve(tracks.get_count());
+            result->slots.reserve(tracks.get_count());
+            pfc::string8 buffer;
+            for (size_t i = 0; i < tracks.get_count(); i++) {
+                result->add(tracks[i], script, buffer);
+            }
+        } catch (...) {
+            result->clear();
+        }
+
+        QueryPerformanceCounter(&end);
+        QueryPerformanceFrequency(&freq);
+        double build_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+
+        fb2k::inMainThread([alive, self, generation, result, build_ms] {
+            if (alive.expired() || generation != self->m_generation) return;
+            self->on_build_finished(result, build_ms);
+        });
+    });
+}
+
+void track_search::on_build_finished(const std::shared_ptr<store>& result, double build_ms) {
+    TRAY_TRACE_SCOPE("search", "index ready");
+    m_store = std::move(*result);
+    m_building = false;
+
+    // Replay what happened while the worker ran
+    std::vector<pending> pending_ops;
+    pending_ops.swap(m_pending);
+    for (const pending& op : pending_ops) {
+        apply(op.op, op.tracks);
+        // A rebuild started from a fresh snapshot that already holds the rest
+        if (m_building) return;
+    }
+
+    pfc::string8 msg;
+    msg << "Tray Controls: search index built, " << (unsigned)m_store.index.size() << " tracks, "
+        << (unsigned)((m_store.index.memory_bytes() + 1023) / 1024) << " KB in "
+        << pfc::format_float(build_ms, 0, 1) << " ms";
+    console::print(msg);
+    notify_changed();
+}
+
+void track_search::apply(pending_op op, metadb_handle_list_cref tracks) {
+    if (!m_open || tracks.get_count() == 0) return;
+    if (m_building) {
+        m_pending.push_back({ op, tracks });
+        return;
+    }
+
+    pfc::string8 buffer;
+    bool changed = false;
+    for (size_t i = 0; i < tracks.get_count(); i++) {
+        switch (op) {
+            case pending_add: changed |= m_store.add(tracks[i], m_key_script, buffer); break;
+            case pending_remove: changed |= m_store.remove(tracks[i]); break;
+            case pending_change: changed |= m_store.change(tracks[i], m_key_script, buffer); break;
+        }
+    }
+    if (m_store.index.wants_rebuild()) {
+        // Mostly dead entries after a large library removal; start over from the sources
+        start_build();
+        return;
+    }
+    if (changed) notify_changed();
+}
+
+void track_search::notify_changed() {
+    if (m_on_changed) m_on_changed();
+}
+
+void track_search::query(const char* query, size_t max_results, metadb_handle_list& out) const {
+    out.remove_all();
+    if (!m_open) return;
+    TRAY_TRACE_SCOPE("search", "query");
+    TRAY_PERF_COUNT(perf_counter_search_queries);
+
+    pfc::string8 folded;
+    make_search_key(query, strlen(query), folded);
+    std::vector<track_search_index::entry_id> ids;
+    m_store.index.search(folded.c_str(), max_results, ids);
+    for (track_search_index::entry_id id : ids) {
+        out.add_item(m_store.tracks[id]);
+    }
+}
+
+void track_search::on_library_items_added(metadb_handle_list_cref tracks) {
+    apply(pending_add, tracks);
+}
+
+void track_search::on_library_items_removed(metadb_handle_list_cref tracks) {
+    apply(pending_remove, tracks);
+}
+
+void track_search::on_playlist_items_added(size_t playlist, metadb_handle_list_cref tracks) {
+    if (playlist != m_playlist) return;
+    apply(pending_add, tracks);
+}
+
+void track_search::on_playlist_items_removing(size_t playlist, const bit_array& mask) {
+    if (!m_open || playlist != m_playlist) return;
+    // Still in the playlist at this point, so their handles can be read
+    metadb_handle_list tracks;
+    playlist_manager::get()->playlist_get_items(playlist, tracks, mask);
+    apply(pending_remove, tracks);
+}
+
+void track_search::on_playlist_items_replaced(size_t playlist, const pfc::list_base_const_t<playlist_callback::t_on_items_replaced_entry>& entries) {
+    if (!m_open || playlist != m_playlist) return;
+    metadb_handle_list old_tracks, new_tracks;
+    for (size_t i = 0; i < entries.get_count(); i++) {
+        const playlist_callback::t_on_items_replaced_entry& entry = entries[i];
+        old_tracks.add_item(entry.m_old);
+        new_tracks.add_item(entry.m_new);
+    }
+    apply(pending_add, new_tracks);
+    apply(pending_remove, old_tracks);
+}
+
+void track_search::on_tracks_changed(metadb_handle_list_cref tracks) {
+    if (!m_open) return;
+    // Only tracks already indexed are re-keyed
+    apply(pending_change, tracks);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "stdafx.h"
+#include "track_search_index.h"
+#include <functional>
+#include <unordered_map>
+
+// Jump-to-track search over the media library plus one playlist (the one shown in Up Next).
+// Each track is keyed by "artist title album", folded by make_search_key so accents and case do
+// not matter, and indexed by track_search_index. The first build runs on a worker from a handle
+// snapshot taken on the main thread; afterwards library, playlist and metadb notifications
+// update single entries. Notifications that arrive during a build are replayed once it lands.
+//
+// A track in both the library and the playlist (or several times in the playlist) is indexed
+// once and reference counted. Main thread only.
+class track_search {
+public:
+    track_search();
+    ~track_search();
+
+    // Build the index for the library and the given playlist; on_changed runs whenever results
+    // may differ (build finished, entries changed)
+    void open(size_t playlist, std::function<void()> on_changed);
+    void close();
+    bool is_open() const { return m_open; }
+    // A rebuild keeps answering from the previous index until it lands
+    bool is_building() const { return m_building; }
+
+    // Rebuild the playlist part when Up Next switches playlists
+    void set_playlist(size_t playlist);
+
+    // Tracks matching every word of the query, in index order
+    void query(const char* query, size_t max_results, metadb_handle_list& out) const;
+
+    // Source notifications
+    void on_library_items_added(metadb_handle_list_cref tracks);
+    void on_library_items_removed(metadb_handle_list_cref tracks);
+    void on_playlist_items_added(size_t playlist, metadb_handle_list_cref tracks);
+    void on_playlist_items_removing(size_t playlist, const bit_array& mask);
+    void on_playlist_items_replaced(size_t playlist, const pfc::list_base_const_t<playlist_callback::t_on_items_replaced_entry>& entries);
+    void on_tracks_changed(metadb_handle_list_cref tracks);
+
+private:
+    struct slot {
+        track_search_index::entry_id id;
+        unsigned refs;
+    };
+
+    // Index plus the tracks behind its ids; built on the worker, then owned by the main thread
+    struct store {
+        track_search_index index;
+        std::vector<metadb_handle_ptr> tracks;  // By entry id; null once removed
+        std::unordered_map<const metadb_handle*, slot> slots;
+
+        // Return true if the searchable keys changed
+        bool add(const metadb_handle_ptr& track, const titleformat_object::ptr& script, pfc::string8& buffer);
+        bool remove(const metadb_handle_ptr& track);
+        bool change(const metadb_handle_ptr& track, const titleformat_object::ptr& script, pfc::string8& buffer);
+        void clear();
+    };
+
+    enum pending_op { pending_add, pending_remove, pending_change };
+    struct pending {
+        pending_op op;
+        metadb_handle_list tracks;
+    };
+
+    class library_listener;
+
+    bool m_open;
+    bool m_building;
+    size_t m_playlist;
+    unsigned m_generation;      // Bumped per build so stale results are dropped
+
+    store m_store;
+
+    std::vector<pending> m_pending;
+    std::unique_ptr<library_listener> m_library;
+    titleformat_object::ptr m_key_script;
+    std::function<void()> m_on_changed;
+    std::shared_ptr<bool> m_alive;  // Lets the worker completion detect a destroyed object
+
+    void start_build();
+    void on_build_finished(const std::shared_ptr<store>& result, double build_ms);
+    void apply(pending_op op, metadb_handle_list_cref tracks);
+    void notify_changed();
+
+    track_search(const track_search&) = delete;
+    track_search& operator=(const track_search&) = delete;
+};
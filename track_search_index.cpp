@@ -0,0 +1,167 @@
+#include "track_search_index.h"
+#include <algorithm>
+#include <cstring>
+
+// Three key bytes packed into one trigram; two-byte grams use the same map with a tag bit
+// above the 24 trigram bits. Spaces never appear inside a query word, so grams spanning a
+// word boundary are not indexed.
+static const uint32_t BIGRAM_TAG = 1u << 24;
+
+static inline uint32_t make_trigram(const char* p) {
+    return ((uint32_t)(uint8_t)p[0] << 16) | ((uint32_t)(uint8_t)p[1] << 8) | (uint32_t)(uint8_t)p[2];
+}
+
+static inline uint32_t make_bigram(const char* p) {
+    return BIGRAM_TAG | ((uint32_t)(uint8_t)p[0] << 8) | (uint32_t)(uint8_t)p[1];
+}
+
+// Distinct grams of a key, in sorted order
+static void collect_grams(const char* key, size_t length, std::vector<uint32_t>& grams) {
+    grams.clear();
+    for (size_t i = 0; i + 2 <= length; i++) {
+        if (key[i] == ' ' || key[i + 1] == ' ') continue;
+        grams.push_back(make_bigram(key + i));
+        if (i + 3 <= length && key[i + 2] != ' ') grams.push_back(make_trigram(key + i));
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+static void split_words(const char* query, std::vector<std::string>& words) {
+    words.clear();
+    const char* p = query;
+    while (*p) {
+        while (*p == ' ' || *p == '\t') p++;
+        const char* start = p;
+        while (*p && *p != ' ' && *p != '\t') p++;
+        if (p > start) words.emplace_back(start, p);
+    }
+}
+
+static bool contains(const char* text, size_t text_length, const std::string& word) {
+    if (word.length() > text_length) return false;
+    const char* end = text + text_length - word.length();
+    const char first = word[0];
+    for (const char* p = text; p <= end; p++) {
+        p = (const char*)memchr(p, first, (size_t)(end - p) + 1);
+        if (!p) return false;
+        if (memcmp(p, word.data(), word.length()) == 0) return true;
+    }
+    return false;
+}
+
+track_search_index::track_search_index()
+    : m_dead(0) {
+}
+
+void track_search_index::append_id(posting& list, entry_id id) {
+    // First id is stored as id + 1 so "last" can start at 0 for an empty list
+    uint32_t delta = list.count == 0 ? id + 1 : id - list.last;
+    while (delta >= 0x80) {
+        list.bytes.push_back((uint8_t)(delta | 0x80));
+        delta >>= 7;
+    }
+    list.bytes.push_back((uint8_t)delta);
+    list.last = id;
+    list.count++;
+}
+
+track_search_index::entry_id track_search_index::add(const char* key, size_t length) {
+    entry_id id = (entry_id)m_entries.size();
+    entry e = { (uint32_t)m_text.size(), (uint32_t)length, true };
+    m_entries.push_back(e);
+    m_text.insert(m_text.end(), key, key + length);
+
+    collect_grams(key, length, m_grams);
+    for (uint32_t gram : m_grams) {
+        append_id(m_postings[gram], id);
+    }
+    return id;
+}
+
+void track_search_index::remove(entry_id id) {
+    if (!is_live(id)) return;
+    m_entries[id].live = false;
+    m_dead++;
+}
+
+bool track_search_index::matches(const entry& e, const std::vector<std::string>& words) const {
+    const char* text = m_text.data() + e.offset;
+    for (const std::string& word : words) {
+        if (!contains(text, e.length, word)) return false;
+    }
+    return true;
+}
+
+void track_search_index::search(const char* query, size_t max_results, std::vector<entry_id>& out) const {
+    out.clear();
+    std::vector<std::string> words;
+    split_words(query, words);
+    if (words.empty() || max_results == 0) return;
+
+    // Rarest gram over all words; a gram nobody has means no match at all
+    const posting* rarest = nullptr;
+    for (const std::string& word : words) {
+        if (word.length() == 2) {
+            auto it = m_postings.find(make_bigram(word.data()));
+            if (it == m_postings.end()) return;
+            if (!rarest || it->second.count < rarest->count) rarest = &it->second;
+        }
+        for (size_t i = 0; i + 3 <= word.length(); i++) {
+            auto it = m_postings.find(make_trigram(word.data() + i));
+            if (it == m_postings.end()) return;
+            if (!rarest || it->second.count < rarest->count) rarest = &it->second;
+        }
+    }
+
+    if (rarest) {
+        entry_id id = 0;
+        const uint8_t* p = rarest->bytes.data();
+        const uint8_t* end = p + rarest->bytes.size();
+        bool first = true;
+        while (p < end) {
+            uint32_t delta = 0;
+            int shift = 0;
+            while (p < end) {
+                uint8_t b = *p++;
+                delta |= (uint32_t)(b & 0x7F) << shift;
+                if (!(b & 0x80)) break;
+                shift += 7;
+            }
+            id = first ? delta - 1 : id + delta;
+            first = false;
+            const entry& e = m_entries[id];
+            if (e.live && matches(e, words)) {
+                out.push_back(id);
+                if (out.size() >= max_results) return;
+            }
+        }
+        return;
+    }
+
+    // Only one-byte words: scan in id order up to the limit
+    for (entry_id id = 0; id < (entry_id)m_entries.size(); id++) {
+        const entry& e = m_entries[id];
+        if (e.live && matches(e, words)) {
+            out.push_back(id);
+            if (out.size() >= max_results) return;
+        }
+    }
+}
+
+void track_search_index::clear() {
+    m_entries.clear();
+    m_text.clear();
+    m_postings.clear();
+    m_dead = 0;
+}
+
+size_t track_search_index::memory_bytes() const {
+    size_t bytes = m_entries.capacity() * sizeof(entry) + m_text.capacity();
+    // Node, bucket and vector overhead of the posting map, plus the encoded ids
+    bytes += m_postings.bucket_count() * sizeof(void*);
+    for (const auto& item : m_postings) {
+        bytes += sizeof(item) + 2 * sizeof(void*) + item.second.bytes.capacity();
+    }
+    return bytes;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// Portable trigram index behind the MiniPlayer's jump-to-track search. Entries are short,
+// already normalized keys ("artist title album", lowercased and diacritic-folded by the
+// caller); queries are whitespace-separated words that must all occur in a key.
+//
+// Every word of two or more bytes narrows the search to the rarest of its bigram/trigram posting
+// lists before candidates are verified by substring match; single-letter queries scan the keys
+// in order and stop at the result limit. Postings are delta/varint encoded and append-only: ids
+// only grow and removal only marks the entry dead, so the owner rebuilds the index from its
+// sources once wants_rebuild() says dead entries make up a quarter of it. Free of Windows and
+// SDK types; not thread-safe.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class track_search_index {
+public:
+    typedef uint32_t entry_id;
+    static const entry_id invalid_id = 0xFFFFFFFFu;
+
+    track_search_index();
+
+    // Add a normalized key; ids are assigned in increasing order
+    entry_id add(const char* key, size_t length);
+    entry_id add(const std::string& key) { return add(key.data(), key.length()); }
+
+    // Mark an entry dead; it stops matching immediately
+    void remove(entry_id id);
+
+    bool is_live(entry_id id) const { return id < m_entries.size() && m_entries[id].live; }
+
+    // Stored key of a live entry, not null-terminated
+    const char* key(entry_id id, size_t& length) const {
+        length = m_entries[id].length;
+        return m_text.data() + m_entries[id].offset;
+    }
+
+    // Live entries containing every word of the normalized query, in id order, at most max_results.
+    // An empty query matches nothing.
+    void search(const char* query, size_t max_results, std::vector<entry_id>& out) const;
+
+    void clear();
+
+    bool wants_rebuild() const { return m_dead > 1024 && m_dead * 4 > m_entries.size(); }
+
+    size_t size() const { return m_entries.size() - m_dead; }
+    size_t memory_bytes() const;
+
+private:
+    struct entry {
+        uint32_t offset;    // Key bytes in m_text
+        uint32_t length;
+        bool live;
+    };
+
+    struct posting {
+        std::vector<uint8_t> bytes; // Varint deltas between successive ids
+        uint32_t count;
+        entry_id last;
+    };
+
+    std::vector<entry> m_entries;
+    std::vector<char> m_text;
+    std::unordered_map<uint32_t, posting> m_postings;
+    size_t m_dead;
+    std::vector<uint32_t> m_grams;  // Scratch for add()
+
+    static void append_id(posting& list, entry_id id);
+    bool matches(const entry& e, const std::vector<std::string>& words) const;
+};
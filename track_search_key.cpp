@@ -0,0 +1,11 @@
+#include "track_search_key.h"
+#include <functional>
+#include <pfc/SmartStrStr.h>
+
+void make_search_key(const char* text, size_t length, pfc::string8& out) {
+    // SmartStrStr's transform only folds the characters; it compares case-insensitively on
+    // top of that, so lowercase the result as well
+    pfc::string8 folded;
+    SmartStrStr::global().transformStrHere(folded, text, length);
+    pfc::stringToLowerHere(out, folded.c_str(), folded.length());
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// Folding shared by the keys in the track search index and the queries run against it, so
+// that plain substring matching on both agrees with SmartStrStr::testSubstring: diacritics
+// and ligatures fold to their base letters ("Café" -> "cafe", "Æ" -> "ae") and case is dropped.
+// Needs only pfc; any thread.
+
+#include <pfc/pfc-lite.h>
+#include <pfc/string_base.h>
+
+void make_search_key(const char* text, size_t length, pfc::string8& out);
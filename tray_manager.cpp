@@ -7,6 +7,10 @@
 #include "popup_window.h"
 #include "control_panel.h"
 #include "volume_popup.h"
+#include "stream_metadata.h"
+#include "startup.h"
+#include "perf_stats.h"
+#include "tracing.h"
 
 // External declaration from main.cpp
 extern HINSTANCE g_hIns;
@@ -44,14 +48,20 @@ tray_manager::tray_manager()
     , m_tray_window(nullptr)
     , m_tray_added(false)
     , m_initialized(false)
+    , m_deferred_initialized(false)
     , m_was_visible(true)
     , m_was_minimized(false)
     , m_processing_minimize(false)
     , m_ignore_next_lbuttonup(false)
     , m_last_dblclk_time(0)
     , m_original_wndproc(nullptr)
+    , m_default_icon(nullptr)
+    , m_state_icon_size(0)
+    , m_state_icons_light(false)
+    , m_icon_state(tray_icon_stopped)
 {
     memset(&m_nid, 0, sizeof(m_nid));
+    for (HICON& icon : m_state_icons) icon = nullptr;
 }
 
 tray_manager::~tray_manager() {
@@ -87,18 +97,14 @@ void tray_manager::initialize() {
         // Fallback to default application icon
         m_nid.hIcon = LoadIcon(nullptr, IDI_APPLICATION);
     }
+    m_default_icon = m_nid.hIcon;
     wcsncpy_s(m_nid.szTip, _countof(m_nid.szTip), L"foobar2000 - Tray Controls", _TRUNCATE);
 
     // Add tray icon immediately - always visible
     Shell_NotifyIcon(NIM_ADD, &m_nid);
     m_tray_added = true;
 
-    // Install low-level mouse hook for wheel volume control over tray icon
-    if (!s_mouse_hook) {
-        s_mouse_hook = SetWindowsHookEx(WH_MOUSE_LL, low_level_mouse_proc, g_hIns, 0);
-    }
-
-    // Use window subclassing for minimize detection only
+    // Use window subclassing for minimize detection only (no polling: see window_proc)
     m_original_wndproc = (WNDPROC)SetWindowLongPtr(m_main_window, GWLP_WNDPROC, (LONG_PTR)window_proc);
     
     
@@ -106,10 +112,36 @@ void tray_manager::initialize() {
     m_was_visible = IsWindowVisible(m_main_window);
     m_was_minimized = IsIconic(m_main_window);
 
+    // Everything else waits for complete_initialization() once foobar2000 is idle
+    m_initialized = true;
+}
+
+void tray_manager::complete_initialization() {
+    if (!m_initialized || m_deferred_initialized) return;
+    m_deferred_initialized = true;
+
+    if (!m_tray_window) return;
+
+    LARGE_INTEGER phase_start;
+
+    // Install low-level mouse hook for wheel volume control over tray icon
+    QueryPerformanceCounter(&phase_start);
+    if (!s_mouse_hook) {
+        s_mouse_hook = SetWindowsHookEx(WH_MOUSE_LL, low_level_mouse_proc, g_hIns, 0);
+    }
+    record_startup_phase("mouse hook", phase_start);
+
+    // Rasterize the playback state icon variants (the static resource icon is shown until now)
+    QueryPerformanceCounter(&phase_start);
+    rebuild_state_icons();
+    record_startup_phase("tray icon variants", phase_start);
+
     // Try to get current playing track for initial tooltip
+    QueryPerformanceCounter(&phase_start);
     try {
         static_api_ptr_t<playback_control> pc;
         if (pc->is_playing()) {
+            set_icon_state(pc->is_paused() ? tray_icon_paused : tray_icon_playing);
             metadb_handle_ptr track;
             if (pc->get_now_playing(track) && track.is_valid()) {
                 update_tooltip(track);
@@ -125,18 +157,16 @@ void tray_manager::initialize() {
         // Keep default tooltip if anything fails
     }
 
-    // Mouse hook removed - was causing system freezing conflicts with artwork downloading components
+    record_startup_phase("initial tooltip", phase_start);
 
     // Initialize popup window and control panel
+    QueryPerformanceCounter(&phase_start);
     popup_window::get_instance().initialize();
-    control_panel::get_instance().initialize();
-    
-    // Start timer to periodically check for track changes and window visibility (every 500ms)
-    if (m_tray_window) {
-        SetTimer(m_tray_window, TOOLTIP_TIMER_ID, 500, tooltip_timer_proc);
-    }
+    record_startup_phase("popup window", phase_start);
 
-    m_initialized = true;
+    QueryPerformanceCounter(&phase_start);
+    control_panel::get_instance().initialize();
+    record_startup_phase("control panel", phase_start);
 }
 
 void tray_manager::cleanup() {
@@ -144,11 +174,6 @@ void tray_manager::cleanup() {
     popup_window::get_instance().cleanup();
     control_panel::get_instance().cleanup();
 
-    // Kill the tooltip update timer
-    if (m_tray_window) {
-        KillTimer(m_tray_window, TOOLTIP_TIMER_ID);
-    }
-
     // Remove low-level mouse hook
     if (s_mouse_hook) {
         UnhookWindowsHookEx(s_mouse_hook);
@@ -159,6 +184,8 @@ void tray_manager::cleanup() {
         Shell_NotifyIcon(NIM_DELETE, &m_nid);
         m_tray_added = false;
     }
+    destroy_state_icons();
+    m_nid.hIcon = m_default_icon;
 
     if (m_main_window && m_original_wndproc) {
         SetWindowLongPtr(m_main_window, GWLP_WNDPROC, (LONG_PTR)m_original_wndproc);
@@ -172,6 +199,7 @@ void tray_manager::cleanup() {
     }
 
     m_initialized = false;
+    m_deferred_initialized = false;
 }
 
 bool tray_manager::create_tray_window() {
@@ -247,6 +275,12 @@ static bool is_remote_stream_path(const char* path) {
 }
 
 void tray_manager::update_tooltip(metadb_handle_ptr p_track) {
+    if (m_initialized && p_track.is_valid()) {
+        // New track or edited tags: playing unless the edit arrived while paused
+        try {
+            set_icon_state(playback_control::get()->is_paused() ? tray_icon_paused : tray_icon_playing);
+        } catch (...) {}
+    }
     if (!m_initialized || !p_track.is_valid()) {
         wcsncpy_s(m_nid.szTip, _countof(m_nid.szTip), L"foobar2000 - No Track", _TRUNCATE);
         if (m_tray_added) {
@@ -349,120 +383,12 @@ void tray_manager::update_tooltip_from_playback() {
     } catch (...) {}
 }
 
-static const char* safe_meta_get_tray(const file_info& info, const char* name) {
-    t_size index = info.meta_find(name);
-    if (index != pfc_infinite && info.meta_enum_value_count(index) > 0) {
-        const char* val = info.meta_enum_value(index, 0);
-        if (val && val[0] != '\0') return val;
-    }
-    return nullptr;
-}
-
-static bool is_inverted_stream_tray(const file_info& info, metadb_handle_ptr track = nullptr) {
-    try {
-        if (track.is_valid()) {
-            pfc::string8 path = track->get_path();
-            if (!path.is_empty()) {
-                std::string path_str = path.c_str();
-                std::transform(path_str.begin(), path_str.end(), path_str.begin(), ::tolower);
-                if (path_str.find("?inverted") != std::string::npos ||
-                    path_str.find("&inverted") != std::string::npos ||
-                    path_str.find("#inverted") != std::string::npos) {
-                    return true;
-                }
-            }
-        }
-        
-        t_size index = info.meta_find("STREAM_INVERTED");
-        if (index != pfc_infinite && info.meta_enum_value_count(index) > 0) {
-            const char* val = info.meta_enum_value(index, 0);
-            if (val && strcmp(val, "1") == 0) return true;
-        }
-    } catch (...) {}
-    return false;
-}
-
-void tray_manager::update_tooltip_with_dynamic_info(const file_info & p_info) {
+void tray_manager::update_tooltip_with_dynamic_info(const stream_metadata& meta) {
     if (!m_initialized) return;
     
     try {
-        metadb_handle_ptr track = m_last_loaded_track;
-        if (!track.is_valid()) {
-            auto playback = playback_control::get();
-            if (!playback->get_now_playing(track) || !track.is_valid()) {
-                return;
-            }
-        }
-        pfc::string8 path = track->get_path();
-        if (!is_remote_stream_path(path.get_ptr())) {
-            return;
-        }
-
-        pfc::string8 artist, title;
-
-        const char* p_artist = safe_meta_get_tray(p_info, "ARTIST");
-        const char* p_title = safe_meta_get_tray(p_info, "TITLE");
-
-        const char* stream_title = safe_meta_get_tray(p_info, "STREAMTITLE");
-        if (!stream_title) {
-            stream_title = safe_meta_get_tray(p_info, "ICY_TITLE");
-        }
-
-        if (stream_title) {
-            const char* dash = strstr(stream_title, " - ");
-            if (dash) {
-                if (!p_artist) {
-                    artist.set_string(stream_title, dash - stream_title);
-                }
-                if (!p_title) {
-                    title.set_string(dash + 3);
-                }
-            } else if (!p_title) {
-                title = stream_title;
-            }
-        }
-
-        if (p_artist && artist.is_empty()) artist = p_artist;
-        if (p_title && title.is_empty()) title = p_title;
-
-        if (artist.is_empty() && !title.is_empty()) {
-            pfc::string8 temp = title;
-            const char* dash = strstr(temp.get_ptr(), " - ");
-            if (dash) {
-                artist.set_string(temp.get_ptr(), dash - temp.get_ptr());
-                title = dash + 3;
-            }
-        }
-
-        if (artist.is_empty()) {
-            const char* val = safe_meta_get_tray(p_info, "ALBUMARTIST");
-            if (val) artist = val;
-        }
-        if (artist.is_empty()) {
-            const char* val = safe_meta_get_tray(p_info, "PERFORMER");
-            if (val) artist = val;
-        }
-        if (title.is_empty()) {
-            const char* val = safe_meta_get_tray(p_info, "DESCRIPTION");
-            if (val) title = val;
-        }
-        if (title.is_empty()) {
-            const char* val = safe_meta_get_tray(p_info, "COMMENT");
-            if (val) title = val;
-        }
-        
-        if (artist.is_empty() && title.is_empty()) {
-            return;
-        }
-
-        artist.trim(' ');
-        title.trim(' ');
-
-        if (is_inverted_stream_tray(p_info, m_last_loaded_track)) {
-            pfc::string8 temp = artist;
-            artist = title;
-            title = temp;
-        }
+        const pfc::string8& artist = meta.artist;
+        const pfc::string8& title = meta.title;
 
         m_last_stream_artist = artist;
         m_last_stream_title = title;
@@ -505,6 +431,14 @@ void tray_manager::update_tooltip_with_dynamic_info(const file_info & p_info) {
 void tray_manager::update_playback_state(const char* state) {
     if (!m_initialized) return;
     
+    if (strcmp(state, "Playing") == 0) {
+        set_icon_state(tray_icon_playing);
+    } else if (strcmp(state, "Paused") == 0) {
+        set_icon_state(tray_icon_paused);
+    } else if (strcmp(state, "Stopped") == 0) {
+        set_icon_state(tray_icon_stopped);
+    }
+
     if (strcmp(state, "Playing") == 0) {
         if (!m_last_track_metadata.is_empty()) {
             pfc::stringcvt::string_wide_from_utf8 wide_tooltip(m_last_track_metadata.get_ptr());
@@ -532,6 +466,110 @@ void tray_manager::update_playback_state(const char* state) {
     }
 }
 
+// Publishes a changed icon on its own: the tooltip updates that follow skip their NIM_MODIFY
+// when the text is unchanged (same track restarted, tag edit that keeps the title)
+void tray_manager::set_icon_state(tray_icon_state state) {
+    m_icon_state = state;
+    if (!m_state_icons[state] || m_nid.hIcon == m_state_icons[state]) return;
+    m_nid.hIcon = m_state_icons[state];
+    if (m_tray_added) {
+        m_nid.uFlags = NIF_ICON;
+        Shell_NotifyIcon(NIM_MODIFY, &m_nid);
+    }
+}
+
+// Small icon size at the tray window's DPI, snapped to the sizes the shell uses (16/20/24/32)
+int tray_manager::get_tray_icon_size() {
+    UINT dpi = 0;
+    typedef UINT(WINAPI* PFN_GetDpiForWindow)(HWND);
+    static PFN_GetDpiForWindow pfnGetDpiForWindow = (PFN_GetDpiForWindow)GetProcAddress(
+        GetModuleHandle(L"user32.dll"), "GetDpiForWindow");
+    if (pfnGetDpiForWindow && m_tray_window) {
+        dpi = pfnGetDpiForWindow(m_tray_window);
+    }
+    if (dpi == 0) {
+        HDC hdc = GetDC(nullptr);
+        dpi = (UINT)GetDeviceCaps(hdc, LOGPIXELSX);
+        ReleaseDC(nullptr, hdc);
+    }
+    if (dpi == 0) dpi = 96;
+
+    int size = MulDiv(16, (int)dpi, 96);
+    if (size <= 16) return 16;
+    if (size <= 20) return 20;
+    if (size <= 24) return 24;
+    return 32;
+}
+
+// Windows 10/11 "apps and taskbar" light theme
+static bool is_light_taskbar() {
+    DWORD value = 0;
+    DWORD size = sizeof(value);
+    if (RegGetValue(HKEY_CURRENT_USER, L"Software\\Microsoft\\Windows\\CurrentVersion\\Themes\\Personalize",
+            L"SystemUsesLightTheme", RRF_RT_REG_DWORD, nullptr, &value, &size) == ERROR_SUCCESS) {
+        return value != 0;
+    }
+    return false;
+}
+
+// Regenerate the state icons only when the icon size or taskbar theme actually changed
+void tray_manager::rebuild_state_icons() {
+    // Not before idle initialization; startup only registers the static resource icon
+    if (!m_tray_window || !m_deferred_initialized) return;
+
+    int size = get_tray_icon_size();
+    bool light = is_light_taskbar();
+    if (m_state_icons[0] && size == m_state_icon_size && light == m_state_icons_light) return;
+
+    HICON icons[tray_icon_state_count] = {};
+    for (int state = 0; state < tray_icon_state_count; state++) {
+        icons[state] = svg_icon::create_tray_icon(size, (tray_icon_state)state, light);
+        TRAY_PERF_COUNT(perf_counter_gdi_objects);
+        if (!icons[state]) {
+            // Keep whatever is showing now rather than a partial set
+            for (HICON icon : icons) {
+                if (icon) DestroyIcon(icon);
+            }
+            return;
+        }
+    }
+
+#ifdef _DEBUG
+    char msg[96];
+    sprintf_s(msg, "tray icon: rasterized %d px variants (%s taskbar)\n", size, light ? "light" : "dark");
+    OutputDebugStringA(msg);
+#endif
+
+    // Publish the new set before destroying the old handles the shell may still reference
+    HICON old_icons[tray_icon_state_count];
+    for (int state = 0; state < tray_icon_state_count; state++) {
+        old_icons[state] = m_state_icons[state];
+        m_state_icons[state] = icons[state];
+    }
+    m_state_icon_size = size;
+    m_state_icons_light = light;
+
+    m_nid.hIcon = m_state_icons[m_icon_state];
+    if (m_tray_added) {
+        m_nid.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
+        Shell_NotifyIcon(NIM_MODIFY, &m_nid);
+    }
+
+    for (HICON icon : old_icons) {
+        if (icon) DestroyIcon(icon);
+    }
+}
+
+void tray_manager::destroy_state_icons() {
+    for (HICON& icon : m_state_icons) {
+        if (icon) {
+            DestroyIcon(icon);
+            icon = nullptr;
+        }
+    }
+    m_state_icon_size = 0;
+}
+
 HWND tray_manager::find_main_window() {
     HWND result = nullptr;
     
@@ -751,7 +789,24 @@ LRESULT CALLBACK tray_manager::window_proc(HWND hwnd, UINT msg, WPARAM wparam, L
                 break;
             }
             break;
-            
+
+        case WM_WINDOWPOSCHANGED:
+            {
+                // Shows, hides and minimizes that bypass WM_SYSCOMMAND (ShowWindow, SetWindowPlacement,
+                // Win+M, other components) all end here, so the cached state never needs polling
+                LRESULT result = s_instance->m_original_wndproc
+                    ? CallWindowProc(s_instance->m_original_wndproc, hwnd, msg, wparam, lparam)
+                    : DefWindowProc(hwnd, msg, wparam, lparam);
+                // Pure moves and z-order changes cannot change visibility or the minimized state
+                const WINDOWPOS* pos = reinterpret_cast<const WINDOWPOS*>(lparam);
+                bool state_may_change = !pos || !(pos->flags & SWP_NOSIZE) ||
+                    (pos->flags & (SWP_SHOWWINDOW | SWP_HIDEWINDOW)) != 0;
+                if (state_may_change) {
+                    s_instance->on_main_window_pos_changed();
+                }
+                return result;
+            }
+
         }
     }
     
@@ -798,6 +853,8 @@ LRESULT CALLBACK tray_manager::tray_window_proc(HWND hwnd, UINT msg, WPARAM wpar
     if (s_instance && s_instance->m_initialized) {
         switch (msg) {
         case WM_TRAYICON: // Tray icon message
+            // A click that beats the idle initialization finishes it first
+            s_instance->complete_initialization();
             switch (LOWORD(lparam)) {
             case WM_RBUTTONUP:
             case WM_CONTEXTMENU:
@@ -841,6 +898,18 @@ LRESULT CALLBACK tray_manager::tray_window_proc(HWND hwnd, UINT msg, WPARAM wpar
                 
             }
             return 0;
+
+        case WM_DPICHANGED:
+        case WM_THEMECHANGED:
+            s_instance->rebuild_state_icons();
+            break;
+
+        case WM_SETTINGCHANGE:
+            // Light/dark taskbar switches arrive as "ImmersiveColorSet"
+            if (lparam && wcscmp(reinterpret_cast<const wchar_t*>(lparam), L"ImmersiveColorSet") == 0) {
+                s_instance->rebuild_state_icons();
+            }
+            break;
         }
     }
     
@@ -882,6 +951,7 @@ bool tray_manager::is_cursor_over_tray_icon() {
 
 // Low-level mouse hook for wheel volume control over tray icon
 LRESULT CALLBACK tray_manager::low_level_mouse_proc(int nCode, WPARAM wParam, LPARAM lParam) {
+    TRAY_PERF_SCOPE(perf_phase_mouse_hook);
     if (nCode >= 0 && wParam == WM_MOUSEWHEEL && s_instance && s_instance->m_initialized) {
         MSLLHOOKSTRUCT* hookData = (MSLLHOOKSTRUCT*)lParam;
 
@@ -933,21 +1003,15 @@ LRESULT CALLBACK tray_manager::low_level_mouse_proc(int nCode, WPARAM wParam, LP
     return CallNextHookEx(s_mouse_hook, nCode, wParam, lParam);
 }
 
-// Timer procedure for periodic tooltip updates and window monitoring
-VOID CALLBACK tray_manager::tooltip_timer_proc(HWND hwnd, UINT msg, UINT_PTR timer_id, DWORD time) {
-    if (s_instance && timer_id == TOOLTIP_TIMER_ID && s_instance->m_initialized) {
-        s_instance->check_window_visibility();
-    }
-}
-
 // Check if the current track has changed and update tooltip accordingly
 void tray_manager::check_for_track_changes() {
     // No-op: Playback callbacks in main.cpp (tray_play_callback) handle all track and playback state changes
     // event-driven from foobar2000, eliminating periodic playback_control polling on the main UI thread.
 }
 
-// Check for window visibility changes and handle minimize behavior
-void tray_manager::check_window_visibility() {
+// Main window was shown, hidden, moved or resized: track visibility and handle minimize behavior
+void tray_manager::on_main_window_pos_changed() {
+    TRAY_TRACE_SCOPE("tray", "main window pos changed");
     if (!m_initialized || !m_main_window || m_processing_minimize) return;
 
     bool current_visible = IsWindowVisible(m_main_window);
@@ -962,6 +1026,7 @@ void tray_manager::check_window_visibility() {
 
             // Hide the window to tray
             ShowWindow(m_main_window, SW_HIDE);
+            current_visible = false;
 
             m_processing_minimize = false;
         }
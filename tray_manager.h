@@ -4,6 +4,9 @@
 #include "resource.h"
 #include "popup_window.h"
 #include "control_panel.h"
+#include "svg_icon.h"
+
+struct stream_metadata;
 
 // Tray manager class - singleton that handles all tray functionality
 class tray_manager {
@@ -12,13 +15,16 @@ public:
     static tray_manager& get_instance();
     
     // Lifecycle management
+    // initialize() only registers the tray icon; complete_initialization() does the rest
+    // (mouse hook, tooltip, popup and control panel windows) and is deferred to idle
     void initialize();
+    void complete_initialization();
     void cleanup();
     
     // Playback event handlers
     void update_tooltip(metadb_handle_ptr p_track);
     void update_tooltip_from_playback();
-    void update_tooltip_with_dynamic_info(const file_info & p_info);
+    void update_tooltip_with_dynamic_info(const stream_metadata& meta);
     void update_playback_state(const char* state);
     
     // Tray functionality - public interface
@@ -38,6 +44,7 @@ private:
     NOTIFYICONDATA m_nid;
     bool m_tray_added;
     bool m_initialized;
+    bool m_deferred_initialized;
     bool m_was_visible;
     bool m_was_minimized;
     bool m_processing_minimize;
@@ -46,8 +53,7 @@ private:
     WNDPROC m_original_wndproc;
     // Mouse hook removed - was causing conflicts with artwork downloading
     
-    // Timer for periodic tooltip updates and single-click disambiguation
-    static const UINT TOOLTIP_TIMER_ID = 2001;
+    // Timer for single-click disambiguation
     static const UINT TRAY_SINGLE_CLICK_TIMER_ID = 2002;
     pfc::string8 m_last_track_path;
     pfc::string8 m_last_track_metadata;
@@ -55,6 +61,14 @@ private:
     pfc::string8 m_last_stream_title;
     metadb_handle_ptr m_last_loaded_track;
 
+    // Tray icon variants rasterized once per icon size and taskbar theme, so play/pause
+    // changes are a handle swap on NIM_MODIFY. m_default_icon is shown until they exist.
+    HICON m_default_icon;
+    HICON m_state_icons[tray_icon_state_count];
+    int m_state_icon_size;
+    bool m_state_icons_light;
+    tray_icon_state m_icon_state;
+
     // Low-level mouse hook for volume wheel control over tray icon
     static HHOOK s_mouse_hook;
     static LRESULT CALLBACK low_level_mouse_proc(int nCode, WPARAM wParam, LPARAM lParam);
@@ -74,7 +88,10 @@ private:
     // Mouse wheel and hook functions removed - were causing conflicts with artwork downloading
     void force_update_tooltip();
     void check_for_track_changes();
-    void check_window_visibility();
-    static VOID CALLBACK tooltip_timer_proc(HWND hwnd, UINT msg, UINT_PTR timer_id, DWORD time);
+    void on_main_window_pos_changed();
+    void set_icon_state(tray_icon_state state);
+    void rebuild_state_icons();
+    void destroy_state_icons();
+    int get_tray_icon_size();
     static VOID CALLBACK single_click_timer_proc(HWND hwnd, UINT msg, UINT_PTR timer_id, DWORD time);
 };
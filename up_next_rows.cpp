@@ -0,0 +1,89 @@
+#include "up_next_rows.h"
+
+int64_t max_row_scroll(size_t item_count, int row_height, int view_height) {
+    if (row_height <= 0 || view_height <= 0) return 0;
+    int64_t content = (int64_t)item_count * row_height;
+    return content > view_height ? content - view_height : 0;
+}
+
+int64_t clamp_row_scroll(int64_t scroll_y, size_t item_count, int row_height, int view_height) {
+    int64_t max_scroll = max_row_scroll(item_count, row_height, view_height);
+    if (scroll_y > max_scroll) scroll_y = max_scroll;
+    if (scroll_y < 0) scroll_y = 0;
+    return scroll_y;
+}
+
+row_viewport compute_row_viewport(size_t item_count, int row_height, int view_height, int64_t scroll_y) {
+    row_viewport view = { 0, 0, 0 };
+    if (item_count == 0 || row_height <= 0 || view_height <= 0) return view;
+
+    scroll_y = clamp_row_scroll(scroll_y, item_count, row_height, view_height);
+    view.first = (size_t)(scroll_y / row_height);
+    view.first_top = -(int)(scroll_y % row_height);
+
+    // Rows from first_top down to the bottom edge, partial rows included
+    size_t count = (size_t)((view_height - view.first_top + row_height - 1) / row_height);
+    if (count > item_count - view.first) count = item_count - view.first;
+    view.count = count;
+    return view;
+}
+
+row_cache::row_cache(size_t capacity) {
+    reset(capacity);
+}
+
+void row_cache::reset(size_t capacity) {
+    m_slots.clear();
+    m_slots.resize(capacity);
+    clear();
+}
+
+void row_cache::clear() {
+    for (up_next_row& row : m_slots) drop(row);
+}
+
+const up_next_row* row_cache::find(size_t index) const {
+    if (m_slots.empty()) return nullptr;
+    const up_next_row& row = m_slots[index % m_slots.size()];
+    return row.index == index ? &row : nullptr;
+}
+
+up_next_row& row_cache::insert(size_t index) {
+    up_next_row& row = m_slots[index % m_slots.size()];
+    drop(row);
+    row.index = index;
+    return row;
+}
+
+void row_cache::invalidate_from(size_t index) {
+    for (up_next_row& row : m_slots) {
+        if (row.index != up_next_row::npos && row.index >= index) drop(row);
+    }
+}
+
+bool row_cache::find_missing_batch(size_t first, size_t count, size_t item_count, size_t batch_size,
+                                   size_t& batch_first, size_t& batch_count) const {
+    if (m_slots.empty() || batch_size == 0) return false;
+    size_t end = first + count;
+    if (end > item_count) end = item_count;
+
+    for (size_t index = first; index < end; index++) {
+        if (find(index)) continue;
+
+        batch_first = index - index % batch_size;
+        size_t batch_end = batch_first + batch_size;
+        if (batch_end > item_count) batch_end = item_count;
+        // A batch can never hold more rows than the cache has slots
+        if (batch_end - batch_first > m_slots.size()) batch_end = batch_first + m_slots.size();
+        batch_count = batch_end - batch_first;
+        return true;
+    }
+    return false;
+}
+
+void row_cache::drop(up_next_row& row) {
+    row.index = up_next_row::npos;
+    row.text.clear();
+    row.length.clear();
+    row.album_key.clear();
+}
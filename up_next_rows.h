@@ -0,0 +1,74 @@
+#pragma once
+
+// Portable bookkeeping behind the MiniPlayer's Up Next pane: which rows of a fixed-row-height
+// list a viewport shows, and a row cache whose memory depends only on the viewport, never on
+// the playlist length. Free of Windows and SDK types so it can be timed over synthetic lists.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Rows intersecting a viewport of a list scrolled by scroll_y pixels
+struct row_viewport {
+    size_t first;   // First row that is at least partly visible
+    size_t count;   // Rows at least partly visible (0 for an empty list)
+    int first_top;  // Top of the first row relative to the viewport top (0 or negative)
+};
+
+// Largest scroll offset that still fills the viewport (0 if the list fits)
+int64_t max_row_scroll(size_t item_count, int row_height, int view_height);
+
+int64_t clamp_row_scroll(int64_t scroll_y, size_t item_count, int row_height, int view_height);
+
+row_viewport compute_row_viewport(size_t item_count, int row_height, int view_height, int64_t scroll_y);
+
+// One formatted row, as the pane draws it
+struct up_next_row {
+    size_t index;           // Playlist index this row was formatted for (npos = empty slot)
+    std::string text;       // "[artist - ]title"
+    std::string length;     // "[%length%]"
+    std::string album_key;  // Identifies the row's thumbnail; rows of one album share it
+
+    static const size_t npos = (size_t)-1;
+};
+
+// Direct-mapped cache of formatted rows: row i lives in slot i % capacity. Any run of up to
+// capacity consecutive rows maps to distinct slots, so with capacity >= visible rows plus one
+// fetch batch on each side, scrolling never evicts a row that is still on screen.
+class row_cache {
+public:
+    explicit row_cache(size_t capacity = 0);
+
+    // Change the capacity; drops every cached row
+    void reset(size_t capacity);
+    size_t capacity() const { return m_slots.size(); }
+
+    const up_next_row* find(size_t index) const;
+
+    // Slot for index, emptied and tagged with index; evicts whatever was there
+    up_next_row& insert(size_t index);
+
+    void clear();
+
+    // Rows at or after index changed position (insertions/removals): drop them
+    void invalidate_from(size_t index);
+
+    // Drop cached rows for which pred(index) is true (modified items)
+    template <typename predicate>
+    void invalidate_if(predicate pred) {
+        for (up_next_row& row : m_slots) {
+            if (row.index != up_next_row::npos && pred(row.index)) drop(row);
+        }
+    }
+
+    // First run of uncached rows within [first, first + count), widened to whole batch_size-aligned
+    // batches and limited to item_count. Returns false when every row in the range is cached.
+    bool find_missing_batch(size_t first, size_t count, size_t item_count, size_t batch_size,
+                            size_t& batch_first, size_t& batch_count) const;
+
+private:
+    std::vector<up_next_row> m_slots;
+
+    static void drop(up_next_row& row);
+};
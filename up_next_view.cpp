@@ -0,0 +1,648 @@
+#include "stdafx.h"
+#include "up_next_view.h"
+#include "preferences.h"
+#include "startup.h"
+#include "perf_stats.h"
+#include "tracing.h"
+
+// Row height at 96 DPI; thumbnails fill the row minus a 3px inset top and bottom
+static const int ROW_HEIGHT_96 = 30;
+static const int THUMBNAIL_INSET = 3;
+
+// Decode album art into a size x size opaque thumbnail, center-cropped to fill. Any thread.
+static HBITMAP decode_thumbnail(const album_art_data_ptr& data, int size) {
+    if (!data.is_valid() || data->get_size() == 0 || size <= 0) return nullptr;
+    if (!ensure_gdiplus()) return nullptr;
+    TRAY_PERF_COUNT(perf_counter_artwork_decodes);
+
+    HBITMAP result = nullptr;
+    try {
+        CComPtr<IStream> stream;
+        stream.p = SHCreateMemStream(reinterpret_cast<const BYTE*>(data->get_ptr()), static_cast<UINT>(data->get_size()));
+        if (!stream) return nullptr;
+
+        Gdiplus::Image image(stream);
+        if (image.GetLastStatus() != Gdiplus::Ok) return nullptr;
+        UINT width = image.GetWidth();
+        UINT height = image.GetHeight();
+        if (width == 0 || height == 0) return nullptr;
+
+        Gdiplus::Bitmap bitmap(size, size, PixelFormat32bppARGB);
+        if (bitmap.GetLastStatus() != Gdiplus::Ok) return nullptr;
+        Gdiplus::Graphics graphics(&bitmap);
+        graphics.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
+        graphics.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHighQuality);
+
+        // Square crop from the middle of the longer side
+        UINT side = width < height ? width : height;
+        Gdiplus::Rect dest(0, 0, size, size);
+        graphics.DrawImage(&image, dest, (INT)((width - side) / 2), (INT)((height - side) / 2),
+            (INT)side, (INT)side, Gdiplus::UnitPixel);
+
+        if (bitmap.GetHBITMAP(Gdiplus::Color(0, 0, 0), &result) != Gdiplus::Ok) {
+            result = nullptr;
+        }
+    } catch (...) {
+        result = nullptr;
+    }
+    return result;
+}
+
+up_next_view::up_next_view()
+    : m_owner(nullptr)
+    , m_open(false)
+    , m_playlist(pfc_infinite)
+    , m_scroll_y(0)
+    , m_follow_playing(true)
+    , m_font(nullptr)
+    , m_font_dpi(0)
+    , m_row_height(ROW_HEIGHT_96)
+    , m_list_rect()
+    , m_close_rect()
+    , m_viewport()
+    , m_paint_count(0)
+    , m_thumbnail_pending(false)
+    , m_alive(std::make_shared<bool>(true))
+    , m_results_dirty(false)
+    , m_selected(0)
+    , m_results_scroll_y(0) {
+}
+
+up_next_view::~up_next_view() {
+    m_alive.reset();
+    release_resources();
+}
+
+void up_next_view::attach(HWND owner) {
+    m_owner = owner;
+}
+
+void up_next_view::detach() {
+    close();
+    m_owner = nullptr;
+}
+
+void up_next_view::open() {
+    if (m_open) return;
+    TRAY_TRACE_INSTANT("ui", "up next open");
+    m_open = true;
+    m_playlist = pfc_infinite;
+    resolve_playlist();
+    m_follow_playing = true;
+    invalidate();
+}
+
+void up_next_view::close() {
+    if (!m_open) return;
+    invalidate();
+    m_open = false;
+    m_search.close();
+    m_query.clear();
+    m_results.clear();
+    release_resources();
+}
+
+void up_next_view::resolve_playlist() {
+    auto pm = playlist_manager::get();
+    size_t playlist = pm->get_playing_playlist();
+    if (playlist == pfc_infinite) playlist = pm->get_active_playlist();
+    if (playlist != m_playlist) {
+        m_playlist = playlist;
+        m_follow_playing = true;
+        reset_rows();
+        m_search.set_playlist(playlist);
+    }
+}
+
+void up_next_view::reset_rows() {
+    m_rows.clear();
+    m_scroll_y = 0;
+}
+
+void up_next_view::ensure_resources(HDC hdc) {
+    if (m_text_script.is_empty()) {
+        auto compiler = titleformat_compiler::get();
+        compiler->compile_safe_ex(m_text_script, "[%artist% - ]%title%");
+        compiler->compile_safe_ex(m_length_script, "[%length%]");
+        compiler->compile_safe_ex(m_album_script, "$if2(%album artist%,%artist%)|%album%");
+    }
+
+    int dpi = GetDeviceCaps(hdc, LOGPIXELSY);
+    if (!m_font || dpi != m_font_dpi) {
+        if (m_font) DeleteObject(m_font);
+        LOGFONT lf = get_default_font(true, 9);
+        lf.lfHeight = -MulDiv(9, dpi, 72);
+        m_font = CreateFontIndirect(&lf);
+        m_font_dpi = dpi;
+        m_row_height = MulDiv(ROW_HEIGHT_96, dpi, 96);
+        // Thumbnails were decoded for the old row height
+        release_thumbnails();
+    }
+
+    // Visible rows plus one fetch batch on each side, so a batch never evicts a visible row
+    RECT client = {};
+    if (m_owner) GetClientRect(m_owner, &client);
+    size_t visible = (size_t)((client.bottom - client.top) / (m_row_height > 0 ? m_row_height : 1)) + 2;
+    size_t capacity = visible + 2 * FETCH_BATCH;
+    if (m_rows.capacity() < capacity) {
+        m_rows.reset(capacity);
+    }
+}
+
+void up_next_view::release_resources() {
+    m_rows.reset(0);
+    release_thumbnails();
+    if (m_font) {
+        DeleteObject(m_font);
+        m_font = nullptr;
+    }
+    m_font_dpi = 0;
+}
+
+void up_next_view::fetch_rows(size_t first, size_t count, size_t item_count) {
+    TRAY_TRACE_SCOPE("ui", "up next fetch rows");
+    auto pm = playlist_manager::get();
+    pfc::string8 buffer;
+    metadb_handle_ptr track;
+    for (size_t index = first; index < first + count && index < item_count; index++) {
+        up_next_row& row = m_rows.insert(index);
+        if (!pm->playlist_get_item_handle(track, m_playlist, index)) continue;
+        track->format_title(nullptr, buffer, m_text_script, nullptr);
+        row.text = buffer.c_str();
+        track->format_title(nullptr, buffer, m_length_script, nullptr);
+        row.length = buffer.c_str();
+        track->format_title(nullptr, buffer, m_album_script, nullptr);
+        row.album_key = buffer.c_str();
+    }
+}
+
+void up_next_view::scroll_to_playing(size_t item_count, int view_height) {
+    size_t playlist = pfc_infinite, index = pfc_infinite;
+    auto pm = playlist_manager::get();
+    if (pm->get_playing_item_location(&playlist, &index) && playlist == m_playlist) {
+        // Playing track on top, what follows it below
+        m_scroll_y = (int64_t)index * m_row_height;
+    } else {
+        m_scroll_y = 0;
+    }
+    m_scroll_y = clamp_row_scroll(m_scroll_y, item_count, m_row_height, view_height);
+}
+
+void up_next_view::invalidate() {
+    if (m_open && m_owner) {
+        InvalidateRect(m_owner, nullptr, FALSE);
+    }
+}
+
+void up_next_view::paint(HDC hdc, const RECT& rect, COLORREF text_color, COLORREF dim_color, COLORREF accent_color) {
+    if (!m_open || !hdc) return;
+    TRAY_TRACE_SCOPE("paint", "up next");
+    ensure_resources(hdc);
+    m_paint_count++;
+
+    auto pm = playlist_manager::get();
+    if (m_playlist == pfc_infinite || m_playlist >= pm->get_playlist_count()) {
+        m_playlist = pfc_infinite;
+        resolve_playlist();
+    }
+    size_t item_count = m_playlist != pfc_infinite ? pm->playlist_get_item_count(m_playlist) : 0;
+
+    HFONT old_font = (HFONT)SelectObject(hdc, m_font);
+    SetBkMode(hdc, TRANSPARENT);
+    int pad = m_row_height / 3;
+
+    // Header: playlist name, or the query while searching, and a close button
+    m_close_rect = { rect.right - m_row_height, rect.top, rect.right, rect.top + m_row_height };
+    RECT header_rect = { rect.left + pad, rect.top, m_close_rect.left, rect.top + m_row_height };
+    if (is_searching()) {
+        // Right-aligned once too long, so the end of the query and the caret stay in view
+        std::wstring field = L"Search: " + m_query + L"|";
+        SIZE field_size = {};
+        GetTextExtentPoint32W(hdc, field.c_str(), (int)field.length(), &field_size);
+        UINT align = field_size.cx > header_rect.right - header_rect.left ? DT_RIGHT : DT_LEFT;
+        SetTextColor(hdc, accent_color);
+        DrawText(hdc, field.c_str(), -1, &header_rect, align | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
+    } else {
+        pfc::string8 header = "Up Next";
+        pfc::string8 playlist_name;
+        if (m_playlist != pfc_infinite && pm->playlist_get_name(m_playlist, playlist_name)) {
+            header << " \xE2\x80\x94 " << playlist_name;
+        }
+        SetTextColor(hdc, text_color);
+        DrawText(hdc, pfc::stringcvt::string_wide_from_utf8(header).get_ptr(), -1, &header_rect,
+            DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+    }
+
+    int cross = m_row_height / 4;
+    int cx = (m_close_rect.left + m_close_rect.right) / 2;
+    int cy = (m_close_rect.top + m_close_rect.bottom) / 2;
+    HPEN cross_pen = CreatePen(PS_SOLID, (std::max)(1, m_font_dpi / 96), dim_color);
+    TRAY_PERF_COUNT(perf_counter_gdi_objects);
+    HPEN old_pen = (HPEN)SelectObject(hdc, cross_pen);
+    MoveToEx(hdc, cx - cross, cy - cross, nullptr);
+    LineTo(hdc, cx + cross, cy + cross);
+    MoveToEx(hdc, cx + cross, cy - cross, nullptr);
+    LineTo(hdc, cx - cross, cy + cross);
+    SelectObject(hdc, old_pen);
+    DeleteObject(cross_pen);
+
+    // Rows
+    m_list_rect = { rect.left, rect.top + m_row_height, rect.right, rect.bottom };
+    if (is_searching()) {
+        paint_results(hdc, text_color, dim_color, accent_color, pad);
+        SelectObject(hdc, old_font);
+        return;
+    }
+    int view_height = m_list_rect.bottom - m_list_rect.top;
+    if (m_follow_playing) {
+        scroll_to_playing(item_count, view_height);
+        m_follow_playing = false;
+    }
+    m_scroll_y = clamp_row_scroll(m_scroll_y, item_count, m_row_height, view_height);
+    m_viewport = compute_row_viewport(item_count, m_row_height, view_height, m_scroll_y);
+
+    size_t batch_first = 0, batch_count = 0;
+    while (m_rows.find_missing_batch(m_viewport.first, m_viewport.count, item_count, FETCH_BATCH, batch_first, batch_count)) {
+        fetch_rows(batch_first, batch_count, item_count);
+    }
+
+    size_t playing_playlist = pfc_infinite, playing_index = pfc_infinite;
+    if (!pm->get_playing_item_location(&playing_playlist, &playing_index) || playing_playlist != m_playlist) {
+        playing_index = pfc_infinite;
+    }
+
+    int saved_dc = SaveDC(hdc);
+    IntersectClipRect(hdc, m_list_rect.left, m_list_rect.top, m_list_rect.right, m_list_rect.bottom);
+
+    HDC thumb_dc = CreateCompatibleDC(hdc);
+    TRAY_PERF_COUNT(perf_counter_gdi_objects);
+    HBRUSH placeholder_brush = CreateSolidBrush(dim_color);
+    TRAY_PERF_COUNT(perf_counter_gdi_objects);
+    int thumb_size = m_row_height - 2 * THUMBNAIL_INSET;
+    size_t first_missing_thumbnail = pfc_infinite;
+
+    for (size_t i = 0; i < m_viewport.count; i++) {
+        size_t index = m_viewport.first + i;
+        const up_next_row* row = m_rows.find(index);
+        if (!row) continue;
+
+        int top = m_list_rect.top + m_viewport.first_top + (int)i * m_row_height;
+        RECT thumb_rect = { rect.left + pad, top + THUMBNAIL_INSET, rect.left + pad + thumb_size, top + THUMBNAIL_INSET + thumb_size };
+        thumbnail* thumb = find_thumbnail(row->album_key);
+        if (thumb) thumb->last_used = m_paint_count;
+        if (thumb && thumb->bitmap) {
+            HBITMAP old_bitmap = (HBITMAP)SelectObject(thumb_dc, thumb->bitmap);
+            BitBlt(hdc, thumb_rect.left, thumb_rect.top, thumb_size, thumb_size, thumb_dc, 0, 0, SRCCOPY);
+            SelectObject(thumb_dc, old_bitmap);
+        } else {
+            FrameRect(hdc, &thumb_rect, placeholder_brush);
+            if (!thumb && first_missing_thumbnail == pfc_infinite) first_missing_thumbnail = index;
+        }
+
+        int text_left = thumb_rect.right + pad;
+        SetTextColor(hdc, dim_color);
+        pfc::stringcvt::string_wide_from_utf8 wide_length(row->length.c_str());
+        SIZE length_size = {};
+        GetTextExtentPoint32W(hdc, wide_length.get_ptr(), (int)wcslen(wide_length.get_ptr()), &length_size);
+        RECT length_rect = { rect.right - pad - length_size.cx, top, rect.right - pad, top + m_row_height };
+        DrawText(hdc, wide_length.get_ptr(), -1, &length_rect, DT_RIGHT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
+
+        SetTextColor(hdc, index == playing_index ? accent_color : text_color);
+        RECT text_rect = { text_left, top, length_rect.left - pad, top + m_row_height };
+        DrawText(hdc, pfc::stringcvt::string_wide_from_utf8(row->text.c_str()).get_ptr(), -1, &text_rect,
+            DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+    }
+
+    DeleteObject(placeholder_brush);
+    DeleteDC(thumb_dc);
+
+    // Scroll position indicator along the right edge
+    int64_t max_scroll = max_row_scroll(item_count, m_row_height, view_height);
+    if (max_scroll > 0) {
+        int bar_width = (std::max)(2, m_row_height / 10);
+        int64_t content = (int64_t)item_count * m_row_height;
+        int bar_height = (std::max)(m_row_height / 2, (int)((int64_t)view_height * view_height / content));
+        int bar_top = m_list_rect.top + (int)((view_height - bar_height) * m_scroll_y / max_scroll);
+        RECT bar = { m_list_rect.right - bar_width - 2, bar_top, m_list_rect.right - 2, bar_top + bar_height };
+        HBRUSH bar_brush = CreateSolidBrush(dim_color);
+        TRAY_PERF_COUNT(perf_counter_gdi_objects);
+        FillRect(hdc, &bar, bar_brush);
+        DeleteObject(bar_brush);
+    }
+
+    RestoreDC(hdc, saved_dc);
+    SelectObject(hdc, old_font);
+
+    if (first_missing_thumbnail != pfc_infinite && !m_thumbnail_pending) {
+        const up_next_row* row = m_rows.find(first_missing_thumbnail);
+        if (row) request_thumbnail(first_missing_thumbnail, row->album_key);
+    }
+}
+
+bool up_next_view::handle_wheel(int wheel_delta) {
+    if (!m_open || m_row_height <= 0) return false;
+    int64_t& scroll_y = is_searching() ? m_results_scroll_y : m_scroll_y;
+    if (!is_searching()) m_follow_playing = false;
+    scroll_y -= (int64_t)wheel_delta * WHEEL_ROWS * m_row_height / WHEEL_DELTA;
+    if (scroll_y < 0) scroll_y = 0; // The bottom is clamped on paint, where the list height is known
+    invalidate();
+    return true;
+}
+
+bool up_next_view::handle_click(POINT pt) {
+    if (!m_open) return false;
+    if (PtInRect(&m_close_rect, pt)) {
+        close();
+        return true;
+    }
+    if (!PtInRect(&m_list_rect, pt) || m_row_height <= 0) return false;
+
+    int offset = pt.y - m_list_rect.top - m_viewport.first_top;
+    size_t index = m_viewport.first + (size_t)(offset / m_row_height);
+    if (offset < 0 || index >= m_viewport.first + m_viewport.count) return true;
+    if (is_searching()) {
+        jump_to(index);
+    } else if (m_playlist != pfc_infinite) {
+        playlist_manager::get()->playlist_execute_default_action(m_playlist, index);
+    }
+    return true;
+}
+
+bool up_next_view::is_header_drag_area(POINT pt) const {
+    return m_open && pt.y < m_list_rect.top && !PtInRect(&m_close_rect, pt);
+}
+
+bool up_next_view::handle_char(wchar_t ch) {
+    if (!m_open) return false;
+    switch (ch) {
+        case L'\b':
+            if (m_query.empty()) return false;
+            {
+                std::wstring query = m_query;
+                query.pop_back();
+                if (!query.empty() && IS_HIGH_SURROGATE(query.back())) query.pop_back();
+                set_query(query);
+            }
+            return true;
+        case 0x1B: // Escape
+            if (m_query.empty()) return false;
+            set_query(std::wstring());
+            return true;
+        case L'\r':
+            if (!is_searching()) return false;
+            if (m_results_dirty) run_query();
+            jump_to(m_selected);
+            return true;
+        default:
+            if (ch < 0x20 || ch == 0x7F) return false;
+            if (ch == L' ' && m_query.empty()) return true;
+            if (m_query.length() < 128) set_query(m_query + ch);
+            return true;
+    }
+}
+
+bool up_next_view::handle_key(UINT vk) {
+    if (!m_open || !is_searching() || m_row_height <= 0) return false;
+    int page = (std::max)(1, (int)((m_list_rect.bottom - m_list_rect.top) / m_row_height) - 1);
+    size_t last = m_results.empty() ? 0 : m_results.size() - 1;
+    switch (vk) {
+        case VK_UP: m_selected = m_selected > 0 ? m_selected - 1 : 0; break;
+        case VK_DOWN: m_selected = (std::min)(m_selected + 1, last); break;
+        case VK_PRIOR: m_selected = m_selected > (size_t)page ? m_selected - page : 0; break;
+        case VK_NEXT: m_selected = (std::min)(m_selected + page, last); break;
+        default: return false;
+    }
+
+    // Keep the selection in view
+    int64_t view_height = m_list_rect.bottom - m_list_rect.top;
+    int64_t top = (int64_t)m_selected * m_row_height;
+    if (top < m_results_scroll_y) m_results_scroll_y = top;
+    if (top + m_row_height > m_results_scroll_y + view_height) m_results_scroll_y = top + m_row_height - view_height;
+    invalidate();
+    return true;
+}
+
+void up_next_view::begin_search() {
+    if (!m_open || m_search.is_open()) return;
+    m_search.open(m_playlist, [this] {
+        m_results_dirty = true;
+        invalidate();
+    });
+}
+
+void up_next_view::set_query(const std::wstring& query) {
+    m_query = query;
+    m_selected = 0;
+    m_results_scroll_y = 0;
+    m_results_dirty = true;
+    if (!m_query.empty()) begin_search();
+    invalidate();
+}
+
+void up_next_view::run_query() {
+    m_results_dirty = false;
+    m_results.clear();
+    if (m_query.empty()) return;
+
+    metadb_handle_list tracks;
+    m_search.query(pfc::stringcvt::string_utf8_from_wide(m_query.c_str()), MAX_RESULTS, tracks);
+    m_results.resize(tracks.get_count());
+    pfc::string8 buffer;
+    for (size_t i = 0; i < tracks.get_count(); i++) {
+        search_result& result = m_results[i];
+        result.track = tracks[i];
+        result.track->format_title(nullptr, buffer, m_text_script, nullptr);
+        result.text = buffer.c_str();
+        result.track->format_title(nullptr, buffer, m_length_script, nullptr);
+        result.length = buffer.c_str();
+    }
+    if (m_selected >= m_results.size()) m_selected = 0;
+}
+
+void up_next_view::paint_results(HDC hdc, COLORREF text_color, COLORREF dim_color, COLORREF accent_color, int pad) {
+    if (m_results_dirty) run_query();
+
+    int view_height = m_list_rect.bottom - m_list_rect.top;
+    m_results_scroll_y = clamp_row_scroll(m_results_scroll_y, m_results.size(), m_row_height, view_height);
+    m_viewport = compute_row_viewport(m_results.size(), m_row_height, view_height, m_results_scroll_y);
+
+    int saved_dc = SaveDC(hdc);
+    IntersectClipRect(hdc, m_list_rect.left, m_list_rect.top, m_list_rect.right, m_list_rect.bottom);
+
+    if (m_results.empty()) {
+        // The first build can take a moment on a large library
+        RECT message_rect = { m_list_rect.left + pad, m_list_rect.top, m_list_rect.right - pad, m_list_rect.top + m_row_height };
+        SetTextColor(hdc, dim_color);
+        DrawText(hdc, m_search.is_building() ? L"Indexing\x2026" : L"No matches", -1, &message_rect,
+            DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
+    }
+
+    for (size_t i = 0; i < m_viewport.count; i++) {
+        size_t index = m_viewport.first + i;
+        const search_result& result = m_results[index];
+        int top = m_list_rect.top + m_viewport.first_top + (int)i * m_row_height;
+
+        SetTextColor(hdc, dim_color);
+        pfc::stringcvt::string_wide_from_utf8 wide_length(result.length.c_str());
+        SIZE length_size = {};
+        GetTextExtentPoint32W(hdc, wide_length.get_ptr(), (int)wcslen(wide_length.get_ptr()), &length_size);
+        RECT length_rect = { m_list_rect.right - pad - length_size.cx, top, m_list_rect.right - pad, top + m_row_height };
+        DrawText(hdc, wide_length.get_ptr(), -1, &length_rect, DT_RIGHT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
+
+        SetTextColor(hdc, index == m_selected ? accent_color : text_color);
+        RECT text_rect = { m_list_rect.left + pad, top, length_rect.left - pad, top + m_row_height };
+        DrawText(hdc, pfc::stringcvt::string_wide_from_utf8(result.text.c_str()).get_ptr(), -1, &text_rect,
+            DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+    }
+
+    RestoreDC(hdc, saved_dc);
+}
+
+void up_next_view::jump_to(size_t result) {
+    if (result >= m_results.size()) return;
+    TRAY_TRACE_INSTANT("ui", "search jump");
+    metadb_handle_ptr track = m_results[result].track;
+    try {
+        auto pm = playlist_manager::get();
+        size_t index = pfc_infinite;
+        if (m_playlist != pfc_infinite && pm->playlist_find_item(m_playlist, track, index)) {
+            pm->playlist_execute_default_action(m_playlist, index);
+        } else {
+            // Library track outside the playlist: play it through the queue
+            pm->queue_add_item(track);
+            playback_control::get()->start(playback_control::track_command_next);
+        }
+    } catch (...) {}
+    set_query(std::wstring());
+    m_follow_playing = true;
+}
+
+void up_next_view::on_items_added(size_t playlist, size_t start, metadb_handle_list_cref tracks) {
+    if (!m_open || playlist != m_playlist) return;
+    m_rows.invalidate_from(start);
+    m_search.on_playlist_items_added(playlist, tracks);
+    invalidate();
+}
+
+void up_next_view::on_items_removing(size_t playlist, const bit_array& mask) {
+    if (!m_open || playlist != m_playlist) return;
+    m_search.on_playlist_items_removing(playlist, mask);
+}
+
+void up_next_view::on_items_removed(size_t playlist, const bit_array& mask, size_t old_count) {
+    if (!m_open || playlist != m_playlist) return;
+    size_t first = mask.find_first(true, 0, old_count);
+    if (first < old_count) m_rows.invalidate_from(first);
+    invalidate();
+}
+
+void up_next_view::on_items_reordered(size_t playlist) {
+    if (!m_open || playlist != m_playlist) return;
+    m_rows.clear();
+    invalidate();
+}
+
+void up_next_view::on_items_modified(size_t playlist, const bit_array& mask) {
+    if (!m_open || playlist != m_playlist) return;
+    m_rows.invalidate_if([&mask](size_t index) { return mask.get(index); });
+    invalidate();
+}
+
+void up_next_view::on_items_replaced(size_t playlist, const bit_array& mask, const pfc::list_base_const_t<playlist_callback::t_on_items_replaced_entry>& entries) {
+    if (!m_open || playlist != m_playlist) return;
+    m_search.on_playlist_items_replaced(playlist, entries);
+    on_items_modified(playlist, mask);
+}
+
+void up_next_view::on_playlists_changed() {
+    if (!m_open) return;
+    // Indices may have shifted under us; re-resolve from scratch
+    m_playlist = pfc_infinite;
+    resolve_playlist();
+    invalidate();
+}
+
+void up_next_view::on_playing_track_changed() {
+    if (!m_open) return;
+    resolve_playlist();
+    m_follow_playing = true;
+    invalidate();
+}
+
+void up_next_view::on_tracks_changed(metadb_handle_list_cref tracks) {
+    if (!m_open) return;
+    m_search.on_tracks_changed(tracks);
+}
+
+up_next_view::thumbnail* up_next_view::find_thumbnail(const std::string& album_key) {
+    for (thumbnail& thumb : m_thumbnails) {
+        if (thumb.album_key == album_key) return &thumb;
+    }
+    return nullptr;
+}
+
+void up_next_view::request_thumbnail(size_t index, const std::string& album_key) {
+    metadb_handle_ptr track;
+    if (m_playlist == pfc_infinite || !playlist_manager::get()->playlist_get_item_handle(track, m_playlist, index)) return;
+
+    // One thumbnail per cached row at most: evict the least recently painted finished one
+    if (m_thumbnails.size() >= m_rows.capacity()) {
+        auto victim = m_thumbnails.end();
+        for (auto it = m_thumbnails.begin(); it != m_thumbnails.end(); ++it) {
+            if (it->loaded && (victim == m_thumbnails.end() || it->last_used < victim->last_used)) victim = it;
+        }
+        if (victim == m_thumbnails.end()) return;
+        if (victim->bitmap) DeleteObject(victim->bitmap);
+        m_thumbnails.erase(victim);
+    }
+    m_thumbnails.push_back({ album_key, nullptr, false, m_paint_count });
+    m_thumbnail_pending = true;
+
+    std::weak_ptr<bool> alive = m_alive;
+    up_next_view* self = this;
+    int size = m_row_height - 2 * THUMBNAIL_INSET;
+    fb2k::splitTask([alive, self, album_key, track, size] {
+        gdiplus_work_scope gdiplus_work;  // decode_thumbnail's Image and Graphics
+        album_art_data_ptr data;
+        try {
+            auto extractor = album_art_manager_v2::get()->open(
+                pfc::list_single_ref_t<metadb_handle_ptr>(track),
+                pfc::list_single_ref_t<GUID>(album_art_ids::cover_front),
+                fb2k::mainAborter());
+            if (extractor.is_valid()) {
+                extractor->query(album_art_ids::cover_front, data, fb2k::mainAborter());
+            }
+        } catch (...) {}
+        HBITMAP bitmap = decode_thumbnail(data, size);
+
+        fb2k::inMainThread([alive, self, album_key, bitmap] {
+            if (alive.expired()) {
+                if (bitmap) DeleteObject(bitmap);
+                return;
+            }
+            self->on_thumbnail_loaded(album_key, bitmap);
+        });
+    });
+}
+
+void up_next_view::on_thumbnail_loaded(const std::string& album_key, HBITMAP bitmap) {
+    m_thumbnail_pending = false;
+    thumbnail* thumb = find_thumbnail(album_key);
+    if (thumb && !thumb->loaded) {
+        thumb->bitmap = bitmap;
+        thumb->loaded = true;
+        if (bitmap) TRAY_PERF_COUNT(perf_counter_gdi_objects);
+    } else if (bitmap) {
+        // The pane closed or was resized while decoding
+        DeleteObject(bitmap);
+    }
+    // Paint again to show it and to start the next missing one
+    invalidate();
+}
+
+void up_next_view::release_thumbnails() {
+    for (thumbnail& thumb : m_thumbnails) {
+        if (thumb.bitmap) DeleteObject(thumb.bitmap);
+    }
+    m_thumbnails.clear();
+}
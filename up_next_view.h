@@ -0,0 +1,131 @@
+#pragma once
+
+#include "stdafx.h"
+#include "up_next_rows.h"
+#include "track_search.h"
+#include <memory>
+
+// Scrollable "Up Next" pane drawn inside the Undocked and Expanded MiniPlayer, listing the
+// playing playlist (or the active one when nothing plays). Rows are virtualized: only the
+// visible rows are fetched from playlist_manager, in aligned batches, and formatted with
+// precompiled titleformat scripts, so cost and memory follow the pane height, not the
+// playlist length. Album thumbnails are decoded one at a time off the main thread.
+//
+// Playlist edits arrive through traycontrols_playlist_callback and only drop the cached rows
+// they touch. Typing while the pane has focus turns the header into a search field: results
+// from track_search (library plus this playlist) replace the rows until the query is cleared.
+// Main thread only.
+class up_next_view {
+public:
+    up_next_view();
+    ~up_next_view();
+
+    // Window that is invalidated when rows or thumbnails change
+    void attach(HWND owner);
+    void detach();
+
+    // Show the pane scrolled to the playing track / hide it and release its rows and thumbnails
+    void open();
+    void close();
+    bool is_open() const { return m_open; }
+
+    void paint(HDC hdc, const RECT& rect, COLORREF text_color, COLORREF dim_color, COLORREF accent_color);
+
+    // Input in owner client coordinates; return true if the pane used the event
+    bool handle_wheel(int wheel_delta);
+    bool handle_click(POINT pt);
+    bool is_header_drag_area(POINT pt) const;
+
+    // Search input: characters from WM_CHAR (including backspace, enter and escape),
+    // navigation keys from WM_KEYDOWN
+    bool handle_char(wchar_t ch);
+    bool handle_key(UINT vk);
+
+    // Start indexing ahead of the first keystroke
+    void begin_search();
+
+    // Playlist notifications
+    void on_items_added(size_t playlist, size_t start, metadb_handle_list_cref tracks);
+    void on_items_removing(size_t playlist, const bit_array& mask);
+    void on_items_removed(size_t playlist, const bit_array& mask, size_t old_count);
+    void on_items_reordered(size_t playlist);
+    void on_items_modified(size_t playlist, const bit_array& mask);
+    void on_items_replaced(size_t playlist, const bit_array& mask, const pfc::list_base_const_t<playlist_callback::t_on_items_replaced_entry>& entries);
+    void on_playlists_changed();
+    void on_playing_track_changed();
+
+    // Metadb notification, for search keys
+    void on_tracks_changed(metadb_handle_list_cref tracks);
+
+private:
+    static const size_t FETCH_BATCH = 32;      // Rows fetched and formatted together
+    static const int WHEEL_ROWS = 3;           // Rows scrolled per wheel notch
+    static const size_t MAX_RESULTS = 100;     // Search results listed
+
+    struct thumbnail {
+        std::string album_key;
+        HBITMAP bitmap;         // null while loading, or if the album has no front cover
+        bool loaded;
+        unsigned last_used;     // Paint counter, for eviction
+    };
+
+    HWND m_owner;
+    bool m_open;
+    size_t m_playlist;          // Playlist shown, pfc_infinite if none
+    int64_t m_scroll_y;         // Pixels from the top of the list
+    bool m_follow_playing;      // Scroll to the playing track on the next paint
+
+    row_cache m_rows;
+    titleformat_object::ptr m_text_script;
+    titleformat_object::ptr m_length_script;
+    titleformat_object::ptr m_album_script;
+
+    HFONT m_font;
+    int m_font_dpi;
+    int m_row_height;
+
+    // Geometry of the last paint, for hit testing
+    RECT m_list_rect;
+    RECT m_close_rect;
+    row_viewport m_viewport;
+
+    std::vector<thumbnail> m_thumbnails;
+    unsigned m_paint_count;
+    bool m_thumbnail_pending;   // A decode is running on the worker
+    std::shared_ptr<bool> m_alive; // Lets worker completions detect a destroyed view
+
+    struct search_result {
+        metadb_handle_ptr track;
+        std::string text;
+        std::string length;
+    };
+
+    track_search m_search;
+    std::wstring m_query;
+    std::vector<search_result> m_results;
+    bool m_results_dirty;       // Query or index changed since the results were formatted
+    size_t m_selected;          // Result played by Enter
+    int64_t m_results_scroll_y;
+
+    void resolve_playlist();
+    void reset_rows();
+    void ensure_resources(HDC hdc);
+    void release_resources();
+    void fetch_rows(size_t first, size_t count, size_t item_count);
+    void scroll_to_playing(size_t item_count, int view_height);
+    void invalidate();
+
+    thumbnail* find_thumbnail(const std::string& album_key);
+    void request_thumbnail(size_t index, const std::string& album_key);
+    void on_thumbnail_loaded(const std::string& album_key, HBITMAP bitmap);
+    void release_thumbnails();
+
+    bool is_searching() const { return !m_query.empty(); }
+    void set_query(const std::wstring& query);
+    void run_query();
+    void paint_results(HDC hdc, COLORREF text_color, COLORREF dim_color, COLORREF accent_color, int pad);
+    void jump_to(size_t result);
+
+    up_next_view(const up_next_view&) = delete;
+    up_next_view& operator=(const up_next_view&) = delete;
+};
@@ -0,0 +1,89 @@
+// volume_osd_paint.cpp - Portable volume OSD painting (no precompiled header, no Windows dependency)
+
+#include "volume_osd_paint.h"
+#include <cmath>
+#include <string>
+#include <algorithm>
+
+void paint_speaker_icon(canvas& c, float x, float y, float size, float volume, canvas_color color) {
+    float scale = size / 24.0f;
+
+    // Draw speaker body polygon (common to all) - 6 points from Material Design SVG
+    const canvas_point speaker[6] = {
+        { x + 3.0f * scale, y + 8.0f * scale },
+        { x + 8.0f * scale, y + 8.0f * scale },
+        { x + 14.0f * scale, y + 2.0f * scale },
+        { x + 14.0f * scale, y + 22.0f * scale },
+        { x + 8.0f * scale, y + 16.0f * scale },
+        { x + 3.0f * scale, y + 16.0f * scale }
+    };
+    c.fill_polygon(speaker, 6, color);
+
+    if (volume <= 0.001f) {
+        // Mute icon state: draw Material Design 'X'
+        c.draw_line(x + 16.0f * scale, y + 8.0f * scale, x + 22.0f * scale, y + 16.0f * scale, 2.0f * scale, color);
+        c.draw_line(x + 22.0f * scale, y + 8.0f * scale, x + 16.0f * scale, y + 16.0f * scale, 2.0f * scale, color);
+    } else {
+        // Speaker icon state: draw double arc sound waves
+        c.draw_arc(x + 14.0f * scale, y + 7.0f * scale, 6.0f * scale, 10.0f * scale, -60.0f, 120.0f, 2.0f * scale, color);
+        c.draw_arc(x + 14.0f * scale, y + 3.0f * scale, 10.0f * scale, 18.0f * scale, -50.0f, 100.0f, 2.0f * scale, color);
+    }
+}
+
+void paint_volume_osd(canvas& c, const volume_osd_style& style) {
+    const int w = style.width;
+    const int h = style.height;
+    const float scale = style.dpi_scale;
+    if (w <= 0 || h <= 0) return;
+
+    // Color definitions
+    const canvas_color bg_color = style.dark ? canvas_color::rgb(32, 32, 36) : canvas_color::rgb(252, 252, 253);
+    const canvas_color border_color = style.dark ? canvas_color::rgb(60, 60, 64) : canvas_color::rgb(218, 218, 222);
+    const canvas_color icon_color = style.dark ? canvas_color::rgb(220, 220, 225) : canvas_color::rgb(40, 40, 45);
+    const canvas_color track_bg_color = style.dark ? canvas_color::rgb(65, 65, 70) : canvas_color::rgb(190, 190, 195);
+    const canvas_color text_color = style.dark ? canvas_color::rgb(240, 240, 245) : canvas_color::rgb(30, 30, 35);
+
+    // 1. Pill card background & border
+    float stroke = 1.0f * scale;
+    float pad = stroke * 0.5f;
+    float radius = (style.rounded_corners ? 12.0f : 6.0f) * scale;
+    c.fill_rounded_rect(pad, pad, (float)w - stroke, (float)h - stroke, radius, bg_color);
+    c.stroke_rounded_rect(pad, pad, (float)w - stroke, (float)h - stroke, radius, stroke, border_color);
+
+    float vol_pct = style.volume;
+    int vol_int = (int)std::round(vol_pct * 100.0f);
+
+    // 2. Speaker vector icon
+    int icon_size = (int)std::round(style.icon_size * scale);
+    int icon_x = (int)std::round(style.icon_x * scale);
+    int icon_y = (h - icon_size) / 2;
+    paint_speaker_icon(c, (float)icon_x, (float)icon_y, (float)icon_size, vol_pct, icon_color);
+
+    // 3. Measure the numeric display first so the track fits exactly
+    float font_size_pt = 10.5f * scale;
+    std::wstring vol_str = std::to_wstring(vol_int);
+    float text_w = (std::max)(c.measure_text(vol_str.c_str(), font_size_pt) + (8.0f * scale), style.text_width * scale);
+    float right_margin = 12.0f * scale;
+
+    // 4. Slider track bar & accent fill capsules
+    float track_x = style.track_x * scale;
+    float track_w = (float)w - track_x - text_w - right_margin;
+    float track_h = 6.0f * scale;
+    float track_y = ((float)h - track_h) * 0.5f;
+
+    if (track_w > 0.0f) {
+        c.fill_rounded_rect(track_x, track_y, track_w, track_h, track_h * 0.5f, track_bg_color);
+
+        float fill_w = track_w * vol_pct;
+        if (fill_w < track_h && vol_pct > 0.0f) fill_w = track_h;
+        if (fill_w > track_w) fill_w = track_w;
+
+        if (fill_w > 0.0f) {
+            c.fill_rounded_rect(track_x, track_y, fill_w, track_h, track_h * 0.5f, style.accent);
+        }
+    }
+
+    // 5. Numeric volume, right-aligned in its box
+    c.draw_text(vol_str.c_str(), (float)w - text_w - right_margin, 0.0f, text_w, (float)h, font_size_pt,
+        canvas_align_far, text_color);
+}
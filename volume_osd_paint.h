@@ -0,0 +1,27 @@
+#pragma once
+
+// Volume feedback OSD drawing, written against canvas so it runs on both the GDI+ backend
+// (volume_popup) and the portable software backend. No Windows dependency.
+
+#include "canvas.h"
+
+struct volume_osd_style {
+    int width;
+    int height;
+    float dpi_scale;       // 1.0 = 96 DPI
+    bool dark;
+    bool rounded_corners;
+    float volume;          // Slider position 0.0 - 1.0
+    canvas_color accent;   // Track fill
+
+    // Layout at 96 DPI
+    int icon_x;
+    int icon_size;
+    int track_x;
+    int text_width;
+};
+
+void paint_volume_osd(canvas& c, const volume_osd_style& style);
+
+// Material Design speaker glyph on a 24x24 grid: mute cross at or below 0.1%, sound waves above
+void paint_speaker_icon(canvas& c, float x, float y, float size, float volume, canvas_color color);
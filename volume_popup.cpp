@@ -1,6 +1,9 @@
 #include "stdafx.h"
 #include "volume_popup.h"
 #include "preferences.h"
+#include "startup.h"
+#include "gdiplus_canvas.h"
+#include "volume_osd_paint.h"
 #include <cmath>
 #include <string>
 
@@ -23,23 +26,6 @@ static inline float slider_to_db(float slider_pos) {
     return static_cast<float>(volume);
 }
 
-// Add rounded rectangle with smooth arcs to GDI+ GraphicsPath
-static void add_rounded_rect_to_path(Gdiplus::GraphicsPath& path, float x, float y, float width, float height, float radius) {
-    float diameter = radius * 2.0f;
-    if (diameter > width) diameter = width;
-    if (diameter > height) diameter = height;
-    if (diameter <= 0.0f) {
-        path.AddRectangle(Gdiplus::RectF(x, y, width, height));
-        return;
-    }
-
-    path.AddArc(x, y, diameter, diameter, 180.0f, 90.0f);
-    path.AddArc(x + width - diameter, y, diameter, diameter, 270.0f, 90.0f);
-    path.AddArc(x + width - diameter, y + height - diameter, diameter, diameter, 0.0f, 90.0f);
-    path.AddArc(x, y + height - diameter, diameter, diameter, 90.0f, 90.0f);
-    path.CloseFigure();
-}
-
 // Helper function to get system DPI scale ratio (1.0 = 100% / 96 DPI, 2.0 = 200% / 192 DPI)
 static float get_dpi_scale() {
     HDC hdc = GetDC(nullptr);
@@ -77,6 +63,8 @@ volume_popup& volume_popup::get_instance() {
 
 void volume_popup::initialize() {
     if (m_initialized) return;
+    // Painting uses GDI+
+    ensure_gdiplus();
     register_class();
     create_window();
     m_initialized = true;
@@ -359,7 +347,7 @@ void volume_popup::paint(HDC hdc) {
     
     RECT fill_rect = { track_left, track_rect.top, track_left + fill_width, track_rect.bottom };
     
-    HBRUSH fill_brush = CreateSolidBrush(get_volume_osd_color()); // User-configurable accent color
+    HBRUSH fill_brush = CreateSolidBrush(get_settings().volume_osd_color); // User-configurable accent color
     FillRect(hdc, &fill_rect, fill_brush);
     DeleteObject(fill_brush);
     
@@ -381,36 +369,6 @@ void volume_popup::paint(HDC hdc) {
     DeleteObject(thumb_pen);
 }
 
-// Draw volume icon matching Now Bar ControlPanelCore::draw_volume_icon
-// Exactly 2 icon states: Mute (<=0.001f) and Speaker (>0.001f)
-void volume_popup::draw_speaker_icon(Gdiplus::Graphics &g, int x, int y, int size, float volume_percent, const Gdiplus::Color &color) {
-    float scale = static_cast<float>(size) / 24.0f;
-    Gdiplus::SolidBrush brush(color);
-
-    // Draw speaker body polygon (common to all) - 6 points from Material Design SVG
-    Gdiplus::PointF speaker[6];
-    speaker[0] = Gdiplus::PointF(x + 3.0f * scale, y + 8.0f * scale);
-    speaker[1] = Gdiplus::PointF(x + 8.0f * scale, y + 8.0f * scale);
-    speaker[2] = Gdiplus::PointF(x + 14.0f * scale, y + 2.0f * scale);
-    speaker[3] = Gdiplus::PointF(x + 14.0f * scale, y + 22.0f * scale);
-    speaker[4] = Gdiplus::PointF(x + 8.0f * scale, y + 16.0f * scale);
-    speaker[5] = Gdiplus::PointF(x + 3.0f * scale, y + 16.0f * scale);
-    g.FillPolygon(&brush, speaker, 6);
-
-    if (volume_percent <= 0.001f) {
-        // Mute icon state: draw Material Design 'X'
-        Gdiplus::Pen pen(color, 2.0f * scale);
-        g.DrawLine(&pen, x + 16.0f * scale, y + 8.0f * scale, x + 22.0f * scale, y + 16.0f * scale);
-        g.DrawLine(&pen, x + 22.0f * scale, y + 8.0f * scale, x + 16.0f * scale, y + 16.0f * scale);
-    } else {
-        // Speaker icon state: draw double arc sound waves
-        Gdiplus::Pen pen(color, 2.0f * scale);
-        g.DrawArc(&pen, x + 14.0f * scale, y + 7.0f * scale, 6.0f * scale, 10.0f * scale, -60.0f, 120.0f);
-        g.DrawArc(&pen, x + 14.0f * scale, y + 3.0f * scale, 10.0f * scale, 18.0f * scale, -50.0f, 100.0f);
-    }
-}
-
-
 void volume_popup::paint_feedback(HDC hdc) {
     RECT rc;
     GetClientRect(m_window, &rc);
@@ -441,7 +399,7 @@ void volume_popup::paint_feedback(HDC hdc) {
 
     // Dark mode check
     bool is_dark = false;
-    int theme_mode = get_theme_mode(); // 0=Auto, 1=Dark, 2=Light
+    int theme_mode = get_settings().theme_mode; // 0=Auto, 1=Dark, 2=Light
     if (theme_mode == 0) {
         try {
             fb2k::CCoreDarkModeHooks darkModeHooks;
@@ -455,98 +413,26 @@ void volume_popup::paint_feedback(HDC hdc) {
         is_dark = false;
     }
 
-    // Color definitions
-    COLORREF bg_color = is_dark ? RGB(32, 32, 36) : RGB(252, 252, 253);
-    COLORREF border_color = is_dark ? RGB(60, 60, 64) : RGB(218, 218, 222);
-    COLORREF icon_color = is_dark ? RGB(220, 220, 225) : RGB(40, 40, 45);
-    COLORREF track_bg_color = is_dark ? RGB(65, 65, 70) : RGB(190, 190, 195);
-    COLORREF track_fill_color = get_volume_osd_color(); // User-configurable accent color
-    COLORREF text_color = is_dark ? RGB(240, 240, 245) : RGB(30, 30, 35);
-
-    // Initialize GDI+ Graphics
-    Gdiplus::Graphics g(mem_dc);
-    g.SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
-    g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-    float scale = get_dpi_scale();
-
-    // 1. Draw Pill Card Background & Border with GDI+ Anti-Aliasing
-    float stroke = 1.0f * scale;
-    float pad = stroke * 0.5f;
-    float radius = (get_use_rounded_corners() ? 12.0f : 6.0f) * scale;
-
-    Gdiplus::GraphicsPath card_path;
-    add_rounded_rect_to_path(card_path, pad, pad, (float)w - stroke, (float)h - stroke, radius);
-
-    Gdiplus::SolidBrush bg_brush(Gdiplus::Color(255, GetRValue(bg_color), GetGValue(bg_color), GetBValue(bg_color)));
-    Gdiplus::Pen border_pen(Gdiplus::Color(255, GetRValue(border_color), GetGValue(border_color), GetBValue(border_color)), stroke);
-
-    g.FillPath(&bg_brush, &card_path);
-    g.DrawPath(&border_pen, &card_path);
-
-    // Volume ratio 0.0 to 1.0
-    float vol_pct = db_to_slider(m_current_volume_db);
-    int vol_int = (int)std::round(vol_pct * 100.0f);
-
-    // 2. Draw Speaker Vector Icon
-    int icon_size = (int)std::round(FEEDBACK_ICON_SIZE * scale);
-    int icon_x = (int)std::round(FEEDBACK_ICON_X * scale);
-    int icon_y = (h - icon_size) / 2;
-
-    Gdiplus::Color gdiplus_icon_color(GetRValue(icon_color), GetGValue(icon_color), GetBValue(icon_color));
-    draw_speaker_icon(g, icon_x, icon_y, icon_size, vol_pct, gdiplus_icon_color);
-
-    // 4. Measure Numerical Volume Display dynamically first so track_w fits perfectly
-    g.SetTextRenderingHint(Gdiplus::TextRenderingHintAntiAliasGridFit);
-    float font_size_pt = 10.5f * scale;
-    Gdiplus::Font font(L"Segoe UI", font_size_pt, Gdiplus::FontStyleRegular, Gdiplus::UnitPoint);
-    Gdiplus::SolidBrush text_brush(Gdiplus::Color(255, GetRValue(text_color), GetGValue(text_color), GetBValue(text_color)));
-    Gdiplus::StringFormat format;
-    format.SetAlignment(Gdiplus::StringAlignmentFar);
-    format.SetLineAlignment(Gdiplus::StringAlignmentCenter);
-    format.SetFormatFlags(Gdiplus::StringFormatFlagsNoWrap);
-
-    std::wstring vol_str = std::to_wstring(vol_int);
-
-    // Measure exact string width needed for volume percentage text
-    Gdiplus::RectF bounds;
-    g.MeasureString(vol_str.c_str(), (int)vol_str.length(), &font, Gdiplus::PointF(0.0f, 0.0f), &format, &bounds);
-
-    float text_w = (std::max)(bounds.Width + (8.0f * scale), FEEDBACK_TEXT_W * scale);
-    float right_margin = 12.0f * scale;
-
-    // 3. Draw Slider Track Bar & Accent Fill
-    float track_x = FEEDBACK_TRACK_X * scale;
-    float track_w = (float)w - track_x - text_w - right_margin;
-    float track_h = 6.0f * scale;
-    float track_y = ((float)h - track_h) * 0.5f;
-
-    if (track_w > 0.0f) {
-        // Track background capsule
-        Gdiplus::GraphicsPath track_path;
-        add_rounded_rect_to_path(track_path, track_x, track_y, track_w, track_h, track_h * 0.5f);
-
-        Gdiplus::SolidBrush track_bg_brush(Gdiplus::Color(255, GetRValue(track_bg_color), GetGValue(track_bg_color), GetBValue(track_bg_color)));
-        g.FillPath(&track_bg_brush, &track_path);
-
-        // Filled Orange Accent Bar capsule
-        float fill_w = track_w * vol_pct;
-        if (fill_w < track_h && vol_pct > 0.0f) fill_w = track_h;
-        if (fill_w > track_w) fill_w = track_w;
-
-        if (fill_w > 0.0f) {
-            Gdiplus::GraphicsPath fill_path;
-            add_rounded_rect_to_path(fill_path, track_x, track_y, fill_w, track_h, track_h * 0.5f);
-
-            Gdiplus::SolidBrush track_fill_brush(Gdiplus::Color(255, GetRValue(track_fill_color), GetGValue(track_fill_color), GetBValue(track_fill_color)));
-            g.FillPath(&track_fill_brush, &fill_path);
-        }
+    // Drawing itself is backend-neutral (volume_osd_paint.cpp)
+    COLORREF accent = get_settings().volume_osd_color; // User-configurable accent color
+    volume_osd_style style = {};
+    style.width = w;
+    style.height = h;
+    style.dpi_scale = get_dpi_scale();
+    style.dark = is_dark;
+    style.rounded_corners = get_settings().use_rounded_corners;
+    style.volume = db_to_slider(m_current_volume_db);
+    style.accent = canvas_color::rgb(GetRValue(accent), GetGValue(accent), GetBValue(accent));
+    style.icon_x = FEEDBACK_ICON_X;
+    style.icon_size = FEEDBACK_ICON_SIZE;
+    style.track_x = FEEDBACK_TRACK_X;
+    style.text_width = FEEDBACK_TEXT_W;
+
+    {
+        gdiplus_canvas gfx(mem_dc, w, h);
+        paint_volume_osd(gfx, style);
     }
 
-    // Draw text inside calculated bounding box
-    Gdiplus::RectF text_rect((float)w - text_w - right_margin, 0.0f, text_w, (float)h);
-    g.DrawString(vol_str.c_str(), (int)vol_str.length(), &font, text_rect, &format, &text_brush);
-
     // Update Layered Window with AC_SRC_ALPHA for hardware per-pixel alpha composition
     RECT win_rect;
     GetWindowRect(m_window, &win_rect);
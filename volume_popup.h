@@ -57,7 +57,6 @@ private:
     void register_class();
     void paint(HDC hdc);
     void paint_feedback(HDC hdc);
-    void draw_speaker_icon(Gdiplus::Graphics &g, int x, int y, int size, float volume_percent, const Gdiplus::Color &color);
     void update_volume_from_point(POINT pt);
 
     
@@ -0,0 +1,201 @@
+#include "stdafx.h"
+#include "waveform_cache.h"
+#include "control_panel.h"
+#include "perf_stats.h"
+#include "tracing.h"
+#include <algorithm>
+#include <atomic>
+
+static const unsigned PEAK_BUCKETS = 2048;         // Several per pixel even on a wide seekbar
+static const size_t RECENT_LIMIT = 4;               // Current track plus a few skipped-back ones
+static const size_t DISK_FILE_LIMIT = 2000;         // About 8 MB of records
+static const unsigned PRUNE_INTERVAL = 32;          // Writes between directory scans
+static const t_filesize MAX_RECORD_SIZE = 1 << 20;
+
+static pfc::string8 get_cache_directory() {
+    pfc::string8 path = core_api::get_profile_path();
+    path.add_filename("foo_traycontrols_peaks");
+    return path;
+}
+
+// Keep the newest records; any thread
+static void prune_cache_directory(const char* directory) {
+    pfc::stringcvt::string_wide_from_utf8 native(filesystem::g_get_native_path(directory));
+    std::wstring pattern = std::wstring(native.get_ptr()) + L"\\*";
+
+    struct record { FILETIME written; std::wstring name; };
+    std::vector<record> records;
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileW(pattern.c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) return;
+    do {
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            records.push_back({ data.ftLastWriteTime, data.cFileName });
+        }
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+    if (records.size() <= DISK_FILE_LIMIT) return;
+
+    // Drop the oldest down to 90% so the next scan is not immediately due again
+    size_t remove_count = records.size() - DISK_FILE_LIMIT * 9 / 10;
+    std::partial_sort(records.begin(), records.begin() + remove_count, records.end(),
+        [](const record& a, const record& b) { return CompareFileTime(&a.written, &b.written) < 0; });
+    for (size_t i = 0; i < remove_count; i++) {
+        std::wstring path = std::wstring(native.get_ptr()) + L"\\" + records[i].name;
+        DeleteFileW(path.c_str());
+    }
+}
+
+static bool read_cached_peaks(const char* path, const std::string& key, waveform_peaks& out, abort_callback& abort) {
+    try {
+        if (!filesystem::g_exists(path, abort)) return false;
+        file::ptr in;
+        filesystem::g_open_read(in, path, abort);
+        t_filesize size = in->get_size_ex(abort);
+        if (size > MAX_RECORD_SIZE) return false;
+        pfc::array_t<t_uint8> data;
+        data.set_size((t_size)size);
+        in->read_object(data.get_ptr(), data.get_size(), abort);
+        return parse_peaks(data.get_ptr(), data.get_size(), key, out);
+    } catch (exception_aborted const&) {
+        throw;
+    } catch (...) {
+        return false;
+    }
+}
+
+static void write_cached_peaks(const char* directory, const char* path, const std::string& key, const waveform_peaks& peaks, abort_callback& abort) {
+    static std::atomic<unsigned> s_writes(0);
+    try {
+        if (!filesystem::g_exists(directory, abort)) filesystem::g_create_directory(directory, abort);
+        std::vector<uint8_t> record;
+        serialize_peaks(key, peaks, record);
+        file::ptr out;
+        filesystem::g_open_write_new(out, path, abort);
+        out->write(record.data(), record.size(), abort);
+    } catch (exception_aborted const&) {
+        throw;
+    } catch (...) {
+        return;
+    }
+    if (s_writes++ % PRUNE_INTERVAL == 0) prune_cache_directory(directory);
+}
+
+// Worker side of a job: disk record first, otherwise a full decode
+static std::shared_ptr<const waveform_peaks> extract_peaks(const metadb_handle_ptr& track, double length, abort_callback& abort) {
+    TRAY_TRACE_SCOPE("waveform", "extract peaks");
+    const playable_location& location = track->get_location();
+    t_filestats stats = track->get_filestats();
+    std::string key = make_peak_cache_key(location.get_path(), location.get_subsong(),
+        stats.m_size, stats.m_timestamp);
+
+    pfc::string8 directory = get_cache_directory();
+    pfc::string8 path = directory;
+    path.add_filename(pfc::format_hex(hash_peak_cache_key(key), 16));
+
+    auto peaks = std::make_shared<waveform_peaks>();
+    if (read_cached_peaks(path, key, *peaks, abort)) return peaks;
+
+    TRAY_PERF_COUNT(perf_counter_waveform_decodes);
+    input_decoder::ptr decoder;
+    input_entry::g_open_for_decoding(decoder, nullptr, location.get_path(), abort);
+    decoder->initialize(location.get_subsong(), input_flag_simpledecode, abort);
+
+    peak_accumulator accumulator;
+    audio_chunk_impl_temporary chunk;
+    bool started = false;
+    while (decoder->run(chunk, abort)) {
+        if (chunk.is_empty()) continue;
+        if (!started) {
+            accumulator.reset((uint64_t)(length * chunk.get_sample_rate() + 0.5), PEAK_BUCKETS);
+            started = true;
+        }
+        accumulator.add(chunk.get_data(), chunk.get_sample_count(), chunk.get_channels());
+    }
+    accumulator.finish(*peaks);
+    if (peaks->empty()) return nullptr;
+
+    write_cached_peaks(directory, path, key, *peaks, abort);
+    return peaks;
+}
+
+waveform_cache* waveform_cache::s_instance = nullptr;
+
+waveform_cache& waveform_cache::get_instance() {
+    if (!s_instance) {
+        s_instance = new waveform_cache();
+    }
+    return *s_instance;
+}
+
+waveform_cache::waveform_cache()
+    : m_generation(0) {
+}
+
+const waveform_cache::entry* waveform_cache::find(const metadb_handle_ptr& track) const {
+    for (const entry& e : m_recent) {
+        if (e.track == track) return &e;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const waveform_peaks> waveform_cache::request(const metadb_handle_ptr& track) {
+    if (track.is_empty()) return nullptr;
+    if (const entry* e = find(track)) return e->peaks;
+    if (track != m_pending) start(track);
+    return nullptr;
+}
+
+void waveform_cache::cancel() {
+    if (m_abort) m_abort->abort();
+    m_abort.reset();
+    m_pending.release();
+    m_generation++;
+}
+
+void waveform_cache::start(const metadb_handle_ptr& track) {
+    cancel();
+
+    double length = track->get_length();
+    if (length <= 0 || filesystem::g_is_remote_or_unrecognized(track->get_path())) {
+        // Nothing to decode; remember the miss so the next paint does not retry
+        on_finished(track, nullptr);
+        return;
+    }
+
+    m_pending = track;
+    m_abort = std::make_shared<abort_callback_impl>();
+    unsigned generation = m_generation;
+    waveform_cache* self = this;
+    std::shared_ptr<abort_callback_impl> abort = m_abort;
+
+    // Idle priority, and background mode for the I/O it does
+    pfc::thread::arg_t arg;
+    arg.winThreadPriority = THREAD_PRIORITY_IDLE;
+    fb2k::splitTask(arg, [self, generation, track, length, abort] {
+        SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+        std::shared_ptr<const waveform_peaks> peaks;
+        bool aborted = false;
+        try {
+            peaks = extract_peaks(track, length, *abort);
+        } catch (exception_aborted const&) {
+            aborted = true;
+        } catch (...) {}
+        SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+        if (aborted) return;
+
+        // The instance lives until process exit, so only staleness needs checking
+        fb2k::inMainThread([self, generation, track, peaks] {
+            if (generation != self->m_generation) return;
+            self->m_pending.release();
+            self->m_abort.reset();
+            self->on_finished(track, peaks);
+        });
+    });
+}
+
+void waveform_cache::on_finished(const metadb_handle_ptr& track, const std::shared_ptr<const waveform_peaks>& peaks) {
+    m_recent.insert(m_recent.begin(), { track, peaks });
+    if (m_recent.size() > RECENT_LIMIT) m_recent.pop_back();
+    if (peaks) control_panel::get_instance().on_waveform_ready(track);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "stdafx.h"
+#include "waveform_peaks.h"
+#include <memory>
+
+// Seekbar peaks per track. A request for a track without peaks starts one background job on an
+// idle-priority thread: read the record from <profile>\foo_traycontrols_peaks, or decode the
+// track and write the record there. Finished peaks are kept for the last few tracks and the
+// control panel is told to repaint. A newer request aborts the running decode, so skipping
+// through a playlist never queues work. Remote and zero-length tracks get no waveform.
+// Main thread only.
+class waveform_cache {
+public:
+    static waveform_cache& get_instance();
+
+    // Peaks if ready; otherwise null, and the extraction is started unless it already failed
+    std::shared_ptr<const waveform_peaks> request(const metadb_handle_ptr& track);
+
+    // Abort the running job (setting turned off, shutdown)
+    void cancel();
+
+private:
+    waveform_cache();
+    static waveform_cache* s_instance;
+
+    struct entry {
+        metadb_handle_ptr track;
+        std::shared_ptr<const waveform_peaks> peaks;  // Null when extraction failed
+    };
+
+    std::vector<entry> m_recent;    // Most recent first
+    metadb_handle_ptr m_pending;    // Track of the running job
+    std::shared_ptr<abort_callback_impl> m_abort;
+    unsigned m_generation;          // Bumped per job so stale completions are dropped
+
+    void start(const metadb_handle_ptr& track);
+    void on_finished(const metadb_handle_ptr& track, const std::shared_ptr<const waveform_peaks>& peaks);
+    const entry* find(const metadb_handle_ptr& track) const;
+
+    waveform_cache(const waveform_cache&) = delete;
+    waveform_cache& operator=(const waveform_cache&) = delete;
+};
@@ -0,0 +1,213 @@
+#include "waveform_peaks.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint8_t RECORD_MAGIC[4] = { 'T', 'W', 'P', 'K' };
+static const uint8_t RECORD_VERSION = 1;
+static const size_t RECORD_HEADER_SIZE = 12;    // Magic, version, reserved, key length (u16), bucket count (u32)
+
+peak_accumulator::peak_accumulator()
+    : m_expected(1)
+    , m_position(0)
+    , m_reached(0) {
+}
+
+void peak_accumulator::reset(uint64_t expected_frames, unsigned bucket_count) {
+    m_expected = expected_frames > 0 ? expected_frames : 1;
+    m_position = 0;
+    m_reached = 0;
+    // Buckets start at zero, so the drawn envelope always spans the center line
+    m_min.assign(bucket_count, 0.0f);
+    m_max.assign(bucket_count, 0.0f);
+}
+
+size_t peak_accumulator::bucket_of(uint64_t frame) const {
+    uint64_t bucket = frame * m_max.size() / m_expected;
+    return bucket < m_max.size() ? (size_t)bucket : m_max.size() - 1;
+}
+
+uint64_t peak_accumulator::bucket_end(size_t bucket) const {
+    if (bucket + 1 >= m_max.size()) return UINT64_MAX;
+    // First frame that maps to the next bucket
+    return ((uint64_t)(bucket + 1) * m_expected + m_max.size() - 1) / m_max.size();
+}
+
+template<typename sample_t>
+void peak_accumulator::add_samples(const sample_t* samples, size_t frames, unsigned channels) {
+    if (m_max.empty() || channels == 0) return;
+    while (frames > 0) {
+        // Frames of one bucket are contiguous in the interleaved buffer, all channels together
+        size_t bucket = bucket_of(m_position);
+        uint64_t end = bucket_end(bucket);
+        size_t run = end - m_position < frames ? (size_t)(end - m_position) : frames;
+        if (run == 0) run = frames;
+
+        reduce_min_max(samples, run * channels, m_min[bucket], m_max[bucket]);
+        if (bucket + 1 > m_reached) m_reached = bucket + 1;
+
+        samples += run * channels;
+        frames -= run;
+        m_position += run;
+    }
+}
+
+void peak_accumulator::add(const float* samples, size_t frames, unsigned channels) {
+    add_samples(samples, frames, channels);
+}
+
+void peak_accumulator::add(const double* samples, size_t frames, unsigned channels) {
+    add_samples(samples, frames, channels);
+}
+
+static int8_t to_peak(float value) {
+    float scaled = value * 127.0f;
+    if (scaled > 127.0f) scaled = 127.0f;
+    if (scaled < -127.0f) scaled = -127.0f;
+    return (int8_t)lrintf(scaled);
+}
+
+void peak_accumulator::finish(waveform_peaks& out) const {
+    out.min.resize(m_reached);
+    out.max.resize(m_reached);
+    for (size_t i = 0; i < m_reached; i++) {
+        out.min[i] = to_peak(m_min[i]);
+        out.max[i] = to_peak(m_max[i]);
+    }
+}
+
+void reduce_min_max(const float* samples, size_t n, float& lo, float& hi) {
+    size_t i = 0;
+#if TRAY_HAVE_SSE2
+    // Two accumulator pairs keep both min/max pipes busy
+    __m128 lo0 = _mm_set1_ps(lo), lo1 = lo0;
+    __m128 hi0 = _mm_set1_ps(hi), hi1 = hi0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_loadu_ps(samples + i);
+        __m128 b = _mm_loadu_ps(samples + i + 4);
+        lo0 = _mm_min_ps(lo0, a);
+        hi0 = _mm_max_ps(hi0, a);
+        lo1 = _mm_min_ps(lo1, b);
+        hi1 = _mm_max_ps(hi1, b);
+    }
+    float lo_lanes[4], hi_lanes[4];
+    _mm_storeu_ps(lo_lanes, _mm_min_ps(lo0, lo1));
+    _mm_storeu_ps(hi_lanes, _mm_max_ps(hi0, hi1));
+    for (int lane = 0; lane < 4; lane++) {
+        if (lo_lanes[lane] < lo) lo = lo_lanes[lane];
+        if (hi_lanes[lane] > hi) hi = hi_lanes[lane];
+    }
+#endif
+    for (; i < n; i++) {
+        if (samples[i] < lo) lo = samples[i];
+        if (samples[i] > hi) hi = samples[i];
+    }
+}
+
+void reduce_min_max(const double* samples, size_t n, float& lo, float& hi) {
+    double lo_d = lo, hi_d = hi;
+    size_t i = 0;
+#if TRAY_HAVE_SSE2
+    __m128d lo0 = _mm_set1_pd(lo_d), lo1 = lo0;
+    __m128d hi0 = _mm_set1_pd(hi_d), hi1 = hi0;
+    for (; i + 4 <= n; i += 4) {
+        __m128d a = _mm_loadu_pd(samples + i);
+        __m128d b = _mm_loadu_pd(samples + i + 2);
+        lo0 = _mm_min_pd(lo0, a);
+        hi0 = _mm_max_pd(hi0, a);
+        lo1 = _mm_min_pd(lo1, b);
+        hi1 = _mm_max_pd(hi1, b);
+    }
+    double lo_lanes[2], hi_lanes[2];
+    _mm_storeu_pd(lo_lanes, _mm_min_pd(lo0, lo1));
+    _mm_storeu_pd(hi_lanes, _mm_max_pd(hi0, hi1));
+    for (int lane = 0; lane < 2; lane++) {
+        if (lo_lanes[lane] < lo_d) lo_d = lo_lanes[lane];
+        if (hi_lanes[lane] > hi_d) hi_d = hi_lanes[lane];
+    }
+#endif
+    for (; i < n; i++) {
+        if (samples[i] < lo_d) lo_d = samples[i];
+        if (samples[i] > hi_d) hi_d = samples[i];
+    }
+    lo = (float)lo_d;
+    hi = (float)hi_d;
+}
+
+std::string make_peak_cache_key(const char* path, uint32_t subsong, uint64_t file_size, uint64_t file_timestamp) {
+    std::string key = path ? path : "";
+    key += '\n';
+    key += std::to_string(subsong);
+    key += '\n';
+    key += std::to_string(file_size);
+    key += '\n';
+    key += std::to_string(file_timestamp);
+    return key;
+}
+
+uint64_t hash_peak_cache_key(const std::string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void serialize_peaks(const std::string& key, const waveform_peaks& peaks, std::vector<uint8_t>& out) {
+    size_t key_length = key.length() < 0xFFFF ? key.length() : 0xFFFF;
+    uint32_t count = (uint32_t)peaks.size();
+
+    out.clear();
+    out.reserve(RECORD_HEADER_SIZE + key_length + 2 * (size_t)count);
+    out.insert(out.end(), RECORD_MAGIC, RECORD_MAGIC + 4);
+    out.push_back(RECORD_VERSION);
+    out.push_back(0);
+    out.push_back((uint8_t)(key_length & 0xFF));
+    out.push_back((uint8_t)(key_length >> 8));
+    for (int shift = 0; shift < 32; shift += 8) out.push_back((uint8_t)(count >> shift));
+    out.insert(out.end(), key.begin(), key.begin() + key_length);
+    out.insert(out.end(), (const uint8_t*)peaks.min.data(), (const uint8_t*)peaks.min.data() + count);
+    out.insert(out.end(), (const uint8_t*)peaks.max.data(), (const uint8_t*)peaks.max.data() + count);
+}
+
+bool parse_peaks(const uint8_t* data, size_t size, const std::string& key, waveform_peaks& out) {
+    if (!data || size < RECORD_HEADER_SIZE) return false;
+    if (memcmp(data, RECORD_MAGIC, 4) != 0 || data[4] != RECORD_VERSION) return false;
+
+    size_t key_length = (size_t)data[6] | ((size_t)data[7] << 8);
+    uint32_t count = 0;
+    for (int i = 0; i < 4; i++) count |= (uint32_t)data[8 + i] << (8 * i);
+    if (size != RECORD_HEADER_SIZE + key_length + 2 * (size_t)count) return false;
+
+    const uint8_t* p = data + RECORD_HEADER_SIZE;
+    if (key_length != key.length() || memcmp(p, key.data(), key_length) != 0) return false;
+    p += key_length;
+
+    out.min.assign((const int8_t*)p, (const int8_t*)p + count);
+    out.max.assign((const int8_t*)p + count, (const int8_t*)p + 2 * (size_t)count);
+    return true;
+}
+
+void peak_envelope(const waveform_peaks& peaks, int columns, std::vector<int8_t>& column_min, std::vector<int8_t>& column_max) {
+    column_min.assign(columns > 0 ? columns : 0, 0);
+    column_max.assign(columns > 0 ? columns : 0, 0);
+    size_t count = peaks.size();
+    if (columns <= 0 || count == 0) return;
+
+    for (int column = 0; column < columns; column++) {
+        size_t first = (size_t)column * count / columns;
+        size_t last = (size_t)(column + 1) * count / columns;
+        if (last <= first) last = first + 1;
+
+        int8_t lo = peaks.min[first];
+        int8_t hi = peaks.max[first];
+        for (size_t i = first + 1; i < last; i++) {
+            if (peaks.min[i] < lo) lo = peaks.min[i];
+            if (peaks.max[i] > hi) hi = peaks.max[i];
+        }
+        column_min[column] = lo;
+        column_max[column] = hi;
+    }
+}
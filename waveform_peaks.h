@@ -0,0 +1,63 @@
+#pragma once
+
+// Portable half of the waveform seekbar: reducing decoded audio to per-bucket min/max peaks,
+// the on-disk record the peaks are cached in, and the per-pixel envelope the seekbar draws.
+// Free of Windows and SDK types, so extraction can be checked on synthetic signals.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Min/max of all channels per bucket, scaled so full scale is 127
+struct waveform_peaks {
+    std::vector<int8_t> min;
+    std::vector<int8_t> max;
+
+    size_t size() const { return max.size(); }
+    bool empty() const { return max.empty(); }
+};
+
+// Streams interleaved samples into a fixed number of equal-length buckets
+class peak_accumulator {
+public:
+    peak_accumulator();
+
+    // expected_frames comes from the track length; later frames land in the last bucket
+    void reset(uint64_t expected_frames, unsigned bucket_count);
+
+    void add(const float* samples, size_t frames, unsigned channels);
+    void add(const double* samples, size_t frames, unsigned channels);
+
+    // Buckets never reached (the track was shorter than expected) are dropped
+    void finish(waveform_peaks& out) const;
+
+    uint64_t frames() const { return m_position; }
+
+private:
+    std::vector<float> m_min;
+    std::vector<float> m_max;
+    uint64_t m_expected;
+    uint64_t m_position;
+    size_t m_reached;   // Buckets touched so far
+
+    template<typename sample_t>
+    void add_samples(const sample_t* samples, size_t frames, unsigned channels);
+    size_t bucket_of(uint64_t frame) const;
+    uint64_t bucket_end(size_t bucket) const;
+};
+
+// SIMD min/max over n samples, folded into lo/hi
+void reduce_min_max(const float* samples, size_t n, float& lo, float& hi);
+void reduce_min_max(const double* samples, size_t n, float& lo, float& hi);
+
+// Cache key of one decode: path, subsong and the file stats that change when the file does
+std::string make_peak_cache_key(const char* path, uint32_t subsong, uint64_t file_size, uint64_t file_timestamp);
+uint64_t hash_peak_cache_key(const std::string& key);
+
+// On-disk record: header, the full key (checked on read, so hash collisions miss), then min and max
+void serialize_peaks(const std::string& key, const waveform_peaks& peaks, std::vector<uint8_t>& out);
+bool parse_peaks(const uint8_t* data, size_t size, const std::string& key, waveform_peaks& out);
+
+// Per-column min/max for a seekbar columns pixels wide; each column covers its share of buckets
+void peak_envelope(const waveform_peaks& peaks, int columns, std::vector<int8_t>& column_min, std::vector<int8_t>& column_max);